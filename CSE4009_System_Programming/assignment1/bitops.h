@@ -0,0 +1,256 @@
+/*
+ * bitops.h - The bits.c puzzles as a header-only library
+ *
+ * The puzzle versions in bits.c are limited to a few integer operators
+ * and no loops. Here the scalar functions use whatever is cheapest, and
+ * the array variants process a whole buffer with SIMD kernels:
+ *
+ *   bitCount_array   total number of 1 bits in n words
+ *   byteSwap_array   byteSwap(x, bn, bm) on every word
+ *   float_abs_array  float_abs on every word (NaN kept as is)
+ *
+ * The kernel is picked at compile time: AVX2, then SSSE3 (SSE2 for
+ * float_abs), then NEON, then a portable scalar loop. Build with
+ * -mavx2 or -march=native to get the AVX2 kernels, or define
+ * BITOPS_SCALAR to force the scalar loops. bitops_kernel() names the
+ * one in use. The arrays need no alignment, dst may equal src.
+ *
+ * bits_bench.c compares these with the puzzle versions.
+ */
+#ifndef BITOPS_H
+#define BITOPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(BITOPS_SCALAR)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BITOPS_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BITOPS_SSSE3
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BITOPS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BITOPS_NEON
+#endif
+#endif
+
+static inline const char *bitops_kernel(void)
+{
+#if defined(BITOPS_AVX2)
+	return "avx2";
+#elif defined(BITOPS_SSSE3)
+	return "ssse3";
+#elif defined(BITOPS_SSE2)
+	return "sse2";
+#elif defined(BITOPS_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+/*
+ * Scalar versions
+ */
+
+/* bitops_count - number of 1 bits in x */
+static inline int bitops_count(uint32_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcount(x);
+#else
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0f0f0f0f;
+	return (x * 0x01010101) >> 24;
+#endif
+}
+
+/* bitops_mask - 1s from bit lowbit to bit highbit inclusive, 0 if lowbit > highbit */
+static inline uint32_t bitops_mask(int highbit, int lowbit)
+{
+	uint32_t high = highbit >= 31 ? 0xffffffffu : (2u << highbit) - 1;
+	return high & (0xffffffffu << lowbit);
+}
+
+/* bitops_byteswap - swap byte n and byte m of x */
+static inline uint32_t bitops_byteswap(uint32_t x, int n, int m)
+{
+	uint32_t y = ((x >> (n << 3)) ^ (x >> (m << 3))) & 0xff;
+	return x ^ (y << (n << 3)) ^ (y << (m << 3));
+}
+
+/* bitops_lshift - logical right shift, 0 <= n <= 31 */
+static inline uint32_t bitops_lshift(uint32_t x, int n)
+{
+	return x >> n;
+}
+
+/* bitops_fabs - absolute value of a float given as its bits, NaN returned as is */
+static inline uint32_t bitops_fabs(uint32_t uf)
+{
+	uint32_t abs = uf & 0x7fffffff;
+	return abs > 0x7f800000 ? uf : abs;
+}
+
+/*
+ * Array versions, the scalar loop finishes what the vector loop leaves
+ */
+
+static inline uint64_t bitCount_array(const uint32_t *x, size_t n)
+{
+	uint64_t total = 0;
+	size_t i = 0;
+
+#if defined(BITOPS_AVX2) || defined(BITOPS_SSSE3)
+	/*
+	 * Nibble lookup with pshufb, byte counts summed with psadbw. Byte
+	 * counts are at most 8, so 31 rounds fit in a byte before the sum.
+	 */
+#if defined(BITOPS_AVX2)
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	__m256i acc = _mm256_setzero_si256();
+
+	while (i + 8 <= n) {
+		__m256i bytes = _mm256_setzero_si256();
+		int round;
+		for (round = 0; round < 31 && i + 8 <= n; round++, i += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+			__m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+			__m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+			bytes = _mm256_add_epi8(bytes, _mm256_add_epi8(lo, hi));
+		}
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+	}
+	total = (uint64_t)_mm256_extract_epi64(acc, 0) + (uint64_t)_mm256_extract_epi64(acc, 1) +
+		(uint64_t)_mm256_extract_epi64(acc, 2) + (uint64_t)_mm256_extract_epi64(acc, 3);
+#else
+	const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m128i low = _mm_set1_epi8(0x0f);
+	__m128i acc = _mm_setzero_si128();
+	uint64_t part[2];
+
+	while (i + 4 <= n) {
+		__m128i bytes = _mm_setzero_si128();
+		int round;
+		for (round = 0; round < 31 && i + 4 <= n; round++, i += 4) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(x + i));
+			__m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, low));
+			__m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low));
+			bytes = _mm_add_epi8(bytes, _mm_add_epi8(lo, hi));
+		}
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(bytes, _mm_setzero_si128()));
+	}
+	_mm_storeu_si128((__m128i *)part, acc);
+	total = part[0] + part[1];
+#endif
+#elif defined(BITOPS_NEON)
+	uint64x2_t acc = vdupq_n_u64(0);
+
+	for (; i + 4 <= n; i += 4) {
+		uint8x16_t c = vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(x + i)));
+		acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(c)));
+	}
+	total = vaddvq_u64(acc);
+#elif defined(__GNUC__)
+	/* two words at a time through the 64-bit popcount */
+	for (; i + 2 <= n; i += 2)
+		total += __builtin_popcountll((uint64_t)x[i] | (uint64_t)x[i + 1] << 32);
+#endif
+	for (; i < n; i++)
+		total += bitops_count(x[i]);
+	return total;
+}
+
+static inline void byteSwap_array(uint32_t *dst, const uint32_t *src, size_t n, int bn, int bm)
+{
+	size_t i = 0;
+
+#if defined(BITOPS_AVX2) || defined(BITOPS_SSSE3) || defined(BITOPS_NEON)
+	/* the same byte permutation for every word, one shuffle per vector */
+	uint8_t perm[16];
+	int k;
+
+	for (k = 0; k < 16; k++) {
+		int b = k & 3;
+		perm[k] = (k & ~3) | (b == bn ? bm : b == bm ? bn : b);
+	}
+#if defined(BITOPS_AVX2)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i *)perm);
+		__m256i shuf = _mm256_inserti128_si256(_mm256_castsi128_si256(p), p, 1);
+		for (; i + 8 <= n; i += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(v, shuf));
+		}
+	}
+#elif defined(BITOPS_SSSE3)
+	{
+		__m128i shuf = _mm_loadu_si128((const __m128i *)perm);
+		for (; i + 4 <= n; i += 4) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, shuf));
+		}
+	}
+#else
+	{
+		uint8x16_t shuf = vld1q_u8(perm);
+		for (; i + 4 <= n; i += 4) {
+			uint8x16_t v = vreinterpretq_u8_u32(vld1q_u32(src + i));
+			vst1q_u32(dst + i, vreinterpretq_u32_u8(vqtbl1q_u8(v, shuf)));
+		}
+	}
+#endif
+#endif
+	for (; i < n; i++)
+		dst[i] = bitops_byteswap(src[i], bn, bm);
+}
+
+static inline void float_abs_array(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	size_t i = 0;
+
+	/* abs is non-negative as a signed int, so a signed compare finds NaN */
+#if defined(BITOPS_AVX2)
+	const __m256i mag = _mm256_set1_epi32(0x7fffffff);
+	const __m256i inf = _mm256_set1_epi32(0x7f800000);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i abs = _mm256_and_si256(v, mag);
+		__m256i nan = _mm256_cmpgt_epi32(abs, inf);
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_blendv_epi8(abs, v, nan));
+	}
+#elif defined(BITOPS_SSSE3) || defined(BITOPS_SSE2)
+	const __m128i mag = _mm_set1_epi32(0x7fffffff);
+	const __m128i inf = _mm_set1_epi32(0x7f800000);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i abs = _mm_and_si128(v, mag);
+		__m128i nan = _mm_cmpgt_epi32(abs, inf);
+		/* abs and v differ only in the sign bit, put it back where NaN */
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(abs, _mm_and_si128(v, nan)));
+	}
+#elif defined(BITOPS_NEON)
+	const uint32x4_t mag = vdupq_n_u32(0x7fffffff);
+	const uint32x4_t inf = vdupq_n_u32(0x7f800000);
+
+	for (; i + 4 <= n; i += 4) {
+		uint32x4_t v = vld1q_u32(src + i);
+		uint32x4_t abs = vandq_u32(v, mag);
+		vst1q_u32(dst + i, vbslq_u32(vcgtq_u32(abs, inf), v, abs));
+	}
+#endif
+	for (; i < n; i++)
+		dst[i] = bitops_fabs(src[i]);
+}
+
+#endif /* BITOPS_H */
@@ -0,0 +1,205 @@
+/*
+ * bits_bench.c - Compare the bitops.h array kernels with the bits.c puzzles
+ *
+ * Each test fills a buffer with random words, runs the puzzle function
+ * over it word by word and then the array variant, checks that both give
+ * the same result and prints the best time of -r runs as CSV.
+ *
+ * build : gcc -O2 -march=native -o bits_bench bits_bench.c bits.c
+ *         (add -DBITOPS_SCALAR to time the scalar fallback)
+ * usage : ./bits_bench [-n words] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "bitops.h"
+
+/* bits.c */
+int bitCount(int x);
+int byteSwap(int x, int n, int m);
+unsigned float_abs(unsigned uf);
+
+#define DEFAULT_WORDS (1 << 20)
+#define DEFAULT_REPEAT 10
+
+static size_t words = DEFAULT_WORDS;
+static int repeat = DEFAULT_REPEAT;
+
+/* keeps the compiler from dropping the puzzle loops */
+static volatile uint64_t sink;
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t rand32(void)
+{
+	static uint64_t s = 0x9E3779B97F4A7C15ULL;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return (uint32_t)s;
+}
+
+static void report(const char *name, double puzzle, double array)
+{
+	printf("%s,%zu,%.6f,%.6f,%.2f\n", name, words, puzzle, array,
+			array > 0 ? puzzle / array : 0.0);
+}
+
+static int bench_bitcount(const uint32_t *src)
+{
+	double best_p = 0, best_a = 0, t;
+	uint64_t p = 0, a = 0;
+	size_t i;
+	int r;
+
+	for (r = 0; r < repeat; r++) {
+		t = now_sec();
+		p = 0;
+		for (i = 0; i < words; i++)
+			p += bitCount((int)src[i]);
+		sink = p;
+		t = now_sec() - t;
+		if (r == 0 || t < best_p) best_p = t;
+
+		t = now_sec();
+		a = bitCount_array(src, words);
+		sink = a;
+		t = now_sec() - t;
+		if (r == 0 || t < best_a) best_a = t;
+	}
+	if (p != a) {
+		fprintf(stderr, "bitCount: puzzle %llu, array %llu\n",
+				(unsigned long long)p, (unsigned long long)a);
+		return -1;
+	}
+	report("bitCount", best_p, best_a);
+	return 0;
+}
+
+static int bench_byteswap(const uint32_t *src, uint32_t *p, uint32_t *a)
+{
+	double best_p = 0, best_a = 0, t;
+	size_t i;
+	int r, bn, bm;
+
+	/* every (n, m) pair, the permutation is built per call */
+	for (bn = 0; bn < 4; bn++) {
+		for (bm = 0; bm < 4; bm++) {
+			for (i = 0; i < words; i++)
+				p[i] = (uint32_t)byteSwap((int)src[i], bn, bm);
+			byteSwap_array(a, src, words, bn, bm);
+			if (memcmp(p, a, words * sizeof(uint32_t)) != 0) {
+				fprintf(stderr, "byteSwap(%d, %d): results differ\n", bn, bm);
+				return -1;
+			}
+		}
+	}
+
+	for (r = 0; r < repeat; r++) {
+		t = now_sec();
+		for (i = 0; i < words; i++)
+			p[i] = (uint32_t)byteSwap((int)src[i], 1, 3);
+		t = now_sec() - t;
+		if (r == 0 || t < best_p) best_p = t;
+
+		t = now_sec();
+		byteSwap_array(a, src, words, 1, 3);
+		t = now_sec() - t;
+		if (r == 0 || t < best_a) best_a = t;
+	}
+	report("byteSwap", best_p, best_a);
+	return 0;
+}
+
+static int bench_fabs(uint32_t *src, uint32_t *p, uint32_t *a)
+{
+	double best_p = 0, best_a = 0, t;
+	size_t i;
+	int r;
+
+	/* make sure the edge cases are in there: NaNs, infinities, zeros */
+	if (words >= 6) {
+		src[0] = 0x7fc00000;
+		src[1] = 0xffc00001;
+		src[2] = 0x7f800000;
+		src[3] = 0xff800000;
+		src[4] = 0x80000000;
+		src[5] = 0xff800001;
+	}
+
+	for (r = 0; r < repeat; r++) {
+		t = now_sec();
+		for (i = 0; i < words; i++)
+			p[i] = float_abs(src[i]);
+		t = now_sec() - t;
+		if (r == 0 || t < best_p) best_p = t;
+
+		t = now_sec();
+		float_abs_array(a, src, words);
+		t = now_sec() - t;
+		if (r == 0 || t < best_a) best_a = t;
+	}
+	if (memcmp(p, a, words * sizeof(uint32_t)) != 0) {
+		fprintf(stderr, "float_abs: results differ\n");
+		return -1;
+	}
+	report("float_abs", best_p, best_a);
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+			"usage : %s [-n words] [-r repeats]\n"
+			"  -n  words per buffer (default %d)\n"
+			"  -r  timed runs, the best is printed (default %d)\n",
+			name, DEFAULT_WORDS, DEFAULT_REPEAT);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t *src, *p, *a;
+	size_t i;
+	int opt, err = 0;
+
+	while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+		switch (opt) {
+		case 'n': words = strtoul(optarg, NULL, 0); break;
+		case 'r': repeat = atoi(optarg); break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+	if (words == 0 || repeat < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	src = malloc(words * sizeof(uint32_t));
+	p = malloc(words * sizeof(uint32_t));
+	a = malloc(words * sizeof(uint32_t));
+	if (src == NULL || p == NULL || a == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < words; i++)
+		src[i] = rand32();
+
+	printf("# kernel %s\n", bitops_kernel());
+	printf("function,words,puzzle_sec,array_sec,speedup\n");
+	err |= bench_bitcount(src);
+	err |= bench_byteswap(src, p, a);
+	err |= bench_fabs(src, p, a);
+
+	free(a);
+	free(p);
+	free(src);
+	return err ? 1 : 0;
+}
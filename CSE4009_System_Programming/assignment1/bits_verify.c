@@ -0,0 +1,503 @@
+/*
+ * bits_verify.c - Check the bits.c puzzles against plain C references
+ *
+ * Every test numbers its inputs 0..N-1 and the threads take chunks of
+ * that range until it is used up:
+ *
+ *   bitCount, float_abs      every 32-bit input
+ *   logicalShift             every x for every n
+ *   byteSwap                 every x for every (n, m)
+ *   replaceByte              every x for every n, c from a fixed set
+ *   bitMask, tmax            every input
+ *   bitNor, isNotEqual       edge values x edge values, then -s pairs
+ *                            (isNotEqual mostly equal or one bit apart)
+ *   conditional              edge x with random y, z, then -s triples
+ *
+ * Random inputs are a hash of the input number, so a failure can be
+ * reproduced with the same -s. bits.c is included rather than linked so
+ * the puzzles inline into the sweep loops and gcc can vectorize them.
+ * When gcc can prove a puzzle equal to its reference the sweep folds
+ * away and the test takes no time.
+ *
+ * build : gcc -O3 -march=native -pthread -o bits_verify bits_verify.c
+ * usage : ./bits_verify [-t threads] [-s samples] [-f function]
+ *   -t  worker threads (default: online CPUs)
+ *   -s  random inputs for the binary and ternary functions (default 2^30)
+ *   -f  check only this function
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bits.c"
+
+#define CHUNK (1ULL << 20)
+#define DEFAULT_SAMPLES (1ULL << 30)
+#define NONE UINT64_MAX
+
+static uint64_t samples = DEFAULT_SAMPLES;
+
+/*
+ * References
+ */
+
+static uint32_t ref_bitNor(uint32_t x, uint32_t y) { return ~(x | y); }
+static uint32_t ref_bitCount(uint32_t x) { return __builtin_popcount(x); }
+static uint32_t ref_isNotEqual(uint32_t x, uint32_t y) { return x != y; }
+static uint32_t ref_conditional(uint32_t x, uint32_t y, uint32_t z) { return x ? y : z; }
+static uint32_t ref_tmax(void) { return 0x7fffffff; }
+static uint32_t ref_logicalShift(uint32_t x, int n) { return x >> n; }
+
+static uint32_t ref_bitMask(int highbit, int lowbit)
+{
+	uint32_t m = 0;
+	int i;
+
+	for (i = lowbit; i <= highbit; i++)
+		m |= 1u << i;
+	return m;
+}
+
+static uint32_t ref_byteSwap(uint32_t x, int n, int m)
+{
+	uint32_t bn = (x >> (n * 8)) & 0xff, bm = (x >> (m * 8)) & 0xff;
+
+	x &= ~(0xffu << (n * 8)) & ~(0xffu << (m * 8));
+	return x | bn << (m * 8) | bm << (n * 8);
+}
+
+static uint32_t ref_replaceByte(uint32_t x, int n, int c)
+{
+	return (x & ~(0xffu << (n * 8))) | ((uint32_t)c << (n * 8));
+}
+
+static uint32_t ref_float_abs(uint32_t uf)
+{
+	int exp = (uf >> 23) & 0xff;
+	return exp == 0xff && (uf & 0x7fffff) ? uf : uf & 0x7fffffff;
+}
+
+/*
+ * Input numbering
+ */
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/* zero, ones, signs, alternating patterns, every single bit set and clear */
+static uint32_t edge[96];
+static int nedge;
+
+static void init_edge(void)
+{
+	static const uint32_t fixed[] = {
+		0, 1, 2, 0x7f, 0x80, 0xff, 0x100, 0x7fffffff, 0x80000000, 0x80000001,
+		0x7ffffffe, 0xffffffff, 0xfffffffe, 0x55555555, 0xaaaaaaaa, 0x0f0f0f0f,
+		0xf0f0f0f0, 0x00ff00ff, 0xff00ff00, 0x12345678, 0xdeadbeef,
+	};
+	int k;
+
+	nedge = 0;
+	for (k = 0; k < (int)(sizeof(fixed) / sizeof(fixed[0])); k++)
+		edge[nedge++] = fixed[k];
+	for (k = 2; k < 32; k++)
+		edge[nedge++] = 1u << k;
+	for (k = 1; k < 31; k++)
+		edge[nedge++] = ~(1u << k);
+}
+
+/* pair number i: the edge cross product first, then hashed pairs */
+static void pair(uint64_t i, int near, uint32_t *x, uint32_t *y)
+{
+	uint64_t h;
+	int sel;
+
+	if (i < (uint64_t)nedge * nedge) {
+		*x = edge[i / nedge];
+		*y = edge[i % nedge];
+		return;
+	}
+	h = splitmix64(i);
+	*x = (uint32_t)h;
+	*y = (uint32_t)(h >> 32);
+	/* random pairs are almost never equal, make most of them close */
+	sel = splitmix64(h) & 63;
+	if (near && sel < 32)
+		*y = *x ^ (1u << sel);
+	else if (near && sel < 40)
+		*y = *x;
+}
+
+static const int replace_c[] = { 0, 1, 0x7f, 0x80, 0xab, 0xfe, 0xff, 0x55 };
+
+/*
+ * Tests. check() returns the number of wrong results for inputs [lo, hi)
+ * and the first of them in *first, show() prints one input.
+ */
+
+typedef struct test_t {
+	const char *name;
+	uint64_t n;
+	uint64_t (*check)(uint64_t lo, uint64_t hi, uint64_t *first);
+	void (*show)(uint64_t i);
+} test_t;
+
+/* find the first failure again, the sweep loops only count */
+#define FIND_FIRST(lo, hi, first, WRONG) do { \
+	uint64_t _i; \
+	for (_i = (lo); _i < (hi); _i++) { \
+		uint64_t i = _i; \
+		if (WRONG) { *(first) = _i; break; } \
+	} \
+} while (0)
+
+static uint64_t check_bitCount(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+
+	for (i = lo; i < hi; i++)
+		bad += (uint32_t)bitCount((int)i) != ref_bitCount((uint32_t)i);
+	if (bad)
+		FIND_FIRST(lo, hi, first, (uint32_t)bitCount((int)i) != ref_bitCount((uint32_t)i));
+	return bad;
+}
+
+static void show_bitCount(uint64_t i)
+{
+	printf("bitCount(0x%08x) = %d, want %u\n", (uint32_t)i, bitCount((int)i),
+			ref_bitCount((uint32_t)i));
+}
+
+static uint64_t check_float_abs(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+
+	for (i = lo; i < hi; i++)
+		bad += float_abs((uint32_t)i) != ref_float_abs((uint32_t)i);
+	if (bad)
+		FIND_FIRST(lo, hi, first, float_abs((uint32_t)i) != ref_float_abs((uint32_t)i));
+	return bad;
+}
+
+static void show_float_abs(uint64_t i)
+{
+	printf("float_abs(0x%08x) = 0x%08x, want 0x%08x\n", (uint32_t)i,
+			float_abs((uint32_t)i), ref_float_abs((uint32_t)i));
+}
+
+/*
+ * i = x | n << 32. A chunk never crosses a multiple of 2^32, so the
+ * parameters are fixed for the whole loop and it vectorizes over x.
+ */
+static uint64_t check_logicalShift(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0;
+	uint32_t x, k, x0 = (uint32_t)lo, cnt = (uint32_t)(hi - lo);
+	int n = (int)(lo >> 32);
+
+	for (k = 0; k < cnt; k++) {
+		x = x0 + k;
+		bad += (uint32_t)logicalShift((int)x, n) != ref_logicalShift(x, n);
+	}
+	if (bad)
+		FIND_FIRST(lo, hi, first, (uint32_t)logicalShift((int)i, n) != ref_logicalShift((uint32_t)i, n));
+	return bad;
+}
+
+static void show_logicalShift(uint64_t i)
+{
+	printf("logicalShift(0x%08x, %d) = 0x%08x, want 0x%08x\n", (uint32_t)i, (int)(i >> 32),
+			logicalShift((int)i, (int)(i >> 32)), ref_logicalShift((uint32_t)i, (int)(i >> 32)));
+}
+
+/* i = x | (n * 4 + m) << 32 */
+static uint64_t check_byteSwap(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0;
+	uint32_t x, k, x0 = (uint32_t)lo, cnt = (uint32_t)(hi - lo);
+	int n = (int)(lo >> 34), m = (int)(lo >> 32) & 3;
+
+	for (k = 0; k < cnt; k++) {
+		x = x0 + k;
+		bad += (uint32_t)byteSwap((int)x, n, m) != ref_byteSwap(x, n, m);
+	}
+	if (bad)
+		FIND_FIRST(lo, hi, first, (uint32_t)byteSwap((int)i, n, m) != ref_byteSwap((uint32_t)i, n, m));
+	return bad;
+}
+
+static void show_byteSwap(uint64_t i)
+{
+	int n = (int)(i >> 34), m = (int)(i >> 32) & 3;
+	printf("byteSwap(0x%08x, %d, %d) = 0x%08x, want 0x%08x\n", (uint32_t)i, n, m,
+			byteSwap((int)i, n, m), ref_byteSwap((uint32_t)i, n, m));
+}
+
+/* i = x | n << 32 | c index << 34 */
+static uint64_t check_replaceByte(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0;
+	uint32_t x, k, x0 = (uint32_t)lo, cnt = (uint32_t)(hi - lo);
+	int n = (int)(lo >> 32) & 3, c = replace_c[lo >> 34];
+
+	for (k = 0; k < cnt; k++) {
+		x = x0 + k;
+		bad += (uint32_t)replaceByte((int)x, n, c) != ref_replaceByte(x, n, c);
+	}
+	if (bad)
+		FIND_FIRST(lo, hi, first, (uint32_t)replaceByte((int)i, n, c) != ref_replaceByte((uint32_t)i, n, c));
+	return bad;
+}
+
+static void show_replaceByte(uint64_t i)
+{
+	int n = (int)(i >> 32) & 3, c = replace_c[i >> 34];
+	printf("replaceByte(0x%08x, %d, 0x%02x) = 0x%08x, want 0x%08x\n", (uint32_t)i, n, c,
+			replaceByte((int)i, n, c), ref_replaceByte((uint32_t)i, n, c));
+}
+
+/* i = highbit * 32 + lowbit */
+static uint64_t check_bitMask(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+
+	for (i = lo; i < hi; i++)
+		bad += (uint32_t)bitMask((int)(i / 32), (int)(i % 32)) != ref_bitMask((int)(i / 32), (int)(i % 32));
+	if (bad)
+		FIND_FIRST(lo, hi, first, (uint32_t)bitMask((int)(i / 32), (int)(i % 32)) !=
+				ref_bitMask((int)(i / 32), (int)(i % 32)));
+	return bad;
+}
+
+static void show_bitMask(uint64_t i)
+{
+	printf("bitMask(%d, %d) = 0x%08x, want 0x%08x\n", (int)(i / 32), (int)(i % 32),
+			bitMask((int)(i / 32), (int)(i % 32)), ref_bitMask((int)(i / 32), (int)(i % 32)));
+}
+
+static uint64_t check_tmax(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	if ((uint32_t)tmax() == ref_tmax())
+		return 0;
+	*first = lo;
+	return 1;
+}
+
+static void show_tmax(uint64_t i)
+{
+	printf("tmax() = 0x%08x, want 0x%08x\n", tmax(), ref_tmax());
+}
+
+static uint64_t check_bitNor(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+	uint32_t x, y;
+
+	for (i = lo; i < hi; i++) {
+		pair(i, 0, &x, &y);
+		if ((uint32_t)bitNor((int)x, (int)y) != ref_bitNor(x, y) && bad++ == 0)
+			*first = i;
+	}
+	return bad;
+}
+
+static void show_bitNor(uint64_t i)
+{
+	uint32_t x, y;
+	pair(i, 0, &x, &y);
+	printf("bitNor(0x%08x, 0x%08x) = 0x%08x, want 0x%08x\n", x, y,
+			bitNor((int)x, (int)y), ref_bitNor(x, y));
+}
+
+static uint64_t check_isNotEqual(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+	uint32_t x, y;
+
+	for (i = lo; i < hi; i++) {
+		pair(i, 1, &x, &y);
+		if ((uint32_t)isNotEqual((int)x, (int)y) != ref_isNotEqual(x, y) && bad++ == 0)
+			*first = i;
+	}
+	return bad;
+}
+
+static void show_isNotEqual(uint64_t i)
+{
+	uint32_t x, y;
+	pair(i, 1, &x, &y);
+	printf("isNotEqual(0x%08x, 0x%08x) = %d, want %u\n", x, y,
+			isNotEqual((int)x, (int)y), ref_isNotEqual(x, y));
+}
+
+/* x from the pair, y and z hashed */
+static void triple(uint64_t i, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+	uint64_t h = splitmix64(i ^ 0x5bd1e995);
+	uint32_t unused;
+
+	pair(i, 0, x, &unused);
+	*y = (uint32_t)h;
+	*z = (uint32_t)(h >> 32);
+}
+
+static uint64_t check_conditional(uint64_t lo, uint64_t hi, uint64_t *first)
+{
+	uint64_t bad = 0, i;
+	uint32_t x, y, z;
+
+	for (i = lo; i < hi; i++) {
+		triple(i, &x, &y, &z);
+		if ((uint32_t)conditional((int)x, (int)y, (int)z) != ref_conditional(x, y, z) && bad++ == 0)
+			*first = i;
+	}
+	return bad;
+}
+
+static void show_conditional(uint64_t i)
+{
+	uint32_t x, y, z;
+	triple(i, &x, &y, &z);
+	printf("conditional(0x%08x, 0x%08x, 0x%08x) = 0x%08x, want 0x%08x\n", x, y, z,
+			conditional((int)x, (int)y, (int)z), ref_conditional(x, y, z));
+}
+
+static test_t tests[] = {
+	{ "bitNor", 0, check_bitNor, show_bitNor },
+	{ "bitCount", 1ULL << 32, check_bitCount, show_bitCount },
+	{ "bitMask", 32 * 32, check_bitMask, show_bitMask },
+	{ "byteSwap", 1ULL << 36, check_byteSwap, show_byteSwap },
+	{ "isNotEqual", 0, check_isNotEqual, show_isNotEqual },
+	{ "conditional", 0, check_conditional, show_conditional },
+	{ "tmax", 1, check_tmax, show_tmax },
+	{ "replaceByte", 8ULL << 34, check_replaceByte, show_replaceByte },
+	{ "logicalShift", 1ULL << 37, check_logicalShift, show_logicalShift },
+	{ "float_abs", 1ULL << 32, check_float_abs, show_float_abs },
+};
+
+/*
+ * Workers
+ */
+
+static test_t *cur;
+static uint64_t next_lo;	/* next chunk to hand out */
+static uint64_t total_bad;
+static uint64_t first_bad;
+static pthread_mutex_t bad_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *worker(void *arg)
+{
+	uint64_t lo, hi, bad, first;
+
+	while ((lo = __atomic_fetch_add(&next_lo, CHUNK, __ATOMIC_RELAXED)) < cur->n) {
+		hi = lo + CHUNK < cur->n ? lo + CHUNK : cur->n;
+		first = NONE;
+		if ((bad = cur->check(lo, hi, &first)) == 0)
+			continue;
+		pthread_mutex_lock(&bad_lock);
+		total_bad += bad;
+		if (first < first_bad)
+			first_bad = first;
+		pthread_mutex_unlock(&bad_lock);
+	}
+	return NULL;
+}
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* run one test on nthread threads, 0 if every input was right */
+static int run(test_t *t, int nthread, pthread_t *tid)
+{
+	double sec = now_sec();
+	int k;
+
+	cur = t;
+	next_lo = 0;
+	total_bad = 0;
+	first_bad = NONE;
+	for (k = 0; k < nthread; k++)
+		if (pthread_create(&tid[k], NULL, worker, NULL) != 0) {
+			perror("pthread_create");
+			exit(2);
+		}
+	for (k = 0; k < nthread; k++)
+		pthread_join(tid[k], NULL);
+	sec = now_sec() - sec;
+
+	if (total_bad == 0) {
+		printf("%-13s ok    %14llu inputs %8.2fs\n", t->name, (unsigned long long)t->n, sec);
+		return 0;
+	}
+	printf("%-13s FAIL  %14llu of %llu inputs %8.2fs, first: ", t->name,
+			(unsigned long long)total_bad, (unsigned long long)t->n, sec);
+	t->show(first_bad);
+	return 1;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+			"usage : %s [-t threads] [-s samples] [-f function]\n"
+			"  -t  worker threads (default: online CPUs)\n"
+			"  -s  random inputs for the binary and ternary functions (default 2^30)\n"
+			"  -f  check only this function\n",
+			name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *only = NULL;
+	pthread_t *tid;
+	int opt, nthread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int k, ran = 0, failed = 0;
+
+	while ((opt = getopt(argc, argv, "t:s:f:h")) != -1) {
+		switch (opt) {
+		case 't': nthread = atoi(optarg); break;
+		case 's': samples = strtoull(optarg, NULL, 0); break;
+		case 'f': only = optarg; break;
+		default: usage(argv[0]); return 2;
+		}
+	}
+	if (nthread < 1) {
+		usage(argv[0]);
+		return 2;
+	}
+	if ((tid = malloc(sizeof(pthread_t) * nthread)) == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+
+	init_edge();
+	for (k = 0; k < (int)(sizeof(tests) / sizeof(tests[0])); k++) {
+		test_t *t = &tests[k];
+		if (only && strcmp(only, t->name))
+			continue;
+		if (t->n == 0)
+			t->n = (uint64_t)nedge * nedge + samples;
+		failed += run(t, nthread, tid);
+		fflush(stdout);
+		ran++;
+	}
+	free(tid);
+	if (ran == 0) {
+		fprintf(stderr, "no function named %s\n", only);
+		return 2;
+	}
+	printf("%d of %d functions failed\n", failed, ran);
+	return failed ? 1 : 0;
+}
@@ -2,15 +2,18 @@
  * mm-implicit.c -  Simple allocator based on implicit free lists,
  *                  first fit placement, and boundary tag coalescing.
  *
- * Each block has header and footer of the form:
+ * Each block has a header of the form:
  *
  *      31                     3  2  1  0
  *      -----------------------------------
- *     | s  s  s  s  ... s  s  s  0  0  a/f
+ *     | s  s  s  s  ... s  s  s pa  0  a/f
  *      -----------------------------------
  *
- * where s are the meaningful size bits and a/f is set
- * iff the block is allocated. The list has the following form:
+ * where s are the meaningful size bits, a/f is set iff the block is
+ * allocated and pa is set iff the previous block is allocated. Only free
+ * blocks carry a footer (a copy of the header), which is all coalesce
+ * needs to step back over a free neighbour, so an allocated block is its
+ * payload plus one word. The list has the following form:
  *
  * begin                                                          end
  * heap                                                           heap
@@ -22,12 +25,50 @@
  *
  * The allocated prologue and epilogue blocks are overhead that
  * eliminate edge conditions during coalescing.
+ *
+ * Free blocks are kept in ClassSize segregated lists. The first two words
+ * of a free block's payload are its pred/succ links, stored as 4-byte
+ * offsets from HeapBase instead of raw pointers, so the 16-byte minimum
+ * block and the header/footer layout stay the same on 64-bit hosts.
+ * The pred link of the first block in a list is the offset of its class
+ * slot. Offset 0 means NULL.
+ *
+ * Class c holds blocks of (16 * 2^(c-1), 16 * 2^c] bytes (class 0 is 16,
+ * the last class takes everything larger) and is computed with one clz.
+ * ClassMap has bit c set iff list c is non-empty, so find_fit only walks
+ * the asize class and otherwise goes straight to the next non-empty one.
+ * In either list it looks at up to FIT_SEARCH fitting blocks and takes
+ * the smallest (good fit); FIT_SEARCH 1 is plain first fit. Lists are
+ * LIFO unless built with -DMM_ADDR_ORDER, which keeps every list sorted
+ * by address at the cost of a walk per insert, so allocations pack
+ * toward the bottom of the heap.
+ *
+ * The free lists are shared by all threads under HeapLock. Blocks of up to
+ * TCACHE_MAX bytes are also kept in per-thread bins (tcache): a bin is a
+ * singly linked stack of blocks of one size that stay marked allocated,
+ * so they are never coalesced while cached. An empty bin is refilled with
+ * TCACHE_FILL blocks under one lock acquisition. A bin that grows past
+ * TCACHE_COUNT gives half of its blocks back the same way. A malloc/free
+ * pair of a small size therefore touches only the calling thread's bin.
+ * mm_init must be called while no other thread uses the allocator.
+ *
+ * Requests of MMAP_THRESHOLD bytes or more bypass the heap: each gets its
+ * own mmap region whose header word has the MMAPPED bit and size 0, and
+ * whose mapping length sits in the first word of the region. mm_free
+ * unmaps it and mm_realloc resizes it with mremap. The heap itself can
+ * not shrink (mem_sbrk only grows), so when a free leaves a free block
+ * of at least TRIM_THRESHOLD bytes at the top of the heap, the whole
+ * pages inside it are handed back with madvise(MADV_DONTNEED).
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
 
 #include "mm.h"
 #include "memlib.h"
@@ -46,11 +87,21 @@
 
 #define GET_SIZE(p) (GET(p) & ~0x7)
 #define GET_ALLOC(p) (GET(p) & 0x1)
+#define MMAPPED 0x2	/* header bit of a block that owns its own mapping */
+#define PREV_ALLOC 0x4	/* header bit : the previous block is allocated */
+#define GET_PREV_ALLOC(p) (GET(p) & PREV_ALLOC)
+
+/* block size for a size byte request : payload and header, at least BLOCKSIZE */
+#define ASIZE(size) MAX(BLOCKSIZE, DSIZE * (((size) + WSIZE + (DSIZE - 1)) / DSIZE))
 
 #define p_to_char(bp) ((char *) (bp))
-#define pAtC(bp) ((char *) (bp + WSIZE))
-#define p_char_GET(bp) ((char *) GET(p_to_char(bp)))
-#define pAtC_GET(bp) ((char *) GET(pAtC(bp)))
+#define pAtC(bp) ((char *) (bp) + WSIZE)
+#define p_char_GET(bp) ((char *) PTR(GET(p_to_char(bp))))
+#define pAtC_GET(bp) ((char *) PTR(GET(pAtC(bp))))
+
+/* heap pointer <-> 4-byte link offset, HeapBase sits below every valid address */
+#define OFF(p) ((p) ? (unsigned int) ((char *) (p) - HeapBase) : 0)
+#define PTR(o) ((o) ? (void *) (HeapBase + (o)) : NULL)
 
 
 #define HDRP(bp) ((char *) (bp) - WSIZE)
@@ -67,23 +118,160 @@
 static void *extend_heap(size_t words);
 static void *coalesce(void *bp);
 static void *find_fit(size_t asize);
+static void *good_fit(int size_class, size_t asize);
 static void place(void *bp, size_t asize);
 
 
 #define ClassSize 17 
+#ifndef FIT_SEARCH
+#define FIT_SEARCH 8	/* fitting blocks find_fit compares in one list */
+#endif
 #define BLOCKSIZE (4*WSIZE) 
 #define eight 8
 #define sideby(size) (((size) + (eight-1)) & ~0x7)
 #define SIZE_T_SIZE (sideby(sizeof(size_t)))
 
 static char *HeapBlocks = 0;
-static char **FreeBlocks = 0;
+static unsigned int *FreeBlocks = 0;	/* list heads, one link offset per class */
+static char *HeapBase = 0;
+static unsigned int ClassMap = 0;	/* bit c : FreeBlocks[c] is non-empty */
 static void free_list_insert(void* bp);
 static void free_list_remove(void* bp);
+static int size_class_of(size_t size);
 
 
 static void put_head_foot(void *bp, size_t size, int t);
 static void put(void *bp, unsigned int t);
+static void set_prev_alloc(void *bp, int t);
+
+static void *heap_malloc(size_t asize);
+static void heap_free(void *bp);
+static void *grow_in_place(void *bp, size_t asize);
+static void split_alloc(void *bp, size_t total, size_t asize);
+
+#define TCACHE_MAX (1024 + DSIZE)	/* largest cached block, 1 KiB payload */
+#define TCACHE_BINS (TCACHE_MAX / DSIZE - 1)	/* one bin per block size 16, 24, ... */
+#define TCACHE_COUNT 32	/* blocks a bin may hold before giving half back */
+#define TCACHE_FILL 8	/* blocks taken from the free lists when a bin is empty */
+
+typedef struct tcache {
+	void *bin[TCACHE_BINS];	/* next block is stored in the first payload word */
+	int count[TCACHE_BINS];
+	unsigned int gen;	/* HeapGen when this cache was set up */
+} tcache_t;
+
+static pthread_mutex_t HeapLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int HeapGen = 0;	/* bumped by mm_init, drops caches of an old heap */
+static __thread tcache_t tcache;
+static pthread_key_t TcacheKey;
+static pthread_once_t TcacheOnce = PTHREAD_ONCE_INIT;
+
+static tcache_t *tcache_get(void);
+
+#define MMAP_THRESHOLD (128 * 1024)	/* blocks this large get their own mapping */
+#define MMAP_HDR (2 * DSIZE)	/* mapping length word, pad and header before bp */
+#define TRIM_THRESHOLD (128 * 1024)	/* free top block size that is given back */
+#define MAP_LEN(bp) (*(size_t *) ((char *) (bp) - MMAP_HDR))
+
+static size_t PageSize = 0;
+
+static void *mmap_alloc(size_t asize);
+static void *mmap_realloc(void *bp, size_t size);
+static void heap_trim(void *bp);
+
+/*
+ * Fixed-size object pools. A pool hands out objects of one size from
+ * slabs; a slab is a single heap block carved into equal objects, so the
+ * objects carry no header/footer and are never coalesced. A free object's
+ * first word links it into the pool's free list. Slabs go back to the
+ * heap only in mm_pool_destroy.
+ */
+#define POOL_SLAB (CHUNKSIZE - DSIZE)	/* slab payload, one page with its tags */
+#define POOL_MIN_OBJS 8	/* a slab holds at least this many objects */
+
+typedef struct pool_slab {
+	struct pool_slab *next;
+} pool_slab;
+
+typedef struct mm_pool {
+	size_t obj_size;	/* requested size rounded up to DSIZE, at least a pointer */
+	size_t slab_objs;	/* objects carved from one slab */
+	void *free_list;
+	pool_slab *slabs;
+	pthread_mutex_t lock;
+} mm_pool;
+
+mm_pool *mm_pool_create(size_t size);
+void *mm_pool_alloc(mm_pool *pool);
+void mm_pool_free(mm_pool *pool, void *p);
+void mm_pool_destroy(mm_pool *pool);
+
+/*
+ * Allocator statistics, compiled in only with -DMM_STATS (mm_bench).
+ * Counters are bumped without the lock, so they are exact only when one
+ * thread uses the allocator. Per-class counters are indexed by the size
+ * class of the request's block size; a tcache refill counts each block it
+ * takes from the heap as its own fit/extend.
+ */
+#ifdef MM_STATS
+typedef struct mm_stats {
+	unsigned long req[ClassSize];	/* mm_malloc calls served by the heap or tcache */
+	unsigned long tcache_hit[ClassSize];	/* taken from a non-empty thread bin */
+	unsigned long fit_own[ClassSize];	/* first fit inside the request's class */
+	unsigned long fit_next[ClassSize];	/* head of a larger non-empty class */
+	unsigned long extend[ClassSize];	/* no fit, the heap was extended */
+	unsigned long mmap_req;	/* blocks given their own mapping */
+	size_t mmap_bytes;	/* bytes mapped by mmap_alloc right now */
+	size_t free_bytes;	/* in the free lists, filled in by mm_stats */
+	size_t largest_free;	/* largest block in the free lists, likewise */
+} mm_stats_t;
+
+static mm_stats_t Stats;
+#define STAT(x) (x)
+
+void mm_stats(mm_stats_t *st);
+#else
+#define STAT(x) ((void)0)
+#endif
+
+/*
+ * Allocation site profile, compiled in only with -DMM_PROFILE. Every
+ * PROF_RATE-th mm_malloc/mm_realloc of a thread is sampled: the block is
+ * asked for one word more and that last word (the pad word before the
+ * header for a mapped block) holds seq + 1 of its record in ProfRing.
+ * A record is live until the block is freed or reallocated, which sets
+ * died. Slots are claimed with one atomic add and reused when the ring
+ * wraps, so a block whose record was overwritten is simply not counted.
+ * mm_profile_dump prints one line per call site; call it while the
+ * allocator is quiet, the records are read without synchronization.
+ */
+#ifdef MM_PROFILE
+#ifndef PROF_RATE
+#define PROF_RATE 64	/* one sampled allocation in this many per thread */
+#endif
+#define PROF_RECORDS (1 << 16)	/* ring size, a power of two */
+
+typedef struct prof_rec {
+	void *bp;
+	void *site;	/* return address of the mm_malloc/mm_realloc call */
+	size_t size;
+	unsigned long born;	/* ns, CLOCK_MONOTONIC */
+	unsigned long died;	/* 0 while the block is live */
+	unsigned int seq;	/* claim number + 1, 0 for an unused slot */
+} prof_rec;
+
+static prof_rec ProfRing[PROF_RECORDS];
+static unsigned int ProfNext = 0;
+static __thread unsigned int ProfTick = 0;
+
+static void *prof_alloc(void *bp, size_t size, void *site);
+static void prof_free(void *bp);
+void mm_profile_dump(FILE *fp);
+#endif
+
+static void *malloc_block(size_t size);
+static void free_block(void *bp);
+static void *realloc_block(void *oldbp, size_t size);
 
 
 
@@ -98,13 +286,23 @@ int mm_init(void)
 		return -1;
 
 	memset(HeapBlocks, 0, ClassSize*WSIZE);
-	FreeBlocks = (char **)HeapBlocks;
+	FreeBlocks = (unsigned int *)HeapBlocks;
+	/* keep the class 0 slot away from offset 0 (NULL) */
+	HeapBase = HeapBlocks - DSIZE;
+	ClassMap = 0;
+	HeapGen++;
+	STAT(memset(&Stats, 0, sizeof(Stats)));
+#ifdef MM_PROFILE
+	memset(ProfRing, 0, sizeof(ProfRing));
+	ProfNext = 0;
+#endif
+	PageSize = sysconf(_SC_PAGESIZE);
 
 
 	HeapBlocks += ClassSize * WSIZE;
 	PUT(HeapBlocks, PACK(DSIZE, 1));
 	PUT(HeapBlocks + (1 * WSIZE), PACK(DSIZE, 1));
-	PUT(HeapBlocks + (2 * WSIZE), PACK(0, 1));
+	PUT(HeapBlocks + (2 * WSIZE), PACK(0, 1) | PREV_ALLOC);
 	HeapBlocks += (1 * WSIZE);
 	/* Extend the empty heap with a free block of CHUNKSIZE bytes */
 	if (extend_heap(CHUNKSIZE / WSIZE) == NULL)
@@ -115,143 +313,616 @@ int mm_init(void)
 /* $end mminit */
 
 /*
- * mm_malloc - Allocate a block with at least size bytes of payload
+ * mm_malloc, mm_free, mm_realloc - The public entry points, which only
+ *                                  add the profile hooks
  */
- /* $begin mmmalloc */
 void *mm_malloc(size_t size)
 {
+#ifdef MM_PROFILE
+	if (++ProfTick >= PROF_RATE) {
+		ProfTick = 0;
+		return prof_alloc(malloc_block(size + WSIZE), size, __builtin_return_address(0));
+	}
+#endif
+	return malloc_block(size);
+}
+
+void mm_free(void *bp)
+{
+#ifdef MM_PROFILE
+	prof_free(bp);
+#endif
+	free_block(bp);
+}
+
+void *mm_realloc(void *oldbp, size_t size)
+{
+#ifdef MM_PROFILE
+	//옛 블락의 기록은 먼저 끝낸다, 실패해서 그대로 남아도 다시 세지는 않는다
+	if (oldbp != NULL)
+		prof_free(oldbp);
+	if (size != 0 && ++ProfTick >= PROF_RATE) {
+		ProfTick = 0;
+		return prof_alloc(realloc_block(oldbp, size + WSIZE), size, __builtin_return_address(0));
+	}
+#endif
+	return realloc_block(oldbp, size);
+}
 
+/*
+ * malloc_block - Allocate a block with at least size bytes of payload
+ */
+ /* $begin mmmalloc */
+static void *malloc_block(size_t size)
+{
 	char *bp;
 	size_t size2;
-	size_t newSize;
+	tcache_t *tc;
+	int i;
 
-	//  0̶ ó θ
+	//만약 사이즈가 0이라면 에러처리로 널리턴
 	if (size <= 0)
 		return NULL;
 
-	//   ũٸ 
-	if (size > DSIZE) size2 = DSIZE * ((size + DSIZE + (DSIZE - 1)) / DSIZE);
-	//۰ų ٸ size2  2
-	else size2 = 2 * DSIZE;
+	//헤더 한 워드를 더해 더블워드로 올린다, 최소는 블락사이즈
+	size2 = ASIZE(size);
+
+	//큰 블락은 힙을 거치지 않고 따로 매핑한다
+	if (size2 >= MMAP_THRESHOLD)
+		return mmap_alloc(size2);
 
-	//Ʈ  ڸ ãƼ ִ´.
+	STAT(Stats.req[size_class_of(size2)]++);
+	if (size2 > TCACHE_MAX) {
+		pthread_mutex_lock(&HeapLock);
+		bp = heap_malloc(size2);
+		pthread_mutex_unlock(&HeapLock);
+		return bp;
+	}
+
+	//작은 블락은 쓰레드 캐시에서 꺼내고, 비어있으면 락 한번에 여러개를 받아둔다
+	tc = tcache_get();
+	i = size2 / DSIZE - 2;
+	if (tc->bin[i] == NULL) {
+		pthread_mutex_lock(&HeapLock);
+		while (tc->count[i] < TCACHE_FILL && (bp = heap_malloc(size2)) != NULL) {
+			*(void **)bp = tc->bin[i];
+			tc->bin[i] = bp;
+			tc->count[i]++;
+		}
+		pthread_mutex_unlock(&HeapLock);
+		if (tc->bin[i] == NULL)
+			return NULL;
+	}
+	else STAT(Stats.tcache_hit[size_class_of(size2)]++);
+	bp = tc->bin[i];
+	tc->bin[i] = *(void **)bp;
+	tc->count[i]--;
+	return bp;
+}
+/* $end mmmalloc */
+
+/*
+ * heap_malloc - Allocate an asize byte block from the free lists, HeapLock held
+ */
+static void *heap_malloc(size_t size2)
+{
+	char *bp;
+	size_t newSize;
+
+	//프리리스트에서 들어갈 자리를 찾아서 넣는다.
 	if ((bp = find_fit(size2)) != NULL) {
 		place(bp, size2);
 		return bp;
 	}
 
-	// ڸ ٸ  Ȯ
+	//들어갈 자리가 없다면 공간을 확장
+	STAT(Stats.extend[size_class_of(size2)]++);
 	newSize = MAX(size2, CHUNKSIZE);
-	//Ȯ ߴٸ null
+	//확장이 실패했다면 null리턴
 	if ((bp = extend_heap(newSize / WSIZE)) == NULL) return NULL;
-	//ƴ϶ ڸ size2ŭ alloc
+	//아니라면 그자리에 size2만큼 alloc
 	place(bp, size2);
 
 	return bp;
 }
-/* $end mmmalloc */
 
 /*
- * mm_free - Free a block
+ * free_block - Free a block
  */
  /* $begin mmfree */
-void mm_free(void *bp)
+static void free_block(void *bp)
 {
-	// ޾ƿ´
+	//블럭사이즈를 받아온다, 할당된 블락의 헤더는 주인 말고는 건드리지 않는다
 	size_t size = GET_SIZE(HDRP(bp));
-	// ǲ͸ ش.
+	tcache_t *tc;
+	int i;
+
+	if (GET(HDRP(bp)) & MMAPPED) {
+		STAT(Stats.mmap_bytes -= MAP_LEN(bp));
+		munmap((char *)bp - MMAP_HDR, MAP_LEN(bp));
+		return;
+	}
+
+	if (size > TCACHE_MAX) {
+		pthread_mutex_lock(&HeapLock);
+		heap_free(bp);
+		pthread_mutex_unlock(&HeapLock);
+		return;
+	}
+
+	//작은 블락은 할당 표시 그대로 쓰레드 캐시에 넣고, 넘치면 반을 락 한번에 돌려준다
+	tc = tcache_get();
+	i = size / DSIZE - 2;
+	*(void **)bp = tc->bin[i];
+	tc->bin[i] = bp;
+	if (++tc->count[i] > TCACHE_COUNT) {
+		pthread_mutex_lock(&HeapLock);
+		while (tc->count[i] > TCACHE_COUNT / 2) {
+			bp = tc->bin[i];
+			tc->bin[i] = *(void **)bp;
+			tc->count[i]--;
+			heap_free(bp);
+		}
+		pthread_mutex_unlock(&HeapLock);
+	}
+}
+
+/* $end mmfree */
+
+/*
+ * heap_free - Give a block back to the free lists, HeapLock held
+ */
+static void heap_free(void *bp)
+{
+	size_t size = GET_SIZE(HDRP(bp));
+	//헤더랑 풋터를 변경해준다.
 	put_head_foot(bp, size, 0);
-	//  üũ
+	//안전을 위한 체크
 	put(bp, 0);
 
-	//ģ  Ʈ ִ´.
-	free_list_insert(coalesce(bp));
+	//합친 블락을 리스트에 넣는다.
+	bp = coalesce(bp);
+	free_list_insert(bp);
 
+	//페이지 이상을 돌려준 free가 힙 끝에 큰 free 블락을 남기면 그 페이지들을 OS에 돌려준다
+	if (size >= CHUNKSIZE)
+		heap_trim(bp);
 }
 
-/* $end mmfree */
+/*
+ * heap_trim - Release the whole pages of bp if it is a free block of at
+ *             least TRIM_THRESHOLD bytes right before the epilogue
+ */
+static void heap_trim(void *bp)
+{
+	size_t size = GET_SIZE(HDRP(bp));
+	char *start, *end;
+
+	if (size < TRIM_THRESHOLD || GET_SIZE(HDRP(NEXT_BLKP(bp))) != 0)
+		return;
+	//링크 두 워드와 풋터가 있는 페이지는 남긴다
+	start = (char *)(((size_t)bp + DSIZE + PageSize - 1) & ~(PageSize - 1));
+	end = (char *)((size_t)FTRP(bp) & ~(PageSize - 1));
+	if (start < end)
+		madvise(start, end - start, MADV_DONTNEED);
+}
 
 /*
- * mm_realloc - naive implementation of mm_realloc
+ * mmap_alloc - Give an asize byte block its own mapping
  */
-void *mm_realloc(void *oldbp, size_t size)
+static void *mmap_alloc(size_t asize)
 {
-	// 
-	size_t old_size = GET_SIZE(HDRP(oldbp));
-	size_t size2, next_block, copy_size;
-	//  ų 
+	size_t len = (asize + MMAP_HDR + PageSize - 1) & ~(PageSize - 1);
+	char *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	char *bp;
+
+	if (map == MAP_FAILED)
+		return NULL;
+	bp = map + MMAP_HDR;
+	MAP_LEN(bp) = len;
+	PUT(HDRP(bp), PACK(0, MMAPPED | 1));
+	STAT(Stats.mmap_req++);
+	STAT(Stats.mmap_bytes += len);
+	return bp;
+}
+
+/*
+ * mmap_realloc - Resize a mapped block, moving it back to the heap when
+ *                it shrinks below MMAP_THRESHOLD
+ */
+static void *mmap_realloc(void *bp, size_t size)
+{
+	size_t old_len = MAP_LEN(bp);
+	size_t asize = ASIZE(size);
+	size_t len = (asize + MMAP_HDR + PageSize - 1) & ~(PageSize - 1);
+	char *map;
+	void *newbp;
+
+	if (asize >= MMAP_THRESHOLD) {
+		if (len == old_len)
+			return bp;
+		//커널이 페이지를 옮기므로 복사하지 않는다
+		map = mremap((char *)bp - MMAP_HDR, old_len, len, MREMAP_MAYMOVE);
+		if (map == MAP_FAILED)
+			return NULL;
+		*(size_t *)map = len;
+		STAT(Stats.mmap_bytes += len - old_len);
+		return map + MMAP_HDR;
+	}
+
+	if ((newbp = malloc_block(size)) == NULL)
+		return NULL;
+	memcpy(newbp, bp, size);
+	STAT(Stats.mmap_bytes -= old_len);
+	munmap((char *)bp - MMAP_HDR, old_len);
+	return newbp;
+}
+
+/*
+ * realloc_block - Resize in place when the neighbours or the heap end allow it,
+ *                 otherwise allocate, copy and free
+ */
+static void *realloc_block(void *oldbp, size_t size)
+{
+	size_t old_size, size2, copy_size;
+	//새 공간을 가리킬 포인터
 	void *newbp;
 
-	// ͸ ޾Ҵٸ ׳   ŭ malloc
+	//만약 널포인터를 받았다면 그냥 그 사이즈 만큼 malloc
 	if (oldbp == NULL) {
-		return mm_malloc(size);
+		return malloc_block(size);
 	}
 
-	// 0̶ free 
+	//사이즈가 0이라면 free랑 동일
 	if (size == 0) {
-		mm_free(oldbp);
+		free_block(oldbp);
 		return NULL;
 	}
 
-	//  ۰ų  
-	if (size <= DSIZE) {
-		size2 = 2 * DSIZE;
-	}
-	// ũٸ 
-	else {
-		size2 = DSIZE * ((size + DSIZE + (DSIZE - 1)) / DSIZE);
-	}
+	if (GET(HDRP(oldbp)) & MMAPPED)
+		return mmap_realloc(oldbp, size);
 
-	//   ʾҴٸ ߰ ۾ʿ x  ȯ
+	//원래 사이즈
+	old_size = GET_SIZE(HDRP(oldbp));
+
+	size2 = ASIZE(size);
+
+	//만약 사이즈가 변경되지 않았다면 추가 작업필요 x 원래꺼 반환
 	if (size2 == old_size) {
 		return oldbp;
 	}
 
-	// ū   Ҵ ϴ 
+	//더 큰 공간으로 재 할당 하는 경우
 	else if (size2 > old_size) {
-		//  ļ ذᰡ ȮѴ
-		next_block = GET_SIZE(HDRP(NEXT_BLKP(oldbp)));
-		//  Ҵ ȵ free ̰ Ҵ  ũ 
-		if (!GET_ALLOC(HDRP(NEXT_BLKP(oldbp)))) {
-			if (next_block + old_size >= size2) {
-				//ϴٸ   Ʈ  Ű  ǲ  
-				free_list_remove(NEXT_BLKP(oldbp));
-				put_head_foot(oldbp, old_size + next_block, 1);
-				return oldbp;
-			}
+		//옆 블락은 다른 쓰레드도 건드리므로 락 안에서 본다, 큰 블락이 되면 매핑으로 옮긴다
+		if (size2 < MMAP_THRESHOLD) {
+			pthread_mutex_lock(&HeapLock);
+			newbp = grow_in_place(oldbp, size2);
+			pthread_mutex_unlock(&HeapLock);
+			if (newbp != NULL)
+				return newbp;
 		}
 
-		//ʺ free 쿡 Ҵ   ؾϹǷ
-		//ǹ ϹǷ ׳   ְ  Ҵϸ  Ѵ.
-
-		//ο   Ҵ
-		newbp = mm_malloc(size);
-		//  :  ũ= ũ⿡ ǲͻŭ
-		copy_size = old_size - DSIZE;
+		//새로운 공간에 재 할당
+		newbp = malloc_block(size);
+		if (newbp == NULL)
+			return NULL;
+		//정보 복사 : 복사할 크기= 원래크기에서 헤더뺀만큼
+		copy_size = old_size - WSIZE;
 		memcpy(newbp, oldbp, copy_size);
-		//  free
-		mm_free(oldbp);
+		//원래 블락 free
+		free_block(oldbp);
 		return newbp;
 	}
 
-	//   Ҵ ϴ 
+	//더 적은 공간으로 재할당 하는 경우
 	else {
-		//پ  ũⰡ  ũų 
-		if (old_size - size2 >= BLOCKSIZE) {
-			//پ   
-			put_head_foot(oldbp, size2, 1);
-			//next   ޾ƿͼ ǲ    free Ʈ ־ش.
-			newbp = NEXT_BLKP(oldbp);
-			put_head_foot(newbp, old_size - size2, 0);
-			put(newbp, 0);
-			free_list_insert(newbp);
+		//남는 부분이 블락사이즈 이상이면 떼어서 옆의 free 블락과 합쳐 리스트에 넣는다
+		pthread_mutex_lock(&HeapLock);
+		split_alloc(oldbp, old_size, size2);
+		pthread_mutex_unlock(&HeapLock);
+		return oldbp;
+	}
+}
+
+/*
+ * grow_in_place - Grow bp to asize without leaving its neighbourhood,
+ *                 HeapLock held. Returns the new block or NULL.
+ *
+ * In order of preference: absorb the next free block, extend the heap when
+ * bp (or bp and its free successor) is last before the epilogue, and
+ * finally merge with a free previous block and slide the payload down.
+ */
+static void *grow_in_place(void *bp, size_t asize)
+{
+	size_t size = GET_SIZE(HDRP(bp));
+	char *next = NEXT_BLKP(bp);
+	char *prev;
+	size_t avail = size;
+	int next_free = !GET_ALLOC(HDRP(next));
+
+	if (next_free)
+		avail += GET_SIZE(HDRP(next));
+
+	//힙의 끝이면 모자란 만큼 늘린다, 새 블락은 next 자리에서 시작한다 (next가 free면 합쳐진다)
+	if (avail < asize && (GET_SIZE(HDRP(next)) == 0 || (next_free && GET_SIZE(HDRP(NEXT_BLKP(next))) == 0))) {
+		if (extend_heap(MAX(asize - avail, CHUNKSIZE) / WSIZE) == NULL)
+			return NULL;
+		next_free = 1;
+		avail = size + GET_SIZE(HDRP(next));
+	}
+
+	if (avail >= asize) {
+		if (next_free)
+			free_list_remove(next);
+		split_alloc(bp, avail, asize);
+		return bp;
+	}
+
+	//앞 블락까지 합치면 되는 경우, 링크를 쓰기 전에 리스트에서 빼고 데이터를 앞으로 옮긴다
+	if (GET_PREV_ALLOC(HDRP(bp)))
+		return NULL;
+	prev = PREV_BLKP(bp);
+	avail += GET_SIZE(HDRP(prev));
+	if (avail < asize)
+		return NULL;
+	free_list_remove(prev);
+	if (next_free)
+		free_list_remove(next);
+	memmove(prev, bp, size - WSIZE);
+	split_alloc(prev, avail, asize);
+	return prev;
+}
+
+/*
+ * split_alloc - Mark bp allocated with asize of its total bytes and
+ *               return a large enough remainder to the free lists
+ */
+static void split_alloc(void *bp, size_t total, size_t asize)
+{
+	char *rest;
+
+	if (total - asize < BLOCKSIZE) {
+		put_head_foot(bp, total, 1);
+		return;
+	}
+	put_head_foot(bp, asize, 1);
+	rest = NEXT_BLKP(bp);
+	//rest의 헤더 자리는 원래 페이로드였으므로 앞 블락 할당 표시부터 새로 쓴다
+	PUT(HDRP(rest), PREV_ALLOC);
+	put_head_foot(rest, total - asize, 0);
+	put(rest, 0);
+	free_list_insert(coalesce(rest));
+}
+
+/*
+ * mm_pool_create - Make a pool of size byte objects
+ */
+mm_pool *mm_pool_create(size_t size)
+{
+	mm_pool *pool;
+	size_t slab;
+
+	if (size == 0)
+		return NULL;
+	if ((pool = mm_malloc(sizeof(mm_pool))) == NULL)
+		return NULL;
+
+	pool->obj_size = sideby(MAX(size, sizeof(void *)));
+	//큰 객체도 한 슬랩에 POOL_MIN_OBJS개는 들어가게
+	slab = MAX(POOL_SLAB, sideby(sizeof(pool_slab)) + POOL_MIN_OBJS * pool->obj_size);
+	pool->slab_objs = (slab - sideby(sizeof(pool_slab))) / pool->obj_size;
+	pool->free_list = NULL;
+	pool->slabs = NULL;
+	pthread_mutex_init(&pool->lock, NULL);
+	return pool;
+}
+
+/*
+ * mm_pool_alloc - Take an object, carving a new slab when the pool is empty
+ */
+void *mm_pool_alloc(mm_pool *pool)
+{
+	pool_slab *slab;
+	char *obj;
+	void *bp;
+	size_t i;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->free_list == NULL) {
+		slab = mm_malloc(sideby(sizeof(pool_slab)) + pool->slab_objs * pool->obj_size);
+		if (slab == NULL) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		slab->next = pool->slabs;
+		pool->slabs = slab;
+
+		//뒤에서부터 넣어서 앞쪽 객체부터 나가게
+		obj = (char *)slab + sideby(sizeof(pool_slab));
+		for (i = pool->slab_objs; i > 0; i--) {
+			bp = obj + (i - 1) * pool->obj_size;
+			*(void **)bp = pool->free_list;
+			pool->free_list = bp;
 		}
+	}
+	bp = pool->free_list;
+	pool->free_list = *(void **)bp;
+	pthread_mutex_unlock(&pool->lock);
+	return bp;
+}
 
-		//پ ũⰡ    ׳ 
-		return oldbp;
+/*
+ * mm_pool_free - Give an object from mm_pool_alloc back to its pool
+ */
+void mm_pool_free(mm_pool *pool, void *p)
+{
+	if (p == NULL)
+		return;
+	pthread_mutex_lock(&pool->lock);
+	*(void **)p = pool->free_list;
+	pool->free_list = p;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * mm_pool_destroy - Free every slab of the pool and the pool itself
+ */
+void mm_pool_destroy(mm_pool *pool)
+{
+	pool_slab *slab;
+
+	if (pool == NULL)
+		return;
+	while ((slab = pool->slabs) != NULL) {
+		pool->slabs = slab->next;
+		mm_free(slab);
 	}
+	pthread_mutex_destroy(&pool->lock);
+	mm_free(pool);
 }
 
+#ifdef MM_STATS
+/*
+ * mm_stats - Copy the counters and measure the free lists
+ */
+void mm_stats(mm_stats_t *st)
+{
+	char *bp;
+	int c;
+
+	pthread_mutex_lock(&HeapLock);
+	*st = Stats;
+	st->free_bytes = 0;
+	st->largest_free = 0;
+	for (c = 0; c < ClassSize; c++) {
+		for (bp = PTR(GET(FreeBlocks + c)); bp != NULL; bp = pAtC_GET(bp)) {
+			st->free_bytes += GET_SIZE(HDRP(bp));
+			st->largest_free = MAX(st->largest_free, GET_SIZE(HDRP(bp)));
+		}
+	}
+	pthread_mutex_unlock(&HeapLock);
+}
+#endif
+
+#ifdef MM_PROFILE
+/* where a sampled block keeps its seq + 1 */
+static unsigned int *prof_word(void *bp)
+{
+	if (GET_SIZE(HDRP(bp)) == 0)
+		return (unsigned int *)((char *)bp - DSIZE);
+	return (unsigned int *)((char *)bp + GET_SIZE(HDRP(bp)) - DSIZE);
+}
+
+static unsigned long prof_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+/*
+ * prof_alloc - Record bp, allocated with a spare last word, as a sample
+ */
+static void *prof_alloc(void *bp, size_t size, void *site)
+{
+	unsigned int seq;
+	prof_rec *r;
+
+	if (bp == NULL)
+		return NULL;
+	seq = __atomic_fetch_add(&ProfNext, 1, __ATOMIC_RELAXED);
+	r = &ProfRing[seq & (PROF_RECORDS - 1)];
+	r->seq = 0;
+	r->bp = bp;
+	r->site = site;
+	r->size = size;
+	r->born = prof_now();
+	r->died = 0;
+	__atomic_store_n(&r->seq, seq + 1, __ATOMIC_RELEASE);
+	*prof_word(bp) = seq + 1;
+	return bp;
+}
+
+/*
+ * prof_free - End the record of bp if it is a live sample. The word of an
+ *             unsampled block is user data, so a record only counts when
+ *             it is live and points back at bp
+ */
+static void prof_free(void *bp)
+{
+	unsigned int v = *prof_word(bp);
+	prof_rec *r;
+
+	if (v == 0)
+		return;
+	r = &ProfRing[(v - 1) & (PROF_RECORDS - 1)];
+	if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != v || r->bp != bp || r->died != 0)
+		return;
+	r->died = prof_now();
+	*prof_word(bp) = 0;
+}
+
+typedef struct prof_site {
+	void *site;
+	unsigned long count, live, freed;
+	size_t bytes;
+	unsigned long life;	/* summed over freed samples, ns */
+} prof_site;
+
+static int prof_cmp_site(const void *a, const void *b)
+{
+	const prof_rec *x = a, *y = b;
+	return x->site < y->site ? -1 : x->site > y->site;
+}
+
+static int prof_cmp_count(const void *a, const void *b)
+{
+	const prof_site *x = a, *y = b;
+	return x->count < y->count ? 1 : x->count > y->count ? -1 : 0;
+}
+
+/*
+ * mm_profile_dump - Print the samples grouped by call site, most sampled
+ *                   site first. est is count * PROF_RATE
+ */
+void mm_profile_dump(FILE *fp)
+{
+	static prof_rec snap[PROF_RECORDS];
+	static prof_site sites[PROF_RECORDS];
+	int n = 0, ns = 0, i;
+
+	for (i = 0; i < PROF_RECORDS; i++)
+		if (ProfRing[i].seq != 0)
+			snap[n++] = ProfRing[i];
+	qsort(snap, n, sizeof(prof_rec), prof_cmp_site);
+
+	for (i = 0; i < n; i++) {
+		if (ns == 0 || sites[ns - 1].site != snap[i].site) {
+			memset(&sites[ns], 0, sizeof(prof_site));
+			sites[ns++].site = snap[i].site;
+		}
+		sites[ns - 1].count++;
+		sites[ns - 1].bytes += snap[i].size;
+		if (snap[i].died) {
+			sites[ns - 1].freed++;
+			sites[ns - 1].life += snap[i].died - snap[i].born;
+		}
+		else sites[ns - 1].live++;
+	}
+	qsort(sites, ns, sizeof(prof_site), prof_cmp_count);
+
+	fprintf(fp, "%-18s %8s %10s %10s %8s %8s %12s\n",
+			"site", "samples", "est", "avg_size", "live", "freed", "avg_life_us");
+	for (i = 0; i < ns; i++) {
+		prof_site *s = &sites[i];
+		fprintf(fp, "%-18p %8lu %10lu %10zu %8lu %8lu %12.1f\n", s->site, s->count,
+				s->count * PROF_RATE, s->bytes / s->count, s->live, s->freed,
+				s->freed ? s->life / 1000.0 / s->freed : 0.0);
+	}
+}
+#endif
+
 /*
  * mm_checkheap - Check the heap for consistency
  *//*
@@ -294,7 +965,7 @@ static void *extend_heap(size_t words) {
 		return NULL;
 
 	/* Initialize free block header/footer and the epilogue header */
-	PUT(HDRP(bp), PACK(size, 0)); 			/* free block header */
+	PUT(HDRP(bp), PACK(size, 0) | GET_PREV_ALLOC(HDRP(bp)));	/* free block header, pa from the old epilogue */
 	PUT(FTRP(bp), PACK(size, 0)); 			/* free block footer */
 	PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 1)); 	/* new epilogue header */
 
@@ -316,16 +987,16 @@ static void *extend_heap(size_t words) {
 static void place(void *bp, size_t asize) {
 	/* $end mmplace-proto */
 	size_t csize = GET_SIZE(HDRP(bp));
+	unsigned int pa = GET_PREV_ALLOC(HDRP(bp));
 
 	if ((csize - asize) >= BLOCKSIZE) {
 
 		free_list_remove(bp);
 
-		PUT(HDRP(bp), PACK(asize, 1));
-		PUT(FTRP(bp), PACK(asize, 1));
+		PUT(HDRP(bp), PACK(asize, 1) | pa);
 
 		bp = NEXT_BLKP(bp);
-		PUT(HDRP(bp), PACK(csize - asize, 0));
+		PUT(HDRP(bp), PACK(csize - asize, 0) | PREV_ALLOC);
 		PUT(FTRP(bp), PACK(csize - asize, 0));
 
 		PUT(p_to_char(bp), 0);
@@ -334,8 +1005,8 @@ static void place(void *bp, size_t asize) {
 	}
 	else {
 		free_list_remove(bp);
-		PUT(HDRP(bp), PACK(csize, 1));
-		PUT(FTRP(bp), PACK(csize, 1));
+		PUT(HDRP(bp), PACK(csize, 1) | pa);
+		set_prev_alloc(NEXT_BLKP(bp), 1);
 	}
 }
 /* $end mmplace */
@@ -345,47 +1016,60 @@ static void place(void *bp, size_t asize) {
  */
 static void *find_fit(size_t asize) {
 
-	size_t tmp_s = asize;
-	int size_class = 0;
-	int sumr = 0;
-	while (asize > BLOCKSIZE && size_class < ClassSize - 1) {
-		size_class++;
-		sumr += asize % 2;
-		asize /= 2;
-	}
-	if (size_class < ClassSize - 1 && sumr > 0 && asize == BLOCKSIZE) {
-		size_class++;
-	}
-	
-	void *class_p, *bp;
-	size_t sizeB;
-
-	/* search from the rover to the end of list */
-	while (size_class < ClassSize) {
-		class_p = FreeBlocks + size_class;
-
-		/* search from start of list to old rover */
-		if (GET(class_p) != 0) {
-			bp = (void *)GET(class_p);
-			while (bp != ((void *)0)) {
-				sizeB = GET_SIZE(HDRP(bp));
-				if (tmp_s <= sizeB) {
-					return bp;
-				}
-				bp = pAtC_GET(bp);
-			}
+	int size_class = size_class_of(asize);
+	unsigned int map = ClassMap >> size_class;
+	void *bp;
+
+	if (map == 0)
+		return NULL;
+
+	/* the asize class can hold smaller blocks */
+	if (map & 1) {
+		if ((bp = good_fit(size_class, asize)) != NULL) {
+			STAT(Stats.fit_own[size_class]++);
+			return bp;
 		}
-		size_class++;
+		map &= ~1u;
+		if (map == 0)
+			return NULL;
 	}
 
-	return NULL; // no fit found
+	/* every block of a larger class fits, the first non-empty one has the tightest */
+	STAT(Stats.fit_next[size_class]++);
+	size_class += __builtin_ctz(map);
+	return good_fit(size_class, asize);
+}
+
+/*
+ * good_fit - Smallest of the first FIT_SEARCH blocks of a list that fit,
+ *            stopping early at a block that would leave nothing to split
+ */
+static void *good_fit(int size_class, size_t asize) {
+	char *bp, *best = NULL;
+	size_t size, best_size = 0;
+	int n = 0;
+
+	for (bp = PTR(GET(FreeBlocks + size_class)); bp != NULL; bp = pAtC_GET(bp)) {
+		size = GET_SIZE(HDRP(bp));
+		if (size < asize)
+			continue;
+		if (best == NULL || size < best_size) {
+			best = bp;
+			best_size = size;
+			if (size - asize < BLOCKSIZE)
+				break;
+		}
+		if (++n >= FIT_SEARCH)
+			break;
+	}
+	return best;
 }
 
 /*
  * coalesce - boundary tag coalescing. Return ptr to coalesced block
  */
 static void *coalesce(void *bp) {
-	size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+	size_t prev_alloc = GET_PREV_ALLOC(HDRP(bp));
 	size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
 	size_t size = GET_SIZE(HDRP(bp));
 
@@ -398,7 +1082,7 @@ static void *coalesce(void *bp) {
 		free_list_remove(NEXT_BLKP(bp));
 
 		size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
-		PUT(HDRP(bp), PACK(size, 0));
+		PUT(HDRP(bp), PACK(size, 0) | PREV_ALLOC);
 		PUT(FTRP(bp), PACK(size, 0));
 	}
 
@@ -408,7 +1092,7 @@ static void *coalesce(void *bp) {
 
 		size += GET_SIZE(HDRP(PREV_BLKP(bp)));
 		PUT(FTRP(bp), PACK(size, 0));
-		PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
+		PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC);
 		bp = PREV_BLKP(bp);
 	}
 
@@ -418,7 +1102,7 @@ static void *coalesce(void *bp) {
 		free_list_remove(NEXT_BLKP(bp));
 
 		size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(FTRP(NEXT_BLKP(bp)));
-		PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
+		PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC);
 		PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0));
 		bp = PREV_BLKP(bp);
 	}
@@ -454,33 +1138,37 @@ static void checkblock(void *bp)
 }*/
 
 static void free_list_insert(void *bp) {
-	size_t size = GET_SIZE(HDRP(bp));
-	char **size_class_ptr;
-	unsigned int bp_val = (unsigned int)bp;
-
-	int size_class = 0;
-	int sumr = 0;
-	while (size > BLOCKSIZE && size_class < ClassSize - 1) {
-		size_class++;
-		sumr += size % 2;
-		size /= 2;
-	}
-	if (size_class < ClassSize - 1 && sumr > 0 && size == BLOCKSIZE) {
-		size_class++;
-	}
-	
+	unsigned int *size_class_ptr;
+	unsigned int bp_val = OFF(bp);
+	int size_class = size_class_of(GET_SIZE(HDRP(bp)));
 
+	ClassMap |= 1u << size_class;
 	size_class_ptr = FreeBlocks + size_class;
+#ifdef MM_ADDR_ORDER
+	//주소 순서로 넣을 자리를 찾는다, 첫 블락보다 앞이면 아래의 머리 삽입과 같다
+	if (GET(size_class_ptr) != 0 && GET(size_class_ptr) < bp_val) {
+		unsigned int pred = GET(size_class_ptr);
+		unsigned int succ;
+		while ((succ = GET(pAtC(PTR(pred)))) != 0 && succ < bp_val)
+			pred = succ;
+		PUT(p_to_char(bp), pred);
+		PUT(pAtC(bp), succ);
+		PUT(pAtC(PTR(pred)), bp_val);
+		if (succ)
+			PUT(p_to_char(PTR(succ)), bp_val);
+		return;
+	}
+#endif
 	if (GET(size_class_ptr) == 0) {
 		PUT(size_class_ptr, bp_val);
-		PUT(p_to_char(bp), (unsigned int)size_class_ptr);
+		PUT(p_to_char(bp), OFF(size_class_ptr));
 		PUT( pAtC(bp), 0);
 	}
 
 	else {
-		PUT(p_to_char(bp), (unsigned int)size_class_ptr);
+		PUT(p_to_char(bp), OFF(size_class_ptr));
 		PUT( pAtC(bp), GET(size_class_ptr));
-		PUT(p_to_char(GET(size_class_ptr)), bp_val);
+		PUT(p_to_char(PTR(GET(size_class_ptr))), bp_val);
 		PUT(size_class_ptr, bp_val);
 	}
 
@@ -490,8 +1178,9 @@ static void free_list_insert(void *bp) {
 static void free_list_remove(void *bp) {
 	int pre ;
 
-	unsigned int valP = (unsigned int)p_char_GET(bp);
-	unsigned int p = (unsigned int)FreeBlocks;
+	//링크는 오프셋이므로 클래스 슬롯인지도 오프셋으로 비교
+	unsigned int valP = GET(p_to_char(bp));
+	unsigned int p = OFF(FreeBlocks);
 	unsigned int f = p + WSIZE * (ClassSize - 1);
 
 	if (valP > f || valP < p)
@@ -507,17 +1196,19 @@ static void free_list_remove(void *bp) {
 	}
 
 	if (!pre && suc) {
-		PUT(p_char_GET(bp), (unsigned int)pAtC_GET(bp));
-		PUT(p_to_char(pAtC_GET(bp)), (unsigned int)p_char_GET(bp));
+		PUT(p_char_GET(bp), GET(pAtC(bp)));
+		PUT(p_to_char(pAtC_GET(bp)), GET(p_to_char(bp)));
 	}
 
 	else if (!pre && !suc) {
-		PUT(p_char_GET(bp), (unsigned int)pAtC_GET(bp));
+		//리스트의 마지막 블락이었으므로 비트맵에서도 뺀다
+		PUT(p_char_GET(bp), GET(pAtC(bp)));
+		ClassMap &= ~(1u << ((valP - p) / WSIZE));
 	}
 
 	else if (pre && suc) {
-		PUT(pAtC(p_char_GET(bp)), (unsigned int)pAtC_GET(bp));
-		PUT(p_to_char(pAtC_GET(bp)), (unsigned int)p_char_GET(bp));
+		PUT(pAtC(p_char_GET(bp)), GET(pAtC(bp)));
+		PUT(p_to_char(pAtC_GET(bp)), GET(p_to_char(bp)));
 	}
 
 	else {
@@ -532,16 +1223,71 @@ static void free_list_remove(void *bp) {
 
 
 
-// ǲ 
+//헤더와 풋터의 정보조정, 앞 블락 표시는 그대로 두고 풋터는 free일때만 쓴다
+//다음 블락 헤더의 앞 블락 표시도 같이 바꾼다
 static void put_head_foot(void *bp, size_t size, int t) {
-	PUT(HDRP(bp), PACK(size, t));
-	PUT(FTRP(bp), PACK(size, t));
+	PUT(HDRP(bp), PACK(size, t) | GET_PREV_ALLOC(HDRP(bp)));
+	if (!t)
+		PUT(FTRP(bp), PACK(size, t));
+	set_prev_alloc(NEXT_BLKP(bp), t);
+
+}
 
+//bp 헤더의 앞 블락 할당 표시
+static void set_prev_alloc(void *bp, int t) {
+	if (t)
+		PUT(HDRP(bp), GET(HDRP(bp)) | PREV_ALLOC);
+	else
+		PUT(HDRP(bp), GET(HDRP(bp)) & ~PREV_ALLOC);
 }
 
-//t ش ּҿ write
+//t로 해당 주소에 write
 static void put(void *bp, unsigned int t) {
 	PUT(p_to_char(bp), t);
 	PUT(pAtC(bp), t);
 
 }
+
+//쓰레드가 끝날때 캐시에 남은 블락을 프리리스트로 돌려준다
+static void tcache_flush(void *arg) {
+	tcache_t *tc = arg;
+	void *bp;
+	int i;
+
+	if (tc->gen != HeapGen)
+		return;
+	pthread_mutex_lock(&HeapLock);
+	for (i = 0; i < TCACHE_BINS; i++) {
+		while ((bp = tc->bin[i]) != NULL) {
+			tc->bin[i] = *(void **)bp;
+			heap_free(bp);
+		}
+		tc->count[i] = 0;
+	}
+	pthread_mutex_unlock(&HeapLock);
+}
+
+static void tcache_key_init(void) {
+	pthread_key_create(&TcacheKey, tcache_flush);
+}
+
+//이 쓰레드의 캐시, 처음 쓰거나 mm_init으로 힙이 새로 만들어졌으면 비우고 시작
+static tcache_t *tcache_get(void) {
+	if (tcache.gen != HeapGen) {
+		memset(&tcache, 0, sizeof(tcache));
+		tcache.gen = HeapGen;
+		pthread_once(&TcacheOnce, tcache_key_init);
+		pthread_setspecific(TcacheKey, &tcache);
+	}
+	return &tcache;
+}
+
+//사이즈 클래스, 16 이하는 0번이고 그 위로는 2배마다 한칸씩 (마지막 클래스에 나머지 전부)
+static int size_class_of(size_t size) {
+	int size_class;
+
+	if (size <= BLOCKSIZE)
+		return 0;
+	size_class = 8 * sizeof(unsigned long) - __builtin_clzl((size - 1) / BLOCKSIZE);
+	return MIN(size_class, ClassSize - 1);
+}
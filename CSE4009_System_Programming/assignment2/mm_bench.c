@@ -0,0 +1,330 @@
+/*
+ * mm_bench.c - Replay allocation traces against mm.c and glibc malloc
+ *
+ * Traces use the CS:APP format read by mdriver:
+ *
+ *     <suggested heap size>
+ *     <number of ids>
+ *     <number of ops>
+ *     <weight>
+ *     a <id> <size>      malloc, the block is known as id from now on
+ *     r <id> <size>      realloc of block id
+ *     f <id>             free of block id
+ *
+ * mm_trace.so records the same format from a running program.
+ *
+ * Each trace is replayed -r times per allocator for throughput (only the
+ * ops are timed), then once more while sampling every -i ops:
+ *   live       payload bytes the trace holds
+ *   footprint  heap size plus mmap'd bytes (mm), arena plus mmap'd
+ *              bytes from mallinfo2 (libc)
+ *   frag       1 - live / footprint
+ * util is peak live / peak footprint, the mdriver utilization.
+ * For mm the per size class table shows where requests were served from.
+ *
+ * build : gcc -O2 -DMM_STATS -o mm_bench mm_bench.c mm.c memlib.c -lpthread
+ *         (memlib.c, memlib.h, mm.h and config.h come with the handout;
+ *          config.h MAX_HEAP limits the traces mm can replay)
+ * usage : ./mm_bench [-r repeats] [-i interval] [-f] [-l] trace ...
+ *   -r  timed replays per allocator (default 5)
+ *   -i  ops between fragmentation samples (default ops / 100)
+ *   -f  print every fragmentation sample, not only the summary
+ *   -l  replay on glibc malloc as well
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+/* mm.h is not part of this tree, keep in sync with mm_stats_t in mm.c */
+#define MM_CLASSES 17
+typedef struct mm_stats {
+	unsigned long req[MM_CLASSES];
+	unsigned long tcache_hit[MM_CLASSES];
+	unsigned long fit_own[MM_CLASSES];
+	unsigned long fit_next[MM_CLASSES];
+	unsigned long extend[MM_CLASSES];
+	unsigned long mmap_req;
+	size_t mmap_bytes;
+	size_t free_bytes;
+	size_t largest_free;
+} mm_stats_t;
+void mm_stats(mm_stats_t *st);
+
+#define DEFAULT_REPEAT 5
+#define DEFAULT_SAMPLES 100
+
+typedef struct op_t {
+	char type;	/* 'a', 'r' or 'f' */
+	int id;
+	size_t size;
+} op_t;
+
+typedef struct trace_t {
+	const char *name;
+	int num_ids;
+	long num_ops;
+	op_t *ops;
+} trace_t;
+
+/* one allocator under test */
+typedef struct alloc_t {
+	const char *name;
+	void (*init)(void);
+	void *(*malloc)(size_t size);
+	void (*free)(void *p);
+	void *(*realloc)(void *p, size_t size);
+	size_t (*footprint)(void);
+} alloc_t;
+
+static int repeat = DEFAULT_REPEAT;
+static long interval = 0;
+static int print_samples = 0;
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void mm_alloc_init(void)
+{
+	mem_reset_brk();
+	if (mm_init() < 0) {
+		fprintf(stderr, "mm_init failed\n");
+		exit(1);
+	}
+}
+
+static size_t mm_footprint(void)
+{
+	mm_stats_t st;
+	mm_stats(&st);
+	return mem_heapsize() + st.mmap_bytes;
+}
+
+/* glibc keeps its heap between runs, footprint is what it holds right now */
+static void libc_init(void)
+{
+	malloc_trim(0);
+}
+
+static size_t libc_footprint(void)
+{
+	struct mallinfo2 mi = mallinfo2();
+	return mi.arena + mi.hblkhd;
+}
+
+static alloc_t allocs[] = {
+	{ "mm", mm_alloc_init, mm_malloc, mm_free, mm_realloc, mm_footprint },
+	{ "libc", libc_init, malloc, free, realloc, libc_footprint },
+};
+
+static int read_trace(const char *path, trace_t *t)
+{
+	FILE *fp = fopen(path, "r");
+	int heap, weight;
+	char type[2];
+	long i;
+
+	if (fp == NULL) {
+		perror(path);
+		return -1;
+	}
+	t->name = path;
+	if (fscanf(fp, "%d %d %ld %d", &heap, &t->num_ids, &t->num_ops, &weight) != 4 ||
+			t->num_ids < 0 || t->num_ops < 0) {
+		fprintf(stderr, "%s : bad header\n", path);
+		fclose(fp);
+		return -1;
+	}
+	t->ops = malloc(sizeof(op_t) * (t->num_ops ? t->num_ops : 1));
+	if (t->ops == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	for (i = 0; i < t->num_ops; i++) {
+		op_t *op = &t->ops[i];
+		if (fscanf(fp, "%1s %d", type, &op->id) != 2)
+			break;
+		op->type = type[0];
+		op->size = 0;
+		if ((op->type == 'a' || op->type == 'r') && fscanf(fp, "%zu", &op->size) != 1)
+			break;
+		if ((op->type != 'a' && op->type != 'r' && op->type != 'f') ||
+				op->id < 0 || op->id >= t->num_ids)
+			break;
+	}
+	fclose(fp);
+	if (i != t->num_ops) {
+		fprintf(stderr, "%s : bad op %ld\n", path, i);
+		free(t->ops);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Replay the ops once. With sample != 0 also track live bytes and sample
+ * the footprint every interval ops, otherwise only the ops are timed.
+ * Blocks the trace never frees are freed afterwards, outside the timing.
+ */
+static double replay(alloc_t *a, trace_t *t, void **blk, size_t *len, int sample,
+		size_t *peak_live, size_t *peak_fp)
+{
+	size_t live = 0, fp;
+	double sec;
+	long i;
+
+	memset(blk, 0, sizeof(void *) * t->num_ids);
+	memset(len, 0, sizeof(size_t) * t->num_ids);
+	a->init();
+
+	sec = now_sec();
+	for (i = 0; i < t->num_ops; i++) {
+		op_t *op = &t->ops[i];
+		void *p;
+
+		switch (op->type) {
+		case 'a':
+			p = a->malloc(op->size);
+			break;
+		case 'r':
+			p = a->realloc(blk[op->id], op->size);
+			break;
+		default:
+			if (blk[op->id]) a->free(blk[op->id]);
+			p = NULL;
+			break;
+		}
+		if (p == NULL && op->type != 'f' && op->size) {
+			fprintf(stderr, "%s/%s : out of memory at op %ld\n", a->name, t->name, i);
+			exit(1);
+		}
+		blk[op->id] = p;
+
+		if (!sample)
+			continue;
+		live = live - len[op->id] + (op->type == 'f' ? 0 : op->size);
+		len[op->id] = op->type == 'f' ? 0 : op->size;
+		if (live > *peak_live) *peak_live = live;
+		if (i % interval == 0 || i == t->num_ops - 1) {
+			fp = a->footprint();
+			if (fp > *peak_fp) *peak_fp = fp;
+			if (print_samples)
+				printf("sample,%s,%s,%ld,%zu,%zu,%.4f\n", t->name, a->name, i + 1,
+						live, fp, fp ? 1.0 - (double)live / fp : 0.0);
+		}
+	}
+	sec = now_sec() - sec;
+
+	for (i = 0; i < t->num_ids; i++)
+		if (blk[i]) a->free(blk[i]);
+	return sec;
+}
+
+static void print_classes(const char *name)
+{
+	mm_stats_t st;
+	int c;
+
+	mm_stats(&st);
+	for (c = 0; c < MM_CLASSES; c++) {
+		unsigned long r = st.req[c];
+		if (r == 0)
+			continue;
+		printf("class,%s,%d,%lu,%.4f,%lu,%lu,%lu\n", name, c, r,
+				(double)st.tcache_hit[c] / r, st.fit_own[c], st.fit_next[c], st.extend[c]);
+	}
+	printf("mmap,%s,%lu\n", name, st.mmap_req);
+}
+
+static void run(trace_t *t, int with_libc)
+{
+	void **blk = malloc(sizeof(void *) * (t->num_ids ? t->num_ids : 1));
+	size_t *len = malloc(sizeof(size_t) * (t->num_ids ? t->num_ids : 1));
+	int n = with_libc ? 2 : 1;
+
+	if (blk == NULL || len == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	interval = interval ? interval : (t->num_ops / DEFAULT_SAMPLES > 0 ? t->num_ops / DEFAULT_SAMPLES : 1);
+
+	for (int k = 0; k < n; k++) {
+		alloc_t *a = &allocs[k];
+		size_t peak_live = 0, peak_fp = 0;
+		double best = 0, sec;
+
+		for (int r = 0; r < repeat; r++) {
+			sec = replay(a, t, blk, len, 0, NULL, NULL);
+			if (r == 0 || sec < best) best = sec;
+		}
+		replay(a, t, blk, len, 1, &peak_live, &peak_fp);
+
+		printf("%s,%s,%ld,%.6f,%.0f,%zu,%zu,%.4f\n", t->name, a->name, t->num_ops, best,
+				best > 0 ? t->num_ops / best : 0.0, peak_live, peak_fp,
+				peak_fp ? (double)peak_live / peak_fp : 0.0);
+		/* the sampled replay ran last, its counters are still in mm */
+		if (k == 0)
+			print_classes(t->name);
+		fflush(stdout);
+	}
+
+	free(len);
+	free(blk);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+			"usage : %s [-r repeats] [-i interval] [-f] [-l] trace ...\n"
+			"  -r  timed replays per allocator (default %d)\n"
+			"  -i  ops between fragmentation samples (default ops / %d)\n"
+			"  -f  print every fragmentation sample\n"
+			"  -l  replay on glibc malloc as well\n",
+			name, DEFAULT_REPEAT, DEFAULT_SAMPLES);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, with_libc = 0;
+
+	while ((opt = getopt(argc, argv, "r:i:flh")) != -1) {
+		switch (opt) {
+		case 'r': repeat = atoi(optarg); break;
+		case 'i': interval = atol(optarg); break;
+		case 'f': print_samples = 1; break;
+		case 'l': with_libc = 1; break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+	if (optind == argc || repeat < 1 || interval < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	mem_init();
+	printf("trace,alloc,ops,sec,ops_per_sec,peak_live,peak_footprint,util\n");
+	printf("class,trace,class,requests,tcache_hit_rate,fit_own,fit_next,extend\n");
+	if (print_samples)
+		printf("sample,trace,alloc,op,live,footprint,frag\n");
+
+	for (int i = optind; i < argc; i++) {
+		trace_t t;
+		long saved = interval;
+		if (read_trace(argv[i], &t) < 0)
+			return 1;
+		run(&t, with_libc);
+		interval = saved;
+		free(t.ops);
+	}
+	return 0;
+}
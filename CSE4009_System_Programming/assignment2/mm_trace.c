@@ -0,0 +1,366 @@
+/*
+ * mm_trace.c - LD_PRELOAD shim that records a program's malloc calls as a
+ *              CS:APP trace for mm_bench
+ *
+ * build : gcc -O2 -shared -fPIC -o mm_trace.so mm_trace.c -ldl -lpthread
+ * usage : MM_TRACE=out.rep LD_PRELOAD=./mm_trace.so ./program
+ *
+ * malloc/calloc/realloc/free are forwarded to the next definition and
+ * logged as a/r/f ops. Every live pointer gets an id; the id of a freed
+ * pointer is reused, so the number of ids is the peak number of live
+ * blocks. The header is written when the program exits normally, a
+ * killed program leaves a trace without a header. memalign and friends
+ * are not recorded, frees of their blocks are skipped as unknown.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define HEADER_LEN 64	/* room for the header, filled in at exit */
+#define BUF_LEN (1 << 16)
+#define BOOT_LEN (1 << 14)	/* allocations made by dlsym before the real functions are known */
+
+static void *(*real_malloc)(size_t);
+static void *(*real_calloc)(size_t, size_t);
+static void *(*real_realloc)(void *, size_t);
+static void (*real_free)(void *);
+
+static pthread_mutex_t TraceLock = PTHREAD_MUTEX_INITIALIZER;
+static int TraceFd = -1;
+static int TraceDone = 0;
+/* set while the shim itself runs, initial-exec so reading it never allocates */
+static __thread int InHook __attribute__((tls_model("initial-exec"))) = 0;
+
+static char Boot[BOOT_LEN];
+static size_t BootUsed = 0;
+
+static char Buf[BUF_LEN];
+static size_t BufUsed = 0;
+
+/* pointer -> id and size, linear probing with backward shift deletion */
+typedef struct slot_t {
+	void *p;
+	size_t size;
+	int id;
+} slot_t;
+
+static slot_t *Map = NULL;
+static size_t MapCap = 0;
+static size_t MapUsed = 0;
+
+static int *FreeIds = NULL;	/* stack of ids to reuse */
+static size_t FreeIdsCap = 0;
+static size_t FreeIdsUsed = 0;
+
+static int NumIds = 0;
+static long NumOps = 0;
+static size_t Live = 0, PeakLive = 0;
+
+static size_t hash_ptr(void *p)
+{
+	uintptr_t x = (uintptr_t)p >> 3;
+	return (x * 0x9E3779B97F4A7C15ULL) >> 17;
+}
+
+/* anonymous mappings only, the traced malloc must not call into itself */
+static void *raw_alloc(size_t len)
+{
+	void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+static void map_put(void *p, size_t size, int id)
+{
+	size_t i = hash_ptr(p) & (MapCap - 1);
+
+	while (Map[i].p)
+		i = (i + 1) & (MapCap - 1);
+	Map[i].p = p;
+	Map[i].size = size;
+	Map[i].id = id;
+	MapUsed++;
+}
+
+static int map_grow(void)
+{
+	slot_t *old = Map;
+	size_t old_cap = MapCap;
+	size_t i;
+
+	MapCap = MapCap ? MapCap * 2 : 1 << 16;
+	if ((Map = raw_alloc(MapCap * sizeof(slot_t))) == NULL) {
+		Map = old;
+		MapCap = old_cap;
+		return -1;
+	}
+	MapUsed = 0;
+	for (i = 0; i < old_cap; i++)
+		if (old[i].p) map_put(old[i].p, old[i].size, old[i].id);
+	if (old)
+		munmap(old, old_cap * sizeof(slot_t));
+	return 0;
+}
+
+/* remove p, its id or -1 if p was never recorded */
+static int map_take(void *p, size_t *size)
+{
+	size_t i, j, h;
+	int id;
+
+	if (MapCap == 0)
+		return -1;
+	for (i = hash_ptr(p) & (MapCap - 1); Map[i].p != p; i = (i + 1) & (MapCap - 1))
+		if (Map[i].p == NULL)
+			return -1;
+	id = Map[i].id;
+	*size = Map[i].size;
+
+	/* pull later entries of the run back into the hole */
+	for (j = (i + 1) & (MapCap - 1); Map[j].p; j = (j + 1) & (MapCap - 1)) {
+		h = hash_ptr(Map[j].p) & (MapCap - 1);
+		if (((j - h) & (MapCap - 1)) >= ((j - i) & (MapCap - 1))) {
+			Map[i] = Map[j];
+			i = j;
+		}
+	}
+	Map[i].p = NULL;
+	MapUsed--;
+	return id;
+}
+
+static void put_id(int id)
+{
+	int *old = FreeIds;
+
+	if (FreeIdsUsed == FreeIdsCap) {
+		FreeIdsCap = FreeIdsCap ? FreeIdsCap * 2 : 1 << 14;
+		if ((FreeIds = raw_alloc(FreeIdsCap * sizeof(int))) == NULL)
+			abort();
+		if (old) {
+			memcpy(FreeIds, old, FreeIdsUsed * sizeof(int));
+			munmap(old, FreeIdsUsed * sizeof(int));
+		}
+	}
+	FreeIds[FreeIdsUsed++] = id;
+}
+
+static int get_id(void)
+{
+	return FreeIdsUsed ? FreeIds[--FreeIdsUsed] : NumIds++;
+}
+
+static void flush_buf(void)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while (off < BufUsed) {
+		if ((n = write(TraceFd, Buf + off, BufUsed - off)) <= 0)
+			break;
+		off += n;
+	}
+	BufUsed = 0;
+}
+
+static void emit(char type, int id, size_t size)
+{
+	if (BUF_LEN - BufUsed < 64)
+		flush_buf();
+	if (type == 'f')
+		BufUsed += snprintf(Buf + BufUsed, BUF_LEN - BufUsed, "f %d\n", id);
+	else
+		BufUsed += snprintf(Buf + BufUsed, BUF_LEN - BufUsed, "%c %d %zu\n", type, id, size);
+	NumOps++;
+}
+
+static void add_live(size_t add, size_t sub)
+{
+	Live = Live + add - sub;
+	if (Live > PeakLive) PeakLive = Live;
+}
+
+/* give the new live block p an id */
+static void record_alloc(void *p, size_t size)
+{
+	int id;
+
+	if (MapUsed * 2 >= MapCap && map_grow() < 0)
+		return;
+	id = get_id();
+	map_put(p, size, id);
+	emit('a', id, size);
+	add_live(size, 0);
+}
+
+static void record_free(void *p)
+{
+	size_t size;
+	int id = map_take(p, &size);
+
+	if (id < 0)
+		return;
+	emit('f', id, 0);
+	put_id(id);
+	add_live(0, size);
+}
+
+/* realloc moves the block under the same id */
+static void record_realloc(void *old, void *p, size_t size)
+{
+	size_t old_size;
+	int id = map_take(old, &old_size);
+
+	if (id < 0) {
+		record_alloc(p, size);
+		return;
+	}
+	map_put(p, size, id);
+	emit('r', id, size);
+	add_live(size, old_size);
+}
+
+/* dlsym may allocate before the real functions are known */
+static void *boot_alloc(size_t len)
+{
+	void *p;
+
+	len = (len + 15) & ~(size_t)15;
+	if (BootUsed + len > BOOT_LEN)
+		return NULL;
+	p = Boot + BootUsed;
+	BootUsed += len;
+	return p;
+}
+
+static void trace_init(void)
+{
+	const char *path;
+
+	InHook = 1;
+	real_malloc = dlsym(RTLD_NEXT, "malloc");
+	real_calloc = dlsym(RTLD_NEXT, "calloc");
+	real_realloc = dlsym(RTLD_NEXT, "realloc");
+	real_free = dlsym(RTLD_NEXT, "free");
+	if ((path = getenv("MM_TRACE")) != NULL) {
+		TraceFd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (TraceFd >= 0) {
+			memset(Buf, ' ', HEADER_LEN);
+			Buf[HEADER_LEN - 1] = '\n';
+			BufUsed = HEADER_LEN;
+		}
+	}
+	InHook = 0;
+}
+
+/* 1 if this call is to be recorded, the real functions are known after it unless InHook */
+static int tracing(void)
+{
+	if (InHook)
+		return 0;
+	if (real_free == NULL) {
+		pthread_mutex_lock(&TraceLock);
+		if (real_free == NULL)
+			trace_init();
+		pthread_mutex_unlock(&TraceLock);
+	}
+	return TraceFd >= 0 && !TraceDone;
+}
+
+__attribute__((destructor))
+static void trace_fini(void)
+{
+	char head[HEADER_LEN];
+	int n;
+
+	pthread_mutex_lock(&TraceLock);
+	if (TraceFd >= 0 && !TraceDone) {
+		TraceDone = 1;
+		flush_buf();
+		/* mdriver reads the header with %d, the padding is whitespace */
+		n = snprintf(head, sizeof(head), "%zu\n%d\n%ld\n1", PeakLive, NumIds, NumOps);
+		memset(head + n, ' ', HEADER_LEN - n - 1);
+		head[HEADER_LEN - 1] = '\n';
+		if (pwrite(TraceFd, head, HEADER_LEN, 0) != HEADER_LEN)
+			perror("mm_trace");
+		close(TraceFd);
+	}
+	pthread_mutex_unlock(&TraceLock);
+}
+
+void *malloc(size_t size)
+{
+	void *p;
+
+	if (!tracing())
+		return real_malloc ? real_malloc(size) : boot_alloc(size);
+	pthread_mutex_lock(&TraceLock);
+	InHook = 1;
+	if ((p = real_malloc(size)) != NULL)
+		record_alloc(p, size);
+	InHook = 0;
+	pthread_mutex_unlock(&TraceLock);
+	return p;
+}
+
+void *calloc(size_t n, size_t size)
+{
+	void *p;
+
+	/* the boot buffer starts out zeroed */
+	if (!tracing())
+		return real_calloc ? real_calloc(n, size) : boot_alloc(n * size);
+	pthread_mutex_lock(&TraceLock);
+	InHook = 1;
+	if ((p = real_calloc(n, size)) != NULL)
+		record_alloc(p, n * size);
+	InHook = 0;
+	pthread_mutex_unlock(&TraceLock);
+	return p;
+}
+
+void *realloc(void *old, size_t size)
+{
+	void *p;
+
+	if (!tracing())
+		return real_realloc ? real_realloc(old, size) : NULL;
+	pthread_mutex_lock(&TraceLock);
+	InHook = 1;
+	if (old == NULL) {
+		if ((p = real_realloc(NULL, size)) != NULL)
+			record_alloc(p, size);
+	}
+	else if (size == 0) {
+		record_free(old);
+		p = real_realloc(old, 0);
+	}
+	else if ((p = real_realloc(old, size)) != NULL)
+		record_realloc(old, p, size);
+	InHook = 0;
+	pthread_mutex_unlock(&TraceLock);
+	return p;
+}
+
+void free(void *p)
+{
+	if (p == NULL || ((char *)p >= Boot && (char *)p < Boot + BOOT_LEN))
+		return;
+	if (!tracing()) {
+		if (real_free)
+			real_free(p);
+		return;
+	}
+	pthread_mutex_lock(&TraceLock);
+	InHook = 1;
+	record_free(p);
+	real_free(p);
+	InHook = 0;
+	pthread_mutex_unlock(&TraceLock);
+}
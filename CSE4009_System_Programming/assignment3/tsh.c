@@ -4,6 +4,7 @@
  * <Put your name and ID here>
  */
 //- Ʈ 
+#define _GNU_SOURCE         /* splice */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -13,12 +14,22 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
  /* Misc manifest constants */
 #define MAXLINE    1024   /* max line size */
 #define MAXARGS     128   /* max args on a command line */
-#define MAXJOBS      16   /* max jobs at any point in time */
-#define MAXJID    1<<16   /* max job ID */
+#define MAXJOBS      16   /* initial job list size, it grows as needed */
+#define MAXJID  (1<<16)   /* max job ID */
+#define MAXPIPE      16   /* max commands in one pipeline */
+#define HASHSIZE     64   /* buckets of the command hash table */
+#define DEFPATH "/bin:/usr/bin" /* searched when PATH is unset, as execvp does */
 
 /* Job states */
 #define UNDEF 0 /* undefined */
@@ -40,6 +51,9 @@
 extern char **environ;      /* defined in libc */
 char prompt[] = "tsh> ";    /* command line prompt (DO NOT CHANGE) */
 int verbose = 0;            /* if true, print additional output */
+int batch = 0;              /* jobs run at once in batch mode (-j), 0 if interactive */
+int batch_done = 0;         /* batch jobs finished */
+int batch_failed = 0;       /* batch jobs that exited nonzero or were killed */
 int nextjid = 1;            /* next job ID to allocate */
 char sbuf[MAXLINE];         /* for composing sprintf messages */
 
@@ -48,8 +62,41 @@ struct job_t {              /* The job struct */
 	int jid;                /* job ID [1, 2, ...] */
 	int state;              /* UNDEF, BG, FG, or ST */
 	char cmdline[MAXLINE];  /* command line */
+	pid_t pids[MAXPIPE];    /* every process of the pipeline, pids[0] == pid */
+	int nstage;             /* processes started, the last one's status is the job's */
+	int nproc;              /* processes not reaped yet */
+	int status;             /* wait status of the last command */
+	struct timespec start;  /* when the job was added */
+	double wall;            /* seconds from start to the last reap */
+	struct timeval utime;   /* user CPU time of the processes reaped so far */
+	struct timeval stime;   /* system CPU time of the same */
+	long maxrss;            /* largest max RSS among them, KB */
 };
-struct job_t jobs[MAXJOBS]; /* The job list */
+struct job_t *jobs;         /* The job list, maxjobs slots */
+int maxjobs;                /* slots in jobs, doubled when full */
+int *freeslots;             /* unused slots of jobs, a stack */
+int nfree;                  /* entries in freeslots */
+struct job_t *fgjob;        /* the FG job, NULL if none */
+int jidmap[MAXJID + 1];     /* jid -> slot + 1, 0 if unused */
+
+struct pidslot {            /* every process of every job -> its job's slot */
+	pid_t pid;              /* 0 if empty */
+	int slot;
+};
+struct pidslot *pidmap;     /* open addressing, linear probing */
+int pidcap;                 /* power of two, kept at least twice npids */
+int npids;
+
+struct job_t fgdone;        /* copy of the last FG job to finish, for time */
+
+struct cmdhash {            /* command name -> full path found in PATH */
+	char *name;
+	char *path;
+	int hits;               /* times the path was used, shown by hash */
+	struct cmdhash *next;
+};
+struct cmdhash *cmdtab[HASHSIZE]; /* chained by name hash */
+char *cmdtab_path;          /* PATH the entries were found in, NULL if none */
 /* End global variables */
 
 
@@ -60,6 +107,16 @@ void eval(char *cmdline);
 int builtin_cmd(char **argv);
 void do_bgfg(char **argv);
 void waitfg(pid_t pid);
+void runbatch(FILE *fp);
+void reportjob(struct job_t *job);
+void do_time(char *cmdline);
+void printusage(struct job_t *job, double wall);
+int spawn_pipeline(char **argv, sigset_t *mask, pid_t *pids);
+pid_t spawn_job(char **argv, int in, int out, pid_t pgid, sigset_t *mask);
+pid_t spawn_cat(char **argv, int in, int out, pid_t pgid, sigset_t *mask);
+char *findcmd(char *name);
+void do_hash(char **argv);
+void do_export(char **argv);
 
 void sigchld_handler(int sig);
 void sigtstp_handler(int sig);
@@ -70,15 +127,19 @@ int parseline(const char *cmdline, char **argv);
 void sigquit_handler(int sig);
 
 void clearjob(struct job_t *job);
-void initjobs(struct job_t *jobs);
-int maxjid(struct job_t *jobs);
-int addjob(struct job_t *jobs, pid_t pid, int state, char *cmdline);
-int deletejob(struct job_t *jobs, pid_t pid);
-pid_t fgpid(struct job_t *jobs);
-struct job_t *getjobpid(struct job_t *jobs, pid_t pid);
-struct job_t *getjobjid(struct job_t *jobs, int jid);
+void initjobs(void);
+int maxjid(void);
+int addjob(pid_t pid, int state, char *cmdline);
+void setjobpids(struct job_t *job, pid_t *pids, int n);
+void setjobstate(struct job_t *job, int state);
+void dropjobpid(struct job_t *job, pid_t pid);
+int deletejob(pid_t pid);
+pid_t fgpid(void);
+struct job_t *getjobpid(pid_t pid);
+struct job_t *getjobjid(int jid);
+struct job_t *getjobmember(pid_t pid);
 int pid2jid(pid_t pid);
-void listjobs(struct job_t *jobs);
+void listjobs(int usage);
 
 void usage(void);
 void unix_error(char *msg);
@@ -100,7 +161,7 @@ int main(int argc, char **argv)
 	dup2(1, 2);
 
 	/* Parse the command line */
-	while ((c = getopt(argc, argv, "hvp")) != EOF) {
+	while ((c = getopt(argc, argv, "hvpj:")) != EOF) {
 		switch (c) {
 		case 'h':             /* print help message */
 			usage();
@@ -111,6 +172,10 @@ int main(int argc, char **argv)
 		case 'p':             /* don't print a prompt */
 			emit_prompt = 0;  /* handy for automatic testing */
 			break;
+		case 'j':             /* run a script's lines as parallel jobs */
+			if ((batch = atoi(optarg)) < 1)
+				usage();
+			break;
 		default:
 			usage();
 		}
@@ -127,7 +192,16 @@ int main(int argc, char **argv)
 	Signal(SIGQUIT, sigquit_handler);
 
 	/* Initialize the job list */
-	initjobs(jobs);
+	initjobs();
+
+	/* Batch mode runs the script (stdin if none) and exits */
+	if (batch) {
+		FILE *fp = stdin;
+		if (optind < argc && (fp = fopen(argv[optind], "r")) == NULL)
+			unix_error("batch script");
+		runbatch(fp);
+		exit(batch_failed ? 1 : 0);
+	}
 
 	/* Execute the shell's read/eval loop */
 	while (1) {
@@ -185,8 +259,11 @@ void eval(char *cmdline) //TODO
 
 	
 	char *cmdArr[MAXARGS];
-	int bg,b_ch,e_ch;
+	int bg,b_ch,n;
 	pid_t pid;
+	pid_t pids[MAXPIPE];
+	struct job_t *jobp;
+	sigset_t mask, prev;
 
 	// ޾ƾƼ 迭ȿ ϳ 
 	bg = parseline(cmdline, cmdArr);
@@ -194,52 +271,425 @@ void eval(char *cmdline) //TODO
 	//  
 	if (cmdArr[0] == NULL)	return;
 
+	//time  ״   ڿ 뷮 ´
+	if (!strcmp(cmdArr[0], "time")) {
+		do_time(cmdline);
+		return;
+	}
+
 	//builtin ɾ  
 	b_ch = builtin_cmd(cmdArr);
 
 	//buitinɾ ƴϾٸ
 	if (!b_ch) {
-		//fork 
-		if ((pid = fork()) < 0) {
-			exit(1);
+		//addjob  ڽ reap ʰ SIGCHLD Ƶд
+		sigemptyset(&mask);
+		sigaddset(&mask, SIGCHLD);
+		sigprocmask(SIG_BLOCK, &mask, &prev);
+
+		//   , ϳ   ( ,   ) job 
+		if ((n = spawn_pipeline(cmdArr, &prev, pids)) == 0) {
+			sigprocmask(SIG_SETMASK, &prev, NULL);
 		}
 
 		// θ μ 
-		else if(pid>0) {
+		else {
+			//job ù μ(process group id) ã,  μ  
+			pid = pids[0];
+			addjob(pid, bg ? BG : FG, cmdline);
+			if ((jobp = getjobpid(pid)) != NULL)
+				setjobpids(jobp, pids, n);
+
 			//background۾ ƴѰ addjob  wait
 			if (!bg) {
-				addjob(jobs, pid, FG, cmdline);
 				waitfg(pid);
 			}
 
 			//background϶ addjob
 			else {
-				addjob(jobs, pid, BG, cmdline);
 				printf("[%d] (%d) %s", pid2jid(pid), pid, cmdline);
 			}
+			sigprocmask(SIG_SETMASK, &prev, NULL);
 		}
+	}
+	return;
+}
 
-		//ڽμ 
-		else if (pid == 0) {
-			//ڽ pid  ׷ id׷쿡 
-			if (setpgid(0, 0) < 0) {
-				exit(1);
-			}
-			//డ  filename ڵ带  μ Ͽ 
-			// ڵ üϿ ο  մϴ.  
-			//,  Ǵ α׷   filename α׷ 
-			//޸𸮿 loadingϿ ó մϴ
-			e_ch = execve(cmdArr[0], cmdArr, environ);
-
-			if (e_ch < 0) {
-				printf("%s: Command not found\n", cmdArr[0]);
-				exit(1);
+/*
+ * spawn_pipeline - Start every command of "cmd [< in] | cmd | ... [> out]"
+ *     with its signal mask set to *mask. The first process leads a new
+ *     process group that the others join. Redirections (<, >, >>) and
+ *     | must be separate words; a redirection overrides the pipe on that
+ *     side. Return the number of processes started, their pids in pids.
+ */
+int spawn_pipeline(char **argv, sigset_t *mask, pid_t *pids)
+{
+	char **stage[MAXPIPE];
+	char *in_path[MAXPIPE], *out_path[MAXPIPE];
+	int append[MAXPIPE];
+	int nstage = 1, n = 0, i, j = 0, k;
+	int in, out, fd[2], next_in = -1;
+	pid_t pid, pgid = 0;
+
+	//'|'   ̷ ܾ   д (ܾ   )
+	stage[0] = argv;
+	in_path[0] = out_path[0] = NULL;
+	append[0] = 0;
+	for (i = 0; argv[i] != NULL; i++) {
+		if (!strcmp(argv[i], "|")) {
+			if (stage[nstage - 1] == &argv[j] || nstage == MAXPIPE)
+				goto syntax;
+			argv[j++] = NULL;
+			stage[nstage] = &argv[j];
+			in_path[nstage] = out_path[nstage] = NULL;
+			append[nstage++] = 0;
+		}
+		else if (!strcmp(argv[i], "<") || !strcmp(argv[i], ">") || !strcmp(argv[i], ">>")) {
+			if (argv[i + 1] == NULL || strchr("<>|", argv[i + 1][0]))
+				goto syntax;
+			if (argv[i][0] == '<')
+				in_path[nstage - 1] = argv[i + 1];
+			else {
+				out_path[nstage - 1] = argv[i + 1];
+				append[nstage - 1] = argv[i][1] == '>';
 			}
+			i++;
+		}
+		else
+			argv[j++] = argv[i];
+	}
+	argv[j] = NULL;
+	if (stage[nstage - 1][0] == NULL)
+		goto syntax;
+
+	for (k = 0; k < nstage; k++) {
+		// close-on-exec  dup2 ڸ  ڽĿ  ʰ
+		in = next_in;
+		out = next_in = -1;
+		if (k < nstage - 1) {
+			if (pipe2(fd, O_CLOEXEC) < 0)
+				unix_error("pipe error");
+			out = fd[1];
+			next_in = fd[0];
+		}
+		if (in_path[k] != NULL) {
+			if (in >= 0)
+				close(in);
+			if ((in = open(in_path[k], O_RDONLY | O_CLOEXEC)) < 0)
+				printf("%s: %s\n", in_path[k], strerror(errno));
+		}
+		if (out_path[k] != NULL) {
+			if (out >= 0)
+				close(out);
+			if ((out = open(out_path[k], O_WRONLY | O_CREAT | O_CLOEXEC |
+					(append[k] ? O_APPEND : O_TRUNC), 0666)) < 0)
+				printf("%s: %s\n", out_path[k], strerror(errno));
 		}
 
-		
+		//̷     ɸ ǳʶڴ (յ   EOF/SIGPIPE ȴ)
+		if ((in_path[k] && in < 0) || (out_path[k] && out < 0))
+			pid = 0;
+		else if ((pid = spawn_cat(stage[k], in, out, pgid, mask)) == 0)
+			pid = spawn_job(stage[k], in, out, pgid, mask);
+		if (pid < 0)
+			printf("%s: Command not found\n", stage[k][0]);
+		else if (pid > 0) {
+			if (pgid == 0)
+				pgid = pid;
+			pids[n++] = pid;
+		}
+		if (in >= 0)
+			close(in);
+		if (out >= 0)
+			close(out);
 	}
-	return;
+	return n;
+
+syntax:
+	printf("tsh: syntax error\n");
+	return 0;
+}
+
+/* cmdhash_index - Bucket of name in cmdtab */
+static unsigned cmdhash_index(const char *name)
+{
+	unsigned h = 5381;
+
+	while (*name)
+		h = h * 33 + (unsigned char)*name++;
+	return h % HASHSIZE;
+}
+
+/* cmdhash_clear - Forget every remembered path */
+static void cmdhash_clear(void)
+{
+	struct cmdhash *e;
+	int i;
+
+	for (i = 0; i < HASHSIZE; i++)
+		while ((e = cmdtab[i]) != NULL) {
+			cmdtab[i] = e->next;
+			free(e->name);
+			free(e->path);
+			free(e);
+		}
+	free(cmdtab_path);
+	cmdtab_path = NULL;
+}
+
+/* cmdhash_drop - Forget the path of name, if any */
+static void cmdhash_drop(const char *name)
+{
+	struct cmdhash **pp, *e;
+
+	for (pp = &cmdtab[cmdhash_index(name)]; (e = *pp) != NULL; pp = &e->next)
+		if (!strcmp(e->name, name)) {
+			*pp = e->next;
+			free(e->name);
+			free(e->path);
+			free(e);
+			return;
+		}
+}
+
+/*
+ * searchpath - First executable regular file called name in the
+ *     directories of path (an empty entry is the current directory).
+ *     Return it in a malloc'd string, or NULL if there is none.
+ */
+static char *searchpath(const char *name, const char *path)
+{
+	char buf[MAXLINE];
+	struct stat st;
+	const char *dir = path, *end;
+	int len;
+
+	for (;;) {
+		end = strchr(dir, ':');
+		len = end ? end - dir : (int)strlen(dir);
+		if (len == 0)
+			snprintf(buf, sizeof(buf), "%s", name);
+		else
+			snprintf(buf, sizeof(buf), "%.*s/%s", len, dir, name);
+		if (stat(buf, &st) == 0 && S_ISREG(st.st_mode) && access(buf, X_OK) == 0)
+			return strdup(buf);
+		if (end == NULL)
+			return NULL;
+		dir = end + 1;
+	}
+}
+
+/*
+ * findcmd - Path to exec for the command name. A name with a '/' is
+ *     used as is. Other names are searched in PATH once and remembered
+ *     in cmdtab, so a script does not stat every PATH directory for each
+ *     of its commands. Everything is forgotten when PATH changes or on
+ *     hash -r, and spawn_job drops a path that exec no longer finds.
+ *     Return NULL if no PATH directory has the command.
+ */
+char *findcmd(char *name)
+{
+	char *path = getenv("PATH");
+	struct cmdhash *e;
+	unsigned h;
+	char *full;
+
+	if (strchr(name, '/') != NULL)
+		return name;
+	if (path == NULL)
+		path = DEFPATH;
+	if (cmdtab_path == NULL || strcmp(cmdtab_path, path) != 0) {
+		cmdhash_clear();
+		if ((cmdtab_path = strdup(path)) == NULL)
+			return NULL;
+	}
+
+	h = cmdhash_index(name);
+	for (e = cmdtab[h]; e != NULL; e = e->next)
+		if (!strcmp(e->name, name)) {
+			e->hits++;
+			return e->path;
+		}
+	if ((full = searchpath(name, path)) == NULL)
+		return NULL;
+	if ((e = malloc(sizeof(struct cmdhash))) == NULL || (e->name = strdup(name)) == NULL) {
+		free(e);
+		free(full);
+		return NULL;
+	}
+	e->path = full;
+	e->hits = 1;
+	e->next = cmdtab[h];
+	cmdtab[h] = e;
+	return e->path;
+}
+
+/*
+ * do_hash - Execute the builtin hash: list the remembered commands,
+ *     forget them all (hash -r), or look up the named ones now.
+ */
+void do_hash(char **argv)
+{
+	struct cmdhash *e;
+	int i, n = 0;
+
+	if (argv[1] != NULL && !strcmp(argv[1], "-r")) {
+		cmdhash_clear();
+		return;
+	}
+	if (argv[1] != NULL) {
+		for (i = 1; argv[i] != NULL; i++)
+			if (strchr(argv[i], '/') == NULL && findcmd(argv[i]) == NULL)
+				printf("hash: %s: not found\n", argv[i]);
+		return;
+	}
+
+	for (i = 0; i < HASHSIZE; i++)
+		for (e = cmdtab[i]; e != NULL; e = e->next) {
+			if (n++ == 0)
+				printf("hits\tcommand\n");
+			printf("%4d\t%s\n", e->hits, e->path);
+		}
+	if (n == 0)
+		printf("hash: hash table empty\n");
+}
+
+/*
+ * do_export - Execute the builtin export: set each NAME=value in the
+ *     environment the jobs get.
+ */
+void do_export(char **argv)
+{
+	char *eq;
+	int i;
+
+	for (i = 1; argv[i] != NULL; i++) {
+		if ((eq = strchr(argv[i], '=')) == NULL || eq == argv[i]) {
+			printf("export: %s: not NAME=value\n", argv[i]);
+			continue;
+		}
+		*eq = '\0';
+		if (setenv(argv[i], eq + 1, 1) < 0)
+			printf("export: %s: %s\n", argv[i], strerror(errno));
+		*eq = '=';
+	}
+}
+
+/*
+ * spawn_job - Run argv[0] with stdin/stdout from in/out (-1 keeps the
+ *     shell's) in process group pgid (0 makes a new one with its pid as
+ *     the id) and signal mask *mask. posix_spawn lets the child share the
+ *     shell's memory until it execs (like vfork), so a large shell does
+ *     not pay for copying its page tables. A name without a '/' is run
+ *     from PATH (findcmd). Return the pid, or -1 if the program could
+ *     not be executed.
+ */
+pid_t spawn_job(char **argv, int in, int out, pid_t pgid, sigset_t *mask)
+{
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t attr;
+	pid_t pid;
+	char *path;
+	int err;
+
+	if ((path = findcmd(argv[0])) == NULL)
+		return -1;
+	if (posix_spawnattr_init(&attr) != 0 || posix_spawn_file_actions_init(&fa) != 0)
+		unix_error("posix_spawn init error");
+	//setpgid(0, pgid) , ڽ Ƶ SIGCHLD   mask 
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+	posix_spawnattr_setpgroup(&attr, pgid);
+	posix_spawnattr_setsigmask(&attr, mask);
+	if (in >= 0)
+		posix_spawn_file_actions_adddup2(&fa, in, STDIN_FILENO);
+	if (out >= 0)
+		posix_spawn_file_actions_adddup2(&fa, out, STDOUT_FILENO);
+
+	//exec е ⼭ ޴´, argv[0] Է ̸ ״ ѱ
+	err = posix_spawn(&pid, path, &fa, &attr, argv, environ);
+	//ص  ų Ű PATH ٽ ã ѹ 
+	if (err == ENOENT && path != argv[0]) {
+		cmdhash_drop(argv[0]);
+		if ((path = findcmd(argv[0])) != NULL)
+			err = posix_spawn(&pid, path, &fa, &attr, argv, environ);
+	}
+	posix_spawn_file_actions_destroy(&fa);
+	posix_spawnattr_destroy(&attr);
+	if (err != 0)
+		return -1;
+	return pid;
+}
+
+/*
+ * spawn_cat - Fast path for "cat file ...": a forked child of the shell
+ *     moves each file to its stdout with splice (stdout is a pipe) or
+ *     sendfile, so the data never passes through user space and no cat
+ *     is exec'd. Return the pid, or 0 if argv is not such a cat (options,
+ *     no files), in which case the real cat runs.
+ */
+pid_t spawn_cat(char **argv, int in, int out, pid_t pgid, sigset_t *mask)
+{
+	char *name = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+	struct stat st;
+	char buf[MAXLINE];
+	int i, fd, status = 0, to_pipe;
+	ssize_t nr;
+	pid_t pid;
+
+	if (strcmp(name, "cat") != 0 || argv[1] == NULL)
+		return 0;
+	for (i = 1; argv[i] != NULL; i++)
+		if (argv[i][0] == '-')
+			return 0;
+
+	if ((pid = fork()) < 0)
+		unix_error("fork error");
+	if (pid > 0) {
+		//ڽ setpgid ϱ     ׷쿡    Ƿ θ Ѵ
+		setpgid(pid, pgid ? pgid : pid);
+		return pid;
+	}
+
+	//exec Ƿ  ڵ鷯  ǵ
+	setpgid(0, pgid);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTSTP, SIG_DFL);
+	signal(SIGCHLD, SIG_DFL);
+	signal(SIGQUIT, SIG_DFL);
+	sigprocmask(SIG_SETMASK, mask, NULL);
+	if (in >= 0)
+		dup2(in, STDIN_FILENO);
+	if (out >= 0)
+		dup2(out, STDOUT_FILENO);
+	to_pipe = fstat(STDOUT_FILENO, &st) == 0 && S_ISFIFO(st.st_mode);
+
+	for (i = 1; argv[i] != NULL; i++) {
+		if ((fd = open(argv[i], O_RDONLY)) < 0) {
+			fprintf(stderr, "cat: %s: %s\n", argv[i], strerror(errno));
+			status = 1;
+			continue;
+		}
+		do {
+			if (to_pipe)
+				nr = splice(fd, NULL, STDOUT_FILENO, NULL, 1 << 16, SPLICE_F_MOVE);
+			else
+				nr = sendfile(STDOUT_FILENO, fd, NULL, 1 << 20);
+		} while (nr > 0);
+		//splice/sendfile    (tty )̸  ׳ Ѵ
+		if (nr < 0 && (errno == EINVAL || errno == ENOSYS)) {
+			while ((nr = read(fd, buf, sizeof(buf))) > 0)
+				if (write(STDOUT_FILENO, buf, nr) != nr) {
+					nr = -1;
+					break;
+				}
+		}
+		if (nr < 0) {
+			fprintf(stderr, "cat: %s: %s\n", argv[i], strerror(errno));
+			status = 1;
+		}
+		close(fd);
+	}
+	_exit(status);
 }
 
 /*
@@ -308,8 +758,9 @@ int builtin_cmd(char **argv) //TODO
 	//ɾ  ش ۾ 
 
 	//background ۾ 
+	//jobs -v ݱ reap μ 뷮 
 	if (!strcmp(argv[0], "jobs")) {
-		listjobs(jobs);
+		listjobs(argv[1] != NULL && !strcmp(argv[1], "-v"));
 		return 1;
 	}
 
@@ -330,6 +781,18 @@ int builtin_cmd(char **argv) //TODO
 		return 1;
 	}
 
+	//PATH ãƵ   (bash hash)
+	else if (!strcmp(argv[0], "hash")) {
+		do_hash(argv);
+		return 1;
+	}
+
+	//ȯ  , PATH ٲ  ɺ ٽ ã´
+	else if (!strcmp(argv[0], "export")) {
+		do_export(argv);
+		return 1;
+	}
+
 	
 	//
 	return 0;
@@ -352,14 +815,14 @@ void do_bgfg(char **argv)
 	/* Parse the required PID or %JID arg */
 	if (isdigit(argv[1][0])) {
 		pid_t pid = atoi(argv[1]);
-		if (!(jobp = getjobpid(jobs, pid))) {
+		if (!(jobp = getjobpid(pid))) {
 			printf("(%d): No such process\n", pid);
 			return;
 		}
 	}
 	else if (argv[1][0] == '%') {
 		int jid = atoi(&argv[1][1]);
-		if (!(jobp = getjobjid(jobs, jid))) {
+		if (!(jobp = getjobjid(jid))) {
 			printf("%s: No such job\n", argv[1]);
 			return;
 		}
@@ -373,7 +836,7 @@ void do_bgfg(char **argv)
 	if (!strcmp(argv[0], "bg")) {
 		if (kill(-(jobp->pid), SIGCONT) < 0)
 			unix_error("kill (bg) error");
-		jobp->state = BG;
+		setjobstate(jobp, BG);
 		printf("[%d] (%d) %s", jobp->jid, jobp->pid, jobp->cmdline);
 	}
 
@@ -381,7 +844,7 @@ void do_bgfg(char **argv)
 	else if (!strcmp(argv[0], "fg")) {
 		if (kill(-(jobp->pid), SIGCONT) < 0)
 			unix_error("kill (fg) error");
-		jobp->state = FG;
+		setjobstate(jobp, FG);
 		waitfg(jobp->pid);
 	}
 	else {
@@ -398,14 +861,123 @@ void do_bgfg(char **argv)
  */
 void waitfg(pid_t pid) //TODO
 {
+	sigset_t mask, prev, wait_mask;
+
+	//fgpid     SIGCHLD  ġǷ, Ƶΰ sigsuspend Ǯ鼭 
+	//evaló ̹ Ƶ · ҷ ǰ ٸ ȸ SIGCHLD  mask 
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &mask, &prev);
+	wait_mask = prev;
+	sigdelset(&wait_mask, SIGCHLD);
+
 	//foreground ÿ wait
-	while (pid == fgpid(jobs))
+	while (pid == fgpid())
 	{
-		sleep(1);
+		sigsuspend(&wait_mask);
 	}
+	sigprocmask(SIG_SETMASK, &prev, NULL);
 	return;
 }
 
+/*
+ * runbatch - Run every line of fp as a background job, at most batch at
+ *     a time, then wait for all of them. sigchld_handler reaps the jobs
+ *     and reports each one's exit status and wall time. Blank lines and
+ *     lines starting with # are skipped, builtins run in line order.
+ */
+void runbatch(FILE *fp)
+{
+	char line[MAXLINE];
+	char *p;
+	size_t len;
+	sigset_t mask, prev, wait_mask;
+	struct timespec t0, t1;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &mask, &prev);
+	wait_mask = prev;
+	sigdelset(&wait_mask, SIGCHLD);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	//'&'  ڸ  д´
+	while (fgets(line, MAXLINE - 2, fp) != NULL) {
+		p = line + strspn(line, " \t");
+		if (*p == '\n' || *p == '\0' || *p == '#')
+			continue;
+
+		//job Ͽ ִ job batch ̸   ٸ
+		while (maxjobs - nfree >= batch)
+			sigsuspend(&wait_mask);
+
+		// background , ̹ '&'  ״
+		len = strcspn(line, "\n");
+		while (len > 0 && isspace((unsigned char)line[len - 1]))
+			len--;
+		if (len > 0 && line[len - 1] == '&')
+			strcpy(line + len, "\n");
+		else
+			strcpy(line + len, " &\n");
+		eval(line);
+		fflush(stdout);
+	}
+
+	while (maxjobs - nfree > 0)
+		sigsuspend(&wait_mask);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("%d jobs, %d failed, %.3fs\n", batch_done, batch_failed,
+		(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+	fflush(stdout);
+	sigprocmask(SIG_SETMASK, &prev, NULL);
+}
+
+/*
+ * reportjob - Print a finished batch job's exit status (or killing
+ *     signal) and resource usage. Called from sigchld_handler.
+ */
+void reportjob(struct job_t *job)
+{
+	if (WIFSIGNALED(job->status))
+		printf("[%d] (%d) signal %d %.3fs %s", job->jid, job->pid,
+			WTERMSIG(job->status), job->wall, job->cmdline);
+	else
+		printf("[%d] (%d) exit %d %.3fs %s", job->jid, job->pid,
+			WEXITSTATUS(job->status), job->wall, job->cmdline);
+	printf("    ");
+	printusage(job, job->wall);
+	batch_done++;
+	if (job->status != 0)
+		batch_failed++;
+}
+
+/*
+ * do_time - Execute the builtin time: run the rest of cmdline like any
+ *     command line, then print the resource usage of the job if it ran
+ *     in the foreground and finished (not for & or a stopped job).
+ */
+void do_time(char *cmdline)
+{
+	char *rest = cmdline + strspn(cmdline, " \t") + strlen("time");
+
+	if (rest[strspn(rest, " \t\n")] == '\0') {
+		printf("time command requires a command line\n");
+		return;
+	}
+	fgdone.pid = 0;
+	eval(rest);
+	if (fgdone.pid != 0)
+		printusage(&fgdone, fgdone.wall);
+}
+
+/* printusage - Print wall time and job's CPU time and max RSS on one line */
+void printusage(struct job_t *job, double wall)
+{
+	printf("real %.3fs user %ld.%03lds sys %ld.%03lds maxrss %ldK\n", wall,
+		(long)job->utime.tv_sec, (long)job->utime.tv_usec / 1000,
+		(long)job->stime.tv_sec, (long)job->stime.tv_usec / 1000, job->maxrss);
+}
+
 /*****************
  * Signal handlers
  *****************/
@@ -420,56 +992,86 @@ void waitfg(pid_t pid) //TODO
 void sigchld_handler(int sig)
 {
 	/* $begin handout */
-	pid_t child_pid;
+	pid_t child_pid, job_pid;
 	int child_jid;
 	int status;
+	struct rusage ru;
+	struct timespec now;
 
 	if (verbose)
 		printf("sigchld_handler: entering\n");
 
 	/* Detect any terminated or stopped jobs, but don't wait on the others. */
-	while ((child_pid = waitpid(-1, &status, WNOHANG | WUNTRACED)) > 0) {
+	while ((child_pid = wait4(-1, &status, WNOHANG | WUNTRACED, &ru)) > 0) {
 
-		/* Was the job stopped by the receipt of a signal? */
-		if (WIFSTOPPED(status)) {
-			struct job_t *j = getjobpid(jobs, child_pid);
-			if (!j) {
+		/* A pipeline is one job, reported by its first (group leader) pid */
+		struct job_t *j = getjobmember(child_pid);
+		if (!j) {
+			if (WIFSTOPPED(status)) {
 				printf("Lost track of (%d)\n", child_pid);
 				return;
 			}
-			j->state = ST;
+			continue;
+		}
+		job_pid = j->pid;
+		child_jid = j->jid;
+
+		/*
+		 * The last command's status is the job's, CPU times add up over
+		 * the processes. Report once the whole job is reaped.
+		 */
+		if (!WIFSTOPPED(status)) {
+			dropjobpid(j, child_pid);
+			if (child_pid == j->pids[j->nstage - 1])
+				j->status = status;
+			timeradd(&j->utime, &ru.ru_utime, &j->utime);
+			timeradd(&j->stime, &ru.ru_stime, &j->stime);
+			if (ru.ru_maxrss > j->maxrss)
+				j->maxrss = ru.ru_maxrss;
+			if (j->nproc == 1) {
+				clock_gettime(CLOCK_MONOTONIC, &now);
+				j->wall = (now.tv_sec - j->start.tv_sec) + (now.tv_nsec - j->start.tv_nsec) / 1e9;
+				if (j == fgjob)
+					fgdone = *j;
+				if (batch)
+					reportjob(j);
+			}
+		}
 
-			fprintf(stdout, "Job [%d] (%d) stopped by signal %d\n",
-				pid2jid(child_pid), child_pid, WSTOPSIG(status));
+		/* Was the job stopped by the receipt of a signal? */
+		if (WIFSTOPPED(status)) {
+			/* every process of the group stops, report the job once */
+			if (j->state != ST)
+				fprintf(stdout, "Job [%d] (%d) stopped by signal %d\n",
+					child_jid, job_pid, WSTOPSIG(status));
+			setjobstate(j, ST);
 		}
 
 		/* Was the job terminated by the receipt of an uncaught signal? */
 		else if (WIFSIGNALED(status)) {
-			child_jid = pid2jid(child_pid);
-			if (deletejob(jobs, child_pid))
+			/* like the exit status, only the last command's signal counts */
+			if (!batch && child_pid == j->pids[j->nstage - 1])
+				fprintf(stdout, "Job [%d] (%d) terminated by signal %d\n",
+					child_jid, job_pid, WTERMSIG(status));
+			if (--j->nproc == 0 && deletejob(job_pid))
 				if (verbose)
 					printf("sigchld_handler: Job [%d] (%d) deleted\n",
-						child_jid, child_pid);
-
-			fprintf(stdout, "Job [%d] (%d) terminated by signal %d\n",
-				child_jid, child_pid, WTERMSIG(status));
-
+						child_jid, job_pid);
 		}
 
 		/* Did the job terminate normally? */
 		else if (WIFEXITED(status)) {
-			child_jid = pid2jid(child_pid);
-			if (deletejob(jobs, child_pid))
+			if (--j->nproc == 0 && deletejob(job_pid))
 				if (verbose)
 					printf("sigchld_handler: Job [%d] (%d) deleted\n",
-						child_jid, child_pid);
+						child_jid, job_pid);
 			if (verbose) {
 				printf("sigchld_handler: Job [%d] (%d) terminates OK (status %d)\n",
 					child_jid, child_pid, WEXITSTATUS(status));
 			}
 		}
 		else
-			unix_error("waitpid error");
+			unix_error("wait4 error");
 	}
 
 	/*
@@ -500,7 +1102,7 @@ void sigint_handler(int sig)
 
 	if (verbose)
 		printf("sigint_handler: entering\n");
-	if ((pid = fgpid(jobs)) > 0) {
+	if ((pid = fgpid()) > 0) {
 		if (kill(-pid, SIGINT) < 0)
 			unix_error("kill (sigint) error");
 		if (verbose)
@@ -525,7 +1127,7 @@ void sigtstp_handler(int sig)
 
 	if (verbose)
 		printf("sigtstp_handler: entering\n");
-	if ((pid = fgpid(jobs)) > 0) {
+	if ((pid = fgpid()) > 0) {
 		if (kill(-pid, SIGTSTP) < 0)
 			unix_error("kill (tstp) error");
 		if (verbose)
@@ -553,129 +1155,284 @@ void clearjob(struct job_t *job) {
 	job->jid = 0;
 	job->state = UNDEF;
 	job->cmdline[0] = '\0';
+	job->nstage = 0;
+	job->nproc = 0;
 }
 
-/* initjobs - Initialize the job list */
-void initjobs(struct job_t *jobs) {
-	int i;
+/* pidhash - Home slot of pid in pidmap */
+static unsigned pidhash(pid_t pid)
+{
+	return ((unsigned)pid * 2654435761u) & (pidcap - 1);
+}
 
-	for (i = 0; i < MAXJOBS; i++)
-		clearjob(&jobs[i]);
+/* pidmap_put - Map pid to slot, there must be room */
+static void pidmap_put(pid_t pid, int slot)
+{
+	unsigned i = pidhash(pid);
+
+	while (pidmap[i].pid != 0)
+		i = (i + 1) & (pidcap - 1);
+	pidmap[i].pid = pid;
+	pidmap[i].slot = slot;
+	npids++;
 }
 
-/* maxjid - Returns largest allocated job ID */
-int maxjid(struct job_t *jobs)
+/* pidmap_get - Slot of the job pid belongs to, -1 if none */
+static int pidmap_get(pid_t pid)
 {
-	int i, max = 0;
+	unsigned i;
 
-	for (i = 0; i < MAXJOBS; i++)
-		if (jobs[i].jid > max)
-			max = jobs[i].jid;
-	return max;
+	for (i = pidhash(pid); pidmap[i].pid != 0; i = (i + 1) & (pidcap - 1))
+		if (pidmap[i].pid == pid)
+			return pidmap[i].slot;
+	return -1;
 }
 
-/* addjob - Add a job to the job list */
-int addjob(struct job_t *jobs, pid_t pid, int state, char *cmdline)
+/* pidmap_del - Unmap pid if it maps to slot, never allocates (called from sigchld_handler) */
+static void pidmap_del(pid_t pid, int slot)
 {
-	int i;
+	unsigned i, j, h;
 
-	if (pid < 1)
-		return 0;
+	for (i = pidhash(pid); pidmap[i].pid != pid || pidmap[i].slot != slot; i = (i + 1) & (pidcap - 1))
+		if (pidmap[i].pid == 0)
+			return;
 
-	for (i = 0; i < MAXJOBS; i++) {
-		if (jobs[i].pid == 0) {
-			jobs[i].pid = pid;
-			jobs[i].state = state;
-			jobs[i].jid = nextjid++;
-			if (nextjid > MAXJOBS)
-				nextjid = 1;
-			strcpy(jobs[i].cmdline, cmdline);
-			if (verbose) {
-				printf("Added job [%d] %d %s\n", jobs[i].jid, jobs[i].pid, jobs[i].cmdline);
-			}
-			return 1;
+	/* pull later entries of the run back into the hole */
+	for (j = (i + 1) & (pidcap - 1); pidmap[j].pid != 0; j = (j + 1) & (pidcap - 1)) {
+		h = pidhash(pidmap[j].pid);
+		if (((j - h) & (pidcap - 1)) >= ((j - i) & (pidcap - 1))) {
+			pidmap[i] = pidmap[j];
+			i = j;
 		}
 	}
-	printf("Tried to create too many jobs\n");
+	pidmap[i].pid = 0;
+	npids--;
+}
+
+/* pidmap_reserve - Make room for n more pids, -1 if out of memory */
+static int pidmap_reserve(int n)
+{
+	struct pidslot *old = pidmap;
+	int old_cap = pidcap, i;
+
+	if ((npids + n) * 2 <= pidcap)
+		return 0;
+	while ((npids + n) * 2 > pidcap)
+		pidcap *= 2;
+	if ((pidmap = calloc(pidcap, sizeof(struct pidslot))) == NULL) {
+		pidmap = old;
+		pidcap = old_cap;
+		return -1;
+	}
+	npids = 0;
+	for (i = 0; i < old_cap; i++)
+		if (old[i].pid != 0)
+			pidmap_put(old[i].pid, old[i].slot);
+	free(old);
 	return 0;
 }
 
-/* deletejob - Delete a job whose PID=pid from the job list */
-int deletejob(struct job_t *jobs, pid_t pid)
+/* growjobs - Double the job list, -1 if out of memory */
+static int growjobs(void)
 {
-	int i;
+	struct job_t *newjobs;
+	int *newfree;
+	int i, cap = maxjobs ? maxjobs * 2 : MAXJOBS;
+
+	if ((newjobs = realloc(jobs, sizeof(struct job_t) * cap)) == NULL)
+		return -1;
+	if (fgjob)
+		fgjob = newjobs + (fgjob - jobs);
+	jobs = newjobs;
+	if ((newfree = realloc(freeslots, sizeof(int) * cap)) == NULL)
+		return -1;
+	freeslots = newfree;
+
+	/* lowest slot on top, so a fresh list fills up in order */
+	for (i = cap - 1; i >= maxjobs; i--) {
+		clearjob(&jobs[i]);
+		freeslots[nfree++] = i;
+	}
+	maxjobs = cap;
+	return 0;
+}
+
+/* initjobs - Initialize the job list */
+void initjobs(void) {
+	pidcap = 4 * MAXJOBS;
+	if ((pidmap = calloc(pidcap, sizeof(struct pidslot))) == NULL || growjobs() < 0)
+		unix_error("initjobs error");
+}
+
+/* maxjid - Returns largest allocated job ID */
+int maxjid(void)
+{
+	return nextjid - 1;
+}
+
+/*
+ * addjob - Add a job to the job list. The handlers read the list, they
+ *     are held off while it may move.
+ */
+int addjob(pid_t pid, int state, char *cmdline)
+{
+	struct job_t *job = NULL;
+	sigset_t mask, prev;
+	int jid, slot;
 
 	if (pid < 1)
 		return 0;
 
-	for (i = 0; i < MAXJOBS; i++) {
-		if (jobs[i].pid == pid) {
-			clearjob(&jobs[i]);
-			nextjid = maxjid(jobs) + 1;
-			return 1;
-		}
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTSTP);
+	sigprocmask(SIG_BLOCK, &mask, &prev);
+
+	//jid  ū jid + 1, MAXJID  ִ   jid
+	jid = nextjid;
+	if (jid > MAXJID)
+		for (jid = 1; jid <= MAXJID && jidmap[jid]; jid++)
+			;
+	//  pid  ڸ ̸ Ƶθ setjobpids Ҵ ʴ´
+	if (jid <= MAXJID && (nfree > 0 || growjobs() == 0) && pidmap_reserve(MAXPIPE) == 0) {
+		slot = freeslots[--nfree];
+		job = &jobs[slot];
+		job->pid = pid;
+		job->pids[0] = pid;
+		job->nstage = job->nproc = 1;
+		job->jid = jid;
+		if (jid >= nextjid)
+			nextjid = jid + 1;
+		jidmap[jid] = slot + 1;
+		pidmap_put(pid, slot);
+		job->status = 0;
+		clock_gettime(CLOCK_MONOTONIC, &job->start);
+		job->wall = 0;
+		timerclear(&job->utime);
+		timerclear(&job->stime);
+		job->maxrss = 0;
+		strcpy(job->cmdline, cmdline);
+		setjobstate(job, state);
 	}
-	return 0;
+	sigprocmask(SIG_SETMASK, &prev, NULL);
+
+	if (job == NULL) {
+		printf("Tried to create too many jobs\n");
+		return 0;
+	}
+	if (verbose) {
+		printf("Added job [%d] %d %s\n", job->jid, job->pid, job->cmdline);
+	}
+	return 1;
 }
 
-/* fgpid - Return PID of current foreground job, 0 if no such job */
-pid_t fgpid(struct job_t *jobs) {
-	int i;
+/* setjobpids - Record every process of job's pipeline, pids[0] == job->pid */
+void setjobpids(struct job_t *job, pid_t *pids, int n)
+{
+	int k;
 
-	for (i = 0; i < MAXJOBS; i++)
-		if (jobs[i].state == FG)
-			return jobs[i].pid;
-	return 0;
+	for (k = 1; k < n; k++)
+		pidmap_put(pids[k], job - jobs);
+	memcpy(job->pids, pids, sizeof(pid_t) * n);
+	job->nstage = job->nproc = n;
+}
+
+/*
+ * dropjobpid - Forget a reaped process of job. The leader's pid names the
+ *     group until the job is deleted, the others may be reused right away.
+ */
+void dropjobpid(struct job_t *job, pid_t pid)
+{
+	if (pid != job->pid)
+		pidmap_del(pid, job - jobs);
+}
+
+/* setjobstate - Change job's state, keeping fgjob in step */
+void setjobstate(struct job_t *job, int state)
+{
+	if (state == FG)
+		fgjob = job;
+	else if (fgjob == job)
+		fgjob = NULL;
+	job->state = state;
+}
+
+/* deletejob - Delete a job whose PID=pid from the job list */
+int deletejob(pid_t pid)
+{
+	struct job_t *job;
+	int k, slot;
+
+	if ((job = getjobpid(pid)) == NULL)
+		return 0;
+
+	slot = job - jobs;
+	if (fgjob == job)
+		fgjob = NULL;
+	for (k = 0; k < job->nstage; k++)
+		pidmap_del(job->pids[k], slot);
+	jidmap[job->jid] = 0;
+	// jid  jid   ū  + 1,  ŭ  ö ̶ ġ O(1)
+	while (nextjid > 1 && jidmap[nextjid - 1] == 0)
+		nextjid--;
+	clearjob(job);
+	freeslots[nfree++] = slot;
+	return 1;
+}
+
+/* fgpid - Return PID of current foreground job, 0 if no such job */
+pid_t fgpid(void) {
+	return fgjob ? fgjob->pid : 0;
 }
 
 /* getjobpid  - Find a job (by PID) on the job list */
-struct job_t *getjobpid(struct job_t *jobs, pid_t pid) {
-	int i;
+struct job_t *getjobpid(pid_t pid) {
+	struct job_t *job = getjobmember(pid);
 
-	if (pid < 1)
-		return NULL;
-	for (i = 0; i < MAXJOBS; i++)
-		if (jobs[i].pid == pid)
-			return &jobs[i];
-	return NULL;
+	return job && job->pid == pid ? job : NULL;
 }
 
 /* getjobjid  - Find a job (by JID) on the job list */
-struct job_t *getjobjid(struct job_t *jobs, int jid)
+struct job_t *getjobjid(int jid)
 {
-	int i;
+	if (jid < 1 || jid > MAXJID || jidmap[jid] == 0)
+		return NULL;
+	return &jobs[jidmap[jid] - 1];
+}
+
+/* getjobmember - Find the job that process pid belongs to */
+struct job_t *getjobmember(pid_t pid)
+{
+	int slot;
 
-	if (jid < 1)
+	if (pid < 1 || (slot = pidmap_get(pid)) < 0)
 		return NULL;
-	for (i = 0; i < MAXJOBS; i++)
-		if (jobs[i].jid == jid)
-			return &jobs[i];
-	return NULL;
+	return &jobs[slot];
 }
 
 /* pid2jid - Map process ID to job ID */
 int pid2jid(pid_t pid)
 {
-	int i;
+	struct job_t *job = getjobpid(pid);
 
-	if (pid < 1)
-		return 0;
-	for (i = 0; i < MAXJOBS; i++)
-		if (jobs[i].pid == pid) {
-			return jobs[i].jid;
-		}
-	return 0;
+	return job ? job->jid : 0;
 }
 
-/* listjobs - Print the job list */
-void listjobs(struct job_t *jobs)
+/*
+ * listjobs - Print the job list in jid order. With usage, follow each job
+ *     with its elapsed time and the usage of its processes reaped so far.
+ */
+void listjobs(int usage)
 {
-	int i;
-
-	for (i = 0; i < MAXJOBS; i++) {
-		if (jobs[i].pid != 0) {
-			printf("[%d] (%d) ", jobs[i].jid, jobs[i].pid);
-			switch (jobs[i].state) {
+	struct job_t *job;
+	struct timespec now;
+	int jid;
+
+	for (jid = 1; jid < nextjid; jid++) {
+		if ((job = getjobjid(jid)) != NULL) {
+			printf("[%d] (%d) ", job->jid, job->pid);
+			switch (job->state) {
 			case BG:
 				printf("Running ");
 				break;
@@ -687,9 +1444,14 @@ void listjobs(struct job_t *jobs)
 				break;
 			default:
 				printf("listjobs: Internal error: job[%d].state=%d ",
-					i, jobs[i].state);
+					jidmap[jid] - 1, job->state);
+			}
+			printf("%s", job->cmdline);
+			if (usage) {
+				clock_gettime(CLOCK_MONOTONIC, &now);
+				printf("    ");
+				printusage(job, (now.tv_sec - job->start.tv_sec) + (now.tv_nsec - job->start.tv_nsec) / 1e9);
 			}
-			printf("%s", jobs[i].cmdline);
 		}
 	}
 }
@@ -707,10 +1469,11 @@ void listjobs(struct job_t *jobs)
    */
 void usage(void)
 {
-	printf("Usage: shell [-hvp]\n");
+	printf("Usage: shell [-hvp] [-j N [script]]\n");
 	printf("   -h   print this message\n");
 	printf("   -v   print additional diagnostic information\n");
 	printf("   -p   do not emit a command prompt\n");
+	printf("   -j N run the script's lines as jobs, at most N at once\n");
 	exit(1);
 }
 
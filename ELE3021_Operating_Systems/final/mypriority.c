@@ -1,4 +1,6 @@
 #include "sched.h"
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 static void put_prev_task_mypriority(struct rq *rq, struct task_struct *p);
 static int select_task_rq_mypriority(struct task_struct *p, int cpu, int sd_flag, int flags);
 static void set_curr_task_mypriority(struct rq *rq);
@@ -12,9 +14,68 @@ static void check_preempt_curr_mypriority(struct rq *rq, struct task_struct *p,
 struct task_struct *pick_next_task_mypriority(struct rq *rq, struct task_struct *prev);
 static void prio_changed_mypriority(struct rq *rq, struct task_struct *p, int oldprio);
 static void queueing_mypriority(struct sched_mypriority_entity *entity, struct mypriority_rq *mypriority_rq, pid_t pid);
+static void unqueueing_mypriority(struct sched_mypriority_entity *entity, struct mypriority_rq *mypriority_rq);
+static void update_next_priority(struct mypriority_rq *mypriority_rq);
+#ifdef CONFIG_SMP
+static void task_woken_mypriority(struct rq *rq, struct task_struct *p);
+static int pull_task_mypriority(struct rq *this_rq);
+#endif
 
 #define MYRR_TIME_SLICE 4
 #define PRIORITY_NUM 50
+
+/*
+ * ٷ  α״ printk  mypriority_trace ftrace ۿ .
+ * ְܼ α ۸ ġ ʰ,    static key nop ϳ ´.
+ * ѱ: echo 1 > /proc/sched_mypriority, : cat /sys/kernel/debug/tracing/trace_pipe
+ */
+static DEFINE_STATIC_KEY_FALSE(mypriority_trace_key);
+#define mypriority_trace(fmt, ...) \
+	do { \
+		if (static_branch_unlikely(&mypriority_trace_key)) \
+			trace_printk("***[MYPRIORITY] " fmt, ##__VA_ARGS__); \
+	} while (0)
+
+/*
+ * cpu .  cpu rq lock  äθ ϹǷ  ȭ ʴ´.
+ *  ð task ť   pick  ð
+ * CONFIG_SCHED_INFO sched_info.last_queued ״ .
+ */
+struct mypriority_stats {
+	u64 enqueue;
+	u64 dequeue;
+	u64 pick;
+	u64 aging;	// aging ڷ ġ Ƚ
+	u64 preempt;	// enqueue  Ƚ
+	u64 migrate;
+	u64 wait_sum;	// ns
+	u64 wait_count;
+};
+static DEFINE_PER_CPU(struct mypriority_stats, mypriority_stats);
+#define mypriority_stat_inc(rq, field) (per_cpu(mypriority_stats, cpu_of(rq)).field++)
+
+/*
+ * ť RT Ŭ rt_prio_arrayó 켱 FIFO Ʈ ϳ
+ *    Ʈ ǥϴ Ʈ Ǿ ִ (sched.h):
+ *
+ *	struct mypriority_prio_array {
+ *		DECLARE_BITMAP(bitmap, PRIORITY_NUM + 1);	//  Ʈ ׻ 1
+ *		struct list_head queue[PRIORITY_NUM];
+ *	};
+ *	struct mypriority_rq {
+ *		struct mypriority_prio_array active;
+ *		unsigned int nr_running;
+ *		int next_priority;
+ *	};
+ *
+ * ֱ, ,  task Ⱑ  find_first_bit   
+ * ť ִ task  .
+ * aging priority PRIORITY_NUM - 1   Ʈ FIFO д.
+ */
+static inline int mypriority_index(int priority)
+{
+	return priority < PRIORITY_NUM ? priority : PRIORITY_NUM - 1;
+}
 const struct sched_class mypriority_sched_class = {
 	.next = &fair_sched_class,
 	.enqueue_task = &enqueue_task_mypriority,
@@ -24,6 +85,7 @@ const struct sched_class mypriority_sched_class = {
 	.put_prev_task = put_prev_task_mypriority,
 #ifdef CONFIG_SMP
 	.select_task_rq = select_task_rq_mypriority,
+	.task_woken = task_woken_mypriority,
 #endif
 	.set_curr_task = set_curr_task_mypriority,
 	.task_tick = task_tick_mypriority,
@@ -35,10 +97,18 @@ const struct sched_class mypriority_sched_class = {
 
 void init_mypriority_rq(struct mypriority_rq *mypriority_rq)
 {
+	struct mypriority_prio_array *array = &mypriority_rq->active;
+	int i;
+
 	printk(KERN_INFO "***[MYPRIORITY] Mysched class is online \n");
 	mypriority_rq->nr_running = 0;
 	mypriority_rq->next_priority = 0;
-	INIT_LIST_HEAD(&mypriority_rq->queue);
+	for (i = 0; i < PRIORITY_NUM; i++) {
+		INIT_LIST_HEAD(array->queue + i);
+		__clear_bit(i, array->bitmap);
+	}
+	//find_first_bit  ť PRIORITY_NUM ֵ Ѵ.
+	__set_bit(PRIORITY_NUM, array->bitmap);
 
 }
 
@@ -47,65 +117,76 @@ static void update_curr_mypriority(struct rq *rq) {
 	struct task_struct *curr = rq->curr;
 	struct mypriority_rq *mypriority_rq = &rq->mypriority;
 	struct sched_mypriority_entity *entity = &curr->mypriority;
+	//ť  task 켱 ٲ۴.
+	if (list_empty(&entity->run_list)) {
+		entity->priority++;
+		return;
+	}
 	//켱  δ.
+	//Ʈ  priority ãƾ ϹǷ  ť .
+	unqueueing_mypriority(entity, mypriority_rq);
 	entity->priority++;
-	printk("***[MYPRIORITY] aging_mypriority AGING ++	pid=%d priority=%d\n", curr->pid, entity->priority);
+	mypriority_trace("aging_mypriority AGING ++	pid=%d priority=%d\n", curr->pid, entity->priority);
 	// ι°  켱 ڽ 켱  ٸ(ڰ  ũٸ) ť ġ Ų.
-	if (mypriority_rq->nr_running > 1 && (entity->priority > mypriority_rq->next_priority)) {
-		printk("***[MYPRIORITY] AGING -- > REPLACE BEFORE pid=%d priority=%d\n", curr->pid, entity->priority);
-		//ť ġ ۾ - 켱 
-		list_del_init(&curr->mypriority.run_list);
-		mypriority_rq->nr_running--;
-		//ť ġ ۾ -  ° ٽ 
+	if (mypriority_rq->nr_running > 1 && (mypriority_index(entity->priority) > mypriority_rq->next_priority)) {
+		mypriority_trace("AGING -- > REPLACE BEFORE pid=%d priority=%d\n", curr->pid, entity->priority);
+		//ť ġ ۾ -  °  켱  ڿ 
 		queueing_mypriority(entity, mypriority_rq, curr->pid);
-		mypriority_rq->nr_running++;
+		mypriority_stat_inc(rq, aging);
 		//ٽ ٸ ǽ
 		resched_curr(rq);
-		printk("***[MYPRIORITY] AGING -- > REPLACE AFTER pid=%d\n", curr->pid);
+		mypriority_trace("AGING -- > REPLACE AFTER pid=%d\n", curr->pid);
+	}
+	else {
+		//  ̹Ƿ  켱 Ʈ  տ ´.
+		int idx = mypriority_index(entity->priority);
+		list_add(&entity->run_list, mypriority_rq->active.queue + idx);
+		__set_bit(idx, mypriority_rq->active.bitmap);
+		update_next_priority(mypriority_rq);
 	}
 
 }
 
 static void queueing_mypriority(struct sched_mypriority_entity *entity, struct mypriority_rq *mypriority_rq, pid_t pid) {
-	struct list_head *head = mypriority_rq->queue.next;
-	struct list_head *now_list = mypriority_rq->queue.next;
+	struct mypriority_prio_array *array = &mypriority_rq->active;
+	int idx = mypriority_index(entity->priority);
 
-	struct task_struct *next_p = NULL;
-	struct sched_mypriority_entity *next_se = NULL;
-	struct sched_mypriority_entity * now_entity;
-	printk("***[MYPRIORITY] queuing mypriority - START pid=%d\n", pid);
-	//ť   ã´
-	while (now_list->next != head) {
-		now_entity = container_of(now_list, struct sched_mypriority_entity, run_list);
-		if (now_entity->priority > entity->priority) {
-			// ڸ ãҴٸ ũ Ʈ Ѵ.
-			entity->run_list.next = now_list;
-			entity->run_list.prev = now_list->prev;
-			now_list->prev->next = &entity->run_list;
-			now_list->prev = &entity->run_list;
-
-			next_se = container_of(now_list, struct sched_mypriority_entity, run_list);
-			next_p = container_of(next_se, struct task_struct, mypriority);
-			printk("***[MYPRIORITY] queuing mypriority - LOCATE!!!! pid=%d my next=%d priority=%d\n", pid, next_p->pid, entity->priority);
-			break;
-		}
-		now_list = now_list->next;
-	}
-	//tail ġؾϴ  list_add_tail Լ Ȱ
-	if (now_list->next == head) {
-		printk("***[MYPRIORITY] queuing mypriority - LOCATE TAIL pid=%d priority=%d\n", pid, entity->priority);
-		list_add_tail(&entity->run_list, &mypriority_rq->queue);
-	}
+	mypriority_trace("queuing mypriority - START pid=%d\n", pid);
+	// 켱   ǵ Ʈ  ִ´.
+	list_add_tail(&entity->run_list, array->queue + idx);
+	__set_bit(idx, array->bitmap);
+	mypriority_trace("queuing mypriority - LOCATE pid=%d priority=%d\n", pid, entity->priority);
 
 	// μ 켱  Ͽ д.
-	if (mypriority_rq->nr_running > 1) {
-		struct sched_mypriority_entity *find_entity;
-		struct list_head *head = mypriority_rq->queue.next;
-		find_entity = container_of(head->next, struct sched_mypriority_entity, run_list);
-		mypriority_rq->next_priority = find_entity->priority;
-		printk("***[MYPRIORITY] queuing mypriority - NEXT PRIORITY VALUE mypriority_rq->next_priority=%d\n", mypriority_rq->next_priority);
+	update_next_priority(mypriority_rq);
+}
 
-	}
+//task ڱ 켱 Ʈ , Ʈ  Ʈ .
+static void unqueueing_mypriority(struct sched_mypriority_entity *entity, struct mypriority_rq *mypriority_rq) {
+	struct mypriority_prio_array *array = &mypriority_rq->active;
+	int idx = mypriority_index(entity->priority);
+
+	list_del_init(&entity->run_list);
+	if (list_empty(array->queue + idx))
+		__clear_bit(idx, array->bitmap);
+}
+
+//ι°  task 켱 =   Ʈ task  ̸̻  켱,
+//ƴϸ    Ʈ
+static void update_next_priority(struct mypriority_rq *mypriority_rq) {
+	struct mypriority_prio_array *array = &mypriority_rq->active;
+	int idx;
+
+	if (mypriority_rq->nr_running <= 1)
+		return;
+	idx = find_first_bit(array->bitmap, PRIORITY_NUM);
+	if (idx >= PRIORITY_NUM)
+		return;
+	if (!list_is_singular(array->queue + idx))
+		mypriority_rq->next_priority = idx;
+	else
+		mypriority_rq->next_priority = find_next_bit(array->bitmap, PRIORITY_NUM, idx + 1);
+	mypriority_trace("NEXT PRIORITY VALUE mypriority_rq->next_priority=%d\n", mypriority_rq->next_priority);
 }
 
 static void enqueue_task_mypriority(struct rq *rq, struct task_struct *p, int flags) {
@@ -119,14 +200,18 @@ static void enqueue_task_mypriority(struct rq *rq, struct task_struct *p, int fl
 	//켱 ° ť ִ´.
 	rq->mypriority.nr_running++;
 	queueing_mypriority(task, mypriority_rq, p->pid);
-	printk(KERN_INFO"***[MYPRIORITY] Enqueue: success cpu=%d, nr_running=%d, pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, p->pid);
+	mypriority_stat_inc(rq, enqueue);
+	mypriority_trace("Enqueue: success cpu=%d, nr_running=%d, pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, p->pid);
 	
 
 	//  켱 Ͽ CPU ȹϰ ȴ.
-	if (mypriority_rq->nr_running > 1 && (&task->run_list == mypriority_rq->queue.next)) {
+	if (mypriority_rq->nr_running > 1 &&
+		find_first_bit(mypriority_rq->active.bitmap, PRIORITY_NUM) == mypriority_index(task->priority) &&
+		list_is_singular(mypriority_rq->active.queue + mypriority_index(task->priority))) {
 		//ٸ Ѵ.
 		resched_curr(rq);
-		printk(KERN_INFO"***[MYPRIORITY] enqueue - PREEMPT: success cpu=%d, nr_running=%d, now_pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, curr->pid);
+		mypriority_stat_inc(rq, preempt);
+		mypriority_trace("enqueue - PREEMPT: success cpu=%d, nr_running=%d, now_pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, curr->pid);
 
 	}
 
@@ -139,51 +224,178 @@ static void dequeue_task_mypriority(struct rq *rq, struct task_struct *p, int fl
 
 		//ϳ ̻ Ұ ť   
 		//Ѱܹ task ť Ѵ.
-		list_del_init(&p->mypriority.run_list);
+		unqueueing_mypriority(&p->mypriority, mypriority_rq);
 		//ť  μ   δ.
 		rq->mypriority.nr_running--;
-		printk(KERN_INFO"***[MYPRIORITY] Dequeue: success cpu=%d, nr_running=%d, pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, p->pid);
-		if (mypriority_rq->nr_running > 1) {
-			// 2̻ Ұ   ι°  켱  缳 Ѵ.
-			struct sched_mypriority_entity *find_entity;
-			struct list_head *head = mypriority_rq->queue.next;
-			find_entity = container_of(head->next, struct sched_mypriority_entity, run_list);
-			mypriority_rq->next_priority = find_entity->priority;
-			printk("***[MYPRIORITY]  Dequeue - NEXT PRIORITY VALUE mypriority_rq->next_priority=%d\n", mypriority_rq->next_priority);
-		}
+		mypriority_stat_inc(rq, dequeue);
+		mypriority_trace("Dequeue: success cpu=%d, nr_running=%d, pid=%d\n", cpu_of(rq), rq->mypriority.nr_running, p->pid);
+		// 2̻ Ұ   ι°  켱  缳 Ѵ.
+		update_next_priority(mypriority_rq);
 	}
 	else {
 	}
 
 }
 void check_preempt_curr_mypriority(struct rq *rq, struct task_struct *p, int flags) {
-	printk("***[MYPRIORITY] check_preempt_curr_mypriority\n");
+	mypriority_trace("check_preempt_curr_mypriority\n");
 }
 struct task_struct *pick_next_task_mypriority(struct rq *rq, struct task_struct *prev)
 {
 	struct task_struct *next_p = NULL;
 	struct sched_mypriority_entity *next_se = NULL;
 	struct mypriority_rq *mypriority_rq = &rq->mypriority;
+	int idx;
 
+#ifdef CONFIG_SMP
+	//  task   ٻ cpu ϳ ´.
+	if (rq->mypriority.nr_running == 0) {
+		pull_task_mypriority(rq);
+		//   double_lock_balance rq lock    Ƿ
+		//   Ŭ task Դ  ȮѴ.
+		if ((rq->stop && task_on_rq_queued(rq->stop)) || rq->dl.dl_nr_running || rq->rt.rt_nr_running)
+			return RETRY_TASK;
+	}
+#endif
 	//   μ ٸ ٷ 
 	if (rq->mypriority.nr_running == 0) {
 		return NULL;
 	}
 
 	//  ť ϳ ̻  μ Ѵٸ
-	//  μ(ť  )  Ѱְ ȴ.
-	next_se = container_of(mypriority_rq->queue.next, struct sched_mypriority_entity, run_list);
+	//  μ(  켱 Ʈ )  Ѱְ ȴ.
+	idx = find_first_bit(mypriority_rq->active.bitmap, PRIORITY_NUM);
+	if (idx >= PRIORITY_NUM)
+		return NULL;
+	next_se = list_first_entry(mypriority_rq->active.queue + idx, struct sched_mypriority_entity, run_list);
 	next_p = container_of(next_se, struct task_struct, mypriority);
 
-	printk(KERN_INFO "***[MYPRIORITY] pick_next_task: cpu=%d, prev->pid=%d,next_p->pid=%d,nr_running=%d\n", cpu_of(rq), prev->pid, next_p->pid, rq->mypriority.nr_running);
+	mypriority_stat_inc(rq, pick);
+#ifdef CONFIG_SCHED_INFO
+	//prev ״ ٽ  last_queued 0̶  ʴ´.
+	if (sched_info_on() && next_p->sched_info.last_queued) {
+		per_cpu(mypriority_stats, cpu_of(rq)).wait_sum += rq_clock(rq) - next_p->sched_info.last_queued;
+		mypriority_stat_inc(rq, wait_count);
+	}
+#endif
+	mypriority_trace("pick_next_task: cpu=%d, prev->pid=%d,next_p->pid=%d,nr_running=%d\n", cpu_of(rq), prev->pid, next_p->pid, rq->mypriority.nr_running);
 	return next_p;
 }
 void put_prev_task_mypriority(struct rq *rq, struct task_struct *p) {
-	printk(KERN_INFO "***[MYPRIORITY] put_prev_task: do_nothing, p->pid=%d\n", p->pid);
+	mypriority_trace("put_prev_task: do_nothing, p->pid=%d\n", p->pid);
 }
+#ifdef CONFIG_SMP
+/*
+ *  л. cpu ϴ  cpu mypriority ť ִ task (nr_running)̴.
+ * - select_task_rq: wakeup/fork/exec   cpu  ϰ    ´.
+ * - task_woken(push):  task տ ٸ task ְ  Ѱ cpu  ׸ .
+ * - pick_next_task(pull): mypriority task   cpu  ٻ cpu ϳ ´.
+ * ٸ cpu nr_running lock  д´.     cpu  ̴.
+ */
+static int find_lowest_cpu_mypriority(struct task_struct *p, int cpu)
+{
+	int i, best = cpu;
+	unsigned int load, best_load;
+
+	if (!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)))
+		best = cpumask_any_and(tsk_cpus_allowed(p), cpu_online_mask);
+	best_load = READ_ONCE(cpu_rq(best)->mypriority.nr_running);
+	for_each_cpu_and (i, tsk_cpus_allowed(p), cpu_online_mask) {
+		load = READ_ONCE(cpu_rq(i)->mypriority.nr_running);
+		if (load < best_load) {
+			best = i;
+			best_load = load;
+		}
+	}
+	return best;
+}
+
+int select_task_rq_mypriority(struct task_struct *p, int cpu, int sd_flag, int flags)
+{
+	if (p->nr_cpus_allowed == 1)
+		return task_cpu(p);
+	return find_lowest_cpu_mypriority(p, task_cpu(p));
+}
+
+//ť    ƴ task p src_rq dst_rq ű (  lock  )
+static void migrate_task_mypriority(struct rq *src_rq, struct rq *dst_rq, struct task_struct *p)
+{
+	//enqueue 켱 pid ٽ ϹǷ ű task   ó ȴ.
+	deactivate_task(src_rq, p, 0);
+	set_task_cpu(p, cpu_of(dst_rq));
+	activate_task(dst_rq, p, 0);
+	mypriority_stat_inc(dst_rq, migrate);
+	mypriority_trace("migrate: pid=%d cpu=%d -> cpu=%d\n", p->pid, cpu_of(src_rq), cpu_of(dst_rq));
+}
+
+static void task_woken_mypriority(struct rq *rq, struct task_struct *p)
+{
+	struct rq *lowest_rq;
+	int cpu;
+
+	if (task_running(rq, p) || p->nr_cpus_allowed == 1 || rq->mypriority.nr_running < 2)
+		return;
+	cpu = find_lowest_cpu_mypriority(p, cpu_of(rq));
+	lowest_rq = cpu_rq(cpu);
+	if (lowest_rq == rq || READ_ONCE(lowest_rq->mypriority.nr_running) + 1 >= rq->mypriority.nr_running)
+		return;
+
+	double_lock_balance(rq, lowest_rq);
+	//rq lock  ̿ p Űų Ǿ  ִ.
+	if (task_rq(p) == rq && task_on_rq_queued(p) && !task_running(rq, p) &&
+	   cpumask_test_cpu(cpu, tsk_cpus_allowed(p))) {
+		migrate_task_mypriority(rq, lowest_rq, p);
+		resched_curr(lowest_rq);
+	}
+	double_unlock_balance(rq, lowest_rq);
+}
+
+// ٻ cpu   task ϳ ´. Ű 1
+static int pull_task_mypriority(struct rq *this_rq)
+{
+	int this_cpu = cpu_of(this_rq), cpu, busiest = -1, moved = 0, idx;
+	unsigned int load, max_load = 1;
+	struct mypriority_prio_array *array;
+	struct rq *src_rq;
+	struct sched_mypriority_entity *entity;
+	struct task_struct *p;
+
+	for_each_cpu (cpu, cpu_online_mask) {
+		if (cpu == this_cpu)
+			continue;
+		load = READ_ONCE(cpu_rq(cpu)->mypriority.nr_running);
+		if (load > max_load) {
+			busiest = cpu;
+			max_load = load;
+		}
+	}
+	if (busiest < 0)
+		return 0;
+
+	src_rq = cpu_rq(busiest);
+	double_lock_balance(this_rq, src_rq);
+	if (src_rq->mypriority.nr_running > 1) {
+		//src_rq ٸ task  켱    ´.
+		array = &src_rq->mypriority.active;
+		for (idx = find_first_bit(array->bitmap, PRIORITY_NUM); idx < PRIORITY_NUM && !moved;
+		    idx = find_next_bit(array->bitmap, PRIORITY_NUM, idx + 1)) {
+			list_for_each_entry (entity, array->queue + idx, run_list) {
+				p = container_of(entity, struct task_struct, mypriority);
+				if (!task_running(src_rq, p) && cpumask_test_cpu(this_cpu, tsk_cpus_allowed(p))) {
+					migrate_task_mypriority(src_rq, this_rq, p);
+					moved = 1;
+					break;
+				}
+			}
+		}
+	}
+	double_unlock_balance(this_rq, src_rq);
+	return moved;
+}
+#else
 int select_task_rq_mypriority(struct task_struct *p, int cpu, int sd_flag, int flags) { return task_cpu(p); }
+#endif
 void set_curr_task_mypriority(struct rq *rq) {
-	printk(KERN_INFO"***[MYPRIORITY] set_curr_task_mypriority\n");
+	mypriority_trace("set_curr_task_mypriority\n");
 }
 void task_tick_mypriority(struct rq *rq, struct task_struct *p, int queued) {
 	// ð update Լ ȣϰ ȴ.
@@ -195,3 +407,65 @@ void switched_to_mypriority(struct rq *rq, struct task_struct *p)
 {
 	resched_curr(rq);
 }
+
+/*
+ * /proc/sched_mypriority: /proc/sched_debugó cpu 踦 ش.
+ * 0̳ 1  mypriority_trace ų Ҵ.
+ */
+static int sched_mypriority_show(struct seq_file *m, void *v)
+{
+	struct mypriority_stats *st;
+	int cpu;
+
+	seq_printf(m, "mypriority_trace: %s\n", static_key_enabled(&mypriority_trace_key) ? "on" : "off");
+	for_each_online_cpu(cpu) {
+		st = &per_cpu(mypriority_stats, cpu);
+		seq_printf(m, "\ncpu#%d\n", cpu);
+		seq_printf(m, "  .%-30s: %u\n", "nr_running", READ_ONCE(cpu_rq(cpu)->mypriority.nr_running));
+		seq_printf(m, "  .%-30s: %llu\n", "enqueue", st->enqueue);
+		seq_printf(m, "  .%-30s: %llu\n", "dequeue", st->dequeue);
+		seq_printf(m, "  .%-30s: %llu\n", "pick", st->pick);
+		seq_printf(m, "  .%-30s: %llu\n", "aging", st->aging);
+		seq_printf(m, "  .%-30s: %llu\n", "preempt", st->preempt);
+		seq_printf(m, "  .%-30s: %llu\n", "migrate", st->migrate);
+		seq_printf(m, "  .%-30s: %llu\n", "wait_count", st->wait_count);
+		seq_printf(m, "  .%-30s: %llu\n", "avg_wait_ns",
+			   st->wait_count ? div64_u64(st->wait_sum, st->wait_count) : 0);
+	}
+	return 0;
+}
+
+static int sched_mypriority_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_mypriority_show, NULL);
+}
+
+static ssize_t sched_mypriority_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	bool on;
+	int ret = kstrtobool_from_user(ubuf, cnt, &on);
+
+	if (ret)
+		return ret;
+	if (on)
+		static_branch_enable(&mypriority_trace_key);
+	else
+		static_branch_disable(&mypriority_trace_key);
+	return cnt;
+}
+
+static const struct file_operations sched_mypriority_fops = {
+	.open		= sched_mypriority_open,
+	.read		= seq_read,
+	.write		= sched_mypriority_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init init_sched_mypriority_procfs(void)
+{
+	if (!proc_create("sched_mypriority", 0644, NULL, &sched_mypriority_fops))
+		return -ENOMEM;
+	return 0;
+}
+__initcall(init_sched_mypriority_procfs);
@@ -0,0 +1,341 @@
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include "../sharedmemory_version/shmring.h"
+
+/*
+ * hw3      ǿ Ѵ
+ *	fifo  - named pipe (namedpipe_version)
+ *	msgq  - System V ޼ ť (messagequeue_version)
+ *	ring  -  ޸ SPSC  (sharedmemory_version/shmring.h)
+ *
+ * ޼ ũ⸶ writer(θ) reader(ڽ) μ    
+ *	ó: count  ʰ  ù ۽ź  ű ð
+ *	:   ϳ  reader ޾Ҵٰ ˷  ٸ,
+ *	      ޼  8Ʈ ۽ ð  ð (ܹ) 
+ *  μ  CLOCK_MONOTONIC Ƿ ð ٷ   ִ
+ *
+ * : ipcbench [-n count] [-l latency_count] [-s size,size,...]
+ *                  [-t fifo,msgq,ring] [-w writer_cpu] [-r reader_cpu]
+ */
+
+#define FIFONAME "/tmp/ipcbench_fifo"
+#define MAX_SIZE 8192		// ⺻ msgmax
+
+struct transport {
+	const char *name;
+	int (*setup)(void);
+	void (*open_end)(int writer);
+	void (*send)(const char *buf, size_t size);
+	void (*recv)(char *buf, size_t size);
+	void (*cleanup)(void);
+};
+
+// μ     (͸  mmap)
+struct shared {
+	_Atomic uint64_t ack;	//   reader  ޼ 
+	uint64_t first_recv, last_recv;
+	uint64_t lat[];		//    (ns)
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+static void pin(int cpu)
+{
+	cpu_set_t set;
+
+	if (cpu < 0) return;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) == -1) perror("sched_setaffinity");
+}
+
+static void die(const char *msg)
+{
+	perror(msg);
+	exit(1);
+}
+
+/* fifo: mkfifo   writer , reader б  */
+static int fifo_fd = -1;
+
+static int fifo_setup(void)
+{
+	unlink(FIFONAME);
+	return mkfifo(FIFONAME, 0666);
+}
+
+static void fifo_open_end(int writer)
+{
+	fifo_fd = open(FIFONAME, writer ? O_WRONLY : O_RDONLY);
+	if (fifo_fd < 0) die("open fifo");
+}
+
+static void fifo_send(const char *buf, size_t size)
+{
+	ssize_t ret;
+
+	while (size > 0) {
+		ret = write(fifo_fd, buf, size);
+		if (ret < 0) die("write");
+		buf += ret;
+		size -= ret;
+	}
+}
+
+//PIPE_BUF ū ޼    Ƿ sizeŭ  д´
+static void fifo_recv(char *buf, size_t size)
+{
+	ssize_t ret;
+
+	while (size > 0) {
+		ret = read(fifo_fd, buf, size);
+		if (ret <= 0) die("read");
+		buf += ret;
+		size -= ret;
+	}
+}
+
+static void fifo_cleanup(void)
+{
+	if (fifo_fd >= 0) close(fifo_fd);
+	fifo_fd = -1;
+	unlink(FIFONAME);
+}
+
+/* msgq: ޼ ϳ msgsnd/msgrcv  ̴.  IPC_NOWAIT  ʴ´ */
+static int msgq_id = -1;
+static struct {
+	long msgtype;
+	char mtext[MAX_SIZE];
+} msgq_buf;
+
+static int msgq_setup(void)
+{
+	msgq_id = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+	return msgq_id == -1 ? -1 : 0;
+}
+
+static void msgq_open_end(int writer) { }
+
+static void msgq_send(const char *buf, size_t size)
+{
+	msgq_buf.msgtype = 3;
+	memcpy(msgq_buf.mtext, buf, size);
+	if (msgsnd(msgq_id, &msgq_buf, size, 0) == -1) die("msgsnd");
+}
+
+static void msgq_recv(char *buf, size_t size)
+{
+	if (msgrcv(msgq_id, &msgq_buf, size, 3, 0) == -1) die("msgrcv");
+	memcpy(buf, msgq_buf.mtext, size);
+}
+
+static void msgq_cleanup(void)
+{
+	msgctl(msgq_id, IPC_RMID, 0);
+}
+
+/* ring:  ϳ RING_DATA_SIZEƮ, ū ޼  Կ  ƴ´ */
+static int ring_id = -1;
+static struct shmring *ring;
+static struct ring_writer ring_w;
+static struct ring_reader ring_r;
+
+static int ring_setup(void)
+{
+	ring_id = shmget(IPC_PRIVATE, sizeof(struct shmring), IPC_CREAT | 0600);
+	if (ring_id == -1) return -1;
+	ring = shmat(ring_id, (void *)0, 0);
+	return ring == (void *)-1 ? -1 : 0;
+}
+
+static void ring_open_end(int writer)
+{
+	if (writer) ring_writer_init(&ring_w, ring);
+	else ring_reader_init(&ring_r, ring);
+}
+
+static void ring_send(const char *buf, size_t size)
+{
+	struct ring_slot *slot;
+	size_t len;
+
+	do {
+		len = size < RING_DATA_SIZE ? size : RING_DATA_SIZE;
+		slot = ring_reserve(&ring_w);
+		memcpy(slot->data, buf, len);
+		slot->len = len;
+		ring_commit(&ring_w);
+		buf += len;
+		size -= len;
+	} while (size > 0);
+}
+
+static void ring_recv(char *buf, size_t size)
+{
+	struct ring_slot *slot;
+
+	do {
+		slot = ring_peek(&ring_r);
+		memcpy(buf, slot->data, slot->len);
+		buf += slot->len;
+		size -= slot->len;
+		ring_release(&ring_r);
+	} while (size > 0);
+}
+
+static void ring_cleanup(void)
+{
+	shmdt(ring);
+	shmctl(ring_id, IPC_RMID, 0);
+}
+
+static const struct transport transports[] = {
+	{ "fifo", fifo_setup, fifo_open_end, fifo_send, fifo_recv, fifo_cleanup },
+	{ "msgq", msgq_setup, msgq_open_end, msgq_send, msgq_recv, msgq_cleanup },
+	{ "ring", ring_setup, ring_open_end, ring_send, ring_recv, ring_cleanup },
+};
+#define NTRANSPORTS (sizeof(transports) / sizeof(transports[0]))
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+//ĵ 迭 q 
+static double percentile_us(const uint64_t *v, size_t n, double q)
+{
+	size_t i = (size_t)(q * (n - 1) + 0.5);
+	return v[i] / 1000.0;
+}
+
+//  ,  ޼ ũ⿡  ó  缭  ٷ Ѵ
+static void run(const struct transport *t, size_t size, long count, long latcount,
+	int wcpu, int rcpu, struct shared *sh)
+{
+	char buf[MAX_SIZE];
+	uint64_t stamp, start;
+	long i;
+	pid_t pid;
+	int status;
+
+	if (t->setup() == -1) die(t->name);
+	sh->ack = 0;
+	memset(buf, 'x', size);
+
+	pid = fork();
+	if (pid == -1) die("fork");
+	if (pid == 0) {
+		//reader
+		pin(rcpu);
+		t->open_end(0);
+		for (i = 0; i < count; i++) {
+			t->recv(buf, size);
+			if (i == 0) sh->first_recv = now_ns();
+		}
+		sh->last_recv = now_ns();
+		for (i = 0; i < latcount; i++) {
+			t->recv(buf, size);
+			memcpy(&stamp, buf, sizeof(stamp));
+			sh->lat[i] = now_ns() - stamp;
+			atomic_store_explicit(&sh->ack, i + 1, memory_order_release);
+		}
+		_exit(0);
+	}
+
+	//writer
+	pin(wcpu);
+	t->open_end(1);
+	start = now_ns();
+	for (i = 0; i < count; i++) t->send(buf, size);
+	for (i = 0; i < latcount; i++) {
+		stamp = now_ns();
+		memcpy(buf, &stamp, sizeof(stamp));
+		t->send(buf, size);
+		// ޼  ڿ  ť ٸ ð  ʴ´
+		while (atomic_load_explicit(&sh->ack, memory_order_acquire) != (uint64_t)i + 1)
+			sched_yield();
+	}
+	waitpid(pid, &status, 0);
+	t->cleanup();
+
+	double sec = (sh->last_recv - start) * 1e-9;
+	printf("%-6s %6zu %9ld %12.0f %10.1f", t->name, size, count,
+		count / sec, count * size / sec / (1 << 20));
+	if (latcount > 0) {
+		qsort(sh->lat, latcount, sizeof(uint64_t), cmp_u64);
+		printf(" %8.2f %8.2f %8.2f %8.2f %8.2f",
+			percentile_us(sh->lat, latcount, 0.5), percentile_us(sh->lat, latcount, 0.9),
+			percentile_us(sh->lat, latcount, 0.99), percentile_us(sh->lat, latcount, 0.999),
+			sh->lat[latcount - 1] / 1000.0);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+	long count = 1000000, latcount = 10000;
+	char sizes[256] = "16,64,512,4096";
+	char names[64] = "fifo,msgq,ring";
+	int wcpu = -1, rcpu = -1;
+	int opt;
+	size_t i;
+	char *tok;
+	struct shared *sh;
+
+	while ((opt = getopt(argc, argv, "n:l:s:t:w:r:")) != -1) {
+		switch (opt) {
+		case 'n': count = atol(optarg); break;
+		case 'l': latcount = atol(optarg); break;
+		case 's': snprintf(sizes, sizeof(sizes), "%s", optarg); break;
+		case 't': snprintf(names, sizeof(names), "%s", optarg); break;
+		case 'w': wcpu = atoi(optarg); break;
+		case 'r': rcpu = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-n count] [-l latency_count] [-s size,...] "
+				"[-t fifo,msgq,ring] [-w writer_cpu] [-r reader_cpu]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (count < 1) count = 1;
+	if (latcount < 0) latcount = 0;
+
+	sh = mmap(NULL, sizeof(*sh) + latcount * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (sh == MAP_FAILED) die("mmap");
+
+	printf("%-6s %6s %9s %12s %10s %8s %8s %8s %8s %8s\n", "ipc", "size", "count",
+		"msgs/s", "MB/s", "p50(us)", "p90", "p99", "p99.9", "max");
+	for (tok = strtok(sizes, ","); tok; tok = strtok(NULL, ",")) {
+		size_t size = strtoul(tok, NULL, 10);
+		//   8Ʈ ۽ ð ƴ´
+		if (size < sizeof(uint64_t) || size > MAX_SIZE) {
+			fprintf(stderr, "size %zu: must be %zu..%d\n", size, sizeof(uint64_t), MAX_SIZE);
+			continue;
+		}
+		for (i = 0; i < NTRANSPORTS; i++)
+			if (strstr(names, transports[i].name))
+				run(&transports[i], size, count, latcount, wcpu, rcpu, sh);
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef MSGBATCH_H
+#define MSGBATCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * writer reader   ޼ 
+ *	MSGTYPE_SINGLE: mtext ڿ ϳ ('\0'  ̸ )
+ *	MSGTYPE_BATCH:  mtext [(2Ʈ)][('\0' )]   پ ִ
+ * reader msgtype 0 ޾Ƽ      д´
+ */
+#define MSG_KEY 1111
+#define MSGTYPE_SINGLE 3
+#define MSGTYPE_BATCH 4
+#define MSG_LINE 1024		// ޼ ϳ ִ 
+
+struct msgbuf {
+	long msgtype;
+	char mtext[];
+};
+
+//޼ ϳ ִ ũ (Ŀ msgmax)
+static inline size_t msg_max(void)
+{
+	FILE *fp = fopen("/proc/sys/kernel/msgmax", "r");
+	long max = 0;
+
+	if (fp) {
+		if (fscanf(fp, "%ld", &max) != 1) max = 0;
+		fclose(fp);
+	}
+	return max > 0 ? (size_t)max : 8192;
+}
+
+//batch off ġ ޼ ̰  ġ ش
+static inline size_t batch_put(char *mtext, size_t off, const char *msg, size_t len)
+{
+	uint16_t n = (uint16_t)len;
+
+	memcpy(mtext + off, &n, sizeof(n));
+	memcpy(mtext + off + sizeof(n), msg, len);
+	return off + sizeof(n) + len;
+}
+
+//batch off ġ ޼   ġ ش
+static inline size_t batch_get(const char *mtext, size_t off, const char **msg, size_t *len)
+{
+	uint16_t n;
+
+	memcpy(&n, mtext + off, sizeof(n));
+	*msg = mtext + off + sizeof(n);
+	*len = n;
+	return off + sizeof(n) + n;
+}
+
+#endif
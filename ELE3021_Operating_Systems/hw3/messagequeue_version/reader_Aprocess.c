@@ -4,25 +4,25 @@
 #include <sys/stat.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include "msgbatch.h"
 
 
-struct msgbuf {
-	long msgtype;
-	char mtext[20];
-};
-
 int main() {
 	//queue unique id
 	key_t key_id;
 
-	int i = 0;
-	struct msgbuf rcvbuf;
-	int msgtype = 3;
+	struct msgbuf *rcvbuf;
+	size_t max_size;
+	ssize_t len;
+	size_t off, n;
+	const char *msg;
+	int quit = 0;
 	
 	//queue create
 	//1111 ȣ ϴ ť Ѵ. ̹   شϴ ť ĺ ȯ
-	key_id = msgget((key_t)1111, IPC_CREAT | 0666);
+	key_id = msgget((key_t)MSG_KEY, IPC_CREAT | 0666);
 
 	//н  ޽ 
 	if (key_id == -1) {
@@ -30,19 +30,39 @@ int main() {
 		return 0;
 	}
 
+	//writer msgmax    Ƿ ׸ŭ  ۸ д
+	max_size = msg_max();
+	rcvbuf = malloc(sizeof(struct msgbuf) + max_size);
+	if (rcvbuf == NULL) {
+		perror("malloc error: ");
+		return 0;
+	}
+
 	//receive msg 
-	while(1){
-		//޽ ް н 
-		if (msgrcv(key_id, (void *)&rcvbuf, sizeof(struct msgbuf), msgtype, 0) == -1) {
+	while(!quit){
+		//޽ ް н  (ŸԿ   )
+		len = msgrcv(key_id, (void *)rcvbuf, max_size, 0, 0);
+		if (len == -1) {
 			perror("msgrcv error: ");
 		}
 		
+		else if (rcvbuf->msgtype == MSGTYPE_BATCH) {
+			//  ޼ ϳ 
+			for (off = 0; off < (size_t)len && !quit; ) {
+				off = batch_get(rcvbuf->mtext, off, &msg, &n);
+				//
+				if (n == 1 && msg[0] == 'q') quit = 1;
+				else printf("%.*s\n", (int)n, msg);
+			}
+		}
+
 		else {
 			//
-			if(strcmp(rcvbuf.mtext,"q")==0) break;
+			if(strcmp(rcvbuf->mtext,"q")==0) break;
 			// ǿ ɸ ʾҴٸ ޼ 
-			printf("%s\n", rcvbuf.mtext);
+			printf("%s\n", rcvbuf->mtext);
 		}
 	}
+	free(rcvbuf);
 
 }
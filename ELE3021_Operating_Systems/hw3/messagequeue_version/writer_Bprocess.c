@@ -6,22 +6,75 @@
 #include <sys/stat.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
+#include "msgbatch.h"
 
 
-struct msgbuf {
-	long msgtype;
-	char mtext[20];
-};
+static int key_id;
+static struct msgbuf *sndbuf;
+static size_t max_size;
+static size_t batch_len;	// sndbuf   batch 
 
-int main() {
-	key_t key_id;
-	int i = 0;
-	struct msgbuf sndbuf;
+//msgsnd     ٽ õѴ
+//ť  (EAGAIN)  ʰ 50us 10ms  辿 ٸ
+static int send_retry(size_t len)
+{
+	struct timespec backoff = { 0, 50000 };
+
+	while (msgsnd(key_id, (void *)sndbuf, len, IPC_NOWAIT) == -1) {
+		if (errno == EINTR) continue;
+		if (errno != EAGAIN) {
+			perror("msgsnd error: ");
+			return -1;
+		}
+		nanosleep(&backoff, NULL);
+		if (backoff.tv_nsec < 10000000) backoff.tv_nsec *= 2;
+	}
+	return 0;
+}
+
+//  batch msgsnd   
+static int flush_batch(void)
+{
+	int ret = 0;
+
+	if (batch_len > 0) {
+		sndbuf->msgtype = MSGTYPE_BATCH;
+		ret = send_retry(batch_len);
+	}
+	batch_len = 0;
+	return ret;
+}
+
+//޼ ϳ . batch 忡 msgmax    д
+static int send_msg(const char *msg, size_t len, int batch)
+{
+	if (!batch) {
+		sndbuf->msgtype = MSGTYPE_SINGLE;
+		memcpy(sndbuf->mtext, msg, len);
+		sndbuf->mtext[len] = '\0';
+		return send_retry(len + 1);
+	}
+	if (batch_len + sizeof(uint16_t) + len > max_size && flush_batch() == -1) return -1;
+	batch_len = batch_put(sndbuf->mtext, batch_len, msg, len);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	//-b:   msgsnd    
+	int batch = argc > 1 && strcmp(argv[1], "-b") == 0;
+	char input[4096];
+	char msg[MSG_LINE];
+	size_t len = 0;
+	ssize_t n, i;
+	int quit = 0;
 
 	//create queue
 	//1111 ȣ ϴ ޽ ť  . ̹ ť ִٸ شϴ ť ĺ ȯ
-	key_id = msgget((key_t)1111, IPC_CREAT | 0666);
+	key_id = msgget((key_t)MSG_KEY, IPC_CREAT | 0666);
 
 	//н  ޼ 
 	if (key_id == -1) {
@@ -29,24 +82,36 @@ int main() {
 		return 0;
 	}
 
-	//޽ Ÿ 
-	sndbuf.msgtype = 3;
+	//޼ ϳ msgmax Ŀ ʵ Ѵ
+	max_size = msg_max();
+	sndbuf = malloc(sizeof(struct msgbuf) + max_size);
+	if (sndbuf == NULL) {
+		perror("malloc error: ");
+		return 0;
+	}
 
 	//ؼ input ޾ ޽  reader 
-	while(1){
-		//msg create
-		char msg[20];
-		scanf("%[^\n]s", msg);
-		strcpy(sndbuf.mtext, msg);
-
-		//msg send
-		if (msgsnd(key_id, (void *)&sndbuf, sizeof(struct msgbuf), IPC_NOWAIT) == -1) {
-			perror("msgsnd error: ");
+	//read    ٵ batch ϳ ,  Է ٸ  
+	//׷ Ѳ  Է¸ ̰  ġ  ٷ ޵ȴ
+	while (!quit) {
+		n = read(0, input, sizeof(input));
+		if (n <= 0) {
+			//Է  reader  q 
+			send_msg("q", 1, batch);
+			break;
 		}
-
-		getchar();
-
-		// 
-		if(strcmp(msg,"q")==0) break;
+		for (i = 0; i < n && !quit; i++) {
+			if (input[i] != '\n') {
+				if (len < sizeof(msg)) msg[len++] = input[i];
+				continue;
+			}
+			// 
+			quit = len == 1 && msg[0] == 'q';
+			if (send_msg(msg, len, batch) == -1) return 0;
+			len = 0;
+		}
+		if (flush_batch() == -1) return 0;
 	}
+	flush_batch();
+	free(sndbuf);
 }
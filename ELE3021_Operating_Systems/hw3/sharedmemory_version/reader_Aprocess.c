@@ -8,16 +8,22 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <time.h>
+#include "shmring.h"
 
 
 
-int main() {
+int main(int argc, char *argv[]) {
 	int shmid;
 	void *shmaddr;
 	int ret;
+	//-q: ޼  ʰ   ӵ Ѵ
+	int quiet = argc > 1 && strcmp(argv[1], "-q") == 0;
+	unsigned long count = 0;
+	struct timespec start, end;
 	//get shared memory id
 	//Ű    ޸ id ޾ƿ
-	shmid = shmget((key_t)1234, 1024, IPC_CREAT | 0666);
+	shmid = shmget((key_t)RING_KEY, sizeof(struct shmring), IPC_CREAT | 0666);
 	//н  ޼
 	if (shmid == -1) {
 		perror("shared memory access is failed\n");
@@ -34,23 +40,32 @@ int main() {
 	}
 
 	//޽ ݺ о´
-	char *read;
+	//   ring_peek ȿ   CPU  ʴ´
+	struct ring_reader reader;
+	struct ring_slot *slot;
+	ring_reader_init(&reader, (struct shmring *)shmaddr);
 	while(1){
-		// ޸𸮿  о´
-		read=(char *)shmaddr;
-		// ΰ̶ Ѿ
-		if(strcmp("\0",read)==0) continue;
+		// ޸   ʰ ״ д´
+		slot = ring_peek(&reader);
+		if (count == 0) clock_gettime(CLOCK_MONOTONIC, &start);
 
 		//
-		if(strcmp(read,"q")==0){
-			 break;
+		if(slot->len == 1 && slot->data[0] == 'q'){
+			ring_release(&reader);
+			break;
 		}
 
 		//޼ 
-		printf("data read from shared memory: %s\n",read);
-		// ޼ Ѵ
-		strcpy((char*)shmaddr, "\0");
-	}	
+		if (!quiet) printf("data read from shared memory: %.*s\n", (int)slot->len, slot->data);
+		count++;
+		//  writer ش
+		ring_release(&reader);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (quiet) {
+		double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+		printf("%lu messages, %.0f messages/s\n", count, sec > 0 ? count / sec : 0.0);
+	}
 	
 	//detach the shared memory
 	ret = shmdt(shmaddr);
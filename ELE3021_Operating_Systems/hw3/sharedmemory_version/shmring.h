@@ -0,0 +1,148 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+ *  ޸  single-producer/single-consumer  
+ *
+ * head writer, tail reader ٲٴ  ϴ ḭ̄
+ * head - tail ť ִ ޽ ̴.  ٸ ĳ ο ξ
+ *    ٸ   ȿȭ ʴ´.
+ *  ä head release ø reader acquire  ڿ
+ *   ̹Ƿ lock ʿ  (tail  ).
+ *
+ * ų   ٻڰ  ʰ head/tail ü futex ٸ.
+ * ٸ  *_waiting  ٽ Ȯ  ,  
+ * ī͸ ø  *_waiting    װ  FUTEX_WAKE θ.
+ *       FUTEX_WAKE θ ʵ   .
+ *  μ ϹǷ FUTEX_PRIVATE_FLAG  ʴ´.
+ *
+ * shmget  ׸Ʈ 0 äǷ head = tail = 0   Ѵ.
+ */
+#define RING_KEY 1234
+#define RING_CACHELINE 64
+#define RING_SLOTS 1024			// 2 ŵ
+#define RING_MASK (RING_SLOTS - 1)
+#define RING_DATA_SIZE (RING_CACHELINE - sizeof(uint32_t))
+
+// ϳ ĳ  ϳ̴
+struct ring_slot {
+	uint32_t len;
+	char data[RING_DATA_SIZE];
+};
+
+struct shmring {
+	_Alignas(RING_CACHELINE) _Atomic uint32_t head;	//   ġ (writer)
+	_Alignas(RING_CACHELINE) _Atomic uint32_t tail;	//   ġ (reader)
+	_Alignas(RING_CACHELINE) _Atomic uint32_t reader_waiting;
+	_Atomic uint32_t writer_waiting;
+	_Alignas(RING_CACHELINE) struct ring_slot slots[RING_SLOTS];
+};
+
+// μ ڱ  īͿ  ī    ־
+// ų áٰ    ĳ  д´
+struct ring_writer {
+	struct shmring *r;
+	uint32_t head;
+	uint32_t tail_cache;
+};
+
+struct ring_reader {
+	struct shmring *r;
+	uint32_t tail;
+	uint32_t head_cache;
+};
+
+static inline void ring_futex_wait(_Atomic uint32_t *addr, uint32_t val)
+{
+	//*addr ̹ val ƴϸ EAGAIN ٷ ƿ´
+	syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static inline void ring_futex_wake(_Atomic uint32_t *addr)
+{
+	syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static inline void ring_writer_init(struct ring_writer *w, struct shmring *r)
+{
+	w->r = r;
+	w->head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	w->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+static inline void ring_reader_init(struct ring_reader *rd, struct shmring *r)
+{
+	rd->r = r;
+	rd->tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	rd->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+}
+
+//   ش.    reader   .
+//Կ    ring_commit θ
+static inline struct ring_slot *ring_reserve(struct ring_writer *w)
+{
+	struct shmring *r = w->r;
+
+	while (w->head - w->tail_cache == RING_SLOTS) {
+		w->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+		if (w->head - w->tail_cache != RING_SLOTS) break;
+
+		atomic_store(&r->writer_waiting, 1);
+		w->tail_cache = atomic_load(&r->tail);
+		if (w->head - w->tail_cache == RING_SLOTS)
+			ring_futex_wait(&r->tail, w->tail_cache);
+		atomic_store_explicit(&r->writer_waiting, 0, memory_order_relaxed);
+	}
+	return &r->slots[w->head & RING_MASK];
+}
+
+static inline void ring_commit(struct ring_writer *w)
+{
+	struct shmring *r = w->r;
+
+	atomic_store_explicit(&r->head, ++w->head, memory_order_release);
+	//head ø Ͱ reader_waiting д   Ѿ ⸦ ġ ʴ´
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&r->reader_waiting, memory_order_relaxed) &&
+	    atomic_exchange_explicit(&r->reader_waiting, 0, memory_order_relaxed))
+		ring_futex_wake(&r->head);
+}
+
+//   ش.   writer   .
+//    ring_release θ
+static inline struct ring_slot *ring_peek(struct ring_reader *rd)
+{
+	struct shmring *r = rd->r;
+
+	while (rd->head_cache == rd->tail) {
+		rd->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+		if (rd->head_cache != rd->tail) break;
+
+		atomic_store(&r->reader_waiting, 1);
+		rd->head_cache = atomic_load(&r->head);
+		if (rd->head_cache == rd->tail)
+			ring_futex_wait(&r->head, rd->head_cache);
+		atomic_store_explicit(&r->reader_waiting, 0, memory_order_relaxed);
+	}
+	return &r->slots[rd->tail & RING_MASK];
+}
+
+static inline void ring_release(struct ring_reader *rd)
+{
+	struct shmring *r = rd->r;
+
+	atomic_store_explicit(&r->tail, ++rd->tail, memory_order_release);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&r->writer_waiting, memory_order_relaxed) &&
+	    atomic_exchange_explicit(&r->writer_waiting, 0, memory_order_relaxed))
+		ring_futex_wake(&r->tail);
+}
+
+#endif
@@ -8,17 +8,19 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include "shmring.h"
 
 
 
-int main() {
+int main(int argc, char *argv[]) {
 	int shmid;
 	void *shmaddr;
-	int i,ret;
+	int ret;
+	long i, n;
 
 	//make a shared memory
 	//key   ޸ id 
-	shmid = shmget((key_t)1234, 1024, IPC_CREAT | 0666);
+	shmid = shmget((key_t)RING_KEY, sizeof(struct shmring), IPC_CREAT | 0666);
 	//н  ޼
 	if (shmid == -1) {
 		perror("shared memory access is failed\n");
@@ -35,15 +37,34 @@ int main() {
 	}
 
 
-	char input[50];
+	struct ring_writer writer;
+	struct ring_slot *slot;
+	ring_writer_init(&writer, (struct shmring *)shmaddr);
+
+	//ڷ  ָ ׸ŭ ޼   (ó )
+	n = argc > 1 ? atol(argv[1]) : 0;
+	for (i = 0; i < n; i++) {
+		slot = ring_reserve(&writer);
+		slot->len = snprintf(slot->data, RING_DATA_SIZE, "message %ld", i);
+		ring_commit(&writer);
+	}
+
 	//ݺ ڿ input ޾Ƽ ش   ޸𸮿 .
-	while(1){
-		scanf("%[^\n]s",input);
-		strcpy((char*)shmaddr, input);
+	//Է   Կ ٷ Ƿ   ʴ´.
+	while(n == 0){
+		slot = ring_reserve(&writer);
+		if (fgets(slot->data, RING_DATA_SIZE, stdin) == NULL) strcpy(slot->data, "q");
+		slot->len = strcspn(slot->data, "\n");
+		ring_commit(&writer);
 
 		// 
-		if(strcmp(input,"q")==0) break;
-		getchar();
+		if(slot->len == 1 && slot->data[0] == 'q') break;
+	}
+	if (n > 0) {
+		slot = ring_reserve(&writer);
+		slot->len = 1;
+		slot->data[0] = 'q';
+		ring_commit(&writer);
 	}
 
 
@@ -1,42 +1,62 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <pthread.h>
+#include "padded.h"
 #define ARGUMENT_NUMBER 20
-long long result[ARGUMENT_NUMBER];
-pthread_t threadID[ARGUMENT_NUMBER];
+#define LOOP_NUM 25000000
 long long result_sum=0;
 
-void * ThreadFunc(void* n) {
+// number ڱ   number LOOP_NUM Ѵ
+void ThreadFunc(int number, long long *acc, void *arg) {
 	long long i;
-	long long number = *((long long *)n);
-	printf("number = %lld\n", number);
-	for(i=0;i<25000000;i++){
-		result[number]+= number;
+	printf("number = %d\n", number);
+	for(i=0;i<LOOP_NUM;i++){
+		*acc += number;
 	}
 }
-int main() {
-	long long argument[ARGUMENT_NUMBER];
-	long long i;
 
-	for (i = 0; i < ARGUMENT_NUMBER; i++)
-	{
-		argument[i] = i;
+//ġũ: Ź ޸𸮿  volatile Ѵ (庰 踦   )
+void BenchFunc(int number, long long *acc, void *arg) {
+	volatile long long *v = acc;
+	long long i;
+	for(i=0;i<LOOP_NUM;i++){
+		*v += number;
 	}
+}
 
-	for (i = 0; i < ARGUMENT_NUMBER; i++)
-	{
-		pthread_create(&(threadID[i]),NULL,ThreadFunc,(void*)&argument[i]);
-	}
-	printf("Main Thread is waiting for Child Thread!\n");
+double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
 
-	for(i=0;i<ARGUMENT_NUMBER; i++){
-		pthread_join(threadID[i],NULL);
-	}
+//  پ ִ long long 迭 ĳ θ  ĭ 迭 ؼ ð Ѵ
+void bench() {
+	long long unpadded[ARGUMENT_NUMBER];
+	double start;
+	long long sum;
+
+	start = now();
+	sum = parallel_reduce_slots(ARGUMENT_NUMBER, BenchFunc, NULL, unpadded, 1);
+	printf("unpadded: result = %lld, %.3f sec\n", sum, now() - start);
+
+	start = now();
+	sum = parallel_reduce(ARGUMENT_NUMBER, BenchFunc, NULL);
+	printf("padded:   result = %lld, %.3f sec\n", sum, now() - start);
+}
 
-	for(i=0;i<ARGUMENT_NUMBER;i++){
-		result_sum+=result[i];
+int main(int argc, char *argv[]) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench();
+		return 0;
 	}
 
+	//帶 ĳ  ϳ¥   ְ  ģ
+	printf("Main Thread is waiting for Child Thread!\n");
+	result_sum = parallel_reduce(ARGUMENT_NUMBER, ThreadFunc, NULL);
+
 	printf("result = %lld\n", result_sum);
 	return 0;
 
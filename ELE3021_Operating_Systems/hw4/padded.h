@@ -0,0 +1,73 @@
+#ifndef PADDED_H
+#define PADDED_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/*
+ * 帶    
+ * long long 迭 庰  ĭ  ̿ 8ĭ  ĳ ο ־
+ *  ٸ  µ   ٸ ھ ĳ  ȿȭѴ
+ * (false sharing). ĭ ĳ  ϳ ° ָ   .
+ */
+#define CACHELINE 64
+
+struct padded_counter {
+	_Alignas(CACHELINE) long long value;
+};
+
+// id ڱ   *acc  Ѵ
+typedef void (*reduce_body)(int id, long long *acc, void *arg);
+
+struct reduce_task {
+	pthread_t tid;
+	int id;
+	reduce_body body;
+	void *arg;
+	long long *acc;
+};
+
+static void *reduce_thread(void *p)
+{
+	struct reduce_task *t = (struct reduce_task *)p;
+	t->body(t->id, t->acc, t->arg);
+	return NULL;
+}
+
+//slots[id * stride] id       ؼ ش
+static inline long long parallel_reduce_slots(int nthreads, reduce_body body, void *arg,
+	long long *slots, size_t stride)
+{
+	struct reduce_task *task = malloc(sizeof(*task) * nthreads);
+	long long sum = 0;
+	int i;
+
+	for (i = 0; i < nthreads; i++) {
+		slots[i * stride] = 0;
+		task[i].id = i;
+		task[i].body = body;
+		task[i].arg = arg;
+		task[i].acc = &slots[i * stride];
+		pthread_create(&task[i].tid, NULL, reduce_thread, &task[i]);
+	}
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(task[i].tid, NULL);
+		sum += slots[i * stride];
+	}
+	free(task);
+	return sum;
+}
+
+//nthreads 尡  padded_counter   
+static inline long long parallel_reduce(int nthreads, reduce_body body, void *arg)
+{
+	struct padded_counter *c = aligned_alloc(CACHELINE, sizeof(*c) * nthreads);
+	long long sum = parallel_reduce_slots(nthreads, body, arg, &c->value,
+		sizeof(struct padded_counter) / sizeof(long long));
+
+	free(c);
+	return sum;
+}
+
+#endif
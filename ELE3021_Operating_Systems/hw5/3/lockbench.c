@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "locks.h"
+
+/*
+ * lock  ġũ
+ * workers (-p μ)  lock    count ø.
+ * lock ɸ ð, lock   ð,     Ѵ.
+ *	peterson     - 1  seq_cst Peterson (2 )
+ *	peterson-raw - 2  Ϲ  ޸ Peterson (2 ,  Ʋ  ִ)
+ *	ticket, mcs, futex - locks.h
+ *	pthread      - pthread_mutex (-p PTHREAD_PROCESS_SHARED)
+ *
+ * : lockbench [-n count] [-w workers,...] [-p]
+ */
+
+#define MAX_WORKERS MCS_MAX
+
+// lock     ΰ -p   mmap 
+struct shared {
+	struct ticket_lock ticket;
+	struct mcs_lock mcs;
+	struct futex_mutex futex;
+	pthread_mutex_t pthread;
+	//1  Peterson
+	_Atomic int turn, flag[2];
+	//2  Peterson (Ϲ , Ϸ    ʵ volatile δ)
+	volatile int raw_turn, raw_flag[2];
+	_Alignas(LOCK_CACHELINE) long counter;
+};
+
+enum kind { PETERSON, PETERSON_RAW, TICKET, MCS, FUTEX, PTHREAD, NKINDS };
+static const char *names[NKINDS] = { "peterson", "peterson-raw", "ticket", "mcs", "futex", "pthread" };
+
+static struct shared *sh;
+static enum kind cur;
+static long count = 1000000;
+
+//Peterson   ٸ lockó spin_wait ƾ CPU ڶ 
+//밡   ִ (׷  time slice   )
+static void lock(int id)
+{
+	unsigned spins = 0;
+
+	switch (cur) {
+	case PETERSON:
+		atomic_store(&sh->flag[id], 1);
+		atomic_store(&sh->turn, 1 - id);
+		while (atomic_load(&sh->flag[1 - id]) && atomic_load(&sh->turn) == 1 - id)
+			spin_wait(&spins);
+		break;
+	case PETERSON_RAW:
+		sh->raw_flag[id] = 1;
+		sh->raw_turn = 1 - id;
+		while (sh->raw_flag[1 - id] && sh->raw_turn == 1 - id)
+			spin_wait(&spins);
+		break;
+	case TICKET: ticket_lock(&sh->ticket); break;
+	case MCS: mcs_lock(&sh->mcs, id); break;
+	case FUTEX: futex_mutex_lock(&sh->futex); break;
+	case PTHREAD: pthread_mutex_lock(&sh->pthread); break;
+	default: break;
+	}
+}
+
+static void unlock(int id)
+{
+	switch (cur) {
+	case PETERSON: atomic_store(&sh->flag[id], 0); break;
+	case PETERSON_RAW: sh->raw_flag[id] = 0; break;
+	case TICKET: ticket_unlock(&sh->ticket); break;
+	case MCS: mcs_unlock(&sh->mcs, id); break;
+	case FUTEX: futex_mutex_unlock(&sh->futex); break;
+	case PTHREAD: pthread_mutex_unlock(&sh->pthread); break;
+	default: break;
+	}
+}
+
+static void work(int id)
+{
+	long i;
+
+	for (i = 0; i < count; i++) {
+		lock(id);
+		sh->counter++;
+		unlock(id);
+	}
+}
+
+static void *thread_main(void *arg)
+{
+	work((int)(long)arg);
+	return NULL;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//lock ϳ workers     Ѵ
+static void run(enum kind k, int workers, int procs)
+{
+	pthread_t tid[MAX_WORKERS];
+	pid_t pid[MAX_WORKERS];
+	pthread_mutexattr_t attr;
+	double start, sec;
+	int i;
+
+	//shmget  ޸ó 0 ä °  lock ʱ ̴
+	memset(sh, 0, sizeof(*sh));
+	futex_mutex_init(&sh->futex, procs);
+	pthread_mutexattr_init(&attr);
+	if (procs) pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutex_init(&sh->pthread, &attr);
+	pthread_mutexattr_destroy(&attr);
+	cur = k;
+
+	start = now();
+	for (i = 0; i < workers; i++) {
+		if (procs) {
+			pid[i] = fork();
+			if (pid[i] == 0) {
+				work(i);
+				_exit(0);
+			}
+		}
+		else pthread_create(&tid[i], NULL, thread_main, (void *)(long)i);
+	}
+	for (i = 0; i < workers; i++) {
+		if (procs) waitpid(pid[i], NULL, 0);
+		else pthread_join(tid[i], NULL);
+	}
+	sec = now() - start;
+	pthread_mutex_destroy(&sh->pthread);
+
+	printf("%-13s %7d %9.3f %10.1f %12ld %12ld%s\n", names[k], workers, sec,
+		sec * 1e9 / ((double)count * workers), sh->counter, count * workers,
+		sh->counter == count * workers ? "" : "  (lost updates)");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+	char list[256] = "1,2,4,8";
+	int procs = 0, opt, workers, k;
+	char *tok;
+
+	while ((opt = getopt(argc, argv, "n:w:p")) != -1) {
+		switch (opt) {
+		case 'n': count = atol(optarg); break;
+		case 'w': snprintf(list, sizeof(list), "%s", optarg); break;
+		case 'p': procs = 1; break;
+		default:
+			fprintf(stderr, "usage: %s [-n count] [-w workers,...] [-p]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (sh == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	printf("%s, %ld per worker\n", procs ? "processes" : "threads", count);
+	printf("%-13s %7s %9s %10s %12s %12s\n", "lock", "workers", "sec", "ns/lock", "actual", "expected");
+	for (tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+		workers = atoi(tok);
+		if (workers < 1 || workers > MAX_WORKERS) continue;
+		for (k = 0; k < NKINDS; k++) {
+			//Peterson    lock̴
+			if ((k == PETERSON || k == PETERSON_RAW) && workers != 2) continue;
+			run(k, workers, procs);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+#ifndef LOCKS_H
+#define LOCKS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+ *      ִ lock
+ *	ticket_lock - ȣǥ   spin lock (ϴ)
+ *	mcs_lock    -  ڱ 忡 ٸ ť lock (ڰ Ƶ ĳ  ϳ )
+ *	futex_mutex -  ƺ  Ǹ futex  mutex
+ *
+ * 1  Peterson lock   seq_cst lock ʿ 
+ *   acquire   release̴. Ӱ   б/Ⱑ
+ * lock   ʴ ͸ ϸ ȴ.
+ *
+ *  lock ͸  ʰ 0 ʱȭϸ Ǯ ¶
+ * shmget/mmap   ޸𸮿 ΰ  μ    ִ.
+ * (MCS  嵵   ȣ Ų)
+ */
+#define LOCK_CACHELINE 64
+#define LOCK_SPIN 128		// ̸ŭ Ƶ  Ǹ CPU 纸Ѵ
+#define MCS_MAX 64		// mcs_lock   ִ /μ 
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+//spin   .   lock   CPU 򵵷 纸Ѵ
+static inline void spin_wait(unsigned *spins)
+{
+	if (++*spins < LOCK_SPIN) cpu_relax();
+	else sched_yield();
+}
+
+/* ticket lock */
+struct ticket_lock {
+	_Alignas(LOCK_CACHELINE) _Atomic uint32_t next;	//    ȣ
+	_Alignas(LOCK_CACHELINE) _Atomic uint32_t serving;	//    ִ ȣ
+};
+
+static inline void ticket_lock(struct ticket_lock *l)
+{
+	uint32_t me = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+	unsigned spins = 0;
+
+	while (atomic_load_explicit(&l->serving, memory_order_acquire) != me)
+		spin_wait(&spins);
+}
+
+static inline void ticket_unlock(struct ticket_lock *l)
+{
+	//serving lock  ʸ ٲٹǷ б relaxed ϴ
+	uint32_t s = atomic_load_explicit(&l->serving, memory_order_relaxed);
+	atomic_store_explicit(&l->serving, s + 1, memory_order_release);
+}
+
+/* MCS lock: id(0 ~ MCS_MAX-1) 尡 ϳ ְ, ȣ id + 1 (0 ) */
+struct mcs_node {
+	_Alignas(LOCK_CACHELINE) _Atomic uint32_t next;	//  ڿ  
+	_Atomic uint32_t locked;			// 1̸  尡 Ǯ ֱ⸦ ٸ
+};
+
+struct mcs_lock {
+	_Alignas(LOCK_CACHELINE) _Atomic uint32_t tail;	//   
+	struct mcs_node node[MCS_MAX];
+};
+
+static inline void mcs_lock(struct mcs_lock *l, int id)
+{
+	struct mcs_node *n = &l->node[id];
+	uint32_t prev;
+	unsigned spins = 0;
+
+	atomic_store_explicit(&n->next, 0, memory_order_relaxed);
+	atomic_store_explicit(&n->locked, 1, memory_order_relaxed);
+	//  . release:  ʱȭ  忡  Ѵ
+	prev = atomic_exchange_explicit(&l->tail, id + 1, memory_order_acq_rel);
+	if (prev == 0) return;
+
+	atomic_store_explicit(&l->node[prev - 1].next, id + 1, memory_order_release);
+	while (atomic_load_explicit(&n->locked, memory_order_acquire))
+		spin_wait(&spins);
+}
+
+static inline void mcs_unlock(struct mcs_lock *l, int id)
+{
+	struct mcs_node *n = &l->node[id];
+	uint32_t next = atomic_load_explicit(&n->next, memory_order_acquire);
+	uint32_t self = id + 1;
+	unsigned spins = 0;
+
+	if (next == 0) {
+		//ڿ ƹ  lock 
+		if (atomic_compare_exchange_strong_explicit(&l->tail, &self, 0,
+				memory_order_release, memory_order_relaxed))
+			return;
+		//     next  ʾҴ
+		while ((next = atomic_load_explicit(&n->next, memory_order_acquire)) == 0)
+			spin_wait(&spins);
+	}
+	atomic_store_explicit(&l->node[next - 1].locked, 0, memory_order_release);
+}
+
+/*
+ * futex mutex (Drepper, "Futexes Are Tricky" mutex3)
+ * state: 0 = Ǯ, 1 = , 2 =  + ٸ    
+ *   state 1̾ ƹ ڰ  Ƿ ý  .
+ * private 0̸ μ ̿   ִ futex 
+ */
+struct futex_mutex {
+	_Atomic uint32_t state;
+	uint32_t private_;
+};
+
+static inline void futex_mutex_init(struct futex_mutex *m, int pshared)
+{
+	atomic_store_explicit(&m->state, 0, memory_order_relaxed);
+	m->private_ = pshared ? 0 : FUTEX_PRIVATE_FLAG;
+}
+
+static inline void futex_mutex_lock(struct futex_mutex *m)
+{
+	uint32_t c = 0;
+	int i;
+
+	//ª Ӱ ̸   ǮǷ ݸ ƺ
+	for (i = 0; i < LOCK_SPIN; i++) {
+		c = 0;
+		if (atomic_compare_exchange_weak_explicit(&m->state, &c, 1,
+				memory_order_acquire, memory_order_relaxed))
+			return;
+		if (c == 2) break;
+		cpu_relax();
+	}
+	if (c != 2) c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+	while (c != 0) {
+		syscall(SYS_futex, (uint32_t *)&m->state, FUTEX_WAIT | m->private_, 2, NULL, NULL, 0);
+		c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+	}
+}
+
+static inline void futex_mutex_unlock(struct futex_mutex *m)
+{
+	if (atomic_fetch_sub_explicit(&m->state, 1, memory_order_release) != 1) {
+		atomic_store_explicit(&m->state, 0, memory_order_release);
+		syscall(SYS_futex, (uint32_t *)&m->state, FUTEX_WAKE | m->private_, 1, NULL, NULL, 0);
+	}
+}
+
+#endif
@@ -1,4 +1,4 @@
-
+#define _GNU_SOURCE
 #include <semaphore.h>
 #include <pthread.h>
 #include <sys/stat.h>
@@ -7,24 +7,28 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include "rwlock.h"
 
 #define COUNTING_NUMBER 50
 void writer();
 void reader();
 
-sem_t writer_lock;
-sem_t reader_count_lock;
+//reader/writer  lock (å  ڷ )
+struct rwlock rw;
 
 long cur_writer=0;
 int cur_count = 0;
-int reader_count = 0;
 
 
-int main() {
+int main(int argc, char *argv[]) {
 	int i;
-	// ʱȭ
-	sem_init(&writer_lock, 0, 1);
-	sem_init(&reader_count_lock, 0, 1);
+	//lock ʱȭ: reader( reader 켱), writer, fair(⺻), sharded
+	int policy = argc > 1 ? rw_policy_parse(argv[1]) : RW_PHASE_FAIR;
+	if (policy < 0) {
+		printf("usage: %s [reader|writer|fair|sharded]\n", argv[0]);
+		return 0;
+	}
+	rw_init(&rw, (enum rw_policy)policy);
 
 	//2 reader 5 writer 
 	pthread_t thread_writer_0, thread_writer_1, thread_writer_2, thread_writer_3, thread_writer_4;
@@ -50,9 +54,8 @@ int main() {
 	pthread_join(thread_reader_0, NULL);
 	pthread_join(thread_reader_1, NULL);
 
-	// ı
-	sem_destroy(&writer_lock);
-	sem_destroy(&reader_count_lock);
+	//lock ı
+	rw_destroy(&rw);
 
 }
 
@@ -65,7 +68,7 @@ void writer()
 	{
 		usleep(100000);
 		//lock
-		sem_wait(&writer_lock);
+		rw_wrlock(&rw);
 
 		//critical
 		now_count++;
@@ -74,7 +77,7 @@ void writer()
 		//printf("<Writer> writer : %ld - total count: %d\n",cur_writer,cur_count);
 
 		//unlock
-		sem_post(&writer_lock);
+		rw_wrunlock(&rw);
 		
 	}
 		
@@ -89,24 +92,15 @@ void reader()
 	{
 		usleep(30000);
 		//lock
-		sem_wait(&reader_count_lock);
-		//reader  ŭ 
-		reader_count++;
-		//ó  reader writer_lock ȹѴ
-		if (reader_count == 1) sem_wait(&writer_lock);
-		sem_post(&reader_count_lock);
+		//reader   writer  å  ٸ
+		int tok = rw_rdlock(&rw);
 
 		//critical
 		printf("<Reader>: %ld => <Recent writer>: %ld - total count : %d\n", pthread_self(),cur_writer, cur_count);
 		
 
-		//unlcok
-		sem_wait(&reader_count_lock);
-		//critical ִ reader  ϳ δ
-		reader_count--;
-		// ڽ critical ȿ ϴ  reader writer lock ش.
-		if (reader_count == 0) sem_post(&writer_lock);
-		sem_post(&reader_count_lock);
+		//unlock
+		rw_rdunlock(&rw, tok);
 		
 	}
 }
@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "rwlock.h"
+
+/*
+ * readers-writers lock å 
+ * reader  ʰ б lock   迭 а, writer interval
+ *  lock ûѴ. å duration  
+ *	reader ó (ʴ б Ƚ)
+ *	writer  ( lock ûؼ  , p50/p99/max)
+ *  Ѵ. reader ó Ƶ writer  ũ writer  ִ ̴
+ *
+ * : rwbench [-r readers] [-w writers] [-d seconds] [-i interval_us]
+ */
+
+#define DATA_SIZE 64
+
+struct reader_stat {
+	_Alignas(RW_CACHELINE) long ops;
+};
+
+static struct rwlock lock;
+static long data[DATA_SIZE];
+static _Atomic int stop;
+static int interval_us = 1000;
+static struct reader_stat *rstat;
+static double **wlat;		// writer   (us)
+static long *wcount;
+static long wmax;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void *reader(void *arg)
+{
+	struct reader_stat *st = &rstat[(long)arg];
+	volatile long sink;
+	long sum;
+	int i, tok;
+
+	while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+		tok = rw_rdlock(&lock);
+		for (sum = 0, i = 0; i < DATA_SIZE; i++) sum += data[i];
+		rw_rdunlock(&lock, tok);
+		sink = sum;
+		st->ops++;
+	}
+	(void)sink;
+	return NULL;
+}
+
+static void *writer(void *arg)
+{
+	long id = (long)arg;
+	double t;
+	int i;
+
+	while (!atomic_load_explicit(&stop, memory_order_relaxed) && wcount[id] < wmax) {
+		usleep(interval_us);
+		t = now();
+		rw_wrlock(&lock);
+		wlat[id][wcount[id]++] = (now() - t) * 1e6;
+		for (i = 0; i < DATA_SIZE; i++) data[i]++;
+		rw_wrunlock(&lock);
+	}
+	return NULL;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+int main(int argc, char *argv[]) {
+	static const char *names[] = { "reader", "writer", "fair", "sharded" };
+	int readers = 4, writers = 2, opt, p, i;
+	double duration = 1.0, start, sec;
+	pthread_t *rt, *wt;
+	double *all;
+	long ops, n;
+
+	while ((opt = getopt(argc, argv, "r:w:d:i:")) != -1) {
+		switch (opt) {
+		case 'r': readers = atoi(optarg); break;
+		case 'w': writers = atoi(optarg); break;
+		case 'd': duration = atof(optarg); break;
+		case 'i': interval_us = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-r readers] [-w writers] [-d seconds] [-i interval_us]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	rt = malloc(sizeof(pthread_t) * readers);
+	wt = malloc(sizeof(pthread_t) * writers);
+	rstat = aligned_alloc(RW_CACHELINE, sizeof(struct reader_stat) * readers);
+	wlat = malloc(sizeof(double *) * writers);
+	wcount = malloc(sizeof(long) * writers);
+	wmax = (long)(duration * 1e6 / (interval_us > 0 ? interval_us : 1)) + 16;
+	for (i = 0; i < writers; i++) wlat[i] = malloc(sizeof(double) * wmax);
+	all = malloc(sizeof(double) * wmax * (writers > 0 ? writers : 1));
+
+	printf("%d readers, %d writers (every %d us), %.1f s\n", readers, writers, interval_us, duration);
+	printf("%-8s %14s %8s %10s %10s %10s\n", "policy", "reads/s", "writes", "p50(us)", "p99(us)", "max(us)");
+	for (p = RW_READER_PREF; p <= RW_SHARDED; p++) {
+		rw_init(&lock, (enum rw_policy)p);
+		atomic_store(&stop, 0);
+		memset(rstat, 0, sizeof(struct reader_stat) * readers);
+		memset(wcount, 0, sizeof(long) * writers);
+
+		start = now();
+		for (i = 0; i < readers; i++) pthread_create(&rt[i], NULL, reader, (void *)(long)i);
+		for (i = 0; i < writers; i++) pthread_create(&wt[i], NULL, writer, (void *)(long)i);
+		usleep((useconds_t)(duration * 1e6));
+		atomic_store(&stop, 1);
+		for (i = 0; i < readers; i++) pthread_join(rt[i], NULL);
+		for (i = 0; i < writers; i++) pthread_join(wt[i], NULL);
+		sec = now() - start;
+		rw_destroy(&lock);
+
+		for (ops = 0, i = 0; i < readers; i++) ops += rstat[i].ops;
+		for (n = 0, i = 0; i < writers; i++) {
+			memcpy(all + n, wlat[i], sizeof(double) * wcount[i]);
+			n += wcount[i];
+		}
+		qsort(all, n, sizeof(double), cmp_double);
+		printf("%-8s %14.0f %8ld", names[p], ops / sec, n);
+		if (n > 0) printf(" %10.1f %10.1f %10.1f", all[n / 2], all[(long)(0.99 * (n - 1))], all[n - 1]);
+		printf("\n");
+		fflush(stdout);
+	}
+	return 0;
+}
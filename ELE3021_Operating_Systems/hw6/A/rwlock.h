@@ -0,0 +1,200 @@
+#ifndef RWLOCK_H
+#define RWLOCK_H
+
+//sched_getcpu Ƿ  Ϻ  _GNU_SOURCE ؾ Ѵ
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/*
+ * å   ִ readers-writers lock
+ *	RW_READER_PREF - reader ϳ   reader  (hw6_A  ,
+ *	                 reader   writer ´)
+ *	RW_WRITER_PREF - ٸ writer   reader ٸ (reader   ִ)
+ *	RW_PHASE_FAIR  - б phase  phase  ´. writer    reader
+ *	                 writer ϳ  ٷ , writer  а ִ reader
+ *	                 ٸ.  ʵ  ʴ´
+ *	RW_SHARDED     - бⰡ κ Ϳ. reader ڱ cpu ī͸ ø Ƿ
+ *	                 reader  ĳ  ΰ  ʴ´. writer  īͰ
+ *	                 0   ٸǷ  δ (writer 켱)
+ *
+ * rw_rdlock   rw_rdunlock Ѱܾ Ѵ (RW_SHARDED  ī)
+ */
+#define RW_SHARDS 16
+#define RW_CACHELINE 64
+
+enum rw_policy { RW_READER_PREF, RW_WRITER_PREF, RW_PHASE_FAIR, RW_SHARDED };
+
+struct rw_shard {
+	_Alignas(RW_CACHELINE) _Atomic long readers;
+};
+
+struct rwlock {
+	enum rw_policy policy;
+	pthread_mutex_t m;
+	pthread_cond_t readers_ok, writers_ok;
+	int active_readers;
+	int waiting_readers, waiting_writers;
+	int writer_active;
+	unsigned long phase;		//  phase   1 
+	int released_readers;		//    phase ڿ   reader 
+	/* RW_SHARDED */
+	pthread_mutex_t writer_m;	// writer 
+	_Atomic int writer_flag;
+	struct rw_shard shard[RW_SHARDS];
+};
+
+static inline void rw_init(struct rwlock *l, enum rw_policy policy)
+{
+	memset(l, 0, sizeof(*l));
+	l->policy = policy;
+	pthread_mutex_init(&l->m, NULL);
+	pthread_mutex_init(&l->writer_m, NULL);
+	pthread_cond_init(&l->readers_ok, NULL);
+	pthread_cond_init(&l->writers_ok, NULL);
+}
+
+static inline void rw_destroy(struct rwlock *l)
+{
+	pthread_mutex_destroy(&l->m);
+	pthread_mutex_destroy(&l->writer_m);
+	pthread_cond_destroy(&l->readers_ok);
+	pthread_cond_destroy(&l->writers_ok);
+}
+
+static inline int rw_rdlock_sharded(struct rwlock *l)
+{
+	int cpu = sched_getcpu();
+	int s = (cpu < 0 ? 0 : cpu) % RW_SHARDS;
+
+	while (1) {
+		//ī͸  ø writer_flag . writer ݴ  ϹǷ
+		//(  seq_cst)   ϳ ݵ 븦 
+		atomic_fetch_add(&l->shard[s].readers, 1);
+		if (!atomic_load(&l->writer_flag)) return s;
+		atomic_fetch_sub_explicit(&l->shard[s].readers, 1, memory_order_release);
+
+		pthread_mutex_lock(&l->m);
+		while (atomic_load_explicit(&l->writer_flag, memory_order_relaxed))
+			pthread_cond_wait(&l->readers_ok, &l->m);
+		pthread_mutex_unlock(&l->m);
+	}
+}
+
+static inline int rw_rdlock(struct rwlock *l)
+{
+	unsigned long phase;
+
+	if (l->policy == RW_SHARDED) return rw_rdlock_sharded(l);
+
+	pthread_mutex_lock(&l->m);
+	switch (l->policy) {
+	case RW_READER_PREF:
+		while (l->writer_active)
+			pthread_cond_wait(&l->readers_ok, &l->m);
+		break;
+	case RW_WRITER_PREF:
+		while (l->writer_active || l->waiting_writers)
+			pthread_cond_wait(&l->readers_ok, &l->m);
+		break;
+	case RW_PHASE_FAIR:
+		//writer    phase ϳ   ٸ
+		if (l->writer_active || l->waiting_writers) {
+			phase = l->phase;
+			l->waiting_readers++;
+			while (l->phase == phase)
+				pthread_cond_wait(&l->readers_ok, &l->m);
+			l->waiting_readers--;
+			l->released_readers--;
+		}
+		break;
+	default:
+		break;
+	}
+	l->active_readers++;
+	pthread_mutex_unlock(&l->m);
+	return 0;
+}
+
+static inline void rw_rdunlock(struct rwlock *l, int token)
+{
+	if (l->policy == RW_SHARDED) {
+		atomic_fetch_sub_explicit(&l->shard[token].readers, 1, memory_order_release);
+		return;
+	}
+	pthread_mutex_lock(&l->m);
+	if (--l->active_readers == 0 && l->waiting_writers)
+		pthread_cond_signal(&l->writers_ok);
+	pthread_mutex_unlock(&l->m);
+}
+
+static inline void rw_wrlock(struct rwlock *l)
+{
+	int i;
+	long sum;
+
+	if (l->policy == RW_SHARDED) {
+		pthread_mutex_lock(&l->writer_m);
+		atomic_store(&l->writer_flag, 1);
+		// cpu reader   ٸ
+		do {
+			for (sum = 0, i = 0; i < RW_SHARDS; i++)
+				sum += atomic_load_explicit(&l->shard[i].readers, memory_order_acquire);
+			if (sum) sched_yield();
+		} while (sum);
+		return;
+	}
+
+	pthread_mutex_lock(&l->m);
+	l->waiting_writers++;
+	//phase-fair   phase ڿ Ǯ reader   Ѵ
+	while (l->writer_active || l->active_readers ||
+		(l->policy == RW_PHASE_FAIR && l->released_readers > 0))
+		pthread_cond_wait(&l->writers_ok, &l->m);
+	l->waiting_writers--;
+	l->writer_active = 1;
+	pthread_mutex_unlock(&l->m);
+}
+
+static inline void rw_wrunlock(struct rwlock *l)
+{
+	if (l->policy == RW_SHARDED) {
+		pthread_mutex_lock(&l->m);
+		atomic_store_explicit(&l->writer_flag, 0, memory_order_release);
+		pthread_cond_broadcast(&l->readers_ok);
+		pthread_mutex_unlock(&l->m);
+		pthread_mutex_unlock(&l->writer_m);
+		return;
+	}
+
+	pthread_mutex_lock(&l->m);
+	l->writer_active = 0;
+	if (l->policy == RW_PHASE_FAIR) {
+		// phase . ٸ reader   б phase 
+		l->phase++;
+		l->released_readers = l->waiting_readers;
+		if (l->released_readers) pthread_cond_broadcast(&l->readers_ok);
+		else pthread_cond_signal(&l->writers_ok);
+	}
+	else if (l->policy == RW_WRITER_PREF && l->waiting_writers) {
+		pthread_cond_signal(&l->writers_ok);
+	}
+	else {
+		pthread_cond_broadcast(&l->readers_ok);
+		pthread_cond_signal(&l->writers_ok);
+	}
+	pthread_mutex_unlock(&l->m);
+}
+
+//"reader", "writer", "fair", "sharded" å ٲ۴. 𸣴 ̸̸ -1
+static inline int rw_policy_parse(const char *name)
+{
+	if (strcmp(name, "reader") == 0) return RW_READER_PREF;
+	if (strcmp(name, "writer") == 0) return RW_WRITER_PREF;
+	if (strcmp(name, "fair") == 0) return RW_PHASE_FAIR;
+	if (strcmp(name, "sharded") == 0) return RW_SHARDED;
+	return -1;
+}
+
+#endif
@@ -1,5 +1,4 @@
 
-#include <semaphore.h>
 #include <pthread.h>
 #include <sys/stat.h>
 #include <stdio.h>
@@ -7,126 +6,95 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include "philo.h"
 
 #define COUNTING_NUMBER 50
-void chopstick();
-sem_t grab[6];
-sem_t cnt_lock;
-int cnt = 0;
+#define PHILOSOPHERS 6
+#define MEALS 3		//öڸ Դ Ƚ
+void *chopstick(void *arg);
 
+// 6 (   ڷ )
+struct ph_table table;
 
-int main() {
+//öڸ    ڿ ģ ( ī͸ lock  ʴ´)
+struct meal_count {
+	_Alignas(PH_CACHELINE) long meals;
+};
+struct meal_count meals[PHILOSOPHERS];
+
+
+int main(int argc, char *argv[]) {
 	int i;
-	// ʱȭ
-	sem_init(&grab[0], 0, 1);
-	sem_init(&grab[1], 0, 1);
-	sem_init(&grab[2], 0, 1);
-	sem_init(&grab[3], 0, 1);
-	sem_init(&grab[4], 0, 1);
-	sem_init(&grab[5], 0, 1);
-
-	sem_init(&cnt_lock, 0, 1);
-	
-
-	//5 ö  
-	pthread_t philoso_0, philoso_1, philoso_2, philoso_3, philoso_4, philoso_5;
-
-
-	// 
-	pthread_create(&philoso_0, NULL, (void*)&chopstick, NULL);
-printf("0 philoso create\n");
-	pthread_create(&philoso_1, NULL, (void*)&chopstick, NULL);
-printf("1 philoso create\n");
-	pthread_create(&philoso_2, NULL, (void*)&chopstick, NULL);
-printf("2 philoso create\n");
-	pthread_create(&philoso_3, NULL, (void*)&chopstick, NULL);
-printf("3 philoso create\n");
-	pthread_create(&philoso_4, NULL, (void*)&chopstick, NULL);
-printf("4 philoso create\n");
-	pthread_create(&philoso_5, NULL, (void*)&chopstick, NULL);
-printf("5 philoso create\n");
-
-
-	
-
-	//尡    ٸ
-	pthread_join(philoso_0, NULL);
-	pthread_join(philoso_1, NULL);
-	pthread_join(philoso_2, NULL);
-	pthread_join(philoso_3, NULL);
-	pthread_join(philoso_4, NULL);
-	pthread_join(philoso_5, NULL);
-
-	printf("All philosophers have finished eating\n.");
-
-	// ı
-	sem_destroy(&grab[0]);
-	sem_destroy(&grab[1]);
-	sem_destroy(&grab[2]);
-	sem_destroy(&grab[3]);
-	sem_destroy(&grab[4]);
-	sem_destroy(&grab[5]);
-
-	sem_destroy(&cnt_lock);
-	
+	long total = 0;
+	// ʱȭ: ordered(⺻,  ȣ), trylock( ٽ)
+	int policy = argc > 1 ? ph_policy_parse(argv[1]) : PH_ORDERED;
+	if (policy < 0) {
+		printf("usage: %s [ordered|trylock]\n", argv[0]);
+		return 0;
+	}
+	ph_init(&table, PHILOSOPHERS, (enum ph_policy)policy);
 
-}
 
+	//6 ö  
+	pthread_t philoso[PHILOSOPHERS];
 
 
-void chopstick()
-{
-	
+	// . ڸ ȣ ڷ ѱ
+	for (i = 0; i < PHILOSOPHERS; i++) {
+		pthread_create(&philoso[i], NULL, chopstick, (void *)(long)i);
+printf("%d philoso create\n", i);
+	}
 
-	//ڽ ° ڸ  ö ã
-	sem_wait(&cnt_lock);
-	int order = cnt;
-	printf("my order is %d\n", order);
-	cnt++;
-	sem_post(&cnt_lock);
 
 
-	
-	//ڽ Ȧ ° ڸ öڶ    ´
-	if (order % 2 == 1) {
 
-		// lock
-		sem_wait(&grab[(order+1)%6]);
-printf("\t%d - philoso success grab left\n", order);
+	//尡    ٸ
+	for (i = 0; i < PHILOSOPHERS; i++)
+		pthread_join(philoso[i], NULL);
 
-		//lock
-		sem_wait(&grab[order]);
-printf("\t%d - philoso success grab right\n", order);
-	}
-	//ڽ ¦° ڸ öڶ    ´
-	else {
-		// lock
+	//öڸ  Ļ Ƚ ģ
+	for (i = 0; i < PHILOSOPHERS; i++) total += meals[i].meals;
+	printf("All philosophers have finished eating (%ld meals)\n.", total);
 
-		sem_wait(&grab[order]);
-printf("\t%d - philoso success grab right\n", order);
+	// ı
+	ph_destroy(&table);
 
-		//lock
-		sem_wait(&grab[(order+1)%6]);
-printf("\t%d - philoso success grab left\n", order);
-	}
-	
+
+}
 
 
 
-	//   µ ߴٸ Ļ縦 Ѵ
-	//eating....(critical section)
-	usleep(10000);
-	printf("\t%d - philoso eating...\n\n", order);
+void *chopstick(void *arg)
+{
+	//ڽ ° ڸ  ö main ˷ش
+	int order = (int)(long)arg;
+	unsigned seed = order + 1;
+	int m;
+	printf("my order is %d\n", order);
 
 
-	//Ļ縦 ƴٸ    ´
-	sem_post(&grab[order]);
-printf("\t%d - philoso success release one\n", order);
-	sem_post(&grab[(order+1)%6]);
-printf("\t%d - philoso success release two\n", order);
-	printf("%d - philoso finish eating\n\n", order);
+	for (m = 0; m < MEALS; m++) {
+		//   ´
+		// öڰ ȣ   Ƿ θ ٸ   ʴ´
+		ph_pickup(&table, order, &seed);
+printf("\t%d - philoso success grab %d and %d\n", order, order, (order+1)%PHILOSOPHERS);
+
 
 
+		//   µ ߴٸ Ļ縦 Ѵ
+		//eating....(critical section)
+		usleep(10000);
+		printf("\t%d - philoso eating...\n\n", order);
+		meals[order].meals++;
+
+
+		//Ļ縦 ƴٸ    ´
+		ph_putdown(&table, order);
+printf("\t%d - philoso success release both\n", order);
+	}
+	printf("%d - philoso finish eating\n\n", order);
+	return NULL;
+
 }
 
 
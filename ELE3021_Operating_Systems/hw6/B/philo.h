@@ -0,0 +1,113 @@
+#ifndef PHILO_H
+#define PHILO_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *   ̻ ڿ() Բ   - Ļϴ ö
+ * i öڴ i (i+1)%n  
+ *	PH_ORDERED - ȣ   ´.  尡    Ƿ
+ *	             ٸ  ̷   deadlock  ʴ´ (ڿ ȭ)
+ *	PH_TRYLOCK -   ٷ  ٸ ϳ trylock ´. ϸ
+ *	                 þ ðŭ ٰ ̹  ʺ
+ *	             ٷ ´. ϳ  ä ٸ  ٸ Ƿ deadlock 
+ *
+ *  ĳ θ ϳ ξ   lock   ΰ  ʴ´
+ */
+#define PH_CACHELINE 64
+#define PH_BACKOFF_MAX 1024	//  ð  (spin Ƚ)
+
+enum ph_policy { PH_ORDERED, PH_TRYLOCK };
+
+struct ph_stick {
+	_Alignas(PH_CACHELINE) pthread_mutex_t m;
+};
+
+struct ph_table {
+	enum ph_policy policy;
+	int n;
+	struct ph_stick *stick;
+};
+
+static inline int ph_init(struct ph_table *t, int n, enum ph_policy policy)
+{
+	int i;
+
+	// ϳ      ȴ
+	if (n < 2) return -1;
+	t->policy = policy;
+	t->n = n;
+	t->stick = aligned_alloc(PH_CACHELINE, sizeof(struct ph_stick) * n);
+	if (!t->stick) return -1;
+	for (i = 0; i < n; i++) pthread_mutex_init(&t->stick[i].m, NULL);
+	return 0;
+}
+
+static inline void ph_destroy(struct ph_table *t)
+{
+	int i;
+
+	for (i = 0; i < t->n; i++) pthread_mutex_destroy(&t->stick[i].m);
+	free(t->stick);
+	t->stick = NULL;
+}
+
+//i ö    ȣ  Ͱ ū 
+static inline int ph_first(const struct ph_table *t, int i)
+{
+	int j = (i + 1) % t->n;
+	return i < j ? i : j;
+}
+
+static inline int ph_second(const struct ph_table *t, int i)
+{
+	int j = (i + 1) % t->n;
+	return i < j ? j : i;
+}
+
+//seed öڸ     (PH_TRYLOCK  ð)
+static inline void ph_pickup(struct ph_table *t, int i, unsigned *seed)
+{
+	int a = ph_first(t, i), b = ph_second(t, i), tmp;
+	unsigned backoff = 1, spin;
+
+	if (t->policy == PH_ORDERED) {
+		pthread_mutex_lock(&t->stick[a].m);
+		pthread_mutex_lock(&t->stick[b].m);
+		return;
+	}
+
+	while (1) {
+		pthread_mutex_lock(&t->stick[a].m);
+		if (pthread_mutex_trylock(&t->stick[b].m) == 0) return;
+		pthread_mutex_unlock(&t->stick[a].m);
+
+		//̿ Դ ̴.  ٰ   ٸ
+		for (spin = rand_r(seed) % backoff; spin > 0; spin--)
+			__asm__ __volatile__("" ::: "memory");
+		if (backoff < PH_BACKOFF_MAX) backoff <<= 1;
+		else sched_yield();
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+}
+
+static inline void ph_putdown(struct ph_table *t, int i)
+{
+	pthread_mutex_unlock(&t->stick[ph_second(t, i)].m);
+	pthread_mutex_unlock(&t->stick[ph_first(t, i)].m);
+}
+
+//"ordered", "trylock"  ٲ۴. 𸣴 ̸̸ -1
+static inline int ph_policy_parse(const char *name)
+{
+	if (strcmp(name, "ordered") == 0) return PH_ORDERED;
+	if (strcmp(name, "trylock") == 0) return PH_TRYLOCK;
+	return -1;
+}
+
+#endif
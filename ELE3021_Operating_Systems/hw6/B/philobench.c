@@ -0,0 +1,115 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "philo.h"
+
+/*
+ * Ļϴ ö ó 
+ * ö (=  ) ٲ   duration  
+ *	meals/s  ( ö ʴ Ļ Ƚ)
+ *	min/max  (   öڿ    ö , 1  )
+ *  Ѵ. Ļ   eat, think   
+ *
+ * : philobench [-n max_philosophers] [-d seconds] [-e eat] [-t think]
+ */
+
+struct philosopher {
+	_Alignas(PH_CACHELINE) long meals;
+	unsigned seed;
+	int id;
+};
+
+static struct ph_table table;
+static _Atomic int stop;
+static int eat = 200, think = 200;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void work(int n)
+{
+	while (n-- > 0) __asm__ __volatile__("" ::: "memory");
+}
+
+static void *philosopher(void *arg)
+{
+	struct philosopher *p = arg;
+
+	while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+		ph_pickup(&table, p->id, &p->seed);
+		work(eat);
+		ph_putdown(&table, p->id);
+		p->meals++;
+		work(think);
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	static const char *names[] = { "ordered", "trylock" };
+	int max_n = 16, opt, n, p, i;
+	double duration = 0.5, start, sec;
+	struct philosopher *ph;
+	pthread_t *th;
+	long total, lo, hi;
+
+	while ((opt = getopt(argc, argv, "n:d:e:t:")) != -1) {
+		switch (opt) {
+		case 'n': max_n = atoi(optarg); break;
+		case 'd': duration = atof(optarg); break;
+		case 'e': eat = atoi(optarg); break;
+		case 't': think = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-n max_philosophers] [-d seconds] [-e eat] [-t think]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (max_n < 2) max_n = 2;
+
+	th = malloc(sizeof(pthread_t) * max_n);
+	ph = aligned_alloc(PH_CACHELINE, sizeof(struct philosopher) * max_n);
+
+	printf("eat %d, think %d, %.1f s per run\n", eat, think, duration);
+	printf("%8s", "threads");
+	for (p = PH_ORDERED; p <= PH_TRYLOCK; p++) printf(" %14s %8s", names[p], "min/max");
+	printf("\n");
+	for (n = 2; n <= max_n; n = n < 8 ? n + 1 : n * 2) {
+		printf("%8d", n);
+		for (p = PH_ORDERED; p <= PH_TRYLOCK; p++) {
+			ph_init(&table, n, (enum ph_policy)p);
+			atomic_store(&stop, 0);
+			memset(ph, 0, sizeof(struct philosopher) * n);
+
+			start = now();
+			for (i = 0; i < n; i++) {
+				ph[i].id = i;
+				ph[i].seed = i + 1;
+				pthread_create(&th[i], NULL, philosopher, &ph[i]);
+			}
+			usleep((useconds_t)(duration * 1e6));
+			atomic_store(&stop, 1);
+			for (i = 0; i < n; i++) pthread_join(th[i], NULL);
+			sec = now() - start;
+			ph_destroy(&table);
+
+			//öڸ   ⼭ ģ
+			for (total = 0, lo = hi = ph[0].meals, i = 0; i < n; i++) {
+				total += ph[i].meals;
+				if (ph[i].meals < lo) lo = ph[i].meals;
+				if (ph[i].meals > hi) hi = ph[i].meals;
+			}
+			printf(" %14.0f %8.2f", total / sec, hi > 0 ? (double)lo / hi : 0);
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+	return 0;
+}
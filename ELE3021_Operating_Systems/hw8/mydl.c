@@ -0,0 +1,296 @@
+#include "sched.h"
+
+/* a is earlier than b (deadlines wrap around like rq_clock) */
+static inline int mydl_time_before(u64 a, u64 b)
+{
+	return (s64)(a - b) < 0;
+}
+
+static inline struct task_struct *mydl_task_of(struct sched_mydl_entity *dl_se)
+{
+	return container_of(dl_se, struct task_struct, mydl);
+}
+
+void init_mydl_rq(struct mydl_rq *mydl_rq)
+{
+	printk(KERN_INFO "***[MYDL] EDF class is online \n");
+	mydl_rq->root = RB_ROOT;
+	mydl_rq->leftmost = NULL;
+	mydl_rq->nr_running = 0;
+	mydl_rq->total_bw = 0;
+	raw_spin_lock_init(&mydl_rq->bw_lock);
+}
+
+/*
+ * Called from __sched_setscheduler() with the task's rq locked. Admits the
+ * task only if the utilization of every deadline task on this cpu, with
+ * the new one, stays within MYDL_BW_MAX; otherwise the task keeps its old
+ * policy and sched_setattr() fails with EBUSY.
+ */
+int mydl_admit(struct rq *rq, struct task_struct *p, const struct sched_attr *attr)
+{
+	struct sched_mydl_entity *dl_se = &p->mydl;
+	struct mydl_rq *mydl_rq = &rq->mydl;
+	u64 period = attr->sched_period ? attr->sched_period : attr->sched_deadline;
+	u64 bw, old = 0;
+	int ret = 0;
+
+	if (attr->sched_runtime == 0 || attr->sched_runtime > attr->sched_deadline ||
+	    attr->sched_deadline > period)
+		return -EINVAL;
+	bw = div64_u64(attr->sched_runtime << MYDL_BW_SHIFT, period);
+
+	raw_spin_lock(&mydl_rq->bw_lock);
+	if (p->policy == SCHED_MYDL && dl_se->bw_cpu == cpu_of(rq))
+		old = dl_se->dl_bw;
+	if (mydl_rq->total_bw - old + bw > MYDL_BW_MAX)
+		ret = -EBUSY;
+	else
+		mydl_rq->total_bw += bw - old;
+	raw_spin_unlock(&mydl_rq->bw_lock);
+	if (ret) {
+		printk(KERN_INFO "***[MYDL] admit: rejected pid=%d, bw=%llu, total_bw=%llu\n",
+		       p->pid, bw, mydl_rq->total_bw);
+		return ret;
+	}
+
+	/* admitted on another cpu before: give that cpu its share back */
+	if (p->policy == SCHED_MYDL && dl_se->bw_cpu != cpu_of(rq)) {
+		struct mydl_rq *prev_rq = &cpu_rq(dl_se->bw_cpu)->mydl;
+
+		raw_spin_lock(&prev_rq->bw_lock);
+		prev_rq->total_bw -= dl_se->dl_bw;
+		raw_spin_unlock(&prev_rq->bw_lock);
+	}
+
+	/* runtime and deadline are left alone: the task may be queued, and
+	 * they are refreshed at its next enqueue */
+	dl_se->dl_runtime = attr->sched_runtime;
+	dl_se->dl_deadline = attr->sched_deadline;
+	dl_se->dl_period = period;
+	dl_se->dl_bw = bw;
+	dl_se->bw_cpu = cpu_of(rq);
+	return 0;
+}
+
+static void release_mydl_bw(struct sched_mydl_entity *dl_se)
+{
+	struct mydl_rq *mydl_rq;
+
+	if (!dl_se->dl_bw)
+		return;
+	mydl_rq = &cpu_rq(dl_se->bw_cpu)->mydl;
+	raw_spin_lock(&mydl_rq->bw_lock);
+	mydl_rq->total_bw -= dl_se->dl_bw;
+	raw_spin_unlock(&mydl_rq->bw_lock);
+	dl_se->dl_bw = 0;
+}
+
+static void enqueue_mydl_entity(struct mydl_rq *mydl_rq, struct sched_mydl_entity *dl_se)
+{
+	struct rb_node **link = &mydl_rq->root.rb_node;
+	struct rb_node *parent = NULL;
+	struct sched_mydl_entity *entry;
+	int leftmost = 1;
+
+	while (*link) {
+		parent = *link;
+		entry = rb_entry(parent, struct sched_mydl_entity, rb_node);
+		if (mydl_time_before(dl_se->deadline, entry->deadline)) {
+			link = &parent->rb_left;
+		} else {
+			link = &parent->rb_right;
+			leftmost = 0;
+		}
+	}
+	if (leftmost)
+		mydl_rq->leftmost = &dl_se->rb_node;
+	rb_link_node(&dl_se->rb_node, parent, link);
+	rb_insert_color(&dl_se->rb_node, &mydl_rq->root);
+	dl_se->on_rq = 1;
+}
+
+static void dequeue_mydl_entity(struct mydl_rq *mydl_rq, struct sched_mydl_entity *dl_se)
+{
+	if (mydl_rq->leftmost == &dl_se->rb_node)
+		mydl_rq->leftmost = rb_next(&dl_se->rb_node);
+	rb_erase(&dl_se->rb_node, &mydl_rq->root);
+	RB_CLEAR_NODE(&dl_se->rb_node);
+	dl_se->on_rq = 0;
+}
+
+/*
+ * Budget used up: move the deadline back by whole periods and refill the
+ * budget (soft CBS). The task keeps the cpu only while nothing with an
+ * earlier deadline is queued, so an overrunning task cannot delay others.
+ */
+static void postpone_mydl_entity(struct rq *rq, struct sched_mydl_entity *dl_se)
+{
+	while (dl_se->runtime <= 0) {
+		dl_se->deadline += dl_se->dl_period;
+		dl_se->runtime += dl_se->dl_runtime;
+	}
+	if (dl_se->on_rq) {
+		dequeue_mydl_entity(&rq->mydl, dl_se);
+		enqueue_mydl_entity(&rq->mydl, dl_se);
+	}
+	if (rq->mydl.leftmost != &dl_se->rb_node)
+		resched_curr(rq);
+}
+
+/*
+ * On wakeup the old deadline is kept only if it is still ahead and the
+ * budget left can be used up before it at the reserved rate
+ * (runtime / (deadline - now) <= dl_runtime / dl_period); otherwise a new
+ * period starts now. A task that sleeps cannot save up budget this way.
+ */
+static void replenish_mydl_entity(struct rq *rq, struct sched_mydl_entity *dl_se)
+{
+	u64 now = rq_clock(rq);
+
+	if (dl_se->runtime <= 0 || !mydl_time_before(now, dl_se->deadline) ||
+	    (u64)dl_se->runtime * dl_se->dl_period > (dl_se->deadline - now) * dl_se->dl_runtime) {
+		dl_se->deadline = now + dl_se->dl_deadline;
+		dl_se->runtime = dl_se->dl_runtime;
+	}
+}
+
+static void update_curr_mydl(struct rq *rq)
+{
+	struct task_struct *curr = rq->curr;
+	struct sched_mydl_entity *dl_se = &curr->mydl;
+	u64 now, delta_exec;
+
+	if (curr->sched_class != &mydl_sched_class)
+		return;
+	now = rq_clock_task(rq);
+	delta_exec = now - curr->se.exec_start;
+	if ((s64)delta_exec <= 0)
+		return;
+	curr->se.sum_exec_runtime += delta_exec;
+	curr->se.exec_start = now;
+
+	dl_se->runtime -= delta_exec;
+	if (dl_se->runtime <= 0)
+		postpone_mydl_entity(rq, dl_se);
+}
+
+static void enqueue_task_mydl(struct rq *rq, struct task_struct *p, int flags)
+{
+	struct sched_mydl_entity *dl_se = &p->mydl;
+
+	if (dl_se->on_rq)
+		return;
+	replenish_mydl_entity(rq, dl_se);
+	enqueue_mydl_entity(&rq->mydl, dl_se);
+	rq->mydl.nr_running += 1;
+	add_nr_running(rq, 1);
+}
+
+static void dequeue_task_mydl(struct rq *rq, struct task_struct *p, int flags)
+{
+	struct sched_mydl_entity *dl_se = &p->mydl;
+
+	update_curr_mydl(rq);
+	if (!dl_se->on_rq)
+		return;
+	dequeue_mydl_entity(&rq->mydl, dl_se);
+	rq->mydl.nr_running -= 1;
+	sub_nr_running(rq, 1);
+}
+
+/* Give up the rest of this period's budget */
+static void yield_task_mydl(struct rq *rq)
+{
+	update_curr_mydl(rq);
+	rq->curr->mydl.runtime = 0;
+	postpone_mydl_entity(rq, &rq->curr->mydl);
+}
+
+/* Only called when both p and curr are deadline tasks */
+static void check_preempt_curr_mydl(struct rq *rq, struct task_struct *p, int flags)
+{
+	if (mydl_time_before(p->mydl.deadline, rq->curr->mydl.deadline))
+		resched_curr(rq);
+}
+
+/* The earliest deadline is the leftmost node. The running task stays in
+ * the tree, so it is compared against every wakeup. */
+struct task_struct *pick_next_task_mydl(struct rq *rq, struct task_struct *prev)
+{
+	struct sched_mydl_entity *dl_se;
+	struct task_struct *next_task;
+
+	if (!rq->mydl.nr_running)
+		return NULL;
+	put_prev_task(rq, prev);
+	dl_se = rb_entry(rq->mydl.leftmost, struct sched_mydl_entity, rb_node);
+	next_task = mydl_task_of(dl_se);
+	next_task->se.exec_start = rq_clock_task(rq);
+	return next_task;
+}
+
+static void put_prev_task_mydl(struct rq *rq, struct task_struct *p)
+{
+	update_curr_mydl(rq);
+}
+
+static int select_task_rq_mydl(struct task_struct *p, int cpu, int sd_flag, int flags)
+{
+	return task_cpu(p);
+}
+
+static void set_curr_task_mydl(struct rq *rq)
+{
+	rq->curr->se.exec_start = rq_clock_task(rq);
+}
+
+static void task_tick_mydl(struct rq *rq, struct task_struct *p, int queued)
+{
+	update_curr_mydl(rq);
+}
+
+static void task_dead_mydl(struct task_struct *p)
+{
+	release_mydl_bw(&p->mydl);
+}
+
+static void prio_changed_mydl(struct rq *rq, struct task_struct *p, int oldprio)
+{
+}
+
+/* This routine is called when a task migrates between classes */
+static void switched_from_mydl(struct rq *rq, struct task_struct *p)
+{
+	release_mydl_bw(&p->mydl);
+}
+
+static void switched_to_mydl(struct rq *rq, struct task_struct *p)
+{
+	if (!task_on_rq_queued(p) || rq->curr == p)
+		return;
+	if (rq->curr->sched_class != &mydl_sched_class ||
+	    mydl_time_before(p->mydl.deadline, rq->curr->mydl.deadline))
+		resched_curr(rq);
+}
+
+const struct sched_class mydl_sched_class = {
+	.next			= &fair_sched_class,
+	.enqueue_task		= enqueue_task_mydl,
+	.dequeue_task		= dequeue_task_mydl,
+	.yield_task		= yield_task_mydl,
+	.check_preempt_curr	= check_preempt_curr_mydl,
+	.pick_next_task		= pick_next_task_mydl,
+	.put_prev_task		= put_prev_task_mydl,
+
+#ifdef CONFIG_SMP
+	.select_task_rq		= select_task_rq_mydl,
+#endif
+	.set_curr_task		= set_curr_task_mydl,
+	.task_tick		= task_tick_mydl,
+	.task_dead		= task_dead_mydl,
+	.prio_changed		= prio_changed_mydl,
+	.switched_from		= switched_from_mydl,
+	.switched_to		= switched_to_mydl,
+	.update_curr		= update_curr_mydl,
+};
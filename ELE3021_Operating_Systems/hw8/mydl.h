@@ -0,0 +1,63 @@
+#ifndef _MYDL_H
+#define _MYDL_H
+
+/*
+ * Earliest-deadline-first scheduling class (mydl.c)
+ *
+ * Hooking it up, in the same places as mysched:
+ *  - include/linux/sched.h: include this file and add
+ *	struct sched_mydl_entity mydl;
+ *    to struct task_struct.
+ *  - kernel/sched/sched.h: add
+ *	struct mydl_rq mydl;
+ *    to struct rq, and declare mydl_sched_class.
+ *  - kernel/sched/core.c:
+ *	init_mydl_rq(&rq->mydl) in sched_init(),
+ *	p->sched_class = &mydl_sched_class in __setscheduler() when
+ *	p->policy == SCHED_MYDL,
+ *	mydl_admit() in __sched_setscheduler() next to the dl_overflow()
+ *	check, with the task's rq locked (return its error to the caller).
+ *  - rt_sched_class.next = &mydl_sched_class, so deadline tasks run
+ *    before every CFS task.
+ *
+ * A task joins with sched_setattr(SCHED_MYDL) and gives sched_runtime,
+ * sched_deadline and sched_period in ns. The class admits it only if the
+ * total utilization (runtime / period) on its cpu stays within
+ * MYDL_BW_MAX.
+ */
+
+#define SCHED_MYDL		8
+
+#define MYDL_BW_SHIFT		20
+#define MYDL_BW_UNIT		(1ULL << MYDL_BW_SHIFT)
+#define MYDL_BW_MAX		(MYDL_BW_UNIT * 95 / 100)
+
+struct sched_mydl_entity {
+	struct rb_node		rb_node;
+	int			on_rq;
+
+	u64			dl_runtime;	/* budget per period */
+	u64			dl_deadline;	/* relative deadline */
+	u64			dl_period;
+	u64			dl_bw;		/* dl_runtime / dl_period << MYDL_BW_SHIFT */
+
+	s64			runtime;	/* budget left in this period */
+	u64			deadline;	/* absolute deadline, rq_clock */
+	int			bw_cpu;		/* cpu whose total_bw holds dl_bw */
+};
+
+struct mydl_rq {
+	struct rb_root		root;		/* by deadline */
+	struct rb_node		*leftmost;	/* earliest deadline */
+	unsigned int		nr_running;
+	u64			total_bw;	/* admitted utilization */
+	raw_spinlock_t		bw_lock;	/* total_bw; task_dead runs without the rq lock */
+};
+
+struct rq;
+struct task_struct;
+struct sched_attr;
+void init_mydl_rq(struct mydl_rq *mydl_rq);
+int mydl_admit(struct rq *rq, struct task_struct *p, const struct sched_attr *attr);
+
+#endif
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Wakeup latency of periodic tasks (cyclictest-style) for the mydl class
+ *
+ * Each of the -t measuring threads sleeps until its next period with
+ * clock_nanosleep(TIMER_ABSTIME), records how late it actually woke up,
+ * spins for -w us of "control work" and sleeps again. -l threads of
+ * SCHED_OTHER busy loops load the cpus meanwhile. Under EDF the latency
+ * stays bounded by the other deadline tasks' runtimes no matter how much
+ * CFS load there is; with -p other it grows with the load.
+ *
+ * usage: mydl_latency [-p mydl|deadline|fifo|other] [-t threads] [-i interval_us]
+ *                     [-r runtime_us] [-w work_us] [-l load_threads] [-d seconds]
+ * build: gcc -O2 -o mydl_latency mydl_latency.c -lpthread
+ */
+
+#define SCHED_MYDL	8
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE	6
+#endif
+#define HIST_US		10000	/* latencies up to 10ms are kept exactly (per us) */
+
+struct sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+};
+
+struct measure {
+	int id;
+	long count, min, max, overflow;
+	double sum;
+	long *hist;
+	int err;	/* errno from sched_setattr */
+};
+
+static int policy = SCHED_MYDL;
+static long interval_us = 1000, runtime_us = 200, work_us = 50;
+static _Atomic int stop;
+
+static long now_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static int set_policy(void)
+{
+	struct sched_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = policy;
+	if (policy == SCHED_FIFO) attr.sched_priority = 80;
+	if (policy == SCHED_MYDL || policy == SCHED_DEADLINE) {
+		attr.sched_runtime = runtime_us * 1000;
+		attr.sched_deadline = interval_us * 1000;
+		attr.sched_period = interval_us * 1000;
+	}
+	if (policy == SCHED_OTHER) return 0;
+	return syscall(SYS_sched_setattr, 0, &attr, 0) ? errno : 0;
+}
+
+static void spin_until(long t)
+{
+	while (now_ns() < t);
+}
+
+static void *measure(void *arg)
+{
+	struct measure *m = arg;
+	struct timespec ts;
+	long next, lat;
+
+	if ((m->err = set_policy()) != 0) return NULL;
+	m->min = -1;
+	next = now_ns() + interval_us * 1000;
+	while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+		ts.tv_sec = next / 1000000000L;
+		ts.tv_nsec = next % 1000000000L;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		lat = (now_ns() - next) / 1000;
+
+		m->count++;
+		m->sum += lat;
+		if (m->min < 0 || lat < m->min) m->min = lat;
+		if (lat > m->max) m->max = lat;
+		if (lat < HIST_US) m->hist[lat]++;
+		else m->overflow++;
+
+		spin_until(now_ns() + work_us * 1000);
+		next += interval_us * 1000;
+	}
+	return NULL;
+}
+
+static void *load(void *arg)
+{
+	volatile unsigned long x = 0;
+
+	while (!atomic_load_explicit(&stop, memory_order_relaxed)) x++;
+	return NULL;
+}
+
+/* smallest latency that at least q of the samples do not exceed */
+static long quantile(const struct measure *m, double q)
+{
+	long need = (long)(q * m->count), seen = 0, us;
+
+	for (us = 0; us < HIST_US; us++) {
+		seen += m->hist[us];
+		if (seen > need) return us;
+	}
+	return m->max;
+}
+
+static int parse_policy(const char *name)
+{
+	if (strcmp(name, "mydl") == 0) return SCHED_MYDL;
+	if (strcmp(name, "deadline") == 0) return SCHED_DEADLINE;
+	if (strcmp(name, "fifo") == 0) return SCHED_FIFO;
+	if (strcmp(name, "other") == 0) return SCHED_OTHER;
+	return -1;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = 1, loads = 2 * (int)sysconf(_SC_NPROCESSORS_ONLN), opt, i;
+	double duration = 5;
+	const char *pname = "mydl";
+	struct measure *m;
+	pthread_t *mt, *lt;
+
+	while ((opt = getopt(argc, argv, "p:t:i:r:w:l:d:")) != -1) {
+		switch (opt) {
+		case 'p': pname = optarg; policy = parse_policy(optarg); break;
+		case 't': threads = atoi(optarg); break;
+		case 'i': interval_us = atol(optarg); break;
+		case 'r': runtime_us = atol(optarg); break;
+		case 'w': work_us = atol(optarg); break;
+		case 'l': loads = atoi(optarg); break;
+		case 'd': duration = atof(optarg); break;
+		default: policy = -1; break;
+		}
+	}
+	if (policy < 0 || threads < 1 || interval_us < 1) {
+		fprintf(stderr, "usage: %s [-p mydl|deadline|fifo|other] [-t threads] [-i interval_us]\n"
+			"\t[-r runtime_us] [-w work_us] [-l load_threads] [-d seconds]\n", argv[0]);
+		return 1;
+	}
+
+	m = calloc(threads, sizeof(*m));
+	mt = malloc(sizeof(pthread_t) * threads);
+	lt = malloc(sizeof(pthread_t) * (loads > 0 ? loads : 1));
+	for (i = 0; i < loads; i++) pthread_create(&lt[i], NULL, load, NULL);
+	for (i = 0; i < threads; i++) {
+		m[i].id = i;
+		m[i].hist = calloc(HIST_US, sizeof(long));
+		pthread_create(&mt[i], NULL, measure, &m[i]);
+	}
+	usleep((useconds_t)(duration * 1e6));
+	atomic_store(&stop, 1);
+	for (i = 0; i < threads; i++) pthread_join(mt[i], NULL);
+	for (i = 0; i < loads; i++) pthread_join(lt[i], NULL);
+
+	printf("policy %s, interval %ld us, runtime %ld us, work %ld us, %d load threads, %.1f s\n",
+		pname, interval_us, runtime_us, work_us, loads, duration);
+	for (i = 0; i < threads; i++) {
+		if (m[i].err) {
+			printf("T:%2d sched_setattr: %s%s\n", i, strerror(m[i].err),
+				m[i].err == EBUSY ? " (not admitted)" : "");
+			continue;
+		}
+		printf("T:%2d C:%8ld Min:%6ld Avg:%8.1f P99:%6ld Max:%6ld%s\n", i, m[i].count, m[i].min,
+			m[i].count ? m[i].sum / m[i].count : 0, quantile(&m[i], 0.99), m[i].max,
+			m[i].overflow ? " (some > 10ms)" : "");
+	}
+	return 0;
+}
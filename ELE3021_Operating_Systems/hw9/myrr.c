@@ -1,4 +1,7 @@
 #include "sched.h"
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/sysctl.h>
 static void put_prev_task_myrr(struct rq *rq, struct task_struct *p);
 static int select_task_rq_myrr(struct task_struct *p, int cpu, int sd_flag, int flags);
 static void set_curr_task_myrr(struct rq *rq);
@@ -11,8 +14,70 @@ static void dequeue_task_myrr(struct rq *rq, struct task_struct *p, int flags);
 static void check_preempt_curr_myrr(struct rq *rq, struct task_struct *p,int flags);
 struct task_struct *pick_next_task_myrr(struct rq *rq, struct task_struct *prev);
 static void prio_changed_myrr(struct rq *rq, struct task_struct *p, int oldprio);
+#ifdef CONFIG_SMP
+static void task_woken_myrr(struct rq *rq, struct task_struct *p);
+static int pull_task_myrr(struct rq *this_rq);
+#endif
+
+/*
+ * time slice tick  ƴ϶ rq_clock_task   ð(ns) .
+ * ⺻ sysctl kernel.sched_myrr_timeslice_us̰, task
+ * sched_setattr sched_runtime(ns)    ִ (0̸ ⺻).
+ * sched_myrr_entity tick (update_num)    (sched.h):
+ *
+ *	struct sched_myrr_entity {
+ *		struct list_head run_list;
+ *		u64 runtime;		// ̹ slice  ð (ns)
+ *		u64 time_slice;		// sched_setattr  slice (ns), 0̸ sysctl 
+ *	};
+ *
+ * core.c SCHED_MYRR  __setscheduler_params __setparam_myrr,
+ * __getparam_dl ڸ __getparam_myrr, ˻  __checkparam_myrr θ.
+ */
+#define MYRR_TIME_SLICE 4	// ⺻ slice (tick)
+#define MYRR_MIN_SLICE_US 100
+#define MYRR_MAX_SLICE_US USEC_PER_SEC
+
+int sysctl_sched_myrr_timeslice_us = MYRR_TIME_SLICE * (USEC_PER_SEC / HZ);
+static int myrr_min_slice_us = MYRR_MIN_SLICE_US;
+static int myrr_max_slice_us = MYRR_MAX_SLICE_US;
+
+static inline u64 myrr_timeslice(struct task_struct *p)
+{
+	if(p->myrr.time_slice)
+		return p->myrr.time_slice;
+	return (u64)READ_ONCE(sysctl_sched_myrr_timeslice_us) * NSEC_PER_USEC;
+}
+
+/*
+ * ٷ  α״ printk  myrr_trace ftrace ۿ .
+ * ְܼ α ۸ ġ ʰ,    static key nop ϳ ´.
+ * ѱ: echo 1 > /proc/sched_myrr, : cat /sys/kernel/debug/tracing/trace_pipe
+ */
+static DEFINE_STATIC_KEY_FALSE(myrr_trace_key);
+#define myrr_trace(fmt, ...) \
+	do { \
+		if (static_branch_unlikely(&myrr_trace_key)) \
+			trace_printk("***[MYRR] " fmt, ##__VA_ARGS__); \
+	} while (0)
+
+/*
+ * cpu .  cpu rq lock  äθ ϹǷ  ȭ ʴ´.
+ *  ð task ť   pick  ð
+ * CONFIG_SCHED_INFO sched_info.last_queued ״ .
+ */
+struct myrr_stats {
+	u64 enqueue;
+	u64 dequeue;
+	u64 pick;
+	u64 slice;	// time slice  Ἥ ť ڷ  Ƚ
+	u64 migrate;
+	u64 wait_sum;	// ns
+	u64 wait_count;
+};
+static DEFINE_PER_CPU(struct myrr_stats, myrr_stats);
+#define myrr_stat_inc(rq, field) (per_cpu(myrr_stats, cpu_of(rq)).field++)
 
-#define MYRR_TIME_SLICE 4
 const struct sched_class myrr_sched_class={
 	.next=&fair_sched_class,
 	.enqueue_task=&enqueue_task_myrr,
@@ -22,6 +87,7 @@ const struct sched_class myrr_sched_class={
 	.put_prev_task=put_prev_task_myrr,
 #ifdef CONFIG_SMP
 	.select_task_rq=select_task_rq_myrr,
+	.task_woken=task_woken_myrr,
 #endif
 	.set_curr_task=set_curr_task_myrr,
 	.task_tick=task_tick_myrr,
@@ -38,21 +104,26 @@ void init_myrr_rq (struct myrr_rq *myrr_rq)
 	INIT_LIST_HEAD(&myrr_rq->queue);
 
 }
+//curr  ķ  ð Ѵ. rq_clock_task irq ó ð  ð̴.
 static void update_curr_myrr(struct rq *rq){
-	
-
 	struct task_struct *curr = rq->curr;
-	struct myrr_rq *myrr_rq = &rq->myrr;
 	struct sched_myrr_entity *entity = &curr->myrr;
-	entity->update_num++;
-	printk("***[MYRR] update_curr_myrr	pid=%d update_num=%d\n",curr->pid ,entity->update_num);
-	if(entity->update_num > MYRR_TIME_SLICE){
-		entity->update_num = 0;
-		list_del_init(&curr->myrr.run_list);
-		list_add_tail(&entity->run_list, &myrr_rq->queue);
-		resched_curr(rq);
-	}
+	u64 now = rq_clock_task(rq);
+	s64 delta_exec;
+
+	if(curr->sched_class != &myrr_sched_class)
+		return;
+	delta_exec = now - curr->se.exec_start;
+	if(unlikely(delta_exec <= 0))
+		return;
 
+	curr->se.sum_exec_runtime += delta_exec;
+	account_group_exec_runtime(curr, delta_exec);
+	curr->se.exec_start = now;
+	cpuacct_charge(curr, delta_exec);
+
+	entity->runtime += delta_exec;
+	myrr_trace("update_curr_myrr\tpid=%d runtime=%llu\n", curr->pid, entity->runtime);
 }
 
 static void enqueue_task_myrr(struct rq *rq, struct task_struct *p, int flags) {
@@ -64,7 +135,8 @@ static void enqueue_task_myrr(struct rq *rq, struct task_struct *p, int flags) {
 	list_add_tail(&task->run_list, &myrr_rq->queue);
 
 	rq->myrr.nr_running++;
-	printk(KERN_INFO"***[MYRR] enqueue: success cpu=%d, nr_running=%d, pid=%d\n",cpu_of(rq), rq->myrr.nr_running,p->pid);
+	myrr_stat_inc(rq, enqueue);
+	myrr_trace("enqueue: success cpu=%d, nr_running=%d, pid=%d\n",cpu_of(rq), rq->myrr.nr_running,p->pid);
 }
 static void dequeue_task_myrr(struct rq *rq, struct task_struct *p, int flags) 
 {
@@ -74,14 +146,15 @@ static void dequeue_task_myrr(struct rq *rq, struct task_struct *p, int flags)
 
 		list_del_init(&p->myrr.run_list);
 		rq->myrr.nr_running--;
-		printk(KERN_INFO"\t***[MYRR] dequeue: success cpu=%d, nr_running=%d, pid=%d\n",cpu_of(rq), rq->myrr.nr_running,p->pid);
+		myrr_stat_inc(rq, dequeue);
+		myrr_trace("\tdequeue: success cpu=%d, nr_running=%d, pid=%d\n",cpu_of(rq), rq->myrr.nr_running,p->pid);
 	}
 	else{
 	}
 	
 }
 void check_preempt_curr_myrr(struct rq *rq, struct task_struct *p, int flags) {
-	printk("***[MYRR] check_preempt_curr_myrr\n");
+	myrr_trace("check_preempt_curr_myrr\n");
 }
 struct task_struct *pick_next_task_myrr(struct rq *rq, struct task_struct *prev)
 {
@@ -89,6 +162,16 @@ struct task_struct *pick_next_task_myrr(struct rq *rq, struct task_struct *prev)
 	struct sched_myrr_entity *next_se = NULL;
 	struct myrr_rq *myrr_rq = &rq->myrr;	
 
+#ifdef CONFIG_SMP
+	//  task   ٻ cpu ϳ ´.
+	if(rq->myrr.nr_running==0){
+		pull_task_myrr(rq);
+		//   double_lock_balance rq lock    Ƿ
+		//   Ŭ task Դ  ȮѴ.
+		if((rq->stop && task_on_rq_queued(rq->stop)) || rq->dl.dl_nr_running || rq->rt.rt_nr_running)
+			return RETRY_TASK;
+	}
+#endif
 	if(rq->myrr.nr_running==0 ){
 		return NULL;
 	}
@@ -96,19 +179,164 @@ struct task_struct *pick_next_task_myrr(struct rq *rq, struct task_struct *prev)
 
 	next_se = container_of(myrr_rq->queue.next, struct sched_myrr_entity, run_list);
 	next_p = container_of(next_se, struct task_struct, myrr);
+	next_p->se.exec_start = rq_clock_task(rq);
 	
-	printk(KERN_INFO "\t***[MYRR] pick_next_task: cpu=%d, prev->pid=%d,next_p->pid=%d,nr_running=%d\n",cpu_of(rq),prev->pid,next_p->pid,rq->myrr.nr_running);
+	myrr_stat_inc(rq, pick);
+#ifdef CONFIG_SCHED_INFO
+	//prev ״ ٽ  last_queued 0̶  ʴ´.
+	if (sched_info_on() && next_p->sched_info.last_queued) {
+		per_cpu(myrr_stats, cpu_of(rq)).wait_sum += rq_clock(rq) - next_p->sched_info.last_queued;
+		myrr_stat_inc(rq, wait_count);
+	}
+#endif
+	myrr_trace("\tpick_next_task: cpu=%d, prev->pid=%d,next_p->pid=%d,nr_running=%d\n",cpu_of(rq),prev->pid,next_p->pid,rq->myrr.nr_running);
 	return next_p;
 }
 void put_prev_task_myrr(struct rq *rq, struct task_struct *p) {
-	printk(KERN_INFO "\t***[MYRR] put_prev_task: do_nothing, p->pid=%d\n",p->pid);
+	update_curr_myrr(rq);
+	myrr_trace("\tput_prev_task: do_nothing, p->pid=%d\n",p->pid);
+}
+#ifdef CONFIG_SMP
+/*
+ *  л. cpu ϴ  cpu myrr ť ִ task (nr_running)̴.
+ * - select_task_rq: wakeup/fork/exec   cpu  ϰ    ´.
+ * - task_woken(push):  task տ ٸ task ְ  Ѱ cpu  ׸ .
+ * - pick_next_task(pull): myrr task   cpu  ٻ cpu ϳ ´.
+ * ٸ cpu nr_running lock  д´.     cpu  ̴.
+ */
+static int find_lowest_cpu_myrr(struct task_struct *p, int cpu)
+{
+	int i, best = cpu;
+	unsigned int load, best_load;
+
+	if(!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)))
+		best = cpumask_any_and(tsk_cpus_allowed(p), cpu_online_mask);
+	best_load = READ_ONCE(cpu_rq(best)->myrr.nr_running);
+	for_each_cpu_and(i, tsk_cpus_allowed(p), cpu_online_mask){
+		load = READ_ONCE(cpu_rq(i)->myrr.nr_running);
+		if(load < best_load){
+			best = i;
+			best_load = load;
+		}
+	}
+	return best;
+}
+
+int select_task_rq_myrr(struct task_struct *p, int cpu, int sd_flag, int flags)
+{
+	if(p->nr_cpus_allowed == 1)
+		return task_cpu(p);
+	return find_lowest_cpu_myrr(p, task_cpu(p));
+}
+
+//ť    ƴ task p src_rq dst_rq ű (  lock  )
+static void migrate_task_myrr(struct rq *src_rq, struct rq *dst_rq, struct task_struct *p)
+{
+	deactivate_task(src_rq, p, 0);
+	set_task_cpu(p, cpu_of(dst_rq));
+	activate_task(dst_rq, p, 0);
+	myrr_stat_inc(dst_rq, migrate);
+	myrr_trace("migrate: pid=%d cpu=%d -> cpu=%d\n", p->pid, cpu_of(src_rq), cpu_of(dst_rq));
+}
+
+static void task_woken_myrr(struct rq *rq, struct task_struct *p)
+{
+	struct rq *lowest_rq;
+	int cpu;
+
+	if(task_running(rq, p) || p->nr_cpus_allowed == 1 || rq->myrr.nr_running < 2)
+		return;
+	cpu = find_lowest_cpu_myrr(p, cpu_of(rq));
+	lowest_rq = cpu_rq(cpu);
+	if(lowest_rq == rq || READ_ONCE(lowest_rq->myrr.nr_running) + 1 >= rq->myrr.nr_running)
+		return;
+
+	double_lock_balance(rq, lowest_rq);
+	//rq lock  ̿ p Űų Ǿ  ִ.
+	if(task_rq(p) == rq && task_on_rq_queued(p) && !task_running(rq, p) &&
+	   cpumask_test_cpu(cpu, tsk_cpus_allowed(p))){
+		migrate_task_myrr(rq, lowest_rq, p);
+		resched_curr(lowest_rq);
+	}
+	double_unlock_balance(rq, lowest_rq);
+}
+
+// ٻ cpu   task ϳ ´. Ű 1
+static int pull_task_myrr(struct rq *this_rq)
+{
+	int this_cpu = cpu_of(this_rq), cpu, busiest = -1, moved = 0;
+	unsigned int load, max_load = 1;
+	struct rq *src_rq;
+	struct sched_myrr_entity *entity;
+	struct task_struct *p;
+
+	for_each_cpu(cpu, cpu_online_mask){
+		if(cpu == this_cpu)
+			continue;
+		load = READ_ONCE(cpu_rq(cpu)->myrr.nr_running);
+		if(load > max_load){
+			busiest = cpu;
+			max_load = load;
+		}
+	}
+	if(busiest < 0)
+		return 0;
+
+	src_rq = cpu_rq(busiest);
+	double_lock_balance(this_rq, src_rq);
+	if(src_rq->myrr.nr_running > 1){
+		//ť  ִ task src_rq   ٷ Ѵ.
+		list_for_each_entry_reverse(entity, &src_rq->myrr.queue, run_list){
+			p = container_of(entity, struct task_struct, myrr);
+			if(!task_running(src_rq, p) && cpumask_test_cpu(this_cpu, tsk_cpus_allowed(p))){
+				migrate_task_myrr(src_rq, this_rq, p);
+				moved = 1;
+				break;
+			}
+		}
+	}
+	double_unlock_balance(this_rq, src_rq);
+	return moved;
 }
+#else
 int select_task_rq_myrr(struct task_struct *p, int cpu, int sd_flag, int flags){return task_cpu(p);}
+#endif
 void set_curr_task_myrr(struct rq *rq){
-	printk(KERN_INFO"***[MYRR] set_curr_task_myrr\n");
+	rq->curr->se.exec_start = rq_clock_task(rq);
+	myrr_trace("set_curr_task_myrr\n");
 }
 void task_tick_myrr(struct rq *rq, struct task_struct *p, int queued) {
+	struct sched_myrr_entity *entity = &p->myrr;
+
 	update_curr_myrr(rq);
+	if(entity->runtime < myrr_timeslice(p))
+		return;
+	//slice    slice ְ, ȥڰ ƴϸ ť  ڷ .
+	entity->runtime = 0;
+	if(list_is_singular(&rq->myrr.queue))
+		return;
+	list_move_tail(&entity->run_list, &rq->myrr.queue);
+	myrr_stat_inc(rq, slice);
+	resched_curr(rq);
+}
+
+//sched_setattr: sched_runtime 0̸ sysctl  , ƴϸ  task slice(ns)̴.
+bool __checkparam_myrr(const struct sched_attr *attr)
+{
+	if(attr->sched_runtime == 0)
+		return true;
+	return attr->sched_runtime >= (u64)MYRR_MIN_SLICE_US * NSEC_PER_USEC &&
+	       attr->sched_runtime <= (u64)MYRR_MAX_SLICE_US * NSEC_PER_USEC;
+}
+
+void __setparam_myrr(struct task_struct *p, const struct sched_attr *attr)
+{
+	p->myrr.time_slice = attr->sched_runtime;
+}
+
+void __getparam_myrr(struct task_struct *p, struct sched_attr *attr)
+{
+	attr->sched_runtime = p->myrr.time_slice;
 }
 void prio_changed_myrr(struct rq *rq, struct task_struct *p, int oldprio) { }
 void switched_to_myrr(struct rq *rq, struct task_struct *p)
@@ -116,3 +344,84 @@ void switched_to_myrr(struct rq *rq, struct task_struct *p)
 	resched_curr(rq);
 }
 
+/*
+ * /proc/sched_myrr: /proc/sched_debugó cpu 踦 ش.
+ * 0̳ 1  myrr_trace ų Ҵ.
+ */
+static int sched_myrr_show(struct seq_file *m, void *v)
+{
+	struct myrr_stats *st;
+	int cpu;
+
+	seq_printf(m, "myrr_trace: %s\n", static_key_enabled(&myrr_trace_key) ? "on" : "off");
+	for_each_online_cpu(cpu) {
+		st = &per_cpu(myrr_stats, cpu);
+		seq_printf(m, "\ncpu#%d\n", cpu);
+		seq_printf(m, "  .%-30s: %u\n", "nr_running", READ_ONCE(cpu_rq(cpu)->myrr.nr_running));
+		seq_printf(m, "  .%-30s: %llu\n", "enqueue", st->enqueue);
+		seq_printf(m, "  .%-30s: %llu\n", "dequeue", st->dequeue);
+		seq_printf(m, "  .%-30s: %llu\n", "pick", st->pick);
+		seq_printf(m, "  .%-30s: %llu\n", "slice", st->slice);
+		seq_printf(m, "  .%-30s: %llu\n", "migrate", st->migrate);
+		seq_printf(m, "  .%-30s: %llu\n", "wait_count", st->wait_count);
+		seq_printf(m, "  .%-30s: %llu\n", "avg_wait_ns",
+			   st->wait_count ? div64_u64(st->wait_sum, st->wait_count) : 0);
+	}
+	return 0;
+}
+
+static int sched_myrr_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_myrr_show, NULL);
+}
+
+static ssize_t sched_myrr_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	bool on;
+	int ret = kstrtobool_from_user(ubuf, cnt, &on);
+
+	if (ret)
+		return ret;
+	if (on)
+		static_branch_enable(&myrr_trace_key);
+	else
+		static_branch_disable(&myrr_trace_key);
+	return cnt;
+}
+
+static const struct file_operations sched_myrr_fops = {
+	.open		= sched_myrr_open,
+	.read		= seq_read,
+	.write		= sched_myrr_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init init_sched_myrr_procfs(void)
+{
+	if (!proc_create("sched_myrr", 0644, NULL, &sched_myrr_fops))
+		return -ENOMEM;
+	return 0;
+}
+__initcall(init_sched_myrr_procfs);
+
+static struct ctl_table sched_myrr_sysctls[] = {
+	{
+		.procname	= "sched_myrr_timeslice_us",
+		.data		= &sysctl_sched_myrr_timeslice_us,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &myrr_min_slice_us,
+		.extra2		= &myrr_max_slice_us,
+	},
+	{}
+};
+
+static int __init init_sched_myrr_sysctl(void)
+{
+	if (!register_sysctl("kernel", sched_myrr_sysctls))
+		return -ENOMEM;
+	return 0;
+}
+__initcall(init_sched_myrr_sysctl);
@@ -0,0 +1,39 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Bump-pointer arena and string interning for the  */
+/* C-Minus syntax tree                              */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+typedef struct arena Arena;
+
+/* astArena owns the syntax tree nodes and identifier
+ * strings of the compilation; util.c creates it on
+ * first use, main frees it
+ */
+extern Arena * astArena;
+
+/* Function newArena creates an empty arena,
+ * NULL if out of memory
+ */
+Arena * newArena(void);
+
+/* Function arenaAlloc returns size bytes from a,
+ * aligned for any type; NULL if out of memory
+ */
+void * arenaAlloc(Arena * a, size_t size);
+
+/* Function internString returns the copy of s kept
+ * in a, making it the first time s is seen; equal
+ * strings get the same pointer. NULL if out of memory
+ */
+char * internString(Arena * a, const char * s);
+
+/* Procedure freeArena releases a and everything
+ * allocated from it at once
+ */
+void freeArena(Arena * a);
+
+#endif
@@ -8,6 +8,8 @@
 
 #include "globals.h"
 #include "code.h"
+#include "tmb.h"
+#include "peep.h"
 
 /* TM location number for current instruction emission */
 static int emitLoc = 0 ;
@@ -17,11 +19,97 @@ static int emitLoc = 0 ;
    emitBackup, and emitRestore */
 static int highEmitLoc = 0;
 
+/* Every instruction is kept in image, indexed by
+   location, so backpatching is a store; the code
+   file is written once by emitImage. notes holds
+   the comment of each instruction and remarks the
+   standalone comment lines before it, for a traced
+   text file */
+static TmbRecord * image = NULL;
+static char ** notes = NULL;
+static char ** remarks = NULL;
+static int imageSize = 0;
+
+#define KEEPNOTES (TraceCode && !BinaryCode)
+/* the peephole pass moves instructions, so
+   standalone comments are dropped with it */
+#define KEEPREMARKS (KEEPNOTES && !OptimizeCode)
+
+static char * opNames[] = TMB_OPCODES;
+#define NOPNAMES ((int) (sizeof(opNames) / sizeof(opNames[0])))
+
+/* Function growStrings makes the string array *p
+ * of imageSize entries hold size, new entries NULL
+ */
+static int growStrings( char *** p, int size )
+{ char ** q = (char **) realloc(*p,size * sizeof(char *));
+  if (q == NULL) return FALSE;
+  memset(q + imageSize,0,(size - imageSize) * sizeof(char *));
+  *p = q;
+  return TRUE;
+}
+
+/* Procedure growImage makes image hold
+ * location loc, new locations read HALT 0,0,0
+ */
+static int growImage( int loc )
+{ if (loc >= imageSize)
+  { int size = imageSize ? imageSize : 256;
+    TmbRecord * p;
+    while (size <= loc) size *= 2;
+    p = (TmbRecord *) realloc(image,size * sizeof(TmbRecord));
+    if (p == NULL ||
+        (KEEPNOTES && ! growStrings(&notes,size)) ||
+        (KEEPREMARKS && ! growStrings(&remarks,size)))
+    { if (p != NULL) image = p;
+      fprintf(listing,"Out of memory for code image\n");
+      Error = TRUE;
+      return FALSE;
+    }
+    memset(p + imageSize,0,(size - imageSize) * sizeof(TmbRecord));
+    image = p;
+    imageSize = size;
+  }
+  return TRUE;
+}
+
+/* Procedure storeCode puts instruction op r,s,t
+ * with comment c at location loc of image
+ */
+static void storeCode( int loc, char * op, int r, int s, int t, char * c)
+{ int i;
+  for (i=0; i < NOPNAMES && strcmp(opNames[i],op) != 0; i++) ;
+  if (i == NOPNAMES)
+  { fprintf(listing,"Unknown TM opcode %s\n",op);
+    Error = TRUE;
+    return;
+  }
+  if (! growImage(loc)) return;
+  image[loc].op = i;
+  image[loc].arg1 = r;
+  image[loc].arg2 = s;
+  image[loc].arg3 = t;
+  if (KEEPNOTES)
+  { free(notes[loc]);
+    notes[loc] = NULL;
+    if (c != NULL && (notes[loc] = malloc(strlen(c) + 1)) != NULL)
+      strcpy(notes[loc],c);
+  }
+}
+
 /* Procedure emitComment prints a comment line 
  * with comment c in the code file
  */
 void emitComment( char * c )
-{ if (TraceCode) fprintf(code,"* %s\n",c);}
+{ char * r;
+  int len;
+  if (!KEEPREMARKS || !growImage(emitLoc)) return;
+  len = remarks[emitLoc] ? strlen(remarks[emitLoc]) : 0;
+  r = (char *) realloc(remarks[emitLoc],len + strlen(c) + 4);
+  if (r == NULL) return;
+  sprintf(r + len,"* %s\n",c);
+  remarks[emitLoc] = r;
+}
 
 /* Procedure emitRO emits a register-only
  * TM instruction
@@ -32,9 +120,7 @@ void emitComment( char * c )
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRO( char *op, int r, int s, int t, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d,%d ",emitLoc++,op,r,s,t);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
+{ storeCode(emitLoc++,op,r,s,t,c);
   if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
 } /* emitRO */
 
@@ -47,9 +133,7 @@ void emitRO( char *op, int r, int s, int t, char *c)
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRM( char * op, int r, int d, int s, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",emitLoc++,op,r,d,s);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
+{ storeCode(emitLoc++,op,r,d,s,c);
   if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
 } /* emitRM */
 
@@ -88,10 +172,130 @@ void emitRestore(void)
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRM_Abs( char *op, int r, int a, char * c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",
-               emitLoc,op,r,a-(emitLoc+1),pc);
+{ storeCode(emitLoc,op,r,a-(emitLoc+1),pc,c);
   ++emitLoc ;
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
   if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
 } /* emitRM_Abs */
+
+/* the text file is formatted in text and
+   written with one fwrite */
+static char * text = NULL;
+static int textLen = 0, textSize = 0;
+
+static void putText( const char * s, int len )
+{ if (textLen + len > textSize)
+  { int size = textSize ? textSize : 4096;
+    char * p;
+    while (size < textLen + len) size *= 2;
+    p = (char *) realloc(text,size);
+    if (p == NULL)
+    { Error = TRUE;
+      return;
+    }
+    text = p;
+    textSize = size;
+  }
+  memcpy(text + textLen,s,len);
+  textLen += len;
+}
+
+static void putString( const char * s )
+{ putText(s,strlen(s)); }
+
+/* putNum puts n right-aligned in width columns */
+static void putNum( int n, int width )
+{ char digits[16];
+  unsigned u = n < 0 ? -(unsigned) n : (unsigned) n;
+  int i = sizeof(digits);
+  do
+  { digits[--i] = '0' + u % 10;
+    u /= 10;
+  } while (u > 0);
+  if (n < 0) digits[--i] = '-';
+  while (width-- > (int) sizeof(digits) - i) putText(" ",1);
+  putText(digits + i,sizeof(digits) - i);
+}
+
+/* Procedure writeText writes the first count
+ * instructions of image in the text format,
+ * each after its standalone comments
+ */
+static void writeText( int count )
+{ int i;
+  textLen = 0;
+  for (i=0;i<=count;i++)
+  { TmbRecord * p = &image[i];
+    const char * op;
+    if (remarks && remarks[i]) putString(remarks[i]);
+    if (i == count) break;
+    op = opNames[p->op];
+    putNum(i,3);
+    putText(":  ",3);
+    putText("     ",5 - (int) strlen(op) > 0 ? 5 - (int) strlen(op) : 0);
+    putString(op);
+    putText("  ",2);
+    putNum(p->arg1,0);
+    putText(",",1);
+    putNum(p->arg2,0);
+    if (p->op < tmbRRLim)
+    { putText(",",1);
+      putNum(p->arg3,0);
+      putText(" ",1);
+    }
+    else
+    { putText("(",1);
+      putNum(p->arg3,0);
+      putText(") ",2);
+    }
+    if (TraceCode && notes && notes[i])
+    { putText("\t",1);
+      putString(notes[i]);
+    }
+    putText("\n",1);
+  }
+  if (fwrite(text,1,textLen,code) != (size_t) textLen)
+  { fprintf(listing,"Cannot write code file\n");
+    Error = TRUE;
+  }
+  free(text);
+  text = NULL;
+  textSize = 0;
+}
+
+/* freeStrings frees the string array *p */
+static void freeStrings( char *** p )
+{ int i;
+  if (*p == NULL) return;
+  for (i=0;i<imageSize;i++) free((*p)[i]);
+  free(*p);
+  *p = NULL;
+}
+
+/* Procedure emitImage writes the instructions
+ * kept in image to the code file, after the
+ * peephole pass if OptimizeCode is TRUE; as a
+ * .tmb image (see tmb.h) if BinaryCode is TRUE,
+ * else as text
+ */
+void emitImage(void)
+{ TmbHeader h;
+  /* one more location for the comments at the end */
+  if (! growImage(highEmitLoc)) return;
+  h.count = highEmitLoc;
+  if (OptimizeCode) h.count = peephole(image,notes,h.count);
+  if (!BinaryCode) writeText(h.count);
+  else
+  { h.magic = TMB_MAGIC;
+    h.recSize = sizeof(TmbRecord);
+    if ((fwrite(&h,sizeof(h),1,code) != 1) ||
+        (fwrite(image,sizeof(TmbRecord),h.count,code) != (size_t) h.count))
+    { fprintf(listing,"Cannot write code image\n");
+      Error = TRUE;
+    }
+  }
+  freeStrings(&notes);
+  freeStrings(&remarks);
+  free(image);
+  image = NULL;
+  imageSize = 0;
+} /* emitImage */
@@ -83,4 +83,13 @@ void emitRestore(void);
  */
 void emitRM_Abs( char *op, int r, int a, char * c);
 
+/* Procedure emitImage writes the emitted code
+ * to the code file in one piece, as a .tmb image
+ * (see tmb.h) if BinaryCode is TRUE, else as
+ * text, after the peephole pass (see peep.h) if
+ * OptimizeCode is TRUE; it must be called once
+ * after the last instruction is emitted
+ */
+void emitImage(void);
+
 #endif
@@ -40,8 +40,10 @@ typedef enum
 extern FILE* source; /* source code text file */
 extern FILE* listing; /* listing output text file */
 extern FILE* code; /* code text file for TM simulator */
+extern FILE* stream; /* token and tree stream for tools, or NULL */
 
 extern int lineno; /* source line number for listing */
+extern int tokenCount; /* tokens scanned so far */
 
 /**************************************************/
 /***********   Syntax tree for parsing ************/
@@ -100,6 +102,17 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
+/* BinaryCode = TRUE causes the TM code to be
+ * written as a .tmb binary image instead of text
+ */
+extern int BinaryCode;
+
+/* OptimizeCode = TRUE causes the TM code to go
+ * through the peephole optimizer before it is
+ * written; standalone comments are then dropped
+ */
+extern int OptimizeCode;
+
 /* Error = TRUE prevents further passes if an error occurs */
 extern int Error; 
 #endif
@@ -351,8 +351,8 @@ static void yynoreturn yy_fatal_error ( const char* msg  );
 	(yy_hold_char) = *yy_cp; \
 	*yy_cp = '\0'; \
 	(yy_c_buf_p) = yy_cp;
-#define YY_NUM_RULES 28
-#define YY_END_OF_BUFFER 29
+#define YY_NUM_RULES 32
+#define YY_END_OF_BUFFER 33
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -360,14 +360,14 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static const flex_int16_t yy_accept[52] =
+static const flex_int16_t yy_accept[57] =
     {   0,
-        0,    0,   29,   27,   26,   25,    8,   15,   16,   19,
-       17,   22,   18,   20,   23,   21,    9,    7,   10,   24,
-       11,   12,   24,   24,   24,   24,   24,   13,   14,   26,
-       23,   24,   24,    1,   24,   24,   24,   24,   24,    5,
-       24,   24,   24,    2,   24,    6,   24,   24,    3,    4,
-        0
+        0,    0,   33,   31,   29,   28,   31,   18,   19,   16,
+       14,   25,   15,   17,   26,   24,   10,    9,   12,   27,
+       20,   21,   27,   27,   27,   27,   27,   22,   23,   29,
+        8,   30,   26,   11,    7,   13,   27,   27,    1,   27,
+       27,   27,   27,   27,    5,   27,   27,   27,    2,   27,
+        6,   27,   27,    3,    4,    0
     } ;
 
 static const YY_CHAR yy_ec[256] =
@@ -410,53 +410,53 @@ static const YY_CHAR yy_meta[36] =
         2,    2,    2,    1,    1
     } ;
 
-static const flex_int16_t yy_base[53] =
+static const flex_int16_t yy_base[58] =
     {   0,
-        0,    0,   59,   60,   56,   60,   60,   60,   60,   60,
-       60,   60,   60,   60,   45,   60,   60,   60,   60,    0,
-       60,   60,   31,   14,   34,   27,   30,   60,   60,   50,
-       39,    0,   21,    0,   19,   18,   23,   22,   24,    0,
-       13,   23,   17,    0,   13,    0,   18,   12,    0,    0,
-       60,   35
+        0,    0,   64,   65,   61,   65,   47,   65,   65,   65,
+       65,   65,   65,   54,   48,   65,   44,   43,   42,    0,
+       65,   65,   31,   14,   34,   27,   30,   65,   65,   50,
+       65,   65,   39,   65,   65,   65,    0,   21,    0,   19,
+       18,   23,   22,   24,    0,   13,   23,   17,    0,   13,
+        0,   18,   12,    0,    0,   65,   35
     } ;
 
-static const flex_int16_t yy_def[53] =
+static const flex_int16_t yy_def[58] =
     {   0,
-       51,    1,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   52,
-       51,   51,   52,   52,   52,   52,   52,   51,   51,   51,
-       51,   52,   52,   52,   52,   52,   52,   52,   52,   52,
-       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
-        0,   51
+       56,    1,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   57,
+       56,   56,   57,   57,   57,   57,   57,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   57,   57,   57,   57,
+       57,   57,   57,   57,   57,   57,   57,   57,   57,   57,
+       57,   57,   57,   57,   57,    0,   56
     } ;
 
-static const flex_int16_t yy_nxt[96] =
+static const flex_int16_t yy_nxt[101] =
     {   0,
         4,    5,    6,    7,    8,    9,   10,   11,   12,   13,
        14,   15,   16,   17,   18,   19,   20,   21,   22,   20,
        23,   20,   20,   24,   20,   20,   20,   25,   20,   20,
-       20,   26,   27,   28,   29,   34,   32,   50,   49,   35,
-       48,   47,   46,   45,   44,   43,   42,   41,   40,   39,
-       31,   30,   38,   37,   36,   33,   31,   30,   51,    3,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51
+       20,   26,   27,   28,   29,   39,   37,   55,   54,   40,
+       53,   52,   51,   50,   49,   48,   47,   46,   45,   44,
+       33,   30,   43,   42,   41,   38,   36,   35,   34,   33,
+       32,   31,   30,   56,    3,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56
 
     } ;
 
-static const flex_int16_t yy_chk[96] =
+static const flex_int16_t yy_chk[101] =
     {   0,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,   24,   52,   48,   47,   24,
-       45,   43,   42,   41,   39,   38,   37,   36,   35,   33,
-       31,   30,   27,   26,   25,   23,   15,    5,    3,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
-       51,   51,   51,   51,   51
+        1,    1,    1,    1,    1,   24,   57,   53,   52,   24,
+       50,   48,   47,   46,   44,   43,   42,   41,   40,   38,
+       33,   30,   27,   26,   25,   23,   19,   18,   17,   15,
+       14,    7,    5,    3,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56
 
     } ;
 
@@ -485,10 +485,12 @@ char *yytext;
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "source.h"
+#include "stream.h"
 /* lexeme of identifier or reserved word */
 char tokenString[MAXTOKENLEN+1];
-#line 491 "lex.yy.c"
-#line 492 "lex.yy.c"
+#line 493 "lex.yy.c"
+#line 494 "lex.yy.c"
 
 #define INITIAL 0
 
@@ -705,10 +707,11 @@ YY_DECL
 		}
 
 	{
-#line 23 "cminus.l"
+#line 25 "cminus.l"
+
 
 
-#line 712 "lex.yy.c"
+#line 715 "lex.yy.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -735,13 +738,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 52 )
+				if ( yy_current_state >= 57 )
 					yy_c = yy_meta[yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
 			++yy_cp;
 			}
-		while ( yy_base[yy_current_state] != 60 );
+		while ( yy_base[yy_current_state] != 65 );
 
 yy_find_action:
 		yy_act = yy_accept[yy_current_state];
@@ -767,199 +770,173 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 25 "cminus.l"
+#line 28 "cminus.l"
 {return IF;}
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 26 "cminus.l"
+#line 29 "cminus.l"
 {return ELSE;}
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 27 "cminus.l"
+#line 30 "cminus.l"
 {return WHILE;}
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 28 "cminus.l"
+#line 31 "cminus.l"
 {return RETURN;}
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 29 "cminus.l"
+#line 32 "cminus.l"
 {return INT;}
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 30 "cminus.l"
+#line 33 "cminus.l"
 {return VOID;}
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 32 "cminus.l"
-{
-                  char c=input();
-                  if(c=='=') return EQ;
-                  else {
-                    unput(c);
-                    return ASSIGN;
-                  }
-                }
+#line 34 "cminus.l"
+{return EQ;}
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 40 "cminus.l"
-{
-                  char c=input();
-                  if(c=='=') return NE;
-                  else {
-                    unput(c);
-                    return ERROR;
-                  }
-                }
+#line 35 "cminus.l"
+{return NE;}
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 49 "cminus.l"
-{
-                  char c=input();
-                  if(c=='=') return LE;
-                  else {
-                    unput(c);
-                    return LT;
-                  };
-                }
+#line 36 "cminus.l"
+{return ASSIGN;}
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 57 "cminus.l"
-{
-                  char c=input();
-                  if(c=='=') return GE;
-                  else {
-                    unput(c);
-                    return GT;
-                  };
-                }
+#line 37 "cminus.l"
+{return LT;}
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 66 "cminus.l"
-{return LBRACE;}
+#line 38 "cminus.l"
+{return LE;}
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 67 "cminus.l"
-{return RBRACE;}
+#line 39 "cminus.l"
+{return GT;}
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 68 "cminus.l"
-{return LCURLY;}
+#line 40 "cminus.l"
+{return GE;}
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 69 "cminus.l"
-{return RCURLY;}
+#line 41 "cminus.l"
+{return PLUS;}
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 70 "cminus.l"
-{return LPAREN;}
+#line 42 "cminus.l"
+{return MINUS;}
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 71 "cminus.l"
-{return RPAREN;}
+#line 43 "cminus.l"
+{return TIMES;}
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 73 "cminus.l"
-{return PLUS;}
+#line 44 "cminus.l"
+{return OVER;}
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 74 "cminus.l"
-{return MINUS;}
+#line 45 "cminus.l"
+{return LPAREN;}
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 75 "cminus.l"
-{return TIMES;}
+#line 46 "cminus.l"
+{return RPAREN;}
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 76 "cminus.l"
-{
-                  char c ;
-                  int done = 0,star;
-                  
-                  c = input();
-                  if (c!='*') {
-                    unput(c);
-                    return OVER;
-                  }
-                  
-                  while(!done){
-              
-                      c= input();
-                      if(star){
-                        if(c=='/') done =1 ;
-                        else star =0;
-                      } 
-
-                      if (c == EOF) break;
-                      if (c == '\n') lineno++;
-                      if (c == '*') {
-                        star = 1;
-                      }
-                  } 
-
-                }
+#line 47 "cminus.l"
+{return LBRACE;}
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 103 "cminus.l"
-{return SEMI;}
+#line 48 "cminus.l"
+{return RBRACE;}
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 104 "cminus.l"
-{return COMMA;}
+#line 49 "cminus.l"
+{return LCURLY;}
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 106 "cminus.l"
-{return NUM;}
+#line 50 "cminus.l"
+{return RCURLY;}
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 107 "cminus.l"
-{return ID;}
+#line 51 "cminus.l"
+{return SEMI;}
 	YY_BREAK
 case 25:
-/* rule 25 can match eol */
 YY_RULE_SETUP
-#line 108 "cminus.l"
-{lineno++;}
+#line 52 "cminus.l"
+{return COMMA;}
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 109 "cminus.l"
-{/* skip whitespace */}
+#line 53 "cminus.l"
+{return NUM;}
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 111 "cminus.l"
-{return ERROR;}
+#line 54 "cminus.l"
+{return ID;}
 	YY_BREAK
 case 28:
+/* rule 28 can match eol */
+YY_RULE_SETUP
+#line 55 "cminus.l"
+{lineno++;}
+	YY_BREAK
+case 29:
+YY_RULE_SETUP
+#line 56 "cminus.l"
+{/* skip whitespace */}
+	YY_BREAK
+case 30:
 YY_RULE_SETUP
-#line 113 "cminus.l"
+#line 57 "cminus.l"
+{ char c, pre;
+                  do
+                  { pre = c;
+                    c = input();
+                    if (c == EOF || c == '\0') break;
+                    if (c == '\n') lineno++;
+                  } while (pre != '*' || c != '/');
+                }
+	YY_BREAK
+case 31:
+YY_RULE_SETUP
+#line 65 "cminus.l"
+{return ERROR;}
+	YY_BREAK
+case 32:
+YY_RULE_SETUP
+#line 67 "cminus.l"
 ECHO;
 	YY_BREAK
-#line 963 "lex.yy.c"
+#line 940 "lex.yy.c"
 case YY_STATE_EOF(INITIAL):
 	yyterminate();
 
@@ -1256,7 +1233,7 @@ static int yy_get_next_buffer (void)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 52 )
+			if ( yy_current_state >= 57 )
 				yy_c = yy_meta[yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
@@ -1284,11 +1261,11 @@ static int yy_get_next_buffer (void)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 52 )
+		if ( yy_current_state >= 57 )
 			yy_c = yy_meta[yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
-	yy_is_jam = (yy_current_state == 51);
+	yy_is_jam = (yy_current_state == 56);
 
 		return yy_is_jam ? 0 : yy_current_state;
 }
@@ -1964,7 +1941,7 @@ void yyfree (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 113 "cminus.l"
+#line 67 "cminus.l"
 
 
 TokenType getToken(void)
@@ -1973,11 +1950,13 @@ TokenType getToken(void)
   if (firstTime)
   { firstTime = FALSE;
     lineno++;
-    yyin = source;
+    /* scan the whole file in place, no copy into flex's buffer */
+    yy_scan_buffer(srcBuf,srcLen + SRCPAD);
     yyout = listing;
   }
   currentToken = yylex();
   strncpy(tokenString,yytext,MAXTOKENLEN);
+  if (stream != NULL) streamToken(currentToken,tokenString,lineno);
   if (TraceScan) {
     fprintf(listing,"\t%d: ",lineno);
     printToken(currentToken,tokenString);
@@ -0,0 +1,116 @@
+/****************************************************/
+/* File: stream.c                                   */
+/* Machine-readable token output                    */
+/* through one buffer and whole-block writes        */
+/****************************************************/
+
+#include "globals.h"
+#include "stream.h"
+
+#define BUFSIZE 65536
+/* room for the longest field written unchecked */
+#define SLACK 64
+
+static char buf[BUFSIZE];
+static int len = 0;
+static int failed = FALSE;
+
+static void flush(void)
+{ if (len > 0 && fwrite(buf,1,len,stream) != (size_t) len)
+    failed = TRUE;
+  len = 0;
+}
+
+static void putStr( const char * s )
+{ while (*s)
+  { if (len >= BUFSIZE) flush();
+    buf[len++] = *s++;
+  }
+}
+
+static void putInt( int n )
+{ if (len > BUFSIZE - SLACK) flush();
+  len += sprintf(buf + len,"%d",n);
+}
+
+/* putText writes s as a JSON string */
+static void putText( const char * s )
+{ putStr("\"");
+  for (; *s; s++)
+  { unsigned char c = *s;
+    if (len > BUFSIZE - SLACK) flush();
+    if (c == '"' || c == '\\')
+    { buf[len++] = '\\';
+      buf[len++] = c;
+    }
+    else if (c < 0x20)
+      len += sprintf(buf + len,"\\u%04x",c);
+    else buf[len++] = c;
+  }
+  putStr("\"");
+}
+
+/* putField writes ,"name": */
+static void putField( const char * name )
+{ putStr(",\"");
+  putStr(name);
+  putStr("\":");
+}
+
+static const char * tokenName( TokenType token )
+{ switch (token)
+  { case ENDFILE: return "ENDFILE";
+    case ERROR: return "ERROR";
+    case IF: return "IF";
+    case ELSE: return "ELSE";
+    case WHILE: return "WHILE";
+    case RETURN: return "RETURN";
+    case INT: return "INT";
+    case VOID: return "VOID";
+    case ID: return "ID";
+    case NUM: return "NUM";
+    case ASSIGN: return "ASSIGN";
+    case EQ: return "EQ";
+    case NE: return "NE";
+    case LT: return "LT";
+    case LE: return "LE";
+    case GT: return "GT";
+    case GE: return "GE";
+    case PLUS: return "PLUS";
+    case MINUS: return "MINUS";
+    case TIMES: return "TIMES";
+    case OVER: return "OVER";
+    case LPAREN: return "LPAREN";
+    case RPAREN: return "RPAREN";
+    case LBRACE: return "LBRACE";
+    case RBRACE: return "RBRACE";
+    case LCURLY: return "LCURLY";
+    case RCURLY: return "RCURLY";
+    case SEMI: return "SEMI";
+    case COMMA: return "COMMA";
+    default: return "UNKNOWN";
+  }
+}
+
+void streamOpen( FILE * f )
+{ stream = f;
+  len = 0;
+  failed = FALSE;
+}
+
+void streamToken( TokenType token, const char * text, int line )
+{ putStr("{\"token\":\"");
+  putStr(tokenName(token));
+  putStr("\"");
+  putField("line");
+  putInt(line);
+  putField("text");
+  putText(text);
+  putStr("}\n");
+}
+
+int streamClose(void)
+{ flush();
+  stream = NULL;
+  return failed ? -1 : 0;
+}
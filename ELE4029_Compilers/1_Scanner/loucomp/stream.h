@@ -0,0 +1,30 @@
+/****************************************************/
+/* File: stream.h                                   */
+/* Machine-readable token output for tools,         */
+/* one JSON object per line                         */
+/****************************************************/
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+/* A line is
+ *   {"token":"ID","line":3,"text":"x"}
+ */
+
+/* Procedure streamOpen starts writing the stream
+ * to f; stream (globals.h) is f until streamClose
+ */
+void streamOpen( FILE * f );
+
+/* Procedure streamToken writes token with its
+ * lexeme text, found on line
+ */
+void streamToken( TokenType token, const char * text, int line );
+
+/* Procedure streamClose writes out what is still
+ * buffered and ends the stream; the file is left
+ * open. Returns -1 if a write failed, else 0
+ */
+int streamClose(void);
+
+#endif
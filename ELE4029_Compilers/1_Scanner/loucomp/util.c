@@ -8,6 +8,7 @@
 
 #include "globals.h"
 #include "util.h"
+#include "arena.h"
 
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
@@ -64,11 +65,30 @@ void printToken( TokenType token, const char* tokenString )
   }
 }
 
+/* currentArena returns astArena, creating it the
+ * first time
+ */
+static Arena * currentArena(void)
+{ if (astArena == NULL) astArena = newArena();
+  return astArena;
+}
+
+/* allocNode returns an uninitialized node from astArena;
+ * nodes are never freed one by one
+ */
+int nodeCount = 0;
+
+static TreeNode * allocNode(void)
+{ Arena * a = currentArena();
+  nodeCount++;
+  return a ? (TreeNode *) arenaAlloc(a,sizeof(TreeNode)) : NULL;
+}
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
 TreeNode * newStmtNode(StmtKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+{ TreeNode * t = allocNode();
   int i;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
@@ -86,7 +106,7 @@ TreeNode * newStmtNode(StmtKind kind)
  * node for syntax tree construction
  */
 TreeNode * newExpNode(ExpKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+{ TreeNode * t = allocNode();
   int i;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
@@ -101,18 +121,18 @@ TreeNode * newExpNode(ExpKind kind)
   return t;
 }
 
-/* Function copyString allocates and makes a new
- * copy of an existing string
+/* Function copyString returns the copy of s kept in
+ * astArena; every occurrence of an identifier shares
+ * one copy, so it must not be modified
  */
 char * copyString(char * s)
-{ int n;
+{ Arena * a;
   char * t;
   if (s==NULL) return NULL;
-  n = strlen(s)+1;
-  t = malloc(n);
+  a = currentArena();
+  t = a ? internString(a,s) : NULL;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
-  else strcpy(t,s);
   return t;
 }
 
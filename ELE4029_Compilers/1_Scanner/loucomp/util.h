@@ -13,6 +13,11 @@
  */
 void printToken( TokenType, const char* );
 
+/* nodeCount is the number of syntax tree
+ * nodes created so far
+ */
+extern int nodeCount;
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
@@ -23,8 +28,8 @@ TreeNode * newStmtNode(StmtKind);
  */
 TreeNode * newExpNode(ExpKind);
 
-/* Function copyString allocates and makes a new
- * copy of an existing string
+/* Function copyString returns the single shared
+ * copy of a string, kept in astArena
  */
 char * copyString( char * );
 
@@ -13,23 +13,58 @@
 /* counter for variable memory locations */
 static int location = 0;
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
+/* a frame of the traverse work stack: node t
+ * and the index of its next child to visit
+ */
+typedef struct
+   { TreeNode * t;
+     int next;
+   } Frame;
+
+/* Procedure traverse is a generic syntax tree
+ * traversal routine:
  * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+ * in postorder to tree pointed to by t.
+ * Siblings are visited in a loop and children
+ * through an explicit stack, so neither long
+ * statement lists nor deep nesting use up the
+ * C stack
  */
 static void traverse( TreeNode * t,
                void (* preProc) (TreeNode *),
                void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
+{ Frame * stack = NULL;
+  int size = 0, top = 0;
+  while (t != NULL || top > 0)
+  { if (t != NULL)
+    { preProc(t);
+      if (top == size)
+      { Frame * s;
+        size = size ? 2 * size : 64;
+        s = (Frame *) realloc(stack,size * sizeof(Frame));
+        if (s == NULL)
+        { fprintf(listing,"Out of memory in tree traversal\n");
+          Error = TRUE;
+          break;
+        }
+        stack = s;
+      }
+      stack[top].t = t;
+      stack[top].next = 0;
+      top++;
+      t = NULL;
+    }
+    else if (stack[top-1].next < MAXCHILDREN)
+    { Frame * f = &stack[top-1];
+      t = f->t->child[f->next++];
+    }
+    else
+    { TreeNode * done = stack[--top].t;
+      postProc(done);
+      t = done->sibling;
     }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
   }
+  free(stack);
 }
 
 /* nullProc is a do-nothing procedure to 
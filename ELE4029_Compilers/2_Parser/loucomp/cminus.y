@@ -332,7 +332,8 @@ int yyerror(char * message)
  * compatible with ealier versions of the TINY scanner
  */
 static int yylex(void)
-{ return getToken(); }
+{ tokenCount++;
+  return getToken(); }
 
 TreeNode * parse(void)
 { yyparse();
@@ -41,8 +41,10 @@ typedef int TokenType;
 extern FILE* source; /* source code text file */
 extern FILE* listing; /* listing output text file */
 extern FILE* code; /* code text file for TM simulator */
+extern FILE* stream; /* token and tree stream for tools, or NULL */
 
 extern int lineno; /* source line number for listing */
+extern int tokenCount; /* tokens scanned so far */
 
 /**************************************************/
 /***********   Syntax tree for parsing ************/
@@ -105,6 +107,17 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
+/* BinaryCode = TRUE causes the TM code to be
+ * written as a .tmb binary image instead of text
+ */
+extern int BinaryCode;
+
+/* OptimizeCode = TRUE causes the TM code to go
+ * through the peephole optimizer before it is
+ * written; standalone comments are then dropped
+ */
+extern int OptimizeCode;
+
 /* Error = TRUE prevents further passes if an error occurs */
 extern int Error; 
 #endif
@@ -0,0 +1,266 @@
+/****************************************************/
+/* File: peep.c                                     */
+/* Peephole optimizer for generated TM code         */
+/* The rewrites are                                 */
+/*   ST a,T(mp) [X] LD b,T(mp)  ->  LDA b,0(a) [X]  */
+/*   LDC r,k  ADD r,x,r         ->  LDA r,k(x)      */
+/*   LDC r,k  SUB r,x,r         ->  LDA r,-k(x)     */
+/*   jump to a jump             ->  jump to the end */
+/*   jump to the next location  ->  nothing         */
+/* and the program is then compacted, with every    */
+/* pc-relative offset relocated                     */
+/****************************************************/
+
+#include "globals.h"
+#include "code.h"
+#include "peep.h"
+
+/* the instructions, their count and flags */
+static TmbRecord * ins;
+static int n;
+static char * dead;   /* deleted, compacted away */
+static char * target; /* reached by some pc-relative address */
+
+#define REG(r) (1 << (r))
+
+static int isRR( int op )
+{ return op < tmbRRLim; }
+
+/* relative is TRUE when i computes d+pc */
+static int relative( int i )
+{ return !isRR(ins[i].op) && ins[i].op != tmbLDC &&
+         ins[i].op != tmbLD && ins[i].op != tmbST &&
+         ins[i].arg3 == pc;
+}
+
+/* the location that relative i addresses */
+static int dest( int i )
+{ return i + 1 + ins[i].arg2; }
+
+static int isJump( int i )
+{ int op = ins[i].op;
+  return op >= tmbJLT || (!isRR(op) && ins[i].arg1 == pc);
+}
+
+/* an unconditional jump to a known location */
+static int isGoto( int i )
+{ return ins[i].op == tmbLDA && ins[i].arg1 == pc && ins[i].arg3 == pc; }
+
+/* registers read and written by i */
+static int reads( int i )
+{ TmbRecord * p = &ins[i];
+  switch (p->op)
+  { case tmbHALT: case tmbIN: return 0;
+    case tmbOUT: return REG(p->arg1);
+    case tmbADD: case tmbSUB: case tmbMUL: case tmbDIV:
+      return REG(p->arg2) | REG(p->arg3);
+    case tmbLDC: return 0;
+    case tmbST: return REG(p->arg1) | REG(p->arg3);
+    case tmbLD: case tmbLDA: return REG(p->arg3);
+    default: /* conditional jumps */
+      return REG(p->arg1) | REG(p->arg3);
+  }
+}
+
+static int writes( int i )
+{ TmbRecord * p = &ins[i];
+  switch (p->op)
+  { case tmbHALT: case tmbOUT: case tmbST: return 0;
+    case tmbIN: case tmbADD: case tmbSUB: case tmbMUL: case tmbDIV:
+    case tmbLD: case tmbLDA: case tmbLDC:
+      return REG(p->arg1);
+    default: return REG(pc);
+  }
+}
+
+/* the first live location at or after i */
+static int live( int i )
+{ while (i < n && dead[i]) i++;
+  return i;
+}
+
+/* Function relocatable is TRUE when no instruction
+ * uses the pc other than as a relative address
+ * or a jump through a register
+ */
+static int relocatable(void)
+{ int i;
+  for (i=0;i<n;i++)
+  { int op = ins[i].op;
+    if (op == tmbRRLim || op == tmbRMLim || op >= tmbRALim) return FALSE;
+    if (op == tmbHALT) continue;
+    if (isRR(op))
+    { if ((reads(i) | writes(i)) & REG(pc)) return FALSE; }
+    else if ((op == tmbLD || op == tmbST) && ins[i].arg3 == pc) return FALSE;
+    else if (op == tmbLDC && ins[i].arg1 == pc) return FALSE;
+  }
+  return TRUE;
+}
+
+static void findTargets(void)
+{ int i;
+  memset(target,0,n);
+  for (i=0;i<n;i++)
+    if (!dead[i] && relative(i))
+    { int d = dest(i);
+      if (d >= 0 && d < n) target[live(d)] = TRUE;
+    }
+}
+
+/* Function threadJumps points every jump that lands
+ * on an unconditional jump at its final location
+ */
+static int threadJumps(void)
+{ int i, changed = FALSE;
+  for (i=0;i<n;i++)
+  { int d, l, steps = 0;
+    if (dead[i] || !isJump(i) || ins[i].arg3 != pc) continue;
+    d = dest(i);
+    while (d >= 0 && d < n && (l = live(d)) < n && isGoto(l) && steps < n)
+    { d = dest(l);
+      steps++;
+    }
+    /* steps reaches n only on a cycle of jumps */
+    if (steps > 0 && steps < n)
+    { ins[i].arg2 = d - (i + 1);
+      changed = TRUE;
+    }
+  }
+  return changed;
+}
+
+/* Procedure kill deletes live i; a jump to it
+ * now reaches the next live instruction
+ */
+static void kill( int i )
+{ dead[i] = TRUE;
+  if (target[i])
+  { int j = live(i);
+    if (j < n) target[j] = TRUE;
+  }
+}
+
+/* Function rewrite applies the local rewrites that
+ * delete instructions, starting at live i
+ */
+static int rewrite( int i )
+{ TmbRecord * p = &ins[i];
+  int j = live(i+1), k;
+  if (j >= n) return FALSE;
+  /* a jump to the next instruction */
+  if (isGoto(i) && dest(i) > i && dest(i) <= j)
+  { kill(i);
+    return TRUE;
+  }
+  /* a temp pushed and popped again */
+  if (p->op == tmbST && p->arg3 == mp && p->arg1 != pc)
+  { int a = p->arg1, b, x = -1;
+    k = j;
+    if (!(ins[k].op == tmbLD && ins[k].arg3 == mp && ins[k].arg2 == p->arg2))
+    { /* one instruction in between */
+      x = j;
+      k = live(j+1);
+      if (k >= n || target[x] || isJump(x) || ins[x].op == tmbHALT ||
+          ins[x].op == tmbST || ins[x].op == tmbIN ||
+          (ins[x].op == tmbLD && ins[x].arg3 == mp))
+        return FALSE;
+      if (!(ins[k].op == tmbLD && ins[k].arg3 == mp &&
+            ins[k].arg2 == p->arg2))
+        return FALSE;
+    }
+    if (target[k]) return FALSE;
+    b = ins[k].arg1;
+    if (b == pc) return FALSE;
+    if (a == b)
+    { if (x >= 0 && (writes(x) & REG(a))) return FALSE;
+      kill(i);
+    }
+    else
+    { if (x >= 0 && ((reads(x) | writes(x)) & REG(b))) return FALSE;
+      /* the copy goes where the store was */
+      p->op = tmbLDA;
+      p->arg1 = b;
+      p->arg2 = 0;
+      p->arg3 = a;
+    }
+    kill(k);
+    return TRUE;
+  }
+  /* a constant operand */
+  if (p->op == tmbLDC && p->arg1 != pc && !target[j] &&
+      (ins[j].op == tmbADD || ins[j].op == tmbSUB) &&
+      ins[j].arg1 == p->arg1)
+  { int r = p->arg1, x;
+    TmbRecord * q = &ins[j];
+    if (q->arg3 == r && q->arg2 != r) x = q->arg2;
+    else if (q->op == tmbADD && q->arg2 == r && q->arg3 != r) x = q->arg3;
+    else return FALSE;
+    if (x == pc) return FALSE;
+    q->arg2 = q->op == tmbADD ? p->arg2 : -p->arg2;
+    q->op = tmbLDA;
+    q->arg3 = x;
+    kill(i);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* Function compact removes the dead instructions
+ * and relocates the pc-relative offsets
+ */
+static int compact( char ** notes )
+{ int * newLoc = (int *) malloc((n + 1) * sizeof(int));
+  int i, m = 0;
+  if (newLoc == NULL) return n;
+  for (i=0;i<n;i++)
+  { newLoc[i] = m;
+    if (!dead[i]) m++;
+  }
+  newLoc[n] = m;
+  for (i=0;i<n;i++)
+    if (!dead[i] && relative(i))
+    { int d = dest(i);
+      if (d >= 0 && d <= n) d = newLoc[d];
+      else if (d > n) d = m + (d - n);
+      ins[i].arg2 = d - (newLoc[i] + 1);
+    }
+  for (i=0;i<n;i++)
+    if (!dead[i])
+    { ins[newLoc[i]] = ins[i];
+      if (notes) notes[newLoc[i]] = notes[i];
+    }
+    else if (notes)
+      free(notes[i]);
+  if (notes)
+    for (i=m;i<n;i++) notes[i] = NULL;
+  free(newLoc);
+  return m;
+}
+
+int peephole( TmbRecord * code, char ** notes, int count )
+{ int i, changed, canDelete;
+  ins = code;
+  n = count;
+  if (n <= 0) return n;
+  dead = (char *) calloc(n,1);
+  target = (char *) calloc(n,1);
+  if (dead == NULL || target == NULL)
+  { free(dead);
+    free(target);
+    return n;
+  }
+  canDelete = relocatable();
+  do
+  { changed = FALSE;
+    if (canDelete)
+    { findTargets();
+      for (i=0;i<n;i++)
+        if (!dead[i] && rewrite(i)) changed = TRUE;
+    }
+    if (threadJumps()) changed = TRUE;
+  } while (changed);
+  if (canDelete) n = compact(notes);
+  free(dead);
+  free(target);
+  return n;
+}
@@ -8,67 +8,52 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "source.h"
+#include "stream.h"
 
-/* states in scanner DFA */
-typedef enum
-   { START,INASSIGN,INCOMMENT,INCOMMENT_,INNUM,INID,DONE,
-   INEQ,INNE,INLT,INGT,INOVER }
-   StateType;
+/* what a state of the scanner tables accepts,
+   besides a token */
+#define SCAN_NONE (-1)    /* nothing */
+#define SCAN_SKIP (-2)    /* white space */
+#define SCAN_COMMENT (-3) /* the opening of a comment */
+
+/* the DFA tables, made by dfagen from cminus.l */
+#include "scantab.h"
 
 /* lexeme of identifier or reserved word */
 char tokenString[MAXTOKENLEN+1];
 
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
-
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
-
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
-    }
-    else
-    { EOF_flag = TRUE;
-      return EOF;
+/* the scanner reads srcBuf in place; srcBuf[srcLen]
+   is a '\0' sentinel */
+static const char * srcPos = NULL; /* start of the next token */
+static const char * readPos = NULL; /* lines before it are counted */
+static const char * lineStart = NULL; /* line not counted yet, NULL if none */
+
+/* countLines counts (and echoes) a line when its
+   first character is read, for the characters
+   from readPos up to p */
+static void countLines(const char * p)
+{ for (; readPos < p; readPos++)
+  { if (readPos == lineStart)
+    { lineno++;
+      lineStart = NULL;
+      if (EchoSource)
+      { const char * eol = memchr(readPos,'\n',srcBuf + srcLen - readPos);
+        int len = eol ? eol - readPos + 1 : srcBuf + srcLen - readPos;
+        fprintf(listing,"%4d: %.*s",lineno,len,readPos);
+      }
     }
+    if (*readPos == '\n') lineStart = readPos + 1;
   }
-  else return lineBuf[linepos++];
 }
 
-/* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
-
-/* lookup table of reserved words */
-static struct
-    { char* str;
-      TokenType tok;
-    } reservedWords[MAXRESERVED]
-   = {{"if",IF},{"else",ELSE},{"while",WHILE},
-      {"return",RETURN},{"int",INT},{"void",VOID}
-      };
-
-/* lookup an identifier to see if it is a reserved word */
-/* uses linear search */
-static TokenType reservedLookup (char * s)
-{ int i;
-  for (i=0;i<MAXRESERVED;i++)
-    if (!strcmp(s,reservedWords[i].str))
-      return reservedWords[i].tok;
-  return ID;
+/* hasMove is TRUE when state s has a transition,
+   so that the scanner reads past the lexeme */
+static int hasMove(int s)
+{ int c;
+  for (c=0;c<SCAN_CLASSES;c++)
+    if (scanCheck[scanBase[s]+c] == s) return TRUE;
+  return FALSE;
 }
 
 /****************************************/
@@ -78,210 +63,67 @@ static TokenType reservedLookup (char * s)
  * next token in source file
  */
 TokenType getToken(void)
-{  /* index for storing into tokenString */
-   int tokenStringIndex = 0;
-   /* holds current token to be returned */
-   TokenType currentToken;
-   /* current state - always begins at START */
-   StateType state = START;
-   /* flag to indicate save to tokenString */
-   int save,remove;
-   while (state != DONE)
-   { int c = getNextChar();
-     save = TRUE;
-     remove = FALSE;
-     switch (state)
-     { case START:
-         if (isdigit(c))
-           state = INNUM;
-         else if (isalpha(c))
-           state = INID;
-         else if (c == '=')
-           state = INASSIGN;
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
-         else if (c == '/')
-           state = INOVER;
-         else if (c == '!')
-           state = INNE;
-         else if (c == '<')
-           state = INLT;
-         else if (c == '>')
-           state = INGT;
-         else
-         { state = DONE;
-           switch (c)
-           { case EOF:
-               save = FALSE;
-               currentToken = ENDFILE;
-               break;
-             case '[':
-               currentToken = LBRACE;
-               break;
-             case ']':
-               currentToken = RBRACE;
-               break;
-
-             case '(':
-               currentToken = LPAREN;
-               break;
-             case ')':
-               currentToken = RPAREN;
-               break;
-
-             case '{':
-               currentToken = LCURLY;
-               break;
-             case '}':
-               currentToken = RCURLY;
-               break;
-
-             case '+':
-               currentToken = PLUS;
-               break;
-             case '-':
-               currentToken = MINUS;
-               break;
-             case '*':
-               currentToken = TIMES;
-               break;
-       
-             case ',':
-               currentToken = COMMA;
-               break;
-             case ';':
-               currentToken = SEMI;
-               break;
-             default:
-               currentToken = ERROR;
-               break;
-           }
-         }
-         break;
-
-       case INEQ:
-          state = DONE;
-          currentToken = EQ;
-          break;
-       case INNE:
-          if(c=='='){
-            state= DONE;
-            currentToken = NE;
-          }
-          else {
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ERROR;
-          }
-          break;
-       case INOVER:
-          if(c=='*'){
-            ungetNextChar();
-            save = FALSE;
-            remove = TRUE;
-            state = INCOMMENT;
-          }
-          else {
-            ungetNextChar();
-            save = FALSE;
-            state= DONE;
-            currentToken = OVER;
-          }
-          break;
-       case INLT:
-          if(c=='='){
-            state = DONE;
-            currentToken = LE;
-          }
-          else {
-            ungetNextChar();
-            save = FALSE;
-            state = DONE;
-            currentToken = LT;
-          }
-          break;
-       case INGT:
-          if(c=='='){
-            state = DONE;
-            currentToken = GE;
-          }
-          else {
-            ungetNextChar();
-            save = FALSE;
-            state = DONE;
-            currentToken = GT;
-          }
-          break;
-
-       
-       case INASSIGN:
-         if (c == '='){
-            state = INEQ;
-         }
-         else{
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ASSIGN; 
-         }
-         break;
-       case INCOMMENT:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if (c == '*') {
-           state = INCOMMENT_;
-         }
-         break;
-       case INCOMMENT_:
-         save = FALSE;
-         if(c=='/') {
-           state = START;
-         }
-         else state = INCOMMENT;
-         break;
-       case INNUM:
-         if (!isdigit(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = NUM;
-         }
-         break;
-       case INID:
-         if (!(isalpha(c)||isdigit(c)))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ID;
-         }
-         break;
-       case DONE:
-       default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
-         state = DONE;
-         currentToken = ERROR;
+{  /* holds current token to be returned */
+   TokenType currentToken = ENDFILE;
+   const char * end = srcBuf + srcLen;
+   if (srcPos == NULL) srcPos = readPos = lineStart = srcBuf;
+   for (;;)
+   { /* run the DFA from srcPos as far as it goes,
+        remembering the last accepting state */
+     const char * p = srcPos, * last = NULL;
+     int state = SCAN_START, accept = SCAN_NONE, len;
+     while (p < end)
+     { int i = scanBase[state] + scanClass[(unsigned char) *p];
+       if (scanCheck[i] != state) break;
+       state = scanNext[i];
+       p++;
+       if (scanAccept[state] != SCAN_NONE)
+       { accept = scanAccept[state];
+         last = p;
+       }
+     }
+     if (last == NULL)
+     { /* only at the end: '.' takes every other byte */
+       countLines(end);
+       lineno++; /* reading EOF */
+       srcPos = end;
+       tokenString[0] = '\0';
+       currentToken = ENDFILE;
+       break;
+     }
+     countLines(last);
+     if (accept == SCAN_COMMENT)
+     { /* skip to the closing star-slash, or the end */
+       p = last;
+       while (p < end && !(p[0] == '*' && p[1] == '/')) p++;
+       srcPos = p < end ? p + 2 : end;
+       countLines(srcPos);
+       if (p == end)
+       { lineno++;
+         tokenString[0] = '\0';
+         currentToken = ENDFILE;
          break;
+       }
+       continue;
      }
-     if(remove) tokenStringIndex--;
-     
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-       tokenString[tokenStringIndex++] = (char) c;
-     if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
-       if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
+     len = last - srcPos;
+     if (accept == SCAN_SKIP)
+     { srcPos = last;
+       continue;
      }
+     /* a token that could go on was ended by EOF */
+     if (p == end && hasMove(state)) lineno++;
+     if (len > MAXTOKENLEN) len = MAXTOKENLEN;
+     memcpy(tokenString,srcPos,len);
+     tokenString[len] = '\0';
+     srcPos = last;
+     currentToken = accept;
+     break;
    }
+   if (stream != NULL) streamToken(currentToken,tokenString,lineno);
    if (TraceScan) {
      fprintf(listing,"\t%d: ",lineno);
      printToken(currentToken,tokenString);
    }
    return currentToken;
 } /* end getToken */
-
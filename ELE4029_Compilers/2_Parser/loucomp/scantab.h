@@ -0,0 +1,132 @@
+/****************************************************/
+/* File: scantab.h                                  */
+/* Scanner tables generated by dfagen from cminus.l */
+/* Do not edit; the Makefile remakes it             */
+/* 31 rules, 50 states, 35 character classes,       */
+/* 565 table entries                                */
+/****************************************************/
+
+#define SCAN_STATES 50
+#define SCAN_CLASSES 35
+#define SCAN_START 0
+
+static const unsigned char scanClass[256] =
+{
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    1,  3,  0,  0,  0,  0,  0,  0,  4,  5,  6,  7,  8,  9,  0, 10,
+   11, 11, 11, 11, 11, 11, 11, 11, 11, 11,  0, 12, 13, 14, 15,  0,
+    0, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+   16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 17,  0, 18,  0,  0,
+    0, 16, 16, 16, 19, 20, 21, 16, 22, 23, 16, 16, 24, 16, 25, 26,
+   16, 16, 27, 28, 29, 30, 31, 32, 16, 16, 16, 33,  0, 34,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
+};
+
+static const short scanBase[50] =
+{
+    0,  0, 35,  0, 23,  0,  0,  0,  0,  0,  0, 32, 28,  0, 27, 28,
+   44, 24,  0,  0, 46, 68, 90,112,134,  0,  0,  0,  0,  0,  0,  0,
+  156,178,200,222,244,266,288,310,332,354,376,398,420,442,464,486,
+  508,530
+};
+
+static const short scanNext[565] =
+{
+    1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16,
+   17, 18, 19, 17, 20, 17, 17, 21, 17, 17, 17, 22, 17, 17, 17, 23,
+   24, 25, 26, 17,  2, 27, 28, 12, 17, 29, 30, 17, 17, 17, 17, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 31,  0,  0,  0, 17,  0,
+    0, 17, 17, 17, 17, 17, 32, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+    0,  0,  0,  0, 17,  0,  0, 17, 17, 33, 17, 17, 17, 34, 17, 17,
+   17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 35, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0,
+   17,  0,  0, 17, 17, 17, 17, 17, 17, 17, 36, 17, 17, 17, 17, 17,
+   17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 37, 17, 17, 17,
+   17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 38, 17, 17, 17, 17, 17,  0,  0,
+    0,  0, 17,  0,  0, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+   17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 17,
+   17, 17, 17, 17, 17, 39, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,
+    0, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 40, 17, 17, 17, 17,
+    0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 41, 17, 17, 17, 17,
+   17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17,
+   17, 42, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0,
+   17,  0,  0, 17, 43, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+   17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 17, 17, 17,
+   17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 44, 17, 17, 17,  0,  0,
+    0,  0, 17,  0,  0, 45, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+   17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 17,
+   46, 17, 17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,
+    0, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+    0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 17, 17, 17, 17, 47,
+   17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0,
+   17,  0,  0, 17, 48, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+   17, 17,  0,  0,  0,  0, 17,  0,  0, 17, 17, 17, 17, 17, 17, 49,
+   17, 17, 17, 17, 17, 17, 17, 17,  0,  0,  0,  0, 17,  0,  0, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,  0,  0,
+    0,  0, 17,  0,  0, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+   17, 17, 17,  0,  0
+};
+
+static const short scanCheck[565] =
+{
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0, 17,  2,  4, 11, 12, 17, 14, 15, 17, 17, 17, 17, 17,
+   17, 17, 17, 17, 17, 17, 17, 17, 17, 20, 16, -1, -1, -1, 20, -1,
+   -1, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 21,
+   -1, -1, -1, -1, 21, -1, -1, 21, 21, 21, 21, 21, 21, 21, 21, 21,
+   21, 21, 21, 21, 21, 22, -1, -1, -1, -1, 22, -1, -1, 22, 22, 22,
+   22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 23, -1, -1, -1, -1,
+   23, -1, -1, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23,
+   23, 24, -1, -1, -1, -1, 24, -1, -1, 24, 24, 24, 24, 24, 24, 24,
+   24, 24, 24, 24, 24, 24, 24, 32, -1, -1, -1, -1, 32, -1, -1, 32,
+   32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 33, -1, -1,
+   -1, -1, 33, -1, -1, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+   33, 33, 33, 34, -1, -1, -1, -1, 34, -1, -1, 34, 34, 34, 34, 34,
+   34, 34, 34, 34, 34, 34, 34, 34, 34, 35, -1, -1, -1, -1, 35, -1,
+   -1, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 35, 36,
+   -1, -1, -1, -1, 36, -1, -1, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+   36, 36, 36, 36, 36, 37, -1, -1, -1, -1, 37, -1, -1, 37, 37, 37,
+   37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 38, -1, -1, -1, -1,
+   38, -1, -1, 38, 38, 38, 38, 38, 38, 38, 38, 38, 38, 38, 38, 38,
+   38, 39, -1, -1, -1, -1, 39, -1, -1, 39, 39, 39, 39, 39, 39, 39,
+   39, 39, 39, 39, 39, 39, 39, 40, -1, -1, -1, -1, 40, -1, -1, 40,
+   40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 40, 41, -1, -1,
+   -1, -1, 41, -1, -1, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41,
+   41, 41, 41, 42, -1, -1, -1, -1, 42, -1, -1, 42, 42, 42, 42, 42,
+   42, 42, 42, 42, 42, 42, 42, 42, 42, 43, -1, -1, -1, -1, 43, -1,
+   -1, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 43, 44,
+   -1, -1, -1, -1, 44, -1, -1, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+   44, 44, 44, 44, 44, 45, -1, -1, -1, -1, 45, -1, -1, 45, 45, 45,
+   45, 45, 45, 45, 45, 45, 45, 45, 45, 45, 45, 46, -1, -1, -1, -1,
+   46, -1, -1, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46, 46,
+   46, 47, -1, -1, -1, -1, 47, -1, -1, 47, 47, 47, 47, 47, 47, 47,
+   47, 47, 47, 47, 47, 47, 47, 48, -1, -1, -1, -1, 48, -1, -1, 48,
+   48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 49, -1, -1,
+   -1, -1, 49, -1, -1, 49, 49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
+   49, 49, 49, -1, -1
+};
+
+static const int scanAccept[50] =
+{
+  SCAN_NONE, ERROR, SCAN_SKIP, SCAN_SKIP, ERROR, LPAREN,
+  RPAREN, TIMES, PLUS, COMMA, MINUS, OVER,
+  NUM, SEMI, LT, ASSIGN, GT, ID,
+  LBRACE, RBRACE, ID, ID, ID, ID,
+  ID, LCURLY, RCURLY, NE, SCAN_COMMENT, LE,
+  EQ, GE, ID, IF, ID, ID,
+  ID, ID, ID, INT, ID, ID,
+  ID, ELSE, ID, VOID, ID, ID,
+  WHILE, RETURN
+};
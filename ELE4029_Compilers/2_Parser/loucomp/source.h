@@ -0,0 +1,30 @@
+/****************************************************/
+/* File: source.h                                   */
+/* Whole-file source buffer for the C-Minus scanners */
+/****************************************************/
+
+#ifndef _SOURCE_H_
+#define _SOURCE_H_
+
+/* SRCPAD is the number of '\0' bytes after the text;
+ * flex's yy_scan_buffer needs two
+ */
+#define SRCPAD 2
+
+/* srcBuf holds the whole source file, srcLen bytes
+ * followed by SRCPAD '\0' bytes; both scanners read
+ * it in place
+ */
+extern char * srcBuf;
+extern size_t srcLen;
+
+/* Function srcLoad maps the file f into srcBuf,
+ * or reads it there if f cannot be mapped (a pipe).
+ * Returns 0, or -1 on error
+ */
+int srcLoad(FILE * f);
+
+/* Procedure srcFree releases srcBuf */
+void srcFree(void);
+
+#endif
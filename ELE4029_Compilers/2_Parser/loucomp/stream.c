@@ -0,0 +1,230 @@
+/****************************************************/
+/* File: stream.c                                   */
+/* Machine-readable token and syntax tree output    */
+/* through one buffer and whole-block writes        */
+/****************************************************/
+
+#include "globals.h"
+#include "stream.h"
+
+#define BUFSIZE 65536
+/* room for the longest field written unchecked */
+#define SLACK 64
+
+static char buf[BUFSIZE];
+static int len = 0;
+static int failed = FALSE;
+
+/* the number of the last node written */
+static int lastNode = 0;
+
+static void flush(void)
+{ if (len > 0 && fwrite(buf,1,len,stream) != (size_t) len)
+    failed = TRUE;
+  len = 0;
+}
+
+static void putStr( const char * s )
+{ while (*s)
+  { if (len >= BUFSIZE) flush();
+    buf[len++] = *s++;
+  }
+}
+
+static void putInt( int n )
+{ if (len > BUFSIZE - SLACK) flush();
+  len += sprintf(buf + len,"%d",n);
+}
+
+/* putText writes s as a JSON string */
+static void putText( const char * s )
+{ putStr("\"");
+  for (; *s; s++)
+  { unsigned char c = *s;
+    if (len > BUFSIZE - SLACK) flush();
+    if (c == '"' || c == '\\')
+    { buf[len++] = '\\';
+      buf[len++] = c;
+    }
+    else if (c < 0x20)
+      len += sprintf(buf + len,"\\u%04x",c);
+    else buf[len++] = c;
+  }
+  putStr("\"");
+}
+
+/* putField writes ,"name": */
+static void putField( const char * name )
+{ putStr(",\"");
+  putStr(name);
+  putStr("\":");
+}
+
+static const char * tokenName( TokenType token )
+{ switch (token)
+  { case ENDFILE: return "ENDFILE";
+    case ERROR: return "ERROR";
+    case IF: return "IF";
+    case ELSE: return "ELSE";
+    case WHILE: return "WHILE";
+    case RETURN: return "RETURN";
+    case INT: return "INT";
+    case VOID: return "VOID";
+    case ID: return "ID";
+    case NUM: return "NUM";
+    case ASSIGN: return "ASSIGN";
+    case EQ: return "EQ";
+    case NE: return "NE";
+    case LT: return "LT";
+    case LE: return "LE";
+    case GT: return "GT";
+    case GE: return "GE";
+    case PLUS: return "PLUS";
+    case MINUS: return "MINUS";
+    case TIMES: return "TIMES";
+    case OVER: return "OVER";
+    case LPAREN: return "LPAREN";
+    case RPAREN: return "RPAREN";
+    case LBRACE: return "LBRACE";
+    case RBRACE: return "RBRACE";
+    case LCURLY: return "LCURLY";
+    case RCURLY: return "RCURLY";
+    case SEMI: return "SEMI";
+    case COMMA: return "COMMA";
+    default: return "UNKNOWN";
+  }
+}
+
+static const char * opText( TokenType op )
+{ switch (op)
+  { case EQ: return "==";
+    case NE: return "!=";
+    case LT: return "<";
+    case LE: return "<=";
+    case GT: return ">";
+    case GE: return ">=";
+    case PLUS: return "+";
+    case MINUS: return "-";
+    case TIMES: return "*";
+    case OVER: return "/";
+    default: return "?";
+  }
+}
+
+void streamOpen( FILE * f )
+{ stream = f;
+  len = 0;
+  failed = FALSE;
+  lastNode = 0;
+}
+
+void streamToken( TokenType token, const char * text, int line )
+{ putStr("{\"token\":\"");
+  putStr(tokenName(token));
+  putStr("\"");
+  putField("line");
+  putInt(line);
+  putField("text");
+  putText(text);
+  putStr("}\n");
+}
+
+/* putType writes the type of a declaration */
+static void putType( TreeNode * t )
+{ putField("type");
+  if (t->type == Void)
+    putStr(t->typeK == ArrayK ? "\"void[]\"" : "\"void\"");
+  else putStr(t->typeK == ArrayK ? "\"int[]\"" : "\"int\"");
+}
+
+/* putNode writes the fields of node t that
+ * depend on its kind
+ */
+static void putNode( TreeNode * t )
+{ putField("kind");
+  if (t->nodekind == StmtK)
+    switch (t->kind.stmt)
+    { case CompK: putStr("\"Compound\""); break;
+      case SelectK:
+        putStr("\"If\"");
+        putField("else");
+        putStr(t->typeK == IfElseK ? "true" : "false");
+        break;
+      case IterK: putStr("\"While\""); break;
+      case RetK:
+        putStr("\"Return\"");
+        putField("value");
+        putStr(t->typeK == ValRetK ? "true" : "false");
+        break;
+      default: putStr("\"Unknown\""); break;
+    }
+  else if (t->nodekind == ExpK)
+    switch (t->kind.exp)
+    { case AssignK: putStr("\"Assign\""); break;
+      case BinK:
+        putStr("\"Op\"");
+        putField("op");
+        putText(opText(t->attr.op));
+        break;
+      case ConstK:
+        putStr("\"Const\"");
+        putField("val");
+        putInt(t->attr.val);
+        break;
+      case IdK: case VarK: case CallK:
+        putStr(t->kind.exp == IdK ? "\"Id\"" :
+               t->kind.exp == VarK ? "\"Var\"" : "\"Call\"");
+        putField("name");
+        putText(t->attr.name);
+        break;
+      case TypeK: putStr("\"VoidParam\""); break;
+      default: putStr("\"Unknown\""); break;
+    }
+  else if (t->nodekind == DeclareK)
+  { switch (t->kind.declare)
+    { case VarDK: putStr("\"VarDecl\""); break;
+      case FuncDK: putStr("\"FuncDecl\""); break;
+      case ParamDK: putStr("\"Param\""); break;
+      default: putStr("\"Unknown\""); break;
+    }
+    putField("name");
+    putText(t->attr.name);
+    if (t->kind.declare == FuncDK)
+    { putField("type");
+      putStr(t->type == Void ? "\"void\"" : "\"int\"");
+    }
+    else putType(t);
+  }
+  else putStr("\"Unknown\"");
+}
+
+/* streamList writes the sibling list t, the
+ * child slot child of node parent
+ */
+static void streamList( TreeNode * t, int parent, int child )
+{ for (; t != NULL; t = t->sibling)
+  { int id = ++lastNode, i;
+    putStr("{\"node\":");
+    putInt(id);
+    putField("parent");
+    putInt(parent);
+    putField("child");
+    putInt(child);
+    putField("line");
+    putInt(t->lineno);
+    putNode(t);
+    putStr("}\n");
+    for (i=0;i<MAXCHILDREN;i++)
+      streamList(t->child[i],id,i);
+  }
+}
+
+void streamTree( TreeNode * tree )
+{ streamList(tree,0,0);
+}
+
+int streamClose(void)
+{ flush();
+  stream = NULL;
+  return failed ? -1 : 0;
+}
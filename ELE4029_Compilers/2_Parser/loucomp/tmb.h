@@ -0,0 +1,50 @@
+/****************************************************/
+/* File: tmb.h                                      */
+/* Binary object format for TM code (.tmb), shared  */
+/* by the code emitter and the TM simulator         */
+/****************************************************/
+
+#ifndef _TMB_H_
+#define _TMB_H_
+
+/* A .tmb file is a TmbHeader followed by count
+ * TmbRecords, one for every location from 0 up;
+ * locations never emitted hold HALT 0,0,0.
+ * Fields are native ints, so a file is read on
+ * the kind of machine that wrote it
+ */
+
+/* TMB_MAGIC is "TMB1" as a little-endian int */
+#define TMB_MAGIC 0x31424d54
+
+/* TMB_OPCODES lists the opcode names in the
+ * order of the TM OPCODE enumeration; a record
+ * stores the index into it
+ */
+#define TMB_OPCODES \
+        {"HALT","IN","OUT","ADD","SUB","MUL","DIV","????", \
+         "LD","ST","????", \
+         "LDA","LDC","JLT","JLE","JGT","JGE","JEQ","JNE","????"}
+
+/* the indexes into TMB_OPCODES */
+typedef enum
+   { tmbHALT, tmbIN, tmbOUT, tmbADD, tmbSUB, tmbMUL, tmbDIV, tmbRRLim,
+     tmbLD, tmbST, tmbRMLim,
+     tmbLDA, tmbLDC, tmbJLT, tmbJLE, tmbJGT, tmbJGE, tmbJEQ, tmbJNE,
+     tmbRALim
+   } TmbOp;
+
+typedef struct
+   { int magic;
+     int recSize; /* sizeof(TmbRecord) of the writer */
+     int count; /* number of records */
+   } TmbHeader;
+
+typedef struct
+   { int op;
+     int arg1;
+     int arg2;
+     int arg3;
+   } TmbRecord;
+
+#endif
@@ -7,29 +7,75 @@
 /****************************************************/
 
 #include "globals.h"
+#include "util.h"
 #include "symtab.h"
 #include "analyze.h"
 
 /* counter for variable memory locations */
 static int location = 0;
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
+/* location of the next global while a
+ * function body is being analyzed
+ */
+static int globalLocation = 0;
+
+/* the body of the function being analyzed;
+ * it shares the scope of the parameters
+ */
+static TreeNode * funcBody = NULL;
+
+/* a frame of the traverse work stack: node t
+ * and the index of its next child to visit
+ */
+typedef struct
+   { TreeNode * t;
+     int next;
+   } Frame;
+
+/* Procedure traverse is a generic syntax tree
+ * traversal routine:
  * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+ * in postorder to tree pointed to by t.
+ * Siblings are visited in a loop and children
+ * through an explicit stack, so neither long
+ * statement lists nor deep nesting use up the
+ * C stack
  */
 static void traverse( TreeNode * t,
                void (* preProc) (TreeNode *),
                void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
+{ Frame * stack = NULL;
+  int size = 0, top = 0;
+  while (t != NULL || top > 0)
+  { if (t != NULL)
+    { preProc(t);
+      if (top == size)
+      { Frame * s;
+        size = size ? 2 * size : 64;
+        s = (Frame *) realloc(stack,size * sizeof(Frame));
+        if (s == NULL)
+        { fprintf(listing,"Out of memory in tree traversal\n");
+          Error = TRUE;
+          break;
+        }
+        stack = s;
+      }
+      stack[top].t = t;
+      stack[top].next = 0;
+      top++;
+      t = NULL;
+    }
+    else if (stack[top-1].next < MAXCHILDREN)
+    { Frame * f = &stack[top-1];
+      t = f->t->child[f->next++];
+    }
+    else
+    { TreeNode * done = stack[--top].t;
+      postProc(done);
+      t = done->sibling;
     }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
   }
+  free(stack);
 }
 
 /* nullProc is a do-nothing procedure to 
@@ -41,23 +87,51 @@ static void nullProc(TreeNode * t)
   else return;
 }
 
-/* Procedure insertNode inserts 
- * identifiers stored in t into 
- * the symbol table 
+static void symbolError(TreeNode * t, char * message)
+{ fprintf(listing,"Symbol error at line %d: %s %s\n",
+          t->lineno,message,t->attr.name);
+  Error = TRUE;
+}
+
+/* Procedure declare enters the declaration t
+ * into the innermost scope
+ */
+static void declare( TreeNode * t)
+{ if (st_lookup_top(t->attr.name) != -1)
+    symbolError(t,"redeclared");
+  else
+    st_insert(t->attr.name,t->lineno,location++);
+}
+
+/* Procedure insertNode inserts
+ * identifiers stored in t into
+ * the symbol table
  */
 static void insertNode( TreeNode * t)
 { switch (t->nodekind)
-  { case StmtK:
+  { case DeclareK:
+      switch (t->kind.declare)
+      { case FuncDK:
+          declare(t);
+          /* parameters and locals are counted
+             from 0 in every function */
+          globalLocation = location;
+          location = 0;
+          funcBody = t->child[1];
+          st_enter();
+          break;
+        case VarDK:
+        case ParamDK:
+          declare(t);
+          break;
+        default:
+          break;
+      }
+      break;
+    case StmtK:
       switch (t->kind.stmt)
-      { case AssignK:
-        case ReadK:
-          if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
-          else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
+      { case CompK:
+          if (t != funcBody) st_enter();
           break;
         default:
           break;
@@ -65,14 +139,14 @@ static void insertNode( TreeNode * t)
       break;
     case ExpK:
       switch (t->kind.exp)
-      { case IdK:
+      { case VarK:
+        case CallK:
           if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
+            symbolError(t,"undeclared");
           else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
+          /* already in table, so ignore location,
+             add line number of use only */
+            st_addline(t->attr.name,t->lineno);
           break;
         default:
           break;
@@ -83,11 +157,33 @@ static void insertNode( TreeNode * t)
   }
 }
 
-/* Function buildSymtab constructs the symbol 
- * table by preorder traversal of the syntax tree
+/* Procedure exitNode closes the scope opened
+ * for t, printing it first when tracing
+ */
+static void exitNode( TreeNode * t)
+{ if ((t->nodekind == DeclareK && t->kind.declare == FuncDK) ||
+      (t->nodekind == StmtK && t->kind.stmt == CompK && t != funcBody))
+  { if (TraceAnalyze)
+    { fprintf(listing,"\n");
+      printSymTab(listing);
+    }
+    st_exit();
+    if (t->nodekind == DeclareK)
+    { location = globalLocation;
+      funcBody = NULL;
+    }
+  }
+}
+
+/* Function buildSymtab constructs the symbol
+ * table by preorder traversal of the syntax tree,
+ * closing each scope on the way back up
  */
 void buildSymtab(TreeNode * syntaxTree)
-{ traverse(syntaxTree,insertNode,nullProc);
+{ /* the built-in functions */
+  st_insert("input",0,location++);
+  st_insert("output",0,location++);
+  traverse(syntaxTree,insertNode,exitNode);
   if (TraceAnalyze)
   { fprintf(listing,"\nSymbol table:\n\n");
     printSymTab(listing);
@@ -106,17 +202,21 @@ static void checkNode(TreeNode * t)
 { switch (t->nodekind)
   { case ExpK:
       switch (t->kind.exp)
-      { case OpK:
-          if ((t->child[0]->type != Integer) ||
+      { case BinK:
+          if ((t->child[0] == NULL) || (t->child[1] == NULL) ||
+              (t->child[0]->type != Integer) ||
               (t->child[1]->type != Integer))
             typeError(t,"Op applied to non-integer");
-          if ((t->attr.op == EQ) || (t->attr.op == LT))
-            t->type = Boolean;
-          else
-            t->type = Integer;
+          t->type = Integer;
+          break;
+        case AssignK:
+          if ((t->child[1] == NULL) || (t->child[1]->type != Integer))
+            typeError(t,"assignment of non-integer value");
+          t->type = Integer;
           break;
         case ConstK:
-        case IdK:
+        case VarK:
+        case CallK:
           t->type = Integer;
           break;
         default:
@@ -125,21 +225,13 @@ static void checkNode(TreeNode * t)
       break;
     case StmtK:
       switch (t->kind.stmt)
-      { case IfK:
-          if (t->child[0]->type == Integer)
-            typeError(t->child[0],"if test is not Boolean");
-          break;
-        case AssignK:
-          if (t->child[0]->type != Integer)
-            typeError(t->child[0],"assignment of non-integer value");
+      { case SelectK:
+          if ((t->child[0] == NULL) || (t->child[0]->type != Integer))
+            typeError(t,"if test is not integer");
           break;
-        case WriteK:
-          if (t->child[0]->type != Integer)
-            typeError(t->child[0],"write of non-integer value");
-          break;
-        case RepeatK:
-          if (t->child[1]->type == Integer)
-            typeError(t->child[1],"repeat test is not Boolean");
+        case IterK:
+          if ((t->child[0] == NULL) || (t->child[0]->type != Integer))
+            typeError(t,"while test is not integer");
           break;
         default:
           break;
@@ -157,3 +249,646 @@ static void checkNode(TreeNode * t)
 void typeCheck(TreeNode * syntaxTree)
 { traverse(syntaxTree,nullProc,checkNode);
 }
+
+/* Function foldOp computes left op right into
+ * *val, FALSE when it cannot be folded
+ */
+static int foldOp( TokenType op, int left, int right, int * val)
+{ switch (op)
+  { case PLUS:  *val = left + right; break;
+    case MINUS: *val = left - right; break;
+    case TIMES: *val = left * right; break;
+    case OVER:
+      /* division by zero is left to run time */
+      if (right == 0) return FALSE;
+      *val = left / right;
+      break;
+    case LT: *val = left < right; break;
+    case LE: *val = left <= right; break;
+    case GT: *val = left > right; break;
+    case GE: *val = left >= right; break;
+    case EQ: *val = left == right; break;
+    case NE: *val = left != right; break;
+    default: return FALSE;
+  }
+  return TRUE;
+}
+
+static int isConst( TreeNode * t)
+{ return t != NULL && t->nodekind == ExpK && t->kind.exp == ConstK;
+}
+
+/* Procedure foldExp folds the constant operator
+ * subtrees of expression t in place
+ */
+static void foldExp( TreeNode * t)
+{ int i, val;
+  if (t == NULL || t->nodekind != ExpK) return;
+  for (i=0; i < MAXCHILDREN; i++)
+  { TreeNode * c;
+    for (c = t->child[i]; c != NULL; c = c->sibling)
+      foldExp(c);
+  }
+  if (t->kind.exp == BinK && isConst(t->child[0]) &&
+      isConst(t->child[1]) &&
+      foldOp(t->attr.op,t->child[0]->attr.val,t->child[1]->attr.val,&val))
+  { t->kind.exp = ConstK;
+    t->attr.val = val;
+    t->child[0] = t->child[1] = NULL;
+  }
+}
+
+/* Function isUsed is TRUE when name is referred
+ * to in list t, outside scopes that redeclare it
+ */
+static int isUsed( char * name, TreeNode * t)
+{ for (; t != NULL; t = t->sibling)
+  { int i;
+    if (t->nodekind == ExpK &&
+        (t->kind.exp == VarK || t->kind.exp == CallK) &&
+        strcmp(t->attr.name,name) == 0)
+      return TRUE;
+    if (t->nodekind == StmtK && t->kind.stmt == CompK)
+    { TreeNode * d;
+      for (d = t->child[0]; d != NULL; d = d->sibling)
+        if (strcmp(d->attr.name,name) == 0) break;
+      if (d != NULL) continue;
+    }
+    for (i=0; i < MAXCHILDREN; i++)
+      if (isUsed(name,t->child[i])) return TRUE;
+  }
+  return FALSE;
+}
+
+static TreeNode * optStmts( TreeNode * t);
+
+/* Function optStmt optimizes statement t and
+ * returns what replaces it, possibly NULL
+ */
+static TreeNode * optStmt( TreeNode * t)
+{ TreeNode * d, * * p;
+  if (t->nodekind == ExpK)
+  { foldExp(t);
+    return t;
+  }
+  if (t->nodekind != StmtK) return t;
+  switch (t->kind.stmt)
+  { case CompK:
+      t->child[1] = optStmts(t->child[1]);
+      /* drop the locals nothing refers to */
+      for (p = &t->child[0]; (d = *p) != NULL; )
+        if (isUsed(d->attr.name,t->child[1])) p = &d->sibling;
+        else *p = d->sibling;
+      break;
+    case SelectK:
+      foldExp(t->child[0]);
+      t->child[1] = optStmts(t->child[1]);
+      t->child[2] = optStmts(t->child[2]);
+      if (isConst(t->child[0]))
+        return t->child[0]->attr.val ? t->child[1] : t->child[2];
+      break;
+    case IterK:
+      foldExp(t->child[0]);
+      t->child[1] = optStmts(t->child[1]);
+      if (isConst(t->child[0]) && t->child[0]->attr.val == 0)
+        return NULL;
+      break;
+    case RetK:
+      foldExp(t->child[0]);
+      break;
+    default:
+      break;
+  }
+  return t;
+}
+
+/* Function optStmts optimizes the statement
+ * list t and returns its new head
+ */
+static TreeNode * optStmts( TreeNode * t)
+{ TreeNode * head = NULL, * * tail = &head;
+  while (t != NULL)
+  { TreeNode * next = t->sibling;
+    TreeNode * r;
+    t->sibling = NULL;
+    r = optStmt(t);
+    if (r != NULL)
+    { *tail = r;
+      tail = &r->sibling;
+    }
+    t = next;
+  }
+  return head;
+}
+
+/* Procedure optimizeTree folds constant
+ * expressions, removes if and while bodies that
+ * can never run and drops unused locals
+ */
+void optimizeTree(TreeNode * syntaxTree)
+{ TreeNode * t;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if (t->nodekind == DeclareK && t->kind.declare == FuncDK)
+      t->child[1] = optStmts(t->child[1]);
+}
+
+/* the most nodes the body of a function may have
+ * for its calls to be inlined
+ */
+#define INLINE_SIZE 40
+
+/* a name visible while a body is copied to a
+ * call: a parameter or local of the callee and
+ * the name it gets there, or for a parameter the
+ * argument put in its place
+ */
+typedef struct
+   { char * name;
+     char * to;
+     TreeNode * arg;
+   } Subst;
+
+static Subst * subst = NULL;
+static int nsubst = 0, substSize = 0;
+
+/* the parameters and locals visible at the call,
+ * innermost last; a global the inlined body refers
+ * to must not be one of them
+ */
+static char ** scope = NULL;
+static int nscope = 0, scopeSize = 0;
+
+/* the declarations of the program being inlined */
+static TreeNode * program = NULL;
+
+/* the calls inlined so far, also numbering the
+ * names of the inlined variables
+ */
+static int inlined = 0;
+
+/* copyFailed is set when the body cannot be put at
+ * the call; copyingArg turns off the renaming while
+ * an argument, which has the caller's names, is
+ * copied
+ */
+static int copyFailed = FALSE;
+static int copyingArg = FALSE;
+
+/* Function grow returns list p of *size elements
+ * of elem bytes with room for element n, NULL if
+ * out of memory
+ */
+static void * grow( void * p, int n, int * size, size_t elem )
+{ void * q;
+  if (n < *size) return p;
+  q = realloc(p,(*size ? 2 * *size : 16) * elem);
+  if (q == NULL)
+  { fprintf(listing,"Out of memory in inlining\n");
+    Error = TRUE;
+    return NULL;
+  }
+  *size = *size ? 2 * *size : 16;
+  return q;
+}
+
+static int pushSubst( char * name, char * to, TreeNode * arg )
+{ Subst * s = grow(subst,nsubst,&substSize,sizeof(Subst));
+  if (s == NULL) return FALSE;
+  subst = s;
+  subst[nsubst].name = name;
+  subst[nsubst].to = to;
+  subst[nsubst].arg = arg;
+  nsubst++;
+  return TRUE;
+}
+
+static Subst * findSubst( char * name )
+{ int i;
+  for (i=nsubst-1; i >= 0; i--)
+    if (strcmp(subst[i].name,name) == 0) return &subst[i];
+  return NULL;
+}
+
+static int pushScope( char * name )
+{ char ** s = grow(scope,nscope,&scopeSize,sizeof(char *));
+  if (s == NULL) return FALSE;
+  scope = s;
+  scope[nscope++] = name;
+  return TRUE;
+}
+
+static int inScope( char * name )
+{ int i;
+  for (i=nscope-1; i >= 0; i--)
+    if (strcmp(scope[i],name) == 0) return TRUE;
+  return FALSE;
+}
+
+/* Function freshName returns the name a variable
+ * of an inlined body gets; a '.' is never part of
+ * a source identifier
+ */
+static char * freshName( char * name )
+{ char buf[64];
+  snprintf(buf,sizeof(buf),"%.40s.%d",name,inlined);
+  return copyString(buf);
+}
+
+/* Function countNodes counts the nodes of list t,
+ * stopping once there are more than max
+ */
+static int countNodes( TreeNode * t, int max )
+{ int n = 0, i;
+  for (; t != NULL && n <= max; t = t->sibling)
+  { n++;
+    for (i=0; i < MAXCHILDREN; i++)
+      n += countNodes(t->child[i],max - n);
+  }
+  return n;
+}
+
+/* Function hasExp is TRUE when expression t or
+ * one of its subexpressions is of kind k
+ */
+static int hasExp( TreeNode * t, ExpKind k )
+{ int i;
+  TreeNode * c;
+  if (t == NULL) return FALSE;
+  if (t->nodekind == ExpK && t->kind.exp == k) return TRUE;
+  for (i=0; i < MAXCHILDREN; i++)
+    for (c = t->child[i]; c != NULL; c = c->sibling)
+      if (hasExp(c,k)) return TRUE;
+  return FALSE;
+}
+
+/* Function hasReturn is TRUE when list t holds a
+ * return statement
+ */
+static int hasReturn( TreeNode * t )
+{ int i;
+  for (; t != NULL; t = t->sibling)
+  { if (t->nodekind == StmtK && t->kind.stmt == RetK) return TRUE;
+    for (i=0; i < MAXCHILDREN; i++)
+      if (hasReturn(t->child[i])) return TRUE;
+  }
+  return FALSE;
+}
+
+/* Function countUses counts the references to
+ * name in expression t
+ */
+static int countUses( char * name, TreeNode * t )
+{ int n = 0, i;
+  TreeNode * c;
+  if (t->nodekind == ExpK && t->kind.exp == VarK &&
+      strcmp(t->attr.name,name) == 0)
+    n++;
+  for (i=0; i < MAXCHILDREN; i++)
+    for (c = t->child[i]; c != NULL; c = c->sibling)
+      n += countUses(name,c);
+  return n;
+}
+
+/* isName is TRUE for a variable without an index */
+static int isName( TreeNode * t )
+{ return t->nodekind == ExpK && t->kind.exp == VarK &&
+         t->child[0] == NULL;
+}
+
+static TreeNode * copyList( TreeNode * t );
+
+/* Function copyNode copies t and its subtrees but
+ * not its siblings, renaming the callee's names and
+ * putting the arguments in place of parameters.
+ * Sets copyFailed when a global the body refers to
+ * is hidden at the call
+ */
+static TreeNode * copyNode( TreeNode * t )
+{ TreeNode * c, * d;
+  Subst * s = NULL;
+  int mark = nsubst, i;
+  if (!copyingArg &&
+      ((t->nodekind == ExpK &&
+        (t->kind.exp == VarK || t->kind.exp == CallK)) ||
+       t->nodekind == DeclareK))
+  { s = findSubst(t->attr.name);
+    if (s == NULL && inScope(t->attr.name))
+    { copyFailed = TRUE;
+      return NULL;
+    }
+    if (s != NULL && s->arg != NULL)
+    { if (t->child[0] != NULL)
+      { copyFailed = TRUE;
+        return NULL;
+      }
+      copyingArg = TRUE;
+      c = copyNode(s->arg);
+      copyingArg = FALSE;
+      return c;
+    }
+  }
+  c = newExpNode(ConstK);
+  if (c == NULL)
+  { copyFailed = TRUE;
+    return NULL;
+  }
+  *c = *t;
+  c->sibling = NULL;
+  if (s != NULL) c->attr.name = s->to;
+  /* the locals of a block are renamed inside it */
+  if (!copyingArg && t->nodekind == StmtK && t->kind.stmt == CompK)
+    for (d = t->child[0]; d != NULL; d = d->sibling)
+      if (!pushSubst(d->attr.name,freshName(d->attr.name),NULL))
+        copyFailed = TRUE;
+  for (i=0; i < MAXCHILDREN; i++)
+    c->child[i] = copyList(t->child[i]);
+  nsubst = mark;
+  return copyFailed ? NULL : c;
+}
+
+static TreeNode * copyList( TreeNode * t )
+{ TreeNode * head = NULL, * * tail = &head;
+  for (; t != NULL && !copyFailed; t = t->sibling)
+  { *tail = copyNode(t);
+    if (*tail != NULL) tail = &(*tail)->sibling;
+  }
+  return head;
+}
+
+/* Function inlinable returns the declaration of
+ * the function call t calls if its body may be
+ * inlined: it is small, does not call itself and
+ * is not hidden by a local at the call
+ */
+static TreeNode * inlinable( TreeNode * t )
+{ TreeNode * f;
+  if (inScope(t->attr.name)) return NULL;
+  for (f = program; f != NULL; f = f->sibling)
+    if (f->nodekind == DeclareK && f->kind.declare == FuncDK &&
+        strcmp(f->attr.name,t->attr.name) == 0)
+      break;
+  if (f == NULL || f->child[1] == NULL) return NULL;
+  if (countNodes(f->child[1],INLINE_SIZE) > INLINE_SIZE) return NULL;
+  if (isUsed(f->attr.name,f->child[1])) return NULL;
+  return f;
+}
+
+/* the parameters of f, NULL for (void) */
+static TreeNode * params( TreeNode * f )
+{ TreeNode * p = f->child[0];
+  return p != NULL && p->nodekind == DeclareK ? p : NULL;
+}
+
+/* Function inlineExp returns the expression that
+ * replaces call t, NULL if it stays a call. Only a
+ * body that is just "return e;" without assignments
+ * is inlined into an expression: each parameter in
+ * e is replaced by its argument. An argument that
+ * is not a constant or a variable must be free of
+ * side effects and used at most once by an e that
+ * calls nothing, so evaluating it at its use gives
+ * the same value
+ */
+static TreeNode * inlineExp( TreeNode * t )
+{ TreeNode * f = inlinable(t), * b, * e, * p, * a, * c;
+  int mark = nsubst;
+  if (f == NULL || f->type == Void) return NULL;
+  b = f->child[1];
+  if (b->child[0] != NULL || b->child[1] == NULL ||
+      b->child[1]->sibling != NULL ||
+      b->child[1]->nodekind != StmtK || b->child[1]->kind.stmt != RetK ||
+      b->child[1]->child[0] == NULL)
+    return NULL;
+  e = b->child[1]->child[0];
+  if (hasExp(e,AssignK)) return NULL;
+  for (p = params(f), a = t->child[0]; p != NULL && a != NULL;
+       p = p->sibling, a = a->sibling)
+  { int ok;
+    if (p->typeK == ArrayK)
+      ok = isName(a) && pushSubst(p->attr.name,a->attr.name,NULL);
+    else if ((a->nodekind == ExpK && a->kind.exp == ConstK) ||
+             (isName(a) && (inScope(a->attr.name) || !hasExp(e,CallK))))
+      ok = pushSubst(p->attr.name,NULL,a);
+    else
+      ok = !hasExp(a,AssignK) && !hasExp(a,CallK) && !hasExp(e,CallK) &&
+           countUses(p->attr.name,e) <= 1 &&
+           pushSubst(p->attr.name,NULL,a);
+    if (!ok) break;
+  }
+  c = NULL;
+  if (p == NULL && a == NULL)
+  { copyFailed = FALSE;
+    c = copyNode(e);
+  }
+  nsubst = mark;
+  return c;
+}
+
+/* Function inlineStmt returns the block that
+ * replaces statement t when t is a call "f(...);",
+ * "x = f(...);" or "return f(...);" and the body
+ * of f has no return but as its last statement,
+ * NULL if t stays. The parameters and locals of f
+ * become locals of the block under new names; the
+ * scalar parameters are assigned their arguments
+ * first and the value of the final return goes to
+ * x or the return of t
+ */
+static TreeNode * inlineStmt( TreeNode * t )
+{ TreeNode * call = t, * f, * b, * p, * a, * s, * last, * * lp;
+  TreeNode * decls = NULL, * * dtail = &decls;
+  TreeNode * sets = NULL, * * stail = &sets;
+  int mark = nsubst, n = 0;
+  if (t->nodekind == ExpK && t->kind.exp == AssignK && isName(t->child[0]))
+    call = t->child[1];
+  else if (t->nodekind == StmtK && t->kind.stmt == RetK)
+    call = t->child[0];
+  if (call == NULL || call->nodekind != ExpK || call->kind.exp != CallK)
+    return NULL;
+  f = inlinable(call);
+  if (f == NULL) return NULL;
+  b = f->child[1];
+  /* only the last statement may return */
+  for (lp = &b->child[1]; *lp != NULL && (*lp)->sibling != NULL;
+       lp = &(*lp)->sibling)
+    if (hasReturn(*lp)) return NULL;
+  last = *lp;
+  if (last != NULL && hasReturn(last) &&
+      !(last->nodekind == StmtK && last->kind.stmt == RetK))
+    return NULL;
+  if (call != t && (last == NULL || !hasReturn(last) || last->child[0] == NULL))
+    return NULL;
+
+  for (p = params(f), a = call->child[0]; p != NULL && a != NULL;
+       p = p->sibling, a = a->sibling)
+  { if (p->typeK == ArrayK)
+    { if (!isName(a) || !pushSubst(p->attr.name,a->attr.name,NULL)) break;
+    }
+    else if (!pushSubst(p->attr.name,freshName(p->attr.name),NULL)) break;
+    n++;
+  }
+  b = NULL;
+  if (p == NULL && a == NULL)
+  { copyFailed = FALSE;
+    b = copyNode(f->child[1]);
+  }
+  if (b == NULL)
+  { nsubst = mark;
+    return NULL;
+  }
+
+  /* a variable for each scalar parameter, set to
+     its argument in order */
+  for (p = params(f), a = call->child[0], n = mark; p != NULL;
+       p = p->sibling, a = s, n++)
+  { TreeNode * d, * v, * set;
+    s = a->sibling;
+    if (p->typeK == ArrayK) continue;
+    d = newDeclareNode(VarDK);
+    v = newExpNode(VarK);
+    set = newExpNode(AssignK);
+    if (d == NULL || v == NULL || set == NULL)
+    { Error = TRUE;
+      nsubst = mark;
+      return NULL;
+    }
+    d->attr.name = v->attr.name = subst[n].to;
+    d->type = Integer;
+    d->typeK = NArrayK;
+    d->lineno = v->lineno = set->lineno = t->lineno;
+    v->type = set->type = Integer;
+    a->sibling = NULL;
+    set->child[0] = v;
+    set->child[1] = a;
+    *dtail = d;
+    dtail = &d->sibling;
+    *stail = set;
+    stail = &set->sibling;
+  }
+  nsubst = mark;
+  *dtail = b->child[0];
+  b->child[0] = decls;
+  *stail = b->child[1];
+  b->child[1] = sets;
+
+  /* the copy of the last statement is last */
+  for (lp = &b->child[1]; *lp != NULL && (*lp)->sibling != NULL;
+       lp = &(*lp)->sibling)
+    ;
+  if (*lp != NULL && (*lp)->nodekind == StmtK && (*lp)->kind.stmt == RetK)
+  { TreeNode * e = (*lp)->child[0];
+    if (call == t) *lp = e;
+    else if (t->nodekind == StmtK)
+    { t->child[0] = e;
+      *lp = t;
+    }
+    else
+    { t->child[1] = e;
+      *lp = t;
+    }
+  }
+  b->lineno = t->lineno;
+  inlined++;
+  return b;
+}
+
+static TreeNode * inlineStmts( TreeNode * t );
+
+/* Procedure inlineCalls replaces the calls in
+ * expression list *p that inlineExp can inline
+ */
+static void inlineCalls( TreeNode * * p )
+{ for (; *p != NULL; p = &(*p)->sibling)
+  { TreeNode * t = *p, * r;
+    int i;
+    if (t->nodekind != ExpK) continue;
+    for (i=0; i < MAXCHILDREN; i++)
+      inlineCalls(&t->child[i]);
+    if (t->kind.exp == CallK && (r = inlineExp(t)) != NULL)
+    { r->sibling = t->sibling;
+      *p = r;
+      inlined++;
+    }
+  }
+}
+
+/* Function inlineOne inlines the calls in
+ * statement t and returns what replaces it
+ */
+static TreeNode * inlineOne( TreeNode * t )
+{ TreeNode * r;
+  TreeNode * d;
+  int mark;
+  if (t->nodekind == ExpK)
+  { inlineCalls(&t);
+    r = inlineStmt(t);
+    return r != NULL ? r : t;
+  }
+  if (t->nodekind != StmtK) return t;
+  switch (t->kind.stmt)
+  { case CompK:
+      mark = nscope;
+      for (d = t->child[0]; d != NULL; d = d->sibling)
+        pushScope(d->attr.name);
+      t->child[1] = inlineStmts(t->child[1]);
+      nscope = mark;
+      break;
+    case SelectK:
+      inlineCalls(&t->child[0]);
+      t->child[1] = inlineStmts(t->child[1]);
+      t->child[2] = inlineStmts(t->child[2]);
+      break;
+    case IterK:
+      inlineCalls(&t->child[0]);
+      t->child[1] = inlineStmts(t->child[1]);
+      break;
+    case RetK:
+      inlineCalls(&t->child[0]);
+      r = inlineStmt(t);
+      if (r != NULL) return r;
+      break;
+    default:
+      break;
+  }
+  return t;
+}
+
+static TreeNode * inlineStmts( TreeNode * t )
+{ TreeNode * head = NULL, * * tail = &head;
+  while (t != NULL)
+  { TreeNode * next = t->sibling;
+    TreeNode * r;
+    t->sibling = NULL;
+    r = inlineOne(t);
+    *tail = r;
+    tail = &r->sibling;
+    t = next;
+  }
+  return head;
+}
+
+/* Procedure inlineTree inlines the calls to small
+ * functions that do not call themselves, function
+ * by function in order, so a callee has its own
+ * calls inlined before it is copied
+ */
+void inlineTree(TreeNode * syntaxTree)
+{ TreeNode * t, * p;
+  program = syntaxTree;
+  inlined = 0;
+  for (t = syntaxTree; t != NULL && ! Error; t = t->sibling)
+    if (t->nodekind == DeclareK && t->kind.declare == FuncDK &&
+        t->child[1] != NULL)
+    { nscope = 0;
+      for (p = params(t); p != NULL; p = p->sibling)
+        pushScope(p->attr.name);
+      t->child[1] = inlineOne(t->child[1]);
+    }
+  if (TraceAnalyze)
+    fprintf(listing,"\n%d call(s) inlined\n",inlined);
+  free(subst);
+  free(scope);
+  subst = NULL;
+  scope = NULL;
+  nsubst = substSize = nscope = scopeSize = 0;
+}
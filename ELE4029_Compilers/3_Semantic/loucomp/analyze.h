@@ -18,4 +18,16 @@ void buildSymtab(TreeNode *);
  */
 void typeCheck(TreeNode *);
 
+/* Procedure optimizeTree simplifies the checked
+ * syntax tree before code generation
+ */
+void optimizeTree(TreeNode *);
+
+/* Procedure inlineTree replaces the calls to
+ * small functions that do not call themselves by
+ * copies of their bodies in the checked syntax
+ * tree, before optimizeTree
+ */
+void inlineTree(TreeNode *);
+
 #endif
@@ -0,0 +1,147 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Bump-pointer arena and string interning for the  */
+/* C-Minus syntax tree                              */
+/****************************************************/
+
+#include "globals.h"
+#include "arena.h"
+#include <stddef.h>
+
+/* BLOCKSIZE is the size of an arena block; larger
+ * requests get a block of their own */
+#define BLOCKSIZE (64 * 1024)
+
+/* ALIGN is the alignment of every allocation */
+#define ALIGN (sizeof(union { long l; double d; void * p; }))
+
+/* INITBUCKETS is the initial size of the intern table */
+#define INITBUCKETS 256
+
+typedef struct block
+   { struct block * next;
+     size_t size; /* bytes after the header */
+   } Block;
+
+#define BLOCKHDR ((sizeof(Block) + ALIGN - 1) / ALIGN * ALIGN)
+
+typedef struct interned
+   { struct interned * next;
+     unsigned hash;
+     char str[1];
+   } Interned;
+
+struct arena
+   { Block * blocks; /* newest first */
+     char * pos; /* next free byte in blocks */
+     char * end;
+     Interned ** buckets;
+     unsigned nbuckets; /* a power of two */
+     unsigned nstrings;
+   };
+
+Arena * astArena = NULL;
+
+Arena * newArena(void)
+{ Arena * a = (Arena *) calloc(1,sizeof(Arena));
+  if (a == NULL) return NULL;
+  a->buckets = (Interned **) calloc(INITBUCKETS,sizeof(Interned *));
+  if (a->buckets == NULL)
+  { free(a);
+    return NULL;
+  }
+  a->nbuckets = INITBUCKETS;
+  return a;
+}
+
+void * arenaAlloc(Arena * a, size_t size)
+{ Block * b;
+  char * p;
+  size = (size + ALIGN - 1) / ALIGN * ALIGN;
+  if ((size_t)(a->end - a->pos) >= size)
+  { p = a->pos;
+    a->pos += size;
+    return p;
+  }
+  /* a new block; a big request gets its own and the
+     current block stays in use */
+  if (size > BLOCKSIZE / 4)
+  { b = (Block *) malloc(BLOCKHDR + size);
+    if (b == NULL) return NULL;
+    b->size = size;
+    if (a->blocks != NULL)
+    { b->next = a->blocks->next;
+      a->blocks->next = b;
+    }
+    else
+    { b->next = NULL;
+      a->blocks = b;
+    }
+    return (char *) b + BLOCKHDR;
+  }
+  b = (Block *) malloc(BLOCKHDR + BLOCKSIZE);
+  if (b == NULL) return NULL;
+  b->size = BLOCKSIZE;
+  b->next = a->blocks;
+  a->blocks = b;
+  p = (char *) b + BLOCKHDR;
+  a->pos = p + size;
+  a->end = p + BLOCKSIZE;
+  return p;
+}
+
+/* hashString is FNV-1a */
+static unsigned hashString(const char * s, size_t * len)
+{ unsigned h = 2166136261u;
+  const char * p;
+  for (p = s; *p; p++)
+    h = (h ^ (unsigned char) *p) * 16777619u;
+  *len = p - s;
+  return h;
+}
+
+/* growTable doubles the intern table; on failure the
+   old table is kept, only longer chains result */
+static void growTable(Arena * a)
+{ unsigned n = a->nbuckets * 2, i;
+  Interned ** nb = (Interned **) calloc(n,sizeof(Interned *));
+  Interned * e, * next;
+  if (nb == NULL) return;
+  for (i = 0; i < a->nbuckets; i++)
+    for (e = a->buckets[i]; e != NULL; e = next)
+    { next = e->next;
+      e->next = nb[e->hash & (n - 1)];
+      nb[e->hash & (n - 1)] = e;
+    }
+  free(a->buckets);
+  a->buckets = nb;
+  a->nbuckets = n;
+}
+
+char * internString(Arena * a, const char * s)
+{ size_t len;
+  unsigned h = hashString(s,&len);
+  Interned * e;
+  for (e = a->buckets[h & (a->nbuckets - 1)]; e != NULL; e = e->next)
+    if (e->hash == h && !strcmp(e->str,s))
+      return e->str;
+  e = (Interned *) arenaAlloc(a,offsetof(Interned,str) + len + 1);
+  if (e == NULL) return NULL;
+  e->hash = h;
+  memcpy(e->str,s,len + 1);
+  e->next = a->buckets[h & (a->nbuckets - 1)];
+  a->buckets[h & (a->nbuckets - 1)] = e;
+  if (++a->nstrings > a->nbuckets) growTable(a);
+  return e->str;
+}
+
+void freeArena(Arena * a)
+{ Block * b, * next;
+  if (a == NULL) return;
+  for (b = a->blocks; b != NULL; b = next)
+  { next = b->next;
+    free(b);
+  }
+  free(a->buckets);
+  free(a);
+}
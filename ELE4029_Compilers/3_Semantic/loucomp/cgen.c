@@ -18,6 +18,14 @@
 */
 static int tmpOffset = 0;
 
+/* Registers FIRSTTMP to LASTTMP are free in the
+   TM and hold left operands of nested operators
+   before temps are spilled to memory; nextTmp is
+   the next one to hand out, in stack order */
+#define FIRSTTMP 2
+#define LASTTMP 4
+static int nextTmp = FIRSTTMP;
+
 /* prototype for internal recursive code generator */
 static void cGen (TreeNode * tree);
 
@@ -94,9 +102,25 @@ static void genStmt( TreeNode * tree)
     }
 } /* genStmt */
 
+/* isLeaf is TRUE for an operand that can be
+ * loaded into any register by one instruction
+ */
+static int isLeaf( TreeNode * tree)
+{ return tree != NULL && tree->nodekind == ExpK &&
+         (tree->kind.exp == ConstK || tree->kind.exp == IdK);
+}
+
+/* Procedure genLeaf loads leaf tree into reg */
+static void genLeaf( TreeNode * tree, int reg)
+{ if (tree->kind.exp == ConstK)
+    emitRM("LDC",reg,tree->attr.val,0,"load const");
+  else
+    emitRM("LD",reg,st_lookup(tree->attr.name),gp,"load id value");
+}
+
 /* Procedure genExp generates code at an expression node */
 static void genExp( TreeNode * tree)
-{ int loc;
+{ int loc, left;
   TreeNode * p1, * p2;
   switch (tree->kind.exp) {
 
@@ -118,36 +142,52 @@ static void genExp( TreeNode * tree)
          if (TraceCode) emitComment("-> Op") ;
          p1 = tree->child[0];
          p2 = tree->child[1];
-         /* gen code for ac = left arg */
-         cGen(p1);
-         /* gen code to push left operand */
-         emitRM("ST",ac,tmpOffset--,mp,"op: push left");
-         /* gen code for ac = right operand */
-         cGen(p2);
-         /* now load left operand */
-         emitRM("LD",ac1,++tmpOffset,mp,"op: load left");
+         if (isLeaf(p1))
+         { /* right operand first, then the left one
+              straight into ac1; loads have no effects */
+           cGen(p2);
+           genLeaf(p1,ac1);
+           left = ac1;
+         }
+         else if (nextTmp <= LASTTMP)
+         { /* gen code for ac = left arg, kept in a register */
+           cGen(p1);
+           left = nextTmp++;
+           emitRM("LDA",left,0,ac,"op: keep left");
+           /* gen code for ac = right operand */
+           cGen(p2);
+           nextTmp--;
+         }
+         else
+         { /* out of registers, spill as before */
+           cGen(p1);
+           emitRM("ST",ac,tmpOffset--,mp,"op: push left");
+           cGen(p2);
+           emitRM("LD",ac1,++tmpOffset,mp,"op: load left");
+           left = ac1;
+         }
          switch (tree->attr.op) {
             case PLUS :
-               emitRO("ADD",ac,ac1,ac,"op +");
+               emitRO("ADD",ac,left,ac,"op +");
                break;
             case MINUS :
-               emitRO("SUB",ac,ac1,ac,"op -");
+               emitRO("SUB",ac,left,ac,"op -");
                break;
             case TIMES :
-               emitRO("MUL",ac,ac1,ac,"op *");
+               emitRO("MUL",ac,left,ac,"op *");
                break;
             case OVER :
-               emitRO("DIV",ac,ac1,ac,"op /");
+               emitRO("DIV",ac,left,ac,"op /");
                break;
             case LT :
-               emitRO("SUB",ac,ac1,ac,"op <") ;
+               emitRO("SUB",ac,left,ac,"op <") ;
                emitRM("JLT",ac,2,pc,"br if true") ;
                emitRM("LDC",ac,0,ac,"false case") ;
                emitRM("LDA",pc,1,pc,"unconditional jmp") ;
                emitRM("LDC",ac,1,ac,"true case") ;
                break;
             case EQ :
-               emitRO("SUB",ac,ac1,ac,"op ==") ;
+               emitRO("SUB",ac,left,ac,"op ==") ;
                emitRM("JEQ",ac,2,pc,"br if true");
                emitRM("LDC",ac,0,ac,"false case") ;
                emitRM("LDA",pc,1,pc,"unconditional jmp") ;
@@ -166,10 +206,11 @@ static void genExp( TreeNode * tree)
 } /* genExp */
 
 /* Procedure cGen recursively generates code by
- * tree traversal
+ * tree traversal; siblings are taken in a loop,
+ * so only nesting deepens the recursion
  */
 static void cGen( TreeNode * tree)
-{ if (tree != NULL)
+{ for (; tree != NULL; tree = tree->sibling)
   { switch (tree->nodekind) {
       case StmtK:
         genStmt(tree);
@@ -180,7 +221,6 @@ static void cGen( TreeNode * tree)
       default:
         break;
     }
-    cGen(tree->sibling);
   }
 }
 
@@ -0,0 +1,618 @@
+/****************************************************/
+/* File: dfagen.c                                   */
+/* Scanner table generator for the C-Minus compiler */
+/* Reads the definitions and rules of a lex file    */
+/* and writes the minimized DFA of its patterns as  */
+/* C tables for the table-driven scanner in scan.c  */
+/*   dfagen cminus.l > scantab.h                    */
+/****************************************************/
+
+/* The patterns may use "strings", [classes] with
+ * ranges, '.', {definitions}, ( | ), * + ? and \
+ * escapes. A rule whose action returns a token
+ * accepts that token; an action that calls input()
+ * reads a comment, which the scanner skips up to
+ * the closing star-slash; any other action skips
+ * the lexeme. As in lex, the longest match wins
+ * and the earlier rule breaks a tie.
+ * The tables are
+ *   scanClass[c]  the equivalence class of byte c
+ *   scanBase[s]   row of state s in scanNext/scanCheck
+ *   scanNext[i]   the next state, if scanCheck[i] == s
+ *   scanAccept[s] what state s accepts
+ * with a missing transition ending the match
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAXDEFS 64
+#define MAXRULES 128
+#define MAXLINE 1024
+
+static char * progName;
+static char * fileName;
+static int lineNo = 0;
+
+static void fail( char * msg, char * arg )
+{ fprintf(stderr,"%s: %s:%d: %s%s\n",progName,fileName,lineNo,msg,arg);
+  exit(1);
+}
+
+static void * alloc( size_t size )
+{ void * p = calloc(1,size);
+  if (p == NULL) fail("out of memory","");
+  return p;
+}
+
+static char * copyString( char * s, int len )
+{ char * t = alloc(len + 1);
+  memcpy(t,s,len);
+  t[len] = '\0';
+  return t;
+}
+
+/**************************************************/
+/*  the lex file                                  */
+/**************************************************/
+
+static struct { char * name, * pattern; } defs[MAXDEFS];
+static int nDefs = 0;
+
+/* what a rule accepts: a token name, or */
+#define ACT_SKIP "SCAN_SKIP"
+#define ACT_COMMENT "SCAN_COMMENT"
+static struct { char * pattern, * action; int line; } rules[MAXRULES];
+static int nRules = 0;
+
+/* Function patternEnd returns the end of the
+ * pattern starting at s: the first blank
+ * outside quotes and brackets
+ */
+static char * patternEnd( char * s )
+{ int quoted = 0, bracket = 0;
+  for (; *s; s++)
+  { if (*s == '\\' && s[1]) s++;
+    else if (quoted) { if (*s == '"') quoted = 0; }
+    else if (bracket) { if (*s == ']') bracket = 0; }
+    else if (*s == '"') quoted = 1;
+    else if (*s == '[') bracket = 1;
+    else if (isspace((unsigned char) *s)) break;
+  }
+  return s;
+}
+
+/* Function actionOf classifies the action text */
+static char * actionOf( char * text )
+{ char * r = strstr(text,"return");
+  if (r != NULL)
+  { char * e;
+    r += 6;
+    while (isspace((unsigned char) *r)) r++;
+    for (e = r; isalnum((unsigned char) *e) || *e == '_'; e++) ;
+    if (e == r) fail("no token in action ",text);
+    return copyString(r,e - r);
+  }
+  if (strstr(text,"input()") != NULL) return ACT_COMMENT;
+  return ACT_SKIP;
+}
+
+/* Procedure readLex reads the definitions and
+ * rules sections of the lex file f
+ */
+static void readLex( FILE * f )
+{ char line[MAXLINE];
+  int section = 0, inCode = 0;
+  while (section < 2 && fgets(line,MAXLINE,f) != NULL)
+  { char * s = line, * e;
+    lineNo++;
+    if (!strncmp(line,"%%",2)) { section++; continue; }
+    if (!strncmp(line,"%{",2)) { inCode = 1; continue; }
+    if (!strncmp(line,"%}",2)) { inCode = 0; continue; }
+    if (inCode || isspace((unsigned char) *s) || *s == '\0') continue;
+    if (section == 0)
+    { /* name pattern */
+      if (!strncmp(s,"/*",2)) continue;
+      if (nDefs == MAXDEFS) fail("too many definitions","");
+      for (e = s; *e && !isspace((unsigned char) *e); e++) ;
+      defs[nDefs].name = copyString(s,e - s);
+      for (s = e; isspace((unsigned char) *s); s++) ;
+      e = patternEnd(s);
+      defs[nDefs++].pattern = copyString(s,e - s);
+    }
+    else
+    { /* pattern action, the action may run on
+         while its braces are open */
+      char action[4 * MAXLINE];
+      int depth = 0, len = 0;
+      if (nRules == MAXRULES) fail("too many rules","");
+      e = patternEnd(s);
+      rules[nRules].pattern = copyString(s,e - s);
+      rules[nRules].line = lineNo;
+      for (s = e; ; )
+      { for (; *s; s++)
+        { if (*s == '{') depth++;
+          else if (*s == '}') depth--;
+          if (len < (int) sizeof(action) - 1) action[len++] = *s;
+        }
+        if (depth <= 0 || fgets(line,MAXLINE,f) == NULL) break;
+        lineNo++;
+        s = line;
+      }
+      action[len] = '\0';
+      rules[nRules++].action = actionOf(action);
+    }
+  }
+  if (section < 1) fail("no rules section","");
+}
+
+/**************************************************/
+/*  the NFA                                       */
+/**************************************************/
+
+/* a state has a byte set edge to out, or up to
+   two empty edges out and out1 (-1 for none) */
+typedef struct
+{ unsigned char set[32];
+  int hasSet;
+  int out, out1;
+  int accept; /* rule number, or -1 */
+} NfaState;
+
+static NfaState * nfa = NULL;
+static int nNfa = 0, nfaSize = 0;
+
+static int newState(void)
+{ if (nNfa == nfaSize)
+  { nfaSize = nfaSize ? 2 * nfaSize : 256;
+    nfa = realloc(nfa,nfaSize * sizeof(NfaState));
+    if (nfa == NULL) fail("out of memory","");
+  }
+  memset(&nfa[nNfa],0,sizeof(NfaState));
+  nfa[nNfa].out = nfa[nNfa].out1 = nfa[nNfa].accept = -1;
+  return nNfa++;
+}
+
+#define SETBIT(set,c) ((set)[(c) >> 3] |= 1 << ((c) & 7))
+#define HASBIT(set,c) ((set)[(c) >> 3] & (1 << ((c) & 7)))
+
+/* a fragment of the NFA, entered at start
+   and left through the empty edges of end */
+typedef struct { int start, end; } Frag;
+
+static void link( int from, int to )
+{ if (nfa[from].out < 0) nfa[from].out = to;
+  else nfa[from].out1 = to;
+}
+
+static Frag setFrag( unsigned char * set )
+{ Frag f;
+  f.start = newState();
+  f.end = newState();
+  memcpy(nfa[f.start].set,set,32);
+  nfa[f.start].hasSet = 1;
+  nfa[f.start].out = f.end;
+  return f;
+}
+
+static Frag emptyFrag(void)
+{ Frag f;
+  f.start = f.end = newState();
+  return f;
+}
+
+static Frag catFrag( Frag a, Frag b )
+{ link(a.end,b.start);
+  a.end = b.end;
+  return a;
+}
+
+static Frag altFrag( Frag a, Frag b )
+{ Frag f;
+  f.start = newState();
+  f.end = newState();
+  link(f.start,a.start);
+  link(f.start,b.start);
+  link(a.end,f.end);
+  link(b.end,f.end);
+  return f;
+}
+
+/* the pattern being parsed */
+static char * pat;
+
+static int escape(void)
+{ int c = (unsigned char) *pat++;
+  switch (c)
+  { case 'n': return '\n';
+    case 't': return '\t';
+    case 'r': return '\r';
+    case 'f': return '\f';
+    case 'v': return '\v';
+    case '0': return '\0';
+    case '\0': fail("pattern ends in \\","");
+  }
+  return c;
+}
+
+static Frag parseAlt(void);
+
+static Frag parseAtom(void)
+{ unsigned char set[32];
+  Frag f;
+  int c;
+  memset(set,0,32);
+  switch (*pat)
+  { case '(':
+      pat++;
+      f = parseAlt();
+      if (*pat++ != ')') fail("missing ) in pattern","");
+      return f;
+    case '"':
+      pat++;
+      f = emptyFrag();
+      while (*pat != '"')
+      { if (*pat == '\0') fail("missing \" in pattern","");
+        c = *pat == '\\' ? (pat++, escape()) : (unsigned char) *pat++;
+        memset(set,0,32);
+        SETBIT(set,c);
+        f = catFrag(f,setFrag(set));
+      }
+      pat++;
+      return f;
+    case '[':
+    { int negate = 0, lo;
+      pat++;
+      if (*pat == '^') { negate = 1; pat++; }
+      while (*pat != ']')
+      { if (*pat == '\0') fail("missing ] in pattern","");
+        lo = *pat == '\\' ? (pat++, escape()) : (unsigned char) *pat++;
+        c = lo;
+        if (*pat == '-' && pat[1] != ']' && pat[1] != '\0')
+        { pat++;
+          c = *pat == '\\' ? (pat++, escape()) : (unsigned char) *pat++;
+        }
+        for (; lo <= c; lo++) SETBIT(set,lo);
+      }
+      pat++;
+      if (negate)
+        for (c = 0; c < 32; c++) set[c] = ~set[c];
+      return setFrag(set);
+    }
+    case '.':
+      pat++;
+      for (c = 0; c < 256; c++)
+        if (c != '\n') SETBIT(set,c);
+      return setFrag(set);
+    case '{':
+    { char * e = strchr(pat,'}'), * save;
+      int i;
+      if (e == NULL) fail("missing } in pattern","");
+      for (i = 0; i < nDefs; i++)
+        if ((int) strlen(defs[i].name) == e - pat - 1 &&
+            !strncmp(defs[i].name,pat + 1,e - pat - 1)) break;
+      if (i == nDefs) fail("undefined name in ",pat);
+      save = e + 1;
+      pat = defs[i].pattern;
+      f = parseAlt();
+      if (*pat != '\0') fail("bad pattern ",defs[i].pattern);
+      pat = save;
+      return f;
+    }
+    case '\\':
+      pat++;
+      c = escape();
+      break;
+    case '\0': case '|': case ')': case '*': case '+': case '?':
+      fail("bad pattern at ",pat);
+      return emptyFrag();
+    default:
+      c = (unsigned char) *pat++;
+  }
+  SETBIT(set,c);
+  return setFrag(set);
+}
+
+static Frag parseRepeat(void)
+{ Frag f = parseAtom();
+  while (*pat == '*' || *pat == '+' || *pat == '?')
+  { Frag g;
+    g.start = newState();
+    g.end = newState();
+    link(g.start,f.start);
+    link(f.end,g.end);
+    if (*pat != '+') link(g.start,g.end);
+    if (*pat != '?') link(f.end,f.start);
+    pat++;
+    f = g;
+  }
+  return f;
+}
+
+static Frag parseCat(void)
+{ Frag f = parseRepeat();
+  while (*pat != '\0' && *pat != '|' && *pat != ')')
+    f = catFrag(f,parseRepeat());
+  return f;
+}
+
+static Frag parseAlt(void)
+{ Frag f = parseCat();
+  while (*pat == '|')
+  { pat++;
+    f = altFrag(f,parseCat());
+  }
+  return f;
+}
+
+/* Function buildNfa joins the rule patterns
+ * under one start state and returns it
+ */
+static int buildNfa(void)
+{ int start = newState(), i;
+  Frag all;
+  all.start = all.end = start;
+  for (i = 0; i < nRules; i++)
+  { Frag f;
+    lineNo = rules[i].line;
+    pat = rules[i].pattern;
+    f = parseAlt();
+    if (*pat != '\0') fail("bad pattern at ",pat);
+    nfa[f.end].accept = i;
+    if (i == 0) nfa[start].out = f.start;
+    else
+    { /* a chain of alternations */
+      int s = newState();
+      nfa[s].out = f.start;
+      nfa[all.end].out1 = s;
+      all.end = s;
+    }
+  }
+  return start;
+}
+
+/**************************************************/
+/*  the DFA                                       */
+/**************************************************/
+
+/* a DFA state is a set of NFA states, one byte
+   per NFA state; trans[c] is -1 for no move */
+typedef struct
+{ char * set;
+  int trans[256];
+  int accept;
+} DfaState;
+
+static DfaState * dfa = NULL;
+static int nDfa = 0, dfaSize = 0;
+
+static void closure( char * set )
+{ int * stack = alloc(nNfa * sizeof(int)), sp = 0, i;
+  for (i = 0; i < nNfa; i++)
+    if (set[i]) stack[sp++] = i;
+  while (sp > 0)
+  { NfaState * s = &nfa[stack[--sp]];
+    if (s->hasSet) continue;
+    if (s->out >= 0 && !set[s->out]) { set[s->out] = 1; stack[sp++] = s->out; }
+    if (s->out1 >= 0 && !set[s->out1]) { set[s->out1] = 1; stack[sp++] = s->out1; }
+  }
+  free(stack);
+}
+
+/* Function addDfa returns the DFA state of
+ * set, adding it if new; set is taken over
+ */
+static int addDfa( char * set )
+{ int i, any = 0;
+  for (i = 0; i < nNfa && !any; i++) any = set[i];
+  if (!any) { free(set); return -1; }
+  for (i = 0; i < nDfa; i++)
+    if (!memcmp(dfa[i].set,set,nNfa)) { free(set); return i; }
+  if (nDfa == dfaSize)
+  { dfaSize = dfaSize ? 2 * dfaSize : 64;
+    dfa = realloc(dfa,dfaSize * sizeof(DfaState));
+    if (dfa == NULL) fail("out of memory","");
+  }
+  dfa[nDfa].set = set;
+  dfa[nDfa].accept = -1;
+  for (i = 0; i < nNfa; i++)
+    if (set[i] && nfa[i].accept >= 0 &&
+        (dfa[nDfa].accept < 0 || nfa[i].accept < dfa[nDfa].accept))
+      dfa[nDfa].accept = nfa[i].accept;
+  return nDfa++;
+}
+
+/* Procedure buildDfa runs the subset
+ * construction from NFA state start
+ */
+static void buildDfa( int start )
+{ char * set = alloc(nNfa);
+  int d, c, i;
+  set[start] = 1;
+  closure(set);
+  addDfa(set);
+  for (d = 0; d < nDfa; d++)
+    for (c = 0; c < 256; c++)
+    { set = alloc(nNfa);
+      for (i = 0; i < nNfa; i++)
+        if (dfa[d].set[i] && nfa[i].hasSet && HASBIT(nfa[i].set,c))
+          set[nfa[i].out] = 1;
+      closure(set);
+      dfa[d].trans[c] = addDfa(set);
+    }
+}
+
+/* Procedure minimize merges the equivalent DFA
+ * states by partition refinement, starting from
+ * the partition by accepted rule; state 0 stays
+ * the start state
+ */
+static void minimize(void)
+{ int * part = alloc(nDfa * sizeof(int));
+  int * next = alloc(nDfa * sizeof(int));
+  int nPart = 0, nNext, i, j, c;
+  for (i = 0; i < nDfa; i++)
+  { for (j = 0; j < i && dfa[j].accept != dfa[i].accept; j++)
+      ;
+    part[i] = j < i ? part[j] : nPart++;
+  }
+  for (;;)
+  { nNext = 0;
+    for (i = 0; i < nDfa; i++)
+    { for (j = 0; j < i; j++)
+      { if (part[j] != part[i]) continue;
+        for (c = 0; c < 256; c++)
+        { int a = dfa[i].trans[c], b = dfa[j].trans[c];
+          if ((a < 0 ? -1 : part[a]) != (b < 0 ? -1 : part[b])) break;
+        }
+        if (c == 256) break;
+      }
+      next[i] = j < i ? next[j] : nNext++;
+    }
+    if (nNext == nPart) break;
+    memcpy(part,next,nDfa * sizeof(int));
+    nPart = nNext;
+  }
+  /* keep the first state of each part */
+  for (i = 0, j = 0; i < nDfa; i++)
+    if (part[i] == j)
+    { for (c = 0; c < 256; c++)
+        if (dfa[i].trans[c] >= 0) dfa[i].trans[c] = part[dfa[i].trans[c]];
+      dfa[j++] = dfa[i];
+    }
+  nDfa = nPart;
+  free(part);
+  free(next);
+}
+
+/**************************************************/
+/*  the tables                                    */
+/**************************************************/
+
+static int charClass[256];
+static int classChar[256]; /* a byte of each class */
+static int nClasses = 0;
+
+/* Procedure makeClasses puts bytes that every
+ * state treats alike in one class
+ */
+static void makeClasses(void)
+{ int c, k, d;
+  for (c = 0; c < 256; c++)
+  { for (k = 0; k < nClasses; k++)
+    { for (d = 0; d < nDfa; d++)
+        if (dfa[d].trans[c] != dfa[d].trans[classChar[k]]) break;
+      if (d == nDfa) break;
+    }
+    if (k == nClasses) classChar[nClasses++] = c;
+    charClass[c] = k;
+  }
+}
+
+static int * base, * tnext, * tcheck;
+static int tsize = 0;
+
+/* Procedure packRows lays the rows over each
+ * other, the fullest first, each at the lowest
+ * base where its transitions fit in the holes
+ * (row displacement)
+ */
+static void packRows(void)
+{ int * order = alloc(nDfa * sizeof(int)), * count = alloc(nDfa * sizeof(int));
+  int max = nDfa * nClasses, i, j, k, b;
+  base = alloc(nDfa * sizeof(int));
+  tnext = alloc(max * sizeof(int));
+  tcheck = alloc(max * sizeof(int));
+  for (i = 0; i < max; i++) tcheck[i] = -1;
+  for (i = 0; i < nDfa; i++)
+  { order[i] = i;
+    for (k = 0; k < nClasses; k++)
+      if (dfa[i].trans[classChar[k]] >= 0) count[i]++;
+  }
+  for (i = 1; i < nDfa; i++)
+    for (j = i; j > 0 && count[order[j]] > count[order[j-1]]; j--)
+    { int t = order[j]; order[j] = order[j-1]; order[j-1] = t; }
+  for (i = 0; i < nDfa; i++)
+  { int d = order[i];
+    for (b = 0; ; b++)
+    { for (k = 0; k < nClasses; k++)
+        if (dfa[d].trans[classChar[k]] >= 0 && tcheck[b+k] >= 0) break;
+      if (k == nClasses) break;
+    }
+    base[d] = b;
+    for (k = 0; k < nClasses; k++)
+      if (dfa[d].trans[classChar[k]] >= 0)
+      { tnext[b+k] = dfa[d].trans[classChar[k]];
+        tcheck[b+k] = d;
+      }
+    if (b + nClasses > tsize) tsize = b + nClasses;
+  }
+  free(order);
+  free(count);
+}
+
+static void printTable( char * type, char * name, int * v, int n )
+{ int i;
+  printf("static const %s %s[%d] =\n{",type,name,n);
+  for (i = 0; i < n; i++)
+    printf("%s%3d%s",i % 16 ? "" : "\n  ",v[i],i < n - 1 ? "," : "");
+  printf("\n};\n\n");
+}
+
+/* Procedure commentLine prints text as
+ * a line of the header comment box
+ */
+static void commentLine( char * text )
+{ printf("/* %-48s */\n",text);
+}
+
+static void writeTables(void)
+{ char line[MAXLINE];
+  int i;
+  printf("/****************************************************/\n");
+  commentLine("File: scantab.h");
+  sprintf(line,"Scanner tables generated by dfagen from %.8s",fileName);
+  commentLine(line);
+  commentLine("Do not edit; the Makefile remakes it");
+  sprintf(line,"%d rules, %d states, %d character classes,",
+          nRules,nDfa,nClasses);
+  commentLine(line);
+  sprintf(line,"%d table entries",tsize);
+  commentLine(line);
+  printf("/****************************************************/\n\n");
+  printf("#define SCAN_STATES %d\n",nDfa);
+  printf("#define SCAN_CLASSES %d\n",nClasses);
+  printf("#define SCAN_START 0\n\n");
+  printTable("unsigned char","scanClass",charClass,256);
+  printTable("short","scanBase",base,nDfa);
+  printTable("short","scanNext",tnext,tsize);
+  printTable("short","scanCheck",tcheck,tsize);
+  printf("static const int scanAccept[%d] =\n{",nDfa);
+  for (i = 0; i < nDfa; i++)
+    printf("%s%s%s",i % 6 ? " " : "\n  ",
+           dfa[i].accept < 0 ? "SCAN_NONE" : rules[dfa[i].accept].action,
+           i < nDfa - 1 ? "," : "");
+  printf("\n};\n");
+}
+
+int main( int argc, char * argv[] )
+{ FILE * f;
+  progName = argv[0];
+  if (argc != 2)
+  { fprintf(stderr,"usage: %s <lex file>\n",progName);
+    exit(1);
+  }
+  fileName = argv[1];
+  f = fopen(fileName,"r");
+  if (f == NULL) fail("cannot open","");
+  readLex(f);
+  fclose(f);
+  buildDfa(buildNfa());
+  minimize();
+  makeClasses();
+  packRows();
+  writeTables();
+  return 0;
+}
@@ -0,0 +1,131 @@
+/****************************************************/
+/* File: fncache.c                                  */
+/* Function fingerprints for the change report of   */
+/* the C-Minus compiler (-fchanges)                 */
+/* The .fnc file has one line "name hash" per       */
+/* function of the last compilation                 */
+/****************************************************/
+
+#include "globals.h"
+#include "fncache.h"
+
+/* the hash is FNV-1a over the tree in preorder */
+#define FNVBASIS 2166136261u
+#define FNVPRIME 16777619u
+
+static unsigned mix( unsigned h, unsigned v )
+{ int i;
+  for (i=0;i<4;i++)
+  { h ^= (v >> (8 * i)) & 0xff;
+    h *= FNVPRIME;
+  }
+  return h;
+}
+
+static unsigned mixString( unsigned h, char * s )
+{ if (s == NULL) return mix(h,0);
+  while (*s != '\0')
+  { h ^= (unsigned char) *s++;
+    h *= FNVPRIME;
+  }
+  return mix(h,0);
+}
+
+/* hashList folds the sibling list t into h; a
+ * marker closes every list so shapes differ
+ */
+static unsigned hashList( unsigned h, TreeNode * t )
+{ for (; t != NULL; t = t->sibling)
+  { int i;
+    h = mix(h,t->nodekind);
+    switch (t->nodekind)
+    { case StmtK:
+        h = mix(h,t->kind.stmt);
+        break;
+      case ExpK:
+        h = mix(h,t->kind.exp);
+        if (t->kind.exp == BinK) h = mix(h,t->attr.op);
+        else if (t->kind.exp == ConstK) h = mix(h,t->attr.val);
+        else if (t->kind.exp != TypeK) h = mixString(h,t->attr.name);
+        break;
+      case DeclareK:
+        h = mix(h,t->kind.declare);
+        h = mixString(h,t->attr.name);
+        break;
+    }
+    h = mix(h,t->typeK);
+    h = mix(h,t->type);
+    for (i=0; i < MAXCHILDREN; i++)
+      h = hashList(h,t->child[i]);
+  }
+  return mix(h,0xffffffffu);
+}
+
+unsigned funcHash( TreeNode * t )
+{ unsigned h = FNVBASIS;
+  int i;
+  h = mix(h,t->nodekind);
+  h = mixString(h,t->attr.name);
+  h = mix(h,t->type);
+  for (i=0; i < MAXCHILDREN; i++)
+    h = hashList(h,t->child[i]);
+  return h;
+}
+
+/* the entries of the .fnc file read back */
+typedef struct
+   { char name[64];
+     unsigned hash;
+   } Entry;
+
+static Entry * readHashes( char * name, int * count )
+{ FILE * f = fopen(name,"r");
+  Entry * e = NULL;
+  int n = 0, size = 0;
+  char fname[64];
+  unsigned h;
+  *count = 0;
+  if (f == NULL) return NULL;
+  while (fscanf(f,"%63s %x",fname,&h) == 2)
+  { if (n == size)
+    { Entry * p;
+      size = size ? 2 * size : 32;
+      p = (Entry *) realloc(e,size * sizeof(Entry));
+      if (p == NULL) break;
+      e = p;
+    }
+    strcpy(e[n].name,fname);
+    e[n].hash = h;
+    n++;
+  }
+  fclose(f);
+  *count = n;
+  return e;
+}
+
+int reportChanges( TreeNode * syntaxTree, char * name )
+{ int n, i, nchanged = 0;
+  Entry * old = readHashes(name,&n);
+  TreeNode * t;
+  FILE * f = fopen(name,"w");
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+  { unsigned h;
+    int same = FALSE;
+    if (t->nodekind != DeclareK || t->kind.declare != FuncDK) continue;
+    h = funcHash(t);
+    for (i=0;i<n;i++)
+      if (strcmp(old[i].name,t->attr.name) == 0)
+      { same = old[i].hash == h;
+        break;
+      }
+    if (!same)
+    { nchanged++;
+      fprintf(listing,"  %s\n",t->attr.name);
+    }
+    if (f != NULL) fprintf(f,"%s %08x\n",t->attr.name,h);
+  }
+  free(old);
+  if (f == NULL) return -1;
+  fclose(f);
+  return nchanged;
+}
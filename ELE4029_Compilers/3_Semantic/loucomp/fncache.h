@@ -0,0 +1,27 @@
+/****************************************************/
+/* File: fncache.h                                  */
+/* Function fingerprints for the change report of   */
+/* the C-Minus compiler (-fchanges)                 */
+/****************************************************/
+
+#ifndef _FNCACHE_H_
+#define _FNCACHE_H_
+
+/* Function funcHash returns a hash of the function
+ * declaration t, its signature and body; equal
+ * token streams give equal hashes whatever their
+ * line numbers
+ */
+unsigned funcHash( TreeNode * t );
+
+/* Function reportChanges compares every function
+ * of syntaxTree with its hash in the file name,
+ * lists the changed ones in the listing, then
+ * rewrites the file. Nothing is skipped: the
+ * report is only for the user. Returns the number
+ * of functions that changed, or -1 if the file
+ * could not be written
+ */
+int reportChanges( TreeNode * syntaxTree, char * name );
+
+#endif
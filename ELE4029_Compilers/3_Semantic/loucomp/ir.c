@@ -0,0 +1,1586 @@
+/****************************************************/
+/* File: ir.c                                       */
+/* Intermediate code for the C-Minus compiler:      */
+/* lowering from the syntax tree, SSA form, the     */
+/* optimization passes and TM code generation       */
+/****************************************************/
+
+#include "globals.h"
+#include "arena.h"
+#include "code.h"
+#include "ir.h"
+
+/* the frame pointer of the generated code */
+#define fp 4
+
+typedef enum
+{ IrConst, IrParam, IrCopy, IrGAddr, IrFAddr,
+  IrAdd, IrSub, IrMul, IrDiv,
+  IrLt, IrLe, IrGt, IrGe, IrEq, IrNe,
+  IrLoad, IrStore, IrCall, IrPhi,
+  IrJump, IrBr, IrRet
+} IrOp;
+
+static char * opName[] =
+{ "const", "param", "copy", "gaddr", "faddr",
+  "add", "sub", "mul", "div",
+  "lt", "le", "gt", "ge", "eq", "ne",
+  "load", "store", "call", "phi",
+  "jump", "br", "ret"
+};
+
+/* what an IrCall calls */
+#define CALL_USER 0
+#define CALL_INPUT 1
+#define CALL_OUTPUT 2
+
+typedef struct irBlock IrBlock;
+
+/* An instruction defines value dst (-1 for none)
+ * from values a and b (-1 for none) and constant k:
+ *   const    dst = k
+ *   param    dst = argument k
+ *   gaddr    dst = gp + k, a global
+ *   faddr    dst = address of word k of the local arrays
+ *   load     dst = mem[a]
+ *   store    mem[a] = b
+ *   call     dst = name(args), k is CALL_USER or a builtin
+ *   phi      dst = args[i] coming from pred[i]; k is the
+ *            variable it was placed for
+ *   jump     to succ[0]
+ *   br       to succ[0] if a is not 0, else succ[1]
+ *   ret      a, or nothing if a is -1
+ * The last three end a block
+ */
+typedef struct irIns
+{ IrOp op;
+  int dst, a, b, k;
+  char * name;
+  int nargs;
+  int * args;
+  struct irIns * prev, * next;
+  IrBlock * block;
+} IrIns;
+
+struct irBlock
+{ int id; /* index in fn->blocks */
+  IrIns * first, * last;
+  IrBlock * succ[2];
+  int nsucc;
+  IrBlock ** pred;
+  int npred;
+  IrBlock * idom;
+  IrBlock ** kids; /* children in the dominator tree */
+  int nkids;
+  IrBlock ** df; /* dominance frontier */
+  int ndf, dfSize;
+  int loc; /* TM location, -1 before it is generated */
+};
+
+/* what is known of each value */
+typedef struct
+{ int isVar; /* a source variable, before SSA form */
+  IrIns * def; /* the defining instruction */
+  int repl; /* the value it is replaced by */
+  int uses;
+  int slot; /* frame slot, -1 for none */
+} ValInfo;
+
+typedef struct irFunc
+{ char * name;
+  int nparams;
+  int isVoid;
+  IrBlock ** blocks;
+  int nblocks, blockSize;
+  ValInfo * val;
+  int nvals, valSize;
+  int undef; /* the value of variables never assigned, -1 until needed */
+  int arrayWords; /* the local arrays */
+  int arrayTop; /* the words of the arrays in scope */
+  int entryLoc;
+  struct irFunc * next;
+} IrFunc;
+
+static Arena * irArena = NULL;
+static IrFunc * funcs = NULL;
+static IrFunc * fn; /* the function being worked on */
+static int globalWords = 0;
+
+/* the pass counts of fn, listed if TraceCode */
+static int nCopies, nCse, nHoisted, nDead;
+
+static void outOfMemory(void)
+{ fprintf(listing,"Out of memory in intermediate code\n");
+  exit(1);
+}
+
+static void * irAlloc( size_t size )
+{ void * p = arenaAlloc(irArena,size);
+  if (p == NULL) outOfMemory();
+  memset(p,0,size);
+  return p;
+}
+
+/* Function grow returns array p of *size
+ * elements of elem bytes, or a copy twice as
+ * large if n elements do not fit
+ */
+static void * grow( void * p, int n, int * size, size_t elem )
+{ void * q;
+  int newSize;
+  if (n < *size) return p;
+  newSize = *size ? 2 * *size : 16;
+  while (newSize <= n) newSize *= 2;
+  q = irAlloc(newSize * elem);
+  if (p != NULL) memcpy(q,p,*size * elem);
+  *size = newSize;
+  return q;
+}
+
+static int newVal( int isVar )
+{ ValInfo * v;
+  fn->val = grow(fn->val,fn->nvals,&fn->valSize,sizeof(ValInfo));
+  v = &fn->val[fn->nvals];
+  v->isVar = isVar;
+  v->def = NULL;
+  v->repl = fn->nvals;
+  v->uses = 0;
+  v->slot = -1;
+  return fn->nvals++;
+}
+
+static IrBlock * newBlock(void)
+{ IrBlock * b = irAlloc(sizeof(IrBlock));
+  fn->blocks = grow(fn->blocks,fn->nblocks,&fn->blockSize,sizeof(IrBlock *));
+  b->id = fn->nblocks;
+  b->loc = -1;
+  fn->blocks[fn->nblocks++] = b;
+  return b;
+}
+
+static IrIns * newIns( IrOp op, int dst, int a, int b, int k )
+{ IrIns * i = irAlloc(sizeof(IrIns));
+  i->op = op;
+  i->dst = dst;
+  i->a = a;
+  i->b = b;
+  i->k = k;
+  return i;
+}
+
+static int isEnd( IrOp op )
+{ return op == IrJump || op == IrBr || op == IrRet; }
+
+static void append( IrBlock * b, IrIns * i )
+{ i->block = b;
+  i->prev = b->last;
+  i->next = NULL;
+  if (b->last) b->last->next = i;
+  else b->first = i;
+  b->last = i;
+}
+
+/* insertBefore puts i before at, or at the end
+ * of block b if at is NULL
+ */
+static void insertBefore( IrBlock * b, IrIns * at, IrIns * i )
+{ if (at == NULL)
+  { append(b,i);
+    return;
+  }
+  i->block = b;
+  i->next = at;
+  i->prev = at->prev;
+  if (at->prev) at->prev->next = i;
+  else b->first = i;
+  at->prev = i;
+}
+
+static void unlink( IrIns * i )
+{ IrBlock * b = i->block;
+  if (i->prev) i->prev->next = i->next;
+  else b->first = i->next;
+  if (i->next) i->next->prev = i->prev;
+  else b->last = i->prev;
+  i->prev = i->next = NULL;
+}
+
+/* mapUses replaces every value i uses by f of it */
+static void mapUses( IrIns * i, int (* f) (int) )
+{ int j;
+  if (i->a >= 0) i->a = f(i->a);
+  if (i->b >= 0) i->b = f(i->b);
+  for (j=0;j<i->nargs;j++)
+    if (i->args[j] >= 0) i->args[j] = f(i->args[j]);
+}
+
+/**************************************************/
+/*  lowering the syntax tree                      */
+/**************************************************/
+
+typedef enum
+{ SymGlobal, SymGlobalArray, SymLocal, SymLocalArray,
+  SymParamArray, SymFunc
+} SymKind;
+
+/* a visible declaration: the offset of a global
+ * or local array, the value of a local or array
+ * parameter, or the builtin code of a function
+ */
+typedef struct
+{ char * name;
+  SymKind kind;
+  int val;
+  int isVoid;
+  IrFunc * func;
+} Sym;
+
+static Sym * syms = NULL;
+static int nsyms = 0, symSize = 0;
+
+/* the block being filled, NULL after a jump */
+static IrBlock * cur;
+
+static Sym * declare( char * name, SymKind kind, int val )
+{ Sym * s;
+  syms = grow(syms,nsyms,&symSize,sizeof(Sym));
+  s = &syms[nsyms++];
+  s->name = name;
+  s->kind = kind;
+  s->val = val;
+  s->isVoid = FALSE;
+  s->func = NULL;
+  return s;
+}
+
+static Sym * lookup( char * name )
+{ int i;
+  for (i=nsyms-1;i>=0;i--)
+    if (strcmp(syms[i].name,name) == 0) return &syms[i];
+  return NULL;
+}
+
+static IrIns * emit( IrOp op, int dst, int a, int b, int k )
+{ IrIns * i = newIns(op,dst,a,b,k);
+  if (cur == NULL) cur = newBlock();
+  append(cur,i);
+  if (dst >= 0) fn->val[dst].def = i;
+  return i;
+}
+
+/* endBlock ends the current block with op
+ * going to s0 and s1
+ */
+static void endBlock( IrOp op, int a, IrBlock * s0, IrBlock * s1 )
+{ IrIns * i = emit(op,-1,a,-1,0);
+  IrBlock * b = i->block;
+  b->succ[0] = s0;
+  b->succ[1] = s1;
+  b->nsucc = s1 ? 2 : s0 ? 1 : 0;
+  cur = NULL;
+}
+
+/* startBlock continues in b after a jump to it */
+static void startBlock( IrBlock * b )
+{ if (cur != NULL) endBlock(IrJump,-1,b,NULL);
+  cur = b;
+}
+
+static int constant( int k )
+{ int d = newVal(FALSE);
+  emit(IrConst,d,-1,-1,k);
+  return d;
+}
+
+static int binary( IrOp op, int a, int b )
+{ int d = newVal(FALSE);
+  emit(op,d,a,b,0);
+  return d;
+}
+
+static IrOp binOp( TokenType op )
+{ switch (op)
+  { case PLUS: return IrAdd;
+    case MINUS: return IrSub;
+    case TIMES: return IrMul;
+    case OVER: return IrDiv;
+    case LT: return IrLt;
+    case LE: return IrLe;
+    case GT: return IrGt;
+    case GE: return IrGe;
+    case EQ: return IrEq;
+    default: return IrNe;
+  }
+}
+
+static int lowerExp( TreeNode * t );
+
+/* arrayBase returns the address of array s */
+static int arrayBase( Sym * s )
+{ int d = newVal(FALSE);
+  if (s->kind == SymGlobalArray) emit(IrGAddr,d,-1,-1,s->val);
+  else if (s->kind == SymLocalArray) emit(IrFAddr,d,-1,-1,s->val);
+  else emit(IrCopy,d,s->val,-1,0);
+  return d;
+}
+
+/* address returns the address of the global or
+ * array element t names, declared by s
+ */
+static int address( TreeNode * t, Sym * s )
+{ int d;
+  if (s->kind == SymGlobal)
+  { d = newVal(FALSE);
+    emit(IrGAddr,d,-1,-1,s->val);
+    return d;
+  }
+  d = arrayBase(s);
+  return binary(IrAdd,d,lowerExp(t->child[0]));
+}
+
+static int lowerCall( TreeNode * t )
+{ Sym * s = lookup(t->attr.name);
+  TreeNode * a;
+  IrIns * i;
+  int n = 0, d = -1, * args;
+  for (a = t->child[0]; a != NULL; a = a->sibling) n++;
+  args = irAlloc((n + 1) * sizeof(int));
+  n = 0;
+  for (a = t->child[0]; a != NULL; a = a->sibling)
+    args[n++] = lowerExp(a);
+  if (!s->isVoid) d = newVal(FALSE);
+  i = emit(IrCall,d,-1,-1,s->val);
+  i->name = s->name;
+  i->nargs = n;
+  i->args = args;
+  return d;
+}
+
+/* lowerExp returns the value of expression t */
+static int lowerExp( TreeNode * t )
+{ Sym * s;
+  int a, d;
+  switch (t->kind.exp)
+  { case ConstK:
+      return constant(t->attr.val);
+    case VarK: case IdK:
+      s = lookup(t->attr.name);
+      if (s->kind == SymLocal)
+      { /* a copy keeps the value read here */
+        d = newVal(FALSE);
+        emit(IrCopy,d,s->val,-1,0);
+        return d;
+      }
+      if (t->child[0] == NULL && s->kind != SymGlobal)
+        return arrayBase(s);
+      a = address(t,s);
+      d = newVal(FALSE);
+      emit(IrLoad,d,a,-1,0);
+      return d;
+    case AssignK:
+      s = lookup(t->child[0]->attr.name);
+      if (s->kind == SymLocal)
+      { d = lowerExp(t->child[1]);
+        emit(IrCopy,s->val,d,-1,0);
+        return d;
+      }
+      a = address(t->child[0],s);
+      d = lowerExp(t->child[1]);
+      emit(IrStore,-1,a,d,0);
+      return d;
+    case BinK:
+      a = lowerExp(t->child[0]);
+      return binary(binOp(t->attr.op),a,lowerExp(t->child[1]));
+    case CallK:
+      return lowerCall(t);
+    default:
+      return constant(0);
+  }
+}
+
+static void lowerStmts( TreeNode * t );
+
+/* declareLocals declares the variables of
+ * compound statement t
+ */
+static void declareLocals( TreeNode * t )
+{ for (; t != NULL; t = t->sibling)
+  { if (t->typeK == ArrayK)
+    { declare(t->attr.name,SymLocalArray,fn->arrayTop);
+      fn->arrayTop += t->child[0]->attr.val;
+      if (fn->arrayTop > fn->arrayWords) fn->arrayWords = fn->arrayTop;
+    }
+    else
+    { /* a variable starts out 0 */
+      int v = newVal(TRUE);
+      declare(t->attr.name,SymLocal,v);
+      emit(IrConst,v,-1,-1,0);
+    }
+  }
+}
+
+static void lowerStmt( TreeNode * t )
+{ IrBlock * b, * e, * j;
+  int mark, top;
+  if (t->nodekind == ExpK)
+  { lowerExp(t);
+    return;
+  }
+  switch (t->kind.stmt)
+  { case CompK:
+      /* the arrays of disjoint blocks share words */
+      mark = nsyms;
+      top = fn->arrayTop;
+      declareLocals(t->child[0]);
+      lowerStmts(t->child[1]);
+      nsyms = mark;
+      fn->arrayTop = top;
+      break;
+    case SelectK:
+      b = newBlock();
+      e = t->child[2] ? newBlock() : NULL;
+      j = newBlock();
+      endBlock(IrBr,lowerExp(t->child[0]),b,e ? e : j);
+      cur = b;
+      lowerStmts(t->child[1]);
+      if (e)
+      { startBlock(j);
+        cur = e;
+        lowerStmts(t->child[2]);
+      }
+      startBlock(j);
+      break;
+    case IterK:
+      j = newBlock();
+      b = newBlock();
+      e = newBlock();
+      startBlock(j);
+      endBlock(IrBr,lowerExp(t->child[0]),b,e);
+      cur = b;
+      lowerStmts(t->child[1]);
+      startBlock(j);
+      cur = e;
+      break;
+    case RetK:
+      endBlock(IrRet,t->child[0] ? lowerExp(t->child[0]) : -1,NULL,NULL);
+      break;
+    default:
+      break;
+  }
+}
+
+static void lowerStmts( TreeNode * t )
+{ for (; t != NULL; t = t->sibling) lowerStmt(t); }
+
+static void lowerFunc( TreeNode * t, IrFunc * f )
+{ TreeNode * p;
+  int mark = nsyms;
+  fn = f;
+  cur = newBlock();
+  for (p = t->child[0]; p != NULL; p = p->sibling)
+  { int v;
+    if (p->nodekind != DeclareK) continue; /* (void) */
+    v = newVal(TRUE);
+    declare(p->attr.name,p->typeK == ArrayK ? SymParamArray : SymLocal,v);
+    emit(IrParam,v,-1,-1,f->nparams++);
+  }
+  lowerStmt(t->child[1]);
+  if (cur != NULL)
+    endBlock(IrRet,f->isVoid ? -1 : constant(0),NULL,NULL);
+  nsyms = mark;
+}
+
+/**************************************************/
+/*  the control flow graph and dominators         */
+/**************************************************/
+
+/* Procedure buildCfg drops the blocks that cannot
+ * be reached, numbers the rest in reverse postorder
+ * and fills in their predecessors
+ */
+static void buildCfg(void)
+{ int n = fn->nblocks, top = 0, npost = 0, i, j;
+  IrBlock ** stack = irAlloc(n * sizeof(IrBlock *));
+  IrBlock ** post = irAlloc(n * sizeof(IrBlock *));
+  int * next = irAlloc(n * sizeof(int));
+  char * seen = irAlloc(n);
+  stack[top++] = fn->blocks[0];
+  seen[0] = TRUE;
+  while (top > 0)
+  { IrBlock * b = stack[top-1];
+    if (next[b->id] < b->nsucc)
+    { IrBlock * s = b->succ[next[b->id]++];
+      if (!seen[s->id])
+      { seen[s->id] = TRUE;
+        stack[top++] = s;
+      }
+    }
+    else post[npost++] = stack[--top];
+  }
+  for (i=0;i<npost;i++)
+  { IrBlock * b = post[npost-1-i];
+    fn->blocks[i] = b;
+    b->id = i;
+    b->npred = 0;
+  }
+  fn->nblocks = npost;
+  for (i=0;i<npost;i++)
+    for (j=0;j<fn->blocks[i]->nsucc;j++)
+      fn->blocks[i]->succ[j]->npred++;
+  for (i=0;i<npost;i++)
+  { fn->blocks[i]->pred = irAlloc(fn->blocks[i]->npred * sizeof(IrBlock *));
+    fn->blocks[i]->npred = 0;
+  }
+  for (i=0;i<npost;i++)
+    for (j=0;j<fn->blocks[i]->nsucc;j++)
+    { IrBlock * s = fn->blocks[i]->succ[j];
+      s->pred[s->npred++] = fn->blocks[i];
+    }
+}
+
+static IrBlock * intersect( IrBlock * a, IrBlock * b )
+{ while (a != b)
+  { while (a->id > b->id) a = a->idom;
+    while (b->id > a->id) b = b->idom;
+  }
+  return a;
+}
+
+/* Procedure dominators finds the immediate
+ * dominators (Cooper, Harvey and Kennedy), the
+ * dominator tree and the dominance frontiers
+ */
+static void dominators(void)
+{ int i, j, changed;
+  IrBlock * entry = fn->blocks[0];
+  for (i=0;i<fn->nblocks;i++)
+  { fn->blocks[i]->idom = NULL;
+    fn->blocks[i]->nkids = 0;
+    fn->blocks[i]->ndf = 0;
+  }
+  entry->idom = entry;
+  do
+  { changed = FALSE;
+    for (i=1;i<fn->nblocks;i++)
+    { IrBlock * b = fn->blocks[i], * d = NULL;
+      for (j=0;j<b->npred;j++)
+        if (b->pred[j]->idom != NULL)
+          d = d ? intersect(b->pred[j],d) : b->pred[j];
+      if (b->idom != d)
+      { b->idom = d;
+        changed = TRUE;
+      }
+    }
+  } while (changed);
+  for (i=1;i<fn->nblocks;i++) fn->blocks[i]->idom->nkids++;
+  for (i=0;i<fn->nblocks;i++)
+  { fn->blocks[i]->kids = irAlloc(fn->blocks[i]->nkids * sizeof(IrBlock *));
+    fn->blocks[i]->nkids = 0;
+  }
+  for (i=1;i<fn->nblocks;i++)
+  { IrBlock * d = fn->blocks[i]->idom;
+    d->kids[d->nkids++] = fn->blocks[i];
+  }
+  for (i=0;i<fn->nblocks;i++)
+  { IrBlock * b = fn->blocks[i];
+    if (b->npred < 2) continue;
+    for (j=0;j<b->npred;j++)
+    { IrBlock * r = b->pred[j];
+      while (r != b->idom)
+      { if (r->ndf == 0 || r->df[r->ndf-1] != b)
+        { r->df = grow(r->df,r->ndf,&r->dfSize,sizeof(IrBlock *));
+          r->df[r->ndf++] = b;
+        }
+        r = r->idom;
+      }
+    }
+  }
+}
+
+static int dominates( IrBlock * a, IrBlock * b )
+{ while (b != a && b->idom != b) b = b->idom;
+  return b == a;
+}
+
+/**************************************************/
+/*  SSA form                                      */
+/**************************************************/
+
+/* Procedure placePhis puts a phi for each variable
+ * at the iterated dominance frontier of the blocks
+ * that assign it
+ */
+static void placePhis(void)
+{ int nb = fn->nblocks, nv = fn->nvals, v, i, top;
+  int * head = irAlloc(nv * sizeof(int));
+  int * work = irAlloc(nb * sizeof(int));
+  int * hasPhi = irAlloc(nb * sizeof(int));
+  IrBlock ** stack;
+  int * site = NULL, * siteNext = NULL, nsites = 0, siteSize = 0, nextSize = 0;
+  IrIns * ins;
+  for (v=0;v<nv;v++) head[v] = -1;
+  for (i=0;i<nb;i++) work[i] = hasPhi[i] = -1;
+  for (i=0;i<nb;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+      if (ins->dst >= 0 && fn->val[ins->dst].isVar)
+      { site = grow(site,nsites,&siteSize,sizeof(int));
+        siteNext = grow(siteNext,nsites,&nextSize,sizeof(int));
+        site[nsites] = i;
+        siteNext[nsites] = head[ins->dst];
+        head[ins->dst] = nsites++;
+      }
+  stack = irAlloc((nb + nsites + 1) * sizeof(IrBlock *));
+  for (v=0;v<nv;v++)
+  { int s;
+    if (!fn->val[v].isVar) continue;
+    top = 0;
+    for (s = head[v]; s >= 0; s = siteNext[s])
+      if (work[site[s]] != v)
+      { work[site[s]] = v;
+        stack[top++] = fn->blocks[site[s]];
+      }
+    while (top > 0)
+    { IrBlock * b = stack[--top];
+      for (i=0;i<b->ndf;i++)
+      { IrBlock * d = b->df[i];
+        if (hasPhi[d->id] == v) continue;
+        hasPhi[d->id] = v;
+        ins = newIns(IrPhi,v,-1,-1,v);
+        ins->nargs = d->npred;
+        ins->args = irAlloc(d->npred * sizeof(int));
+        insertBefore(d,d->first,ins);
+        if (work[d->id] != v)
+        { work[d->id] = v;
+          stack[top++] = d;
+        }
+      }
+    }
+  }
+}
+
+/* the current value of each variable while
+ * renaming, and the log to undo it by
+ */
+static int * current;
+static int * logVar, * logOld;
+static int nlog, logSize, logOldSize;
+
+static int undefVal(void)
+{ if (fn->undef < 0)
+  { IrBlock * entry = fn->blocks[0];
+    IrIns * i;
+    fn->undef = newVal(FALSE);
+    i = newIns(IrConst,fn->undef,-1,-1,0);
+    insertBefore(entry,entry->first,i);
+  }
+  return fn->undef;
+}
+
+static int currentOf( int v )
+{ if (!fn->val[v].isVar) return v;
+  return current[v] >= 0 ? current[v] : undefVal();
+}
+
+static void renameBlock( IrBlock * b )
+{ IrIns * i;
+  int j;
+  for (i = b->first; i != NULL; i = i->next)
+  { if (i->op != IrPhi) mapUses(i,currentOf);
+    if (i->dst >= 0 && fn->val[i->dst].isVar)
+    { int v = i->dst;
+      logVar = grow(logVar,nlog,&logSize,sizeof(int));
+      logOld = grow(logOld,nlog,&logOldSize,sizeof(int));
+      logVar[nlog] = v;
+      logOld[nlog++] = current[v];
+      current[v] = i->dst = newVal(FALSE);
+    }
+  }
+  for (j=0;j<b->nsucc;j++)
+  { IrBlock * s = b->succ[j];
+    int p;
+    for (p=0; s->pred[p] != b; p++) ;
+    for (i = s->first; i != NULL && i->op == IrPhi; i = i->next)
+      i->args[p] = currentOf(i->k);
+  }
+}
+
+/* Procedure renameVars gives every assignment of a
+ * variable a new value, walking the dominator tree
+ * with an explicit stack
+ */
+static void renameVars(void)
+{ int nb = fn->nblocks, nv = fn->nvals, top = 0, v;
+  IrBlock ** stack = irAlloc(nb * sizeof(IrBlock *));
+  int * mark = irAlloc(nb * sizeof(int));
+  int * kid = irAlloc(nb * sizeof(int));
+  current = irAlloc(nv * sizeof(int));
+  for (v=0;v<nv;v++) current[v] = -1;
+  logVar = logOld = NULL;
+  nlog = logSize = logOldSize = 0;
+  stack[top] = fn->blocks[0];
+  mark[top] = 0;
+  kid[top++] = 0;
+  renameBlock(fn->blocks[0]);
+  while (top > 0)
+  { IrBlock * b = stack[top-1];
+    if (kid[top-1] < b->nkids)
+    { IrBlock * c = b->kids[kid[top-1]++];
+      stack[top] = c;
+      mark[top] = nlog;
+      kid[top++] = 0;
+      renameBlock(c);
+    }
+    else
+    { top--;
+      while (nlog > mark[top])
+      { nlog--;
+        current[logVar[nlog]] = logOld[nlog];
+      }
+    }
+  }
+}
+
+/* Procedure findDefs records the instruction
+ * defining each value and counts its uses
+ */
+static void findDefs(void)
+{ int v, i, j;
+  IrIns * ins;
+  for (v=0;v<fn->nvals;v++)
+  { fn->val[v].def = NULL;
+    fn->val[v].uses = 0;
+  }
+  for (i=0;i<fn->nblocks;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+    { if (ins->dst >= 0) fn->val[ins->dst].def = ins;
+      if (ins->a >= 0) fn->val[ins->a].uses++;
+      if (ins->b >= 0) fn->val[ins->b].uses++;
+      for (j=0;j<ins->nargs;j++) fn->val[ins->args[j]].uses++;
+    }
+}
+
+/**************************************************/
+/*  the optimization passes                       */
+/**************************************************/
+
+static int find( int v )
+{ while (fn->val[v].repl != v)
+  { fn->val[v].repl = fn->val[fn->val[v].repl].repl;
+    v = fn->val[v].repl;
+  }
+  return v;
+}
+
+static void replaceAll(void)
+{ int i;
+  IrIns * ins;
+  for (i=0;i<fn->nblocks;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+      mapUses(ins,find);
+}
+
+/* Procedure copyProp replaces the value of every
+ * copy, and of every phi whose arguments are all
+ * one value, by that value
+ */
+static void copyProp(void)
+{ int i, j, changed;
+  IrIns * ins, * next;
+  do
+  { changed = FALSE;
+    replaceAll();
+    for (i=0;i<fn->nblocks;i++)
+      for (ins = fn->blocks[i]->first; ins != NULL; ins = next)
+      { next = ins->next;
+        if (ins->op == IrCopy)
+        { fn->val[ins->dst].repl = find(ins->a);
+          unlink(ins);
+          nCopies++;
+          changed = TRUE;
+        }
+        else if (ins->op == IrPhi)
+        { int x = -1, same = TRUE;
+          for (j=0;j<ins->nargs && same;j++)
+          { int a = find(ins->args[j]);
+            if (a == ins->dst) continue;
+            if (x < 0) x = a;
+            else if (a != x) same = FALSE;
+          }
+          if (same && x >= 0)
+          { fn->val[ins->dst].repl = x;
+            unlink(ins);
+            nCopies++;
+            changed = TRUE;
+          }
+        }
+      }
+  } while (changed);
+  findDefs();
+}
+
+static int isArith( IrOp op )
+{ return op >= IrAdd && op <= IrNe; }
+
+/* fold replaces arithmetic on constants by its
+ * result; a division by 0 is left to trap
+ */
+static void fold( IrIns * i )
+{ IrIns * a, * b;
+  int x, y, r;
+  if (!isArith(i->op)) return;
+  a = fn->val[i->a].def;
+  b = fn->val[i->b].def;
+  if (a == NULL || b == NULL || a->op != IrConst || b->op != IrConst) return;
+  x = a->k;
+  y = b->k;
+  switch (i->op)
+  { case IrAdd: r = x + y; break;
+    case IrSub: r = x - y; break;
+    case IrMul: r = x * y; break;
+    case IrDiv:
+      if (y == 0) return;
+      r = x / y;
+      break;
+    case IrLt: r = x < y; break;
+    case IrLe: r = x <= y; break;
+    case IrGt: r = x > y; break;
+    case IrGe: r = x >= y; break;
+    case IrEq: r = x == y; break;
+    default: r = x != y; break;
+  }
+  i->op = IrConst;
+  i->a = i->b = -1;
+  i->k = r;
+}
+
+/* the available expressions of the CSE walk,
+ * hashed open with linear probing
+ */
+static IrIns ** avail;
+static int availMask;
+
+static unsigned hashIns( IrIns * i )
+{ return ((unsigned) i->op * 31u + (unsigned) i->a) * 31u * 31u +
+         (unsigned) i->b * 31u + (unsigned) i->k;
+}
+
+static int sameIns( IrIns * i, IrIns * j )
+{ return i->op == j->op && i->a == j->a && i->b == j->b && i->k == j->k; }
+
+/* cseBlock looks up or records each pure
+ * instruction of b, logging the slots it fills
+ */
+static void cseBlock( IrBlock * b )
+{ IrIns * i, * next;
+  for (i = b->first; i != NULL; i = next)
+  { unsigned h;
+    next = i->next;
+    if (i->op == IrPhi) continue;
+    mapUses(i,find);
+    if (i->op != IrConst && i->op != IrGAddr && i->op != IrFAddr &&
+        !isArith(i->op))
+      continue;
+    fold(i);
+    if ((i->op == IrAdd || i->op == IrMul || i->op == IrEq ||
+         i->op == IrNe) && i->a > i->b)
+    { int t = i->a;
+      i->a = i->b;
+      i->b = t;
+    }
+    for (h = hashIns(i) & availMask; avail[h] != NULL; h = (h + 1) & availMask)
+      if (sameIns(avail[h],i)) break;
+    if (avail[h] != NULL)
+    { fn->val[i->dst].repl = avail[h]->dst;
+      unlink(i);
+      nCse++;
+    }
+    else
+    { avail[h] = i;
+      logVar = grow(logVar,nlog,&logSize,sizeof(int));
+      logVar[nlog++] = h;
+    }
+  }
+}
+
+/* Procedure cse removes the instructions that
+ * compute a value already computed by a pure
+ * instruction dominating them, folding constants
+ * on the way
+ */
+static void cse(void)
+{ int nb = fn->nblocks, top = 0, n = 0, size = 1, i;
+  IrBlock ** stack = irAlloc(nb * sizeof(IrBlock *));
+  int * mark = irAlloc(nb * sizeof(int));
+  int * kid = irAlloc(nb * sizeof(int));
+  IrIns * ins;
+  for (i=0;i<nb;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next) n++;
+  while (size < 2 * n + 2) size *= 2;
+  avail = irAlloc(size * sizeof(IrIns *));
+  availMask = size - 1;
+  logVar = NULL;
+  nlog = logSize = 0;
+  stack[top] = fn->blocks[0];
+  mark[top] = 0;
+  kid[top++] = 0;
+  cseBlock(fn->blocks[0]);
+  while (top > 0)
+  { IrBlock * b = stack[top-1];
+    if (kid[top-1] < b->nkids)
+    { IrBlock * c = b->kids[kid[top-1]++];
+      stack[top] = c;
+      mark[top] = nlog;
+      kid[top++] = 0;
+      cseBlock(c);
+    }
+    else
+    { /* the slots filled last go first, so the
+         probe sequences of the others stay intact */
+      top--;
+      while (nlog > mark[top]) avail[logVar[--nlog]] = NULL;
+    }
+  }
+  replaceAll();
+  findDefs();
+}
+
+/* hoistable is TRUE for instructions that can
+ * neither trap nor see a store
+ */
+static int hoistable( IrOp op )
+{ return op == IrConst || op == IrGAddr || op == IrFAddr ||
+         (isArith(op) && op != IrDiv);
+}
+
+/* Procedure licm moves the invariant instructions
+ * of each while loop to the block before it,
+ * inner loops first
+ */
+static void licm(void)
+{ int nb = fn->nblocks, h, i, j, top;
+  int * inLoop = irAlloc(nb * sizeof(int));
+  IrBlock ** stack = irAlloc(nb * sizeof(IrBlock *));
+  for (i=0;i<nb;i++) inLoop[i] = -1;
+  for (h=nb-1;h>=0;h--)
+  { IrBlock * head = fn->blocks[h], * pre = NULL;
+    int changed, latches = 0;
+    top = 0;
+    inLoop[h] = h;
+    for (j=0;j<head->npred;j++)
+      if (dominates(head,head->pred[j]))
+      { IrBlock * l = head->pred[j];
+        latches++;
+        if (inLoop[l->id] != h)
+        { inLoop[l->id] = h;
+          stack[top++] = l;
+        }
+      }
+    if (latches == 0) continue;
+    while (top > 0)
+    { IrBlock * b = stack[--top];
+      for (j=0;j<b->npred;j++)
+        if (inLoop[b->pred[j]->id] != h)
+        { inLoop[b->pred[j]->id] = h;
+          stack[top++] = b->pred[j];
+        }
+    }
+    /* the one way in must end in a jump */
+    for (j=0;j<head->npred;j++)
+      if (inLoop[head->pred[j]->id] != h)
+      { if (pre != NULL) break;
+        pre = head->pred[j];
+      }
+    if (j < head->npred || pre == NULL || pre->nsucc != 1) continue;
+    do
+    { changed = FALSE;
+      for (i=h;i<nb;i++)
+      { IrIns * ins, * next;
+        if (inLoop[i] != h) continue;
+        for (ins = fn->blocks[i]->first; ins != NULL; ins = next)
+        { next = ins->next;
+          if (!hoistable(ins->op)) continue;
+          if (ins->a >= 0 && inLoop[fn->val[ins->a].def->block->id] == h)
+            continue;
+          if (ins->b >= 0 && inLoop[fn->val[ins->b].def->block->id] == h)
+            continue;
+          unlink(ins);
+          insertBefore(pre,pre->last,ins);
+          nHoisted++;
+          changed = TRUE;
+        }
+      }
+    } while (changed);
+  }
+}
+
+/* removable is TRUE for instructions whose only
+ * effect is their value
+ */
+static int removable( IrOp op )
+{ return op != IrStore && op != IrCall && !isEnd(op); }
+
+/* Procedure dce removes the instructions whose
+ * values are never used
+ */
+static void dce(void)
+{ int i, j, changed;
+  IrIns * ins, * next;
+  do
+  { changed = FALSE;
+    for (i=0;i<fn->nblocks;i++)
+      for (ins = fn->blocks[i]->first; ins != NULL; ins = next)
+      { next = ins->next;
+        if (ins->dst < 0 || !removable(ins->op) || fn->val[ins->dst].uses > 0)
+          continue;
+        if (ins->a >= 0) fn->val[ins->a].uses--;
+        if (ins->b >= 0) fn->val[ins->b].uses--;
+        for (j=0;j<ins->nargs;j++) fn->val[ins->args[j]].uses--;
+        unlink(ins);
+        nDead++;
+        changed = TRUE;
+      }
+  } while (changed);
+}
+
+/**************************************************/
+/*  leaving SSA form                              */
+/**************************************************/
+
+static void copyAtEnd( IrBlock * b, int dst, int src )
+{ IrIns * i = newIns(IrCopy,dst,src,-1,0);
+  insertBefore(b,b->last,i);
+}
+
+/* Procedure leaveSsa replaces the phis by copies
+ * at the end of the predecessors, splitting the
+ * edges from blocks that branch; the copies of
+ * one edge go through temporaries, as they are
+ * meant to happen at once
+ */
+static void leaveSsa(void)
+{ int nb = fn->nblocks, i, j, n;
+  for (i=0;i<nb;i++)
+  { IrBlock * b = fn->blocks[i];
+    IrIns * phi;
+    if (b->first == NULL || b->first->op != IrPhi) continue;
+    for (j=0;j<b->npred;j++)
+    { IrBlock * p = b->pred[j];
+      if (p->nsucc > 1)
+      { IrBlock * e = newBlock();
+        IrIns * jump = newIns(IrJump,-1,-1,-1,0);
+        append(e,jump);
+        e->succ[0] = b;
+        e->nsucc = 1;
+        e->pred = irAlloc(sizeof(IrBlock *));
+        e->pred[0] = p;
+        e->npred = 1;
+        p->succ[p->succ[0] == b ? 0 : 1] = e;
+        b->pred[j] = e;
+        p = e;
+      }
+      n = 0;
+      for (phi = b->first; phi != NULL && phi->op == IrPhi; phi = phi->next) n++;
+      if (n == 1) copyAtEnd(p,b->first->dst,b->first->args[j]);
+      else
+      { int * tmp = irAlloc(n * sizeof(int)), k = 0;
+        for (phi = b->first; phi != NULL && phi->op == IrPhi; phi = phi->next)
+        { tmp[k] = newVal(FALSE);
+          copyAtEnd(p,tmp[k++],phi->args[j]);
+        }
+        k = 0;
+        for (phi = b->first; phi != NULL && phi->op == IrPhi; phi = phi->next)
+          copyAtEnd(p,phi->dst,tmp[k++]);
+      }
+    }
+    while (b->first != NULL && b->first->op == IrPhi) unlink(b->first);
+  }
+}
+
+/**************************************************/
+/*  listing                                       */
+/**************************************************/
+
+static void printIns( IrIns * i )
+{ int j;
+  fprintf(listing,"    ");
+  if (i->dst >= 0) fprintf(listing,"v%d = ",i->dst);
+  fprintf(listing,"%s",opName[i->op]);
+  switch (i->op)
+  { case IrConst: case IrParam: case IrGAddr: case IrFAddr:
+      fprintf(listing," %d",i->k);
+      break;
+    case IrCall:
+      fprintf(listing," %s(",i->name);
+      for (j=0;j<i->nargs;j++)
+        fprintf(listing,"%sv%d",j ? ", " : "",i->args[j]);
+      fprintf(listing,")");
+      break;
+    case IrPhi:
+      for (j=0;j<i->nargs;j++)
+        fprintf(listing,"%s v%d",j ? "," : "",i->args[j]);
+      break;
+    default:
+      if (i->a >= 0) fprintf(listing," v%d",i->a);
+      if (i->b >= 0) fprintf(listing,", v%d",i->b);
+  }
+  if (i->op == IrJump) fprintf(listing," B%d",i->block->succ[0]->id);
+  if (i->op == IrBr)
+    fprintf(listing,", B%d, B%d",i->block->succ[0]->id,i->block->succ[1]->id);
+  fprintf(listing,"\n");
+}
+
+static void printFunc(void)
+{ int i;
+  IrIns * ins;
+  fprintf(listing,"function %s: %d copies, %d common, %d hoisted, %d dead\n",
+          fn->name,nCopies,nCse,nHoisted,nDead);
+  for (i=0;i<fn->nblocks;i++)
+  { IrBlock * b = fn->blocks[i];
+    fprintf(listing,"  B%d:",i);
+    if (b->npred > 0)
+    { int j;
+      fprintf(listing,"  (from");
+      for (j=0;j<b->npred;j++) fprintf(listing," B%d",b->pred[j]->id);
+      fprintf(listing,")");
+    }
+    fprintf(listing,"\n");
+    for (ins = b->first; ins != NULL; ins = ins->next) printIns(ins);
+  }
+}
+
+/**************************************************/
+/*  TM code                                       */
+/**************************************************/
+
+/* a jump or call emitted before its target */
+typedef struct
+{ int loc;
+  char * op;
+  int reg;
+  IrBlock * block;
+  IrFunc * func;
+} Fixup;
+
+static Fixup * fixups = NULL;
+static int nfixups = 0, fixupSize = 0;
+
+/* the frame of fn: its size and the offsets of
+ * the first slot and the local arrays from fp
+ */
+static int frameSize, slotBase, arrayBase0;
+
+static void addFixup( char * op, int reg, IrBlock * b, IrFunc * f )
+{ fixups = grow(fixups,nfixups,&fixupSize,sizeof(Fixup));
+  fixups[nfixups].loc = emitSkip(1);
+  fixups[nfixups].op = op;
+  fixups[nfixups].reg = reg;
+  fixups[nfixups].block = b;
+  fixups[nfixups++].func = f;
+}
+
+static void genJump( char * op, int reg, IrBlock * b )
+{ if (b->loc >= 0) emitRM_Abs(op,reg,b->loc,"jump");
+  else addFixup(op,reg,b,NULL);
+}
+
+/* constants and addresses are made again at each
+ * use instead of taking a slot
+ */
+static int remade( int v )
+{ IrIns * d = fn->val[v].def;
+  return d != NULL && (d->op == IrConst || d->op == IrGAddr || d->op == IrFAddr);
+}
+
+static int slotOf( int v )
+{ return slotBase - fn->val[v].slot; }
+
+static void load( int reg, int v )
+{ IrIns * d = fn->val[v].def;
+  if (d != NULL && d->op == IrConst) emitRM("LDC",reg,d->k,0,"constant");
+  else if (d != NULL && d->op == IrGAddr) emitRM("LDA",reg,d->k,gp,"global address");
+  else if (d != NULL && d->op == IrFAddr)
+    emitRM("LDA",reg,arrayBase0 + d->k,fp,"array address");
+  else emitRM("LD",reg,slotOf(v),fp,"load value");
+}
+
+static void store( int v )
+{ emitRM("ST",ac,slotOf(v),fp,"store value"); }
+
+/* memOperand sets *off and *base to address the
+ * word value a points to, if a is a known address
+ */
+static int memOperand( int a, int * off, int * base )
+{ IrIns * d = fn->val[a].def;
+  if (d != NULL && d->op == IrGAddr)
+  { *off = d->k;
+    *base = gp;
+    return TRUE;
+  }
+  if (d != NULL && d->op == IrFAddr)
+  { *off = arrayBase0 + d->k;
+    *base = fp;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static char * jumpIf( IrOp op, int negate )
+{ static char * jumps[] = { "JLT", "JLE", "JGT", "JGE", "JEQ", "JNE" };
+  static char * negs[] = { "JGE", "JGT", "JLE", "JLT", "JNE", "JEQ" };
+  return negate ? negs[op - IrLt] : jumps[op - IrLt];
+}
+
+static IrFunc * findFunc( char * name )
+{ IrFunc * f;
+  for (f = funcs; f != NULL && strcmp(f->name,name) != 0; f = f->next) ;
+  return f;
+}
+
+static void genCall( IrIns * i )
+{ int j;
+  if (i->k == CALL_INPUT)
+  { emitRO("IN",ac,0,0,"input");
+    if (i->dst >= 0) store(i->dst);
+    return;
+  }
+  if (i->k == CALL_OUTPUT)
+  { load(ac,i->args[0]);
+    emitRO("OUT",ac,0,0,"output");
+    return;
+  }
+  for (j=0;j<i->nargs;j++)
+  { load(ac,i->args[j]);
+    emitRM("ST",ac,-frameSize-2-j,fp,"argument");
+  }
+  emitRM("ST",fp,-frameSize-1,fp,"save fp");
+  emitRM("LDA",fp,-frameSize,fp,"new frame");
+  emitRM("LDA",ac,2,pc,"return address");
+  emitRM("ST",ac,0,fp,"store return address");
+  addFixup("LDA",pc,NULL,findFunc(i->name));
+  if (i->dst >= 0) store(i->dst);
+}
+
+/* genIns emits ins; it returns the compare left
+ * in ac for the branch that follows, if any
+ */
+static IrOp genIns( IrIns * i, IrOp cmp, IrBlock * next )
+{ int off, base;
+  IrBlock * b = i->block;
+  switch (i->op)
+  { case IrConst: case IrGAddr: case IrFAddr:
+      break;
+    case IrParam:
+      emitRM("LD",ac,-2-i->k,fp,"parameter");
+      store(i->dst);
+      break;
+    case IrCopy:
+      load(ac,i->a);
+      store(i->dst);
+      break;
+    case IrAdd: case IrSub: case IrMul: case IrDiv:
+      load(ac,i->a);
+      load(ac1,i->b);
+      emitRO(i->op == IrAdd ? "ADD" : i->op == IrSub ? "SUB" :
+             i->op == IrMul ? "MUL" : "DIV",ac,ac,ac1,"op");
+      store(i->dst);
+      break;
+    case IrLt: case IrLe: case IrGt: case IrGe: case IrEq: case IrNe:
+      load(ac,i->a);
+      load(ac1,i->b);
+      emitRO("SUB",ac,ac,ac1,"compare");
+      if (i->next && i->next->op == IrBr && i->next->a == i->dst &&
+          fn->val[i->dst].uses == 1)
+        return i->op;
+      emitRM(jumpIf(i->op,FALSE),ac,2,pc,"br if true");
+      emitRM("LDC",ac,0,0,"false case");
+      emitRM("LDA",pc,1,pc,"unconditional jmp");
+      emitRM("LDC",ac,1,0,"true case");
+      store(i->dst);
+      break;
+    case IrLoad:
+      if (memOperand(i->a,&off,&base)) emitRM("LD",ac,off,base,"load");
+      else
+      { load(ac,i->a);
+        emitRM("LD",ac,0,ac,"load");
+      }
+      store(i->dst);
+      break;
+    case IrStore:
+      load(ac1,i->b);
+      if (memOperand(i->a,&off,&base)) emitRM("ST",ac1,off,base,"store");
+      else
+      { load(ac,i->a);
+        emitRM("ST",ac1,0,ac,"store");
+      }
+      break;
+    case IrCall:
+      genCall(i);
+      break;
+    case IrJump:
+      if (b->succ[0] != next) genJump("LDA",pc,b->succ[0]);
+      break;
+    case IrBr:
+    { IrBlock * t = b->succ[0], * f = b->succ[1];
+      if (cmp == IrPhi)
+      { load(ac,i->a);
+        cmp = IrNe;
+      }
+      if (t == next) genJump(jumpIf(cmp,TRUE),ac,f);
+      else
+      { genJump(jumpIf(cmp,FALSE),ac,t);
+        if (f != next) genJump("LDA",pc,f);
+      }
+      break;
+    }
+    case IrRet:
+      if (i->a >= 0) load(ac,i->a);
+      emitRM("LD",ac1,0,fp,"return address");
+      emitRM("LD",fp,-1,fp,"restore fp");
+      emitRM("LDA",pc,0,ac1,"return");
+      break;
+    default:
+      break;
+  }
+  return IrPhi;
+}
+
+/* the live range of each value in slots: the
+ * first and last position in the code of fn
+ */
+static int * rangeStart, * rangeEnd;
+
+static void extend( int v, int pos )
+{ if (remade(v)) return;
+  if (pos < rangeStart[v]) rangeStart[v] = pos;
+  if (pos > rangeEnd[v]) rangeEnd[v] = pos;
+}
+
+/* byStart orders values by the start of their
+ * live ranges
+ */
+static int byStart( const void * a, const void * b )
+{ return rangeStart[*(const int *) a] - rangeStart[*(const int *) b]; }
+
+/* Function assignSlots gives each value not made
+ * again a frame slot and returns the number of
+ * slots. The live sets of the blocks give every
+ * value a range of positions in the code, from its
+ * first to its last point of life; values whose
+ * ranges do not overlap share a slot, so the
+ * variables and temporaries of disjoint scopes and
+ * statements use the same words of the frame. A
+ * range may end where the next one starts, since
+ * an instruction loads its operands before it
+ * stores its value
+ */
+static int assignSlots(void)
+{ int nb = fn->nblocks, nv = fn->nvals, w = (nv + 31) / 32;
+  unsigned * use = irAlloc(nb * w * sizeof(unsigned));
+  unsigned * def = irAlloc(nb * w * sizeof(unsigned));
+  unsigned * in = irAlloc(nb * w * sizeof(unsigned));
+  unsigned * out = irAlloc(nb * w * sizeof(unsigned));
+  int * order = irAlloc((nv + 1) * sizeof(int));
+  int * slotEnd = irAlloc((nv + 1) * sizeof(int));
+  int i, j, k, v, n, pos = 0, nslots = 0, changed;
+  IrIns * ins;
+#define BIT(set,b,v) ((set)[(b) * w + (v) / 32] & (1u << ((v) % 32)))
+#define SETBIT(set,b,v) ((set)[(b) * w + (v) / 32] |= 1u << ((v) % 32))
+  for (i=0;i<nb;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+    { int u[2];
+      u[0] = ins->a;
+      u[1] = ins->b;
+      for (j=0;j<2 + ins->nargs;j++)
+      { v = j < 2 ? u[j] : ins->args[j-2];
+        if (v >= 0 && !BIT(def,i,v)) SETBIT(use,i,v);
+      }
+      if (ins->dst >= 0) SETBIT(def,i,ins->dst);
+    }
+  /* live out is the union of what the successors
+     need, live in adds the uses before any def */
+  do
+  { changed = FALSE;
+    for (i=nb-1;i>=0;i--)
+    { IrBlock * b = fn->blocks[i];
+      for (k=0;k<w;k++)
+      { unsigned o = 0, x;
+        for (j=0;j<b->nsucc;j++) o |= in[b->succ[j]->id * w + k];
+        out[i * w + k] = o;
+        x = use[i * w + k] | (o & ~def[i * w + k]);
+        if (x != in[i * w + k])
+        { in[i * w + k] = x;
+          changed = TRUE;
+        }
+      }
+    }
+  } while (changed);
+
+  rangeStart = irAlloc(nv * sizeof(int));
+  rangeEnd = irAlloc(nv * sizeof(int));
+  for (v=0;v<nv;v++)
+  { rangeStart[v] = 0x7fffffff;
+    rangeEnd[v] = -1;
+  }
+  for (i=0;i<nb;i++)
+  { int first = pos;
+    for (k=0;k<w;k++)
+    { unsigned x = in[i * w + k];
+      for (v = k * 32; x != 0; v++, x >>= 1)
+        if (x & 1) extend(v,first);
+    }
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next, pos++)
+    { if (ins->a >= 0) extend(ins->a,pos);
+      if (ins->b >= 0) extend(ins->b,pos);
+      for (j=0;j<ins->nargs;j++) extend(ins->args[j],pos);
+      if (ins->dst >= 0) extend(ins->dst,pos);
+    }
+    for (k=0;k<w;k++)
+    { unsigned x = out[i * w + k];
+      for (v = k * 32; x != 0; v++, x >>= 1)
+        if (x & 1) extend(v,pos > first ? pos - 1 : first);
+    }
+  }
+#undef BIT
+#undef SETBIT
+
+  /* first fit in the order of the starts */
+  n = 0;
+  for (v=0;v<nv;v++)
+    if (rangeEnd[v] >= 0) order[n++] = v;
+  qsort(order,n,sizeof(int),byStart);
+  for (i=0;i<n;i++)
+  { v = order[i];
+    for (k=0;k<nslots && slotEnd[k] > rangeStart[v];k++) ;
+    if (k == nslots) nslots++;
+    slotEnd[k] = rangeEnd[v];
+    fn->val[v].slot = k;
+  }
+  return nslots;
+}
+
+/* Procedure genFunc emits the TM code of fn,
+ * giving each value not made again a frame slot
+ */
+static void genFunc(void)
+{ int i, nslots;
+  IrIns * ins;
+  findDefs();
+  /* values with more than one definition after
+     leaving SSA form are not made again */
+  for (i=0;i<fn->nblocks;i++)
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+      if (ins->dst >= 0 && fn->val[ins->dst].def != ins)
+        fn->val[ins->dst].def = NULL;
+  nslots = assignSlots();
+  slotBase = -2 - fn->nparams;
+  frameSize = 2 + fn->nparams + nslots + fn->arrayWords;
+  arrayBase0 = -frameSize + 1;
+  if (TraceCode)
+  { char note[80];
+    sprintf(note,"function %.40s: frame of %d words",fn->name,frameSize);
+    emitComment(note);
+  }
+  fn->entryLoc = emitSkip(0);
+  for (i=0;i<fn->nblocks;i++)
+  { IrBlock * next = i + 1 < fn->nblocks ? fn->blocks[i+1] : NULL;
+    IrOp cmp = IrPhi;
+    fn->blocks[i]->loc = emitSkip(0);
+    for (ins = fn->blocks[i]->first; ins != NULL; ins = ins->next)
+      cmp = genIns(ins,cmp,next);
+  }
+  for (i=0;i<nfixups;i++)
+    if (fixups[i].block != NULL)
+    { emitBackup(fixups[i].loc);
+      emitRM_Abs(fixups[i].op,fixups[i].reg,fixups[i].block->loc,"jump");
+      emitRestore();
+      fixups[i--] = fixups[--nfixups];
+    }
+}
+
+/* Procedure optimize runs the passes on fn in SSA
+ * form and leaves SSA form
+ */
+static void optimize(void)
+{ nCopies = nCse = nHoisted = nDead = 0;
+  fn->undef = -1;
+  buildCfg();
+  dominators();
+  placePhis();
+  renameVars();
+  findDefs();
+  copyProp();
+  cse();
+  licm();
+  /* again for what was hoisted to one block */
+  cse();
+  dce();
+  if (TraceCode) printFunc();
+  leaveSsa();
+}
+
+void irGen( TreeNode * syntaxTree )
+{ TreeNode * t;
+  IrFunc * f, ** last = &funcs;
+  Sym * s;
+  int i;
+  irArena = newArena();
+  if (irArena == NULL) outOfMemory();
+  funcs = NULL;
+  nsyms = 0;
+  globalWords = 0;
+  nfixups = 0;
+  s = declare("input",SymFunc,CALL_INPUT);
+  s = declare("output",SymFunc,CALL_OUTPUT);
+  s->isVoid = TRUE;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+  { if (t->nodekind != DeclareK) continue;
+    if (t->kind.declare == VarDK)
+    { if (t->typeK == ArrayK)
+      { declare(t->attr.name,SymGlobalArray,globalWords);
+        globalWords += t->child[0]->attr.val;
+      }
+      else declare(t->attr.name,SymGlobal,globalWords++);
+      continue;
+    }
+    f = irAlloc(sizeof(IrFunc));
+    f->name = t->attr.name;
+    f->isVoid = t->type == Void;
+    f->entryLoc = -1;
+    *last = f;
+    last = &f->next;
+    /* declared before the body, for recursion */
+    s = declare(t->attr.name,SymFunc,CALL_USER);
+    s->isVoid = f->isVoid;
+    s->func = f;
+    lowerFunc(t,f);
+  }
+  f = findFunc("main");
+  if (f == NULL)
+  { fprintf(listing,"No main function for the code\n");
+    Error = TRUE;
+    freeArena(irArena);
+    return;
+  }
+  emitComment("C-Minus compilation to TM code");
+  emitRM("LD",mp,0,ac,"load maxaddress from location 0");
+  emitRM("ST",ac,0,ac,"clear location 0");
+  emitRM("LDA",fp,0,mp,"frame of main");
+  frameSize = 0;
+  emitRM("ST",fp,-1,fp,"save fp");
+  emitRM("LDA",ac,2,pc,"return address");
+  emitRM("ST",ac,0,fp,"store return address");
+  addFixup("LDA",pc,NULL,f);
+  emitRO("HALT",0,0,0,"");
+  for (fn = funcs; fn != NULL; fn = fn->next)
+  { optimize();
+    genFunc();
+  }
+  for (i=0;i<nfixups;i++)
+  { emitBackup(fixups[i].loc);
+    emitRM_Abs(fixups[i].op,fixups[i].reg,fixups[i].func->entryLoc,"call");
+    emitRestore();
+  }
+  emitImage();
+  freeArena(irArena);
+  irArena = NULL;
+}
@@ -0,0 +1,26 @@
+/****************************************************/
+/* File: ir.h                                       */
+/* Three-address intermediate code in basic blocks  */
+/* and its TM code generator for the C-Minus        */
+/* compiler                                         */
+/****************************************************/
+
+#ifndef _IR_H_
+#define _IR_H_
+
+/* Procedure irGen generates TM code for the checked
+ * syntax tree through the intermediate code: each
+ * function is lowered to basic blocks, put in SSA
+ * form, improved by copy propagation, common
+ * subexpression elimination, loop-invariant code
+ * motion and dead code elimination, and lowered to
+ * TM instructions (see code.h); emitImage writes
+ * them. If TraceCode is TRUE the improved code is
+ * printed to the listing file.
+ * The TM code keeps every value in a stack frame:
+ * fp+0 is the return address, fp-1 the caller's fp
+ * and fp-2 down the arguments; globals are at gp
+ */
+void irGen( TreeNode * syntaxTree );
+
+#endif
@@ -6,6 +6,12 @@
 /****************************************************/
 
 #include "globals.h"
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <time.h>
 
 /* set NO_PARSE to TRUE to get a scanner-only compiler */
 #define NO_PARSE FALSE
@@ -18,12 +24,19 @@
 #define NO_CODE TRUE
 
 #include "util.h"
+#include "source.h"
+#include "arena.h"
+#include "stream.h"
 #if NO_PARSE
 #include "scan.h"
 #else
 #include "parse.h"
 #if !NO_ANALYZE
 #include "analyze.h"
+#include "symtab.h"
+#include "fncache.h"
+#include "ir.h"
+#include "code.h"
 #if !NO_CODE
 #include "cgen.h"
 #endif
@@ -32,9 +45,11 @@
 
 /* allocate global variables */
 int lineno = 0;
+int tokenCount = 0;
 FILE * source;
 FILE * listing;
 FILE * code;
+FILE * stream = NULL;
 
 /* allocate and set tracing flags */
 int EchoSource = FALSE;
@@ -42,30 +57,154 @@ int TraceScan = FALSE;
 int TraceParse = FALSE;
 int TraceAnalyze = TRUE;
 int TraceCode = FALSE;
+int BinaryCode = FALSE;
+int OptimizeCode = FALSE;
 
 int Error = FALSE;
 
-main( int argc, char * argv[] )
+/* TimeReport = TRUE (-ftime-report) appends the
+ * time of each phase, the token and node counts
+ * and the peak memory to the listing
+ */
+static int TimeReport = FALSE;
+
+/* ChangeReport = TRUE (-fchanges) lists the
+ * functions changed since the last compilation,
+ * using the hashes kept in a .fnc file; it is a
+ * report only, every function is still compiled
+ */
+static int ChangeReport = FALSE;
+
+/* JsonStream = TRUE (-fjson) writes the tokens and
+ * the syntax tree to a .ndjson file for tools (see
+ * stream.h)
+ */
+static int JsonStream = FALSE;
+
+/* IrCode = TRUE (-fir) generates TM code through
+ * the optimized intermediate code (see ir.h)
+ */
+static int IrCode = FALSE;
+
+/* InlineCode = TRUE (-finline) inlines the calls
+ * to small functions after type checking, then
+ * simplifies the tree as OptimizeCode does
+ */
+static int InlineCode = FALSE;
+
+/* the phases timed so far in this compilation */
+#define MAXPHASES 8
+static struct
+   { char * name;
+     double wall, cpu; /* seconds */
+   } phases[MAXPHASES];
+static int nphases = 0;
+static double phaseWall, phaseCpu;
+
+static double wallClock(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpuClock(void)
+{ return (double) clock() / CLOCKS_PER_SEC;
+}
+
+/* Procedure startPhase starts timing a phase */
+static void startPhase(void)
+{ phaseWall = wallClock();
+  phaseCpu = cpuClock();
+}
+
+/* Procedure endPhase records the phase started
+ * last under name
+ */
+static void endPhase( char * name )
+{ if (nphases == MAXPHASES) return;
+  phases[nphases].name = name;
+  phases[nphases].wall = wallClock() - phaseWall;
+  phases[nphases].cpu = cpuClock() - phaseCpu;
+  nphases++;
+}
+
+/* Procedure timeReport prints the phase times
+ * and counts to the listing file
+ */
+static void timeReport(void)
+{ struct rusage ru;
+  double wall = 0, cpu = 0;
+  int i;
+  fprintf(listing,"\nTime report:\n");
+  fprintf(listing,"  %-12s %10s %10s\n","phase","wall (s)","cpu (s)");
+  for (i=0;i<nphases;i++)
+  { fprintf(listing,"  %-12s %10.6f %10.6f\n",
+            phases[i].name,phases[i].wall,phases[i].cpu);
+    wall += phases[i].wall;
+    cpu += phases[i].cpu;
+  }
+  fprintf(listing,"  %-12s %10.6f %10.6f\n","total",wall,cpu);
+  fprintf(listing,"  tokens: %d\n",tokenCount);
+  fprintf(listing,"  tree nodes: %d\n",nodeCount);
+  if (getrusage(RUSAGE_SELF,&ru) == 0)
+    fprintf(listing,"  peak memory: %ld KB\n",ru.ru_maxrss);
+}
+
+/* Function fileName returns the malloc'ed name of
+ * source file name with its extension replaced
+ * by ext
+ */
+static char * fileName( char * name, char * ext )
+{ char * base = strrchr(name,'/');
+  char * dot = strrchr(base ? base : name,'.');
+  size_t len = dot ? (size_t)(dot - name) : strlen(name);
+  char * file = (char *) malloc(len+strlen(ext)+1);
+  if (file == NULL) return NULL;
+  strncpy(file,name,len);
+  strcpy(file+len,ext);
+  return file;
+}
+
+/* Function compile compiles the source file name
+ * with the listing going to out, and returns TRUE
+ * if an error was found
+ */
+static int compile( char * name, FILE * out )
 { TreeNode * syntaxTree;
   char pgm[120]; /* source code file name */
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
-      exit(1);
-    }
-  strcpy(pgm,argv[1]) ;
+  strncpy(pgm,name,sizeof(pgm)-5);
+  pgm[sizeof(pgm)-5] = '\0';
   if (strchr (pgm, '.') == NULL)
      strcat(pgm,".tny");
   source = fopen(pgm,"r");
   if (source==NULL)
   { fprintf(stderr,"File %s not found\n",pgm);
-    exit(1);
+    return TRUE;
   }
-  listing = stdout; /* send listing to screen */
+  if (srcLoad(source) != 0)
+  { fprintf(stderr,"Cannot read %s\n",pgm);
+    fclose(source);
+    return TRUE;
+  }
+  listing = out;
   fprintf(listing,"\nC-MINUS COMPILATION: %s\n",pgm);
+  if (JsonStream)
+  { char * json = fileName(pgm,".ndjson");
+    FILE * f = json ? fopen(json,"w") : NULL;
+    if (f == NULL) fprintf(stderr,"Cannot open the stream for %s\n",pgm);
+    else streamOpen(f);
+    free(json);
+  }
 #if NO_PARSE
-  while (getToken()!=ENDFILE);
+  startPhase();
+  while (getToken()!=ENDFILE) tokenCount++;
+  tokenCount++;
+  endPhase("scan");
 #else
+  startPhase();
   syntaxTree = parse();
+  endPhase("parse");
+  if (stream != NULL) streamTree(syntaxTree);
   if (TraceParse) {
     fprintf(listing,"\nSyntax tree:\n");
     printTree(syntaxTree);
@@ -73,30 +212,170 @@ main( int argc, char * argv[] )
 #if !NO_ANALYZE
   if (! Error)
   { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
+    startPhase();
     buildSymtab(syntaxTree);
+    endPhase("symtab");
+    if (TimeReport) st_stats(listing);
     if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
+    startPhase();
     typeCheck(syntaxTree);
+    endPhase("typecheck");
     if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
+    if (InlineCode && ! Error)
+    { startPhase();
+      inlineTree(syntaxTree);
+      endPhase("inline");
+    }
+    if ((OptimizeCode || InlineCode) && ! Error)
+    { startPhase();
+      optimizeTree(syntaxTree);
+      endPhase("optimize");
+      if (TraceParse)
+      { fprintf(listing,"\nOptimized syntax tree:\n");
+        printTree(syntaxTree);
+      }
+    }
+  }
+  if (ChangeReport && ! Error)
+  { char * fnc = fileName(pgm,".fnc");
+    int n;
+    fprintf(listing,"\nChanged functions:\n");
+    n = fnc ? reportChanges(syntaxTree,fnc) : -1;
+    if (n < 0) fprintf(listing,"Cannot write function hashes for %s\n",pgm);
+    else fprintf(listing,"%d function(s) changed\n",n);
+    free(fnc);
+  }
+  if (IrCode && ! Error)
+  { char * codefile = fileName(pgm,BinaryCode ? ".tmb" : ".tm");
+    code = codefile ? fopen(codefile,BinaryCode ? "wb" : "w") : NULL;
+    if (code == NULL)
+      fprintf(stderr,"Cannot write the code for %s\n",pgm);
+    else
+    { if (TraceCode) fprintf(listing,"\nIntermediate code:\n");
+      startPhase();
+      irGen(syntaxTree);
+      endPhase("ir");
+      fclose(code);
+    }
+    free(codefile);
   }
 #if !NO_CODE
   if (! Error)
   { char * codefile;
     int fnlen = strcspn(pgm,".");
-    codefile = (char *) calloc(fnlen+4, sizeof(char));
+    codefile = (char *) calloc(fnlen+5, sizeof(char));
     strncpy(codefile,pgm,fnlen);
-    strcat(codefile,".tm");
-    code = fopen(codefile,"w");
+    strcat(codefile,BinaryCode ? ".tmb" : ".tm");
+    code = fopen(codefile,BinaryCode ? "wb" : "w");
     if (code == NULL)
     { printf("Unable to open %s\n",codefile);
       exit(1);
     }
+    startPhase();
     codeGen(syntaxTree,codefile);
+    emitImage();
+    endPhase("codegen");
     fclose(code);
   }
 #endif
 #endif
 #endif
+  if (stream != NULL)
+  { FILE * f = stream;
+    if (streamClose() != 0)
+      fprintf(stderr,"Cannot write the stream for %s\n",pgm);
+    fclose(f);
+  }
+  if (TimeReport) timeReport();
+  freeArena(astArena);
+  astArena = NULL;
+  srcFree();
   fclose(source);
-  return 0;
+  return Error;
+}
+
+/* Procedure compileOne runs in a worker process
+ * and compiles name with its listing in a .lst
+ * file, exiting with 1 on an error
+ */
+static void compileOne( char * name )
+{ char * lst = fileName(name,".lst");
+  FILE * out = lst ? fopen(lst,"w") : NULL;
+  int err;
+  if (out == NULL)
+  { fprintf(stderr,"Cannot open listing for %s\n",name);
+    exit(1);
+  }
+  err = compile(name,out);
+  fclose(out);
+  exit(err ? 1 : 0);
+}
+
+/* Function compileAll compiles the nfiles files
+ * in up to jobs worker processes at a time; the
+ * compiler state is global, so every file gets a
+ * fresh process. Returns the number that failed
+ */
+static int compileAll( char * files[], int nfiles, int jobs )
+{ int next = 0, running = 0, failed = 0;
+  while (next < nfiles || running > 0)
+  { int status;
+    if (next < nfiles && running < jobs)
+    { pid_t pid;
+      fflush(NULL);
+      pid = fork();
+      if (pid == 0) compileOne(files[next]);
+      if (pid < 0)
+      { fprintf(stderr,"Cannot start a worker for %s\n",files[next]);
+        failed++;
+      }
+      else running++;
+      next++;
+      continue;
+    }
+    if (wait(&status) < 0) break;
+    running--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+  }
+  return failed;
+}
+
+main( int argc, char * argv[] )
+{ int jobs = 1, first = 1;
+  while (first < argc && argv[first][0] == '-')
+  { if (strcmp(argv[first],"-ftime-report") == 0)
+    { TimeReport = TRUE;
+      first++;
+    }
+    else if (strcmp(argv[first],"-fjson") == 0)
+    { JsonStream = TRUE;
+      first++;
+    }
+    else if (strcmp(argv[first],"-fir") == 0)
+    { IrCode = TRUE;
+      first++;
+    }
+    else if (strcmp(argv[first],"-finline") == 0)
+    { InlineCode = TRUE;
+      first++;
+    }
+    else if (strcmp(argv[first],"-fchanges") == 0)
+    { ChangeReport = TRUE;
+      first++;
+    }
+    else if (strcmp(argv[first],"-j") == 0 && first + 1 < argc)
+    { jobs = atoi(argv[first+1]);
+      first += 2;
+    }
+    else break;
+  }
+  if (jobs < 1 || first >= argc || argv[first][0] == '-')
+    { fprintf(stderr,"usage: %s [-ftime-report] [-fchanges] [-fjson] [-fir] [-finline] [-j jobs] <filename> ...\n",argv[0]);
+      exit(1);
+    }
+  /* one file keeps the listing on the screen */
+  if (argc - first == 1)
+    return compile(argv[first],stdout) ? 1 : 0;
+  return compileAll(argv + first,argc - first,jobs) ? 1 : 0;
 }
 
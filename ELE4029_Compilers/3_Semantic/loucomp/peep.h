@@ -0,0 +1,25 @@
+/****************************************************/
+/* File: peep.h                                     */
+/* Peephole optimizer for generated TM code         */
+/****************************************************/
+
+#ifndef _PEEP_H_
+#define _PEEP_H_
+
+#include "tmb.h"
+
+/* Function peephole rewrites the count instructions
+ * in code (location i at code[i]) into an equivalent
+ * shorter program and returns its length. notes,
+ * if not NULL, holds one malloc'ed comment (or NULL)
+ * per instruction and is moved along with it; the
+ * comments of deleted instructions are freed.
+ * Code addresses must be formed pc-relative, as
+ * the code generator does; temps stored with base
+ * register mp are taken to be dead once reloaded.
+ * Instructions are only deleted when every use of
+ * the pc can be relocated
+ */
+int peephole( TmbRecord * code, char ** notes, int count );
+
+#endif
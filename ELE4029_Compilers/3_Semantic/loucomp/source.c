@@ -0,0 +1,81 @@
+/****************************************************/
+/* File: source.c                                   */
+/* Whole-file source buffer for the C-Minus scanners */
+/****************************************************/
+
+#include "globals.h"
+#include "source.h"
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+char * srcBuf = NULL;
+size_t srcLen = 0;
+
+static size_t mapLen = 0; /* length of the mapping, 0 if malloc'd */
+
+/* mapFile maps the regular file fd of len bytes
+ * with SRCPAD zero bytes after it
+ */
+static int mapFile(int fd, size_t len)
+{ size_t page = sysconf(_SC_PAGESIZE);
+  size_t total = (len + SRCPAD + page - 1) / page * page;
+  char * p;
+  /* zeroed anonymous memory for the padding, the file over
+   * its front; private and writable since flex writes
+   * '\0' after each yytext
+   */
+  p = mmap(NULL,total,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+  if (p == MAP_FAILED) return -1;
+  if (mmap(p,len,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_FIXED,fd,0) == MAP_FAILED)
+  { munmap(p,total);
+    return -1;
+  }
+  madvise(p,len,MADV_SEQUENTIAL);
+  srcBuf = p;
+  srcLen = len;
+  mapLen = total;
+  return 0;
+}
+
+/* readFile reads f to its end into a malloc'd srcBuf */
+static int readFile(FILE * f)
+{ size_t cap = 1 << 16, n;
+  char * p = malloc(cap);
+  srcLen = 0;
+  while (p != NULL)
+  { n = fread(p + srcLen,1,cap - srcLen - SRCPAD,f);
+    srcLen += n;
+    if (n == 0) break;
+    if (cap - srcLen - SRCPAD == 0)
+    { char * q = realloc(p,cap * 2);
+      if (q == NULL) free(p);
+      p = q;
+      cap *= 2;
+    }
+  }
+  if (p == NULL || ferror(f))
+  { free(p);
+    return -1;
+  }
+  memset(p + srcLen,0,SRCPAD);
+  srcBuf = p;
+  mapLen = 0;
+  return 0;
+}
+
+int srcLoad(FILE * f)
+{ struct stat st;
+  if (fstat(fileno(f),&st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+      && mapFile(fileno(f),st.st_size) == 0)
+    return 0;
+  return readFile(f);
+}
+
+void srcFree(void)
+{ if (srcBuf == NULL) return;
+  if (mapLen) munmap(srcBuf,mapLen);
+  else free(srcBuf);
+  srcBuf = NULL;
+  srcLen = 0;
+}
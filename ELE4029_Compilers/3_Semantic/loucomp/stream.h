@@ -0,0 +1,40 @@
+/****************************************************/
+/* File: stream.h                                   */
+/* Machine-readable token and syntax tree output    */
+/* for tools, one JSON object per line              */
+/****************************************************/
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+/* The lines are
+ *   {"token":"ID","line":3,"text":"x"}
+ *   {"node":2,"parent":1,"child":0,"line":3,
+ *    "kind":"Op","op":"+"}
+ * Nodes are numbered from 1 in preorder; parent is
+ * 0 at the top level and child is the child slot of
+ * the parent, siblings following in order. A node
+ * also has "name", "val", "type", "else" or "value"
+ * when its kind has one
+ */
+
+/* Procedure streamOpen starts writing the stream
+ * to f; stream (globals.h) is f until streamClose
+ */
+void streamOpen( FILE * f );
+
+/* Procedure streamToken writes token with its
+ * lexeme text, found on line
+ */
+void streamToken( TokenType token, const char * text, int line );
+
+/* Procedure streamTree writes the nodes of tree */
+void streamTree( TreeNode * tree );
+
+/* Procedure streamClose writes out what is still
+ * buffered and ends the stream; the file is left
+ * open. Returns -1 if a write failed, else 0
+ */
+int streamClose(void);
+
+#endif
@@ -1,9 +1,11 @@
 /****************************************************/
 /* File: symtab.c                                   */
-/* Symbol table implementation for the TINY compiler*/
-/* (allows only one symbol table)                   */
-/* Symbol table is implemented as a chained         */
-/* hash table                                       */
+/* Symbol table implementation for the C-Minus      */
+/* compiler (one table with nested scopes)          */
+/* Names are kept in an open addressing hash table  */
+/* that doubles when half full; each name points to */
+/* its innermost declaration, which points to the   */
+/* one it shadows                                   */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -13,25 +15,21 @@
 #include <string.h>
 #include "symtab.h"
 
-/* SIZE is the size of the hash table */
-#define SIZE 211
+/* INITSIZE is the initial size of the hash table
+   and of the scope stack, both powers of two */
+#define INITSIZE 256
 
-/* SHIFT is the power of two used as multiplier
-   in hash function  */
-#define SHIFT 4
-
-/* the hash function */
-static int hash ( char * key )
-{ int temp = 0;
-  int i = 0;
-  while (key[i] != '\0')
-  { temp = ((temp << SHIFT) + key[i]) % SIZE;
-    ++i;
+/* the hash function is FNV-1a */
+static unsigned hash ( char * key )
+{ unsigned temp = 2166136261u;
+  while (*key != '\0')
+  { temp ^= (unsigned char) *key++;
+    temp *= 16777619u;
   }
   return temp;
 }
 
-/* the list of line numbers of the source 
+/* the list of line numbers of the source
  * code in which a variable is referenced
  */
 typedef struct LineListRec
@@ -39,84 +37,247 @@ typedef struct LineListRec
      struct LineListRec * next;
    } * LineList;
 
-/* The record in the bucket lists for
- * each variable, including name, 
- * assigned memory location, and
- * the list of line numbers in which
- * it appears in the source code
+/* The record for each declaration, including
+ * the assigned memory location and the list
+ * of line numbers in which it appears in the
+ * source code; last is the tail of lines so
+ * a reference is added in constant time
  */
 typedef struct BucketListRec
-   { char * name;
-     LineList lines;
+   { struct NameRec * key;
+     LineList lines, last;
      int memloc ; /* memory location for variable */
-     struct BucketListRec * next;
+     int scope; /* nesting level of the declaration */
+     struct BucketListRec * shadow; /* same name, outer scope */
+     struct BucketListRec * next; /* next in the same scope */
    } * BucketList;
 
+/* One record per distinct name ever seen; the
+ * table holds pointers to them so it can grow
+ * without touching the declarations. decl is
+ * the visible declaration, NULL if none
+ */
+typedef struct NameRec
+   { char * name;
+     unsigned hash;
+     BucketList decl;
+   } * NameList;
+
 /* the hash table */
-static BucketList hashTable[SIZE];
+static NameList * hashTable = NULL;
+static int tableSize = 0;
+static int tableUsed = 0;
+
+/* the scope stack, each entry lists the
+ * declarations of one scope in order
+ */
+typedef struct
+   { BucketList first, last;
+   } ScopeRec;
+
+static ScopeRec * scopes = NULL;
+static int scopeSize = 0;
+static int level = 0;
+
+static void outOfMemory(void)
+{ fprintf(stderr,"Out of memory in symbol table\n");
+  exit(1);
+}
+
+/* init allocates the table and the global
+ * scope the first time it is needed
+ */
+static void init(void)
+{ if (hashTable != NULL) return;
+  hashTable = (NameList *) calloc(INITSIZE,sizeof(NameList));
+  scopes = (ScopeRec *) calloc(INITSIZE,sizeof(ScopeRec));
+  if (hashTable == NULL || scopes == NULL) outOfMemory();
+  tableSize = INITSIZE;
+  scopeSize = INITSIZE;
+}
+
+/* grow doubles the hash table, reinserting
+ * every name by its stored hash
+ */
+static void grow(void)
+{ int size = tableSize * 2;
+  NameList * t = (NameList *) calloc(size,sizeof(NameList));
+  int i;
+  if (t == NULL) outOfMemory();
+  for (i=0;i<tableSize;++i)
+  { NameList n = hashTable[i];
+    if (n != NULL)
+    { unsigned h = n->hash & (size - 1);
+      while (t[h] != NULL) h = (h + 1) & (size - 1);
+      t[h] = n;
+    }
+  }
+  free(hashTable);
+  hashTable = t;
+  tableSize = size;
+}
+
+/* find returns the record of name, adding
+ * it when create is set, NULL otherwise
+ */
+static NameList find( char * name, int create )
+{ unsigned h;
+  int i;
+  NameList n;
+  init();
+  h = hash(name);
+  i = h & (tableSize - 1);
+  while ((n = hashTable[i]) != NULL)
+  { if (n->hash == h && (n->name == name || strcmp(n->name,name) == 0))
+      return n;
+    i = (i + 1) & (tableSize - 1);
+  }
+  if (!create) return NULL;
+  n = (NameList) malloc(sizeof(struct NameRec));
+  if (n == NULL) outOfMemory();
+  n->name = name;
+  n->hash = h;
+  n->decl = NULL;
+  hashTable[i] = n;
+  if (++tableUsed * 2 > tableSize) grow();
+  return n;
+}
+
+static void addLine( BucketList l, int lineno )
+{ LineList t = (LineList) malloc(sizeof(struct LineListRec));
+  if (t == NULL) outOfMemory();
+  t->lineno = lineno;
+  t->next = NULL;
+  if (l->last == NULL) l->lines = t;
+  else l->last->next = t;
+  l->last = t;
+}
+
+/* the declaration of name in the innermost
+ * scope, NULL if there is none
+ */
+static BucketList topDecl( char * name )
+{ NameList n = find(name,0);
+  if (n == NULL || n->decl == NULL || n->decl->scope != level)
+    return NULL;
+  return n->decl;
+}
+
+void st_enter(void)
+{ init();
+  if (level + 1 == scopeSize)
+  { ScopeRec * s = (ScopeRec *) realloc(scopes,2 * scopeSize * sizeof(ScopeRec));
+    if (s == NULL) outOfMemory();
+    scopes = s;
+    scopeSize *= 2;
+  }
+  ++level;
+  scopes[level].first = scopes[level].last = NULL;
+}
+
+void st_exit(void)
+{ BucketList l, next;
+  if (level == 0) return;
+  for (l = scopes[level].first; l != NULL; l = next)
+  { LineList t, tnext;
+    next = l->next;
+    l->key->decl = l->shadow;
+    for (t = l->lines; t != NULL; t = tnext)
+    { tnext = t->next;
+      free(t);
+    }
+    free(l);
+  }
+  --level;
+}
+
+int st_level(void)
+{ return level;
+}
 
 /* Procedure st_insert inserts line numbers and
- * memory locations into the symbol table
+ * memory locations into the innermost scope
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
 void st_insert( char * name, int lineno, int loc )
-{ int h = hash(name);
-  BucketList l =  hashTable[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
-  if (l == NULL) /* variable not yet in table */
+{ NameList n = find(name,1);
+  BucketList l = n->decl;
+  if (l == NULL || l->scope != level) /* not yet in this scope */
   { l = (BucketList) malloc(sizeof(struct BucketListRec));
-    l->name = name;
-    l->lines = (LineList) malloc(sizeof(struct LineListRec));
-    l->lines->lineno = lineno;
+    if (l == NULL) outOfMemory();
+    l->key = n;
+    l->lines = l->last = NULL;
     l->memloc = loc;
-    l->lines->next = NULL;
-    l->next = hashTable[h];
-    hashTable[h] = l; }
-  else /* found in table, so just add line number */
-  { LineList t = l->lines;
-    while (t->next != NULL) t = t->next;
-    t->next = (LineList) malloc(sizeof(struct LineListRec));
-    t->next->lineno = lineno;
-    t->next->next = NULL;
+    l->scope = level;
+    l->shadow = n->decl;
+    l->next = NULL;
+    n->decl = l;
+    if (scopes[level].last == NULL) scopes[level].first = l;
+    else scopes[level].last->next = l;
+    scopes[level].last = l;
   }
+  addLine(l,lineno);
 } /* st_insert */
 
-/* Function st_lookup returns the memory 
- * location of a variable or -1 if not found
+void st_addline( char * name, int lineno )
+{ NameList n = find(name,0);
+  if (n != NULL && n->decl != NULL) addLine(n->decl,lineno);
+}
+
+/* Function st_lookup returns the memory location
+ * of the visible declaration of name, searching
+ * from the innermost scope out, or -1 if not found
  */
 int st_lookup ( char * name )
-{ int h = hash(name);
-  BucketList l =  hashTable[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
+{ NameList n = find(name,0);
+  if (n == NULL || n->decl == NULL) return -1;
+  else return n->decl->memloc;
+}
+
+int st_lookup_top ( char * name )
+{ BucketList l = topDecl(name);
   if (l == NULL) return -1;
   else return l->memloc;
 }
 
-/* Procedure printSymTab prints a formatted 
- * listing of the symbol table contents 
+/* Procedure printSymTab prints a formatted
+ * listing of the innermost scope contents
  * to the listing file
  */
 void printSymTab(FILE * listing)
-{ int i;
+{ BucketList l;
+  init();
+  fprintf(listing,"Scope %d\n",level);
   fprintf(listing,"Variable Name  Location   Line Numbers\n");
   fprintf(listing,"-------------  --------   ------------\n");
-  for (i=0;i<SIZE;++i)
-  { if (hashTable[i] != NULL)
-    { BucketList l = hashTable[i];
-      while (l != NULL)
-      { LineList t = l->lines;
-        fprintf(listing,"%-14s ",l->name);
-        fprintf(listing,"%-8d  ",l->memloc);
-        while (t != NULL)
-        { fprintf(listing,"%4d ",t->lineno);
-          t = t->next;
-        }
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+  for (l = scopes[level].first; l != NULL; l = l->next)
+  { LineList t = l->lines;
+    fprintf(listing,"%-14s ",l->key->name);
+    fprintf(listing,"%-8d  ",l->memloc);
+    while (t != NULL)
+    { fprintf(listing,"%4d ",t->lineno);
+      t = t->next;
     }
+    fprintf(listing,"\n");
   }
 } /* printSymTab */
+
+/* the probe length of a name is the number of
+ * slots find looks at to reach it
+ */
+void st_stats(FILE * listing)
+{ int i, total = 0, longest = 0;
+  init();
+  for (i=0;i<tableSize;++i)
+    if (hashTable[i] != NULL)
+    { int probes = ((i - (int) (hashTable[i]->hash & (tableSize - 1))) &
+                    (tableSize - 1)) + 1;
+      total += probes;
+      if (probes > longest) longest = probes;
+    }
+  fprintf(listing,"\nSymbol table: %d names in %d slots, load %.2f\n",
+          tableUsed,tableSize,(double) tableUsed / tableSize);
+  fprintf(listing,"  probes per name: average %.2f, longest %d\n",
+          tableUsed ? (double) total / tableUsed : 0.0,longest);
+}
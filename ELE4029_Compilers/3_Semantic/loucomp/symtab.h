@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: symtab.h                                   */
-/* Symbol table interface for the TINY compiler     */
-/* (allows only one symbol table)                   */
+/* Symbol table interface for the C-Minus compiler  */
+/* (one table with nested scopes)                   */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -9,22 +9,55 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
+/* Procedure st_enter opens a new innermost scope;
+ * the global scope is open from the start
+ */
+void st_enter(void);
+
+/* Procedure st_exit closes the innermost scope,
+ * dropping every symbol declared in it; the
+ * global scope is never closed
+ */
+void st_exit(void);
+
+/* Function st_level returns the nesting level of
+ * the innermost scope, 0 for the global scope
+ */
+int st_level(void);
+
 /* Procedure st_insert inserts line numbers and
- * memory locations into the symbol table
+ * memory locations into the innermost scope
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
 void st_insert( char * name, int lineno, int loc );
 
-/* Function st_lookup returns the memory 
- * location of a variable or -1 if not found
+/* Procedure st_addline adds lineno to the visible
+ * declaration of name, if any
+ */
+void st_addline( char * name, int lineno );
+
+/* Function st_lookup returns the memory location
+ * of the visible declaration of name, searching
+ * from the innermost scope out, or -1 if not found
  */
 int st_lookup ( char * name );
 
-/* Procedure printSymTab prints a formatted 
- * listing of the symbol table contents 
+/* Function st_lookup_top is st_lookup restricted
+ * to the innermost scope
+ */
+int st_lookup_top ( char * name );
+
+/* Procedure printSymTab prints a formatted
+ * listing of the innermost scope contents
  * to the listing file
  */
 void printSymTab(FILE * listing);
 
+/* Procedure st_stats prints the size and load
+ * factor of the hash table and its probe lengths
+ * to the listing file
+ */
+void st_stats(FILE * listing);
+
 #endif
@@ -9,6 +9,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "tmb.h"
+
+/* the JIT needs GCC-style x86-64 on a Unix */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__unix__)
+#define TM_JIT
+#include <stddef.h>
+#include <sys/mman.h>
+#endif
 
 #ifndef TRUE
 #define TRUE 1
@@ -18,8 +26,8 @@
 #endif
 
 /******* const *******/
-#define   IADDR_SIZE  1024 /* increase for large programs */
-#define   DADDR_SIZE  1024 /* increase for large programs */
+#define   IADDR_SIZE  1024 /* default, -i for large programs */
+#define   DADDR_SIZE  1024 /* default, -d for large programs */
 #define   NO_REGS 8
 #define   PC_REG  7
 
@@ -82,25 +90,41 @@ int iloc = 0 ;
 int dloc = 0 ;
 int traceflag = FALSE;
 int icountflag = FALSE;
+int profflag = FALSE;
+int jitflag = FALSE;
 
-INSTRUCTION iMem [IADDR_SIZE];
-int dMem [DADDR_SIZE];
+/* sizes set on the command line, iaddrSize
+   also grows to hold a whole .tmb image */
+int iaddrSize = IADDR_SIZE ;
+int daddrSize = DADDR_SIZE ;
+INSTRUCTION * iMem = NULL ;
+int * dMem = NULL ;
 int reg [NO_REGS];
 
-char * opCodeTab[]
-        = {"HALT","IN","OUT","ADD","SUB","MUL","DIV","????",
-            /* RR opcodes */
-           "LD","ST","????", /* RM opcodes */
-           "LDA","LDC","JLT","JLE","JGT","JGE","JEQ","JNE","????"
-           /* RA opcodes */
-          };
+/* RR, RM and RA opcodes, shared with the .tmb writer */
+char * opCodeTab[] = TMB_OPCODES;
 
 char * stepResultTab[]
         = {"OK","Halted","Instruction Memory Fault",
            "Data Memory Fault","Division by 0"
           };
 
-char pgmName[20];
+/* the profile: executions and taken jumps per
+   iMem location, executions per opcode, loads
+   and stores per dMem location. Allocated when
+   profiling is first turned on, zeroed by clear */
+long * execCount = NULL ;
+long * takenCount = NULL ;
+long * dReadCount = NULL ;
+long * dWriteCount = NULL ;
+long opCount [opRALim] ;
+
+/* the comment of every iMem location of a text
+   program, "* " lines before it and the text
+   after it, or NULL */
+char ** iNote = NULL ;
+
+char pgmName[256];
 FILE *pgm  ;
 
 char in_Line[LINESIZE] ;
@@ -119,9 +143,12 @@ int opClass( int c )
 } /* opClass */
 
 /********************************************/
-void writeInstruction ( int loc )
+/* printInstruction prints location loc
+ * without ending the line
+ */
+void printInstruction ( int loc )
 { printf( "%5d: ", loc) ;
-  if ( (loc >= 0) && (loc < IADDR_SIZE) )
+  if ( (loc >= 0) && (loc < iaddrSize) )
   { printf("%6s%3d,", opCodeTab[iMem[loc].iop], iMem[loc].iarg1);
     switch ( opClass(iMem[loc].iop) )
     { case opclRR: printf("%1d,%1d", iMem[loc].iarg2, iMem[loc].iarg3);
@@ -130,8 +157,13 @@ void writeInstruction ( int loc )
       case opclRA: printf("%3d(%1d)", iMem[loc].iarg2, iMem[loc].iarg3);
                    break;
     }
-    printf ("\n") ;
   }
+} /* printInstruction */
+
+/********************************************/
+void writeInstruction ( int loc )
+{ printInstruction(loc) ;
+  printf ("\n") ;
 } /* writeInstruction */
 
 /********************************************/
@@ -218,21 +250,76 @@ int error( char * msg, int lineNo, int instNo)
 } /* error */
 
 /********************************************/
-int readInstructions (void)
-{ OPCODE op;
-  int arg1, arg2, arg3;
-  int loc, regNo, lineNo;
+/* allocMemory sizes iMem and dMem to isize
+ * and dsize locations, FALSE if out of memory
+ */
+int allocMemory ( int isize, int dsize )
+{ INSTRUCTION * ip ;
+  int * dp ;
+  if ( (isize < 1) || (dsize < 1) ) return FALSE ;
+  ip = (INSTRUCTION *) realloc(iMem, isize * sizeof(INSTRUCTION)) ;
+  if ( ip == NULL ) return FALSE ;
+  iMem = ip ;
+  dp = (int *) realloc(dMem, dsize * sizeof(int)) ;
+  if ( dp == NULL ) return FALSE ;
+  dMem = dp ;
+  iaddrSize = isize ;
+  daddrSize = dsize ;
+  return TRUE ;
+} /* allocMemory */
+
+/********************************************/
+void clearMachine (void)
+{ int loc, regNo;
   for (regNo = 0 ; regNo < NO_REGS ; regNo++)
       reg[regNo] = 0 ;
-  dMem[0] = DADDR_SIZE - 1 ;
-  for (loc = 1 ; loc < DADDR_SIZE ; loc++)
+  dMem[0] = daddrSize - 1 ;
+  for (loc = 1 ; loc < daddrSize ; loc++)
       dMem[loc] = 0 ;
-  for (loc = 0 ; loc < IADDR_SIZE ; loc++)
+  for (loc = 0 ; loc < iaddrSize ; loc++)
   { iMem[loc].iop = opHALT ;
     iMem[loc].iarg1 = 0 ;
     iMem[loc].iarg2 = 0 ;
     iMem[loc].iarg3 = 0 ;
   }
+} /* clearMachine */
+
+/********************************************/
+/********************************************/
+/* keepNote makes iNote[loc] the comment block
+ * followed by the comment text, either NULL
+ */
+void keepNote ( int loc, char * block, char * text )
+{ int len = 0 ;
+  char * note ;
+  if ( iNote == NULL ) return ;
+  /* past the ")" closing the operands */
+  while ( (text != NULL) && (isspace(*text) || (*text == ')')) ) text++ ;
+  if ( (text != NULL) && (*text == '\0') ) text = NULL ;
+  if ( (block == NULL) && (text == NULL) ) return ;
+  if ( block != NULL ) len += strlen(block) + 2 ;
+  if ( text != NULL ) len += strlen(text) ;
+  note = (char *) malloc(len + 1) ;
+  if ( note == NULL ) return ;
+  note[0] = '\0' ;
+  if ( block != NULL )
+  { strcat(note,block) ;
+    if ( text != NULL ) strcat(note,"; ") ;
+  }
+  if ( text != NULL ) strcat(note,text) ;
+  free(iNote[loc]) ;
+  iNote[loc] = note ;
+} /* keepNote */
+
+/********************************************/
+int readInstructions (void)
+{ OPCODE op;
+  int arg1, arg2, arg3;
+  int loc, lineNo;
+  char block[LINESIZE] ;
+  clearMachine();
+  iNote = (char **) calloc(iaddrSize, sizeof(char *)) ;
+  block[0] = '\0' ;
   lineNo = 0 ;
   while (! feof(pgm))
   { fgets( in_Line, LINESIZE-2, pgm  ) ;
@@ -241,12 +328,18 @@ int readInstructions (void)
     lineLen = strlen(in_Line)-1 ;
     if (in_Line[lineLen]=='\n') in_Line[lineLen] = '\0' ;
     else in_Line[++lineLen] = '\0';
-    if ( (nonBlank()) && (in_Line[inCol] != '*') )
+    if ( (nonBlank()) && (in_Line[inCol] == '*') )
+    { /* the last comment line is kept for the next instruction */
+      inCol++ ;
+      nonBlank() ;
+      strcpy(block,in_Line + inCol) ;
+    }
+    else if ( nonBlank() )
     { if (! getNum())
         return error("Bad location", lineNo,-1);
       loc = num;
-      if (loc > IADDR_SIZE)
-        return error("Location too large",lineNo,loc);
+      if ((loc < 0) || (loc >= iaddrSize))
+        return error("Location too large (see -i)",lineNo,loc);
       if (! skipCh(':'))
         return error("Missing colon", lineNo,loc);
       if (! getWord ())
@@ -297,21 +390,92 @@ int readInstructions (void)
       iMem[loc].iarg1 = arg1;
       iMem[loc].iarg2 = arg2;
       iMem[loc].iarg3 = arg3;
+      keepNote(loc, block[0] ? block : NULL, in_Line + inCol) ;
+      block[0] = '\0' ;
     }
   }
   return TRUE;
 } /* readInstructions */
 
+/********************************************/
+/* readBinary loads a .tmb image (see tmb.h)
+ * with one read of the whole instruction
+ * array, then checks the operands
+ */
+int readBinary (void)
+{ TmbHeader h;
+  int loc;
+  clearMachine();
+  if ((fread(&h,sizeof(h),1,pgm) != 1) || (h.magic != TMB_MAGIC)
+      || (h.recSize != sizeof(TmbRecord)))
+    return error("Not a TM binary image",0,-1);
+  if (h.count < 0)
+    return error("Bad instruction count",0,h.count);
+  if (h.count > iaddrSize)
+  { if (! allocMemory(h.count,daddrSize))
+      return error("Out of memory",0,h.count);
+    clearMachine();
+  }
+  if (sizeof(TmbRecord) == sizeof(INSTRUCTION))
+  { if (fread(iMem,sizeof(TmbRecord),h.count,pgm) != (size_t) h.count)
+      return error("Truncated image",0,-1);
+  }
+  else
+  { TmbRecord r;
+    for (loc = 0 ; loc < h.count ; loc++)
+    { if (fread(&r,sizeof(r),1,pgm) != 1)
+        return error("Truncated image",0,loc);
+      iMem[loc].iop = r.op;
+      iMem[loc].iarg1 = r.arg1;
+      iMem[loc].iarg2 = r.arg2;
+      iMem[loc].iarg3 = r.arg3;
+    }
+  }
+  for (loc = 0 ; loc < h.count ; loc++)
+  { int op = iMem[loc].iop;
+    if ((op < 0) || (op >= opRALim) || (op == opRRLim) || (op == opRMLim))
+      return error("Illegal opcode",0,loc);
+    if ((iMem[loc].iarg1 < 0) || (iMem[loc].iarg1 >= NO_REGS))
+      return error("Bad first register",0,loc);
+    if ((opClass(op) == opclRR) &&
+        ((iMem[loc].iarg2 < 0) || (iMem[loc].iarg2 >= NO_REGS)))
+      return error("Bad second register",0,loc);
+    if ((iMem[loc].iarg3 < 0) || (iMem[loc].iarg3 >= NO_REGS))
+      return error(opClass(op) == opclRR ? "Bad third register"
+                                         : "Bad second register",0,loc);
+  }
+  return TRUE;
+} /* readBinary */
+
+
+/********************************************/
+/* readValue prompts until an integer is
+ * entered for an IN instruction
+ */
+int readValue (void)
+{ int ok ;
+  do
+  { printf("Enter value for IN instruction: ") ;
+    fflush (stdin);
+    fflush (stdout);
+    gets(in_Line);
+    lineLen = strlen(in_Line) ;
+    inCol = 0;
+    ok = getNum();
+    if ( ! ok ) printf ("Illegal value\n");
+  }
+  while (! ok);
+  return num;
+} /* readValue */
 
 /********************************************/
 STEPRESULT stepTM (void)
 { INSTRUCTION currentinstruction  ;
   int pc  ;
   int r,s,t,m  ;
-  int ok ;
 
   pc = reg[PC_REG] ;
-  if ( (pc < 0) || (pc > IADDR_SIZE)  )
+  if ( (pc < 0) || (pc >= iaddrSize)  )
       return srIMEM_ERR ;
   reg[PC_REG] = pc + 1 ;
   currentinstruction = iMem[ pc ] ;
@@ -328,7 +492,7 @@ STEPRESULT stepTM (void)
       r = currentinstruction.iarg1 ;
       s = currentinstruction.iarg3 ;
       m = currentinstruction.iarg2 + reg[s] ;
-      if ( (m < 0) || (m > DADDR_SIZE))
+      if ( (m < 0) || (m >= daddrSize))
          return srDMEM_ERR ;
       break;
 
@@ -350,18 +514,7 @@ STEPRESULT stepTM (void)
 
     case opIN :
     /***********************************/
-      do
-      { printf("Enter value for IN instruction: ") ;
-        fflush (stdin);
-        fflush (stdout);
-        gets(in_Line);
-        lineLen = strlen(in_Line) ;
-        inCol = 0;
-        ok = getNum();
-        if ( ! ok ) printf ("Illegal value\n");
-        else reg[r] = num;
-      }
-      while (! ok);
+      reg[r] = readValue();
       break;
 
     case opOUT :  
@@ -396,6 +549,671 @@ STEPRESULT stepTM (void)
   return srOKAY ;
 } /* stepTM */
 
+#ifdef __GNUC__
+/********************************************/
+/* runTM executes until a result other than
+ * srOKAY, like repeated stepTM calls, and
+ * returns that result; *count is the number
+ * of instructions executed.
+ * iMem is first decoded into a direct-threaded
+ * stream whose entries hold the address of
+ * their handler (GCC labels as values), with
+ * the registers kept in a local copy. Reg 7
+ * only matters to instructions that name it:
+ * pc-relative operands are turned into
+ * constants here, and whatever else uses reg 7
+ * goes through stepTM
+ */
+STEPRESULT runTM (int * count)
+{ typedef struct
+  { void * op;
+    int r, s, t;
+  } THREADED;
+  /* one more entry catches running off the end */
+  static THREADED * code = NULL ;
+  static int codeSize = 0 ;
+  static void * const handler [opRALim]
+     = { &&doHALT, &&doIN, &&doOUT, &&doADD, &&doSUB, &&doMUL, &&doDIV,
+         &&doHALT, &&doLD, &&doST, &&doHALT,
+         &&doLDA, &&doLDC, &&doJLT, &&doJLE, &&doJGT, &&doJGE, &&doJEQ,
+         &&doJNE };
+  /* the same jumps to a target known in advance */
+  static void * const jumpTo [opRALim]
+     = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+         NULL, &&doJMP, NULL, &&kJLT, &&kJLE, &&kJGT, &&kJGE, &&kJEQ,
+         &&kJNE };
+  const THREADED * ip ;
+  int rg [NO_REGS] ;
+  int loc, m, n = 0 ;
+  STEPRESULT result ;
+
+  if ( codeSize < iaddrSize + 1 )
+  { THREADED * p = (THREADED *) realloc(code,(iaddrSize + 1) * sizeof(THREADED)) ;
+    if ( p == NULL )
+    { printf("Out of memory\n") ;
+      *count = 0 ;
+      return srIMEM_ERR ;
+    }
+    code = p ;
+    codeSize = iaddrSize + 1 ;
+  }
+  for (loc = 0 ; loc < iaddrSize ; loc++)
+  { INSTRUCTION * in = &iMem[loc] ;
+    THREADED * c = &code[loc] ;
+    int op = in->iop ;
+    int target = in->iarg2 + loc + 1 ;
+    c->r = in->iarg1 ;
+    c->s = in->iarg2 ;
+    c->t = in->iarg3 ;
+    c->op = handler[op] ;
+    if ( op == opHALT )
+      ;
+    else if ( op == opRRLim || op == opRMLim )
+      c->op = &&slow ;
+    else if ( opClass(op) == opclRR )
+    { if ( c->r == PC_REG || c->s == PC_REG || c->t == PC_REG )
+        c->op = &&slow ;
+    }
+    else if ( c->t != PC_REG )
+    { /* computed jumps leave through the bounds check in doJump */
+      if ( c->r == PC_REG && op != opLDA )
+        c->op = &&slow ;
+    }
+    else if ( op == opLDA && c->r != PC_REG )
+    { c->op = &&doLDC ;
+      c->s = target ;
+    }
+    else if ( op == opLDC )
+    { if ( c->r == PC_REG ) c->op = &&slow ;
+    }
+    else if ( jumpTo[op] != NULL && c->r != PC_REG
+              && target >= 0 && target < iaddrSize )
+    { c->op = jumpTo[op] ;
+      c->s = target ;
+    }
+    else if ( op == opLDA && target >= 0 && target < iaddrSize )
+    { c->op = &&doJMP ;
+      c->s = target ;
+    }
+    else c->op = &&slow ;
+  }
+  code[iaddrSize].op = &&offEnd ;
+  for (loc = 0 ; loc < NO_REGS ; loc++)
+    rg[loc] = reg[loc] ;
+
+/* NEXT and GOTO count the instruction and
+   enter the next handler */
+#define NEXT      do { n++ ; ip++ ; goto *ip->op ; } while (0)
+#define GOTO(to)  do { n++ ; ip = &code[to] ; goto *ip->op ; } while (0)
+#define ADDR      (ip->s + rg[ip->t])
+#define PC        ((int) (ip - code))
+
+  loc = rg[PC_REG] ;
+  n++ ;
+  if ( (loc < 0) || (loc >= iaddrSize) )
+  { ip = &code[0] ;
+    goto imemErr ;
+  }
+  ip = &code[loc] ;
+  goto *ip->op ;
+
+  doHALT:
+    printf("HALT: %1d,%1d,%1d\n",ip->r,ip->s,ip->t);
+    result = srHALT ; goto stop;
+  doIN:   rg[ip->r] = readValue() ; NEXT;
+  doOUT:  printf ("OUT instruction prints: %d\n", rg[ip->r] ) ; NEXT;
+  doADD:  rg[ip->r] = rg[ip->s] + rg[ip->t] ; NEXT;
+  doSUB:  rg[ip->r] = rg[ip->s] - rg[ip->t] ; NEXT;
+  doMUL:  rg[ip->r] = rg[ip->s] * rg[ip->t] ; NEXT;
+  doDIV:
+    if ( rg[ip->t] == 0 ) { result = srZERODIVIDE ; goto stop; }
+    rg[ip->r] = rg[ip->s] / rg[ip->t] ; NEXT;
+  doLD:
+    m = ADDR ;
+    if ( (unsigned) m >= (unsigned) daddrSize ) { result = srDMEM_ERR ; goto stop; }
+    rg[ip->r] = dMem[m] ; NEXT;
+  doST:
+    m = ADDR ;
+    if ( (unsigned) m >= (unsigned) daddrSize ) { result = srDMEM_ERR ; goto stop; }
+    dMem[m] = rg[ip->r] ; NEXT;
+  doLDA:
+    m = ADDR ;
+    if ( ip->r == PC_REG ) goto doJump ;
+    rg[ip->r] = m ; NEXT;
+  doLDC:  rg[ip->r] = ip->s ; NEXT;
+  doJLT:  m = ADDR ; if ( rg[ip->r] <  0 ) goto doJump ; NEXT;
+  doJLE:  m = ADDR ; if ( rg[ip->r] <= 0 ) goto doJump ; NEXT;
+  doJGT:  m = ADDR ; if ( rg[ip->r] >  0 ) goto doJump ; NEXT;
+  doJGE:  m = ADDR ; if ( rg[ip->r] >= 0 ) goto doJump ; NEXT;
+  doJEQ:  m = ADDR ; if ( rg[ip->r] == 0 ) goto doJump ; NEXT;
+  doJNE:  m = ADDR ; if ( rg[ip->r] != 0 ) goto doJump ; NEXT;
+  doJump:
+    if ( (m < 0) || (m >= iaddrSize) )
+    { n++ ;
+      rg[PC_REG] = m ;
+      result = srIMEM_ERR ; goto done;
+    }
+    GOTO(m);
+  doJMP:  GOTO(ip->s);
+  kJLT:   if ( rg[ip->r] <  0 ) GOTO(ip->s) ; NEXT;
+  kJLE:   if ( rg[ip->r] <= 0 ) GOTO(ip->s) ; NEXT;
+  kJGT:   if ( rg[ip->r] >  0 ) GOTO(ip->s) ; NEXT;
+  kJGE:   if ( rg[ip->r] >= 0 ) GOTO(ip->s) ; NEXT;
+  kJEQ:   if ( rg[ip->r] == 0 ) GOTO(ip->s) ; NEXT;
+  kJNE:   if ( rg[ip->r] != 0 ) GOTO(ip->s) ; NEXT;
+  slow:
+    /* the checked interpreter, with reg 7 in place */
+    for (m = 0 ; m < NO_REGS ; m++)
+      reg[m] = rg[m] ;
+    reg[PC_REG] = PC ;
+    result = stepTM () ;
+    for (m = 0 ; m < NO_REGS ; m++)
+      rg[m] = reg[m] ;
+    if ( result != srOKAY ) goto failed ;
+    if ( (rg[PC_REG] < 0) || (rg[PC_REG] >= iaddrSize) )
+    { n++ ;
+      result = srIMEM_ERR ; goto done;
+    }
+    GOTO(rg[PC_REG]);
+  offEnd:
+    rg[PC_REG] = iaddrSize ;
+    result = srIMEM_ERR ; goto done;
+  imemErr:
+    result = srIMEM_ERR ; goto done;
+
+#undef NEXT
+#undef GOTO
+#undef ADDR
+
+  stop:
+  /* reg 7 as stepTM leaves it, past the last instruction */
+  rg[PC_REG] = PC + 1 ;
+  failed:
+  iloc = PC ;
+  goto finish ;
+  done:
+  /* stopped fetching from reg 7 */
+  iloc = rg[PC_REG] ;
+  finish:
+#undef PC
+  for (m = 0 ; m < NO_REGS ; m++)
+    reg[m] = rg[m] ;
+  *count = n ;
+  return result ;
+} /* runTM */
+#endif
+
+#ifdef TM_JIT
+/********************************************/
+/* The JIT translates iMem into x86-64 code,
+ * one native sequence per location, with TM
+ * registers 0-6 kept in r8d-r14d. Reg 7 only
+ * exists at translation time: pc-relative
+ * operands become constants and jumps native
+ * jumps, computed jumps go through a table of
+ * the native locations. What the native code
+ * does not do (IN, OUT, HALT, faults, other
+ * uses of reg 7) makes it return with the
+ * location in JitState.pc, where jitTM runs it
+ * with stepTM and then re-enters.
+ * Host registers: rbx the JitState, rbp the
+ * instruction count, rsi dMem, edi daddrSize,
+ * r15 the table, eax ecx edx scratch
+ */
+typedef struct
+   { int reg [NO_REGS] ;
+     int pc ;
+     int dsize ;
+     long count ;
+     int * dMem ;
+     void ** table ;
+   } JitState ;
+
+typedef void (* JITENTRY) (JitState *) ;
+
+/* the jump sites patched once all code is out */
+typedef struct
+   { unsigned char * at ; /* the rel32 field */
+     int kind ;
+     int loc ;
+   } JitFix ;
+
+enum { fixNative, fixExit, fixCommon } ;
+
+unsigned char * jitCode = NULL ;
+size_t jitSize = 0 ;
+void ** jitTable = NULL ;
+int jitValid = FALSE ;
+
+static unsigned char * jp ;
+static JitFix * jitFix ;
+static int nFix ;
+
+#define HREG(r) (8 + (r))
+#define rAX  0
+#define rCX  1
+#define rDX  2
+#define rBX  3
+#define rSP  4
+#define rBP  5
+#define rSI  6
+#define rDI  7
+#define rR15 15
+
+static void jb ( int b )
+{ *jp++ = (unsigned char) b ; }
+
+static void jd ( int d )
+{ memcpy(jp, &d, 4) ; jp += 4 ; }
+
+/* jrex emits the REX prefix of reg and rm, if any */
+static void jrex ( int w, int reg, int rm )
+{ int rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3) ;
+  if ( rex != 0x40 ) jb(rex) ;
+}
+
+/* jrr emits op with register operands */
+static void jrr ( int op, int reg, int rm )
+{ jrex(0, reg, rm) ;
+  jb(op) ;
+  jb(0xC0 | ((reg & 7) << 3) | (rm & 7)) ;
+}
+
+/* jmem emits op reg,[base+disp] */
+static void jmem ( int w, int op, int reg, int base, int disp )
+{ jrex(w, reg, base) ;
+  jb(op) ;
+  jb(0x80 | ((reg & 7) << 3) | (base & 7)) ;
+  if ( (base & 7) == rSP ) jb(0x24) ;
+  jd(disp) ;
+}
+
+/* jidx emits op reg,[rsi+rax*4] */
+static void jidx ( int op, int reg )
+{ jrex(0, reg, 0) ;
+  jb(op) ;
+  jb(0x04 | ((reg & 7) << 3)) ;
+  jb(0x86) ;
+}
+
+static void jmovi ( int reg, int imm )
+{ jrex(0, 0, reg) ;
+  jb(0xB8 + (reg & 7)) ;
+  jd(imm) ;
+}
+
+static void jcount (void)
+{ jb(0x48) ; jb(0xFF) ; jb(0xC5) ; } /* inc rbp */
+
+/* jfix leaves a rel32 to be patched */
+static void jfix ( int kind, int loc )
+{ jitFix[nFix].at = jp ;
+  jitFix[nFix].kind = kind ;
+  jitFix[nFix].loc = loc ;
+  nFix++ ;
+  jd(0) ;
+}
+
+static void jjmp ( int kind, int loc )
+{ jb(0xE9) ; jfix(kind, loc) ; }
+
+/* jjcc jumps on condition code cc (0x84 je ...) */
+static void jjcc ( int cc, int kind, int loc )
+{ jb(0x0F) ; jb(cc) ; jfix(kind, loc) ; }
+
+/* jexit leaves the native code at location loc */
+static void jexit ( int loc )
+{ jmovi(rAX, loc) ;
+  jjmp(fixCommon, 0) ;
+}
+
+/* jdispatch jumps to the location in eax */
+static void jdispatch (void)
+{ jb(0x3D) ; jd(iaddrSize) ;          /* cmp eax,iaddrSize */
+  jjcc(0x83, fixCommon, 0) ;          /* jae: leave there */
+  jb(0x41) ; jb(0xFF) ; jb(0x24) ; jb(0xC7) ; /* jmp [r15+rax*8] */
+}
+
+/* jaddr puts the checked dMem address d+reg(s)
+ * in eax for location loc
+ */
+static void jaddr ( int loc, int d, int s )
+{ jmem(0, 0x8D, rAX, HREG(s), d) ;    /* lea eax,[s+d] */
+  jrr(0x39, rDI, rAX) ;               /* cmp eax,edi */
+  jjcc(0x83, fixExit, loc) ;          /* jae */
+}
+
+/* the condition codes of JLT..JNE after test */
+static const int jitCC [6] = { 0x8C, 0x8E, 0x8F, 0x8D, 0x84, 0x85 } ;
+
+/* jitInstruction translates location loc */
+static void jitInstruction ( int loc )
+{ INSTRUCTION * in = &iMem[loc] ;
+  int op = in->iop, r = in->iarg1, s = in->iarg2, t = in->iarg3 ;
+  int target = s + loc + 1 ;
+  unsigned char * skip ;
+  switch ( op )
+  { case opADD : case opSUB : case opMUL :
+      if ( (r == PC_REG) || (s == PC_REG) || (t == PC_REG) ) break ;
+      jrr(0x89, HREG(s), rAX) ;
+      if ( op == opADD ) jrr(0x01, HREG(t), rAX) ;
+      else if ( op == opSUB ) jrr(0x29, HREG(t), rAX) ;
+      else
+      { jrex(0, rAX, HREG(t)) ; jb(0x0F) ; jb(0xAF) ;
+        jb(0xC0 | (HREG(t) & 7)) ;
+      }
+      jcount() ;
+      jrr(0x89, rAX, HREG(r)) ;
+      return ;
+    case opDIV :
+      if ( (r == PC_REG) || (s == PC_REG) || (t == PC_REG) ) break ;
+      jrr(0x85, HREG(t), HREG(t)) ;
+      jjcc(0x84, fixExit, loc) ;       /* division by 0 */
+      jrr(0x89, HREG(s), rAX) ;
+      /* idiv faults on INT_MIN / -1 */
+      jrex(0, 0, HREG(t)) ; jb(0x83) ; jb(0xF8 | (HREG(t) & 7)) ; jb(0xFF) ;
+      jb(0x75) ; jb(4) ;                  /* jne to cdq */
+      jb(0xF7) ; jb(0xD8) ;               /* neg eax */
+      jb(0xEB) ; jb(4) ;                  /* jmp past idiv */
+      jb(0x99) ;                          /* cdq */
+      jrex(0, 0, HREG(t)) ; jb(0xF7) ; jb(0xF8 | (HREG(t) & 7)) ;
+      jcount() ;
+      jrr(0x89, rAX, HREG(r)) ;
+      return ;
+    case opLD :
+    case opST :
+      if ( (op == opST) && (r == PC_REG) ) break ;
+      if ( t == PC_REG )
+      { if ( (target < 0) || (target >= daddrSize) ) break ;
+        jmem(0, op == opLD ? 0x8B : 0x89,
+             r == PC_REG ? rAX : HREG(r), rSI, target * 4) ;
+      }
+      else
+      { jaddr(loc, s, t) ;
+        jidx(op == opLD ? 0x8B : 0x89, r == PC_REG ? rAX : HREG(r)) ;
+      }
+      jcount() ;
+      if ( r == PC_REG ) jdispatch() ;
+      return ;
+    case opLDA :
+    case opLDC :
+      if ( op == opLDC ) target = s ;
+      if ( r != PC_REG )
+      { if ( (op == opLDC) || (t == PC_REG) ) jmovi(HREG(r), target) ;
+        else jmem(0, 0x8D, HREG(r), HREG(t), s) ;
+        jcount() ;
+        return ;
+      }
+      jcount() ;
+      if ( (op == opLDA) && (t != PC_REG) )
+      { jmem(0, 0x8D, rAX, HREG(t), s) ;
+        jdispatch() ;
+      }
+      else if ( (target >= 0) && (target < iaddrSize) )
+        jjmp(fixNative, target) ;
+      else jexit(target) ;
+      return ;
+    case opJLT : case opJLE : case opJGT :
+    case opJGE : case opJEQ : case opJNE :
+      if ( r == PC_REG ) break ;
+      if ( (t == PC_REG) && ((target < 0) || (target >= iaddrSize)) ) break ;
+      jcount() ;
+      jrr(0x85, HREG(r), HREG(r)) ;
+      if ( t == PC_REG )
+      { jjcc(jitCC[op - opJLT], fixNative, target) ;
+        return ;
+      }
+      /* the opposite condition skips the jump */
+      jb(0x70 | ((jitCC[op - opJLT] & 0x0F) ^ 1)) ;
+      skip = jp ;
+      jb(0) ;
+      jmem(0, 0x8D, rAX, HREG(t), s) ;
+      jdispatch() ;
+      *skip = (unsigned char) (jp - skip - 1) ;
+      return ;
+  }
+  /* everything else is left to stepTM */
+  jexit(loc) ;
+}
+
+/********************************************/
+/* jitCompile translates iMem, FALSE if out of
+ * memory
+ */
+int jitCompile (void)
+{ size_t size = 64 * (size_t) (iaddrSize + 2) + 4096 ;
+  size_t * native, * exitAt, common ;
+  int loc, i ;
+  void * p ;
+  if ( jitValid ) return TRUE ;
+  native = (size_t *) malloc((iaddrSize + 1) * sizeof(size_t)) ;
+  exitAt = (size_t *) malloc(iaddrSize * sizeof(size_t)) ;
+  jitFix = (JitFix *) malloc((3 * iaddrSize + 4) * sizeof(JitFix)) ;
+  jitTable = (void **) malloc(iaddrSize * sizeof(void *)) ;
+  p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) ;
+  if ( (native == NULL) || (exitAt == NULL) || (jitFix == NULL)
+       || (jitTable == NULL) || (p == MAP_FAILED) )
+  { free(native) ; free(exitAt) ; free(jitFix) ; free(jitTable) ;
+    jitTable = NULL ;
+    if ( p != MAP_FAILED ) munmap(p, size) ;
+    return FALSE ;
+  }
+  jitCode = (unsigned char *) p ;
+  jitSize = size ;
+  jp = jitCode ;
+  nFix = 0 ;
+  /* entry: save registers, load the state, go to pc */
+  jb(0x53) ; jb(0x55) ; jb(0x41) ; jb(0x54) ;
+  jb(0x41) ; jb(0x55) ; jb(0x41) ; jb(0x56) ; jb(0x41) ; jb(0x57) ;
+  jb(0x48) ; jb(0x89) ; jb(0xFB) ;                  /* mov rbx,rdi */
+  for (i = 0 ; i < PC_REG ; i++)
+    jmem(0, 0x8B, HREG(i), rBX, i * 4) ;
+  jmem(1, 0x8B, rBP, rBX, offsetof(JitState, count)) ;
+  jmem(1, 0x8B, rSI, rBX, offsetof(JitState, dMem)) ;
+  jmem(0, 0x8B, rDI, rBX, offsetof(JitState, dsize)) ;
+  jmem(1, 0x8B, rR15, rBX, offsetof(JitState, table)) ;
+  jmem(0, 0x8B, rAX, rBX, offsetof(JitState, pc)) ;
+  jb(0x41) ; jb(0xFF) ; jb(0x24) ; jb(0xC7) ;       /* jmp [r15+rax*8] */
+  for (loc = 0 ; loc < iaddrSize ; loc++)
+  { native[loc] = jp - jitCode ;
+    jitInstruction(loc) ;
+  }
+  native[iaddrSize] = jp - jitCode ;
+  jexit(iaddrSize) ;
+  for (loc = 0 ; loc < iaddrSize ; loc++)
+  { exitAt[loc] = jp - jitCode ;
+    jexit(loc) ;
+  }
+  /* common exit: eax is the location */
+  common = jp - jitCode ;
+  jmem(0, 0x89, rAX, rBX, offsetof(JitState, pc)) ;
+  for (i = 0 ; i < PC_REG ; i++)
+    jmem(0, 0x89, HREG(i), rBX, i * 4) ;
+  jmem(1, 0x89, rBP, rBX, offsetof(JitState, count)) ;
+  jb(0x41) ; jb(0x5F) ; jb(0x41) ; jb(0x5E) ; jb(0x41) ; jb(0x5D) ;
+  jb(0x41) ; jb(0x5C) ; jb(0x5D) ; jb(0x5B) ; jb(0xC3) ;
+  for (i = 0 ; i < nFix ; i++)
+  { size_t to = jitFix[i].kind == fixNative ? native[jitFix[i].loc]
+              : jitFix[i].kind == fixExit ? exitAt[jitFix[i].loc] : common ;
+    int rel = (int) ((long) to - (long) (jitFix[i].at + 4 - jitCode)) ;
+    memcpy(jitFix[i].at, &rel, 4) ;
+  }
+  for (loc = 0 ; loc < iaddrSize ; loc++)
+    jitTable[loc] = jitCode + native[loc] ;
+  free(native) ; free(exitAt) ; free(jitFix) ;
+  if ( mprotect(jitCode, jitSize, PROT_READ | PROT_EXEC) != 0 )
+  { munmap(jitCode, jitSize) ;
+    return FALSE ;
+  }
+  jitValid = TRUE ;
+  return TRUE ;
+} /* jitCompile */
+
+/********************************************/
+/* jitTM is runTM on the native code; the
+ * locations it leaves at run through stepTM
+ */
+STEPRESULT jitTM (int * count)
+{ JitState st ;
+  JITENTRY enter = (JITENTRY) (void *) jitCode ;
+  STEPRESULT result ;
+  long n = 0 ;
+  int i, pc ;
+  for (;;)
+  { pc = reg[PC_REG] ;
+    if ( (pc >= 0) && (pc < iaddrSize) )
+    { for (i = 0 ; i < NO_REGS ; i++) st.reg[i] = reg[i] ;
+      st.pc = pc ;
+      st.count = 0 ;
+      st.dMem = dMem ;
+      st.dsize = daddrSize ;
+      st.table = jitTable ;
+      enter(&st) ;
+      for (i = 0 ; i < PC_REG ; i++) reg[i] = st.reg[i] ;
+      n += st.count ;
+      pc = st.pc ;
+    }
+    reg[PC_REG] = pc ;
+    iloc = pc ;
+    result = stepTM () ;
+    n++ ;
+    if ( result != srOKAY ) break ;
+  }
+  *count = (int) n ;
+  return result ;
+} /* jitTM */
+#endif
+
+/********************************************/
+/* allocProfile allocates the zeroed profile
+ * counters, FALSE if out of memory
+ */
+int allocProfile (void)
+{ if ( execCount != NULL ) return TRUE ;
+  execCount = (long *) calloc(iaddrSize, sizeof(long)) ;
+  takenCount = (long *) calloc(iaddrSize, sizeof(long)) ;
+  dReadCount = (long *) calloc(daddrSize, sizeof(long)) ;
+  dWriteCount = (long *) calloc(daddrSize, sizeof(long)) ;
+  memset(opCount, 0, sizeof(opCount)) ;
+  if ( (execCount != NULL) && (takenCount != NULL)
+       && (dReadCount != NULL) && (dWriteCount != NULL) )
+    return TRUE ;
+  free(execCount) ; free(takenCount) ;
+  free(dReadCount) ; free(dWriteCount) ;
+  execCount = takenCount = dReadCount = dWriteCount = NULL ;
+  return FALSE ;
+} /* allocProfile */
+
+/********************************************/
+void clearProfile (void)
+{ if ( execCount == NULL ) return ;
+  memset(execCount, 0, iaddrSize * sizeof(long)) ;
+  memset(takenCount, 0, iaddrSize * sizeof(long)) ;
+  memset(dReadCount, 0, daddrSize * sizeof(long)) ;
+  memset(dWriteCount, 0, daddrSize * sizeof(long)) ;
+  memset(opCount, 0, sizeof(opCount)) ;
+} /* clearProfile */
+
+/********************************************/
+/* profileStep is stepTM counting the
+ * instruction it executes
+ */
+STEPRESULT profileStep (void)
+{ int pc = reg[PC_REG] ;
+  INSTRUCTION * in ;
+  STEPRESULT result ;
+  int m ;
+  if ( (pc < 0) || (pc >= iaddrSize) ) return stepTM () ;
+  in = &iMem[pc] ;
+  /* stepTM advances reg 7 before using it */
+  m = in->iarg2 + (in->iarg3 == PC_REG ? pc + 1 : reg[in->iarg3]) ;
+  result = stepTM () ;
+  if ( (result != srOKAY) && (result != srHALT) ) return result ;
+  execCount[pc]++ ;
+  opCount[in->iop]++ ;
+  if ( in->iop == opLD ) dReadCount[m]++ ;
+  else if ( in->iop == opST ) dWriteCount[m]++ ;
+  else if ( (in->iop >= opJLT) && (reg[PC_REG] != pc + 1) )
+    takenCount[pc]++ ;
+  return result ;
+} /* profileStep */
+
+/* the counts qsort orders indexes by */
+long * sortKey ;
+long * sortKey2 ;
+
+int byCount ( const void * a, const void * b )
+{ int i = * (const int *) a, j = * (const int *) b ;
+  long ci = sortKey[i] + (sortKey2 ? sortKey2[i] : 0) ;
+  long cj = sortKey[j] + (sortKey2 ? sortKey2[j] : 0) ;
+  if ( ci != cj ) return ci < cj ? 1 : -1 ;
+  return i - j ;
+} /* byCount */
+
+/********************************************/
+/* sortedBy returns the indexes 0..n-1 of the
+ * nonzero key (+ key2) entries, largest first,
+ * and their number in *used; NULL if out of memory
+ */
+int * sortedBy ( long * key, long * key2, int n, int * used )
+{ int * idx = (int *) malloc(n * sizeof(int)) ;
+  int i, k = 0 ;
+  *used = 0 ;
+  if ( idx == NULL ) return NULL ;
+  for (i = 0 ; i < n ; i++)
+    if ( key[i] || (key2 && key2[i]) ) idx[k++] = i ;
+  sortKey = key ;
+  sortKey2 = key2 ;
+  qsort(idx, k, sizeof(int), byCount) ;
+  *used = k ;
+  return idx ;
+} /* sortedBy */
+
+#define PROFILE_TOP 20
+
+/********************************************/
+/* printProfile prints the profile, hottest
+ * entries first
+ */
+void printProfile (void)
+{ long total = 0 ;
+  int * idx ;
+  int i, n, op ;
+  long opc [opRALim] ;
+  for (op = 0 ; op < opRALim ; op++)
+  { opc[op] = opCount[op] ;
+    total += opCount[op] ;
+  }
+  printf("Profile: %ld instructions executed\n", total) ;
+  if ( total == 0 ) return ;
+  printf("  by opcode:\n") ;
+  idx = sortedBy(opc, NULL, opRALim, &n) ;
+  for (i = 0 ; (idx != NULL) && (i < n) ; i++)
+    printf("  %6s %10ld %6.2f%%\n", opCodeTab[idx[i]], opc[idx[i]],
+           100.0 * opc[idx[i]] / total) ;
+  free(idx) ;
+  printf("  hottest locations:\n") ;
+  idx = sortedBy(execCount, NULL, iaddrSize, &n) ;
+  for (i = 0 ; (idx != NULL) && (i < n) && (i < PROFILE_TOP) ; i++)
+  { int loc = idx[i] ;
+    printf("  %10ld %6.2f%% ", execCount[loc], 100.0 * execCount[loc] / total) ;
+    if ( iMem[loc].iop >= opJLT )
+      printf("taken %5.1f%% ", 100.0 * takenCount[loc] / execCount[loc]) ;
+    else
+      printf("             ") ;
+    printInstruction(loc) ;
+    if ( iNote && iNote[loc] ) printf("\t%s", iNote[loc]) ;
+    printf("\n") ;
+  }
+  free(idx) ;
+  printf("  hottest data locations (loads, stores):\n") ;
+  idx = sortedBy(dReadCount, dWriteCount, daddrSize, &n) ;
+  for (i = 0 ; (idx != NULL) && (i < n) && (i < PROFILE_TOP) ; i++)
+    printf("  %5d: %10ld %10ld\n", idx[i], dReadCount[idx[i]],
+           dWriteCount[idx[i]]) ;
+  free(idx) ;
+} /* printProfile */
+
 /********************************************/
 int doCommand (void)
 { char cmd;
@@ -422,6 +1240,32 @@ int doCommand (void)
       if ( traceflag ) printf("on.\n"); else printf("off.\n");
       break;
 
+    case 'f' :
+    /***********************************/
+      if ( ! profflag && ! allocProfile () )
+      { printf("Out of memory for the profile\n") ;
+        break ;
+      }
+      profflag = ! profflag ;
+      printf("Profiling now ");
+      if ( profflag ) printf("on.\n"); else printf("off.\n");
+      break;
+
+    case 'j' :
+    /***********************************/
+#ifdef TM_JIT
+      if ( ! jitflag && ! jitCompile () )
+      { printf("Out of memory for native code\n") ;
+        break ;
+      }
+      jitflag = ! jitflag ;
+      printf("Native code for 'go' now ");
+      if ( jitflag ) printf("on.\n"); else printf("off.\n");
+#else
+      printf("No native code on this machine\n") ;
+#endif
+      break;
+
     case 'h' :
     /***********************************/
       printf("Commands are:\n");
@@ -440,6 +1284,10 @@ int doCommand (void)
       printf("   p(rint         "\
              "Toggle print of total instructions executed"\
              " ('go' only)\n");
+      printf("   pro(f)ile      "\
+             "Toggle counting of executions, printed at the end\n");
+      printf("   j(it           "\
+             "Toggle running 'go' as native code\n");
       printf("   c(lear         "\
              "Reset simulator for new execution of program\n");
       printf("   h(elp          "\
@@ -482,7 +1330,7 @@ int doCommand (void)
       if ( ! atEOL ())
         printf ("Instruction locations?\n");
       else
-      { while ((iloc >= 0) && (iloc < IADDR_SIZE)
+      { while ((iloc >= 0) && (iloc < iaddrSize)
                 && (printcnt > 0) )
         { writeInstruction(iloc);
           iloc++ ;
@@ -501,7 +1349,7 @@ int doCommand (void)
       if ( ! atEOL ())
         printf("Data locations?\n");
       else
-      { while ((dloc >= 0) && (dloc < DADDR_SIZE)
+      { while ((dloc >= 0) && (dloc < daddrSize)
                   && (printcnt > 0))
         { printf("%5d: %5d\n",dloc,dMem[dloc]);
           dloc++;
@@ -517,9 +1365,10 @@ int doCommand (void)
       stepcnt = 0;
       for (regNo = 0;  regNo < NO_REGS ; regNo++)
             reg[regNo] = 0 ;
-      dMem[0] = DADDR_SIZE - 1 ;
-      for (loc = 1 ; loc < DADDR_SIZE ; loc++)
+      dMem[0] = daddrSize - 1 ;
+      for (loc = 1 ; loc < daddrSize ; loc++)
             dMem[loc] = 0 ;
+      clearProfile () ;
       break;
 
     case 'q' : return FALSE;  /* break; */
@@ -530,10 +1379,19 @@ int doCommand (void)
   if ( stepcnt > 0 )
   { if ( cmd == 'g' )
     { stepcnt = 0;
+#ifdef __GNUC__
+      /* the checked loop only when tracing or profiling */
+      if ( ! traceflag && ! profflag )
+#ifdef TM_JIT
+        stepResult = jitflag ? jitTM (&stepcnt) : runTM (&stepcnt);
+#else
+        stepResult = runTM (&stepcnt);
+#endif
+#endif
       while (stepResult == srOKAY)
       { iloc = reg[PC_REG] ;
         if ( traceflag ) writeInstruction( iloc ) ;
-        stepResult = stepTM ();
+        stepResult = profflag ? profileStep () : stepTM ();
         stepcnt++;
       }
       if ( icountflag )
@@ -543,11 +1401,12 @@ int doCommand (void)
     { while ((stepcnt > 0) && (stepResult == srOKAY))
       { iloc = reg[PC_REG] ;
         if ( traceflag ) writeInstruction( iloc ) ;
-        stepResult = stepTM ();
+        stepResult = profflag ? profileStep () : stepTM ();
         stepcnt-- ;
       }
     }
     printf( "%s\n",stepResultTab[stepResult] );
+    if ( profflag && (stepResult != srOKAY) ) printProfile () ;
   }
   return TRUE;
 } /* doCommand */
@@ -558,21 +1417,40 @@ int doCommand (void)
 /********************************************/
 
 main( int argc, char * argv[] )
-{ if (argc != 2)
-  { printf("usage: %s <filename>\n",argv[0]);
+{ int binary;
+  int isize = IADDR_SIZE, dsize = DADDR_SIZE;
+  int arg = 1;
+  while ((arg + 2 < argc) && (argv[arg][0] == '-'))
+  { if (strcmp(argv[arg],"-i") == 0) isize = atoi(argv[arg+1]);
+    else if (strcmp(argv[arg],"-d") == 0) dsize = atoi(argv[arg+1]);
+    else break;
+    arg += 2;
+  }
+  if ((arg != argc - 1) || (isize < 1) || (dsize < 1))
+  { printf("usage: %s [-i imem] [-d dmem] <filename>\n",argv[0]);
+    exit(1);
+  }
+  if (! allocMemory(isize,dsize))
+  { printf("cannot allocate %d + %d locations\n",isize,dsize);
+    exit(1);
+  }
+  if (strlen(argv[arg]) >= sizeof(pgmName) - 4)
+  { printf("file name '%s' too long\n",argv[arg]);
     exit(1);
   }
-  strcpy(pgmName,argv[1]) ;
+  strcpy(pgmName,argv[arg]) ;
   if (strchr (pgmName, '.') == NULL)
      strcat(pgmName,".tm");
-  pgm = fopen(pgmName,"r");
+  binary = (strlen(pgmName) > 4)
+           && (strcmp(pgmName + strlen(pgmName) - 4,".tmb") == 0);
+  pgm = fopen(pgmName,binary ? "rb" : "r");
   if (pgm == NULL)
   { printf("file '%s' not found\n",pgmName);
     exit(1);
   }
 
   /* read the program */
-  if ( ! readInstructions ())
+  if ( ! (binary ? readBinary () : readInstructions ()))
          exit(1) ;
   /* switch input file to terminal */
   /* reset( input ); */
@@ -2294,7 +2294,8 @@ int yyerror(char * message)
  * compatible with ealier versions of the TINY scanner
  */
 static int yylex(void)
-{ return getToken(); }
+{ tokenCount++;
+  return getToken(); }
 
 TreeNode * parse(void)
 { yyparse();
@@ -0,0 +1,115 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+/*
+ * Event queue and timebase for the lab programs.
+ *
+ * Interrupt handlers only post a 2-byte event into a ring and return; the
+ * main loop takes events out with ev_wait() and does the actual work.
+ * SIGNAL handlers run with interrupts disabled and never nest, so together
+ * they are a single producer: only they move ev_head, only the main loop
+ * moves ev_tail, and both are single bytes, so no locking is needed.
+ * An event that arrives while the ring is full is counted in ev_lost.
+ *
+ * The timebase is Timer0 in CTC mode at exactly 1 ms (16 MHz / 64 / 250);
+ * the period is reloaded by hardware, so no tick is lost or stretched by
+ * ISR latency the way a TCNT0 reload in an overflow handler is.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#define EV_TICK 1	/* ev_period ms have passed */
+#define EV_BUTTON 2	/* arg: number of the external interrupt */
+
+#define EV_QUEUE 16	/* power of two */
+
+typedef struct {
+	unsigned char type;
+	unsigned char arg;
+} event_t;
+
+volatile event_t ev_queue[EV_QUEUE];
+volatile unsigned char ev_head = 0;	/* next free slot, written by ISRs */
+volatile unsigned char ev_tail = 0;	/* next event, written by main */
+volatile unsigned char ev_lost = 0;
+
+volatile unsigned long ev_ms = 0;	/* ms since ev_timer_init */
+unsigned int ev_period = 0;
+unsigned int ev_count = 0;
+
+/* only from interrupt handlers */
+void ev_post(unsigned char type, unsigned char arg) {
+	unsigned char h = ev_head;
+
+	if (((h + 1) & (EV_QUEUE - 1)) == ev_tail) {
+		ev_lost++;
+		return;
+	}
+	ev_queue[h].type = type;
+	ev_queue[h].arg = arg;
+	ev_head = (h + 1) & (EV_QUEUE - 1);
+}
+
+SIGNAL(SIG_OUTPUT_COMPARE0) {
+	ev_ms++;
+	if (ev_period && ++ev_count >= ev_period) {
+		ev_count = 0;
+		ev_post(EV_TICK, 0);
+	}
+}
+
+/* post EV_TICK every period ms (0: only count ev_ms) */
+void ev_timer_init(unsigned int period) {
+	ev_period = period;
+	ev_count = 0;
+
+	OCR0 = 249;
+	TCNT0 = 0;
+	TCCR0 = (1 << WGM01) | (1 << CS02);	/* CTC, clk/64 */
+	TIMSK |= (1 << OCIE0);
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+/* takes the next event if there is one; returns 0 if the ring is empty */
+unsigned char ev_get(event_t *e) {
+	unsigned char t = ev_tail;
+
+	if (t == ev_head)
+		return 0;
+	e->type = ev_queue[t].type;
+	e->arg = ev_queue[t].arg;
+	ev_tail = (t + 1) & (EV_QUEUE - 1);
+	return 1;
+}
+
+/*
+ * Sleeps until an event is queued and takes it. The check and the sleep
+ * are done with interrupts off; sei takes effect after the next
+ * instruction, so an event posted in between still wakes us up.
+ */
+void ev_wait(event_t *e) {
+	cli();
+	while (ev_tail == ev_head) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		cli();
+	}
+	sei();
+	ev_get(e);
+}
+
+unsigned long ev_millis(void) {
+	unsigned long ms;
+
+	cli();
+	ms = ev_ms;
+	sei();
+	return ms;
+}
+
+#endif
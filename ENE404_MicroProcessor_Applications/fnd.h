@@ -0,0 +1,75 @@
+#ifndef FND_H
+#define FND_H
+
+/*
+ * 4-digit FND refreshed from the Timer2 compare interrupt.
+ *
+ * fnd_display() only encodes the digits through Font[] into fnd_buf; the
+ * interrupt lights one digit per 1 ms tick (each digit at 250 Hz), so the
+ * main loop never waits on the display and can sleep between events.
+ * Timer2 is not used by the weekly programs (they use Timer0, Timer1 and
+ * the external interrupts).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#define FND_C0 0x01
+#define FND_C1 0x02
+#define FND_C2 0x04
+#define FND_C3 0x08
+
+const char Font[17] = { 0x3F,0x06,0x5B,0x4F,0x66,0x6D,0x7D,0x07,0x7F,0x6F,0x77,0x7C,0x39,0x5E,0x79,0x71,0x00 };
+
+volatile unsigned char fnd_buf[4];	/* segment pattern of each digit */
+volatile unsigned int fnd_ticks = 0;	/* 1 ms ticks */
+unsigned char fnd_pos = 0;
+
+SIGNAL(SIG_OUTPUT_COMPARE2) {
+	PORTG |= 0x0F;			/* blank while the segments change */
+	PORTB = fnd_buf[fnd_pos];
+	PORTG &= ~(FND_C0 << fnd_pos);
+	fnd_pos = (fnd_pos + 1) & 3;
+	fnd_ticks++;
+}
+
+void fnd_init(void) {
+	DDRB = 0xFF;
+	DDRG |= 0x0F;
+	PORTB = 0x00;
+	PORTG |= 0x0F;
+
+	/* CTC, clk/64: 16 MHz / 64 / (249 + 1) = 1 kHz */
+	OCR2 = 249;
+	TCCR2 = (1 << WGM21) | (1 << CS21) | (1 << CS20);
+	TIMSK |= (1 << OCIE2);
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+void fnd_display(unsigned char digit0, unsigned char digit1, unsigned char digit2, unsigned char digit3) {
+	fnd_buf[0] = Font[digit0];
+	fnd_buf[1] = Font[digit1];
+	fnd_buf[2] = Font[digit2];
+	fnd_buf[3] = Font[digit3];
+}
+
+/* sleep until n more ticks have passed (interrupts must be on) */
+void fnd_wait(unsigned int n) {
+	unsigned int start, now;
+
+	cli();
+	start = fnd_ticks;
+	sei();
+	for (;;) {
+		cli();
+		now = fnd_ticks;
+		sei();
+		if (now - start >= n)
+			break;
+		sleep_mode();
+	}
+}
+
+#endif
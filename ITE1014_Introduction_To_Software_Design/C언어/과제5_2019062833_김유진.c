@@ -3,43 +3,120 @@
 #include <string.h>
 #include <malloc.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2
+#endif
+
+#define TILE 32 //ĳÿ  Ÿ    (8 )
+
+//迭    Ҵ  켱 迭̴: arr[i][j] = arr[i * garo + j]
+
 //ƮԼ 
-void print(int ** arr,int sero, int garo) {
+void print(int * arr,int sero, int garo) {
 	for (int i = 0; i < sero; i++) {
 		for (int j = 0; j < garo; j++) {
-			printf("%4d ", arr[i][j]);
+			printf("%4d ", arr[i * garo + j]);
 		}
 		printf("\n");
 	}
 }
-//ȸִ Լ ϱ
-int** rotate(int ** arr) {
-	int i, j,garo,sero;
-	int** returnArr=NULL;
-	
-	//Ű ޾ƿ 迭 ũ ũ⸦ ش
-	sero = _msize(arr)/sizeof(arr[0]);
-	garo = _msize(arr[0]) / sizeof(arr[0][0]);
 
-	//  Ҵ
-	returnArr = (int **)malloc(garo * sizeof(int*));
+//8x8  90 ȸؼ Űִ Լ
+//src 8 Ʒٺ о ġϸ dst 8 ȴ
+void rotate8x8(const int* src, int sstride, int* dst, int dstride) {
+#ifdef HAVE_SSE2
+	__m128i r[8][2], t0, t1, t2, t3;
+	int k, h, v;
 
-	//  Ҵ
-	for (i = 0; i < garo; ++i) {
-		returnArr[i] = (int *)malloc(sero * sizeof(int));
+	for (k = 0; k < 8; k++) {
+		r[k][0] = _mm_loadu_si128((const __m128i*)(src + (7 - k) * sstride));
+		r[k][1] = _mm_loadu_si128((const __m128i*)(src + (7 - k) * sstride + 4));
 	}
-	//޾ƿ¹迭  θ 迭 90 ȸ · ־ش.
-	for (i = 0; i < garo; ++i) {
-		for (j = 0; j < sero; ++j) {
-			returnArr[i][j] = arr[sero -1- j][i];
+	//4x4  װ  ġؼ ڸ ٲ ִ´
+	for (h = 0; h < 2; h++) {
+		for (v = 0; v < 2; v++) {
+			t0 = _mm_unpacklo_epi32(r[4 * v][h], r[4 * v + 1][h]);
+			t1 = _mm_unpacklo_epi32(r[4 * v + 2][h], r[4 * v + 3][h]);
+			t2 = _mm_unpackhi_epi32(r[4 * v][h], r[4 * v + 1][h]);
+			t3 = _mm_unpackhi_epi32(r[4 * v + 2][h], r[4 * v + 3][h]);
+			_mm_storeu_si128((__m128i*)(dst + (4 * h) * dstride + 4 * v), _mm_unpacklo_epi64(t0, t1));
+			_mm_storeu_si128((__m128i*)(dst + (4 * h + 1) * dstride + 4 * v), _mm_unpackhi_epi64(t0, t1));
+			_mm_storeu_si128((__m128i*)(dst + (4 * h + 2) * dstride + 4 * v), _mm_unpacklo_epi64(t2, t3));
+			_mm_storeu_si128((__m128i*)(dst + (4 * h + 3) * dstride + 4 * v), _mm_unpackhi_epi64(t2, t3));
 		}
 	}
-	//  ޸ 
-	for (i = 0; i < sero; ++i) {
-		free(arr[i]);
+#else
+	int q, k;
+	for (q = 0; q < 8; q++) {
+		for (k = 0; k < 8; k++) {
+			dst[q * dstride + k] = src[(7 - k) * sstride + q];
+		}
 	}
+#endif
+}
 
-	// ޸ 
+//sero x garo 迭 src 90 ȸؼ garo x sero 迭 dst ־ִ Լ
+//dst[i][j] = src[sero-1-j][i]  TILE x TILE Ÿ  ؼ д ʰ    ĳ ȿ ְ Ѵ
+//Ÿ  8x8  ű, 8   ʴ ڸ ĭ ű
+void rotateBuf(const int* src, int* dst, int sero, int garo) {
+	int r0, c0, r1, c1, rr, cc, r, c;
+
+	for (r0 = 0; r0 < sero; r0 += TILE) {
+		r1 = r0 + TILE < sero ? r0 + TILE : sero;
+		rr = r0 + ((r1 - r0) & ~7);
+		for (c0 = 0; c0 < garo; c0 += TILE) {
+			c1 = c0 + TILE < garo ? c0 + TILE : garo;
+			cc = c0 + ((c1 - c0) & ~7);
+
+			for (r = r0; r < rr; r += 8) {
+				for (c = c0; c < cc; c += 8) {
+					rotate8x8(src + r * garo + c, garo, dst + c * sero + (sero - 8 - r), sero);
+				}
+			}
+			for (r = r0; r < r1; r++) {
+				for (c = (r < rr ? cc : c0); c < c1; c++) {
+					dst[c * sero + (sero - 1 - r)] = src[r * garo + c];
+				}
+			}
+		}
+	}
+}
+
+//n x n 迭 ڸ 90 ȸִ Լ
+// ĭ ư ڸ ٲٴµ,   1/4   ĭ   ô´
+//  Ÿ      Ÿ ϳ ũ ȿ  ĳø  
+void rotateSquare(int* a, int n) {
+	int i0, j0, i, j, t;
+	int h = n / 2, w = (n + 1) / 2;
+
+	for (i0 = 0; i0 < h; i0 += TILE) {
+		for (j0 = 0; j0 < w; j0 += TILE) {
+			for (i = i0; i < i0 + TILE && i < h; i++) {
+				for (j = j0; j < j0 + TILE && j < w; j++) {
+					t = a[i * n + j];
+					a[i * n + j] = a[(n - 1 - j) * n + i];
+					a[(n - 1 - j) * n + i] = a[(n - 1 - i) * n + (n - 1 - j)];
+					a[(n - 1 - i) * n + (n - 1 - j)] = a[j * n + (n - 1 - i)];
+					a[j * n + (n - 1 - i)] = t;
+				}
+			}
+		}
+	}
+}
+
+//ȸִ Լ ϱ
+//簢̸ ڸ , ƴϸ  迭  ְ ޾ƿ 迭 Ѵ
+int* rotate(int * arr, int sero, int garo) {
+	int* returnArr = NULL;
+
+	if (sero == garo) {
+		rotateSquare(arr, sero);
+		return arr;
+	}
+
+	returnArr = (int *)malloc((size_t)garo * sero * sizeof(int));
+	rotateBuf(arr, returnArr, sero, garo);
 	free(arr);
 
 	//ȸŲ 迭 ش
@@ -48,7 +125,7 @@ int** rotate(int ** arr) {
 
 int main() {
 	int garo, sero,i,j;
-	int** arr = NULL;
+	int* arr = NULL;
 
 	//ڿ ο ũ⸦ Է¹޴´
 	printf("input row size of the matrix : ");
@@ -56,25 +133,13 @@ int main() {
 	printf("input column size of the matrix : ");
 	scanf("%d", &garo);
 
-	//  Ҵ
-	arr = (int **)malloc(sero*sizeof(int *));
+	//   Ҵ
+	arr = (int *)malloc((size_t)sero * garo * sizeof(int));
 
-	//  Ҵ
+	// ־ش
 	for (i = 0; i < sero; ++i) {
-		arr[i] = (int *)malloc(garo * sizeof(int));
-
-		// ־ش
 		for (j = 0; j < garo; ++j) {
-			if (i == 0 && j == 0) {
-				arr[i][j] = 1;
-			}
-			else if(j!=0){
-				arr[i][j] = arr[i][j - 1]+1;
-			}
-			else {
-				arr[i][j] = arr[i-1][garo-1]+1;
-			}
-			
+			arr[i * garo + j] = i * garo + j + 1;
 		}
 	}
 	//0 迭Ʈ
@@ -83,19 +148,21 @@ int main() {
 	
 	//90 ȸ迭Ʈ
 	printf("< degree : 90 >\n");
-	arr = rotate(arr);
+	arr = rotate(arr, sero, garo);
 	print(arr, garo, sero);
 	
 	//180 ȸ 迭 Ʈ
 	printf("< degree : 180 >\n");
-	arr = rotate(arr);
+	arr = rotate(arr, garo, sero);
 	print(arr, sero, garo);
 	
 	//270 ȸ 迭 Ʈ
 	printf("< degree : 270 >\n");
-	arr = rotate(arr);
+	arr = rotate(arr, sero, garo);
 	print(arr, garo, sero);
 
+	free(arr);
+
 	
 	
 	
@@ -3,6 +3,16 @@
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef unsigned long long lottomask; //ȣ n n Ʈ Ÿ Ƽ (1~45 Ʈ )
+
+//帶 ϳ    (xorshift64*)
+typedef struct {
+	unsigned long long s;
+} lottorng;
 
 void printMenu();//޴ Ʈϴ Լ
 void print(int * arr, int size);//迭 Ʈִ Լ
@@ -10,6 +20,14 @@ int * newTicket();//Ƽ
 int* dangchum();//÷    Լ
 int soonwee2(int count, int count2);// ִ Լ
 int soonwee1(int* soonwee, int* dangchum, int** arr, int ticket, int cnt, int bu);// Ƽ ȣ ְ, ÷Ȱ  ָ,  ÷ ִ Լ
+void drawNumbers(int* arr, int n);//1~45  ٸ n ִ̾ Լ
+lottomask ticketMask(int* arr, int n);//ȣ 迭 Ʈũ ٲִ Լ
+int popcount64(lottomask x);// Ʈ  ִ Լ
+void rngSeed(lottorng* r, unsigned long long seed);//  ʱȭ Լ
+unsigned int rngNext(lottorng* r);//32Ʈ  ִ Լ
+lottomask drawMask(lottorng* r, unsigned char* pool, int n);//κ Ǽ- n ̾ ũ ִ Լ
+int rankMask(lottomask ticket, lottomask draw, lottomask bonus);//ũ  ִ Լ
+void simulate(lottomask draw, lottomask bonus, long long n, unsigned long long seed, long long* ranks);//Ƽ n    ִ Լ
 
 
 int main() {
@@ -173,6 +191,21 @@ int main() {
 			}
 		}
 
+		//޴5 
+		else if (menu == 5) {
+			long long n, ranks[6];//  Ƽ ,  ÷ Ƚ (0 ÷)
+
+			printf("How many tickets to simulate? : ");
+			scanf("%lld", &n);
+
+			simulate(ticketMask(dang, 6), 1ULL << dang[6], n, (unsigned long long)time(NULL), ranks);
+			printf("1st : %lld 2nd : %lld 3rd : %lld 4th : %lld 5th : %lld\n", ranks[1], ranks[2], ranks[3], ranks[4], ranks[5]);
+			for (i = 1; i <= 5; i++) {
+				printf("%d : 1 in %.1f\n", i, ranks[i] ? (double)n / ranks[i] : 0.0);// ÷ Ȯ
+			}
+			printf("\n");
+		}
+
 		//޴0 
 		else if (menu == 0) break;
 
@@ -204,7 +237,7 @@ int main() {
 //޴ Ʈϴ Լ
 void printMenu() {
 	printf("------------------Lottery Ticket------------------\n");
-	printf("--------------------------------------------------\n1. Buy tickets\n2. Spent money\n3. Earned money\n4. Buy until I get 4th of higher prize\n0. exit\n");
+	printf("--------------------------------------------------\n1. Buy tickets\n2. Spent money\n3. Earned money\n4. Buy until I get 4th of higher prize\n5. Simulate tickets\n0. exit\n");
 
 }
 
@@ -240,34 +273,11 @@ void print(int * arr, int size) {
 
 //Ƽϻִ̾ Լ
 int * newTicket() {
-	int i, j, temp, count = 0;
 	int *ticketarr = NULL;
 
 	ticketarr = (int*)malloc(6 * sizeof(int));
 
-	// ֱ̾
-	for (i = 0; i < 6; ++i) {
-		while (1) {
-			ticketarr[i] = rand() % 45 + 1;
-			for (j = 0; j < i; ++j) {//ߺ Ȼ 
-				if (ticketarr[i] == ticketarr[j]) count++;
-			}
-			if (count == 0) break;
-			count = 0;
-
-		}
-	}
-
-	//ũ 
-	for (i = 0; i < 5; i++) {
-		for (j = 0; j < 5 - i; j++) {
-			if (ticketarr[j] >= ticketarr[j + 1]) {
-				temp = ticketarr[j];
-				ticketarr[j] = ticketarr[j + 1];
-				ticketarr[j + 1] = temp;
-			}
-		}
-	}
+	drawNumbers(ticketarr, 6);// ֱ̾
 
 	return ticketarr;
 
@@ -287,47 +297,13 @@ int * newTicket() {
 
 //÷ س Լ
 int* dangchum() {
-	int i, bonus, j, temp, count = 0;
 	int *dangchum = NULL;
 
 	dangchum = (int*)malloc(7 * sizeof(int));
 
-	// ֱ̾
-	for (i = 0; i < 6; ++i) {
-		while (1) {
-			dangchum[i] = rand() % 45 + 1;
-			for (j = 0; j < i; ++j) { // ߺ Ȼ 
-				if (dangchum[j] == dangchum[i]) count++;
-			}
-			if (count == 0) break;
-			count = 0;
-
-		}
-	}
-
-	//ʽ ȣϳ ̰  ĭ 
-	while (1) {
-		count = 0;
-		bonus = rand() % 45 + 1;
-		for (j = 0; j < 6; ++j) { // ߺ Ȼ 
-			if (dangchum[j] == bonus) count++;
-		}
-		if (count == 0) break;
-	}
-	dangchum[6] = bonus;
-
-
-	//ũ -  ʽȣ 
-	for (i = 0; i < 5; ++i) {
-		for (j = 0; j < 5 - i; ++j) {
-			if (dangchum[j] > dangchum[j + 1]) {
-				temp = dangchum[j];
-				dangchum[j] = dangchum[j + 1];
-				dangchum[j + 1] = temp;
-			}
-
-		}
-	}
+	//ϰ ̾Ƽ   ÷ȣ,  ĭ ʽȣ 
+	//  ũ ĵǰ ʽȣ д
+	drawNumbers(dangchum, 7);
 
 	return dangchum;
 }
@@ -371,9 +347,10 @@ int soonwee2(int count, int count2) {
 
 // Ƽ ȣ ְ, ÷   ָ,  ÷ ִ Լ
 int soonwee1(int* soonwee, int* dangchum, int** arr, int ticket, int cnt, int bu) {
-	int i, j, k;
+	int i, j;
 	int count = 0, count2 = 0;//Ϲݹȣ  ġϴ  , ʽȣ ġϴ  
 	int yn = 0; //޴4 ÷ɶ ޱ ʿ  
+	lottomask draw = ticketMask(dangchum, 6), bonus = 1ULL << dangchum[6], t;//÷ȣ, ʽȣ, Ƽ ũ
 
 
 
@@ -384,14 +361,10 @@ int soonwee1(int* soonwee, int* dangchum, int** arr, int ticket, int cnt, int bu
 			printf("ticket [%d]\n", i + 1);//° Ƽ Ʈ
 			for (j = 0; j < 6; ++j) {
 				printf("%d ", arr[i][j]); //  ȣ 
-				for (k = 0; k < 6; k++) {
-					if (arr[i][j] == dangchum[k]) {
-						count++;//ʽȣ ƴ Ϲݹȣ  ġϴ
-					}
-				}
-				if (arr[i][j] == dangchum[6]) count2++;//ʽ ȣ ġϴ
-
 			}
+			t = ticketMask(arr[i], 6);
+			count = popcount64(t & draw);//ʽȣ ƴ Ϲݹȣ  ġϴ
+			count2 = (t & bonus) != 0;//ʽ ȣ ġϴ
 			if (soonwee2(count, count2) != 0) {
 				if (soonwee2(count, count2) ==1) yn=1;// ޴4 ÷ɶ ޱ ʿ  
 				if (soonwee2(count, count2) == 2) yn = 2;
@@ -417,15 +390,10 @@ int soonwee1(int* soonwee, int* dangchum, int** arr, int ticket, int cnt, int bu
 			printf("ticket [%d]\n", i + 1); //° Ƽ 
 			for (j = 0; j < 6; ++j) {
 				printf("%d ", arr[bu - ticket + i][j]); //  ȣ ش
-
-				for (k = 0; k < 6; k++) {
-					if (arr[bu - ticket + i][j] == dangchum[k]) {
-						count++;// ʽȣ ƴ Ϲ ȣ  ġϴ
-					}
-				}
-				if (arr[bu - ticket + i][j] == dangchum[6]) count2++;//ʽ ȣ ġϴ
-
 			}
+			t = ticketMask(arr[bu - ticket + i], 6);
+			count = popcount64(t & draw);// ʽȣ ƴ Ϲ ȣ  ġϴ
+			count2 = (t & bonus) != 0;//ʽ ȣ ġϴ
 			if (soonwee2(count, count2) != 0) {
 				printf(" %d!!!!", soonwee2(count, count2));// ÷Ǹ ˷ش
 				soonwee[soonwee2(count, count2) - 1]++;// ÷  ֱ
@@ -439,3 +407,176 @@ int soonwee1(int* soonwee, int* dangchum, int** arr, int ticket, int cnt, int bu
 
 	return yn;//޴4 ÷ɶ ޱ ʿ  
 }
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+
+
+
+//1~45  ٸ n ִ̾ Լ
+//κ Ǽ-: տ ĭ  ȣ  ϳ ٲֹǷ ߺ˻簡 ʿ
+//ó  Ʈũ ļ ũ ־ش (n 7̸  ĭ   ״)
+void drawNumbers(int* arr, int n) {
+	int pool[45];
+	int i, j, temp, k = 0, sorted = n < 6 ? n : 6;
+	lottomask m = 0;
+
+	for (i = 0; i < 45; i++) pool[i] = i + 1;
+
+	for (i = 0; i < n; i++) {
+		j = i + rand() % (45 - i);
+		temp = pool[i];
+		pool[i] = pool[j];
+		pool[j] = temp;
+	}
+
+	for (i = 0; i < sorted; i++) m |= 1ULL << pool[i];
+	for (i = 1; i <= 45; i++) {
+		if (m >> i & 1) arr[k++] = i;
+	}
+	for (i = sorted; i < n; i++) arr[i] = pool[i];
+}
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+
+
+
+//ȣ 迭 Ʈũ ٲִ Լ
+lottomask ticketMask(int* arr, int n) {
+	lottomask m = 0;
+	int i;
+	for (i = 0; i < n; i++) m |= 1ULL << arr[i];
+	return m;
+}
+
+
+
+// Ʈ  ִ Լ
+int popcount64(lottomask x) {
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+
+
+
+//  ʱȭ Լ (splitmix64  帶 ٸ ¸ )
+void rngSeed(lottorng* r, unsigned long long seed) {
+	unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	r->s = z ? z : 1; // ° 0̸  0 ´
+}
+
+
+
+//32Ʈ  ִ Լ (xorshift64*)
+unsigned int rngNext(lottorng* r) {
+	r->s ^= r->s >> 12;
+	r->s ^= r->s << 25;
+	r->s ^= r->s >> 27;
+	return (unsigned int)((r->s * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+
+
+//pool  1~45  κ Ǽ- n ̾ ũ ִ Լ
+//pool ̰  ̹Ƿ ٽ ä ʰ  ƼϿ ״ 
+//   0~(45-i-1)   
+lottomask drawMask(lottorng* r, unsigned char* pool, int n) {
+	lottomask m = 0;
+	unsigned char temp;
+	int i, j;
+
+	for (i = 0; i < n; i++) {
+		j = i + (int)(((unsigned long long)rngNext(r) * (unsigned)(45 - i)) >> 32);
+		temp = pool[i];
+		pool[i] = pool[j];
+		pool[j] = temp;
+		m |= 1ULL << pool[i];
+	}
+	return m;
+}
+
+
+
+//ũ  ִ Լ (0 ÷) - soonwee2  Ģ
+int rankMask(lottomask ticket, lottomask draw, lottomask bonus) {
+	static const int byMatch[7] = { 0, 0, 0, 5, 4, 3, 1 };//ġ  
+	int m = popcount64(ticket & draw);
+
+	if (m == 5 && (ticket & bonus)) return 2;
+	return byMatch[m];
+}
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+
+
+
+//Ƽ n  ؼ  ÷ Ƚ ranks[0~5] ־ִ Լ (ranks[0] ÷)
+//OpenMP ϸ 帶   ī͸  ΰ  ѹ Ѵ
+void simulate(lottomask draw, lottomask bonus, long long n, unsigned long long seed, long long* ranks) {
+	int k;
+
+	for (k = 0; k < 6; k++) ranks[k] = 0;
+
+#pragma omp parallel
+	{
+		long long local[6] = { 0, 0, 0, 0, 0, 0 };//   Ƚ
+		unsigned char pool[45];
+		lottorng r;
+		long long t;
+		int i, id = 0;
+
+#ifdef _OPENMP
+		id = omp_get_thread_num();
+#endif
+		rngSeed(&r, seed + (unsigned long long)id);
+		for (i = 0; i < 45; i++) pool[i] = (unsigned char)(i + 1);
+
+#pragma omp for schedule(static)
+		for (t = 0; t < n; t++) {
+			local[rankMask(drawMask(&r, pool, 6), draw, bonus)]++;
+		}
+
+#pragma omp critical
+		{
+			for (i = 0; i < 6; i++) ranks[i] += local[i];
+		}
+	}
+}
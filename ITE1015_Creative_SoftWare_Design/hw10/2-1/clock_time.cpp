@@ -69,6 +69,49 @@ increment()
 	second_ = seconds;
 }
 
+void ClockTime::
+advance(long long ticks)
+// The purpose of this method is to advance the clock time by many ticks at
+// once.  increment() subtracts a day only when the sum exceeds it, so after
+// the first tick the time stays in [1, day] and each further tick moves it
+// by secondsPerTick_ modulo a day.  Unusual states are stepped one by one.
+{
+	const int DAY = HOURS_PER_DAY * MINUTES_PER_HOUR * SECONDS_PER_MINUTE;
+	int seconds = totalSeconds();
+
+	if (ticks <= 0)
+		return;
+	if (secondsPerTick_ == 0 && seconds <= DAY)
+		return;
+	if (secondsPerTick_ < 0 || secondsPerTick_ >= DAY || seconds > DAY) {
+		for (; ticks > 0; ticks--)
+			increment();
+		return;
+	}
+
+	deltaTime_ += (unsigned int)(ticks * secondsPerTick_);
+
+	seconds += secondsPerTick_;
+	if (seconds > DAY)
+		seconds -= DAY;
+	seconds = (int)((seconds - 1 + (ticks - 1) % DAY * secondsPerTick_) % DAY) + 1;
+
+	setSeconds(seconds, deltaTime_);
+}
+
+void ClockTime::
+setSeconds(int seconds, unsigned int deltaTime)
+{
+	hour_ = seconds / (MINUTES_PER_HOUR * SECONDS_PER_MINUTE);
+	seconds -= hour_ * (MINUTES_PER_HOUR * SECONDS_PER_MINUTE);
+
+	minute_ = seconds / SECONDS_PER_MINUTE;
+	seconds -= minute_ * SECONDS_PER_MINUTE;
+
+	second_ = seconds;
+	deltaTime_ = deltaTime;
+}
+
 void ClockTime::
 display() const
 // The purpose of this method is to display the values stored in
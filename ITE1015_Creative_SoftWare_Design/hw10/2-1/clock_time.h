@@ -53,6 +53,19 @@ public:
 
 	void increment();
 
+	// Same result as calling increment() ticks times, in O(1).
+	void advance(long long ticks);
+
+	int totalSeconds() const
+	{
+		return hour_ * MINUTES_PER_HOUR * SECONDS_PER_MINUTE +
+			minute_ * SECONDS_PER_MINUTE + second_;
+	}
+
+	// Sets the time from seconds past midnight, keeping secondsPerTick and
+	// the elapsed time (used to load results computed elsewhere).
+	void setSeconds(int seconds, unsigned int deltaTime);
+
 	void display() const;
 
 private:
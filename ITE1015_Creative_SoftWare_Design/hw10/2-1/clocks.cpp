@@ -10,6 +10,7 @@ Clock::Clock()
 Clock::Clock(int hour, int minute, int second, double dirftPerSecond)
 {
 	_totalDrift = 0;
+	_driftComp = 0;
 	_driftPerSecond = dirftPerSecond;
 	_clockTime.setTime(hour, minute, second, 1);
 }
@@ -26,7 +27,24 @@ void Clock::reset()
 void Clock::tick()
 {
 	_clockTime.increment();
-	_totalDrift += _driftPerSecond;
+	addDrift(_driftPerSecond);
+}
+
+void Clock::advance(long long seconds)
+{
+	if (seconds <= 0) return;
+	_clockTime.advance(seconds);
+	addDrift(seconds * _driftPerSecond);
+}
+
+// Kahan summation: _driftComp carries the low-order bits lost by the last
+// addition, so a long run of small drifts does not accumulate rounding error.
+void Clock::addDrift(double drift)
+{
+	double y = drift - _driftComp;
+	double t = _totalDrift + y;
+	_driftComp = (t - _totalDrift) - y;
+	_totalDrift = t;
 }
 
 NaturalClock::NaturalClock()
@@ -150,3 +168,55 @@ void AtomicClock::printMy()
 {
 	cout << "AtomicClock ";
 }
+
+
+size_t ClockBank::add(const Clock& clock)
+{
+	_seconds.push_back(clock._clockTime.totalSeconds());
+	_step.push_back(clock._clockTime.secondsPerTick() ? 1 : 0);
+	_deltaTime.push_back(clock._clockTime.deltaTime());
+	_driftPerSecond.push_back(clock._driftPerSecond);
+	_totalDrift.push_back(clock._totalDrift);
+	_driftComp.push_back(clock._driftComp);
+	return _seconds.size() - 1;
+}
+
+// A moving clock at t (0 <= t <= day) reads (t' + seconds - 1) % day + 1
+// afterwards, where t' is t with 24:00:00 taken as 0 (see ClockTime::advance).
+void ClockBank::advance(long long seconds)
+{
+	const int DAY = HOURS_PER_DAY * MINUTES_PER_HOUR * SECONDS_PER_MINUTE;
+	if (seconds <= 0) return;
+	int r = (int)((seconds - 1) % DAY);
+	unsigned int delta = (unsigned int)seconds;
+	double n = (double)seconds;
+	size_t count = _seconds.size();
+
+	int* t = _seconds.data();
+	const int* step = _step.data();
+	unsigned int* dt = _deltaTime.data();
+	for (size_t i = 0; i < count; i++) {
+		int u = t[i] >= DAY ? t[i] - DAY : t[i];
+		int x = u + r;
+		x = x >= DAY ? x - DAY : x;
+		t[i] = step[i] ? x + 1 : t[i];
+		dt[i] += delta * step[i];
+	}
+
+	const double* d = _driftPerSecond.data();
+	double* sum = _totalDrift.data();
+	double* comp = _driftComp.data();
+	for (size_t i = 0; i < count; i++) {
+		double y = n * d[i] - comp[i];
+		double s = sum[i] + y;
+		comp[i] = (s - sum[i]) - y;
+		sum[i] = s;
+	}
+}
+
+void ClockBank::store(size_t i, Clock& clock) const
+{
+	clock._clockTime.setSeconds(_seconds[i], _deltaTime[i]);
+	clock._totalDrift = _totalDrift[i];
+	clock._driftComp = _driftComp[i];
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <stddef.h>
+#include <vector>
 #include "clock_time.h"
 
 class Clock {
@@ -6,12 +8,18 @@ protected :
 	ClockTime _clockTime;
 	double _driftPerSecond;
 	double _totalDrift;
+	double _driftComp;	// Kahan compensation for _totalDrift
+
+	void addDrift(double drift);
+	friend class ClockBank;
 public:
 	Clock();
 	Clock(int hour, int minute, int second, double dirftPerSecond);
 	virtual ~Clock();
 	void reset();
 	void tick();
+	// the same as seconds calls to tick(), in O(1)
+	void advance(long long seconds);
 	virtual void displayTime() = 0;
 	virtual void printMy()=0;
 
@@ -91,4 +99,28 @@ public:
 	~AtomicClock();
 	void printMy();
 
-};
\ No newline at end of file
+};
+
+// Structure-of-arrays copy of many clocks' state. advance() runs a few plain
+// loops over the arrays, with no virtual calls, which the compiler can
+// vectorize; store() writes a clock's state back so it can be displayed.
+// Every Clock ticks one second at a time (a default-constructed one does not
+// move), and a clock added here must show at most 24:00:00.
+class ClockBank {
+public:
+	size_t add(const Clock& clock);	// returns the clock's index
+	void advance(long long seconds);
+	void tick() { advance(1); }
+	size_t size() const { return _seconds.size(); }
+	int totalSeconds(size_t i) const { return _seconds[i]; }
+	double totalDrift(size_t i) const { return _totalDrift[i]; }
+	void store(size_t i, Clock& clock) const;
+
+private:
+	std::vector<int> _seconds;	// past midnight
+	std::vector<int> _step;	// seconds per tick: 1, or 0 for a stopped clock
+	std::vector<unsigned int> _deltaTime;
+	std::vector<double> _driftPerSecond;
+	std::vector<double> _totalDrift;
+	std::vector<double> _driftComp;
+};
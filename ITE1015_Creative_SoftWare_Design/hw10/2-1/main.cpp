@@ -28,10 +28,7 @@ int main() {
 	cout << endl << "Running the Clocks . . ." << endl << endl;
 	for (int i = 0; i < arr.size(); i++)
 	{
-		for (int j = 0; j < sec; j++)
-		{
-			arr[i]->tick();
-		}
+		arr[i]->advance(sec);
 	}
 
 
@@ -1,5 +1,7 @@
 #include <string>
 
+#include <cstring>
+
 #include <iostream>
 
 #include "my_string.h"
@@ -20,25 +22,77 @@ MyString& MyString::operator=(const MyString& string) {
 
 
 
-MyString MyString::operator*(const int b) {
+MyString& MyString::operator=(const MyStringBuilder& b) {
+
+	str = b.build();
+
+	return *this;
+
+}
+
+
+
+// One allocation for the whole result, then the filled prefix is doubled
+
+// with memcpy, so s * n copies O(|s| * n) bytes in O(log n) steps.
+
+// As before, n < 1 leaves the string as it is.
+
+MyString MyString::operator*(const int b) const {
+
+	MyString result;
 
-	string a = str;
+	size_t len = str.size();
 
-	for (int i = 1; i < b; i++) {
+	size_t total = len * (b > 1 ? b : 1);
 
-		str = str + a;
+	result.str.resize(total);
+
+	if (total == 0) return result;
+
+	char* p = &result.str[0];
+
+	memcpy(p, str.data(), len);
+
+	for (size_t done = len; done < total; ) {
+
+		size_t n = done < total - done ? done : total - done;
+
+		memcpy(p + done, p, n);
+
+		done += n;
 
 	}
 
-	return *this;
+	return result;
 
 }
 
 
 
-MyString MyString::operator+(const MyString& b) {
+MyStringBuilder MyString::operator+(const MyString& b) const {
+
+	return MyStringBuilder(str, b.str);
+
+}
+
 
-	str = str + b.str;
+
+MyStringBuilder::MyStringBuilder(const std::string& a, const std::string& b) : count(2) {
+
+	pieces[0] = &a;
+
+	pieces[1] = &b;
+
+}
+
+
+
+MyStringBuilder& MyStringBuilder::operator+(const MyString& b) {
+
+	if (count < INLINE_PIECES) pieces[count++] = &b.str;
+
+	else more.push_back(&b.str);
 
 	return *this;
 
@@ -46,6 +100,28 @@ MyString MyString::operator+(const MyString& b) {
 
 
 
+std::string MyStringBuilder::build() const {
+
+	size_t total = 0;
+
+	for (int i = 0; i < count; i++) total += pieces[i]->size();
+
+	for (size_t i = 0; i < more.size(); i++) total += more[i]->size();
+
+	std::string out;
+
+	out.reserve(total);
+
+	for (int i = 0; i < count; i++) out.append(*pieces[i]);
+
+	for (size_t i = 0; i < more.size(); i++) out.append(*more[i]);
+
+	return out;
+
+}
+
+
+
 ostream& operator<<(ostream& out, MyString& my_string) {
 
 	out << my_string.str << endl;
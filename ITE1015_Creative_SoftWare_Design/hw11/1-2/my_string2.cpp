@@ -2,6 +2,10 @@
 
 
 
+#include <cstring>
+
+
+
 #include <iostream>
 
 
@@ -22,19 +26,59 @@ using namespace std;
 
 
 
+// Same result as appending str to itself b - 1 times, but the final length is
+
+
+
+// allocated once and the filled prefix is doubled with memcpy (O(|str| * b)).
+
+
+
 MyString2 MyString2::operator*(const int b) {
 
 
 
-	string a = str;
+	size_t len = str.size();
+
+
+
+	size_t total = len * (b > 1 ? b : 1);
+
+
+
+	string out(total, '\0');
+
+
+
+	if (total > 0) {
+
+
+
+		char* p = &out[0];
+
 
 
+		memcpy(p, str.data(), len);
 
-	for (int i = 1; i < b; i++) {
 
 
+		for (size_t done = len; done < total; ) {
 
-		str = str + a;
+
+
+			size_t n = done < total - done ? done : total - done;
+
+
+
+			memcpy(p + done, p, n);
+
+
+
+			done += n;
+
+
+
+		}
 
 
 
@@ -42,6 +86,10 @@ MyString2 MyString2::operator*(const int b) {
 
 
 
+	str.swap(out);
+
+
+
 	return *this;
 
 
@@ -58,7 +106,11 @@ MyString2 MyString2::operator+(const MyString2& b) {
 
 
 
-	str = str + b.str;
+	// append in place instead of building str + b.str in a new string
+
+
+
+	str.append(b.str);
 
 
 
@@ -90,6 +142,10 @@ ostream& operator<<(ostream& out, MyString2& my_string) {
 
 
 
+
+
+
+
 istream& operator>>(istream& in, MyString2& my_string) {
 
 
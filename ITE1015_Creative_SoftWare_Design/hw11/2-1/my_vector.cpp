@@ -1,7 +1,7 @@
 #include "my_vector.h"
 #include <iostream>
 using namespace std;
-MyVector::MyVector()
+MyVector::MyVector() : length(0), a(nullptr)
 {
 	
 }
@@ -17,63 +17,58 @@ MyVector::MyVector(int length)
 	}
 }
 
-MyVector::~MyVector()
-{	
-	//cout << "Ҹ ȣ" << endl;
-	delete[] a;
-}
-
-MyVector & MyVector::operator=(const MyVector & b)
+MyVector::MyVector(const MyVector & b) : length(b.length), a(new double[b.length])
 {
-	this->length = b.length;
-	
-	this->a = new double[length];
-	
 	for (int i = 0; i < length; i++)
 	{
 		this->a[i] = b.a[i];
 	}
-	
-	return *this;
 }
 
-MyVector MyVector::operator+(const MyVector & b)
+//۸ ״ Ѱܹ޴´ (b  Ͱ ȴ)
+MyVector::MyVector(MyVector && b) noexcept : length(b.length), a(b.a)
 {
-	for (int i = 0; i < length; i++)
-	{
-		this->a[i] += b.a[i];
-	}
-	return *this;
+	b.length = 0;
+	b.a = nullptr;
 }
 
-MyVector MyVector::operator-(const MyVector & b)
-{
-	for (int i = 0; i < length; i++)
-	{
-		this->a[i] -= b.a[i];
-	}
-	return *this;
+MyVector::~MyVector()
+{	
+	//cout << "Ҹ ȣ" << endl;
+	delete[] a;
 }
 
-MyVector MyVector::operator+(const int b)
+MyVector & MyVector::operator=(const MyVector & b)
 {
+	if (this == &b) return *this;
+	//̰  ִ ۿ ϰ, ٸ   ҴѴ ( ۴ )
+	if (this->length != b.length) {
+		delete[] this->a;
+		this->length = b.length;
+		this->a = new double[length];
+	}
+	
 	for (int i = 0; i < length; i++)
 	{
-		this->a[i] += b;
+		this->a[i] = b.a[i];
 	}
+	
 	return *this;
 }
 
-MyVector MyVector::operator-(const int b)
+MyVector & MyVector::operator=(MyVector && b) noexcept
 {
-	for (int i = 0; i < length; i++)
-	{
-		this->a[i] -= b;
+	if (this != &b) {
+		delete[] this->a;
+		this->length = b.length;
+		this->a = b.a;
+		b.length = 0;
+		b.a = nullptr;
 	}
 	return *this;
 }
 
-std::ostream & operator<<(std::ostream & out, MyVector & b)
+std::ostream & operator<<(std::ostream & out, const MyVector & b)
 {
 
 	for (int i = 0; i < b.length; i++)
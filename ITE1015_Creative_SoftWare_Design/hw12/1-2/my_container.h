@@ -1,32 +1,126 @@
 #include <iostream>
 #pragma once
+#include <charconv>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 using namespace std;
+
+// Storage is raw memory: only the first n_elements slots hold constructed
+// objects, the rest up to capacity_ are uninitialized. push_back grows the
+// capacity geometrically and moves the elements over with placement new.
+// Arithmetic element types are allocated on a cache-line boundary.
+//
+// For arithmetic T the stream operators skip the formatted-I/O machinery:
+// numbers are parsed with from_chars and printed with to_chars into a
+// buffer that is written in blocks. readBinary/writeBinary move the raw
+// bytes of trivially copyable T in one call.
 template <class T>
 class MyContainer
 {
 public:
+	static const size_t ALIGN = is_arithmetic<T>::value ? 64 : alignof(T);
+
+	MyContainer() {}
 	MyContainer(int size) {
-		n_elements = size;
-		obj_arr = new T[n_elements];
-		//for (int i = 0; i < n_elements; i++)
-		//{
-			//obj_arr[i] = NULL;
-		//}
+		resize(size);
 	}
 		// Implement here
 	~MyContainer() {
-		delete[] obj_arr;
+		clear();
+		deallocate(obj_arr);
+	}
+	MyContainer(const MyContainer& b) {
+		reserve(b.n_elements);
+		for (int i = 0; i < b.n_elements; i++)
+			push_back(b.obj_arr[i]);
+	}
+	MyContainer(MyContainer&& b) noexcept {
+		swap(b);
+	}
+	MyContainer& operator=(MyContainer b) {
+		swap(b);
+		return *this;
+	}
+	void swap(MyContainer& b) noexcept {
+		std::swap(obj_arr, b.obj_arr);
+		std::swap(n_elements, b.n_elements);
+		std::swap(capacity_, b.capacity_);
 	}
 		// Implement here
 	void clear() {
-
+		for (int i = 0; i < n_elements; i++)
+			obj_arr[i].~T();
+		n_elements = 0;
 	}
 		// Implement here
 	int size() {
 		return n_elements;
 	}
-		// Implement here
+	int capacity() const { return capacity_; }
+	T& operator[](int i) { return obj_arr[i]; }
+	const T& operator[](int i) const { return obj_arr[i]; }
+	T* data() { return obj_arr; }
+	T* begin() { return obj_arr; }
+	T* end() { return obj_arr + n_elements; }
+
+	void reserve(int n) {
+		if (n <= capacity_) return;
+		T* arr = allocate(n);
+		for (int i = 0; i < n_elements; i++) {
+			new (&arr[i]) T(move_if_noexcept(obj_arr[i]));
+			obj_arr[i].~T();
+		}
+		deallocate(obj_arr);
+		obj_arr = arr;
+		capacity_ = n;
+	}
+	void push_back(const T& val) {
+		if (n_elements == capacity_) {
+			T copy(val);	// val may live in the old storage
+			grow();
+			new (&obj_arr[n_elements]) T(std::move(copy));
+		}
+		else new (&obj_arr[n_elements]) T(val);
+		n_elements++;
+	}
+	void push_back(T&& val) {
+		if (n_elements == capacity_) {
+			T tmp(std::move(val));
+			grow();
+			new (&obj_arr[n_elements]) T(std::move(tmp));
+		}
+		else new (&obj_arr[n_elements]) T(std::move(val));
+		n_elements++;
+	}
+	void pop_back() {
+		obj_arr[--n_elements].~T();
+	}
+	// new elements are value-initialized (0 for numbers)
+	void resize(int n) {
+		reserve(n);
+		for (; n_elements < n; n_elements++)
+			new (&obj_arr[n_elements]) T();
+		while (n_elements > n)
+			pop_back();
+	}
+
+	// Reads count elements' bytes straight into the container (appending).
+	// Returns false, keeping only what was read completely, on a short read.
+	bool readBinary(std::istream& in, int count) {
+		static_assert(is_trivially_copyable<T>::value, "readBinary needs trivially copyable T");
+		reserve(n_elements + count);
+		in.read((char*)(obj_arr + n_elements), (streamsize)count * sizeof(T));
+		n_elements += (int)(in.gcount() / sizeof(T));
+		return in.gcount() == (streamsize)count * (streamsize)sizeof(T);
+	}
+	bool writeBinary(std::ostream& out) const {
+		static_assert(is_trivially_copyable<T>::value, "writeBinary needs trivially copyable T");
+		out.write((const char*)obj_arr, (streamsize)n_elements * sizeof(T));
+		return (bool)out;
+	}
+
 	template <class U>
 	friend std::istream& operator>> (std::istream &in, MyContainer<U> &b);
 	template <class U>
@@ -34,28 +128,111 @@ public:
 
 protected:
 	T * obj_arr = NULL;
-	int n_elements;
+	int n_elements = 0;
+	int capacity_ = 0;
+
+	static T* allocate(int n) {
+		return (T*)::operator new((size_t)n * sizeof(T), align_val_t(ALIGN));
+	}
+	static void deallocate(T* p) {
+		if (p) ::operator delete(p, align_val_t(ALIGN));
+	}
+	void grow() {
+		reserve(capacity_ < 8 ? 8 : capacity_ * 2);
+	}
 };
+
+inline bool fastSpace(int c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Parses one whitespace-separated number from the stream buffer directly.
+template <class T>
+bool fastRead(std::istream& in, T& v)
+{
+	streambuf* sb = in.rdbuf();
+	int c = sb->sgetc();
+	while (c != char_traits<char>::eof() && fastSpace(c)) c = sb->snextc();
+	char buf[128];
+	int len = 0;
+	while (c != char_traits<char>::eof() && !fastSpace(c) && len < (int)sizeof(buf)) {
+		buf[len++] = (char)c;
+		c = sb->snextc();
+	}
+	if (c == char_traits<char>::eof()) in.setstate(ios::eofbit);
+	const char* p = buf;
+	if (len > 1 && *p == '+') p++;	// from_chars does not take '+'
+	from_chars_result r = from_chars(p, buf + len, v);
+	if (len == 0 || r.ec != errc() || r.ptr != buf + len) {
+		in.setstate(ios::failbit);
+		return false;
+	}
+	return true;
+}
+
 template<class T>
 istream& operator>> (std::istream &in, MyContainer<T> &b)
 {
+	if constexpr (is_arithmetic<T>::value && !is_same<T, char>::value && !is_same<T, bool>::value) {
+		if ((in.flags() & ios::basefield) == ios::dec) {
+			istream::sentry ok(in);	// skips leading whitespace, checks the state
+			for (int i = 0; ok && i < b.size(); i++)
+			{
+				if (!fastRead(in, b.obj_arr[i])) break;
+			}
+			return in;
+		}
+	}
 	for (int i = 0; i < b.size(); i++)
 	{
 		in >> b.obj_arr[i];
 	}
-	
+
 	return in;
-	
-	
+
+
 }
+
+// Formats like operator<< with the stream's current precision.
+template <class T>
+char* fastFormat(char* p, char* end, T v, int precision)
+{
+	if constexpr (is_floating_point<T>::value)
+		return to_chars(p, end, v, chars_format::general, precision ? precision : 1).ptr;
+	else
+		return to_chars(p, end, v).ptr;
+}
+
 template<class T>
 ostream& operator<< (std::ostream &out, MyContainer<T> &b)
 {
+	const ios::fmtflags special = ios::floatfield | ios::showpos | ios::showpoint
+		| ios::uppercase | ios::showbase | ios::boolalpha;
+	if constexpr (is_arithmetic<T>::value && !is_same<T, char>::value && !is_same<T, bool>::value) {
+		if (!(out.flags() & special) && (out.flags() & ios::basefield) == ios::dec
+			&& out.width() == 0) {
+			char buf[8192];
+			char* p = buf;
+			for (int i = 0; i < b.n_elements; i++)
+			{
+				if (p + 64 > buf + sizeof(buf)) {
+					out.write(buf, p - buf);
+					p = buf;
+				}
+				p = fastFormat(p, buf + sizeof(buf), b.obj_arr[i], (int)out.precision());
+				*p++ = ' ';
+			}
+			out.write(buf, p - buf);
+			out << endl;
+			return out;
+		}
+	}
 	for (int i = 0; i < b.n_elements; i++)
 	{
 		out << b.obj_arr[i] << " ";
 	}
-	
+
 	out << endl;
 	return out;
-}
\ No newline at end of file
+}
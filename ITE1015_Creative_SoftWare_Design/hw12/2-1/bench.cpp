@@ -0,0 +1,116 @@
+// Per-operation times of List, UnrolledList and MyContainer (../1-2).
+//
+// For each container: push_back n ints, sum them through the iterators,
+// insert_at / remove_at m times in the middle (the lists only) and pop
+// everything from the front (the lists only). Each step is timed r times
+// and the median ns per element is printed as "BENCH <name> <ns> ns",
+// the lines bench/run.sh collects.
+//
+// build : g++ -O2 -std=c++17 -o bench bench.cpp
+// usage : ./bench [n] [m] [r]      (default 1000000 100 7)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "list.h"
+#include "unrolled_list.h"
+#include "../1-2/my_container.h"
+
+static int n = 1000000, m = 100, rounds = 7;
+static volatile long long sink;   // keeps the sums from being optimized away
+
+static double now_ns()
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, std::vector<double>& ns)
+{
+	std::sort(ns.begin(), ns.end());
+	printf("BENCH %s %.2f ns\n", name, ns[ns.size() / 2]);
+	fflush(stdout);
+}
+
+// L is List<int> or UnrolledList<int>, which share the interface
+template <class L>
+void bench_list(const char* prefix)
+{
+	std::vector<double> push, iter, insert, pop;
+	char name[64];
+
+	for (int r = 0; r < rounds; r++) {
+		L li;
+		double t = now_ns();
+		for (int i = 0; i < n; i++)
+			li.push_back(i);
+		push.push_back((now_ns() - t) / n);
+
+		t = now_ns();
+		long long sum = 0;
+		for (typename L::iterator it = li.begin(); it != li.end(); ++it)
+			sum += *it;
+		sink = sum;
+		iter.push_back((now_ns() - t) / n);
+
+		t = now_ns();
+		for (int i = 0; i < m; i++) {
+			li.insert_at(li.length() / 2, i);
+			li.remove_at(li.length() / 2);
+		}
+		insert.push_back((now_ns() - t) / (2 * m));
+
+		t = now_ns();
+		while (!li.empty())
+			li.pop_front();
+		pop.push_back((now_ns() - t) / n);
+	}
+
+	snprintf(name, sizeof(name), "%s_push_back", prefix);
+	report(name, push);
+	snprintf(name, sizeof(name), "%s_iterate", prefix);
+	report(name, iter);
+	snprintf(name, sizeof(name), "%s_insert_mid", prefix);
+	report(name, insert);
+	snprintf(name, sizeof(name), "%s_pop_front", prefix);
+	report(name, pop);
+}
+
+void bench_container()
+{
+	std::vector<double> push, iter;
+
+	for (int r = 0; r < rounds; r++) {
+		MyContainer<int> c;
+		double t = now_ns();
+		for (int i = 0; i < n; i++)
+			c.push_back(i);
+		push.push_back((now_ns() - t) / n);
+
+		t = now_ns();
+		long long sum = 0;
+		for (int* p = c.begin(); p != c.end(); ++p)
+			sum += *p;
+		sink = sum;
+		iter.push_back((now_ns() - t) / n);
+	}
+	report("mycontainer_push_back", push);
+	report("mycontainer_iterate", iter);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) n = atoi(argv[1]);
+	if (argc > 2) m = atoi(argv[2]);
+	if (argc > 3) rounds = atoi(argv[3]);
+	if (n < 1 || m < 0 || rounds < 1) {
+		fprintf(stderr, "usage : %s [n] [m] [rounds]\n", argv[0]);
+		return 1;
+	}
+
+	bench_list<List<int> >("list");
+	bench_list<UnrolledList<int> >("unrolled_list");
+	bench_container();
+	return 0;
+}
@@ -2,6 +2,7 @@
 
 
 #include <iostream>
+#include <utility>
 using namespace std;
 
 template <class T>
@@ -10,156 +11,223 @@ class Node
 public:
 	T data;
 	Node<T>* next;
+	Node<T>* prev;
 };
 
+template <class T> class List;
+
+// Bidirectional iterator over a List. V is T or const T.
+// end() is a NULL node; --end() steps back to the tail.
+template <class T, class V>
+class ListIterator {
+public:
+	ListIterator() : node(NULL), list(NULL) {}
+	ListIterator(Node<T>* node, const List<T>* list) : node(node), list(list) {}
+	// iterator -> const_iterator
+	operator ListIterator<T, const T>() const { return ListIterator<T, const T>(node, list); }
+
+	V& operator*() const { return node->data; }
+	V* operator->() const { return &node->data; }
+	ListIterator& operator++() { node = node->next; return *this; }
+	ListIterator operator++(int) { ListIterator t = *this; node = node->next; return t; }
+	ListIterator& operator--() { node = node ? node->prev : list->tail; return *this; }
+	ListIterator operator--(int) { ListIterator t = *this; --*this; return t; }
+	bool operator==(const ListIterator& rhs) const { return node == rhs.node; }
+	bool operator!=(const ListIterator& rhs) const { return node != rhs.node; }
+
+private:
+	Node<T>* node;
+	const List<T>* list;
+	friend class List<T>;
+};
+
+// Doubly linked list with a maintained tail, so push/pop at either end is O(1).
+// Nodes come from a per-list pool: blocks of nodes are allocated together and
+// freed nodes go on a free list for reuse, so most pushes do not call new.
+// Everything is released when the list is destroyed.
 template <class T>
 class List {
 private:
 	Node<T> * head;
 	Node<T> * tail;
 	int size;
-public:
-	List() : head(NULL) {}
-	~List() {}            /*Remove and free all resources*/
-	List(T* arr, int n_nodes) : List()
-	{
-		size = n_nodes;
-		Node<T>** list = &this->head;  // "list" is a variable to make a list
 
-		for (int i = 0; i < n_nodes; i++) {
-			*list = new Node<T>;            // allocate new node
-			(*list)->data = arr[i];         // initialize new node with data
-			(*list)->next = NULL;           // The last node's next must be NULL;
+	// pool: blocks of nodes chained through their first element's next
+	static const int MIN_BLOCK = 16;
+	static const int MAX_BLOCK = 1024;
+	Node<T> * blocks;
+	Node<T> * free_nodes;
+	int next_block;
 
-			list = &((*list)->next);        // manipulate next node
-		}
+	template <class U, class V> friend class ListIterator;
 
-		/*
-		 * Is there a way like this?
-		 *
-		Node<T>*& iter = this->head;
-		for (int i = 0 ; i < n_nodes; i++ ){
-		 iter = new Node<T>;
-		 iter->data = arr[i];
-		 iter->next = NULL;
-		 &iter = &(iter->next);
+	// allocate n nodes in one block and put them on the free list
+	void grow(int n)
+	{
+		Node<T>* block = new Node<T>[n + 1];   // block[0] links the blocks
+		block[0].next = blocks;
+		blocks = block;
+		for (int i = n; i >= 1; i--) {
+			block[i].next = free_nodes;
+			free_nodes = &block[i];
 		}
-		*/
-
 	}
-
-	void insert_at(int idx, T data) // or void insert_at(int idx, const T& data);
+	Node<T>* alloc_node(const T& val)
 	{
-		Node<T>* new_node = new Node<T>;
-		new_node->data = data;
-
-		Node<T> * find1 = head;
-		Node<T> * find2 = head;
-		for (int i = 0; i < idx; i++)
-		{
-			find1 = find1->next;//ϳ  Ŵ
-		}
-		for (int i = 0; i < idx-1; i++)
-		{
-			find2 = find2->next;//ϳ ĭ  Ŵ
+		if (!free_nodes) {
+			grow(next_block);
+			if (next_block < MAX_BLOCK)
+				next_block *= 2;
 		}
+		Node<T>* node = free_nodes;
+		free_nodes = node->next;
+		node->data = val;
+		return node;
+	}
+	void free_node(Node<T>* node)
+	{
+		node->data = T();      // drop whatever the value holds
+		node->next = free_nodes;
+		free_nodes = node;
+	}
 
-		new_node->next = find1;
-		find2->next = new_node;
-		
-		//cout << "insert";
+	// link a new node before pos (pos == NULL appends)
+	Node<T>* link_before(Node<T>* pos, const T& val)
+	{
+		Node<T>* new_node = alloc_node(val);
+		new_node->next = pos;
+		new_node->prev = pos ? pos->prev : tail;
+		if (new_node->prev) new_node->prev->next = new_node;
+		else head = new_node;
+		if (pos) pos->prev = new_node;
+		else tail = new_node;
 		size++;
-
+		return new_node;
 	}
-	void remove_at(int idx)
+	Node<T>* unlink(Node<T>* node)
 	{
-
-		Node<T> * find1 = head;
-		Node<T> * find2 = head;
-		for (int i = 0; i < idx; i++)
-		{
-			find1 = find1->next;//ϳ  Ŵ
+		Node<T>* next = node->next;
+		if (node->prev) node->prev->next = next;
+		else head = next;
+		if (next) next->prev = node->prev;
+		else tail = node->prev;
+		free_node(node);
+		size--;
+		return next;
+	}
+	// walk from whichever end is closer
+	Node<T>* node_at(int idx) const
+	{
+		Node<T>* find;
+		if (idx < size / 2) {
+			find = head;
+			for (int i = 0; i < idx; i++) find = find->next;
+		} else {
+			find = tail;
+			for (int i = size - 1; i > idx; i--) find = find->prev;
 		}
-		for (int i = 0; i < idx-1; i++)
-		{
-			find2 = find2->next;//ϳ ĭ  Ŵ
+		return find;
+	}
+
+public:
+	typedef ListIterator<T, T> iterator;
+	typedef ListIterator<T, const T> const_iterator;
+
+	List() : head(NULL), tail(NULL), size(0), blocks(NULL), free_nodes(NULL), next_block(MIN_BLOCK) {}
+	~List()                   /*Remove and free all resources*/
+	{
+		while (blocks) {
+			Node<T>* block = blocks;
+			blocks = block[0].next;
+			delete[] block;
 		}
+	}
+	List(T* arr, int n_nodes) : List()
+	{
+		reserve(n_nodes);
+		for (int i = 0; i < n_nodes; i++)
+			push_back(arr[i]);
+	}
+	List(const List& rhs) : List()
+	{
+		reserve(rhs.size);
+		for (Node<T>* iter = rhs.head; iter; iter = iter->next)
+			push_back(iter->data);
+	}
+	List(List&& rhs) noexcept : List() { swap(rhs); }
+	List& operator=(List rhs) { swap(rhs); return *this; }
 
-		
-		find2->next = find1->next;
-		delete find1;
-		
-		//cout << "remov";
-		size--;
+	void swap(List& rhs)
+	{
+		std::swap(head, rhs.head);
+		std::swap(tail, rhs.tail);
+		std::swap(size, rhs.size);
+		std::swap(blocks, rhs.blocks);
+		std::swap(free_nodes, rhs.free_nodes);
+		std::swap(next_block, rhs.next_block);
+	}
 
+	// make room for n more nodes with a single allocation
+	void reserve(int n)
+	{
+		int avail = 0;
+		for (Node<T>* iter = free_nodes; iter && avail < n; iter = iter->next) avail++;
+		if (avail < n) grow(n - avail);
 	}
-	void pop_back()
+
+	int length() const { return size; }
+	bool empty() const { return size == 0; }
+	T& front() { return head->data; }
+	T& back() { return tail->data; }
+
+	iterator begin() { return iterator(head, this); }
+	iterator end() { return iterator(NULL, this); }
+	const_iterator begin() const { return const_iterator(head, this); }
+	const_iterator end() const { return const_iterator(NULL, this); }
+
+	// O(1) given an iterator; returns an iterator to the new element
+	iterator insert(const_iterator pos, const T& data)
 	{
-		Node<T> * find1 = head;
-		Node<T> * find2 = head;
-		for (int i = 0; i < size - 1; i++)
-		{
-			find1 = find1->next;//ϳ  Ŵ
-		}
-		for (int i = 0; i < size - 2; i++)
-		{
-			find2 = find2->next;//ϳ ĭ  Ŵ
-		}
-		delete find1;
-		find2->next = NULL;
+		return iterator(link_before(pos.node, data), this);
+	}
+	// O(1) given an iterator; returns an iterator to the following element
+	iterator erase(const_iterator pos)
+	{
+		return iterator(unlink(pos.node), this);
+	}
 
-		//cout << "popback";
-		size--;
+	void insert_at(int idx, T data) // or void insert_at(int idx, const T& data);
+	{
+		link_before(idx < size ? node_at(idx) : NULL, data);
+	}
+	void remove_at(int idx)
+	{
+		unlink(node_at(idx));
+	}
+	void pop_back()
+	{
+		unlink(tail);
 	}
 	void push_back(T val) // or void push_back(const T& val)
 	{
-		// allocate new node
-		Node<T>* new_node = new Node<T>;
-		new_node->data = val;
-
-		// insert new node into head;
-		new_node->next = NULL;
-		Node<T> * find = head;
-		for (int i = 0; i < size-1; i++)
-		{
-			find = find->next;
-		}
-		find->next = new_node;
-		//cout << "pu_ba";
-		size++;
+		link_before(NULL, val);
 	}
 	void pop_front()
 	{
-		Node<T>* temp;
-		temp = this->head;
-		this->head = head->next;
-		delete temp;
-		//cout << "pop_fr";
-		size--;
-
-
+		unlink(head);
 	}
 	void push_front(T val) // or void push_front(const T& val)
 	{
-		// allocate new node
-		Node<T>* new_node = new Node<T>;
-		new_node->data = val;
-
-		// insert new node into head;
-		new_node->next = this->head;
-		this->head = new_node;
-		//cout << "pu_fr";
-		size++;
-
+		link_before(head, val);
 	}
 	// insert const keyword cuz of rvalue problem
-	friend std::ostream& operator<<(std::ostream& out, List<T>& rhs)
+	friend std::ostream& operator<<(std::ostream& out, const List<T>& rhs)
 	{
 		Node<T> * iter = rhs.head;
 		while (iter) {
 			out << iter->data;
 			if (!(iter->next == NULL)) {
-				 cout << ",";
+				 out << ",";
 			}
 			iter = iter->next;
 		}
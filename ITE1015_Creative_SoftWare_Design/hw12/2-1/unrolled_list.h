@@ -0,0 +1,271 @@
+#ifndef __UNROLLED_LIST_H__
+#define __UNROLLED_LIST_H__
+
+#include <iostream>
+#include <utility>
+
+// Unrolled variant of List (list.h) with the same interface.
+// Each chunk holds up to CHUNK elements in a small array, sized so the
+// elements fill about two cache lines, and chunks are doubly linked.
+// Walking the list touches one pointer per chunk instead of one per element,
+// and the per-element overhead is a fraction of a pointer.
+// A full chunk is split in half on insert; a chunk that drops below half
+// full on remove borrows from or merges with its next chunk.
+template <class T>
+class Chunk
+{
+public:
+	static const int CHUNK = 128 / sizeof(T) < 4 ? 4 : 128 / sizeof(T);
+
+	Chunk<T>* next;
+	Chunk<T>* prev;
+	int count;
+	T data[CHUNK];
+};
+
+template <class T> class UnrolledList;
+
+// Bidirectional iterator over an UnrolledList. V is T or const T.
+template <class T, class V>
+class UnrolledIterator {
+public:
+	UnrolledIterator() : chunk(NULL), i(0), list(NULL) {}
+	UnrolledIterator(Chunk<T>* chunk, int i, const UnrolledList<T>* list) : chunk(chunk), i(i), list(list) {}
+	// iterator -> const_iterator
+	operator UnrolledIterator<T, const T>() const { return UnrolledIterator<T, const T>(chunk, i, list); }
+
+	V& operator*() const { return chunk->data[i]; }
+	V* operator->() const { return &chunk->data[i]; }
+	UnrolledIterator& operator++()
+	{
+		if (++i == chunk->count) {
+			chunk = chunk->next;
+			i = 0;
+		}
+		return *this;
+	}
+	UnrolledIterator operator++(int) { UnrolledIterator t = *this; ++*this; return t; }
+	UnrolledIterator& operator--()
+	{
+		if (i == 0) {
+			chunk = chunk ? chunk->prev : list->tail;
+			i = chunk->count;
+		}
+		i--;
+		return *this;
+	}
+	UnrolledIterator operator--(int) { UnrolledIterator t = *this; --*this; return t; }
+	bool operator==(const UnrolledIterator& rhs) const { return chunk == rhs.chunk && i == rhs.i; }
+	bool operator!=(const UnrolledIterator& rhs) const { return !(*this == rhs); }
+
+private:
+	Chunk<T>* chunk;
+	int i;
+	const UnrolledList<T>* list;
+};
+
+template <class T>
+class UnrolledList {
+private:
+	static const int CHUNK = Chunk<T>::CHUNK;
+
+	Chunk<T> * head;
+	Chunk<T> * tail;
+	int size;
+
+	template <class U, class V> friend class UnrolledIterator;
+
+	// a new empty chunk linked after c (c == NULL puts it first)
+	Chunk<T>* new_chunk_after(Chunk<T>* c)
+	{
+		Chunk<T>* n = new Chunk<T>;
+		n->count = 0;
+		n->prev = c;
+		n->next = c ? c->next : head;
+		if (n->next) n->next->prev = n;
+		else tail = n;
+		if (c) c->next = n;
+		else head = n;
+		return n;
+	}
+	void delete_chunk(Chunk<T>* c)
+	{
+		if (c->prev) c->prev->next = c->next;
+		else head = c->next;
+		if (c->next) c->next->prev = c->prev;
+		else tail = c->prev;
+		delete c;
+	}
+
+	// chunk holding element idx; idx becomes the offset inside it.
+	// Walks whole chunks from whichever end is closer.
+	Chunk<T>* find(int& idx) const
+	{
+		Chunk<T>* c;
+		if (idx < size / 2) {
+			c = head;
+			while (idx >= c->count) {
+				idx -= c->count;
+				c = c->next;
+			}
+		} else {
+			int rest = size - idx;    // elements from idx to the end
+			c = tail;
+			while (rest > c->count) {
+				rest -= c->count;
+				c = c->prev;
+			}
+			idx = c->count - rest;
+		}
+		return c;
+	}
+
+	// insert at offset i of chunk c, splitting c if it is full
+	void insert_into(Chunk<T>* c, int i, const T& val)
+	{
+		if (c->count == CHUNK) {
+			Chunk<T>* n = new_chunk_after(c);
+			int half = CHUNK / 2;
+			for (int k = half; k < CHUNK; k++)
+				n->data[k - half] = std::move(c->data[k]);
+			n->count = CHUNK - half;
+			c->count = half;
+			if (i > half) {
+				c = n;
+				i -= half;
+			}
+		}
+		for (int k = c->count; k > i; k--)
+			c->data[k] = std::move(c->data[k - 1]);
+		c->data[i] = val;
+		c->count++;
+		size++;
+	}
+
+	// remove offset i of chunk c and keep chunks at least half full
+	void remove_from(Chunk<T>* c, int i)
+	{
+		for (int k = i; k < c->count - 1; k++)
+			c->data[k] = std::move(c->data[k + 1]);
+		c->data[--c->count] = T();    // drop whatever the value holds
+		size--;
+
+		if (c->count == 0) {
+			delete_chunk(c);
+			return;
+		}
+		Chunk<T>* n = c->next;
+		if (c->count >= CHUNK / 2 || !n)
+			return;
+		if (c->count + n->count <= CHUNK) {
+			// merge the next chunk into this one
+			for (int k = 0; k < n->count; k++)
+				c->data[c->count + k] = std::move(n->data[k]);
+			c->count += n->count;
+			delete_chunk(n);
+		} else {
+			// borrow from the next chunk until both are half full
+			int move = (n->count - c->count) / 2;
+			for (int k = 0; k < move; k++)
+				c->data[c->count + k] = std::move(n->data[k]);
+			for (int k = move; k < n->count; k++)
+				n->data[k - move] = std::move(n->data[k]);
+			for (int k = n->count - move; k < n->count; k++)
+				n->data[k] = T();
+			c->count += move;
+			n->count -= move;
+		}
+	}
+
+public:
+	typedef UnrolledIterator<T, T> iterator;
+	typedef UnrolledIterator<T, const T> const_iterator;
+
+	UnrolledList() : head(NULL), tail(NULL), size(0) {}
+	~UnrolledList()           /*Remove and free all resources*/
+	{
+		while (head) {
+			Chunk<T>* c = head;
+			head = c->next;
+			delete c;
+		}
+	}
+	UnrolledList(T* arr, int n_nodes) : UnrolledList()
+	{
+		for (int i = 0; i < n_nodes; i++)
+			push_back(arr[i]);
+	}
+	UnrolledList(const UnrolledList& rhs) : UnrolledList()
+	{
+		for (Chunk<T>* c = rhs.head; c; c = c->next)
+			for (int i = 0; i < c->count; i++)
+				push_back(c->data[i]);
+	}
+	UnrolledList(UnrolledList&& rhs) noexcept : UnrolledList() { swap(rhs); }
+	UnrolledList& operator=(UnrolledList rhs) { swap(rhs); return *this; }
+
+	void swap(UnrolledList& rhs)
+	{
+		std::swap(head, rhs.head);
+		std::swap(tail, rhs.tail);
+		std::swap(size, rhs.size);
+	}
+
+	int length() const { return size; }
+	bool empty() const { return size == 0; }
+	T& front() { return head->data[0]; }
+	T& back() { return tail->data[tail->count - 1]; }
+
+	iterator begin() { return iterator(head, 0, this); }
+	iterator end() { return iterator(NULL, 0, this); }
+	const_iterator begin() const { return const_iterator(head, 0, this); }
+	const_iterator end() const { return const_iterator(NULL, 0, this); }
+
+	void insert_at(int idx, T data) // or void insert_at(int idx, const T& data);
+	{
+		if (idx == size) {
+			push_back(data);
+			return;
+		}
+		Chunk<T>* c = find(idx);
+		insert_into(c, idx, data);
+	}
+	void remove_at(int idx)
+	{
+		Chunk<T>* c = find(idx);
+		remove_from(c, idx);
+	}
+	void pop_back()
+	{
+		remove_from(tail, tail->count - 1);
+	}
+	void push_back(T val) // or void push_back(const T& val)
+	{
+		// appending fills the last chunk instead of splitting it
+		if (!tail || tail->count == CHUNK)
+			new_chunk_after(tail);
+		tail->data[tail->count++] = val;
+		size++;
+	}
+	void pop_front()
+	{
+		remove_from(head, 0);
+	}
+	void push_front(T val) // or void push_front(const T& val)
+	{
+		if (!head || head->count == CHUNK)
+			new_chunk_after(NULL);
+		insert_into(head, 0, val);
+	}
+	friend std::ostream& operator<<(std::ostream& out, const UnrolledList<T>& rhs)
+	{
+		for (Chunk<T>* c = rhs.head; c; c = c->next)
+			for (int i = 0; i < c->count; i++) {
+				if (c != rhs.head || i) out << ",";
+				out << c->data[i];
+			}
+		return out;
+	}
+
+};
+#endif // __UNROLLED_LIST_H__
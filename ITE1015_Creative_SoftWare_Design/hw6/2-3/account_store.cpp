@@ -0,0 +1,151 @@
+#include "account_store.h"
+#include <stdint.h>
+
+
+
+// Fibonacci hashing: the top bits of id * 2^64/phi pick the slot
+static size_t slotOf(int id, size_t mask)
+{
+	uint64_t h = (uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull;
+	return (size_t)(h >> 32) & mask;
+}
+
+AccountStore::AccountStore(size_t stripes)
+	: keys_(1024), slots_(1024, -1), count_(0),
+	nstripes_(stripes ? stripes : 1), stripes_(new Stripe[nstripes_])
+{
+}
+
+AccountStore::~AccountStore()
+{
+}
+
+long AccountStore::find(int id) const
+{
+	size_t mask = slots_.size() - 1;
+	for (size_t s = slotOf(id, mask); slots_[s] != -1; s = (s + 1) & mask)
+		if (keys_[s] == id) return slots_[s];
+	return -1;
+}
+
+// double the table and reinsert every ID
+void AccountStore::grow()
+{
+	std::vector<int> keys(keys_.size() * 2);
+	std::vector<long> slots(slots_.size() * 2, -1);
+	size_t mask = slots.size() - 1;
+	for (size_t i = 0; i < slots_.size(); i++)
+	{
+		if (slots_[i] == -1) continue;
+		size_t s = slotOf(keys_[i], mask);
+		while (slots[s] != -1) s = (s + 1) & mask;
+		keys[s] = keys_[i];
+		slots[s] = slots_[i];
+	}
+	keys_.swap(keys);
+	slots_.swap(slots);
+}
+
+AccountStore::Result AccountStore::open(int id)
+{
+	std::unique_lock<std::shared_mutex> guard(table_lock_);
+	if (find(id) != -1) return EXISTS;
+	if ((count_ + 1) * 2 > slots_.size()) grow();
+
+	long index = (long)count_;
+	if ((index & (CHUNK - 1)) == 0)
+		chunks_.push_back(std::unique_ptr<int[]>(new int[CHUNK]));
+	bal(index) = 0;
+
+	size_t mask = slots_.size() - 1;
+	size_t s = slotOf(id, mask);
+	while (slots_[s] != -1) s = (s + 1) & mask;
+	keys_[s] = id;
+	slots_[s] = index;
+	count_++;
+	return OK;
+}
+
+size_t AccountStore::size() const
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	return count_;
+}
+
+bool AccountStore::exists(int id) const
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	return find(id) != -1;
+}
+
+int AccountStore::balance(int id) const
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	long i = find(id);
+	if (i == -1) return -1;
+	std::lock_guard<std::mutex> lock(stripe(i));
+	return bal(i);
+}
+
+AccountStore::Result AccountStore::deposit(int id, int amount)
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	long i = find(id);
+	if (i == -1) return NO_ACCOUNT;
+	std::lock_guard<std::mutex> lock(stripe(i));
+	if (bal(i) + amount > MAX_BALANCE) return OVER_LIMIT;
+	bal(i) += amount;
+	return OK;
+}
+
+AccountStore::Result AccountStore::withdraw(int id, int amount)
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	long i = find(id);
+	if (i == -1) return NO_ACCOUNT;
+	std::lock_guard<std::mutex> lock(stripe(i));
+	if (bal(i) - amount < 0) return INSUFFICIENT;
+	bal(i) -= amount;
+	return OK;
+}
+
+// same checks as AccountManager::trans; the caller holds table_lock_
+AccountStore::Result AccountStore::transferLocked(long from, long to, int amount)
+{
+	if (from == -1 || to == -1) return NO_ACCOUNT;
+
+	size_t a = from % nstripes_, b = to % nstripes_;
+	if (a > b) { size_t t = a; a = b; b = t; }
+	std::lock_guard<std::mutex> first(stripes_[a].lock);
+	std::unique_lock<std::mutex> second;
+	if (b != a) second = std::unique_lock<std::mutex>(stripes_[b].lock);
+
+	if (bal(from) - amount < 0) return INSUFFICIENT;
+	if (bal(to) + amount > MAX_BALANCE) return OVER_LIMIT;
+	bal(from) -= amount;
+	bal(to) += amount;
+	return OK;
+}
+
+AccountStore::Result AccountStore::transfer(int from, int to, int amount)
+{
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	return transferLocked(find(from), find(to), amount);
+}
+
+std::vector<AccountStore::Failure> AccountStore::transferBatch(const std::vector<Transfer>& batch)
+{
+	std::vector<Failure> failed;
+	std::shared_lock<std::shared_mutex> guard(table_lock_);
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		const Transfer& t = batch[i];
+		Result r = transferLocked(find(t.from), find(t.to), t.amount);
+		if (r != OK)
+		{
+			Failure f = { i, r };
+			failed.push_back(f);
+		}
+	}
+	return failed;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+// Account store for many accounts and concurrent transfers.
+//
+// IDs are found through an open-addressing hash table that doubles when it
+// is half full; balances live in fixed-size chunks that never move. Opening
+// an account (which may grow the table) takes table_lock_ exclusively;
+// every other operation takes it shared, so lookups run in parallel.
+//
+// Balances are guarded by striped locks: account i uses stripe i % stripes.
+// A transfer locks its two stripes in stripe order (once if they are the
+// same), so concurrent transfers cannot deadlock.
+//
+// Nothing here prints: results are returned to the caller.
+class AccountStore
+{
+public:
+	static const int MAX_BALANCE = 1000000;
+
+	enum Result { OK, NO_ACCOUNT, INSUFFICIENT, OVER_LIMIT, EXISTS };
+
+	struct Transfer
+	{
+		int from, to, amount;
+	};
+	struct Failure
+	{
+		size_t index;	// position in the batch
+		Result result;
+	};
+
+	explicit AccountStore(size_t stripes = 1024);
+	~AccountStore();
+
+	Result open(int id);
+	size_t size() const;
+	bool exists(int id) const;
+	int balance(int id) const;	// -1 if there is no such account
+
+	Result deposit(int id, int amount);
+	Result withdraw(int id, int amount);
+	Result transfer(int from, int to, int amount);
+
+	// Applies the transfers in order and returns the ones that failed.
+	// Several threads may each run their own batch at the same time; the
+	// table lock is taken once per batch instead of once per transfer.
+	std::vector<Failure> transferBatch(const std::vector<Transfer>& batch);
+
+private:
+	static const int CHUNK_BITS = 16;
+	static const int CHUNK = 1 << CHUNK_BITS;
+
+	struct alignas(64) Stripe
+	{
+		std::mutex lock;
+	};
+
+	long find(int id) const;	// account index, or -1
+	int& bal(long i) const { return chunks_[i >> CHUNK_BITS][i & (CHUNK - 1)]; }
+	std::mutex& stripe(long i) const { return stripes_[i % nstripes_].lock; }
+	Result transferLocked(long from, long to, int amount);
+	void grow();
+
+	mutable std::shared_mutex table_lock_;
+	std::vector<int> keys_;	// ID in each slot
+	std::vector<long> slots_;	// account index in each slot, -1 if empty
+	size_t count_;
+
+	std::vector<std::unique_ptr<int[]> > chunks_;
+
+	size_t nstripes_;
+	std::unique_ptr<Stripe[]> stripes_;
+};
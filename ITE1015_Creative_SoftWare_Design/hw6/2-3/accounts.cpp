@@ -22,15 +22,7 @@ Account::~Account()
 
 int AccountManager::dep(int id, int amount)
 {
-	int user = -1;
-	for (int i = 0; i < 10; i++)
-	{
-		
-		if (id == arr[i].ID) {
-			user = i;
-			break;
-		}
-	}
+	int user = find(id);
 	if (user == -1) {
 		cout << "Account does not exist"<< endl << endl;
 		return 0;
@@ -52,15 +44,7 @@ int AccountManager::dep(int id, int amount)
 
 int AccountManager::with(int id, int amount)
 {
-	int user = -1;
-	for (int i = 0; i < 10; i++)
-	{
-		
-		if (id == arr[i].ID) {
-			user = i;
-			break;
-		}
-	}
+	int user = find(id);
 	if (user == -1) {
 		cout << "Account does not exist" << endl << endl;
 		return 0;
@@ -82,25 +66,9 @@ int AccountManager::with(int id, int amount)
 
 int AccountManager::trans(int from, int to,int amount)
 {
-	int user_f = -1;
-	for (int i = 0; i < 10; i++)
-	{
-		
-		if (from == arr[i].ID) {
-			user_f = i;
-			break;
-		}
-	}
+	int user_f = find(from);
 
-	int user_t = -1;
-	for (int i = 0; i < 10; i++)
-	{
-		
-		if (to == arr[i].ID) {
-			user_t = i;
-			break;
-		}
-	}
+	int user_t = find(to);
 	if (user_f == -1 || user_t==-1) {
 		cout << "Account does not exist" << endl << endl; 
 		return 0;
@@ -128,17 +96,19 @@ int AccountManager::trans(int from, int to,int amount)
 
 }
 
-void AccountManager::check(int id)
+// index of the account with this ID in arr, or -1
+int AccountManager::find(int id)
 {
-	int user = -1;
 	for (int i = 0; i < 10; i++)
 	{
-		
-		if (id == arr[i].ID) {
-			user = i;
-			break;
-		}
+		if (id == arr[i].ID) return i;
 	}
+	return -1;
+}
+
+void AccountManager::check(int id)
+{
+	int user = find(id);
 	//cout << user;
 	
 	cout << "Balance of user " << arr[user].ID << " : " << arr[user].balance << endl ;
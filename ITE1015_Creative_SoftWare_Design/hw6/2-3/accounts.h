@@ -24,6 +24,7 @@ public:
 	int with(int id,int amount);
 	int trans(int from,int to,int amount);
 	void check(int id);
+	int find(int id);
 
 	AccountManager();
 	~AccountManager();
@@ -2,7 +2,7 @@
 
 
 
-sortedArray::sortedArray()
+sortedArray::sortedArray() : sorted_(0), min_(0), max_(0)
 {
 }
 
@@ -12,39 +12,52 @@ sortedArray::~sortedArray()
 
 void sortedArray::AddNumber(int num)
 {
+	if (numbers_.empty() || num < min_) min_ = num;
+	if (numbers_.empty() || num > max_) max_ = num;
+	// still in order: the sorted prefix just grows
+	if (sorted_ == numbers_.size() && (numbers_.empty() || numbers_.back() <= num)) sorted_++;
 	numbers_.push_back(num);
 	return;
 }
 
-vector<int> sortedArray::GetSortedAscending()
+// sort only what was added out of order and merge it into the prefix
+void sortedArray::Settle()
 {
+	if (sorted_ == numbers_.size()) return;
+	sort(numbers_.begin() + sorted_, numbers_.end());
+	inplace_merge(numbers_.begin(), numbers_.begin() + sorted_, numbers_.end());
+	sorted_ = numbers_.size();
+}
 
-	
-	sort(numbers_.begin(), numbers_.end());
+const vector<int>& sortedArray::GetSortedAscending()
+{
+	Settle();
 	return numbers_;
 }
 
 vector<int> sortedArray::GetSortedDescending()
 {
+	Settle();
+	return vector<int>(numbers_.rbegin(), numbers_.rend());
+}
 
-
-	sort(numbers_.begin(), numbers_.end(),greater<int>());
-	return numbers_;
+vector<int>::const_reverse_iterator sortedArray::DescendBegin()
+{
+	Settle();
+	return numbers_.crbegin();
 }
 
-int sortedArray::GetMax()
+vector<int>::const_reverse_iterator sortedArray::DescendEnd()
 {
-	
-	vector<int>::iterator it;
-	it = max_element(numbers_.begin(),numbers_.end());
-	
-	return *it;
+	return numbers_.crend();
 }
 
-int sortedArray::GetMin()
+int sortedArray::GetMax() const
 {
-	vector<int>::iterator it;
-	it = min_element(numbers_.begin(), numbers_.end());
+	return max_;
+}
 
-	return *it;
+int sortedArray::GetMin() const
+{
+	return min_;
 }
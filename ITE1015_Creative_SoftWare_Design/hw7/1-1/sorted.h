@@ -4,6 +4,9 @@ using namespace std;
 #include <algorithm>
 
 
+// numbers_[0, sorted_) is always in ascending order; numbers added out of
+// order are appended after it and merged in on the next query, so repeated
+// queries do not sort again. Min and max are tracked as numbers are added.
 class sortedArray
 {
 public:
@@ -12,13 +15,20 @@ public:
 
 	void AddNumber(int num);
 
-	vector<int> GetSortedAscending();
+	const vector<int>& GetSortedAscending();
 	vector<int> GetSortedDescending();
-	int GetMax();
-	int GetMin();
+	// the ascending array read backwards, without a copy
+	vector<int>::const_reverse_iterator DescendBegin();
+	vector<int>::const_reverse_iterator DescendEnd();
+	int GetMax() const;	// the array must not be empty
+	int GetMin() const;
 
 private:
+	void Settle();
+
 	vector<int> numbers_;
+	size_t sorted_;
+	int min_, max_;
 
 };
 
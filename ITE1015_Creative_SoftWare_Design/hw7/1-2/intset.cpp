@@ -13,35 +13,124 @@ intgerSet::~intgerSet()
 }
 
 void intgerSet::AddNumber(int num)
-{	
-	
-	for (int i = 0; i < numbers_.size(); i++)
-	{
-		if (num == numbers_[i]) numbers_.erase(numbers_.begin() + i);
-	}
-	this->numbers_.push_back(num);
+{
+	vector<int>::iterator it = lower_bound(numbers_.begin(), numbers_.end(), num);
+	if (it == numbers_.end() || *it != num) numbers_.insert(it, num);
+}
+
+void intgerSet::AddNumbers(const vector<int>& nums)
+{
+	numbers_.insert(numbers_.end(), nums.begin(), nums.end());
 	sort(numbers_.begin(), numbers_.end());
+	numbers_.erase(unique(numbers_.begin(), numbers_.end()), numbers_.end());
 }
 
 void intgerSet::DeleteNumber(int num)
 {
-	
-	for (int i = 0; i < numbers_.size(); i++)
-	{
-		if (num == numbers_[i]) numbers_.erase(numbers_.begin() + i);
-	}
-	sort(numbers_.begin(), numbers_.end());
+	vector<int>::iterator it = lower_bound(numbers_.begin(), numbers_.end(), num);
+	if (it != numbers_.end() && *it == num) numbers_.erase(it);
+}
+
+bool intgerSet::Contains(int num) const
+{
+	return binary_search(numbers_.begin(), numbers_.end(), num);
 }
 
 int intgerSet::GetItem(int pos)
 {
 	int re;
-	if (pos > numbers_.size() - 1) re = -1;
+	if (pos < 0 || pos >= (int)numbers_.size()) re = -1;
 	else re = numbers_[pos];
 	return re;
 }
 
-vector<int> intgerSet::GetAll()
+const vector<int>& intgerSet::GetAll() const
 {
 	return numbers_;
 }
+
+
+
+bitIntSet::bitIntSet() : base_(0), count_(0)
+{
+}
+
+// grow bits_ so that [lo, hi] is inside the range
+void bitIntSet::Cover(int lo, int hi)
+{
+	int64_t first = ((int64_t)lo - ((lo % 64 + 64) % 64));
+	if (bits_.empty()) {
+		base_ = first;
+		bits_.assign(((int64_t)hi - first) / 64 + 1, 0);
+		return;
+	}
+	if (first < base_) {
+		bits_.insert(bits_.begin(), (size_t)((base_ - first) / 64), 0);
+		base_ = first;
+	}
+	size_t need = (size_t)(((int64_t)hi - base_) / 64 + 1);
+	if (need > bits_.size()) bits_.resize(need, 0);
+}
+
+void bitIntSet::AddNumber(int num)
+{
+	Cover(num, num);
+	int64_t off = num - base_;
+	uint64_t bit = (uint64_t)1 << (off % 64);
+	if (!(bits_[off / 64] & bit)) {
+		bits_[off / 64] |= bit;
+		count_++;
+	}
+}
+
+void bitIntSet::AddNumbers(const vector<int>& nums)
+{
+	if (nums.empty()) return;
+	Cover(*min_element(nums.begin(), nums.end()), *max_element(nums.begin(), nums.end()));
+	for (size_t i = 0; i < nums.size(); i++) {
+		int64_t off = nums[i] - base_;
+		bits_[off / 64] |= (uint64_t)1 << (off % 64);
+	}
+	count_ = 0;
+	for (size_t w = 0; w < bits_.size(); w++) count_ += __builtin_popcountll(bits_[w]);
+}
+
+void bitIntSet::DeleteNumber(int num)
+{
+	if (!Contains(num)) return;
+	int64_t off = num - base_;
+	bits_[off / 64] &= ~((uint64_t)1 << (off % 64));
+	count_--;
+}
+
+bool bitIntSet::Contains(int num) const
+{
+	int64_t off = num - base_;
+	if (off < 0 || off >= (int64_t)bits_.size() * 64) return false;
+	return (bits_[off / 64] >> (off % 64)) & 1;
+}
+
+// skip whole words by their popcount, then find the bit inside the word
+int bitIntSet::GetItem(int pos)
+{
+	if (pos < 0 || pos >= count_) return -1;
+	size_t w = 0;
+	for (;; w++) {
+		int c = __builtin_popcountll(bits_[w]);
+		if (pos < c) break;
+		pos -= c;
+	}
+	uint64_t word = bits_[w];
+	for (; pos > 0; pos--) word &= word - 1;	// clear the lowest set bits
+	return (int)(base_ + (int64_t)w * 64 + __builtin_ctzll(word));
+}
+
+vector<int> bitIntSet::GetAll() const
+{
+	vector<int> re;
+	re.reserve(count_);
+	for (size_t w = 0; w < bits_.size(); w++)
+		for (uint64_t word = bits_[w]; word; word &= word - 1)
+			re.push_back((int)(base_ + (int64_t)w * 64 + __builtin_ctzll(word)));
+	return re;
+}
@@ -1,22 +1,50 @@
 #pragma once
 using namespace std;
 #include <algorithm>
+#include <stdint.h>
 #include <vector>
 
+// numbers_ is always sorted and has no duplicates, so a single number is
+// found with lower_bound and added or removed with one insert/erase.
 class intgerSet
 {
 public:
 	intgerSet();
 	~intgerSet();
 	void AddNumber(int num);
+	void AddNumbers(const vector<int>& nums);	// append, sort and dedup once
 	void DeleteNumber(int num);
+	bool Contains(int num) const;
 
 	int GetItem(int pos);
-	vector<int> GetAll();
+	const vector<int>& GetAll() const;
 
 
 private:
 	vector<int> numbers_;
-	
+
 };
 
+// The same interface backed by a bitset over [base_, base_ + 64 * bits_.size()).
+// For dense ranges this takes one bit per possible value, and add, delete and
+// lookup are O(1). The range grows to cover every number added.
+class bitIntSet
+{
+public:
+	bitIntSet();
+	void AddNumber(int num);
+	void AddNumbers(const vector<int>& nums);
+	void DeleteNumber(int num);
+	bool Contains(int num) const;
+
+	int GetItem(int pos);
+	vector<int> GetAll() const;
+	int Size() const { return count_; }
+
+private:
+	void Cover(int lo, int hi);
+
+	int64_t base_;	// multiple of 64
+	vector<uint64_t> bits_;
+	int count_;
+};
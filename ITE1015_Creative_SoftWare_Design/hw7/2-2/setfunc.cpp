@@ -1,100 +1,183 @@
 #include "setfunc.h"
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
-std::set<int> parseSet(const std::string & str)
+// Reads the numbers straight out of str: no substr or stoi temporaries.
+// Anything that is not a digit or a leading '-' separates numbers, so
+// "{ }" gives an empty set.
+static void parseNumbers(const std::string& str, std::vector<int>& out)
 {
-	set<int> setnew;
-	int size= str.size();
-	string strok;
-	
-	//cout << size << endl;
-	int fir = 1;
-	while (1) {
-		
-		size_t pos = str.find(" ",fir);
-		strok = str.substr(fir,pos-fir);
-		//cout << strok << endl;
-		//cout << str << endl;
-		fir = pos + 1;
-		//cout << "while " << endl;
-		setnew.insert(stoi(strok));
-		
-
-		if (pos+1==size) break;
+	const char* p = str.c_str();
+	const char* end = p + str.size();
+	while (p < end) {
+		bool neg = false;
+		if (*p == '-' && p + 1 < end && *(p + 1) >= '0' && *(p + 1) <= '9') {
+			neg = true;
+			p++;
+		}
+		if (*p < '0' || *p > '9') {
+			p++;
+			continue;
+		}
+		long long v = 0;
+		while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+		out.push_back((int)(neg ? -v : v));
 	}
-		
-	//cout << "while " << endl;
-	//printSet(setnew);
-	return setnew;
 }
 
-std::set<int> getIntersection(const std::set<int>& set0, const std::set<int>& set1)
+std::set<int> parseSet(const std::string & str)
 {
-	set<int> inter;
-	set<int> mid1;
-	set<int> mid2;
-	mid1 = getDifference(set0, set1);
-	//printSet(mid1);
-	inter = getDifference(set0, mid1);
-	//printSet(inter);
-
-
+	std::vector<int> nums;
+	parseNumbers(str, nums);
+	return set<int>(nums.begin(), nums.end());
+}
 
-	return inter;
+std::vector<int> parseSorted(const std::string& str)
+{
+	std::vector<int> nums;
+	parseNumbers(str, nums);
+	sort(nums.begin(), nums.end());
+	nums.erase(unique(nums.begin(), nums.end()), nums.end());
+	return nums;
 }
 
-std::set<int> getUnion(const std::set<int>& set0, const std::set<int>& set1)
+std::vector<int> sortedUnion(const std::vector<int>& a, const std::vector<int>& b)
 {
-	set<int> uni;
-	set<int>::iterator it0 = set0.begin();
-	set<int>::iterator it1 = set1.begin();
-	int size1 = set0.size(), size2 = set1.size();
-	for (int i = 0; i < size1; i++)
-	{
-		uni.insert(*it0);
-		it0++;
+	std::vector<int> re;
+	re.reserve(a.size() + b.size());
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i] < b[j]) re.push_back(a[i++]);
+		else if (b[j] < a[i]) re.push_back(b[j++]);
+		else {
+			re.push_back(a[i++]);
+			j++;
+		}
 	}
-	for (int i = 0; i < size2; i++)
-	{
-		uni.insert(*it1);
-		it1++;
+	re.insert(re.end(), a.begin() + i, a.end());
+	re.insert(re.end(), b.begin() + j, b.end());
+	return re;
+}
+
+std::vector<int> sortedDifference(const std::vector<int>& a, const std::vector<int>& b)
+{
+	std::vector<int> re;
+	re.reserve(a.size());
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i] < b[j]) re.push_back(a[i++]);
+		else if (b[j] < a[i]) j++;
+		else {
+			i++;
+			j++;
+		}
 	}
+	re.insert(re.end(), a.begin() + i, a.end());
+	return re;
+}
 
+// first index >= from with b[index] >= x: double the step, then binary search
+static size_t gallop(const std::vector<int>& b, size_t from, int x)
+{
+	size_t step = 1, lo = from, hi = from;
+	while (hi < b.size() && b[hi] < x) {
+		lo = hi + 1;
+		hi = from + step;
+		step *= 2;
+	}
+	if (hi > b.size()) hi = b.size();
+	return lower_bound(b.begin() + lo, b.begin() + hi, x) - b.begin();
+}
 
-	return uni;
+// small is much shorter than big
+static void gallopIntersection(const std::vector<int>& small, const std::vector<int>& big, std::vector<int>& re)
+{
+	size_t j = 0;
+	for (size_t i = 0; i < small.size() && j < big.size(); i++) {
+		j = gallop(big, j, small[i]);
+		if (j < big.size() && big[j] == small[i]) re.push_back(big[j++]);
+	}
 }
 
-std::set<int> getDifference(const std::set<int>& set0, const std::set<int>& set1)
+std::vector<int> sortedIntersection(const std::vector<int>& a, const std::vector<int>& b)
 {
-	set<int> dif;
-	dif = set0;
-	set<int>::iterator it0 = dif.begin();
-	//cout << "dif " << endl;
-	int size1 = set0.size(), size2 = set1.size();
-	for (int i = 0; it0!=dif.end(); i++)
-	{
-		int count = 1;
-		//cout << "dif ó" << endl;
-		set<int>::iterator it1 = set1.begin();
-		for (int j = 0; j < size2; j++)
-		{
-			//cout << "dif ι° " << endl;
-			if (*it0 == *it1) {
-				count = 0;
-				it0 = dif.erase(it0);
-				//cout << "dif if  " << endl;
-				break;
+	std::vector<int> re;
+	if (a.size() * 32 < b.size()) {
+		gallopIntersection(a, b, re);
+		return re;
+	}
+	if (b.size() * 32 < a.size()) {
+		gallopIntersection(b, a, re);
+		return re;
+	}
+
+	// write through a raw pointer; the result is at most the smaller size
+	re.resize(min(a.size(), b.size()));
+	int* out = re.data();
+	size_t i = 0, j = 0;
+#ifdef __SSE2__
+	// Compare a[i..i+3] with all four rotations of b[j..j+3]. Elements are
+	// unique, so each a[k] matches at most once over all the b blocks it
+	// meets; store all four and keep the matches, then advance the block
+	// with the smaller last element. Nothing here branches on the data.
+	while (i + 4 <= a.size() && j + 4 <= b.size()) {
+		__m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+		__m128i vb = _mm_loadu_si128((const __m128i*)&b[j]);
+		__m128i eq = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi32(va, vb),
+				_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+			_mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+				_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+		if (mask) {
+			for (int k = 0; k < 4; k++) {
+				*out = a[i + k];
+				out += mask >> k & 1;
 			}
-			it1++;
 		}
-		if(count==1)it0++;
+
+		int amax = a[i + 3], bmax = b[j + 3];
+		i += (amax <= bmax) * 4;
+		j += (bmax <= amax) * 4;
+	}
+#endif
+	while (i < a.size() && j < b.size()) {
+		if (a[i] < b[j]) i++;
+		else if (b[j] < a[i]) j++;
+		else {
+			*out++ = a[i++];
+			j++;
+		}
 	}
-	//cout << "difŻ " << endl;
-	return dif;
+	re.resize(out - re.data());
+	return re;
+}
+
+std::set<int> getIntersection(const std::set<int>& set0, const std::set<int>& set1)
+{
+	std::vector<int> re = sortedIntersection(std::vector<int>(set0.begin(), set0.end()),
+		std::vector<int>(set1.begin(), set1.end()));
+	return set<int>(re.begin(), re.end());
+}
+
+std::set<int> getUnion(const std::set<int>& set0, const std::set<int>& set1)
+{
+	std::vector<int> re = sortedUnion(std::vector<int>(set0.begin(), set0.end()),
+		std::vector<int>(set1.begin(), set1.end()));
+	return set<int>(re.begin(), re.end());
+}
+
+std::set<int> getDifference(const std::set<int>& set0, const std::set<int>& set1)
+{
+	std::vector<int> re = sortedDifference(std::vector<int>(set0.begin(), set0.end()),
+		std::vector<int>(set1.begin(), set1.end()));
+	return set<int>(re.begin(), re.end());
 }
 
 void printSet(const std::set<int>& _set) {
-	//cout << "print " << endl;
 	int size = _set.size();
 	set<int>::iterator iter=_set.begin();
 
@@ -105,4 +188,4 @@ void printSet(const std::set<int>& _set) {
 		iter++;
 	}
 	cout << "}\n";
-}
\ No newline at end of file
+}
@@ -2,9 +2,21 @@
 #include <set>
 #include <iostream>
 #include <string>
+#include <vector>
 using namespace std;
 std::set<int> parseSet(const std::string& str);
 void printSet(const std::set<int>&);
 std::set<int> getIntersection(const std::set<int>& set0, const std::set<int>& set1);
 std::set<int> getUnion(const std::set<int>& set0, const std::set<int>& set1);
-std::set<int> getDifference(const std::set<int>& set0, const std::set<int>& set1);
\ No newline at end of file
+std::set<int> getDifference(const std::set<int>& set0, const std::set<int>& set1);
+
+// Set operations on flat sorted vectors without duplicates.
+// Each one is a single merge pass over both inputs (O(n + m)).
+// The std::set versions above copy into vectors, use these, and build the
+// result from the sorted output, which is also linear.
+std::vector<int> parseSorted(const std::string& str);
+std::vector<int> sortedUnion(const std::vector<int>& a, const std::vector<int>& b);
+std::vector<int> sortedDifference(const std::vector<int>& a, const std::vector<int>& b);
+// When one side is much smaller, each of its elements is found in the other
+// by galloping (O(n log m)); otherwise the merge compares 4x4 blocks with SSE2.
+std::vector<int> sortedIntersection(const std::vector<int>& a, const std::vector<int>& b);
@@ -116,3 +116,124 @@ void Diamond::Draw(int _garo, int _sero)
 		cout << endl;
 	}
 }
+
+
+size_t ShapeBatch::Add(const Square& s) { return AddSquare(s.wid); }
+size_t ShapeBatch::Add(const Rectangle& r) { return AddRectangle(r.wid, r.hei); }
+
+size_t ShapeBatch::Add(const Diamond& d)
+{
+	diamondWid.push_back(d.wid);
+	return diamondWid.size() - 1;
+}
+
+size_t ShapeBatch::AddSquare(int wid)
+{
+	squareWid.push_back(wid);
+	return squareWid.size() - 1;
+}
+
+size_t ShapeBatch::AddRectangle(int wid, int hei)
+{
+	rectWid.push_back(wid);
+	rectHei.push_back(hei);
+	return rectWid.size() - 1;
+}
+
+size_t ShapeBatch::AddDiamond(int dis)
+{
+	diamondWid.push_back(dis * 2 + 1);
+	return diamondWid.size() - 1;
+}
+
+size_t ShapeBatch::Size(Kind kind) const
+{
+	if (kind == SQUARE) return squareWid.size();
+	if (kind == RECTANGLE) return rectWid.size();
+	if (kind == DIAMOND) return diamondWid.size();
+	return 0;
+}
+
+void ShapeBatch::Clear()
+{
+	squareWid.clear();
+	rectWid.clear();
+	rectHei.clear();
+	diamondWid.clear();
+}
+
+void ShapeBatch::ComputeAreas(Kind kind, double* out) const
+{
+	if (kind == SQUARE) {
+		const int* w = squareWid.data();
+		for (size_t i = 0, n = squareWid.size(); i < n; i++)
+			out[i] = w[i] * w[i];
+	}
+	else if (kind == RECTANGLE) {
+		const int* w = rectWid.data();
+		const int* h = rectHei.data();
+		for (size_t i = 0, n = rectWid.size(); i < n; i++)
+			out[i] = w[i] * h[i];
+	}
+	else if (kind == DIAMOND) {
+		const int* w = diamondWid.data();
+		for (size_t i = 0, n = diamondWid.size(); i < n; i++)
+			out[i] = (double)(w[i] * w[i]) / 2;
+	}
+}
+
+void ShapeBatch::ComputePerimeters(Kind kind, int* out) const
+{
+	if (kind == SQUARE) {
+		const int* w = squareWid.data();
+		for (size_t i = 0, n = squareWid.size(); i < n; i++)
+			out[i] = w[i] * 4;
+	}
+	else if (kind == RECTANGLE) {
+		const int* w = rectWid.data();
+		const int* h = rectHei.data();
+		for (size_t i = 0, n = rectWid.size(); i < n; i++)
+			out[i] = w[i] * 2 + h[i] * 2;
+	}
+	else if (kind == DIAMOND) {
+		// the same operations as Diamond::GetPerimeter, so the truncation agrees
+		const int* w = diamondWid.data();
+		for (size_t i = 0, n = diamondWid.size(); i < n; i++)
+			out[i] = (int)((double)w[i] / 2 * sqrt((double)(w[i] / 2)) * 4);
+	}
+}
+
+double ShapeBatch::TotalArea() const
+{
+	// a diamond's area is w * w / 2, so its sum is halved once at the end
+	long long sq = 0, rect = 0, dia = 0;
+	for (size_t i = 0, n = squareWid.size(); i < n; i++)
+		sq += (long long)squareWid[i] * squareWid[i];
+	for (size_t i = 0, n = rectWid.size(); i < n; i++)
+		rect += (long long)rectWid[i] * rectHei[i];
+	for (size_t i = 0, n = diamondWid.size(); i < n; i++)
+		dia += (long long)diamondWid[i] * diamondWid[i];
+	return (double)(sq + rect) + (double)dia / 2;
+}
+
+long long ShapeBatch::TotalPerimeter() const
+{
+	long long sq = 0, rect = 0, dia = 0;
+	for (size_t i = 0, n = squareWid.size(); i < n; i++)
+		sq += squareWid[i];
+	for (size_t i = 0, n = rectWid.size(); i < n; i++)
+		rect += rectWid[i] + rectHei[i];
+
+	// each diamond truncates on its own, so go through the per-shape values
+	const size_t CHUNK = 1024;
+	int peri[CHUNK];
+	const int* w = diamondWid.data();
+	for (size_t i = 0, n = diamondWid.size(); i < n; i += CHUNK) {
+		size_t m = n - i < CHUNK ? n - i : CHUNK;
+		for (size_t j = 0; j < m; j++)
+			peri[j] = (int)((double)w[i + j] / 2 * sqrt((double)(w[i + j] / 2)) * 4);
+		for (size_t j = 0; j < m; j++)
+			dia += peri[j];
+	}
+	return sq * 4 + rect * 2 + dia;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 using namespace std;
 class Shape {
 public:
@@ -8,6 +9,7 @@ public:
 	double GetArea() {};
 	int GetPerimeter() {};
 	void Draw(int canvas_width, int canvas_height) {};
+	friend class ShapeBatch;
 protected:
 	int x,y;
 	int wid, hei;
@@ -45,6 +47,41 @@ public:
 
 };
 
+// Sizes of many shapes kept per kind in parallel arrays (structure of
+// arrays). Areas and perimeters come out of one flat loop per kind, with no
+// per-shape type switch, and the compiler vectorizes the loops. Results
+// match the classes' GetArea()/GetPerimeter(); the diamond loop vectorizes
+// only with -fno-math-errno (it takes sqrt). Positions and brushes are not
+// kept, they do not change a shape's area or perimeter.
+class ShapeBatch {
+public:
+	enum Kind { SQUARE, RECTANGLE, DIAMOND, KINDS };
+
+	// each returns the shape's index within its kind
+	size_t Add(const Square& s);
+	size_t Add(const Rectangle& r);
+	size_t Add(const Diamond& d);
+	size_t AddSquare(int wid);
+	size_t AddRectangle(int wid, int hei);
+	size_t AddDiamond(int dis);
+
+	size_t Size(Kind kind) const;
+	void Clear();
+
+	// out[i] for the i-th shape of the kind, out holds Size(kind) values
+	void ComputeAreas(Kind kind, double* out) const;
+	void ComputePerimeters(Kind kind, int* out) const;
+
+	// over every shape; areas are summed exactly in integers
+	double TotalArea() const;
+	long long TotalPerimeter() const;
+
+private:
+	vector<int> squareWid;
+	vector<int> rectWid, rectHei;
+	vector<int> diamondWid;	// 2 * dis + 1, as Diamond stores it
+};
+
 
 
 	//isinshape Լ ֱ
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "canvas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
 using namespace std;
@@ -8,16 +11,10 @@ Canvas::Canvas(size_t row, size_t col)
 {
 	row_ = row;
 	col_ = col;
-	can = new string*[row];
-	for (int i = 0; i < row; i++)
-	{
-		can[i] = new string[col];
-		for (int j = 0; j < col; j++)
-		{
-			
-			can[i][j] = ".";
-		}
-	}
+	can.assign(row * col, Brush("."));
+	clip_ = Whole();
+	dirty_ = Whole();
+	pending_ = Box::none();
 }
 
 Canvas::~Canvas()
@@ -26,26 +23,13 @@ Canvas::~Canvas()
 
 void Canvas::Resize(size_t w, size_t h)
 {
-	
-	for (int i = 0; i < row_; i++)
-	{
-		delete[] can[i];
-	}
-	delete[] can;
 	row_ = h;
 	col_ = w;
-	
-
-
-	can = new string*[h];
-	for (int i = 0; i < h; i++)
-	{
-		can[i] = new string[w];
-		for (int j = 0; j < w; j++)
-		{
-			can[i][j] = ".";
-		}
-	}
+	can.assign(h * w, Brush("."));
+	clip_ = Whole();
+	dirty_ = Whole();
+	pending_ = Box::none();
+	shown_.clear();
 }
 
 bool Canvas::DrawPixel(int x, int y)
@@ -55,31 +39,109 @@ bool Canvas::DrawPixel(int x, int y)
 	return  isok;
 }
 
-void Canvas::Print()
+// first byte in the low 8 bits; unused bytes stay 0
+uint32_t Canvas::Brush(const string& bru)
 {
+	uint32_t cell = 0;
+	for (size_t i = 0; i < bru.size() && i < 4; i++)
+		cell |= (uint32_t)(unsigned char)bru[i] << (8 * i);
+	return cell;
+}
+
+void Canvas::FillSpan(int y, int x0, int x1, uint32_t cell)
+{
+	if (y < clip_.y0 || y > clip_.y1) return;
+	if (x0 < clip_.x0) x0 = clip_.x0;
+	if (x1 > clip_.x1) x1 = clip_.x1;
+	if (x0 > x1) return;
+	uint32_t* row = Row(y);
+	fill(row + x0, row + x1 + 1, cell);
+}
 
-	for (int i = 0; i <= row_; i++)
+// row i with its label, as text; returns the end of the line
+char* Canvas::FormatRow(int i, char* p)
+{
+	const uint32_t* row = Row(i);
+	*p++ = '0' + i % 10;
+	for (int j = 0; j < col_; j++)
 	{
-		for (int j = 0; j <= col_; j++)
-		{
-			if (i == 0 && j == 0) cout << " ";
-			else if (i == 0) cout << (j - 1)%10;
-			else if (j == 0) cout << (i - 1)%10;
-			else cout << can[i - 1][j - 1];
-		}
-		cout << endl;
+		uint32_t cell = row[j];
+		do {
+			*p++ = (char)cell;
+			cell >>= 8;
+		} while (cell);
 	}
+	*p++ = '\n';
+	return p;
 }
 
-void Canvas::Clear()
-{	
+// Each line is built in line_ and written with one fwrite.
+// cout is synced with stdio, so this interleaves correctly with cout.
+void Canvas::Print()
+{
+	line_.resize(((size_t)col_ + 1) * 4 + 1);
+	char* p = line_.data();
+	*p++ = ' ';
+	for (int j = 0; j < col_; j++) *p++ = '0' + j % 10;
+	*p++ = '\n';
+	fwrite(line_.data(), 1, p - line_.data(), stdout);
+
 	for (int i = 0; i < row_; i++)
 	{
-		for (int j = 0; j < col_; j++)
+		p = FormatRow(i, line_.data());
+		fwrite(line_.data(), 1, p - line_.data(), stdout);
+	}
+}
+
+void Canvas::Redraw(const vector<Shape*>& shapes)
+{
+	Box box = dirty_.intersect(Whole());
+	dirty_ = Box::none();
+	if (box.empty()) return;
+
+	uint32_t dot = Brush(".");
+	for (int y = box.y0; y <= box.y1; y++)
+		fill(Row(y) + box.x0, Row(y) + box.x1 + 1, dot);
+	clip_ = box;
+	DrawAll(shapes);
+	clip_ = Whole();
+	pending_ = pending_.unite(box);
+}
+
+// The header is screen line 1 and row i is line i + 2.
+void Canvas::PrintChanged()
+{
+	if (shown_.size() != can.size()) {
+		fputs("\x1b[2J\x1b[H", stdout);
+		Print();
+		shown_ = can;
+	}
+	else {
+		line_.resize(((size_t)col_ + 1) * 4 + 1);
+		for (int i = max(pending_.y0, 0); i <= pending_.y1 && i < row_; i++)
 		{
-			can[i][j] = ".";
+			uint32_t* row = Row(i);
+			uint32_t* old = &shown_[(size_t)i * col_];
+			if (equal(row, row + col_, old)) continue;
+			copy(row, row + col_, old);
+			printf("\x1b[%d;1H", i + 2);
+			char* p = FormatRow(i, line_.data());
+			fwrite(line_.data(), 1, p - line_.data(), stdout);
 		}
 	}
+	pending_ = Box::none();
+	// leave the cursor under the canvas with the rest of the screen cleared
+	printf("\x1b[%d;1H\x1b[J", row_ + 2);
+	fflush(stdout);
+}
+
+void Canvas::Clear()
+{
+	fill(can.begin(), can.end(), Brush("."));
+}
+
+Shape::Shape() : _kind(OTHER), _box(Box::none()), _cell(0)
+{
 }
 
 Shape::~Shape()
@@ -100,6 +162,10 @@ Rectangle::Rectangle(int x, int y, int wid, int hei, string brush)
 	_hei = hei;
 	_wid = wid;
 	_bru = brush;
+	_cell = Canvas::Brush(_bru);
+	_kind = RECT;
+	Box box = { _x, _y, _x + _wid - 1, _y + _hei - 1 };
+	_box = box;
 
 }
 
@@ -109,19 +175,14 @@ Rectangle::~Rectangle()
 
 void Rectangle::Draw(Canvas * canvas)
 {
-	
-	for (int i = 0; i < _hei; i++){
-		for (int j = 0; j < _wid; j++){
-			if (canvas->DrawPixel(_x + j, _y + i)) {
-				canvas->can[_y + i][_x + j] = _bru;
-			}
-			else continue;
-		}
-	}
-	
-	
-	
-	
+	Fill(canvas);
+}
+
+void Rectangle::Fill(Canvas * canvas) const
+{
+	int top = max(_y, canvas->clip_.y0), bottom = min(_y + _hei, canvas->clip_.y1 + 1);
+	for (int y = top; y < bottom; y++)
+		canvas->FillSpan(y, _x, _x + _wid - 1, _cell);
 }
 
 void Rectangle::print()
@@ -136,6 +197,10 @@ UpTriangle::UpTriangle(int x, int y, int hei,string bru)
 	_hei = hei;
 	_wid = 2 * hei - 1;
 	_bru = bru;
+	_cell = Canvas::Brush(_bru);
+	_kind = TRI_UP;
+	Box box = { _x - _hei + 1, _y, _x + _hei - 1, _y + _hei - 1 };
+	_box = box;
 }
 
 UpTriangle::~UpTriangle()
@@ -145,18 +210,15 @@ UpTriangle::~UpTriangle()
 
 void UpTriangle::Draw(Canvas * canvas)
 {
-	for (int i = 0; i < _hei; i++)
-	{
-		for (int j = -i; j <= i; j++)
-		{
-			if (canvas->DrawPixel(_x+j,_y+i)) {
-				canvas->can[_y + i][_x + j] = _bru;
-			}
-			else continue;
-			
-		}
-	}
-	
+	Fill(canvas);
+}
+
+void UpTriangle::Fill(Canvas * canvas) const
+{
+	// row _y + i spans _x - i .. _x + i
+	int first = max(0, canvas->clip_.y0 - _y), last = min(_hei, canvas->clip_.y1 + 1 - _y);
+	for (int i = first; i < last; i++)
+		canvas->FillSpan(_y + i, _x - i, _x + i, _cell);
 }
 
 void UpTriangle::print()
@@ -171,6 +233,10 @@ DownTriangle::DownTriangle(int x, int y, int hei,string bru)
 	_hei = hei;
 	_wid = 2 * hei - 1;
 	_bru = bru;
+	_cell = Canvas::Brush(_bru);
+	_kind = TRI_DOWN;
+	Box box = { _x - _hei + 1, _y - _hei + 1, _x + _hei - 1, _y };
+	_box = box;
 	
 }
 
@@ -180,19 +246,15 @@ DownTriangle::~DownTriangle()
 
 void DownTriangle::Draw(Canvas * canvas)
 {
-	for (int i =_hei; i >0; i--)
-	{
-		for (int j =-(_hei-i); j <= (_hei-i); j++)
-		{
-			if (canvas->DrawPixel(_x + j, _y - (_hei - i))) {
-				canvas->can[_y - (_hei - i)][_x + j] = _bru;
-			}
-			else continue;
-			
+	Fill(canvas);
+}
 
-		}
-	}
-	
+void DownTriangle::Fill(Canvas * canvas) const
+{
+	// row _y - i spans _x - i .. _x + i
+	int first = max(0, _y - canvas->clip_.y1), last = min(_hei, _y - canvas->clip_.y0 + 1);
+	for (int i = first; i < last; i++)
+		canvas->FillSpan(_y - i, _x - i, _x + i, _cell);
 }
 
 void DownTriangle::print()
@@ -208,6 +270,10 @@ Diamond::Diamond(int x, int y, int dis, string brush)
 	_hei = dis*2+1;
 	_wid = dis * 2+1;
 	_bru = brush;
+	_cell = Canvas::Brush(_bru);
+	_kind = DIAMOND;
+	Box box = { _x - _hei / 2, _y, _x + _hei / 2, _y + _hei - 1 };
+	_box = box;
 
 }
 
@@ -217,19 +283,17 @@ Diamond::~Diamond()
 
 void Diamond::Draw(Canvas * canvas)
 {
-	int center_x = _x;
+	Fill(canvas);
+}
+
+void Diamond::Fill(Canvas * canvas) const
+{
 	int center_y = _y + _hei / 2;
-	for (int i = 0; i < canvas->row_ ; i++) {
-		for (int j = 0; j < canvas->col_; j++) {
-			if (canvas->DrawPixel(j,i)){
-				if (_x - (_hei / 2 - abs(center_y - i)) <= j && j <= _x + (_hei / 2 - abs(center_y - i)) && _y <= i && i < _y + _hei)  canvas->can[i][j] = _bru;
-			}
-			else continue;
-
-			
-		}
+	int top = max(_y, canvas->clip_.y0), bottom = min(_y + _hei, canvas->clip_.y1 + 1);
+	for (int y = top; y < bottom; y++) {
+		int half = _hei / 2 - abs(center_y - y);
+		canvas->FillSpan(y, _x - half, _x + half, _cell);
 	}
-	
 }
 
 void Diamond::print()
@@ -237,3 +301,19 @@ void Diamond::print()
 	cout << "diamond" << " " << _x << " " << _y << " " << _hei / 2 << " " << _bru << endl;
 }
 
+
+void Canvas::DrawAll(const vector<Shape*>& shapes)
+{
+	for (size_t i = 0; i < shapes.size(); i++)
+	{
+		Shape* s = shapes[i];
+		if (s->kind() != Shape::OTHER && s->bounds().intersect(clip_).empty()) continue;
+		switch (s->kind()) {
+		case Shape::RECT: static_cast<Rectangle*>(s)->Fill(this); break;
+		case Shape::TRI_UP: static_cast<UpTriangle*>(s)->Fill(this); break;
+		case Shape::TRI_DOWN: static_cast<DownTriangle*>(s)->Fill(this); break;
+		case Shape::DIAMOND: static_cast<Diamond*>(s)->Fill(this); break;
+		default: s->Draw(this); break;
+		}
+	}
+}
@@ -1,6 +1,31 @@
 #pragma once
+#include <stdint.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 using namespace std;
+class Shape;
+// inclusive rectangle of cells; empty when x0 > x1 or y0 > y1
+struct Box {
+	int x0, y0, x1, y1;
+	bool empty() const { return x0 > x1 || y0 > y1; }
+	static Box none() { Box b = { 0, 0, -1, -1 }; return b; }
+	Box unite(const Box& o) const
+	{
+		if (empty()) return o;
+		if (o.empty()) return *this;
+		Box b = { min(x0, o.x0), min(y0, o.y0), max(x1, o.x1), max(y1, o.y1) };
+		return b;
+	}
+	Box intersect(const Box& o) const
+	{
+		Box b = { max(x0, o.x0), max(y0, o.y0), min(x1, o.x1), min(y1, o.y1) };
+		return b;
+	}
+};
+// Framebuffer: one contiguous array of cells, row by row (stride col_).
+// A cell holds the brush's bytes packed into 32 bits (up to 4 bytes, enough
+// for one UTF-8 character), so no pixel owns a heap string.
 class Canvas {
 public:
 	Canvas(size_t row, size_t col);
@@ -10,15 +35,53 @@ public:
 	void Print();
 	void Clear();
 
-	string **can;
+	static uint32_t Brush(const string& bru);
+	// fill cells [x0, x1] of row y with cell, clipped to clip_
+	void FillSpan(int y, int x0, int x1, uint32_t cell);
+	uint32_t* Row(int y) { return &can[(size_t)y * col_]; }
+	// draws shapes in order (later ones on top), calling each known shape's
+	// rasterizer directly instead of through the virtual Draw
+	void DrawAll(const vector<Shape*>& shapes);
+
+	// Incremental redraw: MarkDirty records the area a scene change touched,
+	// and Redraw clears and re-rasterizes only the bounding box of those
+	// areas instead of the whole canvas.
+	void MarkDirty(const Box& box) { dirty_ = dirty_.unite(box); }
+	void Redraw(const vector<Shape*>& shapes);
+	// For a terminal: the first call clears the screen and prints the whole
+	// canvas at the top; later calls rewrite, by cursor addressing, only the
+	// redrawn rows that differ from what is on screen.
+	void PrintChanged();
+	// the screen no longer shows the canvas (e.g. other output scrolled it)
+	void ForgetScreen() { shown_.clear(); }
+	Box Whole() const { Box b = { 0, 0, col_ - 1, row_ - 1 }; return b; }
+
+	vector<uint32_t> can;
 	int row_, col_;
+	Box clip_;	// FillSpan writes only inside this box
+private:
+	char* FormatRow(int i, char* p);
+
+	vector<char> line_;	// Print's output buffer for one row
+	Box dirty_;	// changed since the last Redraw
+	Box pending_;	// redrawn since the last PrintChanged
+	vector<uint32_t> shown_;	// what PrintChanged left on screen
 };
+// Each shape rasterizes itself row by row: Fill computes the clipped span
+// of every row that lies inside the canvas' clip_ and fills it in one go.
 class Shape {
 public:
+	enum Kind { OTHER, RECT, TRI_UP, TRI_DOWN, DIAMOND };
+	Shape();
 	virtual ~Shape();
 	virtual void Draw(Canvas* canvas) {};
 	virtual void print();
+	Kind kind() const { return _kind; }
+	Box bounds() const { return _box; }	// every cell Draw may touch
 protected:
+	Kind _kind;
+	Box _box;
+	uint32_t _cell;	// _bru packed by Canvas::Brush
 	string _bru;
 	int _x, _y;
 	int _hei,_wid;
@@ -29,6 +92,7 @@ public:
 	// ǥ
 	~Rectangle();
 	virtual void Draw(Canvas* canvas);
+	void Fill(Canvas* canvas) const;
 	virtual void print();
 	
 
@@ -39,6 +103,7 @@ public:
 	//߰ ǥ
 	~UpTriangle();
 	virtual void Draw(Canvas* canvas);
+	void Fill(Canvas* canvas) const;
 	virtual void print();
 
 };
@@ -48,6 +113,7 @@ public:
 	//Ʒ߰ ǥ
 	~DownTriangle();
 	virtual void Draw(Canvas* canvas);
+	void Fill(Canvas* canvas) const;
 	virtual void print();
 
 };
@@ -57,6 +123,7 @@ public:
 	//߰ ǥ 
 	~Diamond();
 	virtual void Draw(Canvas* canvas);
+	void Fill(Canvas* canvas) const;
 	virtual void print();
 	
 };
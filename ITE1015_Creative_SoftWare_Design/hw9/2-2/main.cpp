@@ -4,7 +4,10 @@
 #include  "canvas.h"
 using namespace std;
 
-int main() {
+// "live" as the first argument: draw updates only the changed rows of a
+// canvas kept at the top of the terminal
+int main(int argc, char* argv[]) {
+	bool live = argc > 1 && string(argv[1]) == "live";
 	int garo, sero;
 	cin >> garo >> sero;
 	Canvas can(garo,sero);
@@ -26,6 +29,7 @@ int main() {
 	while (1) {
 		cin >> menu1;
 		if (menu1 == "add") {
+			size_t before = arr.size();
 			cin >> menu2;
 			if (menu2 == "rect") {
 				int top_left_x, top_left_y, width, height;
@@ -52,23 +56,24 @@ int main() {
 				arr.push_back(new DownTriangle(x,y, hei, bru));
 
 			}
+			if (arr.size() > before) can.MarkDirty(arr.back()->bounds());
 		
 		}
 		else if (menu1 == "delete") {
 			int index;
 			cin >> index;
 			vector<Shape *>::iterator it=arr.begin();
-			if(!(index>=arr.size()||index<0)) arr.erase(it + index);
+			if (!(index >= arr.size() || index < 0)) {
+				can.MarkDirty(arr[index]->bounds());
+				arr.erase(it + index);
+			}
 			
 
 		}
 		else if (menu1 == "draw") {
-			can.Clear();
-			for (int i = 0; i < arr.size(); i++)
-			{
-				arr[i]->Draw(&can);
-			}
-			can.Print();
+			can.Redraw(arr);
+			if (live) can.PrintChanged();
+			else can.Print();
 		}
 		else if (menu1 == "dump") {
 			for (int i = 0; i < arr.size(); i++)
@@ -77,6 +82,7 @@ int main() {
 				arr[i]->print();
 				
 			}
+			if (live) can.ForgetScreen();
 		}
 		else if (menu1 == "resize") {
 			int newHei, newWid;
@@ -0,0 +1,364 @@
+#include <lock_table.h>
+
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*
+ * Throughput / tail latency benchmark and stress test for the lock table.
+ *
+ * Every run spreads -n acquire/release pairs over the worker threads.
+ * Keys are drawn from one of three distributions:
+ *   uniform : every (table, record) pair is equally likely
+ *   zipf    : record ids follow a Zipfian distribution (theta = -z)
+ *   hot     : every thread hammers the same single record
+ *
+ * While a thread holds a lock it checks that nobody else is inside the
+ * same record and bumps a non-atomic counter, so a broken lock table shows
+ * up as an owner violation or a lost update at the end of the run.
+ *
+ * Output is one CSV line per (distribution, threads) run.
+ * usage : ./bench_lock_table [-t 1,2,4,...] [-d uniform,zipf,hot] [-n ops]
+ *                            [-k records] [-T tables] [-z theta] [-c work]
+ */
+
+#define MAX_THREAD_NUMBER		(64)
+#define MAX_RUN_NUMBER			(16)
+
+#define DEFAULT_OP_NUMBER		(200000)
+#define DEFAULT_RECORD_NUMBER	(10000)
+#define DEFAULT_TABLE_NUMBER	(1)
+#define DEFAULT_THETA			(0.99)
+
+enum { DIST_UNIFORM, DIST_ZIPF, DIST_HOT, DIST_NUMBER };
+
+static const char* dist_name[DIST_NUMBER] = { "uniform", "zipf", "hot" };
+
+/* benchmark parameters */
+int		thread_list[MAX_RUN_NUMBER] = { 1, 2, 4, 8, 16, 32, 64 };
+int		thread_list_number = 7;
+int		dist_list[DIST_NUMBER] = { DIST_UNIFORM, DIST_ZIPF, DIST_HOT };
+int		dist_list_number = DIST_NUMBER;
+long	op_number = DEFAULT_OP_NUMBER;
+int		record_number = DEFAULT_RECORD_NUMBER;
+int		table_number = DEFAULT_TABLE_NUMBER;
+double	theta = DEFAULT_THETA;
+int		work_loop = 0;
+
+/* Zipfian constants, Gray et al. "Quickly generating billion-record ..." */
+double	zipf_alpha;
+double	zipf_zetan;
+double	zipf_eta;
+
+/* This is shared data protected by the lock table. */
+int*	owner;
+long*	counter;
+
+/* state of a single run */
+int		cur_dist;
+long	op_per_thread;
+pthread_barrier_t	start_barrier;
+
+typedef struct worker_t {
+	pthread_t	thread;
+	int			id;
+	uint64_t	rand_state;
+	uint32_t*	latency;	/* acquire latency of each op, ns */
+	long		violation;
+} worker_t;
+
+worker_t	workers[MAX_THREAD_NUMBER];
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* xorshift64*, rand() takes a global lock and would serialize the workers */
+static uint64_t
+next_rand(uint64_t* s)
+{
+	uint64_t x = *s;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*s = x;
+	return x * 2685821657736338717ULL;
+}
+
+static double
+next_double(uint64_t* s)
+{
+	return (next_rand(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void
+zipf_init(int n, double th)
+{
+	double zeta2 = 0;
+	zipf_zetan = 0;
+	for (int i = 1; i <= n; i++) {
+		zipf_zetan += 1.0 / pow(i, th);
+		if (i == 2) zeta2 = zipf_zetan;
+	}
+	zipf_alpha = 1.0 / (1.0 - th);
+	zipf_eta = (1.0 - pow(2.0 / n, 1.0 - th)) / (1.0 - zeta2 / zipf_zetan);
+}
+
+static int
+zipf_next(uint64_t* s, int n)
+{
+	double u = next_double(s);
+	double uz = u * zipf_zetan;
+	if (uz < 1.0) return 0;
+	if (uz < 1.0 + pow(0.5, theta)) return 1;
+	int r = (int)(n * pow(zipf_eta * u - zipf_eta + 1.0, zipf_alpha));
+	return r < n ? r : n - 1;
+}
+
+static void
+pick_key(worker_t* w, int* table_id, int* record_id)
+{
+	switch (cur_dist) {
+	case DIST_UNIFORM:
+		*table_id = next_rand(&w->rand_state) % table_number;
+		*record_id = next_rand(&w->rand_state) % record_number;
+		break;
+	case DIST_ZIPF:
+		*table_id = next_rand(&w->rand_state) % table_number;
+		*record_id = zipf_next(&w->rand_state, record_number);
+		break;
+	default:
+		*table_id = 0;
+		*record_id = 0;
+		break;
+	}
+}
+
+/*
+ * This thread repeatedly locks a record, checks that it is alone inside,
+ * and releases it.
+ */
+void*
+worker_func(void* arg)
+{
+	worker_t*	w = (worker_t*)arg;
+	lock_t*		lock;
+	int			table_id;
+	int			record_id;
+	int			slot;
+	long		c;
+	uint64_t	t;
+
+	pthread_barrier_wait(&start_barrier);
+
+	for (long i = 0; i < op_per_thread; i++) {
+		pick_key(w, &table_id, &record_id);
+		slot = table_id * record_number + record_id;
+
+		t = now_ns();
+		lock = lock_acquire(table_id, record_id);
+		t = now_ns() - t;
+		w->latency[i] = t > UINT32_MAX ? UINT32_MAX : (uint32_t)t;
+		if (lock == NULL) {
+			w->violation++;
+			continue;
+		}
+
+		/* Nobody else may be inside this record. */
+		if (__atomic_exchange_n(&owner[slot], w->id + 1, __ATOMIC_ACQ_REL) != 0)
+			w->violation++;
+
+		/* Lost update if the lock does not exclude others. */
+		c = counter[slot];
+		for (volatile int k = 0; k < work_loop; k++)
+			;
+		counter[slot] = c + 1;
+
+		if (__atomic_exchange_n(&owner[slot], 0, __ATOMIC_ACQ_REL) != w->id + 1)
+			w->violation++;
+
+		lock_release(lock);
+	}
+
+	return NULL;
+}
+
+static int
+cmp_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a;
+	uint32_t y = *(const uint32_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+/* Returns the number of violations found in this run. */
+static long
+run(int dist, int thread_number)
+{
+	long		slot_number = (long)table_number * record_number;
+	long		total;
+	long		sum = 0;
+	long		bad = 0;
+	uint32_t*	all;
+	uint64_t	t;
+	double		sec;
+
+	cur_dist = dist;
+	op_per_thread = op_number / thread_number;
+	if (op_per_thread == 0) op_per_thread = 1;
+	total = op_per_thread * thread_number;
+
+	memset(owner, 0, sizeof(int) * slot_number);
+	memset(counter, 0, sizeof(long) * slot_number);
+	all = (uint32_t*)malloc(sizeof(uint32_t) * total);
+	if (all == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	pthread_barrier_init(&start_barrier, NULL, thread_number + 1);
+	for (int i = 0; i < thread_number; i++) {
+		workers[i].id = i;
+		workers[i].rand_state = 0x9E3779B97F4A7C15ULL * (i + 1) + dist;
+		workers[i].latency = all + op_per_thread * i;
+		workers[i].violation = 0;
+		pthread_create(&workers[i].thread, 0, worker_func, &workers[i]);
+	}
+
+	pthread_barrier_wait(&start_barrier);
+	t = now_ns();
+	for (int i = 0; i < thread_number; i++)
+		pthread_join(workers[i].thread, NULL);
+	sec = (now_ns() - t) / 1e9;
+	pthread_barrier_destroy(&start_barrier);
+
+	for (int i = 0; i < thread_number; i++)
+		bad += workers[i].violation;
+	for (long i = 0; i < slot_number; i++)
+		sum += counter[i];
+	if (sum != total) {
+		fprintf(stderr, "%s/%d : lost update, counter sum %ld != %ld\n",
+				dist_name[dist], thread_number, sum, total);
+		bad++;
+	}
+
+	qsort(all, total, sizeof(uint32_t), cmp_u32);
+	printf("%s,%d,%ld,%.3f,%.0f,%.2f,%.2f,%.2f,%.2f,%ld\n",
+			dist_name[dist], thread_number, total, sec, total / sec,
+			all[total / 2] / 1000.0,
+			all[total * 99 / 100] / 1000.0,
+			all[total * 999 / 1000] / 1000.0,
+			all[total - 1] / 1000.0, bad);
+	fflush(stdout);
+
+	free(all);
+	return bad;
+}
+
+static int
+parse_threads(char* s)
+{
+	thread_list_number = 0;
+	for (char* p = strtok(s, ","); p; p = strtok(NULL, ",")) {
+		int n = atoi(p);
+		if (n < 1 || n > MAX_THREAD_NUMBER || thread_list_number == MAX_RUN_NUMBER)
+			return FAIL;
+		thread_list[thread_list_number++] = n;
+	}
+	return thread_list_number ? SUCCESS : FAIL;
+}
+
+static int
+parse_dists(char* s)
+{
+	dist_list_number = 0;
+	for (char* p = strtok(s, ","); p; p = strtok(NULL, ",")) {
+		int d;
+		for (d = 0; d < DIST_NUMBER; d++)
+			if (strcmp(p, dist_name[d]) == 0) break;
+		if (d == DIST_NUMBER || dist_list_number == DIST_NUMBER)
+			return FAIL;
+		dist_list[dist_list_number++] = d;
+	}
+	return dist_list_number ? SUCCESS : FAIL;
+}
+
+static void
+usage(const char* name)
+{
+	fprintf(stderr,
+			"usage : %s [-t threads,...] [-d uniform,zipf,hot] [-n ops]\n"
+			"          [-k records] [-T tables] [-z theta] [-c work]\n"
+			"  -t  thread counts to sweep, 1-%d (default 1,2,4,8,16,32,64)\n"
+			"  -d  key distributions (default uniform,zipf,hot)\n"
+			"  -n  acquire/release pairs per run (default %d)\n"
+			"  -k  records per table (default %d)\n"
+			"  -T  tables (default %d)\n"
+			"  -z  zipf theta, 0 < theta < 1 (default %.2f)\n"
+			"  -c  busy loop iterations while holding a lock (default 0)\n",
+			name, MAX_THREAD_NUMBER, DEFAULT_OP_NUMBER, DEFAULT_RECORD_NUMBER,
+			DEFAULT_TABLE_NUMBER, DEFAULT_THETA);
+}
+
+int
+main(int argc, char* argv[])
+{
+	int		opt;
+	long	bad = 0;
+
+	while ((opt = getopt(argc, argv, "t:d:n:k:T:z:c:h")) != -1) {
+		switch (opt) {
+		case 't':
+			if (parse_threads(optarg) != SUCCESS) { usage(argv[0]); return 1; }
+			break;
+		case 'd':
+			if (parse_dists(optarg) != SUCCESS) { usage(argv[0]); return 1; }
+			break;
+		case 'n': op_number = atol(optarg); break;
+		case 'k': record_number = atoi(optarg); break;
+		case 'T': table_number = atoi(optarg); break;
+		case 'z': theta = atof(optarg); break;
+		case 'c': work_loop = atoi(optarg); break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+	if (op_number < 1 || record_number < 2 || table_number < 1 ||
+			theta <= 0 || theta >= 1 || work_loop < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	owner = (int*)calloc((long)table_number * record_number, sizeof(int));
+	counter = (long*)calloc((long)table_number * record_number, sizeof(long));
+	if (owner == NULL || counter == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	zipf_init(record_number, theta);
+	init_lock_table();
+
+	/* Touch every record once so no run pays for hash node creation. */
+	for (int i = 0; i < table_number; i++)
+		for (int j = 0; j < record_number; j++)
+			lock_release(lock_acquire(i, j));
+
+	printf("dist,threads,ops,sec,ops_per_sec,p50_us,p99_us,p999_us,max_us,violations\n");
+	for (int d = 0; d < dist_list_number; d++)
+		for (int i = 0; i < thread_list_number; i++)
+			bad += run(dist_list[d], thread_list[i]);
+
+	if (bad) {
+		fprintf(stderr, "FAIL : %ld violations\n", bad);
+		return 1;
+	}
+	return 0;
+}
@@ -7,7 +7,7 @@
 #include<fcntl.h>
 #include<string.h>
 #include<stdlib.h>
-#include<inttypes.h>//PRid64 - int64_t  
+#include<inttypes.h>//PRid64 - int64_t를 정수로 출력
 #include<sys/types.h>
 #include <stdbool.h>
 #include <sys/stat.h>
@@ -17,33 +17,60 @@
 #include "trx_manager.h"
 #include "lock_manager.h"
 #include "log_manager.h"
+#include "trace.h"
+#include "page_size.h"
 
-#define  PAGESIZE 4096
 ////////////
 #define FAIL -1
 #define SUCCESS 0 
 #define HEAD - 2
 #define TAIL -3
+////////////
+//버퍼 교체 정책
+#define BUF_LRU 0
+#define BUF_CLOCK 1
+#define BUF_LRU2 2
 /////////////
-#define leaf_order 31
-#define node_order 248
+//인터널 페이지 형식 (page_t.layout, 테이블 헤더의 node_layout)
+#define LAYOUT_BRANCH 0//key_child branch[node_order]
+#define LAYOUT_SEP 1//key[sep_order] / child[sep_order] 따로, child는 32bit page_num
+//리프 페이지 형식 (page_t.leaf_layout, 테이블 헤더의 leaf_layout)
+#define LEAF_RECORD 0//key_val record[leaf_order], 값은 val_max바이트 고정
+#define LEAF_SLOT 1//앞쪽 slot 디렉토리 + 뒤쪽 heap, 값은 길이만큼만
+#define PREFETCH_MAX 32//pagePrefetch가 한번에 읽는 페이지 수
+#define TABLE_CHUNK 64//table catalog를 이 개수씩 늘린다
+#define MERGE_FILL 25//리프가 이 비율(%)보다 덜 차면 merger가 옆 리프와 합친다
+#define MERGE_QUEUE 1024//merger가 기다리는 리프 수, 넘치면 버리고 다음 delete 때 다시 넣는다
+#define TABLE_MAX (TABLE_CHUNK * 1024)//한 버퍼에서 열 수 있는 테이블 수
+#define AHI_SIZE (1 << 16)//adaptive hash index 엔트리 수, 2의 거듭제곱
+#define AHI_HEAT 4096//db_find가 리프까지 내려간 횟수를 세는 칸 수, 2의 거듭제곱
+#define AHI_HOT 8//한 리프로 이만큼 내려간 뒤부터 그 리프에서 찾은 키를 adaptive hash index에 넣는다
+#define SCAN_RING 16//scan 힌트를 켠 쓰레드가 돌려 쓰는 프레임 수, db_scan은 리프를 이만큼 읽은 뒤부터 켠다
+#define SCAN_RING_MAX 256
+#define PSCAN_MAX 64//db_parallel_scan의 worker 수 상한
+#define PSCAN_SPLIT 4//db_parallel_scan이 구간을 나눌때 worker마다 이만큼의 separator가 모일때까지 인터널을 한 층씩 더 내려간다
+#define VERIFY_CHUNK 256//db_verify가 파일을 한번에 읽는 페이지 수
+#define VERIFY_TASK 4//db_verify가 쓰레드마다 나눠줄 subtree 수 (이만큼 나올때까지 루트쪽 층을 먼저 본다)
+#define VERIFY_THREAD_MAX 64
+#define VERIFY_REPORT 20//db_verify가 출력하는 오류 수, 넘는 것은 세기만 한다
 ////////////
 #define b_index b_M.frameArray[index]
-#define b_page b_M.frameArray[index].frame_p
+//table_id의 Table, 1 ~ table_total 사이여야 한다
+#define table_get(id) (&b_M.table[((id) - 1) / TABLE_CHUNK][((id) - 1) % TABLE_CHUNK])
+#define b_page (*b_M.frameArray[index].frame_p)
 ////////////
-#define b_head b_M.frameArray[head].frame_h
-#define b_root b_M.frameArray[root].frame_p
+#define b_head (*b_M.frameArray[head].frame_h)
+#define b_root (*b_M.frameArray[root].frame_p)
 ////////////////////
-#define b_leaf b_M.frameArray[leaf].frame_p
-#define b_parent b_M.frameArray[parent].frame_p
-#define b_child b_M.frameArray[child].frame_p
-#define b_nei b_M.frameArray[nei].frame_p
-#define b_right b_M.frameArray[right].frame_p
-#define b_left b_M.frameArray[left].frame_p
-#define b_page_parent b_M.frameArray[page_parent].frame_p
-#define b_old b_M.frameArray[old_p].frame_p
-#define b_new b_M.frameArray[new_p].frame_p
-pthread_mutex_t buf_latch ;
+#define b_leaf (*b_M.frameArray[leaf].frame_p)
+#define b_parent (*b_M.frameArray[parent].frame_p)
+#define b_child (*b_M.frameArray[child].frame_p)
+#define b_nei (*b_M.frameArray[nei].frame_p)
+#define b_right (*b_M.frameArray[right].frame_p)
+#define b_left (*b_M.frameArray[left].frame_p)
+#define b_page_parent (*b_M.frameArray[page_parent].frame_p)
+#define b_old (*b_M.frameArray[old_p].frame_p)
+#define b_new (*b_M.frameArray[new_p].frame_p)
 extern int ch;
 extern int op_fd;
 typedef uint64_t pagenum_t;
@@ -55,44 +82,88 @@ typedef struct queue {
 
 
 typedef struct record {
-	int64_t key;//64bit  
-	char val[120];
+	int64_t key;//64bit 정수 
+	char val[val_max];
 } key_val;
 
 
+//LEAF_SLOT의 slot, 값은 body[off]부터 len바이트('\0' 포함)
+typedef struct leaf_slot {
+	int64_t key;
+	uint16_t off;
+	uint16_t len;
+	uint32_t reserved;
+} leaf_slot;
+
+
 typedef struct key_child {
-	int64_t key; //8Ʈ
+	int64_t key; //8바이트
 	pagenum_t child;
 } key_child;
 
 
-typedef struct page_t { // 4096Byte
+typedef struct page_t { // PAGESIZE Byte
 	// in-memory page struccture
 	pagenum_t parent;
 	int is_leaf;
 	int num_key;
-	int64_t page_LSN;// ߰Ǵ 
-	char reserved[96];
-	pagenum_t right_left;//leaf  :   / internal  : 
+	int64_t page_LSN;//새로 추가되는 정보
+	char layout;//인터널 형식, LAYOUT_*
+	char leaf_layout;//리프 형식, LEAF_*
+	uint16_t heap;//LEAF_SLOT : heap 시작 위치(body 기준), 뒤에서 앞으로 자란다
+	uint16_t garbage;//LEAF_SLOT : 지우거나 늘리면서 버려진 heap 바이트
+	uint16_t dead_num;//리프 : db_delete가 지운 표시만 해둔 레코드 수
+	uint8_t dead[dead_bytes];//리프 : 지운 표시 bitmap, i번째 레코드는 dead[i / 8]의 i % 8번째 bit
+	uint32_t checksum;//[PAGE_CSUM_OFF] 디스크에 쓸때 채우는 CRC32C (이 4바이트는 빼고 계산), 0이면 확인하지 않는다
+	char reserved[PAGE_HEADER - PAGE_CSUM_OFF - 12];//4096이면 52
+	pagenum_t right_left;//leaf의 경우 : 오른쪽형제  / internal의 경우 : 왼쪽
 	union {
-		key_child branch[248]; //  key8+offset8 - 248
-		key_val record[31]; // key8+record120 - 31 
+		key_child branch[node_order]; //  key8+offset8
+		key_val record[leaf_order]; // key8+값 val_max
+		struct {
+			int64_t key[sep_order];
+			uint32_t child[sep_order];
+		} sep; // key8 + child4 sep_order개씩, 키끼리 붙어있어 이진탐색이 cache line을 덜 건드린다
+		leaf_slot slot[slot_max]; // LEAF_SLOT : 앞에서부터 slot
+		char body[leaf_body]; // LEAF_SLOT : 뒤에서부터 heap
 	};
 }page_t;
 
 
+//보조 인덱스 (따로 연 테이블), 엔트리 키는 값의 앞 len바이트와 primary key를 붙인 것
+#define INDEX_MAX 4//테이블 하나에 만들 수 있는 인덱스 수
+#define INDEX_LEN 4//엔트리 키에 넣는 값의 최대 바이트 수, primary key는 63 - 8*len 비트 안이어야 한다
+
+typedef struct index_desc {
+	int len;//값의 앞 몇 바이트로 찾는지 (1 ~ INDEX_LEN)
+	char path[124];//인덱스 테이블 파일
+}index_desc;
+
+//[] 안의 자리는 PAGESIZE 4096 기준, page_size/record_size까지는 크기와 상관없이 같은 자리
 typedef struct header_page {
 	pagenum_t free_page;//[0-7] free page offset
 	pagenum_t root_page;//[8-15] root page offset
 	int64_t page_num;// [16-23] number of pages
+	int node_layout;// [24-27] 인터널 형식, 이전 파일은 0(LAYOUT_BRANCH)
+	int leaf_layout;// [28-31] 리프 형식, 이전 파일은 0(LEAF_RECORD)
+	int page_size;// [32-35] 만든 빌드의 PAGESIZE, 이전 파일은 0(4096)
+	int record_size;// [36-39] 만든 빌드의 RECORD_SIZE, 이전 파일은 0(128)
+	char reserved0[PAGE_CSUM_OFF - 40];// [40-63]
+	uint32_t checksum;// [64-67] page_t.checksum과 같은 자리
+	int index_num;// [68-71] 만든 인덱스 수, 이전 파일은 0
+	index_desc index[INDEX_MAX];// [72-583]
 	
-	char reserved[4072];//reserved
+	char reserved[PAGESIZE - PAGE_CSUM_OFF - 8 - INDEX_MAX * sizeof(index_desc)];//reserved
 } header_page;
 
+#define PIN_EVICT (-1)//buffer_S.pin, victim으로 잡혀 내리는 중
+
+//프레임의 페이지는 b_M.page_region에 따로 모여있고 여기는 그 자리만 가리킨다
+//페이지끼리 붙어 있어야 huge page 하나에 512개가 들어가고 늘 PAGESIZE 정렬이 된다
 typedef struct bufferStructure {
 	union {
-		header_page frame_h;
-		page_t frame_p;
+		header_page * frame_h;
+		page_t * frame_p;
 	};
 
 	pagenum_t page_num;
@@ -101,9 +172,28 @@ typedef struct bufferStructure {
 	int next;
 	int pre;
 
+	//page table 체인 / free frame 리스트 (frame index, 없으면 -1)
+	int hash_next;
+	int free_next;
+	//이 프레임이 속한 partition
+	int part;
+
+	//교체 정책용 정보
+	//CLOCK : reference bit / LRU-2 : 최근 두번의 접근 시각(hist[1]이 0이면 한번만 접근)
+	bool ref;
+	uint64_t hist[2];
+
 	bool isdirty;
-	bool ispinned;
-	pthread_mutex_t page_latch;
+	bool scan;//scan 힌트로 올린 프레임, 다른 쪽이 접근해서 pageTouch가 불리면 0
+	//이 프레임을 쓰는 쪽의 수, atomic으로만 올리고 내린다
+	//pageVictim은 0일때만 CAS로 PIN_EVICT를 넣어 잡고, 그 뒤로는 pinTry가 실패한다
+	int pin;
+	int64_t rec_LSN;//이 프레임을 처음 dirty로 만든 로그의 LSN, 로그 없이 고쳤거나 clean이면 -1
+	bool flushing;//flusher가 복사본을 쓰는 중, 끝날때까지 victim에서 제외
+	//낙관적 탐색용 version, 홀수면 누가 고치는 중
+	//인터널/헤더를 고치거나 프레임의 페이지가 바뀔때 pageWriteBegin/End로 올린다
+	uint64_t version;
+	pthread_rwlock_t page_latch;//읽기는 S, 고칠때는 X
 
 }buffer_S;
 
@@ -112,27 +202,224 @@ typedef struct Table {
 	int id;
 	char * path;
 	int isopen;
+	int node_layout;//헤더에서 읽어온 인터널 형식
+	int leaf_layout;//헤더에서 읽어온 리프 형식
+	char * map;//open_table_mmap으로 연 읽기 전용 테이블이면 파일 전체를 mmap한 주소, 아니면 NULL
+	pagenum_t map_pages;//map 안의 페이지 수
+	int gen;//열때마다 바뀌는 값, 쓰레드마다 잡아둔 extent가 아직 이 테이블 것인지 본다
+	//insert/delete/merge처럼 트리 모양을 바꾸는 쪽끼리는 smo_latch로 줄을 세운다
+	//리프를 쪼개거나 merger가 합치는 동안 smo_seq는 홀수, reader는 시작할때 받아둔 값이 리프를 잡은 뒤에도 같은지 본다
+	pthread_mutex_t smo_latch;
+	uint64_t smo_seq;
+	//열때 헤더에서 읽어 같이 연 인덱스 테이블
+	int index_num;
+	int index_table[INDEX_MAX];
+	int index_len[INDEX_MAX];
+	//b_opt.warm일때 열면서 미리 읽는 페이지 목록, close_table이 쓰레드를 멈추고 푼다
+	pthread_t warm_th;
+	int warm_run;
+	int warm_stop;
+	pagenum_t * warm_page;
+	int warm_num;
+	int warm_done;//지금까지 올린 페이지 수
 }Table;
 
-typedef struct bufferManager {
-	Table table[10];
-	int table_use;
-	int table_total;
+//merger에게 넘긴 리프
+typedef struct merge_ent {
+	int table_id;
+	int gen;//넣을때의 Table.gen, 그 사이 다시 열렸으면 버린다
+	pagenum_t page_num;
+}merge_ent;
+
+//adaptive hash index 엔트리, key가 있는 리프와 그 안의 자리
+//version은 page version과 같은 방식 (홀수면 고치는 중), 찾은 뒤에는 늘 리프를 잡고 그 자리의 키를 다시 확인한다
+typedef struct ahi_ent {
+	uint64_t version;
+	int table_id;//0이면 빈 엔트리
+	int gen;//넣을때의 Table.gen, 그 사이 다시 열었으면 버린다
+	int64_t key;
+	pagenum_t page_num;
+	int64_t page_LSN;//넣을때 리프의 page_LSN, 지금도 같으면 slot을 그대로 쓰고 다르면 리프 안에서 다시 찾는다
+	int slot;
+}ahi_ent;
 
-	int frame_capacity;
+//frameArray를 나눈 partition, 자기 구간의 프레임만 관리한다
+//LRU 리스트랑 page eviction도 partition latch획득 이후 진행
+typedef struct bufferPartition {
+	pthread_mutex_t latch;
+
+	int begin;//[begin, end) 구간의 프레임
+	int end;
 	int use_num;
 
-	//LRU Ʈ page eviction buf latchȹ  
 	int LRU_head;
 	int LRU_tail;
-	buffer_S * frameArray;
+
+	//(table_id, page_num) -> frame index 해시, 버킷 수는 2의 거듭제곱
+	int * page_table;
+	int page_table_size;
+	//비어있는 프레임 리스트의 헤드
+	int free_head;
+
+	int hand;//CLOCK hand
+	uint64_t tick;//LRU-2 접근 시각
+	int node;//b_opt.numa일때 이 partition의 페이지를 둔 NUMA node 번호
+}buf_part;
+
+//page_region을 잡는 방법, 앞에서부터 되는 것을 쓴다
+#define HUGE_PAGE (2 * 1024 * 1024)
+#define REGION_PLAIN 0//보통 페이지
+#define REGION_THP 1//madvise(MADV_HUGEPAGE)로 transparent huge page를 부탁
+#define REGION_HUGETLB 2//MAP_HUGETLB로 미리 잡아둔 huge page
+
+typedef struct bufferManager {
+	Table * table[TABLE_MAX / TABLE_CHUNK];//TABLE_CHUNK개씩 필요할때 할당하고 옮기지 않는다, table_get으로 찾는다
+	int table_use;
+	int table_total;
+
+	int frame_capacity;
+	buffer_S * frameArray;//프레임의 메타데이터, 페이지는 frame_p가 가리킨다
+	char * page_region;//frame_capacity개 페이지, HUGE_PAGE 단위로 mmap
+	size_t region_size;
+	int region_huge;//REGION_HUGETLB / REGION_THP / REGION_PLAIN
+	int numa_node;//CPU가 있는 NUMA node 수, b_opt.numa가 아니거나 1이면 나누지 않는다
+	int numa_next;//bufBindThread가 다음 쓰레드를 묶을 node
+
+	buf_part * part;
+	int part_num;
+	int policy;//BUF_LRU, BUF_CLOCK, BUF_LRU2
+
+	//background flusher
+	pthread_t flusher;
+	int flusher_run;
+	pthread_mutex_t flush_latch;//flusher 한 회차 동안 잡는다, close_table과 겹치지 않게
+	pthread_cond_t flush_cond;
+
+	//flush 통계
+	uint64_t flush_round;
+	uint64_t flush_page;//flusher가 내린 페이지 수
+	uint64_t flush_write;//flusher의 pwritev 호출 수
+	uint64_t sync_write;//miss 경로의 pageDrop에서 직접 쓴 페이지 수
+
+	//background merger, db_delete로 덜 찬 리프를 옆 리프와 합친다
+	pthread_t merger;
+	int merger_run;
+	pthread_mutex_t merge_latch;//merge_q를 보호
+	pthread_cond_t merge_cond;
+	merge_ent merge_q[MERGE_QUEUE];//ring
+	int merge_head;
+	int merge_num;
+	uint64_t merge_done;//합쳐서 없앤 리프 수
+	uint64_t merge_moved;//옆 리프와 레코드를 나눠 가진 횟수
+
+	//b_opt.ahi일때 init_db가 잡는다, 아니면 NULL
+	ahi_ent * ahi;//(table_id, key) 해시로 자리를 정하는 direct-mapped 표, 겹치면 나중 것이 덮는다
+	uint8_t * ahi_heat;//(table_id, page_num) 해시 자리마다 리프까지 내려간 횟수
 
 }buffer_M;
 
 buffer_M b_M;
 
-//free page leaf/internal parent   ϵ Ѵ.
-//  ش.
+//init_db 전에 채워두는 버퍼 옵션, 0이면 기본값
+typedef struct bufferOption {
+	int part_num;//partition 개수, 기본 1
+	int policy;//교체 정책, 기본 BUF_LRU
+	int flush_clean;//partition마다 LRU tail쪽에 유지할 clean 프레임 수, 0이면 flusher 없음
+	int flush_ms;//flusher 주기, 기본 10ms
+	int readahead;//db_scan에서 순차 패턴일때 미리 읽을 리프 수, 기본 8
+	int node_layout;//새로 만드는 테이블의 인터널 형식, 기본 LAYOUT_BRANCH
+	int leaf_layout;//새로 만드는 테이블의 리프 형식, 기본 LEAF_RECORD
+	int redo_thread;//recovery redo 쓰레드 수, 기본 4
+	int ckpt_ms;//fuzzy checkpoint 주기, 0이면 recovery가 끝날때만 한다
+	int log_full;//1이면 update 로그에 new image를 xor 없이 그대로 남긴다
+	int dead_ms;//0이면 lock을 기다릴때마다 바로 deadlock 검사, 아니면 이 주기로 detector 쓰레드가 검사
+	int lock_timeout_ms;//lock을 이보다 오래 기다리면 abort, 0이면 계속 기다린다
+	int direct_io;//1이면 table 파일을 O_DIRECT로 열어 kernel page cache를 거치지 않는다
+	int io_uring;//1이면 flusher/readahead/find_batch의 여러 페이지 I/O를 io_uring으로 한번에 넘긴다
+	int extent_pages;//free list가 비었을때 파일 끝에서 한번에 잡는 페이지 수, 기본 FILE_EXTENT
+	int merge_fill;//db_delete 후 리프가 이 비율(%)보다 덜 차면 merger에게 넘긴다, 0이면 MERGE_FILL / 음수면 merger를 띄우지 않는다
+	int no_checksum;//1이면 페이지를 읽을때 checksum을 확인하지 않는다 (쓸때는 늘 채운다)
+	int compress;//1이면 새로 만드는 테이블을 페이지마다 압축해서 쓴다 (이미 있는 파일은 파일의 형식을 따른다)
+	//층을 하나씩 빼고 돌려 그 층의 비용을 잴때 쓴다, 둘다 0이 정상 동작
+	int no_lock;//1이면 record/table lock을 잡지 않는다 (latch는 그대로, 한 trx만 돌리거나 충돌이 없을때만 맞다)
+	int no_wal;//1이면 로그를 남기지 않는다 (abort가 되돌리지 못하고 recovery할 것도 없다)
+	int warm;//1이면 close_table이 버퍼에 남은 페이지 목록을 "<path>.warm"에 남기고 다시 열때 그 페이지들을 미리 읽는다
+	int numa;//1이면 partition을 NUMA node에 돌아가며 두고 trx를 시작하는 쓰레드를 node 하나에 묶는다
+	int elr;//1이면 commit 로그를 버퍼에 넣자마자 lock을 풀고, trx_commit은 로그가 내려간 뒤에 돌아온다
+	int update_batch;//0보다 크면 db_update를 trx에 이만큼(TRX_BATCH_MAX까지) 모았다가 로그 한번에 남기고 리프별로 묶어 쓴다
+	int scan_ring;//scan 힌트를 켠 쓰레드가 돌려 쓰는 프레임 수, 0이면 SCAN_RING / 음수면 힌트를 무시한다
+	int ahi;//1이면 db_find가 자주 내려가는 리프의 키를 adaptive hash index에 넣어두고 그 키는 트리를 내려가지 않고 찾는다
+	const char * trace_path;//DB_TRACE 빌드에서 shutdown_db가 trace를 남길 파일, NULL이면 남기지 않는다
+}buf_option;
+
+buf_option b_opt;
+
+//db_stats 통계, 쓰레드마다 자기 stat_local에만 더하고 읽는 쪽이 모든 쓰레드 것을 더한다
+//더하는 쪽은 하나뿐이라 atomic add 없이 relaxed store로 충분하다
+#define STAT_ADD(v, n) __atomic_store_n(&(v), (v) + (n), __ATOMIC_RELAXED)
+#define STAT_BUF_LATCH 0//buffer partition latch
+#define STAT_LOCK_LATCH 1//lock table의 stripe latch, table lock latch
+#define STAT_LATCH 2
+
+//테이블별 버퍼 통계
+typedef struct stat_table {
+	uint64_t hit;
+	uint64_t miss;//디스크에서 읽어 올린 페이지 수 (prefetch 포함)
+	uint64_t evict;//새 페이지 자리를 만드려고 내린 페이지 수
+	uint64_t dirty_write;//pageDrop과 flusher가 디스크에 쓴 dirty 페이지 수
+	uint64_t bad_page;//읽을때 checksum이 맞지 않았던 페이지 수
+	uint64_t ahi_hit;//db_find가 adaptive hash index로 바로 리프를 찾은 수
+	uint64_t ahi_build;//db_find가 adaptive hash index에 넣은 키 수
+	uint64_t ring_reuse;//scan ring에서 내리고 다시 쓴 프레임 수 (evict에는 더하지 않는다)
+	uint64_t cursor_hit;//db_cursor가 잡아둔 리프에서 바로 이어 읽은 수
+	uint64_t cursor_descend;//db_cursor가 루트부터 다시 내려간 수
+}stat_table;
+
+typedef struct stat_local {
+	stat_table * table[TABLE_MAX / TABLE_CHUNK];//TABLE_CHUNK개씩 처음 쓸때 할당, 읽는 쪽이 보고 있을 수 있어 풀지 않는다
+	uint64_t latch_wait[STAT_LATCH];//trylock에 실패해서 기다린 횟수
+	uint64_t latch_ns[STAT_LATCH];//그때 기다린 시간
+	uint64_t lock_wait;//record/table lock을 기다린 횟수
+	uint64_t lock_ns;
+	uint64_t dead_abort;//deadlock으로 abort된 횟수
+	uint64_t timeout_abort;//lock_timeout_ms가 지나 abort된 횟수
+	int used;//쓰레드가 끝나면 0, 다음에 만들어지는 쓰레드가 그대로 이어 쓴다
+	struct stat_local * next;
+}stat_local;
+
+//db_stats 결과, init_db 이후 누적
+typedef struct db_stat {
+	stat_table total;//모든 테이블의 합
+	uint64_t latch_wait[STAT_LATCH];
+	uint64_t latch_ns[STAT_LATCH];
+	uint64_t lock_wait;
+	uint64_t lock_ns;
+	uint64_t dead_abort;
+	uint64_t timeout_abort;
+	uint64_t log_byte;//잡힌 로그 바이트
+	double sec;//init_db 이후 지난 시간
+	double log_byte_sec;
+}db_stat;
+
+//db_verify 결과
+typedef struct verify_stat {
+	uint64_t page_num;//헤더의 page_num (헤더 포함)
+	int depth;//루트부터 리프까지의 층 수, 빈트리면 0
+	uint64_t leaf;
+	uint64_t internal;
+	uint64_t record;//리프의 레코드 수 (dead 포함)
+	uint64_t dead;//지운 표시만 된 레코드 수
+	uint64_t free;//free list의 페이지 수
+	uint64_t unused;//트리에도 free list에도 없는 페이지 (쓰레드가 잡아둔 extent에 남았거나 잃어버린 페이지)
+	uint64_t leaf_jump;//리프 체인에서 다음 리프가 바로 뒤 페이지가 아닌 횟수
+	double leaf_fill;//리프의 평균 채움 비율 (LEAF_SLOT은 바이트로)
+	double internal_fill;
+	uint64_t error;
+	double sec;
+}verify_stat;
+
+//free page는 leaf/internal의 parent 영역을 같이 사용하도록 한다.
+//헤더만 따로 구현해준다.
 
 
 
@@ -146,36 +433,156 @@ void menu();
 void freeInfo(int tableid);
 void headInfo(int tableid);
 void bufInfo();
+void flushInfo();
+void mergeInfo();
+void statInfo();
+void verifyInfo(int table_id, int nthreads);
 
 ////////////////////////////////////
-//3 insert db  װɷ 
+//프3껄로 insert한 db생성 후 그걸로 진행하자
 int db_find(int table_id, int64_t key, char*ret_val, int trx_id);
 int db_update(int table_id, int64_t key, char * val, int trx_id);
+//write batch에 모아둔 update를 로그 자리 한번에 남기고 리프별로 묶어 페이지에 쓴다 (trx_commit, batch가 찰때)
+int db_wbatch_flush(Trx * t);
+int db_delete(int table_id, int64_t key);
+int db_insert_trx(int table_id, int64_t key, char * value, int trx_id);
+int leaf_locate(int table_id, pagenum_t page_num, int64_t key, int * i);
+
+//통계
+uint64_t stat_ns();
+stat_local * stat_get();
+stat_table * stat_table_get(int table_id);
+void stat_latch(pthread_mutex_t * latch, int kind);
+void stat_lock_wait(uint64_t start_ns);
+void stat_lock_abort(int dead);
+void stat_reset();
+int db_stats(db_stat * out);
+int db_table_stats(int table_id, stat_table * out);
 int find_page(int tableid, int64_t key,int trx_id,int mode);
+int find_leaf_olc(int tableid, int64_t key, int trx_id, int mode, pagenum_t * leaf_num);
+int leaf_search(const page_t * pg, int num_key, int64_t key);
+int leaf_find(const page_t * pg, int64_t key);
+int node_search(const page_t * pg, int num_key, int64_t key);
+int node_cap(int layout);
+int64_t node_key(const page_t * pg, int i);
+pagenum_t node_child(const page_t * pg, int i);
+void node_set(page_t * pg, int i, int64_t key, pagenum_t child);
+int64_t leaf_key(const page_t * pg, int i);
+char * leaf_val(page_t * pg, int i);
+void leaf_init(page_t * pg, int leaf_layout);
+int leaf_fits(const page_t * pg, const char * val);
+void leaf_insert(page_t * pg, int i, int64_t key, const char * val);
+int leaf_update(page_t * pg, int i, const char * val);
+void leaf_remove(page_t * pg, int i);
+int leaf_dead(const page_t * pg, int i);
+//0이 아닌 값을 리턴하면 scan을 멈춘다
+typedef int (*scan_callback)(int64_t key, const char * val);
+int db_scan(int table_id, int64_t begin_key, int64_t end_key, scan_callback callback, int trx_id);
+//db_parallel_scan의 callback, worker는 레코드를 읽은 worker 번호 (0 ~ nworkers - 1)
+typedef int (*pscan_callback)(int worker, int64_t key, const char * val);
+int db_parallel_scan(int table_id, int64_t lo, int64_t hi, int nworkers, pscan_callback fn);
+int db_find_batch(int table_id, const int64_t * keys, int n, char ** out, int trx_id);
+int db_create_index(int table_id, char * index_path, int prefix_len);
+int db_verify(int table_id, int nthreads, verify_stat * out);
+
+//db_find_ref / db_update_ref가 잡아둔 리프, db_ref_release로 놓는다
+typedef struct rec_ref {
+	int frame;//잡은 프레임, 놓을 것이 없으면 -1
+	int update;//1이면 X로 잡은 update
+	int table_id;
+	int64_t key;
+	int slot;//리프 안의 자리
+	int trx_id;
+	struct lock_t * lock;//update가 받은 X lock
+	char copy[val_max];//update는 바꾸기 전 값, snapshot trx는 되돌려 읽은 값
+}rec_ref;
+int db_find_ref(int table_id, int64_t key, const char ** val, rec_ref * ref, int trx_id);
+int db_update_ref(int table_id, int64_t key, char ** val, int * cap, rec_ref * ref, int trx_id);
+int db_ref_release(rec_ref * ref);
+
+//db_cursor_seek / db_cursor_next가 마지막으로 넘겨준 자리
+//호출 사이에는 리프 프레임의 pin만 남겨 evict되지 않게 하고 latch는 놓는다, db_cursor_close로 놓는다 (close_table 전에)
+typedef struct db_cursor {
+	int table_id;
+	int trx_id;
+	int frame;//pin을 잡아둔 리프 프레임, 없으면 -1
+	pagenum_t page_num;
+	int slot;//마지막으로 넘겨준 레코드의 리프 안 자리
+	int64_t page_LSN;//그때 리프의 page_LSN, 같으면 slot을 그대로 쓰고 다르면 리프 안에서 다시 찾는다
+	uint64_t smo;//리프를 찾을때의 smo_seq, 그 뒤로 split/merge가 없었으면 그 리프가 그대로 같은 키 범위를 맡는다
+	int64_t key;//마지막으로 넘겨준 키
+	int valid;//key가 있으면 1
+}db_cursor;
+int db_cursor_open(db_cursor * c, int table_id, int trx_id);
+int db_cursor_seek(db_cursor * c, int64_t key, int64_t * found, char * val);
+int db_cursor_next(db_cursor * c, int64_t * found, char * val);
+int db_cursor_close(db_cursor * c);
+int db_find_index(int table_id, int index_no, const char * prefix, scan_callback callback, int trx_id);
 ////////////////////////////////////////
 
-//  Ŵ -> ispinnedõȰ 
+//여기부터 버퍼 매니저 -> ispinned관련된거 수정
 
 int init_db(int buf_num, int flag, int log_num, char* log_path, char* logmsg_path);
 int open_table(char *pathname);
+int open_table_layout(char *pathname, int node_layout, int leaf_layout);
+int open_table_mmap(char *pathname);
+int table_isopen(int table_id);
 int close_table(int table_id);
 int shutdown_db();
+int bufBindThread();
 ////////////////////
 int pageDrop(int index);
 int pageScan(int table, pagenum_t pagenum);
+int pageScanShared(int table, pagenum_t pagenum);
+int pagePrefetch(int table_id, const pagenum_t * pages, int n);
 int pageLoad(int index);
+int bufScanHint(int on);
+
+int pageEvict(int index);
+
+int pageOptFind(int table_id, pagenum_t page_num);
+uint64_t pageReadBegin(int index);
+int pageReadValidate(int index, uint64_t v);
+void pageWriteBegin(int index);
+void pageWriteEnd(int index);
+void * flusher_func(void * arg);
+void * merger_func(void * arg);
+int flushPart(buf_part * p, page_t * buf);
+void pageTouch(int index);
+int pageVictim(buf_part * p);
+
+uint64_t pageHash(int table_id, pagenum_t page_num);
+buf_part * pagePart(int table_id, pagenum_t page_num);
+int pageTableFind(buf_part * p, int table_id, pagenum_t page_num);
+void pageTableInsert(int index);
+void pageTableRemove(int index);
+void freePush(int index);
+int freePop(buf_part * p);
 
 int pinCheck();
 
 void setPage(int table_id, pagenum_t page_num, int index);
 void setDirty(int index);
+void setDirtyLSN(int index, int64_t LSN);
 void clearDirty(int index);
 void setPin(int index);
+int pinTry(int index);
+int pinClaim(int index);
+void pinUnclaim(int index);
+int pinCount(int index);
 void clearPin(int index);
+void pageLatch(int index);
+void pageLatchShared(int index);
+void pageUnlatch(int index);
 ////////
 int insert_into_new_root(int tableid ,pagenum_t l, int64_t key, pagenum_t r);
 int start_new_tree(int tableid,int64_t key,char * val) ;
+//레코드를 하나씩 채워주고 1, 끝이면 0 리턴
+typedef int (*bulk_next)(key_val * rec);
+int db_bulk_load(int table_id, int64_t n, bulk_next next, int fill);
 int db_insert(int tableid,int64_t key, char * value) ;
+int db_insert_base(int tableid, int64_t key, char * value);
+int db_delete_base(int table_id, int64_t key);
 int make_leaf_page(int tableid);
 int get_left_index(int tableid,pagenum_t p, pagenum_t l);
 int insert_into_leaf(int tableid,pagenum_t l, int64_t key, char * val);
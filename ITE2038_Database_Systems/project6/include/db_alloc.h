@@ -0,0 +1,28 @@
+#ifndef __DB_ALLOC_H__
+#define __DB_ALLOC_H__
+#include <stddef.h>
+
+//자주 만들고 지우는 고정 크기 객체의 할당
+//make MM=1이면 CSE4009 assignment2의 mm.c로 빌드해서 종류마다 mm_pool 하나에서 잘라 쓴다
+//쓰레드마다 종류별 free list를 앞에 두어 pool latch는 DB_OBJ_CACHE개씩 넘칠때만 잡는다
+//MM이 없으면 malloc/free 그대로
+enum db_obj {
+	DB_OBJ_TRX,//Trx
+	DB_OBJ_TLOCK,//tlock_t
+	DB_OBJ_MVCC_WRITER,//mvcc_writer
+	DB_OBJ_MVCC_VER,//mvcc_ver
+	DB_OBJ_MVCC_KEY,//mvcc_key
+	DB_OBJ_INDEX_DEL,//index_del
+	DB_OBJ_VALUE,//val_max 바이트 값 버퍼
+	DB_OBJ_NUM
+};
+
+#define DB_OBJ_CACHE 64//쓰레드가 종류마다 쥐고 있는 객체 수 상한
+
+//size는 종류마다 항상 같아야 한다 (처음 부를때 pool을 만든다)
+void * db_obj_alloc(enum db_obj kind, size_t size);
+void db_obj_free(enum db_obj kind, void * p);
+//돌려주지 않는 큰 slab (lock_t, Node), MM이면 mm 힙에서
+void * db_slab_alloc(size_t size);
+
+#endif
@@ -7,25 +7,60 @@
 #include<fcntl.h>
 #include<string.h>
 #include<stdlib.h>
-#include<inttypes.h>//PRid64 - int64_t  
+#include<inttypes.h>//PRid64 - int64_t를 정수로 출력
 #include<sys/types.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <stdint.h>
 #include <unistd.h>
 
-//8Ʈ ũ 
+//8바이트 크기의 정수형선언
+
+#define FILE_RING 64//쓰레드마다 두는 io_uring의 queue depth
+#define FILE_EXTENT 64//file_alloc_page가 파일 끝에서 한번에 잡는 페이지 수
+
+//file_submit으로 한번에 넘기는 I/O 하나, 디스크에서 이어진 cnt개 페이지
+typedef struct file_io {
+	int fd;
+	pagenum_t page_num;
+	page_t ** pages;//cnt개, 메모리에서는 이어지지 않아도 된다
+	int cnt;
+	int write;//1이면 write
+	int res;//끝난 뒤 SUCCESS/FAIL
+	void * arg;//done에 넘길 값
+}file_io;
+
+//io 하나가 끝날때마다 부른다 (io_uring이면 끝난 순서대로)
+typedef void (*file_done)(file_io * io);
 
 
 
 
 // Allocate an on-disk page from the free page list
 pagenum_t file_alloc_page(int table_id);
+// Give back the pages left in this thread's extent (close_table)
+void file_extent_release(int table_id);
 // Free an on-disk page to the free page list
 void file_free_page(int table_id, pagenum_t pagenum);
-// Read an on-disk page into the in-memory page structure(dest)
-void file_read_page(int table_id, pagenum_t pagenum, page_t* dest);
-// Write an in-memory page(src) to the on-disk page
-void file_write_page(int table_id, pagenum_t pagenum, const page_t* src);
+// Read an on-disk page into the in-memory page structure(dest), FAIL if its checksum does not match
+int file_read_page(int table_id, pagenum_t pagenum, page_t* dest);
+// Write an in-memory page(src) to the on-disk page, filling in its checksum
+void file_write_page(int table_id, pagenum_t pagenum, page_t* src);
+// Write cnt in-memory pages to the consecutive on-disk pages starting at pagenum
+int file_write_pages(int table_fd, pagenum_t pagenum, page_t** src, int cnt);
+// Submit n I/Os at once (io_uring when b_opt.io_uring, else one preadv/pwritev each) and wait for all of them
+int file_submit(file_io * io, int n, file_done done);
+// CRC32C of a page without its checksum field
+uint32_t page_checksum(const page_t * page);
+// Set up a just opened table file : a new one(create) gets the compressed format when b_opt.compress, an old one is checked for it and for its page geometry
+int file_open_table(int table_fd, int create);
+// FAIL if a table header's page_size/record_size differ from this build (0 means an old 4096/128 file)
+int file_geometry_check(int table_fd, const header_page * h);
+// Drop the compressed page map of a table file before closing it
+void file_close_table(int table_fd);
+// 1 if the first page of a table file is the header of the compressed format
+int file_compressed_image(const void * first_page);
+// Pages written, bytes used and slot moves of a compressed table file, FAIL if it is not compressed
+int file_compress_info(int table_fd, uint64_t * pages, uint64_t * bytes, uint64_t * relocate);
 
 #endif
@@ -10,9 +10,28 @@
 
 #define FAIL -1
 #define SUCCESS 0
-#define LOAD_FACTOR 20
+#define LOAD_FACTOR 2//bucket당 평균 노드 수가 이보다 많아지면 bucket 하나를 split
+#define LOCK_STRIPE 1024//lock table latch 수 (처음 bucket 수와 같음, 2의 거듭제곱)
+#define LOCK_SEGMENT 1024//segment 하나의 bucket 수
+#define LOCK_MAX_SEGMENT 8192//bucket은 LOCK_SEGMENT * LOCK_MAX_SEGMENT개까지 늘어난다
+#define LOCK_SLAB 64//pool이 비었을때 한번에 만드는 lock_t, Node 수
+#define LOCK_POOL_MAX 256//쓰레드 pool의 lock_t가 이보다 많아지면 반을 공용 pool로 넘긴다
+#define LOCK_SUPREMUM INT64_MAX//다음 키가 없을때 next-key lock을 거는 키 (트리의 끝)
+#define TLOCK_TABLE 64//table lock queue 수, table_id % TLOCK_TABLE번 queue에 여러 table이 같이 들어간다
+#define LOCK_FAST 4//Node마다 stripe latch 없이 S를 줄 수 있는 자리 수
+#define LOCK_CACHE 64//쓰레드마다 기억하는 (table_id, key)의 Node와 이 trx의 lock 수 (2의 거듭제곱)
+
+//table lock mode, record lock 전에 S는 IS, X는 IX를 table에 먼저 잡는다
+//table 전체를 S(SIX)로 잡으면 record S lock, X로 잡으면 record lock을 모두 건너뛴다
+#define TLOCK_NONE 0
+#define TLOCK_IS 1
+#define TLOCK_IX 2
+#define TLOCK_S 3
+#define TLOCK_SIX 4
+#define TLOCK_X 5
 
 typedef struct lock_t lock_t;
+typedef struct tlock_t tlock_t;
 typedef struct Node Node;
 typedef struct HashNode HashNode;
 typedef struct HashTable HashTable;
@@ -21,65 +40,102 @@ typedef struct lock_t {
 
 	lock_t *pre;
 	lock_t *next;
-	pthread_cond_t cond; // ̰ ߿ ּǮ
-	Node * node_ptr; // ̰ õȰ 
+	int park;//futex word, 자는 쪽이 latch 안에서 1로 두고 깨우는 쪽이 latch 안에서 0으로 바꾼 뒤 깨운다
+	Node * node_ptr; // 이거 관련된거 수정
 	int lock_mode;
 	lock_t *trx_next_lock;
 	int owner_txn_id;
-	// Ž  ȸ   -> Abort=ش txn lock release 
-	//-> update/find Լ return abortϷ -> 
-	// ڵ undo & lock Ʈ ع & شTxn  ̺ 
+	//데드락 탐지를 위한 순회 가능  -> Abort=해당 txn꺼 lock전부 release 
+	//-> update/find 함수내에서 return전에 abort완료 -> 
+	//수정된 레코드 undo & lock 오브젝트 해방 & 해당Txn 를 테이블에서 삭제
 
 	int change;
 	int sleep;
+	int victim;//detector가 deadlock victim으로 골랐다, stripe latch 안에서 쓴다
+	int upgrade;//S를 받은채 X를 기다리는 중, 뒤에서 자던 lock에게는 아직 S로 보인다
+	int fast;//0이 아니면 Node의 fast[fast - 1] 자리로 받은 S, 줄에는 없다
 
 
 
 }lock_t;
 
+//table lock, 한 trx는 table마다 하나를 갖고 upgrade도 그 자리에서 mode만 올린다
+typedef struct tlock_t {
+	tlock_t * pre;
+	tlock_t * next;
+	pthread_cond_t cond;
+	int table_id;
+	int owner_txn_id;
+	int mode;//기다리는 중이면 받으려는 mode
+	int held;//이미 받은 mode, 처음 기다리는 중이면 TLOCK_NONE
+	int sleep;
+	tlock_t * trx_next_lock;//trx의 table lock 리스트
+}tlock_t;
+
 typedef struct Node {
 	int table_id;
 	int64_t record_id;//key
 
-	lock_t * tail; // 
-	lock_t * head; // 
+	lock_t * tail; //헤드 락
+	lock_t * head; //테일 락
 
 	Node * next;
+	pthread_mutex_t * latch;//노드가 속한 stripe latch, split으로 bucket이 바뀌어도 그대로다
+
+	//줄이 비어있는 동안 S는 fast 자리에 trx id를 CAS로 넣어 latch 없이 받는다
+	//fast 자리의 trx는 줄의 다른 lock에게 이미 받은 S로 보인다
+	int closed;//줄에 lock이 있으면 1, 그 동안은 fast 자리를 새로 주지 않는다 (stripe latch 안에서만 바꾼다)
+	int fast[LOCK_FAST];//fast S를 가진 trx id, 빈 자리는 0
 
 }Node;
 
 typedef struct HashNode {
-	Node * nodeList; //Node 迭 Ű 
+	Node * nodeList; //Node 배열을 가리키는 포인터
 	int key;
 	int node_num;
 
 }HashNode;
 
 
+//linear hashing, (table_id, record_id)의 hash h로 bucket을 찾는다
+//bucket 수는 LOCK_STRIPE << level + split, split보다 앞의 bucket은 이미 둘로 나뉘어 한 bit 더 본다
+//bucket 번호의 아래 bit가 h의 아래 bit이므로 h & (LOCK_STRIPE - 1) latch 하나가 bucket과 거기서 split된 bucket을 같이 보호한다
 typedef struct HashTable {
-	HashNode ** table;//HashNode 迭 Ű 
-	int size;
+	HashNode ** table;//segment 배열, segment 하나는 LOCK_SEGMENT개의 HashNode (옮겨지지 않는다)
+	int size;//bucket 수
+	uint64_t state;//level << 32 | split, split이 끝날때 한번에 바꾼다
+	int64_t node_num;//전체 노드 수
+	pthread_mutex_t split_latch;//split은 한번에 하나만
+	pthread_mutex_t latch[LOCK_STRIPE];//stripe latch, 그 stripe의 nodeList와 lock list, lock의 sleep을 보호
 }HashTable;
 
 
 HashTable * createHashTable(int size); 
 Node* hashSearch(HashTable * hash_t, int table_id,int64_t r_id);
 int hashInsert(HashTable * hash_t, int table_id,int64_t r_id);
+int hashSplit(HashTable * hash_t);
 int hashPrint(HashTable * hash_t);
-int getKey(int64_t r_id,int table_size);
+uint64_t getKey(int table_id, int64_t r_id);
+pthread_mutex_t * hashLatch(HashTable * hash_t, int table_id, int64_t r_id);
 
 
 /* APIs for lock table */
-int init_lock_table();//굵  
-int lock_release(lock_t* lock_obj);//굵 
-
-lock_t* lock_acquire(int table_id, int64_t key,int trx_id, int lock_mode);//߰  trxid  õȰ 
-int lock_abort(lock_t * lock);//굵
+int init_lock_table();//얘도 조금 수정
+int lock_release(lock_t* lock_obj);//얘도 수정, stripe latch를 잡은채로 부른다
+void lock_wake(lock_t * lock);//자던 lock을 깨운다, sleep/victim을 바꾼 뒤 stripe latch를 잡은채로 부른다
+void lock_release_all(lock_t * head);//trx의 lock list를 stripe latch를 잡아가며 해제
+
+lock_t* lock_acquire(int table_id, int64_t key,int trx_id, int lock_mode);//모드추가 및 trxid 정보 관련된거 수정
+int lock_abort(lock_t * lock);//얘도
+int lock_busy(int table_id, int64_t key);//record에 잡혀있거나 기다리는 lock이 있으면 1
+int lock_table(int table_id, int trx_id, int mode);//table lock을 mode까지 올린다, 기다리다 deadlock이면 abort하고 ABORT
+void lock_table_release_all(tlock_t * head);//trx의 table lock 리스트 해제
+int lock_table_busy(int table_id);//table에 잡혀있거나 기다리는 table lock이 있으면 1
+extern const int tlock_sup[6][6];
 void show_lock_list(int64_t key,int table_id);
 
 void show_lock_list(int64_t key, int table_id);
 
-pthread_mutex_t lock_table_latch;
 HashTable * hash_t;
 
 #endif 
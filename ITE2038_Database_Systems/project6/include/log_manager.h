@@ -6,26 +6,41 @@
 #include<fcntl.h>
 #include<string.h>
 #include<stdlib.h>
-#include<inttypes.h>//PRid64 - int64_t  
+#include<inttypes.h>//PRid64 - int64_t를 정수로 출력
 #include<sys/types.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <pthread.h>
+#include "page_size.h"
 
 int log_fd;
+int log_msg_fd;//recovery 진행 메세지
+int log_master_fd;//마지막 checkpoint 위치 (<log_path>.ckpt)
 
-//̹ Ʈ end offset 
+//이번 프로젝트는 end offset 사용
 
 #define BEGIN 0
 #define UPDATE 1
 #define COMMIT 2
 #define ROLLBACK 3
 #define COMPENSATE 4
+#define CKPT_BEGIN 5
+#define CKPT_END 6
+#define INSERT 7//logical insert, key와 new image만 담는다
+#define INSERT_CLR 8//insert를 되돌린 compensate, 그 키에 지운 표시를 한다
 
 #define BCR_SIZE 28
-#define UP_SIZE 288
-#define COM_SIZE 296
+#define LOG_IMAGE val_max//image 최대 길이 (leaf value 크기)
+#define LOG_FULL 0xFFFF//d_off가 이 값이면 new image를 xor하지 않고 그대로 담는다
+
+#define LOG_HEAD 24//LSN, pre_LSN, trx_id, type
+#define LOG_READ_SIZE (1 << 20)//recovery에서 로그 파일을 한번에 읽는 크기
+#define REDO_QUEUE 256//redo 쓰레드 하나가 받아둘 수 있는 레코드 수
+#define REDO_SEEN_BITS 10//redo prefetch에서 최근에 본 페이지 표 크기 (2^bits)
+#define SHIP_MAX 8//primary에 동시에 붙을 수 있는 replica 수
+#define SHIP_CHUNK (1 << 16)//shipper가 한번에 읽어 보내는 크기
 
 
 
@@ -51,10 +66,11 @@ typedef struct type_update {
 
 	int table_id;
 	int64_t page_num;
+	int64_t key;//redo/undo는 key로 레코드를 찾는다 (page_num은 처음 찾아볼 리프)
 	int off;
 	int data_len;
-	char old_image[120];
-	char new_image[120];
+	char old_image[LOG_IMAGE];
+	char new_image[LOG_IMAGE];
 	int log_size;
 
 }type_update;
@@ -69,39 +85,123 @@ typedef struct type_compen {
 
 	int table_id;
 	int64_t page_num;
+	int64_t key;
 	int off;
 	int data_len;
-	char old_image[120];
-	char new_image[120];
+	char old_image[LOG_IMAGE];
+	char new_image[LOG_IMAGE];
 	int64_t next_undo_LSN;
 	int log_size;
 
 }type_compen;
 
-typedef struct log_bufferStructure {
-	union {
-		type_BCR frame_BCR;
-		type_update frame_update;
-		type_compen frame_compensate;
+//update, compensate, insert가 파일에 쓰이는 모양, 메모리에서는 type_update/type_compen으로 풀어서 쓴다
+//헤더 뒤에 (compensate, insert clr이면 next_undo_LSN,) old image old_len바이트,
+//new image new_len바이트 또는 old와 xor한 [d_off, d_off + d_len) 구간이 오고, 마지막은 레코드 크기(int)
+typedef struct log_packed {
+
+	int64_t LSN;
+	int64_t pre_LSN;
+	int trx_id;
+	int type;
+
+	int table_id;
+	int off;
+	int64_t page_num;
+	int64_t key;
+	uint16_t old_len;
+	uint16_t new_len;
+	uint16_t d_off;
+	uint16_t d_len;
+
+}log_packed;
 
-	};
+#define LOG_MAX_SIZE ((int)sizeof(log_packed) + 8 + 2 * LOG_IMAGE + 4)//가장 큰 레코드 (xor하지 않은 compensate)
 
+//fuzzy checkpoint의 end 레코드, 뒤에 att_num개의 ckpt_att와 dpt_num개의 ckpt_dpt가 붙는다
+//begin 레코드는 trx_id가 0인 type_BCR
+typedef struct type_ckpt {
+
+	int64_t LSN;
+	int64_t pre_LSN;//짝이 되는 CKPT_BEGIN의 LSN
+	int trx_id;
 	int type;
-	int next;
-	int pre;
 
+	int log_size;//뒤에 붙는 표까지 포함한 전체 크기
+	int att_num;
+	int dpt_num;
+	int table_max;//그때까지 열린 가장 큰 table_id
+	int trx_max;//그때까지 나간 가장 큰 trx id
+	int reserved;
 
-}log_buffer_S;
+}type_ckpt;
 
-typedef struct log_bufferManager {
+//active transaction table 한칸
+typedef struct ckpt_att {
+	int trx_id;
+	int reserved;
+	int64_t lastLSN;
+}ckpt_att;
 
-	int frame_capacity;
-	int use_num;
-	int log_now;	
+//dirty page table 한칸, rec_LSN은 그 페이지를 처음 dirty로 만든 로그
+typedef struct ckpt_dpt {
+	int table_id;
+	int reserved;
+	int64_t page_num;
+	int64_t rec_LSN;
+}ckpt_dpt;
+
+//파일에서 읽어온 레코드 하나, 앞부분(LSN~type)은 모든 형식이 같다
+//checkpoint end는 헤더만 들어간다
+typedef union log_record {
+	type_BCR bcr;
+	type_update update;
+	type_compen compen;
+	type_ckpt ckpt;
+}log_rec;
+
+typedef struct log_bufferManager {
 
-	log_buffer_S * logRecords;
-	int head;
-	int tail;
+	//로그 버퍼는 파일 offset을 그대로 접어넣은 byte ring (크기는 2의 거듭제곱)
+	//자리는 log_now에 fetch-add로 잡고, 레코드는 ring에 바로 복사한다
+	char * ring;
+	int64_t ring_size;
+	int64_t log_now;//여기까지 자리가 잡힌 LSN
+	int64_t filled_LSN;//여기까지는 ring에 다 복사됨 (앞 레코드부터 순서대로 올라간다)
+
+	//group commit
+	//파일에 쓰는건 log flusher 하나만 하고, latch는 기다릴때만 잡는다
+	pthread_mutex_t latch;
+	pthread_cond_t flush_cond;//flusher를 깨운다
+	pthread_cond_t done_cond;//flushed_LSN이 올라가면 기다리던 쪽을 깨운다
+	pthread_t flusher;
+	int flusher_run;
+	int64_t flush_req;//여기까지 내려달라고 요청된 LSN
+	int64_t flushed_LSN;//여기까지는 fdatasync까지 끝남
+	//early lock release (b_opt.elr), commit 로그가 내려가기 전에 lock을 푼 trx 중 가장 큰 commit LSN
+	int64_t elr_LSN;
+
+	//flush 통계
+	uint64_t flush_round;//pwrite + fdatasync 횟수
+	uint64_t flush_byte;//내려간 바이트 수
+
+	//fuzzy checkpoint, ckpt_ms마다 checkpointer가 log_checkpoint를 부른다
+	pthread_t checkpointer;
+	pthread_cond_t ckpt_cond;
+	int ckpt_run;
+	int ckpt_ms;
+	int64_t ckpt_LSN;//마지막 checkpoint begin의 LSN
+	int64_t trunc_off;//여기 앞의 로그 파일 공간은 비웠다
+	uint64_t ckpt_num;
+
+	//log shipping, replica마다 shipper 쓰레드가 fdatasync까지 끝난 로그를 파일 offset 그대로 보낸다
+	//ship_off는 그 replica에 다음에 보낼 offset (-1이면 빈칸), log_truncate는 가장 작은 것 앞까지만 비운다
+	int ship_fd;//listen socket
+	int ship_run;
+	int ship_num;//살아있는 shipper 수, 끝날때 done_cond로 알린다
+	pthread_t ship_acceptor;
+	int ship_conn[SHIP_MAX];
+	int64_t ship_off[SHIP_MAX];
 
 }log_buffer_M;
 
@@ -110,18 +210,38 @@ log_buffer_M log_M;
 int open_log(char * log_path);
 int open_msg_log(char*log_msg_path);
 int init_log_buf(int capacity);
+int close_log();
 
-int log_to_file_BCR(int trx_id, int log_fd, type_BCR * log);
-int log_to_file_UP(int trx_id, int log_fd, type_update * log);
-int log_to_file_COM(int trx_id, int log_fd, type_compen * log);
+//LSN까지 로그가 디스크에 내려갈때까지 기다린다 (group commit)
+int log_flush(int64_t LSN);
+void log_elr(int64_t LSN);
+void * log_flusher_func(void * arg);
+void logFlushInfo();
 
-int read_log_file(int mode);
+int log_read(int64_t LSN, log_rec * rec);
 
 int log_BCR(int trx_id,int type);
-int log_compensate(int trx_id, int table_id, int64_t page_num, int target_log,int record_off);
-int log_update(int trx_id,int table_id,int64_t page_num,char* old_image,char* new_image,int record_off);
-
-
+int log_checkpoint();
+int log_checkpoint_start(int ms);
+
+//log shipping : primary는 port에서 replica를 받아 내려간 로그를 계속 보낸다, close_log가 멈춘다
+//replica는 받은 로그 중 commit된 trx만 자기 trx로 다시 실행하므로 snapshot trx로 읽으면 primary의 어느 commit 시점과 같다
+//replica에서는 snapshot trx로 읽기만 한다, 테이블은 primary와 같은 순서로 먼저 열어둔다
+//state_path에 다시 받을 offset과 마지막으로 적용한 commit LSN을 남기고, 없으면 from부터 받는다
+int log_ship_start(int port);
+int log_replica_start(const char * host, int port, const char * state_path, int64_t from);
+void log_replica_stop();
+int log_compensate(int trx_id, const type_update * target);
+int log_update(int trx_id,int table_id,int64_t page_num,int64_t key,char* old_image,char* new_image,int record_off);
+int log_insert(int trx_id, int table_id, int64_t page_num, int64_t key, const char * value);
+typedef struct wbatch_ent wbatch_ent;
+void log_update_batch(int trx_id, const wbatch_ent * e, int n, int64_t * LSN);
+
+
+
+//LSN의 레코드를 되돌리고 다음에 되돌릴 LSN을 돌려준다 (-1이면 그 trx는 끝)
+//insert는 그 키에 지운 표시를 하므로 smo_latch를 잡을 수 있다, latch를 잡지 않은 채로 부른다
+int64_t log_undo(int trx_id, int64_t LSN, int * type);
 
 void recovery_redo(int log_num);
 void recovery_undo(int log_num);
@@ -0,0 +1,32 @@
+#ifndef __PAGE_SIZE_H__
+#define __PAGE_SIZE_H__
+
+//페이지/레코드 크기, make PAGE=8192 RECORD=256 처럼 빌드할때 정한다 (-DPAGESIZE, -DRECORD_SIZE)
+//나머지 order와 page_t 배치는 전부 여기서 계산되고, 파일 헤더에 남겨 다른 크기로 만든 파일은 열지 않는다
+//크기를 바꾸면 make clean 후 다시 빌드해야 한다 (.o는 플래그가 바뀐 걸 모른다)
+
+#ifndef PAGESIZE
+#define PAGESIZE 4096
+#endif
+#ifndef RECORD_SIZE
+#define RECORD_SIZE 128//LEAF_RECORD 레코드 하나, key 8바이트 + 값
+#endif
+
+#if PAGESIZE < 4096 || PAGESIZE > 65536 || (PAGESIZE & (PAGESIZE - 1))
+#error "PAGESIZE must be a power of two between 4096 and 65536"
+#endif
+#if RECORD_SIZE < 16 || RECORD_SIZE % 8 || RECORD_SIZE > PAGESIZE / 32
+#error "RECORD_SIZE must be a multiple of 8 between 16 and PAGESIZE / 32"
+#endif
+
+#define PAGE_HEADER (PAGESIZE / 32)//페이지 헤더, 4096이면 128바이트
+#define leaf_body (PAGESIZE - PAGE_HEADER)//페이지 헤더를 뺀 나머지
+#define val_max (RECORD_SIZE - 8)//값의 최대 길이('\0' 포함)
+#define leaf_order (leaf_body / RECORD_SIZE)//LEAF_RECORD 레코드 수, 4096이면 31
+#define node_order (leaf_body / 16)//LAYOUT_BRANCH 엔트리 수, 4096이면 248
+#define sep_order (leaf_body / 12)//LAYOUT_SEP 엔트리 수, 4096이면 330
+#define slot_max (leaf_body / 16)//LEAF_SLOT slot 수의 상한
+#define dead_bytes ((slot_max + 31) / 32 * 4)//지운 표시 bitmap, 4096이면 32바이트
+#define PAGE_CSUM_OFF (32 + dead_bytes)//page_t/header_page의 checksum 자리, 4096이면 64
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+//hot path tracing, make TRACE=1 (-DDB_TRACE)로 빌드했을때만 남는다
+//아니면 TRACE_START/TRACE는 아무것도 남기지 않으므로 인자도 계산하지 않는다
+//쓰레드마다 자기 ring에만 쓰고 (lock 없음), trace_dump가 모든 쓰레드 것을 binary 파일로 남긴다
+//trace2json이 그 파일을 Chrome trace(JSON)로 바꾼다 -> chrome://tracing, ui.perfetto.dev
+
+#define TRACE_RING 16384//쓰레드마다 남기는 event 수 (2의 제곱), 넘치면 오래된 것부터 덮는다
+#define TRACE_MAGIC 0x3145434152544244ULL//"DBTRACE1"
+
+//event 종류, a/b의 뜻
+enum {
+	TRACE_LATCH,//partition/lock table latch를 기다림, a = STAT_BUF_LATCH/STAT_LOCK_LATCH
+	TRACE_PAGE_LATCH,//page latch를 잡음 (dur은 기다린 시간), a = frame, b = 1이면 X
+	TRACE_PAGE_UNLATCH,//page latch를 놓음, a = frame
+	TRACE_LOCK_WAIT,//record/table lock을 기다림, a = table_id, b = key (table lock이면 -1)
+	TRACE_PAGE_MISS,//디스크에서 페이지를 읽어 올림, a = table_id, b = page_num
+	TRACE_LOG_FLUSH,//log flusher의 pwrite + fdatasync 한번, a = 바이트, b = 내린 마지막 LSN
+	TRACE_LOG_WAIT,//commit 등에서 log가 내려가길 기다림, a = LSN
+	TRACE_KIND
+};
+
+//파일에 그대로 쓰이는 event 하나, 32바이트
+typedef struct trace_ev {
+	uint64_t ts;//시작 시각 (stat_ns)
+	uint32_t dur;//걸린 시간 ns, 순간 event는 0
+	uint16_t kind;
+	uint16_t tid;//trace ring 번호, 쓰레드가 끝나면 다음 쓰레드가 이어 쓴다
+	int64_t a;
+	int64_t b;
+}trace_ev;
+
+//파일 형식 : trace_file 다음 ring마다 trace_head와 n개의 trace_ev (시간순)
+typedef struct trace_file {
+	uint64_t magic;
+	uint32_t ring_num;
+	uint32_t ev_size;
+}trace_file;
+
+typedef struct trace_head {
+	uint32_t tid;
+	uint32_t n;
+}trace_head;
+
+#ifdef DB_TRACE
+#define TRACE_START(t) uint64_t t = stat_ns()
+#define TRACE(kind, t, a, b) trace_event((kind), (t), (int64_t)(a), (int64_t)(b))
+#else
+#define TRACE_START(t)
+#define TRACE(kind, t, a, b) ((void)0)
+#endif
+
+//t가 0이면 순간 event
+void trace_event(int kind, uint64_t t, int64_t a, int64_t b);
+//DB_TRACE 없이 빌드했으면 FAIL
+int trace_dump(const char * path);
+
+#endif
@@ -1,27 +1,67 @@
 #ifndef __TRX_MANAGER_H__
 #define __TRX_MANAGER_H__
 #include "lock_manager.h"
-//#include <windows.h>//Sleep(1000)=1
+#include "page_size.h"
+//#include <windows.h>//Sleep(1000)=1초
 typedef struct Trx_m Trx_m;
 typedef struct Trx Trx;
+typedef struct mvcc_writer mvcc_writer;
+typedef struct index_del index_del;
+typedef struct wbatch_ent wbatch_ent;
 
-// ũ Ʈ  
+#define TRX_BATCH_MAX 256//b_opt.update_batch의 상한, 한번에 남기는 로그가 log ring에 들어가야 한다
+#define TRX_HASH 1024//trx id로 찾는 hash의 bucket 수 (2의 거듭제곱), id가 차례로 나오므로 chain이 거의 없다
+
+//더블 링크드 리스트로 구현, 순회는 리스트로 하고 id로 찾는건 hash로 한다
 typedef struct Trx_m {
-	int64_t global_trx_id;//ũ ̵ 
+	int64_t global_trx_id;//유니크 아이디 제공
 	Trx* trx_table_head;
 	Trx* trx_table_tail;
+	Trx* trx_hash[TRX_HASH];//trx_id & (TRX_HASH - 1), hash_next로 잇는다
 
 }Trx_m;
 
 typedef struct Trx {
-	int trx_id;//ڽ ũ ̵
-	lock_t * trx_lock_head;//ڽ txn ϴ lock 
-	Trx * next;//txn 
-	Trx* pre;//txn
+	int trx_id;//자신의 유니크 아이디
+	lock_t * trx_lock_head;//자신의 txn가 수행하는 lock을 연결
+	lock_t * trx_lock_tail;//마지막 lock, trx_lock이 리스트를 따라가지 않고 붙인다
+	Trx * next;//다음txn 
+	Trx* pre;//이전txn
+	Trx* hash_next;//같은 hash bucket의 다음 trx
 	int state;//1=running 2=commiting 3=aborting
 	int lastLSN;
+	int firstLSN;//begin 로그의 LSN, checkpoint가 이 앞의 로그는 지우지 않는다
+	int * wait_for;//기다리는 lock 앞에 있던 lock들의 주인 (wait-for 그래프의 간선), trx_latch로 보호
+	int wait_num;
+	int wait_cap;
+	lock_t * wait_lock;//detector 모드에서 기다리는 lock, detector가 victim을 깨울때 쓴다
+	pthread_mutex_t * wait_latch;//wait_lock의 stripe latch
+	int64_t snap;//snapshot trx면 begin때의 commit seq, 아니면 -1
+	Trx * snap_pre;//진행중인 snapshot trx 리스트 (snap 순서)
+	Trx * snap_next;
+	mvcc_writer * mv;//update한 trx의 commit seq, 덮어쓴 version들이 같이 가리킨다
+	tlock_t * tlock_head;//잡은 table lock
+	index_del * index_head;//update로 값이 바뀌어 commit때 지울 인덱스 엔트리
+	wbatch_ent * wbatch;//b_opt.update_batch일때 아직 페이지에 쓰지 않은 update, 처음 쓸때 잡는다
+	int wbatch_num;
 }Trx;
 
+//write batch의 update 하나, X lock은 stage할때 받아 commit까지 잡는다
+typedef struct wbatch_ent {
+	int table_id;
+	int off;//stage때 리프 안 자리, page_num과 같이 로그에 hint로만 남는다
+	int64_t key;
+	int64_t page_num;
+	char old_image[val_max];//stage때 페이지 값, 같은 키를 다시 고치면 그대로 두고 new만 바꾼다
+	char new_image[val_max];
+}wbatch_ent;
+
+typedef struct index_del {
+	int table_id;//인덱스 테이블
+	int64_t key;
+	index_del * next;
+}index_del;
+
 
 Trx_m T_M;
 
@@ -31,19 +71,36 @@ Trx_m T_M;
 #define ABORT -4
 #define CYCLE -5
 
-//ϳ find_page  ؿ Լ   -> ̰ ȭ^^ + acquire պ
-//ϳ  ϰ ݿϳ   + q&a 󺸱
-//ϵ  Ͽϵ   Űۼ
+#define MVCC_HASH 4096//version chain hash의 bucket 수 (2의 거듭제곱)
+#define MVCC_STRIPE 256//version chain latch 수
+#define MVCC_ABORTED -1//abort한 writer의 csn, 그 version은 건너뛴다
+
+//수요일날 find_page랑 그 밑에 함수는 다 수정 -> 이게제일 화날듯^^ + acquire좀더 손보기
+//목요일날 남은거 마무리하고 금요일날 디버깅 시작 + q&a 영상보기
+//토요일도 디버깅 일요일도 디버깅 후 위키작성
 
 int trx_init();
 int trx_begin();
+int trx_begin_snapshot();//read only, lock 없이 begin 시점에 commit된 값만 읽는다
+int mvcc_push(int table_id, int64_t key, const char * old_image, int trx_id);
+int mvcc_read(int table_id, int64_t key, char * val, int64_t snap);
+void mvccInfo();
 int trx_commit(int trx_id);
-int checkDead(lock_t * front,int back_id);
+int trx_index_del(int trx_id, int table_id, int64_t del_key, int64_t keep_key);
+int checkDead(int back_id, const int * wait_for, int wait_num);
+int trx_wait_set(int back_id, const int * wait_for, int wait_num, lock_t * lock);
+void trx_wait_clear(int trx_id);
+void trx_wait_add(const int * ids, int num, int blocker);
+int trx_detector_start(int ms);
+void trx_detector_stop();
+void deadInfo();
 int trx_abort(int trx_id);
 int trx_lock(int trx_id, lock_t * lock);
 Trx* trx_find(int trx_id);
-int trx_dead_check(lock_t* obj,int back_id);
-int trx_cycle(lock_t* obj,int back_id);
+Trx* trx_get(int trx_id);
+void trx_set_id(int64_t trx_id);
+Trx* trx_restore(int trx_id, int lastLSN);
+int trx_remove(int trx_id);
 int trx_duplicate(lock_t* obj,int back_id);
 int trx_error(lock_t* obj);
 void printTrx();
@@ -0,0 +1,306 @@
+#include "lock_manager.h"
+#include "file.h"
+#include "trx_manager.h"
+#include "buf_manager.h"
+
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+//여러 쓰레드가 find/update로 이루어진 trx를 돌리는 벤치마크
+//결과는 CSV 한 줄, -o로 파일을 주면 뒤에 이어 붙여서 회차별로 모아 볼 수 있다
+//
+//./bench -t 8 -k 100000 -z 0.9 -r 80 -b 4000 -l 10 -d 10 -o result.csv
+//-L/-W로 lock/로그 층을 빼고 같은 부하를 돌려 두 결과의 차이로 그 층의 비용을 본다
+//-L은 충돌이 없어야 값이 맞으므로 -t 1이나 -r 100으로 돌린다
+//make TRACE=1로 빌드하고 -T를 주면 끝날때 trace를 남긴다, ./trace2json bench.trace > bench.json
+
+typedef struct bench_opt {
+	int threads;//trx 쓰레드 수
+	int64_t keys;//미리 넣어두는 레코드 수, key는 0 ~ keys-1
+	double theta;//Zipf skew, 0이면 uniform
+	int read_pct;//한 연산이 find일 확률(%), 나머지는 update
+	int frames;//버퍼 프레임 수
+	int trx_len;//trx 하나의 연산 수
+	int sec;//측정 시간
+	int part_num;//버퍼 partition 수
+	int no_checksum;//1이면 페이지를 읽을때 checksum을 확인하지 않는다
+	int compress;//1이면 테이블을 압축 형식으로 만든다
+	int no_lock;//1이면 lock manager를 빼고 돌린다
+	int no_wal;//1이면 로그를 남기지 않고 돌린다
+	int numa;//1이면 partition을 NUMA node에 나눠 두고 쓰레드를 node에 묶는다
+	int elr;//1이면 commit에서 로그가 내려가기 전에 lock을 푼다
+	int update_batch;//0보다 크면 update를 trx에 이만큼 모았다가 한번에 로그를 남기고 쓴다
+	int ahi;//1이면 adaptive hash index를 켠다
+	char * path;//테이블 파일, 로그는 뒤에 .log/.msg를 붙인다
+	char * out;//NULL이면 stdout
+	char * trace;//DB_TRACE 빌드에서 trace를 남길 파일
+}bench_opt;
+
+static bench_opt opt = { 4, 10000, 0.0, 50, 1000, 10, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0, "bench.db", NULL, NULL };
+
+//Gray et al.의 Zipf 생성기, 인자를 한번 계산해두고 쓰레드끼리 나눠 쓴다
+//rank가 작을수록 자주 나오고 rank를 그대로 key로 쓴다 (hot key가 앞쪽 리프에 모인다)
+typedef struct zipf_t {
+	int64_t n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+	double half;//1 + 0.5^theta
+}zipf_t;
+
+static zipf_t zipf;
+
+static void zipf_init(zipf_t * z, int64_t n, double theta)
+{
+	z->n = n;
+	z->theta = theta;
+	if (theta == 0) return;
+	double zeta2 = 1 + pow(0.5, theta);
+	z->zetan = 0;
+	for (int64_t i = 1; i <= n; i++) z->zetan += 1 / pow((double)i, theta);
+	z->alpha = 1 / (1 - theta);
+	z->eta = (1 - pow(2.0 / n, 1 - theta)) / (1 - zeta2 / z->zetan);
+	z->half = zeta2;
+}
+
+//쓰레드마다 따로 쓰는 xorshift64*
+static uint64_t rng_next(uint64_t * s)
+{
+	*s ^= *s >> 12;
+	*s ^= *s << 25;
+	*s ^= *s >> 27;
+	return *s * 2685821657736338717ULL;
+}
+
+//[0, 1)
+static double rng_unit(uint64_t * s)
+{
+	return (rng_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int64_t zipf_next(const zipf_t * z, uint64_t * s)
+{
+	if (z->theta == 0) return (int64_t)(rng_next(s) % (uint64_t)z->n);
+	double u = rng_unit(s);
+	double uz = u * z->zetan;
+	if (uz < 1) return 0;
+	if (uz < z->half) return 1;
+	int64_t k = (int64_t)(z->n * pow(z->eta * u - z->eta + 1, z->alpha));
+	return k < z->n ? k : z->n - 1;
+}
+
+//쓰레드 하나의 결과, commit된 trx의 latency(ns)를 모은다
+typedef struct bench_local {
+	pthread_t th;
+	int id;
+	uint64_t commits;
+	uint64_t aborts;
+	uint64_t * lat;
+	size_t lat_num;
+	size_t lat_cap;
+}bench_local;
+
+static int table_id;
+static volatile int bench_stop;
+
+static void lat_push(bench_local * b, uint64_t ns)
+{
+	if (b->lat_num == b->lat_cap) {
+		size_t cap = b->lat_cap ? b->lat_cap * 2 : 4096;
+		uint64_t * p = (uint64_t*)realloc(b->lat, cap * sizeof(uint64_t));
+		if (!p) return;
+		b->lat = p;
+		b->lat_cap = cap;
+	}
+	b->lat[b->lat_num++] = ns;
+}
+
+static void * bench_thread_func(void * arg)
+{
+	bench_local * b = (bench_local*)arg;
+	uint64_t seed = 0x9E3779B97F4A7C15ULL * (b->id + 1) ^ stat_ns();
+	if (seed == 0) seed = 1;
+	char val[val_max];
+	char ret[val_max];
+
+	while (!bench_stop) {
+		uint64_t start = stat_ns();
+		int trx_id = trx_begin();
+		if (trx_id <= 0) {
+			b->aborts++;
+			continue;
+		}
+
+		//중간에 SUCCESS가 아니면 lock을 기다리다 abort된 것, 남아있으면 직접 abort
+		int ok = 1;
+		for (int i = 0; i < opt.trx_len && ok; i++) {
+			int64_t key = zipf_next(&zipf, &seed);
+			if ((int)(rng_next(&seed) % 100) < opt.read_pct) {
+				ok = db_find(table_id, key, ret, trx_id) == SUCCESS;
+			}
+			else {
+				snprintf(val, sizeof(val), "%d-%" PRIu64, b->id, b->commits);
+				ok = db_update(table_id, key, val, trx_id) == SUCCESS;
+			}
+		}
+		if (ok && trx_commit(trx_id) == trx_id) {
+			b->commits++;
+			lat_push(b, stat_ns() - start);
+		}
+		else {
+			if (trx_get(trx_id)) trx_abort(trx_id);
+			b->aborts++;
+		}
+	}
+	return NULL;
+}
+
+static int lat_cmp(const void * a, const void * b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+//정렬된 lat에서 p 분위수(us)
+static double lat_pct(const uint64_t * lat, size_t n, double p)
+{
+	if (n == 0) return 0;
+	return lat[(size_t)(p * (n - 1))] / 1000.0;
+}
+
+static void usage(const char * name)
+{
+	fprintf(stderr, "usage : %s [-t threads] [-k keys] [-z zipf theta] [-r read %%] [-b frames] [-l trx length]\n", name);
+	fprintf(stderr, "          [-d seconds] [-p partitions] [-C (skip checksum check)] [-Z (compressed table)]\n");
+	fprintf(stderr, "          [-L (no lock manager)] [-W (no log)] [-N (NUMA placement)] [-f table path] [-o csv file]\n");
+	fprintf(stderr, "          [-E (early lock release)] [-U update batch] [-A (adaptive hash index)] [-T trace file (make TRACE=1)]\n");
+}
+
+static int parse_opt(int argc, char ** argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "t:k:z:r:b:l:d:p:CZLWNEU:Af:o:T:h")) != -1) {
+		switch (c) {
+		case 't': opt.threads = atoi(optarg); break;
+		case 'k': opt.keys = atoll(optarg); break;
+		case 'z': opt.theta = atof(optarg); break;
+		case 'r': opt.read_pct = atoi(optarg); break;
+		case 'b': opt.frames = atoi(optarg); break;
+		case 'l': opt.trx_len = atoi(optarg); break;
+		case 'd': opt.sec = atoi(optarg); break;
+		case 'p': opt.part_num = atoi(optarg); break;
+		case 'C': opt.no_checksum = 1; break;
+		case 'Z': opt.compress = 1; break;
+		case 'L': opt.no_lock = 1; break;
+		case 'W': opt.no_wal = 1; break;
+		case 'N': opt.numa = 1; break;
+		case 'E': opt.elr = 1; break;
+		case 'U': opt.update_batch = atoi(optarg); break;
+		case 'A': opt.ahi = 1; break;
+		case 'f': opt.path = optarg; break;
+		case 'o': opt.out = optarg; break;
+		case 'T': opt.trace = optarg; break;
+		default: return FAIL;
+		}
+	}
+	//theta가 1이면 alpha가 발산한다
+	if (opt.threads < 1 || opt.keys < 2 || opt.theta < 0 || opt.theta >= 1 || opt.read_pct < 0 || opt.read_pct > 100
+		|| opt.frames < 8 || opt.trx_len < 1 || opt.sec < 1 || opt.part_num < 1 || opt.update_batch < 0) return FAIL;
+	return SUCCESS;
+}
+
+int main(int argc, char ** argv)
+{
+	if (parse_opt(argc, argv) != SUCCESS) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	//매번 빈 테이블과 빈 로그로 시작한다
+	char log_path[300], msg_path[300], ckpt_path[310];
+	snprintf(log_path, sizeof(log_path), "%s.log", opt.path);
+	snprintf(msg_path, sizeof(msg_path), "%s.msg", opt.path);
+	snprintf(ckpt_path, sizeof(ckpt_path), "%s.ckpt", log_path);
+	unlink(opt.path);
+	unlink(log_path);
+	unlink(msg_path);
+	unlink(ckpt_path);
+
+	b_opt.part_num = opt.part_num;
+	b_opt.no_checksum = opt.no_checksum;
+	b_opt.compress = opt.compress;
+	b_opt.no_lock = opt.no_lock;
+	b_opt.no_wal = opt.no_wal;
+	b_opt.numa = opt.numa;
+	b_opt.elr = opt.elr;
+	b_opt.update_batch = opt.update_batch;
+	b_opt.ahi = opt.ahi;
+	b_opt.trace_path = opt.trace;
+	if (init_db(opt.frames, 0, 0, log_path, msg_path) != SUCCESS) return 1;
+	table_id = open_table(opt.path);
+	if (table_id == FAIL) return 1;
+	char val[val_max];
+	for (int64_t k = 0; k < opt.keys; k++) {
+		snprintf(val, sizeof(val), "%" PRId64, k);
+		db_insert(table_id, k, val);
+	}
+	zipf_init(&zipf, opt.keys, opt.theta);
+
+	//적재가 쓴 통계는 빼고 측정한다
+	stat_reset();
+	bench_local * b = (bench_local*)calloc(opt.threads, sizeof(bench_local));
+	uint64_t start = stat_ns();
+	for (int i = 0; i < opt.threads; i++) {
+		b[i].id = i;
+		pthread_create(&b[i].th, 0, bench_thread_func, &b[i]);
+	}
+	sleep(opt.sec);
+	bench_stop = 1;
+	for (int i = 0; i < opt.threads; i++) pthread_join(b[i].th, NULL);
+	double sec = (stat_ns() - start) / 1e9;
+
+	db_stat s;
+	db_stats(&s);
+
+	uint64_t commits = 0, aborts = 0;
+	size_t n = 0;
+	for (int i = 0; i < opt.threads; i++) {
+		commits += b[i].commits;
+		aborts += b[i].aborts;
+		n += b[i].lat_num;
+	}
+	uint64_t * lat = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+	n = 0;
+	for (int i = 0; i < opt.threads; i++) {
+		memcpy(lat + n, b[i].lat, b[i].lat_num * sizeof(uint64_t));
+		n += b[i].lat_num;
+		free(b[i].lat);
+	}
+	qsort(lat, n, sizeof(uint64_t), lat_cmp);
+
+	//파일이 비어있을때만 헤더를 쓴다
+	FILE * fp = opt.out ? fopen(opt.out, "a") : stdout;
+	if (!fp) {
+		perror(opt.out);
+		return 1;
+	}
+	if (!opt.out || ftell(fp) == 0)
+		fprintf(fp, "threads,keys,zipf,read_pct,frames,trx_len,sec,commits,aborts,tps,abort_rate,p50_us,p99_us,p999_us,hit_rate,lock_wait,dead_abort,log_byte_sec\n");
+	uint64_t get = s.total.hit + s.total.miss;
+	fprintf(fp, "%d,%" PRId64 ",%.3f,%d,%d,%d,%.3f,%" PRIu64 ",%" PRIu64 ",%.1f,%.4f,%.1f,%.1f,%.1f,%.4f,%" PRIu64 ",%" PRIu64 ",%.0f\n",
+		opt.threads, opt.keys, opt.theta, opt.read_pct, opt.frames, opt.trx_len, sec,
+		commits, aborts, commits / sec, commits + aborts ? (double)aborts / (commits + aborts) : 0.0,
+		lat_pct(lat, n, 0.50), lat_pct(lat, n, 0.99), lat_pct(lat, n, 0.999),
+		get ? (double)s.total.hit / get : 0.0, s.lock_wait, s.dead_abort, s.log_byte_sec);
+	if (opt.out) fclose(fp);
+
+	free(lat);
+	free(b);
+	shutdown_db();
+	return 0;
+}
@@ -1,15 +1,21 @@
 
+#define _GNU_SOURCE//O_DIRECT
 #include<stdio.h>
 #include<fcntl.h>
 #include<string.h>
 #include<stdlib.h>
-#include<inttypes.h>//PRid64 - int64_t  
+#include<inttypes.h>//PRid64 - int64_t를 정수로 출력
 #include<sys/types.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <limits.h>//PATH_MAX
 #include "file.h"
 #include "buf_manager.h"
 #include "lock_manager.h"
@@ -20,202 +26,737 @@
 
 
 
-//⼭ ۶  ۾ 
-int find_page(int tableid, int64_t key,int trx_id,int mode) {
+//버퍼에 올라와있는 페이지를 latch 없이 찾는다, 없으면 -1
+//체인이 중간에 바뀔 수 있으므로 결과는 pageReadBegin 이후 version으로 확인해야 한다
+int pageOptFind(int table_id, pagenum_t page_num)
+{
+	buf_part * p = pagePart(table_id, page_num);
+	int i = __atomic_load_n(&p->page_table[pageHash(table_id, page_num) & (p->page_table_size - 1)], __ATOMIC_ACQUIRE);
 
-//printf("\nfind page[%d] 1\n",trx_id);
-	int i = 0;
-	// ޾ƿ´ ->  ȿ ۶ -> ã  -> ۾
-	int head = pageScan(tableid, 0);
-	pagenum_t rootp=b_head.root_page;
-	clearPin(head);
-	pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
-	//printf("find page[%d] : page unlock head [%d] \n", trx_id, head );
+	//체인이 꼬여도 무한루프는 돌지 않게
+	for (int n = 0; i >= 0 && n < b_M.frame_capacity; n++) {
+		if (__atomic_load_n(&b_M.frameArray[i].table_id, __ATOMIC_RELAXED) == table_id
+			&& __atomic_load_n(&b_M.frameArray[i].page_num, __ATOMIC_RELAXED) == page_num)
+			return i;
+		i = __atomic_load_n(&b_M.frameArray[i].hash_next, __ATOMIC_RELAXED);
+	}
+	return -1;
+}
 
+//짝수 version이 될때까지 기다렸다가 리턴
+uint64_t pageReadBegin(int index)
+{
+	uint64_t v;
+	while ((v = __atomic_load_n(&b_index.version, __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+	return v;
+}
 
-	//Ʈ ϰ
-	if (rootp == 0) {
-//printf("find page[%d] - empty\n", trx_id);
-		return FAIL;
+//읽는 동안 아무도 고치지 않았으면 1
+int pageReadValidate(int index, uint64_t v)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&b_index.version, __ATOMIC_RELAXED) == v;
+}
+
+//고치는 쪽은 page latch나 partition latch를 잡은 상태라 서로 겹치지 않는다
+void pageWriteBegin(int index)
+{
+	__atomic_fetch_add(&b_index.version, 1, __ATOMIC_ACQ_REL);
+}
+
+void pageWriteEnd(int index)
+{
+	__atomic_fetch_add(&b_index.version, 1, __ATOMIC_RELEASE);
+}
+
+//page version과 같은 방식의 테이블 단위 version, 리프를 쪼개거나 합치는 중이 아닐때까지 기다렸다가 리턴
+static uint64_t smo_read_begin(int table_id)
+{
+	uint64_t s;
+	while ((s = __atomic_load_n(&table_get(table_id)->smo_seq, __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+	return s;
+}
+
+//트리를 바꾸는 쪽은 smo_latch를 잡은 상태라 서로 겹치지 않는다
+static void smo_write_begin(int table_id)
+{
+	__atomic_fetch_add(&table_get(table_id)->smo_seq, 1, __ATOMIC_ACQ_REL);
+}
+
+static void smo_write_end(int table_id)
+{
+	__atomic_fetch_add(&table_get(table_id)->smo_seq, 1, __ATOMIC_RELEASE);
+}
+
+//smo_read_begin 이후 트리 모양이 바뀌지 않았으면 1
+static int smo_read_validate(int table_id, uint64_t s)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&table_get(table_id)->smo_seq, __ATOMIC_RELAXED) == s;
+}
+
+//리프의 i번째 키/값
+int64_t leaf_key(const page_t * pg, int i)
+{
+	if (pg->leaf_layout == LEAF_SLOT) return pg->slot[i].key;
+	return pg->record[i].key;
+}
+
+char * leaf_val(page_t * pg, int i)
+{
+	if (pg->leaf_layout == LEAF_SLOT) return &pg->body[pg->slot[i].off];
+	return pg->record[i].val;
+}
+
+//빈 리프로 만든다
+void leaf_init(page_t * pg, int leaf_layout)
+{
+	pg->leaf_layout = leaf_layout;
+	pg->num_key = 0;
+	pg->heap = leaf_body;
+	pg->garbage = 0;
+	pg->dead_num = 0;
+	memset(pg->dead, 0, sizeof(pg->dead));
+}
+
+//i번째 레코드에 지운 표시가 있으면 1, dead_num이 0이면 bitmap도 전부 0이다
+int leaf_dead(const page_t * pg, int i)
+{
+	return pg->dead_num > 0 && ((pg->dead[i >> 3] >> (i & 7)) & 1);
+}
+
+static int leaf_dead_bit(const page_t * pg, int i)
+{
+	return (pg->dead[i >> 3] >> (i & 7)) & 1;
+}
+
+static void leaf_dead_set(page_t * pg, int i, int v)
+{
+	if (v) pg->dead[i >> 3] |= (uint8_t)(1 << (i & 7));
+	else pg->dead[i >> 3] &= (uint8_t)~(1 << (i & 7));
+}
+
+//레코드가 [from, num_key)에서 한칸 밀리거나 당겨질때 bitmap도 같이 옮긴다, delta는 1 또는 -1
+static void leaf_dead_shift(page_t * pg, int from, int delta)
+{
+	if (pg->dead_num == 0) return;
+	if (delta > 0) {
+		for (int k = pg->num_key - 1; k >= from; k--) leaf_dead_set(pg, k + 1, leaf_dead_bit(pg, k));
+		leaf_dead_set(pg, from, 0);
+	}
+	else {
+		for (int k = from; k < pg->num_key - 1; k++) leaf_dead_set(pg, k, leaf_dead_bit(pg, k + 1));
+		leaf_dead_set(pg, pg->num_key - 1, 0);
 	}
+}
 
-	//trx ̺ Ȯ
-	if (!trx_find(trx_id)) {
-		//printf("find page[%d]: not exist trx\n", trx_id);
-		return FAIL;
+//LEAF_SLOT에 저장되는 값의 길이('\0' 포함), val_max를 넘는 부분은 잘린다
+static int leaf_len(const char * val)
+{
+	return strnlen(val, val_max - 1) + 1;
+}
+
+//val을 가진 레코드가 하나 더 들어갈 수 있는지, LEAF_SLOT은 버려진 heap을 모으면 되는 경우도 포함
+int leaf_fits(const page_t * pg, const char * val)
+{
+	if (pg->leaf_layout != LEAF_SLOT) return pg->num_key < leaf_order;
+	int room = pg->heap - pg->num_key * (int)sizeof(leaf_slot) + pg->garbage;
+	return room >= (int)sizeof(leaf_slot) + leaf_len(val);
+}
+
+//LEAF_SLOT : 살아있는 값만 body 끝쪽으로 다시 모은다
+static void leaf_compact(page_t * pg)
+{
+	char tmp[leaf_body];
+	int top = leaf_body;
+	for (int i = 0; i < pg->num_key; i++) {
+		top -= pg->slot[i].len;
+		memcpy(&tmp[top], &pg->body[pg->slot[i].off], pg->slot[i].len);
+		pg->slot[i].off = top;
 	}
+	memcpy(&pg->body[top], &tmp[top], leaf_body - top);
+	pg->heap = top;
+	pg->garbage = 0;
+}
 
-	//Ʈ
-	int trace = pageScan(tableid, rootp);
-	lock_t * tmp_l;
-//printf("find page[%d] : trace page lock\n", trx_id);
-	pagenum_t tmp = rootp;
-
-	// ൵ ɵ 
-	while (!b_M.frameArray[trace].frame_p.is_leaf) {
-		i=0;
-		while (i < b_M.frameArray[trace].frame_p.num_key) {
-		clearPin(trace);
-		pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-		//printf("find page[%d] : page unlock [%d] before acquire lock \n",trx_id,trace);
-		tmp_l=lock_acquire(tableid,b_M.frameArray[trace].frame_p.branch[i].key,trx_id,mode);
-		setPin(trace);
-		pthread_mutex_lock(&b_M.frameArray[trace].page_latch);
-		//printf("find page[%d] : page lock [%d] after acquire lock \n",trx_id,trace);
-		if(tmp_l==NULL){
-		//	printf("find_page[%d] : lock acquire failed\n", trx_id);
-			clearPin(trace);
-			
-			pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-//printf("find page[%d] : page unlock inside [%d] \n", trx_id,trace);
-			
-			return FAIL;
+//LEAF_SLOT : slot이 slots개가 된 뒤에도 겹치지 않게 heap에서 len바이트를 떼온다
+//모자라면 compact하므로 자리는 호출하는 쪽에서 미리 확인한다
+static int leaf_alloc(page_t * pg, int len, int slots)
+{
+	if (pg->heap - slots * (int)sizeof(leaf_slot) < len) leaf_compact(pg);
+	pg->heap -= len;
+	return pg->heap;
+}
+
+//i번째 자리에 레코드를 끼워넣는다, 자리는 leaf_fits로 먼저 확인
+void leaf_insert(page_t * pg, int i, int64_t key, const char * val)
+{
+	leaf_dead_shift(pg, i, 1);
+	if (pg->leaf_layout != LEAF_SLOT) {
+		memmove(&pg->record[i + 1], &pg->record[i], (pg->num_key - i) * sizeof(key_val));
+		pg->record[i].key = key;
+		strcpy(pg->record[i].val, val);
+		pg->num_key++;
+		return;
+	}
+
+	int len = leaf_len(val);
+	int off = leaf_alloc(pg, len, pg->num_key + 1);
+	memmove(&pg->slot[i + 1], &pg->slot[i], (pg->num_key - i) * sizeof(leaf_slot));
+	pg->slot[i].key = key;
+	pg->slot[i].off = off;
+	pg->slot[i].len = len;
+	memcpy(&pg->body[off], val, len - 1);
+	pg->body[off + len - 1] = '\0';
+	pg->num_key++;
+}
+
+//i번째 값을 바꾼다, LEAF_SLOT에서 늘어난 값이 들어갈 자리가 없으면 FAIL
+int leaf_update(page_t * pg, int i, const char * val)
+{
+	if (pg->leaf_layout != LEAF_SLOT) {
+		strcpy(pg->record[i].val, val);
+		return SUCCESS;
+	}
+
+	int len = leaf_len(val);
+	leaf_slot * sl = &pg->slot[i];
+	if (len <= sl->len) {
+		//줄어든 만큼은 버려진 heap
+		pg->garbage += sl->len - len;
+	}
+	else {
+		if (pg->heap - pg->num_key * (int)sizeof(leaf_slot) + pg->garbage + sl->len < len) return FAIL;
+		pg->garbage += sl->len;
+		sl->len = 0;
+		sl->off = leaf_alloc(pg, len, pg->num_key);
+	}
+	sl->len = len;
+	memcpy(&pg->body[sl->off], val, len - 1);
+	pg->body[sl->off + len - 1] = '\0';
+	return SUCCESS;
+}
+
+//i번째 값을 프레임 안에서 고친 뒤 부른다, LEAF_SLOT은 줄어든 만큼을 버려진 heap으로 돌린다 (늘리지는 못한다)
+static void leaf_update_inplace(page_t * pg, int i)
+{
+	if (pg->leaf_layout != LEAF_SLOT) {
+		pg->record[i].val[sizeof(pg->record[i].val) - 1] = '\0';
+		return;
+	}
+	leaf_slot * sl = &pg->slot[i];
+	pg->body[sl->off + sl->len - 1] = '\0';
+	int len = leaf_len(&pg->body[sl->off]);
+	pg->garbage += sl->len - len;
+	sl->len = len;
+}
+
+//i번째 레코드를 빼고 뒤를 당긴다, LEAF_SLOT은 값 자리를 버려진 heap으로 돌린다
+void leaf_remove(page_t * pg, int i)
+{
+	int dead = leaf_dead(pg, i);
+	leaf_dead_shift(pg, i, -1);
+	pg->dead_num -= dead;
+	if (pg->leaf_layout != LEAF_SLOT) {
+		memmove(&pg->record[i], &pg->record[i + 1], (pg->num_key - i - 1) * sizeof(key_val));
+		pg->num_key--;
+		pg->record[pg->num_key].key = -1;
+		return;
+	}
+	pg->garbage += pg->slot[i].len;
+	memmove(&pg->slot[i], &pg->slot[i + 1], (pg->num_key - i - 1) * sizeof(leaf_slot));
+	pg->num_key--;
+}
+
+//리프가 레코드에 쓰는 바이트, 지운 표시가 있는 레코드는 live가 0이면 같이 센다
+static int leaf_used(const page_t * pg, int live)
+{
+	int used = 0;
+	for (int i = 0; i < pg->num_key; i++) {
+		if (live && leaf_dead(pg, i)) continue;
+		used += (pg->leaf_layout == LEAF_SLOT) ? (int)sizeof(leaf_slot) + pg->slot[i].len : (int)sizeof(key_val);
+	}
+	return used;
+}
+
+static int leaf_cap(const page_t * pg)
+{
+	return (pg->leaf_layout == LEAF_SLOT) ? leaf_body : leaf_order * (int)sizeof(key_val);
+}
+
+//i번째 레코드 하나가 쓰는 바이트
+static int leaf_rec_size(const page_t * pg, int i)
+{
+	return (pg->leaf_layout == LEAF_SLOT) ? (int)sizeof(leaf_slot) + pg->slot[i].len : (int)sizeof(key_val);
+}
+
+//지운 표시가 있는 레코드를 실제로 뺀다, 뒤에서부터 빼서 앞쪽 자리는 그대로
+static void leaf_purge(page_t * pg)
+{
+	for (int i = pg->num_key - 1; i >= 0 && pg->dead_num > 0; i--)
+		if (leaf_dead(pg, i)) leaf_remove(pg, i);
+}
+
+//페이지 안 키 탐색 (branchless 이진탐색), num_key는 호출하는 쪽에서 넘겨준다
+//리프 : key 이상인 첫 레코드의 인덱스 (없으면 num_key)
+int leaf_search(const page_t * pg, int num_key, int64_t key)
+{
+	//LEAF_RECORD는 key가 RECORD_SIZE 간격, LEAF_SLOT은 16바이트 간격
+	int slot = (pg->leaf_layout == LEAF_SLOT);
+	const int64_t * k = slot ? &pg->slot[0].key : &pg->record[0].key;
+	int stride = slot ? (int)(sizeof(leaf_slot) / 8) : (int)(sizeof(key_val) / 8);
+	int base = 0;
+	if (num_key <= 0) return 0;
+	while (num_key > 1) {
+		int half = num_key >> 1;
+		base = (k[(base + half) * stride] < key) ? base + half : base;
+		num_key -= half;
+	}
+	return base + (k[base * stride] < key);
+}
+
+//인터널 : key 이하인 마지막 branch의 인덱스, -1이면 right_left(제일 왼쪽 자식)
+//LAYOUT_BRANCH는 key가 16바이트 간격, LAYOUT_SEP은 8바이트 간격으로 붙어있다
+int node_search(const page_t * pg, int num_key, int64_t key)
+{
+	int sep = (pg->layout == LAYOUT_SEP);
+	const int64_t * k = sep ? pg->sep.key : &pg->branch[0].key;
+	int stride = sep ? 1 : 2;
+	int base = 0;
+	if (num_key > node_cap(pg->layout)) num_key = node_cap(pg->layout);
+	if (num_key <= 0) return -1;
+	while (num_key > 1) {
+		int half = num_key >> 1;
+		base = (k[(base + half) * stride] <= key) ? base + half : base;
+		num_key -= half;
+	}
+	return base - (k[base * stride] > key);
+}
+
+//인터널 형식별 최대 키 수
+int node_cap(int layout)
+{
+	return (layout == LAYOUT_SEP) ? sep_order : node_order;
+}
+
+//인터널의 i번째 키/자식, node_child는 i가 -1이면 right_left
+//낙관적으로 읽는 중에 layout이 바뀌어도 페이지 밖은 읽지 않게 인덱스를 막아둔다
+int64_t node_key(const page_t * pg, int i)
+{
+	if (pg->layout == LAYOUT_SEP) return (i < sep_order) ? pg->sep.key[i] : 0;
+	return (i < node_order) ? pg->branch[i].key : 0;
+}
+
+pagenum_t node_child(const page_t * pg, int i)
+{
+	if (i < 0) return pg->right_left;
+	if (pg->layout == LAYOUT_SEP) return (i < sep_order) ? pg->sep.child[i] : 0;
+	return (i < node_order) ? pg->branch[i].child : 0;
+}
+
+void node_set(page_t * pg, int i, int64_t key, pagenum_t child)
+{
+	if (pg->layout == LAYOUT_SEP) {
+		pg->sep.key[i] = key;
+		pg->sep.child[i] = (uint32_t)child;
+	}
+	else {
+		pg->branch[i].key = key;
+		pg->branch[i].child = child;
+	}
+}
+
+//리프에서 key와 같은 레코드의 인덱스, 없거나 지운 표시가 있으면 num_key
+int leaf_find(const page_t * pg, int64_t key)
+{
+	int i = leaf_search(pg, pg->num_key, key);
+	if (i < pg->num_key && (leaf_key(pg, i) != key || leaf_dead(pg, i))) return pg->num_key;
+	return i;
+}
+
+//page_num을 낙관적으로 읽을 프레임을 찾는다, 버퍼에 없으면 pageScan으로 올려두고 다시 찾는다
+static int olc_open(int table_id, pagenum_t page_num, uint64_t * v)
+{
+	while (1) {
+		int f = pageOptFind(table_id, page_num);
+		if (f == -1) {
+			f = pageScanShared(table_id, page_num);
+			clearPin(f);
+			pageUnlatch(f);
+			continue;
 		}
-			if (key >= b_M.frameArray[trace].frame_p.branch[i].key) {
-				if (i == (b_M.frameArray[trace].frame_p.num_key - 1)) {
-					
-					break;
-				}
-				i++;
-			}
-			else {
-				i--;
-				
-				break;
-			}
+		*v = pageReadBegin(f);
+		//version을 읽은 뒤에도 같은 페이지인지, 아니면 그 사이 교체된것
+		if (b_M.frameArray[f].table_id == table_id && b_M.frameArray[f].page_num == page_num)
+			return f;
+	}
+}
+
+//key가 들어갈 리프의 page_num을 찾는다 (optimistic lock coupling)
+//헤더/인터널은 latch 없이 읽고 hop마다 version을 확인, 바뀌었으면 루트부터 다시
+//trx_id가 0이 아니면 find_page처럼 지나간 인터널 키에 mode로 lock
+//빈트리거나 lock 실패면 FAIL
+int find_leaf_olc(int tableid, int64_t key, int trx_id, int mode, pagenum_t * leaf_num)
+{
+	int64_t lock_key[sep_order];
+	uint64_t v, smo;
+	int f;
+
+	//merger가 없앤 페이지는 version이 그대로라, 그 사이 트리가 바뀌었는지는 smo_seq로 본다
+restart:
+	smo = smo_read_begin(tableid);
+	f = olc_open(tableid, 0, &v);
+	pagenum_t pn = b_M.frameArray[f].frame_h->root_page;
+	if (!pageReadValidate(f, v)) goto restart;
+	if (pn == 0) return FAIL;
+
+	while (1) {
+		f = olc_open(tableid, pn, &v);
+		page_t * pg = b_M.frameArray[f].frame_p;
+
+		int is_leaf = pg->is_leaf;
+		int num_key = pg->num_key;
+		if (num_key < 0 || num_key > node_cap(pg->layout)) num_key = 0;//고치는 중에 읽은 값, 아래에서 걸러진다
+
+		if (is_leaf) {
+			if (!pageReadValidate(f, v) || !smo_read_validate(tableid, smo)) goto restart;
+			*leaf_num = pn;
+			return SUCCESS;
 		}
 
-		if (i != -1) {
-//printf("find page[%d] - 2\n", trx_id);
-			tmp = b_M.frameArray[trace].frame_p.branch[i].child;
-			clearPin(trace);
-			pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-//printf("find page[%d] : page unlock inside [%d] \n", trx_id,trace);
-			trace = pageScan(tableid, tmp);
-			
+		//자식 선택, 지나간 키(멈춘 키까지)는 lock_key에
+		int i = node_search(pg, num_key, key);
+		int nlock = 0;
+		if (trx_id != 0) {
+			nlock = (i == num_key - 1) ? num_key : i + 2;
+			for (int j = 0; j < nlock; j++)
+				lock_key[j] = node_key(pg, j);
 		}
-		else if (i == -1) {
-//printf("find page[%d] - 3\n", trx_id);
-			tmp = b_M.frameArray[trace].frame_p.right_left;
-			clearPin(trace);
-			pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-//printf("find page[%d] : page unlock inside [%d] \n", trx_id,trace);
-			trace = pageScan(tableid, tmp);
-			
+		pagenum_t next = node_child(pg, i);
+		if (!pageReadValidate(f, v) || !smo_read_validate(tableid, smo)) goto restart;
+
+		if (trx_id != 0) {
+			for (int j = 0; j < nlock; j++)
+				if (lock_acquire(tableid, lock_key[j], trx_id, mode) == NULL) return FAIL;
 		}
+		pn = next;
+	}
+}
+
+//mmap 테이블의 페이지, 파일 밖이면 NULL
+static page_t * map_page(const Table * tb, pagenum_t pn)
+{
+	if (pn == 0 || pn >= tb->map_pages) return NULL;
+	return (page_t*)(tb->map + pn * PAGESIZE);
+}
 
+//mmap 테이블에서 key가 들어있을 수 있는 리프, 빈트리면 NULL
+//읽기 전용이라 고치는 쪽이 없으므로 pin, latch, lock 없이 포인터만 따라 내려간다
+static page_t * map_find_leaf(int tableid, int64_t key)
+{
+	const Table * tb = table_get(tableid);
+	page_t * pg = map_page(tb, ((const header_page*)tb->map)->root_page);
+
+	//깨진 파일에서 자식이 돌아도 멈추도록 깊이를 제한한다
+	for (int d = 0; pg != NULL && !pg->is_leaf; d++) {
+		int num_key = pg->num_key;
+		if (d == 64 || num_key < 0 || num_key > node_cap(pg->layout)) return NULL;
+		pg = map_page(tb, node_child(pg, node_search(pg, num_key, key)));
+	}
+	if (pg != NULL && (pg->num_key < 0 || pg->num_key > (pg->leaf_layout == LEAF_SLOT ? slot_max : leaf_order))) return NULL;
+	return pg;
+}
+
+//mmap 테이블에서 key의 값을 ret_val에, 없으면 FAIL
+static int map_find(int tableid, int64_t key, char * ret_val)
+{
+	page_t * leaf = map_find_leaf(tableid, key);
+	if (leaf == NULL) return FAIL;
+	int i = leaf_find(leaf, key);
+	if (i == leaf->num_key) return FAIL;
+	strcpy(ret_val, leaf_val(leaf, i));
+	return SUCCESS;
+}
+
+//여기서 버퍼락 페이지락 버퍼언락 얼어나게
+int find_page(int tableid, int64_t key,int trx_id,int mode) {
+
+//printf("\nfind page[%d] 1\n",trx_id);
+	//trx 테이블에서 확인
+	Trx * t = trx_get(trx_id);
+	if (!t) {
+		//printf("find page[%d]: not exist trx\n", trx_id);
+		return FAIL;
+	}
+
+	//헤더와 인터널은 latch 없이 version으로 확인하며 내려가고 리프만 잡는다
+	//지나가는 인터널 키에는 예전처럼 mode로 lock (snapshot trx는 lock 없이)
+	//빈트리거나 lock 실패면 FAIL
+	pagenum_t tmp;
+	if (find_leaf_olc(tableid, key, t->snap >= 0 ? 0 : trx_id, mode, &tmp) != SUCCESS) {
+//printf("find page[%d] - empty or lock fail\n", trx_id);
+		return FAIL;
 	}
-	clearPin(trace);
-	pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-	//printf("find page[%d] : page unlock1 [%d] \n", trx_id,trace);
-	// ޾ƿ´ ->  ȿ ۶ -> ã  -> ۾
-	int find = pageScan(tableid, tmp);
+
+	//헤더를 받아온다 -> 이 안에서 버퍼락 -> 페이지찾고 페이지락 -> 버퍼언락
+	int find = pageScanShared(tableid, tmp);
 //printf("find page[%d] - 4\n", trx_id);
 
 	clearPin(find);
-	pthread_mutex_unlock(&b_M.frameArray[find].page_latch);
+	pageUnlatch(find);
 	//printf("find page[%d] : page unlock3 [%d] \n", trx_id,find);
-	//  3
 
-	//  mutex 
+	//끝날시점에는 모든 mutex들이 해제
 
 	return find;
 }
 
+//find_page처럼 리프를 찾되 latch를 잡은 채로 돌려주고 *pn에 page_num을 넣는다 (shared가 0이면 X)
+//빈트리면 FAIL, 인터널 키 lock을 기다리다 abort되었으면 ABORT
+static int find_page_latch(int tableid, int64_t key, int trx_id, int shared, pagenum_t * pn)
+{
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	if (find_leaf_olc(tableid, key, t->snap >= 0 ? 0 : trx_id, 0, pn) != SUCCESS) return trx_get(trx_id) ? FAIL : ABORT;
+	return shared ? pageScanShared(tableid, *pn) : pageScan(tableid, *pn);
+}
+
+//latch를 놓고 lock을 기다린 뒤에 다시 잡는다
+//그 사이 프레임이 evict되어 다른 페이지가 올라왔을 수 있으므로 page_num이 다르면 다시 찾아 올린다
+static int page_relatch(int table_id, pagenum_t pn, int index, int shared)
+{
+	if (!pinTry(index)) return shared ? pageScanShared(table_id, pn) : pageScan(table_id, pn);
+	if (shared) pageLatchShared(index);
+	else pageLatch(index);
+	if (b_M.frameArray[index].table_id == table_id && b_M.frameArray[index].page_num == pn) return index;
+	clearPin(index);
+	pageUnlatch(index);
+	return shared ? pageScanShared(table_id, pn) : pageScan(table_id, pn);
+}
+
+//////////////////////////////////////////// adaptive hash index
+//db_find가 같은 리프로 AHI_HOT번 넘게 내려가면 그 뒤로 그 리프에서 찾은 키를 key -> (page_num, slot)으로 넣어두고
+//다음부터 그 키는 트리를 내려가지 않고 리프를 바로 잡는다
+//엔트리는 힌트일 뿐이라 잡은 리프에서 그 자리(또는 이진탐색)에 키가 살아있을때만 쓴다
+//키는 트리에서 하나뿐이라 잡은 리프에 있으면 그 리프가 맞다, merger가 없앤 리프는 is_leaf가 0이다
+
+static ahi_ent * ahi_slot(int table_id, int64_t key)
+{
+	uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ull ^ (uint64_t)table_id * 0xC2B2AE3D27D4EB4Full;
+	return &b_M.ahi[(h >> 32) & (AHI_SIZE - 1)];
+}
+
+//엔트리를 고치는 쪽끼리는 version을 CAS로 홀수로 만들어 줄을 세운다, 다른 쪽이 고치는 중이면 그냥 넘어간다
+static int ahi_write_begin(ahi_ent * e, uint64_t * v)
+{
+	*v = __atomic_load_n(&e->version, __ATOMIC_RELAXED);
+	return !(*v & 1) && __atomic_compare_exchange_n(&e->version, v, *v + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void ahi_put(int table_id, int gen, int64_t key, pagenum_t pn, int slot, int64_t page_LSN)
+{
+	ahi_ent * e = ahi_slot(table_id, key);
+	uint64_t v;
+	if (!ahi_write_begin(e, &v)) return;
+	e->table_id = table_id;
+	e->gen = gen;
+	e->key = key;
+	e->page_num = pn;
+	e->page_LSN = page_LSN;
+	e->slot = slot;
+	__atomic_store_n(&e->version, v + 2, __ATOMIC_RELEASE);
+}
+
+//key가 다른 리프로 옮겨갈때, 옮기는 쪽이 리프를 X로 잡은 채로 부른다
+static void ahi_drop(int table_id, int64_t key)
+{
+	ahi_ent * e = ahi_slot(table_id, key);
+	uint64_t v;
+	if (!ahi_write_begin(e, &v)) return;
+	if (e->table_id == table_id && e->key == key) e->table_id = 0;
+	__atomic_store_n(&e->version, v + 2, __ATOMIC_RELEASE);
+}
+
+//key의 엔트리를 out에 복사, 없으면 0
+static int ahi_get(int table_id, int64_t key, ahi_ent * out)
+{
+	ahi_ent * e = ahi_slot(table_id, key);
+	uint64_t v = __atomic_load_n(&e->version, __ATOMIC_ACQUIRE);
+	if (v & 1) return 0;
+	*out = *e;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&e->version, __ATOMIC_RELAXED) != v) return 0;
+	return out->table_id == table_id && out->key == key && out->gen == table_get(table_id)->gen;
+}
+
+//adaptive hash index로 key의 리프를 S로 잡아 돌려주고 *pn, *slot을 채운다, 못 쓰면 -1
+static int ahi_find(int table_id, int64_t key, pagenum_t * pn, int * slot)
+{
+	ahi_ent e;
+	if (!b_M.ahi || !ahi_get(table_id, key, &e)) return -1;
+
+	int f = pageScanShared(table_id, e.page_num);
+	page_t * pg = b_M.frameArray[f].frame_p;
+	if (pg->is_leaf) {
+		int i = e.slot;
+		//page_LSN이 그대로면 자리도 그대로일 가능성이 높지만, 확인은 늘 키로 한다
+		if (pg->page_LSN != e.page_LSN || i >= pg->num_key || leaf_key(pg, i) != key) {
+			i = leaf_find(pg, key);
+			if (i < pg->num_key) ahi_put(table_id, e.gen, key, e.page_num, i, pg->page_LSN);
+		}
+		if (i < pg->num_key && !leaf_dead(pg, i)) {
+			STAT_ADD(stat_table_get(table_id)->ahi_hit, 1);
+			*pn = e.page_num;
+			*slot = i;
+			return f;
+		}
+	}
+	clearPin(f);
+	pageUnlatch(f);
+	return -1;
+}
+
+//db_find가 트리를 내려가 pn 리프의 slot에서 key를 찾았다 (S로 잡은 상태)
+//그 리프로 AHI_HOT번 이상 내려왔으면 key를 넣는다, 자주 찾는 리프의 키만 하나씩 들어가므로 hot 구간만 표에 남는다
+static void ahi_touch(int table_id, int64_t key, pagenum_t pn, int f, int slot)
+{
+	if (!b_M.ahi) return;
+	uint8_t * heat = &b_M.ahi_heat[pageHash(table_id, pn) & (AHI_HEAT - 1)];
+	//세는건 대략이면 되므로 atomic add 없이, AHI_HOT에서 멈춘다
+	int n = __atomic_load_n(heat, __ATOMIC_RELAXED);
+	if (n < AHI_HOT) {
+		__atomic_store_n(heat, (uint8_t)(n + 1), __ATOMIC_RELAXED);
+		return;
+	}
+	ahi_put(table_id, table_get(table_id)->gen, key, pn, slot, b_M.frameArray[f].frame_p->page_LSN);
+	STAT_ADD(stat_table_get(table_id)->ahi_build, 1);
+}
+
+static wbatch_ent * wbatch_get(Trx * t, int table_id, int64_t key);
+
 int db_find(int table_id, int64_t key, char * ret_val, int trx_id)
 {
 	//if(b_M.frameArray==NULL) init_db(500);
 	
 	int i;
-	if (b_M.table[table_id - 1].isopen == 0) {
+	if (!table_isopen(table_id)) {
 	//	printf("File Is Closed\n");
 		return SUCCESS;
 	}
 
-	//trx ̺ Ȯ
-	if (!trx_find(trx_id)) {
+	//trx 테이블에서 확인
+	Trx * t = trx_get(trx_id);
+	if (!t) {
 	//	printf("db find[%d] : not exist trx\n", trx_id);
 		return SUCCESS;
 	}
+	//mmap 테이블은 고치는 trx가 없으므로 lock도 snapshot도 필요없다
+	if (table_get(table_id)->map) {
+		map_find(table_id, key, ret_val);
+		return SUCCESS;
+	}
+	//write batch에 모아둔 키면 그 값이 이 trx가 쓴 최신 값 (X lock은 이미 잡고 있다)
+	if (t->wbatch_num) {
+		wbatch_ent * e = wbatch_get(t, table_id, key);
+		if (e) {
+			strcpy(ret_val, e->new_image);
+			return SUCCESS;
+		}
+	}
 
 
-//printf("\ndb_find[%d] start -1\n",trx_id);
-		// Ű  ִ  ´
-	
-	int find_p = find_page(table_id, key,trx_id,0);
+	//리프를 잡은 뒤에 보니 split이나 merge로 레코드가 옮겨갔으면 다시 내려간다
+	uint64_t smo;
+	int find_p;
+	pagenum_t pn;
 	lock_t * tmp_l;
-	//۶ 
-	
+restart:
+	smo = smo_read_begin(table_id);
+
+	//자주 찾는 리프의 키면 adaptive hash index로 그 리프를 바로 잡는다
+	//이때는 인터널을 지나지 않으므로 인터널 키 lock 없이 레코드 lock만 잡는다
+	find_p = ahi_find(table_id, key, &pn, &i);
+	if (find_p < 0) {
+//printf("\ndb_find[%d] start -1\n",trx_id);
+		//그 키가 들어있을수도 있는 리프페이지를 가져온다
+		find_p = find_page_latch(table_id, key, trx_id, 1, &pn);
 //printf("db find page lock [%d] suc\n",find_p);
-	//۾
-	
-	//Ʈ 
-	if (find_p == FAIL) {
+
+		if (find_p == ABORT) return ABORT;
+		//빈트리인 경우
+		if (find_p == FAIL) {
 //printf("db_find[%d]- empty\n",trx_id);
-		
-//printf("db find[%d] : page unlock-fail [%d] \n",trx_id,find_p);
-		return SUCCESS;
+			return SUCCESS;
+		}
+		i = -1;
 	}
 
-	setPin(find_p);
-	pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
-
-	//  
-	//Ű ߰ϸ  = ->ڵ ->->б->ڵ( ) ---  ڵ ̰ ݺ(abort Ȯ),
-	for (i = 0; i < b_M.frameArray[find_p].frame_p.num_key; i++)
-	{
+	if (!smo_read_validate(table_id, smo)) {
 		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-		//printf("db_find[%d] : page unlock-1 [%d] before acquire lock \n",trx_id,find_p);
-		tmp_l=lock_acquire(table_id,b_M.frameArray[find_p].frame_p.record[i].key,trx_id,0);
-		setPin(find_p);
-		pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
-		//printf("db find[%d] : page lock [%d] after acquire lock \n",trx_id,find_p);
-		if(tmp_l==NULL){
-		//	printf("db find : lock acquire failed-1\n");
-			clearPin(find_p);
-			pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-//printf("db find[%d] : page unlock-0 [%d] \n",trx_id,find_p);
-			return ABORT;
-		}
-		if (b_M.frameArray[find_p].frame_p.record[i].key == key) {
-			
-			break;
-		}
-		
+		pageUnlatch(find_p);
+		goto restart;
+	}
+
+	//페이지 안에서 키 자리를 이진탐색으로 찾고, 찾은 레코드에만 lock을 건다
+	if (i < 0) {
+		i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+		if (i < b_M.frameArray[find_p].frame_p->num_key) ahi_touch(table_id, key, pn, find_p, i);
 	}
 //printf("db_find[%d]-2\n",trx_id);
-		//ε  ƴ϶ ãѰ - break  ƴ϶ 
-	if (i == b_M.frameArray[find_p].frame_p.num_key) {
+		//인덱스가 끝번이 아니라면 찾지못한것 - break로 멈춰진게 아니라는 뜻
+	if (i == b_M.frameArray[find_p].frame_p->num_key) {
 //printf("db_find[%d] end----- not find\n",trx_id);
 		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
+		pageUnlatch(find_p);
 //printf("db find[%d] : page unlock-1 [%d] \n",trx_id,find_p);
 		return SUCCESS;
 	}
+	else if (t->snap >= 0) {
+		//snapshot trx는 lock 없이 page 값을 begin 시점으로 되돌려 읽는다
+		//begin 뒤에 들어온 레코드면 못 찾은 것
+		char val[val_max];
+		strcpy(val, leaf_val(b_M.frameArray[find_p].frame_p, i));
+		if (mvcc_read(table_id, key, val, t->snap) == SUCCESS) strcpy(ret_val, val);
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return SUCCESS;
+	}
 	else {
 //printf("db_find end[%d]------ find\n",trx_id);
-//̰ ڵ ۾ S (abortȮ) -> ڵ  -> commitÿ 
+//이거전에도 레코드락 작업 S모드로 (abort확인) -> 레코드 언락 안함-> commit시에 함
 		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
+		pageUnlatch(find_p);
 		//printf("db_find[%d] : page unlock-2 [%d] before acquire lock \n",trx_id,find_p);
-		tmp_l=lock_acquire(table_id,b_M.frameArray[find_p].frame_p.record[i].key,trx_id,0);
-		setPin(find_p);
-		pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
+		tmp_l=lock_acquire(table_id,key,trx_id,0);
+		find_p = page_relatch(table_id, pn, find_p, 1);
 		//printf("db find[%d] : page lock [%d] after acquire lock \n",trx_id,find_p);
 		if(tmp_l==NULL){
 			//printf("db find : lock acquire failed-2\n");
 			clearPin(find_p);
-			pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
+			pageUnlatch(find_p);
 //printf("db find[%d] : page unlock-2 [%d] \n",trx_id,find_p);
 			return ABORT;
 		}
+		if (!smo_read_validate(table_id, smo)) {
+			clearPin(find_p);
+			pageUnlatch(find_p);
+			goto restart;
+		}
+		//lock을 기다리는 동안 레코드가 밀렸을 수 있으니 다시 찾는다
+		i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+		if (i == b_M.frameArray[find_p].frame_p->num_key) {
+			clearPin(find_p);
+			pageUnlatch(find_p);
+			return SUCCESS;
+		}
 
-//printf("db find[%d] : find val=%s\n",trx_id,b_M.frameArray[find_p].frame_p.record[i].val);
-		strcpy(ret_val, b_M.frameArray[find_p].frame_p.record[i].val);
+//printf("db find[%d] : find val=%s\n",trx_id,b_M.frameArray[find_p].frame_p->record[i].val);
+		strcpy(ret_val, leaf_val(b_M.frameArray[find_p].frame_p, i));
 //printf("hoo.....\n");
 		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
+		pageUnlatch(find_p);
 //printf("db find[%d] : page unlock [%d] FINISH \n",trx_id,find_p);
 		return SUCCESS;
 	}
@@ -223,155 +764,1464 @@ int db_find(int table_id, int64_t key, char * ret_val, int trx_id)
 }
 
 
-//Ű شϴ  оͼ ڵ  
-// 0 
-//н nonzero -> abort ʿ ->   release ϰ undo
-//->E , տ   ִٸ  ٸ
-//Abortٸ ABORT
-int db_update(int table_id, int64_t key, char * val, int trx_id)
+//db_scan의 mmap 테이블 버전, 리프 체인을 포인터로만 따라간다
+static int map_scan(int table_id, int64_t begin_key, int64_t end_key, scan_callback callback)
+{
+	const Table * tb = table_get(table_id);
+	page_t * leaf = map_find_leaf(table_id, begin_key);
+	int cnt = 0;
+
+	//리프 수보다 많이 돌면 깨진 체인
+	for (pagenum_t n = 0; leaf != NULL && n < tb->map_pages; n++) {
+		for (int i = leaf_search(leaf, leaf->num_key, begin_key); i < leaf->num_key; i++)
+		{
+			int64_t key = leaf_key(leaf, i);
+			if (key < begin_key || leaf_dead(leaf, i)) continue;
+			if (key > end_key) return cnt;
+			cnt++;
+			if (callback(key, leaf_val(leaf, i))) return cnt;
+		}
+		leaf = map_page(tb, leaf->right_left);
+	}
+	return cnt;
+}
+
+//begin_key 이상 end_key 이하의 레코드를 리프 체인을 따라가며 callback으로 넘겨준다
+//레코드마다 S lock (snapshot trx는 lock 없이 begin 시점의 값), 넘겨준 레코드 수 리턴 / lock 실패시 ABORT
+//end_key 다음 키(트리 끝이면 LOCK_SUPREMUM)에도 S lock을 남겨 db_insert_trx가 범위 안에 phantom을 넣지 못하게 한다
+//다음 리프는 미리 fadvise 해두고, 리프가 디스크에서 연속이면 readahead개 만큼 미리 읽는다
+//리프를 scan_ring개보다 많이 읽으면 그 뒤로는 scan 힌트를 켜서 scan ring 안의 프레임만 돌려 쓴다
+static int tree_scan(int table_id, int64_t begin_key, int64_t end_key, scan_callback callback, int trx_id)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	if (begin_key > end_key) return 0;
+	//write batch에 모아둔 값이 보이도록 먼저 페이지에 쓴다
+	if (t->wbatch_num) db_wbatch_flush(t);
+	if (table_get(table_id)->map) return map_scan(table_id, begin_key, end_key, callback);
+
+	int fd = table_get(table_id)->fd;
+	int window = b_opt.readahead > 0 ? b_opt.readahead : 8;
+
+	pagenum_t pf_lo = 0, pf_hi = 0;//이미 fadvise 한 구간 [pf_lo, pf_hi)
+	pagenum_t pf_from = 0, pf_to = 0;//io_uring이면 fadvise 대신 이 리프를 푼 뒤 [pf_from, pf_to)를 버퍼에 올린다
+	int seq = 0;//연속으로 다음 리프가 page_num+1 이었던 횟수
+	int cnt = 0;
+	key_val rec;
+	lock_t * tmp_l;
+	//from은 다음에 넘겨줄 키, 리프를 잡은 뒤에 트리 모양이 바뀐걸 알면 from부터 다시 내려간다
+	int64_t from = begin_key;
+	uint64_t smo;
+	pagenum_t leaf_num;
+	//fence는 S lock을 잡아둔 end_key 다음 키, end는 범위 끝이나 callback으로 멈췄는지
+	//relock은 lock을 받은 뒤 from부터 다시 내려가 본 키
+	int64_t fence = 0, relock = 0;
+	int fenced = 0, relocked = 0, end;
+	int leaves = 0, ring = b_opt.scan_ring ? b_opt.scan_ring : SCAN_RING;
+
+restart:
+	end = 0;
+	smo = smo_read_begin(table_id);
+	if (find_leaf_olc(table_id, from, t->snap >= 0 ? 0 : trx_id, 0, &leaf_num) != SUCCESS) {
+		if (!trx_get(trx_id)) return cnt;
+		leaf_num = 0;
+	}
+
+	while (leaf_num != 0) {
+		if (++leaves > ring && ring > 0) bufScanHint(1);
+		int leaf = pageScanShared(table_id, leaf_num);
+		if (!smo_read_validate(table_id, smo)) {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			goto restart;
+		}
+		pagenum_t next = b_leaf.right_left;
+
+		//다음 리프를 미리 요청해둔다
+		if (next != 0) {
+			seq = (next == leaf_num + 1) ? seq + 1 : 0;
+			if (seq >= 2) {
+				//순차 패턴 : 요청한 구간의 절반을 지나면 앞쪽으로 readahead개 만큼 더 요청
+				if (next < pf_lo || next + window / 2 >= pf_hi) {
+					pagenum_t from = (next >= pf_lo && next < pf_hi) ? pf_hi : next;
+					if (b_opt.io_uring) {
+						pf_from = from;
+						pf_to = next + window;
+					}
+					else posix_fadvise(fd, from * PAGESIZE, (next + window - from) * PAGESIZE, POSIX_FADV_WILLNEED);
+					pf_lo = next;
+					pf_hi = next + window;
+				}
+			}
+			else if (next < pf_lo || next >= pf_hi) {
+				//io_uring이어도 한 페이지는 어차피 바로 읽으므로 fadvise로 충분하다
+				posix_fadvise(fd, next * PAGESIZE, PAGESIZE, POSIX_FADV_WILLNEED);
+				pf_lo = next;
+				pf_hi = next + 1;
+			}
+		}
+
+		//from 이전 레코드는 이진탐색으로 건너뛴다
+		for (int i = leaf_search(&b_leaf, b_leaf.num_key, from); i < b_leaf.num_key; i++)
+		{
+			int64_t key = leaf_key(&b_leaf, i);
+			if (key < from || leaf_dead(&b_leaf, i)) continue;
+			if (key > end_key) {
+				if (t->snap < 0 && !(fenced && fence == key)) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					if (lock_acquire(table_id, key, trx_id, 0) == NULL) return ABORT;
+					fence = key;
+					fenced = 1;
+					//기다리는 사이 from과 key 사이에 commit된 insert가 있으면 마저 넘겨준다
+					goto restart;
+				}
+				end = 1;
+				next = 0;
+				break;
+			}
+
+			if (t->snap >= 0) {
+				rec.key = key;
+				strcpy(rec.val, leaf_val(&b_leaf, i));
+				if (mvcc_read(table_id, key, rec.val, t->snap) != SUCCESS) continue;
+			}
+			else {
+				//db_find와 같이 page unlock -> record lock -> page lock
+				clearPin(leaf);
+				pageUnlatch(leaf);
+				tmp_l = lock_acquire(table_id, key, trx_id, 0);
+				leaf = page_relatch(table_id, leaf_num, leaf, 1);
+				if (tmp_l == NULL) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					return ABORT;
+				}
+				if (!smo_read_validate(table_id, smo)) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					goto restart;
+				}
+				//기다리는 사이 insert가 레코드를 밀었거나 지워졌거나, from과 key 사이에 새 키를 넣었을 수 있으니 from부터 다시 본다
+				//from이 리프 맨 앞이면 새 키는 왼쪽 리프에 들어갔을 수 있으므로 한번은 from부터 다시 내려간다
+				int j = leaf_search(&b_leaf, b_leaf.num_key, from);
+				if (j == 0 && !(relocked && relock == key)) {
+					relock = key;
+					relocked = 1;
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					goto restart;
+				}
+				while (j < b_leaf.num_key && leaf_dead(&b_leaf, j)) j++;
+				if (j == b_leaf.num_key || leaf_key(&b_leaf, j) != key) {
+					i = j - 1;
+					continue;
+				}
+				i = j;
+				rec.key = key;
+				strcpy(rec.val, leaf_val(&b_leaf, i));
+			}
+
+			//callback은 latch 밖에서
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			cnt++;
+			int stop = callback(rec.key, rec.val);
+			leaf = page_relatch(table_id, leaf_num, leaf, 1);
+			if (stop || key == end_key) {
+				end = 1;
+				next = 0;
+				break;
+			}
+			from = key + 1;
+			if (!smo_read_validate(table_id, smo)) {
+				clearPin(leaf);
+				pageUnlatch(leaf);
+				goto restart;
+			}
+			i = leaf_search(&b_leaf, b_leaf.num_key, from) - 1;
+		}
+
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		leaf_num = next;
+
+		//latch를 다 놓은 뒤에 한번에 읽는다
+		if (pf_to > pf_from && leaf_num != 0) {
+			pagenum_t pf[PREFETCH_MAX];
+			int m = 0;
+			for (pagenum_t p = pf_from; p < pf_to && m < PREFETCH_MAX; p++) pf[m++] = p;
+			pagePrefetch(table_id, pf, m);
+		}
+		pf_from = pf_to = 0;
+	}
+
+	//트리 끝까지 왔으면 뒤에 붙는 insert를 LOCK_SUPREMUM으로 막는다
+	if (!end && t->snap < 0 && !(fenced && fence == LOCK_SUPREMUM)) {
+		if (lock_acquire(table_id, LOCK_SUPREMUM, trx_id, 0) == NULL) return ABORT;
+		fence = LOCK_SUPREMUM;
+		fenced = 1;
+		goto restart;
+	}
+	return cnt;
+}
+
+//tree_scan이 켠 scan 힌트는 돌아올때 부르기 전 상태로 돌린다
+int db_scan(int table_id, int64_t begin_key, int64_t end_key, scan_callback callback, int trx_id)
+{
+	int hint = bufScanHint(-1);
+	int ret = tree_scan(table_id, begin_key, end_key, callback, trx_id);
+	bufScanHint(hint);
+	return ret;
+}
+
+//db_parallel_scan의 worker 하나, [lo, hi]를 db_scan으로 읽는다
+typedef struct pscan_job {
+	int table_id;
+	int worker;
+	int64_t lo;
+	int64_t hi;
+	int trx_id;
+	pscan_callback fn;
+	int * stop;//한 worker의 fn이 멈추면 다른 worker도 다음 레코드에서 멈춘다
+	int cnt;//fn에 넘겨준 레코드 수
+	int ret;
+	pthread_t th;
+}pscan_job;
+
+static __thread pscan_job * pscan_my;
+
+static int pscan_cb(int64_t key, const char * val)
+{
+	pscan_job * j = pscan_my;
+	if (__atomic_load_n(j->stop, __ATOMIC_RELAXED)) return 1;
+	j->cnt++;
+	if (j->fn(j->worker, key, val)) {
+		__atomic_store_n(j->stop, 1, __ATOMIC_RELAXED);
+		return 1;
+	}
+	return 0;
+}
+
+static void * pscan_thread(void * arg)
+{
+	pscan_job * j = (pscan_job*)arg;
+	pscan_my = j;
+	int ret = db_scan(j->table_id, j->lo, j->hi, pscan_cb, j->trx_id);
+	j->ret = ret < 0 ? ret : j->cnt;
+	return NULL;
+}
+
+static int pscan_key_cmp(const void * a, const void * b)
+{
+	int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+//pn을 S latch로 잡아 out에 복사한다, mmap 테이블이면 파일에서 바로
+static int pscan_read(int table_id, pagenum_t pn, page_t * out)
+{
+	const Table * tb = table_get(table_id);
+	if (tb->map) {
+		page_t * pg = map_page(tb, pn);
+		if (!pg) return FAIL;
+		memcpy(out, pg, PAGESIZE);
+		return SUCCESS;
+	}
+	int f = pageScanShared(table_id, pn);
+	memcpy(out, b_M.frameArray[f].frame_p, PAGESIZE);
+	clearPin(f);
+	pageUnlatch(f);
+	return SUCCESS;
+}
+
+//(lo, hi] 안의 separator 키를 루트부터 한 층씩 모은다, want개가 넘거나 리프 바로 위 층까지 모으면 멈춘다
+//같은 층의 separator 사이에는 리프가 비슷한 수만큼 있으므로 순서대로 고르게 뽑으면 구간마다 리프 수가 비슷하다
+//페이지는 복사해서 보므로 그 사이 트리가 바뀌어도 구간이 덜 고르게 나뉠 뿐이다, 정렬된 키 수 리턴 (*out은 free)
+static int pscan_split(int table_id, int64_t lo, int64_t hi, int want, int64_t ** out)
+{
+	page_t * pg = (page_t*)malloc(PAGESIZE);
+	pagenum_t * cur = (pagenum_t*)malloc(sizeof(pagenum_t));
+	pagenum_t * next = NULL;
+	int64_t * sep = NULL;
+	int ncur = 0, nsep = 0, sep_cap = 0;
+	const Table * tb = table_get(table_id);
+
+	if (tb->map) cur[0] = ((const header_page*)tb->map)->root_page;
+	else {
+		int head = pageScanShared(table_id, 0);
+		cur[0] = b_head.root_page;
+		clearPin(head);
+		pageUnlatch(head);
+	}
+	if (cur[0] != 0) ncur = 1;
+
+	while (ncur > 0 && nsep < want) {
+		int nnext = 0, next_cap = 0;
+		for (int c = 0; c < ncur; c++) {
+			if (pscan_read(table_id, cur[c], pg) != SUCCESS || pg->is_leaf) continue;
+			int n = pg->num_key;
+			if (n < 0 || n > node_cap(pg->layout)) n = 0;
+			//i번째 child는 [key(i), key(i + 1)), -1번째는 right_left
+			for (int i = -1; i < n; i++) {
+				if (i >= 0) {
+					int64_t k = node_key(pg, i);
+					if (k > hi) break;
+					if (k > lo) {
+						if (nsep == sep_cap) {
+							sep_cap = sep_cap ? sep_cap * 2 : 64;
+							sep = (int64_t*)realloc(sep, sep_cap * sizeof(int64_t));
+						}
+						sep[nsep++] = k;
+					}
+				}
+				if (i + 1 < n && node_key(pg, i + 1) <= lo) continue;
+				if (nnext == next_cap) {
+					next_cap = next_cap ? next_cap * 2 : 64;
+					next = (pagenum_t*)realloc(next, next_cap * sizeof(pagenum_t));
+				}
+				next[nnext++] = node_child(pg, i);
+			}
+		}
+		pagenum_t * tmp = cur;
+		cur = next;
+		next = tmp;
+		ncur = nnext;
+	}
+	free(pg);
+	free(cur);
+	free(next);
+
+	//위 층의 키는 아래 층에서 다시 나오지 않지만 고치는 중에 읽은 값이 섞일 수 있어 중복을 지운다
+	if (nsep > 0) {
+		qsort(sep, nsep, sizeof(int64_t), pscan_key_cmp);
+		int m = 1;
+		for (int i = 1; i < nsep; i++)
+			if (sep[i] != sep[m - 1]) sep[m++] = sep[i];
+		nsep = m;
+	}
+	*out = sep;
+	return nsep;
+}
+
+//[lo, hi]를 루트쪽 separator로 리프 수가 비슷한 nworkers개 구간으로 나눠 worker마다 따로 리프 체인을 따라 읽는다
+//모든 worker가 snapshot trx 하나를 같이 써서 같은 시점의 값을 본다 (lock 없음)
+//fn은 worker들이 동시에 부르므로 worker 번호(0 ~ nworkers - 1)로 자기 몫에만 모으고 끝난 뒤에 합친다
+//fn이 0이 아닌 값을 리턴하면 모든 worker가 멈춘다, 넘겨준 레코드 수 리턴
+int db_parallel_scan(int table_id, int64_t lo, int64_t hi, int nworkers, pscan_callback fn)
+{
+	if (!table_isopen(table_id) || nworkers < 1 || !fn) return FAIL;
+	if (lo > hi) return 0;
+	if (nworkers > PSCAN_MAX) nworkers = PSCAN_MAX;
+
+	int64_t * sep = NULL;
+	int nsep = nworkers > 1 ? pscan_split(table_id, lo, hi, nworkers * PSCAN_SPLIT, &sep) : 0;
+	if (nworkers > nsep + 1) nworkers = nsep + 1;
+
+	int trx_id = trx_begin_snapshot();
+	if (!trx_id) {
+		free(sep);
+		return FAIL;
+	}
+
+	pscan_job job[PSCAN_MAX];
+	int stop = 0;
+	for (int w = 0; w < nworkers; w++) {
+		job[w].table_id = table_id;
+		job[w].worker = w;
+		job[w].lo = w == 0 ? lo : sep[(int64_t)w * nsep / nworkers];
+		job[w].hi = hi;
+		if (w > 0) job[w - 1].hi = job[w].lo - 1;
+		job[w].trx_id = trx_id;
+		job[w].fn = fn;
+		job[w].stop = &stop;
+		job[w].cnt = 0;
+		job[w].ret = 0;
+	}
+	free(sep);
+
+	//0번은 부른 쓰레드가 읽는다, 쓰레드를 만들지 못한 구간도 여기서 읽는다
+	int started[PSCAN_MAX] = { 0 };
+	for (int w = 1; w < nworkers; w++)
+		started[w] = pthread_create(&job[w].th, 0, pscan_thread, &job[w]) == 0;
+	pscan_job * my = pscan_my;
+	for (int w = 0; w < nworkers; w++)
+		if (!started[w]) pscan_thread(&job[w]);
+	pscan_my = my;
+
+	int cnt = 0;
+	for (int w = 0; w < nworkers; w++) {
+		if (started[w]) pthread_join(job[w].th, NULL);
+		if (job[w].ret < 0) cnt = job[w].ret;
+		else if (cnt >= 0) cnt += job[w].ret;
+	}
+	trx_commit(trx_id);
+	return cnt;
+}
+
+//find_batch용 정렬 키, pos는 원래 위치
+typedef struct batch_key {
+	int64_t key;
+	int pos;
+}batch_key;
+
+static int batch_cmp(const void * a, const void * b)
+{
+	const batch_key * x = (const batch_key*)a;
+	const batch_key * y = (const batch_key*)b;
+	if (x->key != y->key) return x->key < y->key ? -1 : 1;
+	return x->pos - y->pos;
+}
+
+//find_batch가 내려온 경로, 각 페이지가 맡는 키 범위 [lo, hi)
+#define BATCH_DEPTH 16
+typedef struct batch_path {
+	int frame;//pin만 잡고 있는 프레임, 없으면 -1
+	pagenum_t page_num;
+	int64_t lo;
+	int64_t hi;
+	int hi_inf;//hi가 무한대
+	int pf_k;//io_uring이면 이 페이지의 자식들을 bk[pf_k] 앞까지는 미리 읽었다
+}batch_path;
+
+//경로에 잡아둔 pin을 푼다
+static void batch_drop(batch_path * path, int depth)
+{
+	for (int d = 0; d <= depth; d++)
+		if (path[d].frame >= 0) clearPin(path[d].frame);
+}
+
+//keys n개를 한번에 찾는다, 찾은 값은 out[i]에 (못찾으면 빈 문자열)
+//키를 정렬해서 공통 경로의 인터널 페이지는 pin을 잡은채로 재사용하고
+//범위를 벗어날때만 위로 올라간다. record lock은 키 순서대로 S모드
+//찾은 개수 리턴 / lock 실패시 ABORT
+int db_find_batch(int table_id, const int64_t * keys, int n, char ** out, int trx_id)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	if (n <= 0) return 0;
+	//write batch에 모아둔 값이 보이도록 먼저 페이지에 쓴다
+	if (t->wbatch_num) db_wbatch_flush(t);
+	for (int i = 0; i < n; i++) out[i][0] = '\0';
+	if (table_get(table_id)->map) {
+		//경로를 잡아둘 pin이 없으니 키마다 그냥 내려간다
+		int found = 0;
+		for (int i = 0; i < n; i++)
+			if (map_find(table_id, keys[i], out[i]) == SUCCESS) found++;
+		return found;
+	}
+
+	batch_key * bk = (batch_key*)malloc(sizeof(batch_key) * n);
+	for (int i = 0; i < n; i++) {
+		bk[i].key = keys[i];
+		bk[i].pos = i;
+	}
+	qsort(bk, n, sizeof(batch_key), batch_cmp);
+
+	batch_path path[BATCH_DEPTH];
+	int depth = 0;
+	int found = 0;
+	int ret = SUCCESS;
+	int k = 0;
+	lock_t * tmp_l;
+	uint64_t smo;
+	int head;
+	pagenum_t rootp;
+
+	//잡아둔 경로는 트리 모양이 바뀌면 키 범위가 틀리므로 버리고 루트부터 다시, 처리한 키는 그대로 둔다
+reset:
+	smo = smo_read_begin(table_id);
+	head = pageScanShared(table_id, 0);
+	rootp = b_head.root_page;
+	clearPin(head);
+	pageUnlatch(head);
+	//빈트리 일경우
+	if (rootp == 0) {
+		free(bk);
+		return found;
+	}
+
+	depth = 0;
+	path[0].frame = -1;
+	path[0].page_num = rootp;
+	path[0].lo = INT64_MIN;
+	path[0].hi = 0;
+	path[0].hi_inf = 1;
+	path[0].pf_k = 0;
+
+	while (k < n) {
+		int64_t key = bk[k].key;
+
+		//키가 범위를 벗어난 페이지는 pin을 풀고 올라간다
+		while (depth > 0 && !(key >= path[depth].lo && (path[depth].hi_inf || key < path[depth].hi))) {
+			if (path[depth].frame >= 0) clearPin(path[depth].frame);
+			depth--;
+		}
+
+		//리프까지 내려간다, 끝나면 리프 f는 page latch를 잡은 상태
+		int f;
+		while (1) {
+			batch_path * bp = &path[depth];
+			f = bp->frame;
+			if (f >= 0) {
+				//pin을 잡아뒀던 프레임이라 내려가지 않았다, 그래도 close_table이 내렸으면 다시 scan
+				pageLatchShared(f);
+				if (b_M.frameArray[f].table_id != table_id || b_M.frameArray[f].page_num != bp->page_num) {
+					pageUnlatch(f);
+					clearPin(f);
+					f = -1;
+				}
+			}
+			if (f < 0) {
+				f = pageScanShared(table_id, bp->page_num);
+				bp->frame = f;
+			}
+			if (b_M.frameArray[f].frame_p->is_leaf) break;
+			if (depth + 1 >= BATCH_DEPTH) {
+				clearPin(f);
+				pageUnlatch(f);
+				bp->frame = -1;
+				ret = FAIL;
+				break;
+			}
+
+			page_t * pg = b_M.frameArray[f].frame_p;
+			int i = node_search(pg, pg->num_key, key);
+
+			batch_path * c = &path[depth + 1];
+			c->frame = -1;
+			c->page_num = node_child(pg, i);
+			c->lo = (i >= 0) ? node_key(pg, i) : bp->lo;
+			if (i + 1 < pg->num_key) {
+				c->hi = node_key(pg, i + 1);
+				c->hi_inf = 0;
+			}
+			else {
+				c->hi = bp->hi;
+				c->hi_inf = bp->hi_inf;
+			}
+			c->pf_k = 0;
+
+			//남은 키들이 갈 자식들을 모아뒀다가 latch를 놓은 뒤 한번에 읽는다 (miss가 여러개면 queue depth만큼 겹친다)
+			pagenum_t pf[PREFETCH_MAX];
+			int m = 0;
+			if (b_opt.io_uring && bp->pf_k <= k) {
+				int j = k;
+				while (j < n && m < PREFETCH_MAX && (bp->hi_inf || bk[j].key < bp->hi)) {
+					int ci = node_search(pg, pg->num_key, bk[j].key);
+					pagenum_t child = node_child(pg, ci);
+					if (m == 0 || pf[m - 1] != child) pf[m++] = child;
+					j++;
+				}
+				bp->pf_k = j;
+			}
+			//인터널은 pin만 남기고 latch는 푼다
+			pageUnlatch(f);
+			if (m > 1) pagePrefetch(table_id, pf, m);
+			depth++;
+		}
+		if (ret != SUCCESS) break;
+
+		//이 리프 범위에 들어가는 키들을 차례로 처리
+		int leaf = f;
+		batch_path * lp = &path[depth];
+		if (!smo_read_validate(table_id, smo)) {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			lp->frame = -1;
+			batch_drop(path, depth);
+			goto reset;
+		}
+		while (k < n && bk[k].key >= lp->lo && (lp->hi_inf || bk[k].key < lp->hi)) {
+			key = bk[k].key;
+			int i = leaf_find(&b_leaf, key);
+
+			if (i < b_leaf.num_key && t->snap >= 0) {
+				strcpy(out[bk[k].pos], leaf_val(&b_leaf, i));
+				if (mvcc_read(table_id, key, out[bk[k].pos], t->snap) == SUCCESS) found++;
+				else out[bk[k].pos][0] = '\0';
+			}
+			else if (i < b_leaf.num_key) {
+				//db_find와 같이 page unlock -> record lock -> page lock
+				clearPin(leaf);
+				pageUnlatch(leaf);
+				tmp_l = lock_acquire(table_id, key, trx_id, 0);
+				leaf = page_relatch(table_id, lp->page_num, leaf, 1);
+				lp->frame = leaf;
+				if (tmp_l == NULL) {
+					ret = ABORT;
+					break;
+				}
+				if (!smo_read_validate(table_id, smo)) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					lp->frame = -1;
+					batch_drop(path, depth);
+					goto reset;
+				}
+				//기다리는 사이 자리가 바뀌었을 수 있으므로 다시 찾는다
+				i = leaf_find(&b_leaf, key);
+				if (i < b_leaf.num_key) {
+					strcpy(out[bk[k].pos], leaf_val(&b_leaf, i));
+					found++;
+				}
+			}
+			k++;
+		}
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		lp->frame = -1;
+		if (ret != SUCCESS) break;
+		if (depth > 0) depth--;
+	}
+
+	//남은 pin 해제
+	batch_drop(path, depth);
+	free(bk);
+
+	if (ret != SUCCESS) return ret;
+	return found;
+}
+
+//보조 인덱스
+//인덱스는 따로 연 테이블이고 엔트리 키는 (값의 앞 len바이트 << 63 - 8*len) | primary key, 값은 비워둔다
+//엔트리는 레코드보다 늦게 지우고(update한 trx의 commit) 찾을때 레코드를 다시 읽어 확인하므로 남은 엔트리는 걸러진다
+static char index_val[1];
+
+//값의 앞 len바이트를 big endian으로, NUL 뒤는 0
+static uint64_t index_code(const char * val, int len)
+{
+	uint64_t code = 0;
+	int end = 0;
+	for (int i = 0; i < len; i++) {
+		if (!end && val[i] == 0) end = 1;
+		code = code << 8 | (end ? 0 : (unsigned char)val[i]);
+	}
+	return code;
+}
+
+static int64_t index_entry(const char * val, int len, int64_t key)
+{
+	return (int64_t)(index_code(val, len) << (63 - 8 * len) | (uint64_t)key);
+}
+
+//인덱스가 있는 테이블의 primary key는 가장 긴 len의 엔트리 키에 들어가야 한다
+static int index_key_ok(Table * tb, int64_t key)
+{
+	for (int j = 0; j < tb->index_num; j++)
+		if (key < 0 || key >= (int64_t)1 << (63 - 8 * tb->index_len[j])) return 0;
+	return 1;
+}
+
+//db_scan callback에 넘길 자리가 없어서 쓰레드마다 모은다
+static __thread int64_t * index_buf;
+static __thread int64_t index_buf_num;
+static __thread int64_t index_buf_cap;
+static __thread int64_t index_buf_pos;//bulk load로 넘겨준 수
+static __thread int index_build_len;//만드는 인덱스의 len, 범위 밖의 key를 만나면 -1
+
+static int index_buf_push(int64_t k)
+{
+	if (index_buf_num == index_buf_cap) {
+		int64_t cap = index_buf_cap ? index_buf_cap * 2 : 1024;
+		int64_t * p = (int64_t*)realloc(index_buf, cap * sizeof(int64_t));
+		if (!p) return FAIL;
+		index_buf = p;
+		index_buf_cap = cap;
+	}
+	index_buf[index_buf_num++] = k;
+	return SUCCESS;
+}
+
+static int index_collect_cb(int64_t key, const char * val)
+{
+	(void)val;
+	return index_buf_push(key) != SUCCESS;
+}
+
+static int index_build_cb(int64_t key, const char * val)
+{
+	if (key < 0 || key >= (int64_t)1 << (63 - 8 * index_build_len)) {
+		index_build_len = -1;
+		return 1;
+	}
+	return index_buf_push(index_entry(val, index_build_len, key)) != SUCCESS;
+}
+
+static int index_bulk_next(key_val * rec)
+{
+	if (index_buf_pos == index_buf_num) return 0;
+	rec->key = index_buf[index_buf_pos++];
+	rec->val[0] = 0;
+	return 1;
+}
+
+static int index_cmp(const void * a, const void * b)
+{
+	int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+//헤더에 남긴 인덱스들을 연다, 열지 못한 인덱스부터는 쓰지 않는다
+static void index_load(int table_id)
+{
+	Table * tb = table_get(table_id);
+	index_desc d[INDEX_MAX];
+	int head = pageScanShared(table_id, 0);
+	int n = b_head.index_num;
+	if (n < 0 || n > INDEX_MAX) n = 0;
+	memcpy(d, b_head.index, sizeof(index_desc) * n);
+	clearPin(head);
+	pageUnlatch(head);
+
+	tb->index_num = 0;
+	for (int j = 0; j < n; j++) {
+		int idx = open_table_layout(d[j].path, b_opt.node_layout, LEAF_SLOT);
+		if (idx == FAIL) {
+			printf("index open failed : %s\n", d[j].path);
+			break;
+		}
+		tb->index_table[j] = idx;
+		tb->index_len[j] = d[j].len;
+		tb->index_num++;
+	}
+}
+
+//값의 앞 prefix_len바이트로 찾는 인덱스를 index_path에 만들고 인덱스 번호(0부터)를 리턴, 실패시 FAIL
+//지금 있는 레코드로 엔트리를 정렬해서 bulk load하고 헤더에 남겨 다음에 열때 같이 연다
+//엔트리 값이 비어있으므로 인덱스는 LEAF_SLOT으로 만든다
+//DDL이라 다른 trx가 이 테이블을 쓰지 않을때 부른다, key가 엔트리에 들어가지 않는 레코드가 있으면 FAIL
+int db_create_index(int table_id, char * index_path, int prefix_len)
+{
+	if (!table_isopen(table_id) || prefix_len < 1 || prefix_len > INDEX_LEN) return FAIL;
+	if (strlen(index_path) >= sizeof(((index_desc*)0)->path)) return FAIL;
+	Table * tb = table_get(table_id);
+	if (tb->map || tb->index_num == INDEX_MAX) return FAIL;
+
+	int idx = open_table_layout(index_path, b_opt.node_layout, LEAF_SLOT);
+	if (idx == FAIL) return FAIL;
+	if (idx == table_id || table_get(idx)->index_num > 0) return FAIL;
+	for (int j = 0; j < tb->index_num; j++)
+		if (tb->index_table[j] == idx) return FAIL;
+	int head = pageScanShared(idx, 0);
+	pagenum_t root = b_head.root_page;
+	clearPin(head);
+	pageUnlatch(head);
+	if (root != 0) return FAIL;
+
+	int trx_id = trx_begin();
+	if (trx_id <= 0) return FAIL;
+	index_buf_num = 0;
+	index_build_len = prefix_len;
+	int n = db_scan(table_id, INT64_MIN, INT64_MAX, index_build_cb, trx_id);
+	if (trx_get(trx_id)) trx_commit(trx_id);
+	else n = ABORT;
+	if (n < 0 || index_build_len < 0 || n != index_buf_num) return FAIL;
+
+	if (index_buf_num > 0) {
+		qsort(index_buf, index_buf_num, sizeof(int64_t), index_cmp);
+		index_buf_pos = 0;
+		if (db_bulk_load(idx, index_buf_num, index_bulk_next, 90) != SUCCESS) return FAIL;
+	}
+
+	head = pageScan(table_id, 0);
+	pageWriteBegin(head);
+	int no = b_head.index_num;
+	b_head.index[no].len = prefix_len;
+	strcpy(b_head.index[no].path, index_path);
+	b_head.index_num++;
+	pageWriteEnd(head);
+	setDirty(head);
+	clearPin(head);
+	pageUnlatch(head);
+
+	tb->index_table[no] = idx;
+	tb->index_len[no] = prefix_len;
+	tb->index_num++;
+	return no;
+}
+
+//index_no번 인덱스로 값이 prefix로 시작하는 레코드를 (값의 앞부분, key) 순으로 callback에 넘긴다
+//엔트리 구간을 db_scan한 뒤 레코드마다 db_find로 다시 읽어 (lock은 primary 레코드에 S) 값이 엔트리와 같은지 본다
+//넘겨준 레코드 수 리턴 / lock 실패시 ABORT
+int db_find_index(int table_id, int index_no, const char * prefix, scan_callback callback, int trx_id)
+{
+	if (!table_isopen(table_id) || !trx_get(trx_id)) return FAIL;
+	Table * tb = table_get(table_id);
+	if (index_no < 0 || index_no >= tb->index_num) return FAIL;
+	int len = tb->index_len[index_no];
+	int shift = 63 - 8 * len;
+	int plen = strlen(prefix);
+
+	//prefix가 len보다 짧으면 남은 바이트는 0 ~ 0xFF, 길면 앞 len바이트로 찾고 나머지는 값을 읽어 거른다
+	uint64_t lo = 0, hi = 0;
+	for (int i = 0; i < len; i++) {
+		lo = lo << 8 | (i < plen ? (unsigned char)prefix[i] : 0);
+		hi = hi << 8 | (i < plen ? (unsigned char)prefix[i] : 0xFF);
+	}
+	index_buf_num = 0;
+	int n = db_scan(tb->index_table[index_no], (int64_t)(lo << shift), (int64_t)(hi << shift | (((uint64_t)1 << shift) - 1)), index_collect_cb, trx_id);
+	//scan이 lock을 기다리다 abort되면 trx가 없다
+	if (!trx_get(trx_id)) return ABORT;
+	if (n < 0) return n;
+
+	//callback이 다시 인덱스를 찾을 수 있으므로 옮겨둔다
+	int64_t num = index_buf_num;
+	int64_t * ent = (int64_t*)malloc((num ? num : 1) * sizeof(int64_t));
+	memcpy(ent, index_buf, num * sizeof(int64_t));
+
+	int cnt = 0;
+	char val[val_max];
+	for (int64_t j = 0; j < num; j++) {
+		int64_t key = ent[j] & (((int64_t)1 << shift) - 1);
+		//없는 키면 val을 건드리지 않으므로 NUL이 없는 값으로 채워둔다
+		memset(val, 1, sizeof(val));
+		if (db_find(table_id, key, val, trx_id) == ABORT) {
+			cnt = ABORT;
+			break;
+		}
+		//레코드가 없거나 값이 바뀌어 이 엔트리가 아닌 경우는 거른다 (바뀐 값의 엔트리가 따로 있다)
+		if (!memchr(val, 0, sizeof(val)) || index_entry(val, len, key) != ent[j] || strncmp(val, prefix, plen) != 0) continue;
+		cnt++;
+		if (callback(key, val)) break;
+	}
+	free(ent);
+	return cnt;
+}
+
+//update로 값이 바뀐 레코드의 인덱스, 새 엔트리는 같은 trx로 넣고 (abort하면 로그로 되돌아간다) 예전 엔트리는 commit때 지운다
+//primary key의 X lock을 commit까지 잡으므로 그 사이 다른 trx가 이 레코드의 엔트리를 건드리지 않는다
+static int index_update(Table * tb, int64_t key, const char * old, const char * val, int trx_id)
+{
+	for (int j = 0; j < tb->index_num; j++) {
+		int64_t o = index_entry(old, tb->index_len[j], key);
+		int64_t e = index_entry(val, tb->index_len[j], key);
+		if (o == e) continue;
+		//같은 trx에서 전에 있던 값으로 돌아왔으면 엔트리가 남아있어서 FAIL, 지울 목록에서만 뺀다
+		if (db_insert_trx(tb->index_table[j], e, index_val, trx_id) == ABORT) return ABORT;
+		trx_index_del(trx_id, tb->index_table[j], o, e);
+	}
+	return SUCCESS;
+}
+
+//key 레코드에 X lock을 받고 그 리프를 X로 잡아 프레임을 돌려주고 *i에 자리를 넣는다 (db_update, db_update_ref)
+//레코드가 없으면 FAIL, lock 실패시 ABORT
+//->E 모드, 앞에 누가 잡고 있다면 무조건 기다림
+static int update_latch(int table_id, int64_t key, int trx_id, int * i, lock_t ** lock)
+{
+	char str_tmp[val_max];
+	//find를 해서 해당 페이지를 읽어옴
+	//무사히 끝났다는건 데드락이 일어나지 않음을 의미하고 또한 이 lock이 wakeup한 상태라는 것임
+	int f_c = db_find(table_id, key, str_tmp, trx_id);
+	if (f_c == ABORT) {return ABORT;}
+
+	uint64_t smo;
+	int find_p;
+	pagenum_t pn;
+restart:
+	smo = smo_read_begin(table_id);
+	find_p = find_page_latch(table_id, key, trx_id, 0, &pn);
+	if (find_p == ABORT) {return ABORT;}
+	else if (find_p == FAIL) {return FAIL;}
+
+	if (!smo_read_validate(table_id, smo)) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		goto restart;
+	}
+	//db_find와 같이 이진탐색으로 찾은 레코드에만 lock
+	*i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+	//인덱스가 끝번이면 찾지못한것
+	if (*i == b_M.frameArray[find_p].frame_p->num_key) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return FAIL;
+	}
+
+	//레코드 lock은 latch를 놓고 기다린다 -> 레코드 언락 안함-> commit시에 함
+	clearPin(find_p);
+	pageUnlatch(find_p);
+	*lock = lock_acquire(table_id, key, trx_id, 1);
+	find_p = page_relatch(table_id, pn, find_p, 0);
+	if (*lock == NULL) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return ABORT;
+	}
+	if (!smo_read_validate(table_id, smo)) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		goto restart;
+	}
+	*i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+	if (*i == b_M.frameArray[find_p].frame_p->num_key) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return FAIL;
+	}
+	return find_p;
+}
+
+//update_latch로 잡은 리프의 i번째 레코드가 old에서 바뀐 뒤에 부른다
+//snapshot trx가 읽을 수 있게 덮어쓴 값을 version chain에 남기고 (page latch 안에서) 업데이트 로그를 남긴 뒤 리프를 놓는다
+static void update_log(int table_id, int64_t key, int find_p, int i, char * old, lock_t * lock, int trx_id)
+{
+	lock->change = 1;
+	mvcc_push(table_id, key, old, trx_id);
+	int LSN = log_update(trx_id, table_id, b_M.frameArray[find_p].page_num, key, old, leaf_val(b_M.frameArray[find_p].frame_p, i), i);
+	b_M.frameArray[find_p].frame_p->page_LSN = LSN;
+	setDirtyLSN(find_p, LSN);
+	//lock해제는 안함 commit 때까지 기다림
+	clearPin(find_p);
+	pageUnlatch(find_p);
+}
+
+//write batch : b_opt.update_batch면 db_update는 X lock만 받고 바꿀 값을 trx에 모아둔다
+//commit이나 batch가 찰때 로그 자리를 한번에 잡고, 키 순서로 정렬해 같은 리프의 레코드는 latch 한번으로 쓴다
+//LEAF_SLOT은 늘어난 값이 안 들어갈 수 있고 인덱스가 있으면 엔트리를 바로 고쳐야 해서 예전처럼 바로 쓴다
+static int wbatch_cap(void)
+{
+	return b_opt.update_batch < TRX_BATCH_MAX ? b_opt.update_batch : TRX_BATCH_MAX;
+}
+
+static int wbatch_able(int table_id)
+{
+	Table * tb = table_get(table_id);
+	return b_opt.update_batch > 0 && tb->leaf_layout == LEAF_RECORD && tb->index_num == 0;
+}
+
+//이 trx가 모아둔 그 키의 update, 없으면 NULL
+static wbatch_ent * wbatch_get(Trx * t, int table_id, int64_t key)
+{
+	for (int k = t->wbatch_num - 1; k >= 0; k--)
+		if (t->wbatch[k].key == key && t->wbatch[k].table_id == table_id) return &t->wbatch[k];
+	return NULL;
+}
+
+//같은 리프의 레코드가 이어지도록 (table_id, key) 순서
+static int wbatch_cmp(const void * a, const void * b)
+{
+	const wbatch_ent * x = (const wbatch_ent*)a;
+	const wbatch_ent * y = (const wbatch_ent*)b;
+	if (x->table_id != y->table_id) return x->table_id < y->table_id ? -1 : 1;
+	return (x->key > y->key) - (x->key < y->key);
+}
+
+//db_update의 batch 경로, 다시 고치는 키면 page를 보지 않고 new만 바꾼다
+static int wbatch_stage(Trx * t, int table_id, int64_t key, const char * val, int trx_id)
+{
+	wbatch_ent * e = wbatch_get(t, table_id, key);
+	if (!e) {
+		int i;
+		lock_t * tmp_l;
+		int find_p = update_latch(table_id, key, trx_id, &i, &tmp_l);
+		if (find_p == ABORT) return ABORT;
+		if (find_p == FAIL) return SUCCESS;
+		if (!t->wbatch) t->wbatch = (wbatch_ent*)malloc(sizeof(wbatch_ent) * wbatch_cap());
+		//X lock을 commit까지 잡으므로 지금 값을 old로 두면 flush때까지 이 trx 말고는 바꾸지 않는다
+		e = &t->wbatch[t->wbatch_num++];
+		e->table_id = table_id;
+		e->key = key;
+		e->off = i;
+		e->page_num = b_M.frameArray[find_p].page_num;
+		strcpy(e->old_image, leaf_val(b_M.frameArray[find_p].frame_p, i));
+		tmp_l->change = 1;
+		clearPin(find_p);
+		pageUnlatch(find_p);
+	}
+	strncpy(e->new_image, val, val_max - 1);
+	e->new_image[val_max - 1] = '\0';
+	if (t->wbatch_num == wbatch_cap()) db_wbatch_flush(t);
+	return SUCCESS;
+}
+
+//key가 있는 리프를 X로 잡고 *i에 자리를 넣는다, lock은 stage때 받았으므로 인터널 키 lock 없이 내려간다
+//non-trx db_delete가 지웠으면 FAIL
+static int wbatch_leaf(int table_id, int64_t key, int * i)
+{
+	uint64_t smo;
+	pagenum_t pn;
+	int find_p;
+restart:
+	smo = smo_read_begin(table_id);
+	if (find_leaf_olc(table_id, key, 0, 0, &pn) != SUCCESS) return FAIL;
+	find_p = pageScan(table_id, pn);
+	if (!smo_read_validate(table_id, smo)) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		goto restart;
+	}
+	*i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+	if (*i == b_M.frameArray[find_p].frame_p->num_key) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return FAIL;
+	}
+	return find_p;
+}
+
+int db_wbatch_flush(Trx * t)
+{
+	int n = t->wbatch_num;
+	if (n == 0) return SUCCESS;
+	t->wbatch_num = 0;
+	wbatch_ent * e = t->wbatch;
+	qsort(e, n, sizeof(wbatch_ent), wbatch_cmp);
+
+	//page보다 로그가 먼저, 레코드 n개의 자리를 한번에 잡는다
+	int64_t * LSN = (int64_t*)malloc(sizeof(int64_t) * n);
+	log_update_batch(t->trx_id, e, n, LSN);
+
+	int find_p = -1;
+	for (int k = 0; k < n; k++) {
+		int i = -1;
+		//앞 레코드와 같은 리프에 있으면 잡은 latch를 그대로 쓴다
+		if (find_p >= 0 && e[k].table_id == e[k - 1].table_id) {
+			i = leaf_find(b_M.frameArray[find_p].frame_p, e[k].key);
+			if (i == b_M.frameArray[find_p].frame_p->num_key) i = -1;
+		}
+		if (i < 0) {
+			if (find_p >= 0) {
+				clearPin(find_p);
+				pageUnlatch(find_p);
+			}
+			find_p = wbatch_leaf(e[k].table_id, e[k].key, &i);
+			if (find_p < 0) continue;
+		}
+		page_t * pg = b_M.frameArray[find_p].frame_p;
+		mvcc_push(e[k].table_id, e[k].key, e[k].old_image, t->trx_id);
+		leaf_update(pg, i, e[k].new_image);
+		pg->page_LSN = LSN[k];
+		setDirtyLSN(find_p, LSN[k]);
+	}
+	if (find_p >= 0) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+	}
+	free(LSN);
+	return SUCCESS;
+}
+
+//키에 해당하는 페이지를 읽어와서 레코드 수정 
+//성공시 0리턴 
+//실패시 nonzero -> abort 필요 -> 리턴 전에 release 다하고 undo
+//Abort였다면 ABORT리턴
+int db_update(int table_id, int64_t key, char * val, int trx_id)
+{
+	if (!table_isopen(table_id)) {
+		printf("File Is Closed\n");
+		return SUCCESS;
+	}
+
+	//trx 테이블에서 확인
+	Trx * t = trx_get(trx_id);
+	if (!t) {
+		return SUCCESS;
+	}
+	//snapshot trx와 mmap 테이블은 read only
+	if (t->snap >= 0 || table_get(table_id)->map) return FAIL;
+	if (wbatch_able(table_id)) return wbatch_stage(t, table_id, key, val, trx_id);
+
+	int i;
+	lock_t * tmp_l;
+	int find_p = update_latch(table_id, key, trx_id, &i, &tmp_l);
+	if (find_p == ABORT) return ABORT;
+	if (find_p == FAIL) return SUCCESS;
+
+	char old[val_max];
+	strcpy(old, leaf_val(b_M.frameArray[find_p].frame_p, i));
+	//LEAF_SLOT에서 늘어난 값이 들어갈 자리가 없으면 바꾸지 않는다
+	if (leaf_update(b_M.frameArray[find_p].frame_p, i, val) != SUCCESS) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return FAIL;
+	}
+	update_log(table_id, key, find_p, i, old, tmp_l, trx_id);
+
+	//인덱스는 page latch 밖에서
+	Table * tb = table_get(table_id);
+	if (tb->index_num > 0) return index_update(tb, key, old, val, trx_id);
+	return SUCCESS;
+}
+
+//db_find처럼 읽되 값을 복사하지 않고 잡아둔 프레임 안의 값을 *val로 넘긴다
+//찾았으면 SUCCESS, 리프를 S로 잡은 채라 다 읽으면 db_ref_release로 놓는다 (그 사이 다른 db_ 함수를 부르지 않는다)
+//없으면 FAIL, lock 실패시 ABORT (둘다 놓을 것이 없다)
+//snapshot trx는 begin 시점으로 되돌린 값을 ref 안에 두고 넘긴다
+int db_find_ref(int table_id, int64_t key, const char ** val, rec_ref * ref, int trx_id)
+{
+	ref->frame = -1;
+	ref->update = 0;
+	if (!table_isopen(table_id)) return FAIL;
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	//write batch에 모아둔 값이 보이도록 먼저 페이지에 쓴다
+	if (t->wbatch_num) db_wbatch_flush(t);
+	if (table_get(table_id)->map) {
+		//mmap 테이블은 파일을 바로 가리킨다
+		page_t * leaf = map_find_leaf(table_id, key);
+		if (!leaf) return FAIL;
+		int i = leaf_find(leaf, key);
+		if (i == leaf->num_key) return FAIL;
+		*val = leaf_val(leaf, i);
+		return SUCCESS;
+	}
+
+	uint64_t smo;
+	int find_p;
+	pagenum_t pn;
+	lock_t * tmp_l;
+restart:
+	smo = smo_read_begin(table_id);
+	find_p = find_page_latch(table_id, key, trx_id, 1, &pn);
+	if (find_p == ABORT) return ABORT;
+	if (find_p == FAIL) return FAIL;
+	if (!smo_read_validate(table_id, smo)) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		goto restart;
+	}
+	int i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+	if (i < b_M.frameArray[find_p].frame_p->num_key && t->snap < 0) {
+		//lock은 latch를 놓고 기다린다
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		tmp_l = lock_acquire(table_id, key, trx_id, 0);
+		find_p = page_relatch(table_id, pn, find_p, 1);
+		if (tmp_l == NULL) {
+			clearPin(find_p);
+			pageUnlatch(find_p);
+			return ABORT;
+		}
+		if (!smo_read_validate(table_id, smo)) {
+			clearPin(find_p);
+			pageUnlatch(find_p);
+			goto restart;
+		}
+		i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+	}
+	if (i == b_M.frameArray[find_p].frame_p->num_key) {
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		return FAIL;
+	}
+	if (t->snap >= 0) {
+		//begin 뒤에 들어온 레코드면 못 찾은 것
+		//page 값과 version chain이 어긋나지 않게 latch 안에서 되돌린다
+		strcpy(ref->copy, leaf_val(b_M.frameArray[find_p].frame_p, i));
+		int ret = mvcc_read(table_id, key, ref->copy, t->snap);
+		clearPin(find_p);
+		pageUnlatch(find_p);
+		if (ret != SUCCESS) return FAIL;
+		*val = ref->copy;
+		return SUCCESS;
+	}
+	//pin은 flag라 다른 reader가 풀 수 있으므로 S latch로 프레임을 붙잡아둔다
+	ref->frame = find_p;
+	*val = leaf_val(b_M.frameArray[find_p].frame_p, i);
+	return SUCCESS;
+}
+
+//db_update처럼 X lock을 받고 리프를 X로 잡은 채로 프레임 안의 값을 *val로 넘긴다, *cap은 NUL까지 쓸 수 있는 바이트 수
+//그 자리에 값을 고친 뒤 db_ref_release를 부르면 로그와 version을 남기고 리프를 놓는다 (LEAF_SLOT은 지금 값보다 길게 못 쓴다)
+//찾았으면 SUCCESS, 없으면 FAIL, lock 실패시 ABORT
+int db_update_ref(int table_id, int64_t key, char ** val, int * cap, rec_ref * ref, int trx_id)
+{
+	ref->frame = -1;
+	ref->update = 0;
+	if (!table_isopen(table_id)) return FAIL;
+	Trx * t = trx_get(trx_id);
+	if (!t || t->snap >= 0 || table_get(table_id)->map) return FAIL;
+	//write batch에 모아둔 값이 보이도록 먼저 페이지에 쓴다
+	if (t->wbatch_num) db_wbatch_flush(t);
+
+	int i;
+	lock_t * tmp_l;
+	int find_p = update_latch(table_id, key, trx_id, &i, &tmp_l);
+	if (find_p < 0) return find_p;
+
+	page_t * pg = b_M.frameArray[find_p].frame_p;
+	strcpy(ref->copy, leaf_val(pg, i));
+	ref->frame = find_p;
+	ref->update = 1;
+	ref->table_id = table_id;
+	ref->key = key;
+	ref->slot = i;
+	ref->lock = tmp_l;
+	ref->trx_id = trx_id;
+	*val = leaf_val(pg, i);
+	*cap = pg->leaf_layout == LEAF_SLOT ? pg->slot[i].len : (int)sizeof(pg->record[i].val);
+	return SUCCESS;
+}
+
+//db_find_ref, db_update_ref가 잡아둔 리프를 놓는다
+//update면 고친 값이 바뀌었을때만 로그를 남기고, 인덱스는 리프를 놓은 뒤에 고친다
+int db_ref_release(rec_ref * ref)
+{
+	int f = ref->frame;
+	ref->frame = -1;
+	if (f < 0) return SUCCESS;
+	if (!ref->update) {
+		clearPin(f);
+		pageUnlatch(f);
+		return SUCCESS;
+	}
+
+	ref->update = 0;
+	page_t * pg = b_M.frameArray[f].frame_p;
+	char * val = leaf_val(pg, ref->slot);
+	if (strcmp(val, ref->copy) == 0) {
+		clearPin(f);
+		pageUnlatch(f);
+		return SUCCESS;
+	}
+	leaf_update_inplace(pg, ref->slot);
+	char now[val_max];
+	strcpy(now, val);
+	update_log(ref->table_id, ref->key, f, ref->slot, ref->copy, ref->lock, ref->trx_id);
+
+	Table * tb = table_get(ref->table_id);
+	if (tb->index_num > 0) return index_update(tb, ref->key, ref->copy, now, ref->trx_id);
+	return SUCCESS;
+}
+
+//////////////////////////////////////////// cursor
+//키 순서로 읽는 쪽이 db_find를 키마다 부르면 매번 루트부터 내려간다
+//cursor는 마지막으로 읽은 리프에 pin을 남겨두고 다음 호출에서 그 리프를 바로 잡아 slot 다음부터 이어 읽는다
+//smo_seq가 그대로면 리프가 맡는 키 범위도 그대로라 그 리프에서 찾은 결과를 믿을 수 있다, 바뀌었으면 from부터 다시 내려간다
+//레코드마다 db_find와 같이 S lock (snapshot trx는 lock 없이 begin 시점의 값)
+//인터널 키 lock은 잡지 않고 phantom도 막지 않으므로 범위 전체가 필요하면 db_scan을 쓴다
+
+int db_cursor_open(db_cursor * c, int table_id, int trx_id)
+{
+	c->table_id = table_id;
+	c->trx_id = trx_id;
+	c->frame = -1;
+	c->page_num = 0;
+	c->slot = 0;
+	c->page_LSN = -1;
+	c->smo = 0;
+	c->key = 0;
+	c->valid = 0;
+	if (!table_isopen(table_id) || !trx_get(trx_id)) return FAIL;
+	return SUCCESS;
+}
+
+int db_cursor_close(db_cursor * c)
+{
+	if (c->frame >= 0) clearPin(c->frame);
+	c->frame = -1;
+	c->valid = 0;
+	return SUCCESS;
+}
+
+//잡아둔 pin으로 리프를 다시 S로 잡는다
+//그 사이 프레임에 다른 페이지가 올라왔거나 트리 모양이 바뀌었으면 pin을 놓고 -1
+static int cursor_relatch(db_cursor * c)
 {
+	int f = c->frame;
+	if (f < 0) return -1;
+	c->frame = -1;
+	pageLatchShared(f);
+	if (b_M.frameArray[f].table_id == c->table_id && b_M.frameArray[f].page_num == c->page_num
+		&& b_M.frameArray[f].frame_p->is_leaf && smo_read_validate(c->table_id, c->smo)) return f;
+	clearPin(f);
+	pageUnlatch(f);
+	return -1;
+}
 
-	//if(b_M.frameArray==NULL) init_db(500);
-	int i;
-	char * str_tmp= (char *)malloc(120);
-	//printf("\ndb update start[%d]\n",trx_id);
-	//find ؼ ش  о-E
-	// ٴ°  Ͼ  ǹϰ   lock wakeup ¶ 
-	//->Լ  Ұ 
-	if (b_M.table[table_id - 1].isopen == 0) {
-		printf("File Is Closed\n");
-		return SUCCESS;
+//cursor의 mmap 테이블 버전, 고치는 쪽이 없으므로 pin 없이 매번 포인터로 리프까지 내려간다
+static int cursor_map(db_cursor * c, int64_t from, int64_t * found, char * val)
+{
+	const Table * tb = table_get(c->table_id);
+	page_t * leaf = map_find_leaf(c->table_id, from);
+
+	//리프 수보다 많이 돌면 깨진 체인
+	for (pagenum_t n = 0; leaf != NULL && n < tb->map_pages; n++) {
+		for (int i = leaf_search(leaf, leaf->num_key, from); i < leaf->num_key; i++) {
+			if (leaf_dead(leaf, i)) continue;
+			*found = c->key = leaf_key(leaf, i);
+			strcpy(val, leaf_val(leaf, i));
+			c->valid = 1;
+			return SUCCESS;
+		}
+		leaf = map_page(tb, leaf->right_left);
 	}
+	c->valid = 0;
+	return FAIL;
+}
 
-	//trx ̺ Ȯ
-	if (!trx_find(trx_id)) {
-		//printf("db update : not exist trx\n");
-		return SUCCESS;
+//from 이상에서 살아있는 첫 레코드를 *found, val에 넘기고 그 리프에 pin을 남긴다
+//next가 1이면 잡아둔 리프에서 이어 읽고, 0이면 from이 잡아둔 리프의 첫 키와 끝 키 사이일때만 그 리프에서 찾는다
+//없으면 FAIL, lock 실패시 ABORT (둘다 pin을 놓는다)
+static int cursor_fetch(db_cursor * c, int64_t from, int next, int64_t * found, char * val)
+{
+	int table_id = c->table_id;
+	int trx_id = c->trx_id;
+	Trx * t = trx_get(trx_id);
+	if (!t || !table_isopen(table_id)) {
+		db_cursor_close(c);
+		return FAIL;
 	}
-	
-//printf("db update[%d] 1\n",trx_id);
-	int f_c = db_find(table_id, key, str_tmp, trx_id);
-	
-	if (f_c == ABORT) {return ABORT;}
-
-//printf("db update[%d] 2\n",trx_id);
-	int find_p = find_page(table_id, key,trx_id,0);
-	
-	//۶  ۾
-	
-	if (find_p == ABORT) {return ABORT;}
-	else if (find_p == FAIL) {return SUCCESS;}
-//printf("db update[%d] 3\n",trx_id);
+	//write batch에 모아둔 값이 보이도록 먼저 페이지에 쓴다
+	if (t->wbatch_num) db_wbatch_flush(t);
+	if (table_get(table_id)->map) return cursor_map(c, from, found, val);
 
-	setPin(find_p);
-	pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
-//printf("db update [%d] lock page [%d]\n",trx_id,find_p);
+	pagenum_t leaf_num = c->page_num;
 	lock_t * tmp_l;
-	for (i = 0; i < b_M.frameArray[find_p].frame_p.num_key; i++)
-	{
-		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-		//printf("db update[%d] : page unlock-1 [%d] before acquire lock \n",trx_id,find_p);
-		tmp_l=lock_acquire(table_id,b_M.frameArray[find_p].frame_p.record[i].key,trx_id,0);
-		setPin(find_p);
-		pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
-		//printf("db update[%d] : page lock [%d] after acquire lock \n",trx_id,find_p);
-		if(tmp_l==NULL){
-			//printf("db update : lock acquire failed-1\n");
-			clearPin(find_p);
-			pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-//printf("db update[%d] : page unlock [%d] FINISH \n",trx_id,find_p);
-//printf("abort2\n");
-			return ABORT;
-		}	
-		if (b_M.frameArray[find_p].frame_p.record[i].key == key) {
-			
-			break;
-				
+	int i = 0;
+	int leaf = cursor_relatch(c);
+	if (leaf >= 0) {
+		int n = b_leaf.num_key;
+		//리프가 그대로면 넘겨준 자리 바로 다음, 아니면 리프 안에서 이진탐색
+		if (next && b_leaf.page_LSN == c->page_LSN && c->slot < n && leaf_key(&b_leaf, c->slot) == c->key) i = c->slot + 1;
+		else if (next || (n > 0 && leaf_key(&b_leaf, 0) <= from && from <= leaf_key(&b_leaf, n - 1))) i = leaf_search(&b_leaf, n, from);
+		else {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			leaf = -1;
 		}
 	}
-
-		//ε  ƴ϶ ãѰ - break  ƴ϶ 
-	if (i == b_M.frameArray[find_p].frame_p.num_key) {
-		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-		//printf("not find the date\n")
-		//printf("db find[%d] : page unlock-1 [%d] \n",trx_id,find_p);
-		return SUCCESS;
+	c->valid = 0;
+
+restart:
+	if (leaf < 0) {
+		STAT_ADD(stat_table_get(table_id)->cursor_descend, 1);
+		c->smo = smo_read_begin(table_id);
+		//빈트리
+		if (find_leaf_olc(table_id, from, 0, 0, &leaf_num) != SUCCESS) return FAIL;
+		leaf = pageScanShared(table_id, leaf_num);
+		if (!smo_read_validate(table_id, c->smo)) {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			leaf = -1;
+			goto restart;
+		}
+		i = leaf_search(&b_leaf, b_leaf.num_key, from);
 	}
+	else STAT_ADD(stat_table_get(table_id)->cursor_hit, 1);
+
+	while (1) {
+		for (; i < b_leaf.num_key; i++) {
+			int64_t key = leaf_key(&b_leaf, i);
+			if (key < from || leaf_dead(&b_leaf, i)) continue;
+
+			if (t->snap >= 0) {
+				//begin 뒤에 들어온 레코드는 건너뛴다
+				char v[val_max];
+				strcpy(v, leaf_val(&b_leaf, i));
+				if (mvcc_read(table_id, key, v, t->snap) != SUCCESS) continue;
+				strcpy(val, v);
+			}
+			else {
+				//db_find와 같이 page unlock -> record lock -> page lock
+				clearPin(leaf);
+				pageUnlatch(leaf);
+				tmp_l = lock_acquire(table_id, key, trx_id, 0);
+				leaf = page_relatch(table_id, leaf_num, leaf, 1);
+				if (tmp_l == NULL) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					return ABORT;
+				}
+				if (!smo_read_validate(table_id, c->smo)) {
+					clearPin(leaf);
+					pageUnlatch(leaf);
+					leaf = -1;
+					goto restart;
+				}
+				//기다리는 사이 레코드가 밀렸거나 지워졌거나 from과 key 사이에 새 키가 들어왔을 수 있으니 from부터 다시 본다
+				int j = leaf_search(&b_leaf, b_leaf.num_key, from);
+				while (j < b_leaf.num_key && leaf_dead(&b_leaf, j)) j++;
+				if (j == b_leaf.num_key || leaf_key(&b_leaf, j) != key) {
+					i = j - 1;
+					continue;
+				}
+				i = j;
+				strcpy(val, leaf_val(&b_leaf, i));
+			}
 
-
-
-//printf("db_update[%d]: find end------ find, pre val=%s\n",trx_id,b_M.frameArray[find_p].frame_p.record[i].val);
-//̰ ڵ ۾ S (abortȮ) -> ڵ  -> commitÿ 
-		clearPin(find_p);
-		pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-		//printf("db update[%d] : page unlock-2 [%d] before acquire lock \n",trx_id,find_p);
-		tmp_l=lock_acquire(table_id,b_M.frameArray[find_p].frame_p.record[i].key,trx_id,1);
-		setPin(find_p);
-//printf("seg?..\n");
-		pthread_mutex_lock(&b_M.frameArray[find_p].page_latch);
-		//printf("db update[%d] : page lock [%d] after acquire lock \n",trx_id,find_p);
-		if(tmp_l==NULL){
-			//printf("db update : lock acquire failed-2\n");
-			clearPin(find_p);
-			pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-//printf("db update[%d] : page unlock [%d] FINISH \n",trx_id,find_p);
-			//printf("abort3\n");
-			return ABORT;
+			//latch만 놓고 pin은 다음 호출까지 남긴다
+			*found = key;
+			c->frame = leaf;
+			c->page_num = leaf_num;
+			c->slot = i;
+			c->page_LSN = b_leaf.page_LSN;
+			c->key = key;
+			c->valid = 1;
+			pageUnlatch(leaf);
+			return SUCCESS;
 		}
-		
-		char *old=(char*)malloc(120);
-		tmp_l->change = 1;
-		strcpy(old, b_M.frameArray[find_p].frame_p.record[i].val);
-		strcpy(b_M.frameArray[find_p].frame_p.record[i].val,val);
-
-		//Ʈ α ߻
-	//int log_update(int trx_id,int table_id,int64_t page_num,char* old_image,char* new_image);
-		int LSN=log_update(trx_id, table_id, find_p, old, val, i);
-		b_M.frameArray[find_p].frame_p.page_LSN = LSN;
-		
 
-	//lock  commit  ٸ
-	//printf("db update[%d] SUCCESS end, change val=%s\n",trx_id,val);
-	clearPin(find_p);
-	pthread_mutex_unlock(&b_M.frameArray[find_p].page_latch);
-//printf("dp update[%d] : mutex unlock [%d] FINISH \n",trx_id,find_p);
+		//리프 끝이면 오른쪽 리프로
+		pagenum_t right = b_leaf.right_left;
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		if (right == 0) return FAIL;
+		leaf_num = right;
+		leaf = pageScanShared(table_id, leaf_num);
+		if (!smo_read_validate(table_id, c->smo)) {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			leaf = -1;
+			goto restart;
+		}
+		i = leaf_search(&b_leaf, b_leaf.num_key, from);
+	}
+}
 
+//key 이상인 첫 레코드로 옮겨 *found, val에 넘긴다
+//key가 잡아둔 리프의 키 사이면 루트부터 내려가지 않고 그 리프에서 찾는다
+//뒤에 레코드가 없으면 FAIL, lock 실패시 ABORT
+int db_cursor_seek(db_cursor * c, int64_t key, int64_t * found, char * val)
+{
+	return cursor_fetch(c, key, 0, found, val);
+}
 
-	
-	
-	
-	return SUCCESS;
+//마지막으로 넘겨준 키 다음 레코드로 옮긴다
+//seek 전이거나 이미 끝까지 갔으면 FAIL
+int db_cursor_next(db_cursor * c, int64_t * found, char * val)
+{
+	if (!c->valid || c->key == INT64_MAX) {
+		db_cursor_close(c);
+		return FAIL;
+	}
+	return cursor_fetch(c, c->key + 1, 1, found, val);
 }
 
 
 
 
-//5 Ʒ Լ  ϱ
+//5번할일 아래 함수 다 수정하기
 
-//Լ  0 н -1 
+//함수 성공시 0리턴 실패시 -1 리턴
 int ch;
 
-// : page lock  Ȯ  ְ
+//수정 : page lock 상태 확인할 수 있게
 void bufInfo() {
 	//if(b_M.frameArray==NULL) init_db(500);
 	printf("\n<buffer info>\n");
 	printf("table use : %d\n", b_M.table_use);
 	printf("table total : %d\n", b_M.table_total);
-	printf("use num : %d\n", b_M.use_num);
-	printf("LRU head : %d\n", b_M.LRU_head);
-	printf("LRU tail : %d\n", b_M.LRU_tail);
+	printf("page region : %zu byte / %s\n", b_M.region_size,
+		b_M.region_huge == REGION_HUGETLB ? "hugetlb" : b_M.region_huge == REGION_THP ? "thp" : "plain");
+	for (int p = 0; p < b_M.part_num; p++) {
+		printf("part %d [%d, %d) : use num = %d, LRU head = %d, LRU tail = %d, node = %d\n", p,
+			b_M.part[p].begin, b_M.part[p].end, b_M.part[p].use_num, b_M.part[p].LRU_head, b_M.part[p].LRU_tail,
+			b_M.part[p].node);
+	}
 
 	for (int i = 0; i < b_M.frame_capacity; i++) {
 		printf("%d : tableid,pagenum = (%d,%ld), next = %d, pre = %d \n", i, b_M.frameArray[i].table_id, b_M.frameArray[i].page_num,
 			b_M.frameArray[i].next, b_M.frameArray[i].pre);
-		printf("ispinned=%d, isdirty=%d\n", b_M.frameArray[i].ispinned, b_M.frameArray[i].isdirty);
+		printf("pin=%d, isdirty=%d\n", b_M.frameArray[i].pin, b_M.frameArray[i].isdirty);
 
 		if (b_M.frameArray[i].page_num != 0) {
 			printf("parent = %ld / is leaf = %d / num key = %d / right_left = %ld\n",
-				b_M.frameArray[i].frame_p.parent, b_M.frameArray[i].frame_p.is_leaf,
-				b_M.frameArray[i].frame_p.num_key, b_M.frameArray[i].frame_p.right_left);
+				b_M.frameArray[i].frame_p->parent, b_M.frameArray[i].frame_p->is_leaf,
+				b_M.frameArray[i].frame_p->num_key, b_M.frameArray[i].frame_p->right_left);
 		}
 		else if (b_M.frameArray[i].table_id != 0) {
 			printf("it is head\n");
@@ -383,12 +2233,339 @@ void bufInfo() {
 }
 
 
-//pin   
+//flusher 통계
+void flushInfo() {
+	printf("\n<flush info>\n");
+	printf("flusher : %s\n", b_M.flusher_run ? "on" : "off");
+	printf("round : %" PRIu64 "\n", b_M.flush_round);
+	printf("flushed page : %" PRIu64 " / pwritev : %" PRIu64 "\n", b_M.flush_page, b_M.flush_write);
+	printf("sync write in pageDrop : %" PRIu64 "\n", b_M.sync_write);
+}
+
+void mergeInfo() {
+	printf("\n<merge info>\n");
+	printf("merger : %s\n", b_M.merger_run ? "on" : "off");
+	printf("waiting leaf : %d\n", b_M.merge_num);
+	printf("merged leaf : %" PRIu64 " / redistributed : %" PRIu64 "\n", b_M.merge_done, b_M.merge_moved);
+}
+
+void statInfo() {
+	db_stat s;
+	db_stats(&s);
+	printf("\n<stat info> %.1fs\n", s.sec);
+	uint64_t get = s.total.hit + s.total.miss;
+	printf("hit : %" PRIu64 " / miss : %" PRIu64 " (%.2f%%)\n", s.total.hit, s.total.miss, get ? 100.0 * s.total.hit / get : 0.0);
+	printf("evict : %" PRIu64 " / dirty write : %" PRIu64 " / bad checksum : %" PRIu64 "\n", s.total.evict, s.total.dirty_write, s.total.bad_page);
+	if (s.total.ring_reuse) printf("scan ring reuse : %" PRIu64 "\n", s.total.ring_reuse);
+	if (s.total.cursor_hit + s.total.cursor_descend) printf("cursor leaf hit : %" PRIu64 " / descend : %" PRIu64 "\n", s.total.cursor_hit, s.total.cursor_descend);
+	if (b_M.ahi) printf("adaptive hash hit : %" PRIu64 " / indexed key : %" PRIu64 "\n", s.total.ahi_hit, s.total.ahi_build);
+	for (int i = 1; i <= b_M.table_total; i++) {
+		stat_table t;
+		if (db_table_stats(i, &t) == SUCCESS && t.hit + t.miss > 0)
+			printf("  table %d : hit %" PRIu64 " / miss %" PRIu64 " / evict %" PRIu64 " / dirty write %" PRIu64 "\n", i, t.hit, t.miss, t.evict, t.dirty_write);
+	}
+	printf("buf latch wait : %" PRIu64 " (%.3fms) / lock latch wait : %" PRIu64 " (%.3fms)\n",
+		s.latch_wait[STAT_BUF_LATCH], s.latch_ns[STAT_BUF_LATCH] / 1e6, s.latch_wait[STAT_LOCK_LATCH], s.latch_ns[STAT_LOCK_LATCH] / 1e6);
+	printf("lock wait : %" PRIu64 " (%.3fms) / deadlock abort : %" PRIu64 " / timeout abort : %" PRIu64 "\n",
+		s.lock_wait, s.lock_ns / 1e6, s.dead_abort, s.timeout_abort);
+	printf("log : %" PRIu64 " byte (%.0f byte/s)\n", s.log_byte, s.log_byte_sec);
+}
+
+//////////////////////////////////////////// 통계
+
+static pthread_mutex_t stat_list_latch = PTHREAD_MUTEX_INITIALIZER;
+static stat_local * stat_head;//한번 들어간 stat_local은 빠지지 않는다
+static pthread_key_t stat_key;
+static pthread_once_t stat_once = PTHREAD_ONCE_INIT;
+static __thread stat_local * stat_my;
+static __thread stat_table stat_dummy;//table_id가 범위 밖이거나 할당에 실패했을때 대신 더하는 곳
+static uint64_t stat_start;//stat_reset 시각
+static int64_t stat_log_start;//stat_reset때의 log_now
+
+uint64_t stat_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//쓰레드가 끝날때 자기 stat_local을 내놓는다, 누적값은 남겨둔다
+static void stat_exit(void * p)
+{
+	pthread_mutex_lock(&stat_list_latch);
+	((stat_local*)p)->used = 0;
+	pthread_mutex_unlock(&stat_list_latch);
+}
+
+static void stat_key_init()
+{
+	pthread_key_create(&stat_key, stat_exit);
+}
+
+//이 쓰레드의 stat_local, 처음이면 끝난 쓰레드 것을 이어받거나 새로 만들어 리스트에 넣는다
+stat_local * stat_get()
+{
+	if (stat_my) return stat_my;
+	pthread_once(&stat_once, stat_key_init);
+	pthread_mutex_lock(&stat_list_latch);
+	stat_local * s;
+	for (s = stat_head; s; s = s->next)
+		if (!s->used) break;
+	if (!s) {
+		s = (stat_local*)calloc(1, sizeof(stat_local));
+		if (!s) {
+			pthread_mutex_unlock(&stat_list_latch);
+			return NULL;
+		}
+		s->next = stat_head;
+		__atomic_store_n(&stat_head, s, __ATOMIC_RELEASE);
+	}
+	s->used = 1;
+	pthread_mutex_unlock(&stat_list_latch);
+	pthread_setspecific(stat_key, s);
+	stat_my = s;
+	return s;
+}
+
+//이 쓰레드가 table_id에 더할 stat_table
+stat_table * stat_table_get(int table_id)
+{
+	stat_local * s = stat_get();
+	if (!s || table_id < 1 || table_id >= TABLE_MAX) return &stat_dummy;
+	stat_table * c = s->table[table_id / TABLE_CHUNK];
+	if (!c) {
+		c = (stat_table*)calloc(TABLE_CHUNK, sizeof(stat_table));
+		if (!c) return &stat_dummy;
+		__atomic_store_n(&s->table[table_id / TABLE_CHUNK], c, __ATOMIC_RELEASE);
+	}
+	return &c[table_id % TABLE_CHUNK];
+}
+
+//latch를 잡는다, 바로 못잡았을때만 기다린 시간을 잰다
+void stat_latch(pthread_mutex_t * latch, int kind)
+{
+	if (pthread_mutex_trylock(latch) == 0) return;
+	uint64_t t = stat_ns();
+	pthread_mutex_lock(latch);
+	stat_local * s = stat_get();
+	if (!s) return;
+	STAT_ADD(s->latch_wait[kind], 1);
+	STAT_ADD(s->latch_ns[kind], stat_ns() - t);
+	TRACE(TRACE_LATCH, t, kind, 0);
+}
+
+//lock을 start_ns부터 기다리다 깨어났을때 (abort여도)
+void stat_lock_wait(uint64_t start_ns)
+{
+	stat_local * s = stat_get();
+	if (!s) return;
+	STAT_ADD(s->lock_wait, 1);
+	STAT_ADD(s->lock_ns, stat_ns() - start_ns);
+}
+
+//lock을 기다리다 abort될때, dead면 deadlock 아니면 timeout
+void stat_lock_abort(int dead)
+{
+	stat_local * s = stat_get();
+	if (!s) return;
+	if (dead) STAT_ADD(s->dead_abort, 1);
+	else STAT_ADD(s->timeout_abort, 1);
+}
+
+//모든 통계를 0으로, 다른 쓰레드가 db를 쓰지 않을때 (init_db 끝) 부른다
+void stat_reset()
+{
+	pthread_mutex_lock(&stat_list_latch);
+	for (stat_local * s = stat_head; s; s = s->next) {
+		for (int c = 0; c < TABLE_MAX / TABLE_CHUNK; c++)
+			if (s->table[c]) memset(s->table[c], 0, TABLE_CHUNK * sizeof(stat_table));
+		memset(s->latch_wait, 0, sizeof(s->latch_wait));
+		memset(s->latch_ns, 0, sizeof(s->latch_ns));
+		s->lock_wait = 0;
+		s->lock_ns = 0;
+		s->dead_abort = 0;
+		s->timeout_abort = 0;
+	}
+	stat_start = stat_ns();
+	stat_log_start = __atomic_load_n(&log_M.log_now, __ATOMIC_ACQUIRE);
+	pthread_mutex_unlock(&stat_list_latch);
+}
+
+#define STAT_LOAD(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+
+static void stat_table_sum(stat_table * out, const stat_table * t)
+{
+	out->hit += STAT_LOAD(t->hit);
+	out->miss += STAT_LOAD(t->miss);
+	out->evict += STAT_LOAD(t->evict);
+	out->dirty_write += STAT_LOAD(t->dirty_write);
+	out->bad_page += STAT_LOAD(t->bad_page);
+	out->ahi_hit += STAT_LOAD(t->ahi_hit);
+	out->ahi_build += STAT_LOAD(t->ahi_build);
+	out->ring_reuse += STAT_LOAD(t->ring_reuse);
+	out->cursor_hit += STAT_LOAD(t->cursor_hit);
+	out->cursor_descend += STAT_LOAD(t->cursor_descend);
+}
+
+//모든 쓰레드의 통계를 더해 out에 채운다, 더하는 중에도 다른 쓰레드는 계속 더하므로 대략적인 값
+int db_stats(db_stat * out)
+{
+	if (!out) return FAIL;
+	memset(out, 0, sizeof(db_stat));
+	for (stat_local * s = __atomic_load_n(&stat_head, __ATOMIC_ACQUIRE); s; s = s->next) {
+		for (int c = 0; c < TABLE_MAX / TABLE_CHUNK; c++) {
+			stat_table * t = __atomic_load_n(&s->table[c], __ATOMIC_ACQUIRE);
+			if (!t) continue;
+			for (int i = 0; i < TABLE_CHUNK; i++) stat_table_sum(&out->total, &t[i]);
+		}
+		for (int k = 0; k < STAT_LATCH; k++) {
+			out->latch_wait[k] += STAT_LOAD(s->latch_wait[k]);
+			out->latch_ns[k] += STAT_LOAD(s->latch_ns[k]);
+		}
+		out->lock_wait += STAT_LOAD(s->lock_wait);
+		out->lock_ns += STAT_LOAD(s->lock_ns);
+		out->dead_abort += STAT_LOAD(s->dead_abort);
+		out->timeout_abort += STAT_LOAD(s->timeout_abort);
+	}
+	int64_t log_now = __atomic_load_n(&log_M.log_now, __ATOMIC_ACQUIRE);
+	out->log_byte = log_now > stat_log_start ? (uint64_t)(log_now - stat_log_start) : 0;
+	out->sec = stat_start ? (stat_ns() - stat_start) / 1e9 : 0;
+	out->log_byte_sec = out->sec > 0 ? out->log_byte / out->sec : 0;
+	return SUCCESS;
+}
+
+//table_id 하나의 버퍼 통계
+int db_table_stats(int table_id, stat_table * out)
+{
+	if (!out || table_id < 1 || table_id >= TABLE_MAX) return FAIL;
+	memset(out, 0, sizeof(stat_table));
+	for (stat_local * s = __atomic_load_n(&stat_head, __ATOMIC_ACQUIRE); s; s = s->next) {
+		stat_table * t = __atomic_load_n(&s->table[table_id / TABLE_CHUNK], __ATOMIC_ACQUIRE);
+		if (t) stat_table_sum(out, &t[table_id % TABLE_CHUNK]);
+	}
+	return SUCCESS;
+}
+
+#ifdef DB_TRACE
+//쓰레드마다 하나, 쓰는 쪽이 하나뿐이라 head만 release로 올린다
+typedef struct trace_ring {
+	trace_ev ev[TRACE_RING];
+	uint64_t head;//지금까지 쓴 event 수
+	int tid;
+	int used;
+	struct trace_ring * next;
+}trace_ring;
+
+static pthread_mutex_t trace_list_latch = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring * trace_list;//한번 들어간 ring은 빠지지 않는다
+static int trace_num;
+static pthread_key_t trace_key;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static __thread trace_ring * trace_my;
+
+static void trace_exit(void * p)
+{
+	pthread_mutex_lock(&trace_list_latch);
+	((trace_ring*)p)->used = 0;
+	pthread_mutex_unlock(&trace_list_latch);
+}
+
+static void trace_key_init()
+{
+	pthread_key_create(&trace_key, trace_exit);
+}
+
+//이 쓰레드의 ring, stat_get처럼 끝난 쓰레드 것을 이어받거나 새로 만든다
+static trace_ring * trace_get()
+{
+	if (trace_my) return trace_my;
+	pthread_once(&trace_once, trace_key_init);
+	pthread_mutex_lock(&trace_list_latch);
+	trace_ring * r;
+	for (r = trace_list; r; r = r->next)
+		if (!r->used) break;
+	if (!r) {
+		r = (trace_ring*)calloc(1, sizeof(trace_ring));
+		if (!r) {
+			pthread_mutex_unlock(&trace_list_latch);
+			return NULL;
+		}
+		r->tid = ++trace_num;
+		r->next = trace_list;
+		__atomic_store_n(&trace_list, r, __ATOMIC_RELEASE);
+	}
+	r->used = 1;
+	pthread_mutex_unlock(&trace_list_latch);
+	pthread_setspecific(trace_key, r);
+	trace_my = r;
+	return r;
+}
+
+void trace_event(int kind, uint64_t t, int64_t a, int64_t b)
+{
+	trace_ring * r = trace_get();
+	if (!r) return;
+	uint64_t now = stat_ns();
+	trace_ev * e = &r->ev[r->head & (TRACE_RING - 1)];
+	e->ts = t ? t : now;
+	e->dur = t ? (uint32_t)(now - t > UINT32_MAX ? UINT32_MAX : now - t) : 0;
+	e->kind = kind;
+	e->tid = r->tid;
+	e->a = a;
+	e->b = b;
+	__atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+//모든 ring을 path에 남긴다, 다른 쓰레드가 쓰고 있으면 덮이는 중인 event가 섞일 수 있다
+int trace_dump(const char * path)
+{
+	if (!path) return FAIL;
+	FILE * fp = fopen(path, "wb");
+	if (!fp) return FAIL;
+
+	trace_file fh;
+	fh.magic = TRACE_MAGIC;
+	fh.ring_num = 0;
+	fh.ev_size = sizeof(trace_ev);
+	for (trace_ring * r = __atomic_load_n(&trace_list, __ATOMIC_ACQUIRE); r; r = r->next) fh.ring_num++;
+	fwrite(&fh, sizeof(fh), 1, fp);
+
+	//새로 생긴 ring은 list 앞에 붙으므로 센 만큼만 쓴다
+	trace_ring * r = __atomic_load_n(&trace_list, __ATOMIC_ACQUIRE);
+	for (uint32_t k = 0; k < fh.ring_num && r; k++, r = r->next) {
+		uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		uint64_t first = head > TRACE_RING ? head - TRACE_RING : 0;
+		trace_head th;
+		th.tid = r->tid;
+		th.n = (uint32_t)(head - first);
+		fwrite(&th, sizeof(th), 1, fp);
+		//ring 끝에 걸치면 두 조각
+		uint64_t pos = first & (TRACE_RING - 1);
+		uint64_t n1 = th.n < TRACE_RING - pos ? th.n : TRACE_RING - pos;
+		fwrite(&r->ev[pos], sizeof(trace_ev), n1, fp);
+		fwrite(&r->ev[0], sizeof(trace_ev), th.n - n1, fp);
+	}
+	int ret = ferror(fp) ? FAIL : SUCCESS;
+	if (fclose(fp) != 0) ret = FAIL;
+	return ret;
+}
+#else
+void trace_event(int kind, uint64_t t, int64_t a, int64_t b)
+{
+}
+
+int trace_dump(const char * path)
+{
+	return FAIL;
+}
+#endif
+
+//pin 관련 정보 수정
 void freeInfo(int table_id) {
 	//if(b_M.frameArray==NULL) init_db(500);
 	printf("\n<free page> \n");
-	int head = pageScan(table_id, 0);
-	int free = pageScan(table_id, b_head.free_page);
+	int head = pageScanShared(table_id, 0);
+	int free = pageScanShared(table_id, b_head.free_page);
 
 
 	int cnt = 0;
@@ -399,13 +2576,13 @@ void freeInfo(int table_id) {
 			if (cnt > 20) break;
 			cnt++;
 			printf("free %d : pagenum = %ld, right=%ld \n", cnt, tmp_next,
-				b_M.frameArray[free].frame_p.parent);
-			tmp_next = b_M.frameArray[free].frame_p.parent;
+				b_M.frameArray[free].frame_p->parent);
+			tmp_next = b_M.frameArray[free].frame_p->parent;
 			if (tmp_next == 0)break;
 			clearPin(free);
-			pthread_mutex_unlock(&b_M.frameArray[free].page_latch);
+			pageUnlatch(free);
 printf("page unlock [%d]\n",free);
-			free = pageScan(table_id, tmp_next);
+			free = pageScanShared(table_id, tmp_next);
 			
 
 		}
@@ -413,62 +2590,225 @@ printf("page unlock [%d]\n",free);
 
 	clearPin(free);
 	clearPin(head);
-pthread_mutex_unlock(&b_M.frameArray[free].page_latch);
+pageUnlatch(free);
 printf("page unlock [%d]\n",free);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+pageUnlatch(head);
 printf("page unlock [%d]\n",head);
 
-	//
+	//페이지언락
 }
 
 
-//  
+//핀 정보 수정
 void headInfo(int tableid) {
 	//if(b_M.frameArray==NULL) init_db(500);
-	int head = pageScan(tableid, 0);
+	int head = pageScanShared(tableid, 0);
 	
 	printf("\n<header info>\n");
 	printf("root , free, pagenum = %ld, %ld, %ld\n", b_head.root_page, b_head.free_page, b_head.page_num);
 	clearPin(head);
-	pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+	pageUnlatch(head);
+	uint64_t pages, bytes, moved;
+	if (file_compress_info(table_get(tableid)->fd, &pages, &bytes, &moved) == SUCCESS)
+		printf("compressed : written page %" PRIu64 " / file %" PRIu64 " bytes (%.2f of raw) / slot moved %" PRIu64 "\n",
+			pages, bytes, pages ? (double)bytes / (pages * PAGESIZE) : 0.0, moved);
+	Table * tb = table_get(tableid);
+	if (tb->warm_run) printf("warm : %d / %d page\n", __atomic_load_n(&tb->warm_done, __ATOMIC_RELAXED), tb->warm_num);
 printf("page unlock [%d]\n",head);
 
 }
 
-//  
+//b_opt.warm : close_table이 이 테이블의 버퍼에 남은 페이지를 자주 쓰인 순서로 "<path>.warm"에 남기고
+//다음에 열때 앞에서부터 버퍼 크기만큼 골라 파일 순서로 정렬한 뒤 background 쓰레드가 pagePrefetch로 읽는다
+//파일 모양 : WARM_MAGIC | int64 수 | pagenum_t 목록
+#define WARM_MAGIC "WARMSET1"
+
+typedef struct warm_ent {
+	uint64_t rank;//작을수록 최근에 쓰였다
+	pagenum_t page_num;
+}warm_ent;
+
+static int warm_rank_cmp(const void * a, const void * b)
+{
+	const warm_ent * x = (const warm_ent*)a, * y = (const warm_ent*)b;
+	if (x->rank != y->rank) return x->rank < y->rank ? -1 : 1;
+	return x->page_num < y->page_num ? -1 : x->page_num > y->page_num;
+}
+
+static int warm_page_cmp(const void * a, const void * b)
+{
+	pagenum_t x = *(const pagenum_t*)a, y = *(const pagenum_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+//partition마다 latch를 잡고 순위를 매긴다
+//LRU는 리스트 head에서의 거리, LRU-2는 마지막 접근 시각, CLOCK은 reference bit만 본다
+static void warm_dump(int table_id)
+{
+	Table * tb = table_get(table_id);
+	warm_ent * e = (warm_ent*)malloc((size_t)b_M.frame_capacity * sizeof(warm_ent));
+	if (!e) return;
+	int n = 0;
+	for (int p = 0; p < b_M.part_num; p++) {
+		buf_part * bp = &b_M.part[p];
+		pthread_mutex_lock(&bp->latch);
+		if (b_M.policy == BUF_LRU) {
+			uint64_t rank = 0;
+			for (int i = bp->LRU_head; i >= 0; i = b_M.frameArray[i].next, rank++)
+				if (b_M.frameArray[i].table_id == table_id && b_M.frameArray[i].page_num != 0) {
+					e[n].rank = rank;
+					e[n++].page_num = b_M.frameArray[i].page_num;
+				}
+		}
+		else {
+			for (int i = bp->begin; i < bp->end; i++) {
+				buffer_S * f = &b_M.frameArray[i];
+				if (f->table_id != table_id || f->page_num == 0) continue;
+				e[n].rank = b_M.policy == BUF_LRU2 ? ~f->hist[0] : !f->ref;
+				e[n++].page_num = f->page_num;
+			}
+		}
+		pthread_mutex_unlock(&bp->latch);
+	}
+	qsort(e, n, sizeof(warm_ent), warm_rank_cmp);
+
+	//중간에 죽어도 이전 목록이 남도록 tmp에 쓰고 rename
+	char path[PATH_MAX], tmp[PATH_MAX];
+	snprintf(path, sizeof(path), "%s.warm", tb->path);
+	snprintf(tmp, sizeof(tmp), "%s.warm.tmp", tb->path);
+	FILE * fp = fopen(tmp, "wb");
+	if (fp) {
+		int64_t num = n;
+		int ok = fwrite(WARM_MAGIC, 1, 8, fp) == 8 && fwrite(&num, sizeof(num), 1, fp) == 1;
+		for (int k = 0; k < n && ok; k++) ok = fwrite(&e[k].page_num, sizeof(pagenum_t), 1, fp) == 1;
+		if (fclose(fp) == 0 && ok) rename(tmp, path);
+		else unlink(tmp);
+	}
+	free(e);
+}
+
+static void * warm_thread(void * arg)
+{
+	Table * tb = (Table*)arg;
+	for (int k = 0; k < tb->warm_num && !__atomic_load_n(&tb->warm_stop, __ATOMIC_ACQUIRE); k += PREFETCH_MAX) {
+		int n = tb->warm_num - k < PREFETCH_MAX ? tb->warm_num - k : PREFETCH_MAX;
+		__atomic_store_n(&tb->warm_done, tb->warm_done + pagePrefetch(tb->id, tb->warm_page + k, n), __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+//목록이 있으면 loader를 띄운다, 파일이 그 사이 줄었을 수 있으니 헤더의 page_num을 넘는 페이지는 버린다
+static void warm_load(int table_id)
+{
+	Table * tb = table_get(table_id);
+	if (!b_opt.warm || tb->warm_run) return;
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s.warm", tb->path);
+	FILE * fp = fopen(path, "rb");
+	if (!fp) return;
+	char magic[8];
+	int64_t num;
+	if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, WARM_MAGIC, 8) != 0 || fread(&num, sizeof(num), 1, fp) != 1 || num <= 0) {
+		fclose(fp);
+		return;
+	}
+	//앞쪽이 더 자주 쓰인 페이지, 버퍼에 다 못 올리는 뒤쪽은 읽지 않는다
+	if (num > b_M.frame_capacity) num = b_M.frame_capacity;
+	pagenum_t * page = (pagenum_t*)malloc(num * sizeof(pagenum_t));
+	int n = page ? (int)fread(page, sizeof(pagenum_t), num, fp) : 0;
+	fclose(fp);
+
+	int head = pageScanShared(table_id, 0);
+	pagenum_t total = b_head.page_num;
+	clearPin(head);
+	pageUnlatch(head);
+	int m = 0;
+	for (int k = 0; k < n; k++)
+		if (page[k] > 0 && page[k] < total) page[m++] = page[k];
+	if (m == 0) {
+		free(page);
+		return;
+	}
+	qsort(page, m, sizeof(pagenum_t), warm_page_cmp);
+
+	tb->warm_page = page;
+	tb->warm_num = m;
+	tb->warm_done = 0;
+	tb->warm_stop = 0;
+	if (pthread_create(&tb->warm_th, 0, warm_thread, tb) == 0) tb->warm_run = 1;
+	else {
+		free(page);
+		tb->warm_page = NULL;
+	}
+}
+
+//loader가 돌고 있으면 멈추고 기다린다
+static void warm_end(Table * tb)
+{
+	if (!tb->warm_run) return;
+	__atomic_store_n(&tb->warm_stop, 1, __ATOMIC_RELEASE);
+	pthread_join(tb->warm_th, NULL);
+	tb->warm_run = 0;
+	free(tb->warm_page);
+	tb->warm_page = NULL;
+	tb->warm_num = 0;
+}
+
+//핀 관련 수정
 int close_table(int table_id) {
 //printf("\nclosetable1 -- frame capacity : %d\n",b_M.frame_capacity);
-	if (table_id > 10 || table_id < 1) {
+	if (table_id > b_M.table_total || table_id < 1) {
 //printf("wrong close\n");
 		return FAIL;
 	}
+	//merger가 이 테이블을 고치는 중이면 끝날때까지 기다린다, queue에 남은건 gen이 달라 건너뛴다
+	Table * tb = table_get(table_id);
+	warm_end(tb);
+	pthread_mutex_lock(&tb->smo_latch);
 
-	// ̺   ũ ش.
+	//이 쓰레드가 잡아둔 extent를 헤더에 돌려준 뒤
+	if (table_get(table_id)->isopen && !table_get(table_id)->map) file_extent_release(table_id);
+	//내보내기 전에 버퍼에 남은 페이지 목록을 남긴다
+	if (b_opt.warm && tb->isopen && !tb->map) warm_dump(table_id);
+
+	//그 테이블의 페이지들을 전부 디스크로 내려준다.
 	for (int i = 0; i < b_M.frame_capacity; i++)
 	{
 //printf("closetable2 -- cmp > framArray[i].table id / close id = %d/%d\n",b_M.frameArray[i].table_id , table_id);
 
 		if (b_M.frameArray[i].table_id == table_id) {
-			if (b_M.frameArray[i].ispinned == 1) {
-				clearPin(i);
-				pthread_mutex_unlock(&b_M.frameArray[i].page_latch);
+			if (pinCount(i) > 0) {
+				__atomic_store_n(&b_M.frameArray[i].pin, 0, __ATOMIC_RELEASE);
+				pageUnlatch(i);
 //printf("page unlock [%d]\n",i);
 			}
-			pageDrop(i);
+			pageEvict(i);
 		}
 	}
 
-	//̺ 迭 ش
-	for (int i = 0; i < 10; i++)
-	{
-//printf("closetable3\n");
-		if (b_M.table[i].id == table_id) {
-			b_M.table[i].isopen = 0;
-			b_M.table_use--;
-			close(b_M.table[i].fd);
-		}
-
+	//테이블 배열에서 없애준다
+	if (tb->map) {
+		//mmap 테이블은 버퍼에 올라온 페이지가 없다
+		munmap(tb->map, tb->map_pages * PAGESIZE);
+		tb->map = NULL;
+		tb->map_pages = 0;
+		tb->isopen = 0;
+		b_M.table_use--;
 	}
+	else {
+		tb->isopen = 0;
+		b_M.table_use--;
+		//flusher가 이 fd에 쓰는 중일 수 있다
+		pthread_mutex_lock(&b_M.flush_latch);
+		file_close_table(tb->fd);
+		close(tb->fd);
+		pthread_mutex_unlock(&b_M.flush_latch);
+	}
+	pthread_mutex_unlock(&tb->smo_latch);
+
+	//같이 연 인덱스도 닫는다
+	for (int j = 0; j < tb->index_num; j++)
+		if (table_isopen(tb->index_table[j])) close_table(tb->index_table[j]);
 	//clear the trx table
 
 	//clear the lock table
@@ -478,221 +2818,521 @@ int close_table(int table_id) {
 	return SUCCESS;
 }
 
-// x
+//수정 x
 int shutdown_db()
 {
-	//̺ öִ ŭ close table
-	for (int i = 0; i < 10; i++)
+	trx_detector_stop();
+	//replica applier는 테이블에 쓰므로 테이블을 닫기 전에
+	log_replica_stop();
+
+	//flusher 종료
+	if (b_M.flusher_run) {
+		pthread_mutex_lock(&b_M.flush_latch);
+		b_M.flusher_run = 0;
+		pthread_cond_signal(&b_M.flush_cond);
+		pthread_mutex_unlock(&b_M.flush_latch);
+		pthread_join(b_M.flusher, NULL);
+	}
+
+	//merger 종료, queue에 남은 리프는 버린다
+	if (b_M.merger_run) {
+		pthread_mutex_lock(&b_M.merge_latch);
+		b_M.merger_run = 0;
+		b_M.merge_num = 0;
+		pthread_cond_signal(&b_M.merge_cond);
+		pthread_mutex_unlock(&b_M.merge_latch);
+		pthread_join(b_M.merger, NULL);
+	}
+
+	//열려있는 테이블만 close table
+	for (int i = 1; i <= b_M.table_total; i++)
 	{
-		close_table(b_M.table[i].id);
+		if (table_get(i)->isopen) close_table(i);
 	}
 
+	//남은 로그도 내리고 log flusher 정지
+	close_log();
+
+	//쓰레드가 다 멈춘 뒤라 ring이 더 바뀌지 않는다
+	if (b_opt.trace_path) trace_dump(b_opt.trace_path);
+
 	return SUCCESS;
 }
 
 ////////////////////////////////////////////
 
 
-//x
+//buf_num개 페이지 자리를 HUGE_PAGE 단위로 잡는다
+//MAP_HUGETLB는 미리 잡아둔 huge page가 있어야 되고, 없으면 THP를 부탁하고 그것도 안되면 보통 페이지로 쓴다
+static int regionAlloc(int buf_num)
+{
+	size_t size = ((size_t)buf_num * PAGESIZE + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+	void * p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	b_M.region_huge = REGION_HUGETLB;
+#endif
+	if (p == MAP_FAILED) {
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED) return FAIL;
+		b_M.region_huge = REGION_PLAIN;
+#ifdef MADV_HUGEPAGE
+		if (madvise(p, size, MADV_HUGEPAGE) == 0) b_M.region_huge = REGION_THP;
+#endif
+	}
+	b_M.page_region = (char*)p;
+	b_M.region_size = size;
+	return SUCCESS;
+}
+
+//NUMA node의 CPU, numaInit이 채운다
+#define NUMA_MAX 64
+#define NUMA_PREFERRED 1//linux/mempolicy.h의 MPOL_PREFERRED, 그 node가 모자라면 다른 node에서 잡는다
+static cpu_set_t numa_cpu[NUMA_MAX];
+static int numa_id[NUMA_MAX];//실제 node 번호
+static __thread int numa_bound;//이 쓰레드를 묶은 node + 1, 아직이면 0
+
+//"0-3,8-11" 꼴의 cpulist를 set에 넣는다
+static void numaParseList(const char * s, cpu_set_t * set)
+{
+	CPU_ZERO(set);
+	while (*s) {
+		char * e;
+		long a = strtol(s, &e, 10);
+		if (e == s) break;
+		long b = a;
+		if (*e == '-') b = strtol(e + 1, &e, 10);
+		for (long c = a; c <= b && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+		s = *e == ',' ? e + 1 : e;
+	}
+}
+
+//sysfs에서 CPU가 있는 node만 모은다, 메모리만 있는 node에는 쓰레드를 묶을 수 없다
+static void numaInit()
+{
+	b_M.numa_node = 0;
+	b_M.numa_next = 0;
+	for (int d = 0; d < NUMA_MAX && b_opt.numa; d++) {
+		char path[64], buf[1024];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", d);
+		FILE * fp = fopen(path, "r");
+		if (!fp) continue;
+		int ok = fgets(buf, sizeof(buf), fp) != NULL;
+		fclose(fp);
+		if (!ok) continue;
+		numaParseList(buf, &numa_cpu[b_M.numa_node]);
+		if (CPU_COUNT(&numa_cpu[b_M.numa_node]) == 0) continue;
+		numa_id[b_M.numa_node++] = d;
+	}
+	if (b_M.numa_node == 0) b_M.numa_node = 1;
+}
+
+//partition의 페이지 자리를 bp->node에 두도록 부탁한다
+//init_db에서는 아직 아무도 건드리지 않은 페이지라 처음 닿을때 그 node에서 잡힌다, MAP_HUGETLB면 huge page 경계 안쪽만 된다
+static void numaBindPart(buf_part * bp)
+{
+#ifdef SYS_mbind
+	size_t unit = b_M.region_huge == REGION_HUGETLB ? HUGE_PAGE : PAGESIZE;
+	uintptr_t s = (uintptr_t)(b_M.page_region + (size_t)bp->begin * PAGESIZE);
+	uintptr_t e = (uintptr_t)(b_M.page_region + (size_t)bp->end * PAGESIZE);
+	s = (s + unit - 1) / unit * unit;
+	e = e / unit * unit;
+	if (s >= e) return;
+	unsigned long mask[NUMA_MAX / 64] = { 0 };
+	mask[bp->node / 64] |= 1UL << (bp->node % 64);
+	syscall(SYS_mbind, (void*)s, (unsigned long)(e - s), NUMA_PREFERRED, mask, (unsigned long)NUMA_MAX, 0);
+#else
+	(void)bp;
+#endif
+}
+
+//b_opt.numa면 처음 부른 쓰레드를 node 하나의 CPU에 묶고 그 node를 돌려준다, node는 쓰레드마다 돌아가며 준다
+//페이지의 partition은 hash로 정해지므로 쓰레드가 보는 페이지가 모두 자기 node에 있지는 않다
+//node마다 partition과 쓰레드가 고르게 나뉘어 한 node의 메모리와 interconnect만 붙잡지 않게 한다
+int bufBindThread()
+{
+	if (!b_opt.numa || b_M.numa_node <= 1) return -1;
+	if (numa_bound) return numa_bound - 1;
+	int n = __atomic_fetch_add(&b_M.numa_next, 1, __ATOMIC_RELAXED) % b_M.numa_node;
+	if (sched_setaffinity(0, sizeof(cpu_set_t), &numa_cpu[n]) != 0) return -1;
+	numa_bound = n + 1;
+	return n;
+}
+
+//수정x
 int init_db(int buf_num,int flag, int log_num,char* log_path, char* logmsg_path)
 {
 //printf("\ninit db 1\n");
-		//Ҵ ش, calloc  0 ʱȭ... ׷ Ȥ 𸣴Ϥ
-	b_M.frameArray = (buffer_S*)calloc(buf_num, sizeof(struct bufferStructure));
-	for (int i = 0; i < 10; i++)
+		//동적할당 시켜준다, calloc은 모두 0을 초기화... 그래도 혹시 모르니ㅠ
+	//이전 init_db의 프레임은 돌려준다
+	if (b_M.frameArray) {
+		for (int i = 0; i < b_M.frame_capacity; i++) pthread_rwlock_destroy(&b_M.frameArray[i].page_latch);
+		free(b_M.frameArray);
+		munmap(b_M.page_region, b_M.region_size);
+		b_M.frameArray = NULL;
+	}
+	//페이지와 메타데이터를 따로 잡는다, 페이지는 mmap이라 늘 PAGESIZE 정렬이고 O_DIRECT로 바로 읽고 쓴다
+	if (regionAlloc(buf_num) != SUCCESS) return FAIL;
+	b_M.frameArray = (buffer_S*)calloc(buf_num, sizeof(buffer_S));
+	if (!b_M.frameArray) {
+		munmap(b_M.page_region, b_M.region_size);
+		return FAIL;
+	}
+	for (int i = 0; i < buf_num; i++) b_M.frameArray[i].frame_p = (page_t*)(b_M.page_region + (size_t)i * PAGESIZE);
+	//이전 init_db의 catalog는 비운다, 같은 파일도 다시 1번부터 id를 받는다
+	for (int c = 0; c < TABLE_MAX / TABLE_CHUNK && b_M.table[c]; c++)
 	{
-		b_M.table[i].fd = 0;
-		b_M.table[i].id = 0;
-		b_M.table[i].path = (char*)calloc(20, sizeof(char));
-		b_M.table[i].isopen = 0;
-
-
+		for (int i = 0; i < TABLE_CHUNK; i++) free(b_M.table[c][i].path);
+		free(b_M.table[c]);
+		b_M.table[c] = NULL;
 	}
 	b_M.table_total = 0; 
 	b_M.table_use = 0;
 	b_M.frame_capacity = buf_num;
-	b_M.use_num = 0;
 
-	b_M.LRU_head = -1;
-	b_M.LRU_tail = -1;
-	pthread_mutex_init(&buf_latch, NULL);
-	
+	//partition 하나당 프레임이 너무 적으면 victim을 못 고르므로 최소 8개씩
+	int part_num = b_opt.part_num > 0 ? b_opt.part_num : 1;
+	if (part_num > buf_num / 8) part_num = buf_num / 8;
+	if (part_num < 1) part_num = 1;
+	b_M.part_num = part_num;
+	b_M.part = (buf_part*)calloc(part_num, sizeof(buf_part));
+	b_M.policy = b_opt.policy;
+	numaInit();
 
-	for (int i = 0; i < buf_num; i++)
+	for (int p = 0; p < part_num; p++)
 	{
-		b_M.frameArray[i].pre = -1;
-		b_M.frameArray[i].next = -1;
-		pthread_mutex_init(&b_M.frameArray[i].page_latch, NULL);
+		buf_part * bp = &b_M.part[p];
+		pthread_mutex_init(&bp->latch, NULL);
+		bp->begin = (int)((int64_t)buf_num * p / part_num);
+		bp->end = (int)((int64_t)buf_num * (p + 1) / part_num);
+		bp->use_num = 0;
+		bp->LRU_head = -1;
+		bp->LRU_tail = -1;
+		bp->hand = bp->begin;
+		bp->tick = 0;
+		bp->node = numa_id[p % b_M.numa_node];
+		if (b_M.numa_node > 1) numaBindPart(bp);
+
+		//page table 버킷은 프레임 수의 2배 이상인 2의 거듭제곱
+		bp->page_table_size = 1;
+		while (bp->page_table_size < (bp->end - bp->begin) * 2) bp->page_table_size <<= 1;
+		bp->page_table = (int*)malloc(bp->page_table_size * sizeof(int));
+		for (int i = 0; i < bp->page_table_size; i++) bp->page_table[i] = -1;
+
+		bp->free_head = -1;
+		for (int i = bp->end - 1; i >= bp->begin; i--)
+		{
+			b_M.frameArray[i].pre = -1;
+			b_M.frameArray[i].next = -1;
+			b_M.frameArray[i].hash_next = -1;
+			b_M.frameArray[i].part = p;
+			b_M.frameArray[i].rec_LSN = -1;
+			pthread_rwlock_init(&b_M.frameArray[i].page_latch, NULL);
+			freePush(i);
+		}
+	}
 
+	pthread_mutex_init(&b_M.flush_latch, NULL);
+	pthread_cond_init(&b_M.flush_cond, NULL);
+	b_M.flush_round = 0;
+	b_M.flush_page = 0;
+	b_M.flush_write = 0;
+	b_M.sync_write = 0;
+	b_M.flusher_run = 0;
+	if (b_opt.flush_clean > 0) {
+		b_M.flusher_run = 1;
+		pthread_create(&b_M.flusher, NULL, flusher_func, NULL);
 	}
 
 	open_log(log_path);
 	open_msg_log(logmsg_path);
 	init_log_buf(1000);
 
-	if (flag == 0) {//븻
-		//α Ͽ ִ  α׷ڵ带 
-		//м->redo->undo  ϵ Ѵ
+	if (flag == 0) {//노말
+		//로그 파일에 있는 모든 로그레코드를 실행
+		//분석->redo->undo를 모두 진행하도록 한다
 		
-		//м
-		log_M.log_now=analysis();//α 鼭  ã´.
+		//분석
+		log_M.log_now=analysis();//로그파일을 보면서 루저를 찾는다.
 
 		//redo
-		recovery_redo(0);// α׸ 
+		recovery_redo(0);//모든 로그를 재실행
 
 		//undo
-		recovery_undo(0);// ؼ undo 
+		recovery_undo(0);//루저에 대해서 undo 실행
 
 	}
 	else if (flag == 1) {//redo crash
-		//redo ܰ迡 ־ α seq num  ϰ 
+		//redo 단계에서 주어진 로그 seq num까지 모두 진행하고 
 
-		//м
+		//분석
 		log_M.log_now=analysis();
 
 		//redo
 		recovery_redo(log_num);
 	}
 	else if (flag == 2) {//undo crash
-		//undoܰ迡 ־  α seq num  ϰ 
+		//undo단계에서 주어진  로그 seq num까지 무두 진행하고 
+
+		//분석
+		log_M.log_now=analysis();
+
+		//redo
+		recovery_redo(0);
+
+		//undo
+		recovery_undo(log_num);
+	}
+
+	//로그 버퍼와 페이지 버퍼의 dirty를 전부 디스크로 내려준다
+	if (flag >= 0 && flag <= 2) {
+		log_flush(log_M.log_now);
+		for (int i = 0; i < b_M.frame_capacity; i++)
+		{
+			if (b_M.frameArray[i].table_id != 0) pageEvict(i);
+		}
+	}
+
+	//merge_fill이 음수면 merger 없이 지운 표시만 남긴다 (꽉 찬 리프에 insert할때 비워진다)
+	//merger는 latch를 여러개 잡은 채로 pageScan하므로, 위에서 프레임을 전부 내리는 동안에는 돌지 않게 recovery 뒤에 띄운다
+	if (!b_M.merger_run) {
+		pthread_mutex_init(&b_M.merge_latch, NULL);
+		pthread_cond_init(&b_M.merge_cond, NULL);
+		b_M.merge_head = 0;
+		b_M.merge_num = 0;
+		b_M.merge_done = 0;
+		b_M.merge_moved = 0;
+		if (b_opt.merge_fill >= 0) {
+			b_M.merger_run = 1;
+			pthread_create(&b_M.merger, NULL, merger_func, NULL);
+		}
+	}
+
+	//adaptive hash index는 비운 채로 시작한다 (recovery가 고친 리프를 가리키지 않게 여기서)
+	free(b_M.ahi);
+	free(b_M.ahi_heat);
+	b_M.ahi = NULL;
+	b_M.ahi_heat = NULL;
+	if (b_opt.ahi) {
+		b_M.ahi = (ahi_ent*)calloc(AHI_SIZE, sizeof(ahi_ent));
+		b_M.ahi_heat = (uint8_t*)calloc(AHI_HEAT, 1);
+		if (!b_M.ahi || !b_M.ahi_heat) {
+			free(b_M.ahi);
+			free(b_M.ahi_heat);
+			b_M.ahi = NULL;
+			b_M.ahi_heat = NULL;
+		}
+	}
+
+	//recovery가 끝난 지점을 checkpoint로 남겨 다음 analysis는 여기서 시작한다
+	if (flag == 0) log_checkpoint();
+	if (b_opt.ckpt_ms > 0) log_checkpoint_start(b_opt.ckpt_ms);
+	if (b_opt.dead_ms > 0) trx_detector_start(b_opt.dead_ms);
+
+	//recovery가 쓴 것은 빼고 여기서부터 센다
+	stat_reset();
 
-		//м
-		log_M.log_now=analysis();
+	return SUCCESS;
+}
 
-		//redo
-		recovery_redo(0);
 
-		//undo
-		recovery_undo(log_num);
-	}
+//테이블을 열때마다 하나씩 늘린다, init_db를 다시 해도 이어간다
+static int table_gen;
 
-	//α ۿ   dirty  ũ ش
+int table_isopen(int table_id)
+{
+	return table_id >= 1 && table_id <= b_M.table_total && table_get(table_id)->isopen;
+}
+
+//pathname으로 열었던 테이블의 id, 처음 보는 파일이면 0
+static int table_find(const char * pathname)
+{
+	for (int i = 1; i <= b_M.table_total; i++)
+		if (!strcmp(pathname, table_get(i)->path)) return i;
+	return 0;
+}
 
+//다음 table_id의 자리를 만든다, chunk가 없으면 할당 / 꽉 찼으면 FAIL
+static int table_reserve(void)
+{
+	int c = b_M.table_total / TABLE_CHUNK;
+	if (b_M.table_total == TABLE_MAX) return FAIL;
+	if (b_M.table[c] == NULL) {
+		b_M.table[c] = (Table*)calloc(TABLE_CHUNK, sizeof(Table));
+		if (b_M.table[c] == NULL) return FAIL;
+		for (int i = 0; i < TABLE_CHUNK; i++) pthread_mutex_init(&b_M.table[c][i].smo_latch, NULL);
+	}
 	return SUCCESS;
 }
 
+//direct_io면 O_DIRECT를 붙여 연다, 파일시스템이 O_DIRECT를 받지 않으면(tmpfs 등) 그냥 연다
+static int table_open_fd(const char * pathname, int flags)
+{
+	if (b_opt.direct_io) {
+		int fd = open(pathname, flags | O_DIRECT, 0777);
+		if (fd >= 0 || errno != EINVAL) return fd;
+	}
+	return open(pathname, flags, 0777);
+}
+
 
-// 
+//핀 수정
 int open_table(char *pathname) {
+	return open_table_layout(pathname, b_opt.node_layout, b_opt.leaf_layout);
+}
+
+//새로 만드는 테이블이면 인터널/리프 형식을 정해서 헤더에 남긴다, 이미 있는 파일은 헤더의 형식을 따른다
+int open_table_layout(char *pathname, int node_layout, int leaf_layout) {
 	
 	//if(b_M.frameArray==NULL) init_db(500);
-	// о´.
+	//헤더를 읽어온다.
 	int root;
 	int head;
-	//O_creat 忡 ° ڿ Ͽ ٱ 
-	//    ִµ  Ѵٸ  (O_EXCL)
+	//O_creat 모드에서는 세번째 인자에 파일에 접근권한 설정가능
+	//파일이 없는 경우 새로 생성해주는데 파일이 존재한다면 에러를 리턴(O_EXCL)
 
 
-	// ϸ ϴ üũ
-	int i;
-	for (i = 0; i < 10; i++)
-	{
-		if (!strcmp(pathname, b_M.table[i].path)) {
-			break;
-		}
+	//같은 파일명이 존재하는지 체크, 처음 보는 파일이면 다음 자리
+	int i = table_find(pathname);
+	i = i ? i - 1 : b_M.table_total;
+	if (i == b_M.table_total && table_reserve() == FAIL) {
+		printf("full table\n");
+		return FAIL;
 	}
+	Table * tb = table_get(i + 1);
 
 //printf("open table : i= %d\n",i);
-		//   ̺
-	if (i == 10) {
-		if (b_M.table_total == 10) {
-			printf("full table\n");
-			return FAIL;
-		}
+	//mmap으로 열려있는 동안은 쓰기용으로 열지 않는다
+	if (tb->map) return FAIL;
+		//이전에 열린적이 없던 테이블
+	if (i == b_M.table_total) {
 
 //printf("open table : first open-1\n");
-		i = b_M.table_total;
-		b_M.table[i].fd = open(pathname, O_RDWR | O_CREAT | O_EXCL, 0777);
-		int table_fd = b_M.table[i].fd;
+		tb->fd = table_open_fd(pathname, O_RDWR | O_CREAT | O_EXCL);
+		int table_fd = tb->fd;
 		int table_id;
-		// ȴٸ
+		//압축 형식이면 압축 헤더를 먼저 쓴다
+		if (table_fd > 0 && file_open_table(table_fd, 1) != SUCCESS) {
+			close(table_fd);
+			unlink(pathname);
+			return FAIL;
+		}
+		//정상적으로 열렸다면
 		if (table_fd > 0) {
 //printf("open table : first open-2\n");
 
-			b_M.table[i].id = i + 1;
-			table_id = b_M.table[i].id;
-			strcpy(b_M.table[i].path, pathname);
-			b_M.table[i].isopen = 1;
+			tb->id = i + 1;
+			table_id = tb->id;
+			tb->path = strdup(pathname);
+			tb->isopen = 1;
+			tb->gen = ++table_gen;
 			b_M.table_total++;
 			b_M.table_use++;
 
 //printf("head scan : %d\n",table_id);
 			head = pageScan(table_id, 0);
-			//   īƮ
+			//헤더 페이지 개수 카운트
 			b_head.page_num = 1;
 			b_head.free_page = 0;
 			b_head.root_page = 0;
-
-			// dirty/pin set
+			//인터널/리프 형식은 만들때 정해서 헤더에 남긴다
+			b_head.node_layout = node_layout;
+			b_head.leaf_layout = leaf_layout;
+			//다른 크기로 빌드한 엔진이 열지 않도록 남긴다
+			b_head.page_size = PAGESIZE;
+			b_head.record_size = RECORD_SIZE;
+			tb->node_layout = b_head.node_layout;
+			tb->leaf_layout = b_head.leaf_layout;
+			tb->index_num = 0;
+
+			//헤더 dirty/pin set
 			clearPin(head);
-			pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+			pageUnlatch(head);
 //printf("page unlock [%d]\n",head);
 			setDirty(head);
 
 			return table_id;
 		}
 
-		//Ǿִٸ ٽ о´.
-		b_M.table[i].fd = open(pathname, O_RDWR);
-		table_fd = b_M.table[i].fd;
+		//생성되어있다면 다시 읽어온다.
+		tb->fd = table_open_fd(pathname, O_RDWR);
+		table_fd = tb->fd;
+		if (table_fd > 0 && file_open_table(table_fd, 0) != SUCCESS) {
+			close(table_fd);
+			return FAIL;
+		}
 
-		// о
+		//정상으로 읽어진경우
 		if (table_fd > 0) {
 
 //printf("open table : first open-3\n");
-			b_M.table[i].id = i + 1;
-			table_id = b_M.table[i].id;
+			tb->id = i + 1;
+			table_id = tb->id;
 			head = pageScan(table_id, 0);
+			tb->node_layout = b_head.node_layout;
+			tb->leaf_layout = b_head.leaf_layout;
 
-			strcpy(b_M.table[i].path, pathname);
-			b_M.table[i].isopen = 1;
+			tb->path = strdup(pathname);
+			tb->isopen = 1;
+			tb->gen = ++table_gen;
 			b_M.table_total++;
 			b_M.table_use++;
 //printf("open table : first open-4\n");
-						//Ʈ ۿ ÷ش
+						//루트페이지를 버퍼에 올려준다
 			if (b_head.root_page != 0) {
 //printf("open table : first open-5\n");
 				root = pageScan(table_id, b_head.root_page);
 				clearPin(root);
-				pthread_mutex_unlock(&b_M.frameArray[root].page_latch);
+				pageUnlatch(root);
 //printf("page unlock [%d]\n",root);
 			}
 //printf("open table : first open-6\n");
 			clearPin(head);
-			pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+			pageUnlatch(head);
 //printf("page unlock [%d]\n",head);
+			index_load(table_id);
+			warm_load(table_id);
 			return table_id;
 		}
 
 
 	}
 
-	//  ־  Ǿִ  fd ؼ 
+	//이전에 열린적이 있어 정보가 저장되어있는 경우 fd만 갱신해서 저장
 	else {
 //printf("open table : already open-1\n");
-		b_M.table[i].fd = open(pathname, O_RDWR);
-//printf("new fd : %d\n",b_M.table[i].fd);
-		int table_fd = b_M.table[i].fd;
-		int table_id = b_M.table[i].id;
+		tb->fd = table_open_fd(pathname, O_RDWR);
+//printf("new fd : %d\n",tb->fd);
+		int table_fd = tb->fd;
+		int table_id = tb->id;
+		if (table_fd > 0 && file_open_table(table_fd, 0) != SUCCESS) {
+			close(table_fd);
+			return FAIL;
+		}
 
 		if (table_fd > 0) {
 //printf("open table : already open-2\n");
-						// ۿ ÷ش
+						//헤더를 버퍼에 올려준다
 			head = pageScan(table_id, 0);
-			b_M.table[i].isopen = 1;
+			tb->node_layout = b_head.node_layout;
+			tb->leaf_layout = b_head.leaf_layout;
+			tb->isopen = 1;
+			tb->gen = ++table_gen;
 			b_M.table_use++;
 
-			//Ʈ ۿ ÷ش
+			//루트페이지를 버퍼에 올려준다
 			if (b_head.root_page != 0) {
 				root = pageScan(table_id, b_head.root_page);
 				clearPin(root);
-				pthread_mutex_unlock(&b_M.frameArray[root].page_latch);
+				pageUnlatch(root);
 //printf("page unlock [%d]\n",root);
 			}
 
 			clearPin(head);
-			pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+			pageUnlatch(head);
 //printf("page unlock [%d]\n",head);
+			index_load(table_id);
+			warm_load(table_id);
 			return table_id;
 		}
 
@@ -704,182 +3344,646 @@ int open_table(char *pathname) {
 	return FAIL;
 }
 
+//이미 있는 테이블 파일을 읽기 전용으로 통째로 mmap해서 연다
+//찾기는 버퍼 매니저를 거치지 않고 page_num * PAGESIZE 위치를 바로 읽는다
+//insert/update/bulk load는 FAIL, 쓰기용으로 열려있는 테이블이면 FAIL
+int open_table_mmap(char *pathname) {
+	int i = table_find(pathname);
+	i = i ? i - 1 : b_M.table_total;
+	if (i == b_M.table_total && table_reserve() == FAIL) {
+		printf("full table\n");
+		return FAIL;
+	}
+	Table * tb = table_get(i + 1);
+	if (tb->isopen) return FAIL;
+
+	int fd = open(pathname, O_RDONLY);
+	if (fd < 0) return FAIL;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < PAGESIZE) {
+		close(fd);
+		return FAIL;
+	}
+	pagenum_t pages = st.st_size / PAGESIZE;
+	char * map = (char*)mmap(NULL, pages * PAGESIZE, PROT_READ, MAP_SHARED, fd, 0);
+	//매핑은 fd를 닫아도 남는다
+	close(fd);
+	if (map == MAP_FAILED) return FAIL;
+	//압축 테이블은 페이지가 page_num 자리에 있지 않다, 다른 크기로 만든 파일도 읽지 않는다
+	const header_page * h = (const header_page*)map;
+	if (file_compressed_image(map) || file_geometry_check(-1, h) != SUCCESS) {
+		munmap(map, pages * PAGESIZE);
+		return FAIL;
+	}
+	//참조용 테이블은 작으니 미리 올려둔다
+	madvise(map, pages * PAGESIZE, MADV_WILLNEED);
+
+	if (i == b_M.table_total) {
+		tb->id = i + 1;
+		tb->path = strdup(pathname);
+		b_M.table_total++;
+	}
+	tb->fd = -1;
+	tb->node_layout = h->node_layout;
+	tb->leaf_layout = h->leaf_layout;
+	tb->map = map;
+	tb->map_pages = pages;
+	tb->isopen = 1;
+	tb->gen = ++table_gen;
+	b_M.table_use++;
+	return tb->id;
+}
+
+
+
+
 
+////////////////////////////// 아래는 다 핀수정만 하면 되지 않을까
 
+//pageScan 밖에서 프레임을 내릴때, partition latch를 잡고 drop
+int pageEvict(int index)
+{
+	buf_part * bp = &b_M.part[b_index.part];
 
+	stat_latch(&bp->latch, STAT_BUF_LATCH);
+	int ret = pageDrop(index);
+	pthread_mutex_unlock(&bp->latch);
 
-////////////////////////////// Ʒ  ɼ ϸ  
+	return ret;
+}
 
-// ۹ؽ ʿx -> pageScan ̹  ,   ʿ
+//얘는 partition latch 필요x -> pageScan/pageEvict에서 이미 잡고 있음, 대신 페이지락 필요
 int pageDrop(int index){
 //printf("\npage drop start : victim=%d \n", index);
-pthread_mutex_lock(&b_M.frameArray[index].page_latch);
-setPin(index);
+pageLatch(index);
 //printf("page Drop : page lock\n");
+	buf_part * bp = &b_M.part[b_index.part];
 
-	//ũ Ʈ 
+	//링크드 리스트에서 삭제
 	int pre = b_index.pre;
 	int next = b_index.next;
 
-	//drop  忴ٸ
+	//drop할 페이지가 헤드였다면
 	if (pre == HEAD) {
 //printf("pagedrop head \n");
 		if (next != TAIL) {
-			b_M.LRU_head = b_index.next;
+			bp->LRU_head = b_index.next;
 			b_M.frameArray[b_index.next].pre = HEAD;
 		}
 		else {
-			b_M.LRU_head = -1;
+			bp->LRU_head = -1;
 		}
 	}
-	// ̾ٸ
+	//테일 이었다면
 	else if (next == TAIL) {
 //printf("pagedrop tail \n");
-		b_M.LRU_tail = b_index.pre;
+		bp->LRU_tail = b_index.pre;
 		b_M.frameArray[b_index.pre].next = TAIL;
 	}
-	//Ѵ ƴѰ
+	//둘다 아닌경우
 	else {
 //printf("pagedrop normal \n");
 		b_M.frameArray[pre].next = next;
 		b_M.frameArray[next].pre = pre;
 	}
 
-	//ʱȭ
+	//초기화
 	b_index.pre = -1;
 	b_index.next = -1;
 
-	//Ƽΰ ũ ְ ش
+	//더티인경우 디스크에 써주고 없애준다
 	if (b_index.isdirty) {
 //printf("pagedrop dirty \n");
 //printf("parent : %ld\n",b_page.parent);
-		file_write_page(b_M.table[b_index.table_id - 1].fd, b_index.page_num, &b_page);
+		//WAL : 페이지를 고친 로그가 먼저 내려가야 한다
+		if (b_index.page_num != 0) log_flush(b_page.page_LSN);
+		file_write_page(table_get(b_index.table_id)->fd, b_index.page_num, &b_page);
+		__sync_fetch_and_add(&b_M.sync_write, 1);
+		STAT_ADD(stat_table_get(b_index.table_id)->dirty_write, 1);
+		//flusher가 따라오지 못하는 중이므로 깨워준다
+		if (b_M.flusher_run) pthread_cond_signal(&b_M.flush_cond);
 	}
+	pageWriteBegin(index);
+	pageTableRemove(index);
 	b_index.table_id = 0;
 	b_index.page_num = 0;
+	pageWriteEnd(index);
 
-	//ʱȭ
-	b_M.use_num--;
+	//초기화
+	bp->use_num--;
 	b_index.isdirty = 0;
-	b_index.ispinned = 0;
+	b_index.rec_LSN = -1;
+	b_index.flushing = 0;
+	//pageVictim이 잡은 프레임이면 풀어준다, 억지로 고른 프레임은 pin이 남아있으면 그대로 둔다
+	pinUnclaim(index);
+	freePush(index);
 
 
 //printf("page drop end");
-clearPin(index);
-pthread_mutex_unlock(&b_M.frameArray[index].page_latch);
+pageUnlatch(index);
 //printf("page Drop : page unlock[%d]\n",index);
 	return SUCCESS;
 }
 
-int pageScan(int table, pagenum_t pagenum)
+//scan 힌트 : 긴 scan이 올리는 프레임이 working set을 밀어내지 않게 한다
+//힌트를 켠 쓰레드가 올린 프레임은 쓰레드마다의 ring에 들어가고, hit이어도 교체 정책 정보는 고치지 않는다
+//ring이 차면 다음 miss는 ring에서 같은 partition의 가장 먼저 올린 프레임을 내리고 그 자리에 읽는다
+//그 사이 다른 쪽이 접근했거나(scan이 0) dirty면 그 프레임은 놔두고 보통처럼 victim을 골라 ring의 그 자리에 넣는다
+typedef struct scan_ring_ent {
+	int frame;
+	int table_id;//올릴때의 페이지, 그 사이 내려가고 다른 페이지가 올라왔으면 건드리지 않는다
+	pagenum_t page_num;
+}scan_ring_ent;
+
+typedef struct scan_ring {
+	int on;
+	int size;
+	int num;//채운 자리 수
+	int pos;//가장 먼저 넣은 자리
+	int take;//scanRingPick이 본 자리, 다음 pageLoad가 여기에 넣는다
+	scan_ring_ent ent[SCAN_RING_MAX];
+}scan_ring;
+
+static __thread scan_ring scan_my;
+
+//이 쓰레드의 scan 힌트를 켜고(1) 끈다(0), 이전 값 리턴 / 음수면 지금 값만 리턴
+//꺼진 상태에서 켤때 ring을 비운다, 이전 ring의 프레임은 LRU 뒤에 남아 먼저 나간다
+int bufScanHint(int on)
+{
+	int prev = scan_my.on;
+	if (on < 0) return prev;
+	if (on && !prev) {
+		int n = b_opt.scan_ring ? b_opt.scan_ring : SCAN_RING;
+		if (n < 0) return prev;
+		scan_my.size = n < SCAN_RING_MAX ? n : SCAN_RING_MAX;
+		scan_my.num = 0;
+		scan_my.pos = 0;
+		scan_my.take = 0;
+	}
+	scan_my.on = on ? 1 : 0;
+	return prev;
+}
+
+//ring에서 bp의 가장 먼저 올린 프레임을 내리고 free list에서 다시 꺼내준다, 못 쓰면 -1
+//bp의 partition latch를 잡은 상태에서 부른다, table_id/page_num은 그 latch 아래서만 바뀐다
+static int scanRingPick(buf_part * bp)
+{
+	scan_my.take = scan_my.pos;
+	if (!scan_my.on || scan_my.num < scan_my.size) return -1;
+	for (int k = 0; k < scan_my.size; k++) {
+		int at = (scan_my.pos + k) % scan_my.size;
+		scan_ring_ent * e = &scan_my.ent[at];
+		int index = e->frame;
+		if (&b_M.part[b_index.part] != bp) continue;
+
+		scan_my.take = at;
+		if (!b_index.scan || b_index.table_id != e->table_id || b_index.page_num != e->page_num
+			|| b_index.isdirty || b_index.flushing || !pinClaim(index)) return -1;
+		STAT_ADD(stat_table_get(b_index.table_id)->ring_reuse, 1);
+		pageDrop(index);
+		return freePop(bp);
+	}
+	return -1;
+}
+
+//pageLoad가 힌트를 켠 쓰레드가 올린 프레임을 ring에 넣는다
+//ring이 차기 전에는 뒤에 붙이고, 찬 뒤에는 scanRingPick이 본 자리를 바꾼다 (bp의 프레임이 없었으면 가장 먼저 넣은 자리)
+static void scanRingAdd(int index)
+{
+	int at = scan_my.num < scan_my.size ? scan_my.pos : scan_my.take;
+	scan_ring_ent * e = &scan_my.ent[at];
+	e->frame = index;
+	e->table_id = b_index.table_id;
+	e->page_num = b_index.page_num;
+	if (at == scan_my.pos) {
+		scan_my.pos = (scan_my.pos + 1) % scan_my.size;
+		if (scan_my.num < scan_my.size) scan_my.num++;
+	}
+	scan_my.take = scan_my.pos;
+}
+
+//shared면 page latch를 S모드로 잡아서 돌려준다
+static int pageScanMode(int table, pagenum_t pagenum, int shared)
 {
 //printf("page scan : pagenum = %ld\n",pagenum);
 //if(pagenum>500) exit(0);
-	pthread_mutex_lock(&buf_latch);
-//printf("page scan buf lock\n");
+	//페이지가 속한 partition의 latch만 잡는다
+	buf_part * bp = pagePart(table, pagenum);
+	stat_table * st = stat_table_get(table);
+
+	//이미 올라와 있으면 partition latch 없이 pin부터 잡는다, pin이 있는 동안은 victim이 되지 않는다
+	//pin을 잡기 전에 내려가고 다른 페이지가 올라왔을 수 있으니 latch를 잡은 뒤 다시 본다
+	int i = pageOptFind(table, pagenum);
+	if (i >= 0 && pinTry(i)) {
+		if (shared) pageLatchShared(i);
+		else pageLatch(i);
+		if (b_M.frameArray[i].table_id == table && b_M.frameArray[i].page_num == pagenum) {
+			STAT_ADD(st->hit, 1);
+			if (scan_my.on) return i;
+			//교체 정책 정보는 partition latch 아래서만 고친다, 누가 잡고 있으면 이번 접근은 CLOCK ref만 남긴다
+			if (pthread_mutex_trylock(&bp->latch) == 0) {
+				pageTouch(i);
+				pthread_mutex_unlock(&bp->latch);
+			}
+			else {
+				b_M.frameArray[i].scan = 0;
+				if (b_M.policy == BUF_CLOCK) b_M.frameArray[i].ref = 1;
+			}
+			return i;
+		}
+		pageUnlatch(i);
+		clearPin(i);
+	}
 
+	stat_latch(&bp->latch, STAT_BUF_LATCH);
+//printf("page scan buf lock\n");
 	int victim;
-	//ϴ   öִ Ȯ
-	// pick
-	// ũ ҷ ÷
-	//ҷ ۸Ŵ 
-
-	for (int i = 0; i < b_M.frame_capacity; i++)
-	{
-		if (b_M.frameArray[i].table_id == table && b_M.frameArray[i].page_num == pagenum) {
+	//원하는 페이지가 버퍼위에 올라가있는지 page table에서 확인
+	//있으면 pick
+	//없으면 free frame(없으면 victim)에 디스크에서 불러서 올려줌
+	i = pageTableFind(bp, table, pagenum);
+	if (i != -1) {
 //printf("scan_already exist : i=%d\n",i);
-			setPin(i);
-			pthread_mutex_lock(&b_M.frameArray[i].page_latch);
+		STAT_ADD(st->hit, 1);
+		if (!scan_my.on) pageTouch(i);
+		setPin(i);
+		if (shared) pageLatchShared(i);
+		else pageLatch(i);
 //printf("scan page lock-1 [%d]\n",i);
-			pthread_mutex_unlock(&buf_latch);
+		pthread_mutex_unlock(&bp->latch);
 //printf("scan buf unlock\n");
-			return i;
-		}
+		return i;
 	}
 
 
-	//ڸ  ۿ ÷ش.
-	if (b_M.frame_capacity > b_M.use_num) {
-
-		for (int i = 0; i < b_M.frame_capacity; i++)
-		{
-			//   ã ű  ´
-			if (b_M.frameArray[i].pre == -1 && b_M.frameArray[i].next == -1) {
+	//빈자리가 있을경우 버퍼에 올려준다. scan 힌트면 ring의 프레임부터 다시 쓴다
+	i = scanRingPick(bp);
+	if (i == -1) i = freePop(bp);
+	if (i != -1) {
 //printf("scan_space exist : pagenum=%ld,i=%d\n",pagenum,i);
-				setPage(table, pagenum, i);
-				pageLoad(i);
-				setPin(i);
-				pthread_mutex_lock(&b_M.frameArray[i].page_latch);
+		STAT_ADD(st->miss, 1);
+		setPage(table, pagenum, i);
+		pageLoad(i);
+		setPin(i);
+		if (shared) pageLatchShared(i);
+		else pageLatch(i);
 //printf("scan page lock-2 [%d]\n",i);
-				pthread_mutex_unlock(&buf_latch);
+		pthread_mutex_unlock(&bp->latch);
 //printf("scan buf unlock\n");
-				return i;
-			}
-		}
+		return i;
 	}
 
-	//ڸ °
-	else {
+	//빈자리가 없는경우
 //printf("scan_space full\n");
-			
-	
-
 //printf("victim1 : %d\n",b_M.LRU_tail);
-		victim = b_M.LRU_tail;
-		if (victim == 0) {
+	victim = pageVictim(bp);
+	STAT_ADD(st->miss, 1);
+	STAT_ADD(stat_table_get(b_M.frameArray[victim].table_id)->evict, 1);
 
-			victim = b_M.frameArray[victim].pre;	
-			printf("victim change : %d\n",victim);
-		}
-
-		//뷮̲ drop
-		pageDrop(victim);
+	//용량이꽉찬경우 drop -> free list로 돌아간 프레임을 다시 꺼낸다
+	pageDrop(victim);
+	victim = freePop(bp);
 //printf("page scan : drop complete\n");
 
 
-	}
-
-
 //printf("final victim : %d, pagenum : %ld\n",victim,pagenum);
-		// ӿ   о  
+		//비운 프레임에 새 페이지를 읽어온후 정보 갱신
 	setPin(victim);
-	pthread_mutex_lock(&b_M.frameArray[victim].page_latch);
-	setPage(table, pagenum, victim);//readؼ tableid, pagenum 
-	setDirty(victim);
+	if (shared) pageLatchShared(victim);
+	else pageLatch(victim);
+	setPage(table, pagenum, victim);//read해서 tableid, pagenum 수정
+	//scan 힌트는 읽기만 하므로 clean으로 둬야 ring에서 쓰지 않고 다시 쓸 수 있다
+	if (!scan_my.on) setDirty(victim);
 
 //printf("page scan : page victim lock\n");
 	pageLoad(victim);
 //printf("page scan end\n");
 	
-	pthread_mutex_unlock(&buf_latch);
+	pthread_mutex_unlock(&bp->latch);
 //printf("page scan : buf unlock\n");
 	return victim;
 }
 
-//  ۿ Ǿ  next/pre 
+//pagePrefetch가 읽기를 마친 프레임을 하나씩 푼다 (file_submit의 done)
+static void prefetch_done(file_io * io)
+{
+	int index = (int)(intptr_t)io->arg;
+	if (io->res != SUCCESS) STAT_ADD(stat_table_get(b_M.frameArray[index].table_id)->bad_page, 1);
+	pageWriteEnd(index);
+	clearPin(index);
+	pageUnlatch(index);
+}
+
+//pages 중 버퍼에 없는 것들을 프레임에 올리고 file_submit 한번으로 읽는다 (io_uring이면 queue depth가 그 수만큼)
+//읽는 동안 프레임은 page table에 넣어두고 X latch와 홀수 version으로 막아서, 찾아온 쪽은 읽기가 끝나길 기다린다
+//프레임을 잡은 채로 다른 partition latch를 기다리지 않도록 두번째부터는 trylock, 실패하면 모은 것을 먼저 읽는다
+//미리 읽기일뿐이므로 victim이 dirty거나 쓰는 중이면 그 페이지는 건너뛴다
+//page latch를 하나도 잡지 않은 상태에서 부른다, 올린 페이지 수 리턴
+int pagePrefetch(int table_id, const pagenum_t * pages, int n)
+{
+	file_io io[PREFETCH_MAX];
+	page_t * pg[PREFETCH_MAX];
+	int fd = table_get(table_id)->fd;
+	int m = 0, loaded = 0;
+
+	for (int k = 0; k < n; k++) {
+		if (pages[k] == 0) continue;
+		buf_part * bp = pagePart(table_id, pages[k]);
+		if (m > 0 && (m == PREFETCH_MAX || pthread_mutex_trylock(&bp->latch) != 0)) {
+			file_submit(io, m, prefetch_done);
+			loaded += m;
+			m = 0;
+		}
+		if (m == 0) stat_latch(&bp->latch, STAT_BUF_LATCH);
+
+		if (pageTableFind(bp, table_id, pages[k]) != -1) {
+			pthread_mutex_unlock(&bp->latch);
+			continue;
+		}
+		int i = scanRingPick(bp);
+		if (i == -1) i = freePop(bp);
+		if (i == -1) {
+			int v = pageVictim(bp);
+			buffer_S * f = &b_M.frameArray[v];
+			if (pinCount(v) != PIN_EVICT || f->isdirty || f->flushing || pthread_rwlock_trywrlock(&f->page_latch) != 0) {
+				pinUnclaim(v);
+				pthread_mutex_unlock(&bp->latch);
+				continue;
+			}
+			pageUnlatch(v);
+			STAT_ADD(stat_table_get(f->table_id)->evict, 1);
+			pageDrop(v);
+			i = freePop(bp);
+		}
+		STAT_ADD(stat_table_get(table_id)->miss, 1);
+
+		setPin(i);
+		pageLatch(i);
+		pageWriteBegin(i);
+		b_M.frameArray[i].table_id = table_id;
+		b_M.frameArray[i].page_num = pages[k];
+		b_M.frameArray[i].rec_LSN = -1;
+		pageTableInsert(i);
+		pageLoad(i);
+		pthread_mutex_unlock(&bp->latch);
+
+		pg[m] = b_M.frameArray[i].frame_p;
+		io[m].fd = fd;
+		io[m].page_num = pages[k];
+		io[m].pages = &pg[m];
+		io[m].cnt = 1;
+		io[m].write = 0;
+		io[m].arg = (void*)(intptr_t)i;
+		m++;
+	}
+	if (m > 0) file_submit(io, m, prefetch_done);
+	return loaded + m;
+}
+
+//페이지를 X latch로 잡아서 프레임 인덱스 리턴 (pin도 set)
+int pageScan(int table, pagenum_t pagenum)
+{
+	return pageScanMode(table, pagenum, 0);
+}
+
+//읽기만 할때, S latch라 같은 페이지를 읽는 쪽끼리는 막지 않는다
+int pageScanShared(int table, pagenum_t pagenum)
+{
+	return pageScanMode(table, pagenum, 1);
+}
+
+//flusher가 모은 페이지 하나
+typedef struct flush_ent {
+	int fd;
+	int index;
+	int table_id;
+	pagenum_t page_num;
+	page_t * copy;
+}flush_ent;
+
+static int flush_cmp(const void * a, const void * b)
+{
+	const flush_ent * x = (const flush_ent*)a;
+	const flush_ent * y = (const flush_ent*)b;
+	if (x->fd != y->fd) return x->fd < y->fd ? -1 : 1;
+	if (x->page_num != y->page_num) return x->page_num < y->page_num ? -1 : 1;
+	return 0;
+}
+
+//LRU tail쪽 flush_clean개 프레임 중 dirty이고 pin이 없는 것을 복사해서 내려준다
+//복사는 partition latch 안에서, 디스크 쓰기는 latch 밖에서
+//flush_latch를 잡은 상태에서 호출, 내린 페이지 수 반환
+int flushPart(buf_part * bp, page_t * buf)
+{
+	flush_ent ent[b_opt.flush_clean];
+	int n = 0;
+
+	stat_latch(&bp->latch, STAT_BUF_LATCH);
+	int index = bp->LRU_tail;
+	for (int walk = 0; index >= 0 && walk < b_opt.flush_clean; walk++, index = b_index.pre)
+	{
+		if (!b_index.isdirty || pinCount(index) || b_index.flushing) continue;
+		if (pthread_rwlock_tryrdlock(&b_index.page_latch) != 0) continue;
+
+		memcpy(&buf[n], &b_page, PAGESIZE);
+		b_index.flushing = 1;
+		ent[n].fd = table_get(b_index.table_id)->fd;
+		ent[n].index = index;
+		ent[n].table_id = b_index.table_id;
+		ent[n].page_num = b_index.page_num;
+		ent[n].copy = &buf[n];
+		n++;
+
+		pageUnlatch(index);
+	}
+	pthread_mutex_unlock(&bp->latch);
+
+	if (n == 0) return 0;
+
+	//WAL : 복사본들을 고친 로그까지 먼저 내린다
+	int64_t max_LSN = -1;
+	for (int i = 0; i < n; i++)
+		if (ent[i].page_num != 0 && ent[i].copy->page_LSN > max_LSN) max_LSN = ent[i].copy->page_LSN;
+	if (max_LSN >= 0) log_flush(max_LSN);
+
+	//같은 테이블에서 page_num이 이어지는 것끼리 하나의 write로 묶어 file_submit 한번에 넘긴다
+	qsort(ent, n, sizeof(flush_ent), flush_cmp);
+	page_t * run[b_opt.flush_clean];
+	file_io io[b_opt.flush_clean];
+	int io_num = 0;
+	for (int i = 0; i < n; i++) {
+		run[i] = ent[i].copy;
+		if (i > 0 && ent[i].fd == ent[i - 1].fd && ent[i].page_num == ent[i - 1].page_num + 1) {
+			io[io_num - 1].cnt++;
+			continue;
+		}
+		io[io_num].fd = ent[i].fd;
+		io[io_num].page_num = ent[i].page_num;
+		io[io_num].pages = &run[i];
+		io[io_num].cnt = 1;
+		io[io_num].write = 1;
+		io[io_num].arg = NULL;
+		io_num++;
+	}
+	file_submit(io, io_num, NULL);
+	b_M.flush_write += io_num;
+
+	//테이블마다 fsync
+	for (int i = 0; i < n; i++)
+		if (i == n - 1 || ent[i + 1].fd != ent[i].fd) fdatasync(ent[i].fd);
+
+	//그 사이에 다시 dirty가 되지 않았다면 clean으로
+	stat_latch(&bp->latch, STAT_BUF_LATCH);
+	for (int i = 0; i < n; i++) {
+		STAT_ADD(stat_table_get(ent[i].table_id)->dirty_write, 1);
+		index = ent[i].index;
+		if (b_index.flushing && b_index.table_id == ent[i].table_id && b_index.page_num == ent[i].page_num) {
+			b_index.isdirty = 0;
+			b_index.rec_LSN = -1;
+		}
+		b_index.flushing = 0;
+	}
+	pthread_mutex_unlock(&bp->latch);
+
+	b_M.flush_page += n;
+	return n;
+}
+
+//background flusher, flush_ms마다 또는 pageDrop이 직접 쓸때 깨어난다
+void * flusher_func(void * arg)
+{
+	page_t * buf = (page_t*)malloc(sizeof(page_t) * b_opt.flush_clean);
+	int ms = b_opt.flush_ms > 0 ? b_opt.flush_ms : 10;
+
+	pthread_mutex_lock(&b_M.flush_latch);
+	while (b_M.flusher_run) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += (long)ms * 1000000;
+		ts.tv_sec += ts.tv_nsec / 1000000000;
+		ts.tv_nsec %= 1000000000;
+		pthread_cond_timedwait(&b_M.flush_cond, &b_M.flush_latch, &ts);
+		if (!b_M.flusher_run) break;
+
+		for (int p = 0; p < b_M.part_num; p++)
+			flushPart(&b_M.part[p], buf);
+		b_M.flush_round++;
+	}
+	pthread_mutex_unlock(&b_M.flush_latch);
+
+	free(buf);
+	return NULL;
+}
+
+//버퍼 hit시 교체 정책 정보 갱신
+//CLOCK은 ref bit만 세우므로 공유 리스트를 건드리지 않는다
+void pageTouch(int index)
+{
+	buf_part * bp = &b_M.part[b_index.part];
+
+	b_index.scan = 0;
+	if (b_M.policy == BUF_CLOCK) {
+		b_index.ref = 1;
+	}
+	else if (b_M.policy == BUF_LRU2) {
+		b_index.hist[1] = b_index.hist[0];
+		b_index.hist[0] = ++bp->tick;
+	}
+	else {
+		//LRU : 맨 앞으로 옮겨준다
+		if (b_index.pre == HEAD) return;
+		b_M.frameArray[b_index.pre].next = b_index.next;
+		if (b_index.next == TAIL) bp->LRU_tail = b_index.pre;
+		else b_M.frameArray[b_index.next].pre = b_index.pre;
+
+		b_index.pre = HEAD;
+		b_index.next = bp->LRU_head;
+		b_M.frameArray[bp->LRU_head].pre = index;
+		bp->LRU_head = index;
+	}
+}
+
+//partition 안에서 내보낼 프레임을 고른다, pin이 잡히거나 flush 중인 프레임은 건너뛴다
+//고른 프레임은 pinClaim으로 PIN_EVICT가 되어 돌아오고 pageDrop(또는 pinUnclaim)이 다시 0으로 돌린다
+//전부 pin이면 예전처럼 LRU tail을 억지로 잡는다, pin 수는 그대로 두므로 잡고 있던 쪽의 clearPin이 그대로 맞는다
+//(pageDrop이 page latch를 기다리므로 읽는 중에 내리지는 않는다)
+int pageVictim(buf_part * bp)
+{
+	int victim = -1;
+
+	if (b_M.policy == BUF_CLOCK) {
+		int n = bp->end - bp->begin;
+		//두바퀴 돌면 ref가 전부 내려가므로 그 안에 찾는다
+		for (int step = 0; step < 2 * n; step++) {
+			int i = bp->hand;
+			bp->hand = (bp->hand + 1 < bp->end) ? bp->hand + 1 : bp->begin;
+
+			if (pinCount(i) || b_M.frameArray[i].flushing) continue;
+			if (b_M.frameArray[i].ref) {
+				b_M.frameArray[i].ref = 0;
+				continue;
+			}
+			if (!pinClaim(i)) continue;
+			victim = i;
+			break;
+		}
+	}
+	else if (b_M.policy == BUF_LRU2) {
+		//두번째 최근 접근이 가장 오래된 프레임, 한번만 접근한 프레임(0)이 먼저 나간다
+		for (int i = bp->begin; i < bp->end; i++) {
+			if (pinCount(i) || b_M.frameArray[i].flushing) continue;
+			if (victim == -1
+				|| b_M.frameArray[i].hist[1] < b_M.frameArray[victim].hist[1]
+				|| (b_M.frameArray[i].hist[1] == b_M.frameArray[victim].hist[1]
+					&& b_M.frameArray[i].hist[0] < b_M.frameArray[victim].hist[0]))
+				victim = i;
+		}
+		//고르는 사이 누가 pin을 잡았으면 다음 기회에
+		if (victim >= 0 && !pinClaim(victim)) victim = -1;
+	}
+	else {
+		//tail부터 거슬러 올라가며 pin이 없는 프레임을 고른다
+		victim = bp->LRU_tail;
+		while (victim >= 0 && (b_M.frameArray[victim].flushing || !pinClaim(victim)))
+			victim = b_M.frameArray[victim].pre;
+	}
+
+	if (victim < 0) victim = bp->LRU_tail;
+	return victim;
+}
+
+//새 페이지를 버퍼에 실었기 때문에 next/pre값을 갱신
 int pageLoad(int index)
 {
 //printf("\npage load : index=%d \n", index);
 
-	b_M.use_num++;
+	buf_part * bp = &b_M.part[b_index.part];
+	bp->use_num++;
+
+	//교체 정책 정보 초기화, CLOCK은 한번 더 접근해야 ref가 선다
+	b_index.ref = 0;
+	b_index.hist[0] = ++bp->tick;
+	b_index.hist[1] = 0;
+	b_index.scan = scan_my.on;
+	if (scan_my.on) scanRingAdd(index);
 
-	if (b_M.use_num == 1) {
+	if (bp->use_num == 1) {
 //printf("page load only use1_return\n");
-		b_M.LRU_head = index;
-		b_M.LRU_tail = index;
-		b_index.pre = HEAD; // ڽ Ǿ
-		b_index.next = TAIL; //ڽ ǳ
+		bp->LRU_head = index;
+		bp->LRU_tail = index;
+		b_index.pre = HEAD; // 자신이 맨앞
+		b_index.next = TAIL; //자신이 맨끝
 
 		return SUCCESS;
 	}
 //printf("page load more than one..\n");
-		//  
-	b_index.pre = HEAD; // ڽ Ǿ̶ Ҹ
-	b_index.next = b_M.LRU_head;
+		//새로 실은 페이지
+	b_index.pre = HEAD; // 자신이 맨앞이라는 소리
+	b_index.next = bp->LRU_head;
 
-	//յڷ 
-	b_M.frameArray[b_M.LRU_head].pre = index;
-	b_M.LRU_head = index;
+	//앞뒤로 수정
+	b_M.frameArray[bp->LRU_head].pre = index;
+	bp->LRU_head = index;
 
 
 //printf("pageload end\n");
@@ -888,74 +3992,209 @@ int pageLoad(int index)
 }
 
 
-//   üũϴ Լ
-//ؽ ʿ 
+//모든 프레임이 사용중인지 체크하는 함수
+//뮤텍스 할필요 없음
 int pinCheck()
 {
 	for (int i = 1; i < b_M.frame_capacity; i++)
 	{
 
-		if (b_M.frameArray[i].ispinned == 0) {
+		if (pinCount(i) == 0) {
 			//printf("pinCheck... : i=%d\n",i);
 			return SUCCESS;
 		}
 
 	}
 	//printf("all page is pinnded. Please wait and try again....\n");
-	//
+	//실패
 	return FAIL;
 
 }
 
 
-// оͼ Ʈ
-//ؽ ʿ 
+//페이지를 읽어와서 업데이트
+//뮤텍스 할필요 없음
 void setPage(int table_id, pagenum_t page_num, int index)
 {
 
 	
 	//bufInfo();
-	file_read_page(b_M.table[table_id - 1].fd, page_num, &b_page);
+	pageWriteBegin(index);
+	TRACE_START(t);
+	if (file_read_page(table_get(table_id)->fd, page_num, &b_page) != SUCCESS) STAT_ADD(stat_table_get(table_id)->bad_page, 1);
+	TRACE(TRACE_PAGE_MISS, t, table_id, page_num);
 	b_index.table_id = table_id;
 	b_index.page_num = page_num;
+	b_index.rec_LSN = -1;
+	pageTableInsert(index);
+	pageWriteEnd(index);
 
 
 	//bufInfo();
 
 }
 
-//Ʒ  set/clear
+//아래는 전부 set/clear
 void setDirty(int index)
 {
 	b_index.isdirty = 1;
+	//flusher가 들고 있는 복사본은 이제 옛날 것
+	b_index.flushing = 0;
+}
+
+
+//로그를 남긴 변경, 처음 dirty가 될때의 LSN이 checkpoint의 dirty page table로 간다
+void setDirtyLSN(int index, int64_t LSN)
+{
+	if (b_index.rec_LSN < 0) b_index.rec_LSN = LSN;
+	setDirty(index);
 }
 
 
 void clearDirty(int index)
 {
 	b_index.isdirty = 0;
+	b_index.rec_LSN = -1;
 }
 
+//partition latch를 잡고 page table에서 찾은 프레임에만 쓴다, 그런 프레임은 victim으로 잡혀있을 수 없다
 void setPin(int index) {
-	b_index.ispinned = 1;
+	__atomic_fetch_add(&b_index.pin, 1, __ATOMIC_ACQ_REL);
+}
+
+//partition latch 없이 pin을 얻는다, victim으로 잡혀 내리는 중이면 0
+//pin을 얻은 뒤에도 프레임의 페이지가 바뀌었을 수 있으니 latch를 잡고 table_id/page_num을 확인해야 한다
+int pinTry(int index) {
+	int c = __atomic_load_n(&b_index.pin, __ATOMIC_RELAXED);
+	do {
+		if (c < 0) return 0;
+	} while (!__atomic_compare_exchange_n(&b_index.pin, &c, c + 1, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+	return 1;
 }
 
+//pin이 없거나 내리는 중이면 그대로 둔다
 void clearPin(int index) {
-	b_index.ispinned = 0;
+	int c = __atomic_load_n(&b_index.pin, __ATOMIC_RELAXED);
+	do {
+		if (c <= 0) return;
+	} while (!__atomic_compare_exchange_n(&b_index.pin, &c, c - 1, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+}
+
+//pin이 0이면 PIN_EVICT로 바꾸고 1, partition latch를 잡고 부른다
+int pinClaim(int index) {
+	int zero = 0;
+	return __atomic_compare_exchange_n(&b_index.pin, &zero, PIN_EVICT, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+//pinClaim으로 잡은 프레임을 다시 0으로, 잡혀있지 않으면 그대로 둔다
+void pinUnclaim(int index) {
+	int evict = PIN_EVICT;
+	__atomic_compare_exchange_n(&b_index.pin, &evict, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+//pin 수, 내리는 중이면 PIN_EVICT
+int pinCount(int index) {
+	return __atomic_load_n(&b_index.pin, __ATOMIC_ACQUIRE);
+}
+
+//page latch, 읽기는 S 쓰기는 X
+void pageLatch(int index) {
+	TRACE_START(t);
+	pthread_rwlock_wrlock(&b_index.page_latch);
+	TRACE(TRACE_PAGE_LATCH, t, index, 1);
+}
+
+void pageLatchShared(int index) {
+	TRACE_START(t);
+	pthread_rwlock_rdlock(&b_index.page_latch);
+	TRACE(TRACE_PAGE_LATCH, t, index, 0);
+}
+
+void pageUnlatch(int index) {
+	pthread_rwlock_unlock(&b_index.page_latch);
+	TRACE(TRACE_PAGE_UNLATCH, 0, index, 0);
+}
+
+//page table / free frame list
+//전부 해당 partition latch를 잡은 상태에서 호출된다
+uint64_t pageHash(int table_id, pagenum_t page_num)
+{
+	uint64_t h = ((uint64_t)table_id << 48) ^ page_num;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+//상위 비트로 partition, 하위 비트로 버킷을 고른다
+buf_part * pagePart(int table_id, pagenum_t page_num)
+{
+	return &b_M.part[(pageHash(table_id, page_num) >> 32) % b_M.part_num];
+}
+
+int pageTableFind(buf_part * p, int table_id, pagenum_t page_num)
+{
+	int i = p->page_table[pageHash(table_id, page_num) & (p->page_table_size - 1)];
+	while (i != -1) {
+		if (b_M.frameArray[i].table_id == table_id && b_M.frameArray[i].page_num == page_num)
+			return i;
+		i = b_M.frameArray[i].hash_next;
+	}
+	return -1;
+}
+
+void pageTableInsert(int index)
+{
+	buf_part * p = &b_M.part[b_index.part];
+	int h = pageHash(b_index.table_id, b_index.page_num) & (p->page_table_size - 1);
+	b_index.hash_next = p->page_table[h];
+	p->page_table[h] = index;
+}
+
+void pageTableRemove(int index)
+{
+	buf_part * p = &b_M.part[b_index.part];
+	int h = pageHash(b_index.table_id, b_index.page_num) & (p->page_table_size - 1);
+	int * link = &p->page_table[h];
+
+	while (*link != -1) {
+		if (*link == index) {
+			*link = b_index.hash_next;
+			break;
+		}
+		link = &b_M.frameArray[*link].hash_next;
+	}
+	b_index.hash_next = -1;
+}
+
+void freePush(int index)
+{
+	buf_part * p = &b_M.part[b_index.part];
+	b_index.free_next = p->free_head;
+	p->free_head = index;
+}
+
+int freePop(buf_part * p)
+{
+	int index = p->free_head;
+	if (index == -1) return -1;
+	p->free_head = b_index.free_next;
+	b_index.free_next = -1;
+	return index;
 }
 
 ///////////////
-//߿ κ
+//나중에 지울부분
 queue * q;
 void print_tree(int table_id) {
 	printf("\n<print tree>\n");
 	pagenum_t nnum, rnum;
 
-	//޾ƿ
-	int head = pageScan(table_id, 0);
+	//헤더받아오기
+	int head = pageScanShared(table_id, 0);
 	pagenum_t root=b_head.root_page;
 	clearPin(head);
-	pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+	pageUnlatch(head);
 
 	//if  no root
 	if (root == 0) {
@@ -965,6 +4204,8 @@ void print_tree(int table_id) {
 
 	q = (queue*)malloc(sizeof(queue));
 	q = NULL;
+	//트리 전체를 읽으므로 버퍼의 working set을 밀어내지 않게 한다
+	int hint = bufScanHint(1);
 
 	rnum = root;
 	enqueue(rnum);
@@ -973,32 +4214,33 @@ void print_tree(int table_id) {
 //printf("print tree 2\n");
 		//dequeue and trace
 		nnum = dequeue();
-		int tmp = pageScan(table_id, nnum);
+		int tmp = pageScanShared(table_id, nnum);
 
 
-		//printf("<my parent = %ld> <my pagenum = %ld> ", b_M.frameArray[tmp].frame_p.parent, nnum);
+		//printf("<my parent = %ld> <my pagenum = %ld> ", b_M.frameArray[tmp].frame_p->parent, nnum);
 
-		for (int i = 0; i < b_M.frameArray[tmp].frame_p.num_key; ++i) {
+		for (int i = 0; i < b_M.frameArray[tmp].frame_p->num_key; ++i) {
 
-			printf("%" PRId64 " ", b_M.frameArray[tmp].frame_p.is_leaf ? b_M.frameArray[tmp].frame_p.record[i].key : b_M.frameArray[tmp].frame_p.branch[i].key);
-			if(b_M.frameArray[tmp].frame_p.is_leaf)printf(":%s, ", b_M.frameArray[tmp].frame_p.record[i].val);
+			printf("%" PRId64 " ", b_M.frameArray[tmp].frame_p->is_leaf ? leaf_key(b_M.frameArray[tmp].frame_p, i) : node_key(b_M.frameArray[tmp].frame_p, i));
+			if(b_M.frameArray[tmp].frame_p->is_leaf)printf(":%s, ", leaf_val(b_M.frameArray[tmp].frame_p, i));
 		}
 		//isnot leaf enqueue
-		if (!b_M.frameArray[tmp].frame_p.is_leaf) {
+		if (!b_M.frameArray[tmp].frame_p->is_leaf) {
 
-			enqueue(b_M.frameArray[tmp].frame_p.right_left);
-			//printf("enqueue : %ld\n",b_M.frameArray[tmp].frame_p.right_left);
-			for (int i = 0; i < b_M.frameArray[tmp].frame_p.num_key; ++i) {
-				enqueue(b_M.frameArray[tmp].frame_p.branch[i].child);
-				//printf("enqueue : %ld\n",b_M.frameArray[tmp].frame_p.branch[i].child);
+			enqueue(b_M.frameArray[tmp].frame_p->right_left);
+			//printf("enqueue : %ld\n",b_M.frameArray[tmp].frame_p->right_left);
+			for (int i = 0; i < b_M.frameArray[tmp].frame_p->num_key; ++i) {
+				enqueue(node_child(b_M.frameArray[tmp].frame_p, i));
+				//printf("enqueue : %ld\n",b_M.frameArray[tmp].frame_p->branch[i].child);
 			}
 		}
 		printf("| ");
 		clearPin(tmp);
-		pthread_mutex_unlock(&b_M.frameArray[tmp].page_latch);
+		pageUnlatch(tmp);
 //printf("print tree unlock suc\n");
 	}
 	printf("\n");
+	bufScanHint(hint);
 
 
 
@@ -1020,7 +4262,7 @@ printf("\n<print tree direct>\n");
 	//header get
 	header_page * head;
 	head = (header_page *)calloc(1, PAGESIZE);
-	file_read_page(b_M.table[table_id - 1].fd,0, (page_t *)head);
+	file_read_page(table_get(table_id)->fd,0, (page_t *)head);
 
 	//if  no root
 	if (head->root_page == 0) {
@@ -1044,19 +4286,19 @@ printf("\n<print tree direct>\n");
 		//dequeue and trace
 		nnum = dequeue();
 
-		file_read_page(b_M.table[table_id - 1].fd,nnum, n);
+		file_read_page(table_get(table_id)->fd,nnum, n);
 		//printf("<my parent = %ld> <my pagenum = %ld> ",n->parent,nnum);
 		for (i = 0; i < n->num_key; ++i) {
 	
-			printf("%" PRId64 " ", n->is_leaf ? n->record[i].key : n->branch[i].key);
-			if(n->is_leaf)printf(":%s, ",n->record[i].val);
+			printf("%" PRId64 " ", n->is_leaf ? leaf_key(n, i) : node_key(n, i));
+			if(n->is_leaf)printf(":%s, ",leaf_val(n, i));
 		}
 		//isnot leaf enqueue
 		if (!n->is_leaf) {
 
 			enqueue(n->right_left);
 			for (i = 0; i < n->num_key; ++i)
-				enqueue(n->branch[i].child);
+				enqueue(node_child(n, i));
 		}
 		printf("| ");
 	}
@@ -1064,7 +4306,7 @@ printf("\n<print tree direct>\n");
 
 	printf( "<free page>\n"); 
 	page_t *  freeprint = (page_t *)calloc(1, PAGESIZE);
-	file_read_page(b_M.table[table_id - 1].fd,head->free_page, freeprint);
+	file_read_page(table_get(table_id)->fd,head->free_page, freeprint);
 
 	
 	int cnt=0;
@@ -1077,27 +4319,443 @@ printf("\n<print tree direct>\n");
 		printf("free %d : %ld \n",cnt,tmp_next);
 		tmp_next = freeprint->parent;
 		if(freeprint->parent==0)break;
-		file_read_page(b_M.table[table_id - 1].fd,freeprint->parent,freeprint);
+		file_read_page(table_get(table_id)->fd,freeprint->parent,freeprint);
+
+
+	}
+	}
+	
+	free(n);
+	free(par_n);
+	free(q);
+
+
+}
+
+//////////////////////////////////////////// db_verify
+//버퍼를 거치지 않고 테이블 파일을 직접 읽어 트리 모양을 확인한다
+//1) 쓰레드들이 VERIFY_CHUNK 페이지씩 받아 파일 순서대로 크게 읽으며 페이지마다 키 순서 / 키 수 / checksum을 보고 요약만 남긴다
+//2) free list를 요약의 parent로 따라가며 표시한다
+//3) 루트쪽 subtree들을 쓰레드들이 나눠 내려가며 parent, 키 범위, 깊이, 두번 가리킨 페이지, 리프 sibling을 본다 (인터널만 다시 읽는다)
+//처음에 버퍼의 dirty 페이지를 파일에 써두지만 그 뒤로는 파일만 보므로 이 테이블을 고치는 쪽이 없을때 부른다
+//free page는 내용으로 알 수 없어서, 페이지마다 본 것은 트리에서 닿은 페이지일때만 오류로 센다
+
+#define VF_ORDER 1//키가 오름차순이 아니다
+#define VF_COUNT 2//num_key가 범위 밖
+#define VF_CSUM 4//checksum이 맞지 않는다
+#define VF_SLOT 8//LEAF_SLOT의 slot이 heap 밖을 가리킨다
+#define VM_FREE 1//free list에서 닿았다
+#define VM_TREE 2//트리에서 닿았다
+
+//페이지 하나의 요약, 파일 크기만큼 잡으므로 작게 둔다
+typedef struct verify_meta {
+	pagenum_t parent;//free 페이지면 다음 free 페이지
+	pagenum_t right_left;
+	int64_t lo;//첫 키
+	int64_t hi;//마지막 키
+	uint16_t num_key;
+	uint16_t dead_num;
+	uint16_t fill;//65535가 꽉 찬 것
+	uint8_t is_leaf;
+	uint8_t flag;//VF_*
+	uint8_t mark;//VM_*, 쓰레드끼리 atomic으로 세운다
+}verify_meta;
+
+//subtree 하나, 키는 [lo, hi) 안에 있어야 한다 (has_lo/has_hi가 0이면 그쪽은 끝이 없다)
+typedef struct verify_task {
+	pagenum_t pn;
+	pagenum_t parent;
+	int64_t lo;
+	int64_t hi;
+	int has_lo;
+	int has_hi;
+	int depth;
+	pagenum_t first_leaf;//이 subtree에서 처음과 마지막으로 본 리프, 없으면 0
+	pagenum_t last_leaf;
+}verify_task;
+
+//쓰레드마다 모으고 끝날때 더한다
+typedef struct verify_local {
+	uint64_t leaf;
+	uint64_t internal;
+	uint64_t record;
+	uint64_t dead;
+	uint64_t leaf_jump;
+	double leaf_fill;
+	double internal_fill;
+	int min_depth;
+	int max_depth;
+}verify_local;
+
+typedef struct verify_ctx {
+	const Table * tb;
+	int fd;
+	pagenum_t page_num;
+	verify_meta * meta;
+	pagenum_t next_chunk;//다음에 읽을 페이지, 쓰레드들이 atomic으로 VERIFY_CHUNK씩 가져간다
+	verify_task * task;
+	int task_num;
+	int next_task;
+	pthread_mutex_t latch;//local을 더할때
+	verify_local sum;
+	uint64_t error;
+}verify_ctx;
+
+static void verify_error(verify_ctx * c, pagenum_t pn, const char * what)
+{
+	if (__atomic_fetch_add(&c->error, 1, __ATOMIC_RELAXED) < VERIFY_REPORT)
+		printf("verify : page %" PRIu64 " %s\n", pn, what);
+}
+
+static void verify_local_init(verify_local * l)
+{
+	memset(l, 0, sizeof(verify_local));
+	l->min_depth = INT_MAX;
+	l->max_depth = -1;
+}
+
+static void verify_local_add(verify_ctx * c, const verify_local * l)
+{
+	pthread_mutex_lock(&c->latch);
+	c->sum.leaf += l->leaf;
+	c->sum.internal += l->internal;
+	c->sum.record += l->record;
+	c->sum.dead += l->dead;
+	c->sum.leaf_jump += l->leaf_jump;
+	c->sum.leaf_fill += l->leaf_fill;
+	c->sum.internal_fill += l->internal_fill;
+	if (l->min_depth < c->sum.min_depth) c->sum.min_depth = l->min_depth;
+	if (l->max_depth > c->sum.max_depth) c->sum.max_depth = l->max_depth;
+	pthread_mutex_unlock(&c->latch);
+}
+
+//cnt개 페이지를 from부터 읽는다, mmap 테이블이면 복사만
+static int verify_read(verify_ctx * c, pagenum_t from, int cnt, page_t * buf)
+{
+	if (c->tb->map) {
+		memcpy(buf, c->tb->map + from * PAGESIZE, (size_t)cnt * PAGESIZE);
+		return SUCCESS;
+	}
+	page_t * pages[VERIFY_CHUNK];
+	for (int i = 0; i < cnt; i++) pages[i] = &buf[i];
+	//파일 끝을 넘으면 덜 채워지므로 비워두고 읽는다
+	memset(buf, 0, (size_t)cnt * PAGESIZE);
+	file_io io = { .fd = c->fd, .page_num = from, .pages = pages, .cnt = cnt, .write = 0, .arg = NULL };
+	return file_submit(&io, 1, NULL);
+}
+
+//읽은 페이지 하나를 요약한다
+static void verify_page(verify_ctx * c, pagenum_t pn, const page_t * pg)
+{
+	verify_meta * m = &c->meta[pn];
+	m->parent = pg->parent;
+	m->right_left = pg->right_left;
+	m->is_leaf = pg->is_leaf == 1;
+	m->dead_num = pg->dead_num;
+	if (!b_opt.no_checksum && pg->checksum != 0 && page_checksum(pg) != pg->checksum) m->flag |= VF_CSUM;
+
+	int slot = m->is_leaf && pg->leaf_layout == LEAF_SLOT;
+	int cap = m->is_leaf ? (slot ? slot_max : leaf_order) : node_cap(pg->layout);
+	int n = pg->num_key;
+	if (n < 0 || n > cap || (slot && (pg->heap > leaf_body || n * (int)sizeof(leaf_slot) > pg->heap))) {
+		m->flag |= VF_COUNT;
+		n = 0;
+	}
+	m->num_key = n;
+
+	for (int i = 0; i < n; i++) {
+		int64_t k = m->is_leaf ? leaf_key(pg, i) : node_key(pg, i);
+		if (i == 0) m->lo = k;
+		else if (k <= m->hi) m->flag |= VF_ORDER;
+		m->hi = k;
+		if (slot && (pg->slot[i].off < pg->heap || pg->slot[i].off + pg->slot[i].len > leaf_body)) m->flag |= VF_SLOT;
+	}
+
+	double fill = (double)n / cap;
+	if (slot) {
+		int used = n * (int)sizeof(leaf_slot) + (leaf_body - pg->heap) - pg->garbage;
+		fill = used < 0 ? 0 : (double)used / leaf_body;
+	}
+	m->fill = (uint16_t)(fill > 1 ? 65535 : fill * 65535);
+}
+
+static void * verify_scan_thread(void * arg)
+{
+	verify_ctx * c = (verify_ctx*)arg;
+	page_t * buf;
+	if (posix_memalign((void**)&buf, PAGESIZE, (size_t)VERIFY_CHUNK * PAGESIZE) != 0) return NULL;
+
+	while (1) {
+		pagenum_t from = __atomic_fetch_add(&c->next_chunk, VERIFY_CHUNK, __ATOMIC_RELAXED);
+		if (from >= c->page_num) break;
+		int cnt = c->page_num - from < VERIFY_CHUNK ? (int)(c->page_num - from) : VERIFY_CHUNK;
+		//checksum이 틀린 페이지가 있으면 FAIL이지만 나머지는 다 읽혀 있고 그 페이지는 VF_CSUM으로 따로 센다
+		verify_read(c, from, cnt, buf);
+		for (int i = 0; i < cnt; i++) verify_page(c, from + i, &buf[i]);
+	}
+	free(buf);
+	return NULL;
+}
+
+//pn과 그 아래를 확인한다, out이 있으면 자식은 내려가지 않고 task로 붙인다
+static void verify_node(verify_ctx * c, verify_local * l, verify_task * t, const verify_task * at, verify_task ** out, int * out_num)
+{
+	pagenum_t pn = at->pn;
+	if (pn == 0 || pn >= c->page_num) {
+		verify_error(c, at->parent, "points outside the file");
+		return;
+	}
+	verify_meta * m = &c->meta[pn];
+	uint8_t mark = __atomic_fetch_or(&m->mark, VM_TREE, __ATOMIC_RELAXED);
+	if (mark & VM_TREE) {
+		verify_error(c, pn, "is referenced twice");
+		return;
+	}
+	if (mark & VM_FREE) verify_error(c, pn, "is in the tree and on the free list");
+	if (m->parent != at->parent) verify_error(c, pn, "has a wrong parent pointer");
+	if (m->flag & VF_CSUM) verify_error(c, pn, "checksum mismatch");
+	if (m->flag & VF_COUNT) verify_error(c, pn, "num_key out of range");
+	if (m->flag & VF_ORDER) verify_error(c, pn, "keys out of order");
+	if (m->flag & VF_SLOT) verify_error(c, pn, "slot outside the heap");
+	if (m->num_key > 0 && ((at->has_lo && m->lo < at->lo) || (at->has_hi && m->hi >= at->hi)))
+		verify_error(c, pn, "key outside the parent's range");
+
+	if (m->is_leaf) {
+		l->leaf++;
+		l->record += m->num_key;
+		l->dead += m->dead_num;
+		l->leaf_fill += m->fill / 65535.0;
+		if (at->depth < l->min_depth) l->min_depth = at->depth;
+		if (at->depth > l->max_depth) l->max_depth = at->depth;
+		//키 순서로 내려가므로 바로 앞에 본 리프의 오른쪽이어야 한다
+		if (t->last_leaf) {
+			if (c->meta[t->last_leaf].right_left != pn) verify_error(c, t->last_leaf, "sibling link does not point to the next leaf");
+			if (pn != t->last_leaf + 1) l->leaf_jump++;
+		}
+		else t->first_leaf = pn;
+		t->last_leaf = pn;
+		return;
+	}
+
+	l->internal++;
+	l->internal_fill += m->fill / 65535.0;
+	if (m->flag & VF_COUNT) return;
+
+	//자식과 키를 복사해두고 내려간다
+	page_t * pg;
+	if (posix_memalign((void**)&pg, PAGESIZE, PAGESIZE) != 0) return;
+	verify_read(c, pn, 1, pg);
+	int n = m->num_key;
+	verify_task * child = (verify_task*)malloc((n + 1) * sizeof(verify_task));
+	for (int i = -1; i < n; i++) {
+		verify_task * ch = &child[i + 1];
+		ch->pn = node_child(pg, i);
+		ch->parent = pn;
+		ch->lo = i < 0 ? at->lo : node_key(pg, i);
+		ch->has_lo = i < 0 ? at->has_lo : 1;
+		ch->hi = i + 1 < n ? node_key(pg, i + 1) : at->hi;
+		ch->has_hi = i + 1 < n ? 1 : at->has_hi;
+		ch->depth = at->depth + 1;
+		ch->first_leaf = ch->last_leaf = 0;
+	}
+	free(pg);
+
+	for (int i = 0; i <= n; i++) {
+		if (out) {
+			(*out)[(*out_num)++] = child[i];
+			continue;
+		}
+		verify_node(c, l, t, &child[i], NULL, NULL);
+	}
+	free(child);
+}
+
+static void * verify_tree_thread(void * arg)
+{
+	verify_ctx * c = (verify_ctx*)arg;
+	verify_local l;
+	verify_local_init(&l);
+	while (1) {
+		int k = __atomic_fetch_add(&c->next_task, 1, __ATOMIC_RELAXED);
+		if (k >= c->task_num) break;
+		verify_node(c, &l, &c->task[k], &c->task[k], NULL, NULL);
+	}
+	verify_local_add(c, &l);
+	return NULL;
+}
+
+//fn을 nthreads개 쓰레드로 돌린다, 0번은 부른 쓰레드가 돌고 만들지 못한 쓰레드 몫도 남은 쓰레드들이 가져간다
+static void verify_run(verify_ctx * c, int nthreads, void * (*fn)(void *))
+{
+	pthread_t th[VERIFY_THREAD_MAX];
+	int started[VERIFY_THREAD_MAX] = { 0 };
+	for (int i = 1; i < nthreads; i++) started[i] = pthread_create(&th[i], 0, fn, c) == 0;
+	fn(c);
+	for (int i = 1; i < nthreads; i++) if (started[i]) pthread_join(th[i], NULL);
+}
 
+//테이블의 dirty 프레임을 파일에 쓰기만 한다, 버퍼에는 dirty로 그대로 둔다
+static void verify_flush(int table_id)
+{
+	const Table * tb = table_get(table_id);
+	page_t * copy;
+	if (tb->map || posix_memalign((void**)&copy, PAGESIZE, PAGESIZE) != 0) return;
+	for (int i = 0; i < b_M.frame_capacity; i++) {
+		buffer_S * f = &b_M.frameArray[i];
+		if (f->table_id != table_id || !f->isdirty || !pinTry(i)) continue;
+		pageLatchShared(i);
+		pagenum_t pn = f->page_num;
+		int dirty = f->table_id == table_id && f->isdirty;
+		if (dirty) memcpy(copy, f->frame_p, PAGESIZE);
+		pageUnlatch(i);
+		clearPin(i);
+		if (!dirty) continue;
+		//WAL : 페이지를 고친 로그가 먼저 내려가야 한다
+		if (pn != 0) log_flush(copy->page_LSN);
+		file_write_pages(tb->fd, pn, &copy, 1);
+	}
+	fdatasync(tb->fd);
+	free(copy);
+}
 
+//table_id의 파일을 nthreads개 쓰레드로 확인한다, 오류 수 리턴 (테이블이 열려있지 않으면 FAIL)
+//오류는 처음 VERIFY_REPORT개만 출력하고, out이 있으면 통계를 채운다
+int db_verify(int table_id, int nthreads, verify_stat * out)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	if (nthreads < 1) nthreads = 1;
+	if (nthreads > VERIFY_THREAD_MAX) nthreads = VERIFY_THREAD_MAX;
+	uint64_t start = stat_ns();
+
+	verify_ctx c;
+	memset(&c, 0, sizeof(c));
+	c.tb = table_get(table_id);
+	c.fd = c.tb->fd;
+	pthread_mutex_init(&c.latch, NULL);
+	verify_local_init(&c.sum);
+
+	verify_flush(table_id);
+	header_page * h;
+	if (posix_memalign((void**)&h, PAGESIZE, PAGESIZE) != 0) return FAIL;
+	if (verify_read(&c, 0, 1, (page_t*)h) != SUCCESS) verify_error(&c, 0, "header checksum mismatch");
+	c.page_num = h->page_num > 0 ? (pagenum_t)h->page_num : 1;
+	if (c.tb->map && c.page_num > c.tb->map_pages) {
+		verify_error(&c, 0, "page_num is past the end of the file");
+		c.page_num = c.tb->map_pages;
 	}
+	pagenum_t root = h->root_page, free_page = h->free_page;
+	free(h);
+
+	//1) 파일 전체를 순서대로 읽는다
+	c.meta = (verify_meta*)calloc(c.page_num, sizeof(verify_meta));
+	if (!c.meta) return FAIL;
+	c.next_chunk = 1;
+	verify_run(&c, nthreads, verify_scan_thread);
+
+	//2) free list
+	uint64_t free_num = 0;
+	for (pagenum_t pn = free_page; pn != 0; pn = c.meta[pn].parent) {
+		if (pn >= c.page_num) {
+			verify_error(&c, pn, "free list points outside the file");
+			break;
+		}
+		if (c.meta[pn].mark & VM_FREE) {
+			verify_error(&c, pn, "free list has a cycle");
+			break;
+		}
+		c.meta[pn].mark |= VM_FREE;
+		free_num++;
 	}
-	
-	free(n);
-	free(par_n);
-	free(q);
 
+	//3) 트리, 쓰레드마다 VERIFY_TASK개 이상의 subtree가 나오도록 루트쪽 인터널은 여기서 본다
+	verify_local top;
+	verify_local_init(&top);
+	verify_task first = { .pn = root, .parent = 0, .depth = 0 };
+	int want = nthreads * VERIFY_TASK;
+	c.task = (verify_task*)malloc(sizeof(verify_task));
+	c.task[0] = first;
+	c.task_num = root != 0 && root < c.page_num ? 1 : 0;
+	if (root >= c.page_num) verify_error(&c, 0, "root points outside the file");
+	while (c.task_num > 0 && c.task_num < want && !c.meta[c.task[0].pn].is_leaf) {
+		int next_num = 0, next_cap = 1;
+		for (int k = 0; k < c.task_num; k++) next_cap += c.meta[c.task[k].pn].num_key + 1;
+		verify_task * next = (verify_task*)malloc(next_cap * sizeof(verify_task));
+		for (int k = 0; k < c.task_num; k++) {
+			//층이 어긋난 리프는 그대로 task로 남긴다 (깊이 검사에서 걸린다)
+			if (c.meta[c.task[k].pn].is_leaf) next[next_num++] = c.task[k];
+			else verify_node(&c, &top, &c.task[k], &c.task[k], &next, &next_num);
+		}
+		free(c.task);
+		c.task = next;
+		c.task_num = next_num;
+	}
+	verify_local_add(&c, &top);
+	verify_run(&c, nthreads, verify_tree_thread);
+
+	//subtree 사이의 sibling, 마지막 리프의 오른쪽은 0
+	pagenum_t last = 0;
+	for (int k = 0; k < c.task_num; k++) {
+		if (!c.task[k].first_leaf) continue;
+		if (last) {
+			if (c.meta[last].right_left != c.task[k].first_leaf) verify_error(&c, last, "sibling link does not point to the next leaf");
+			if (c.task[k].first_leaf != last + 1) c.sum.leaf_jump++;
+		}
+		last = c.task[k].last_leaf;
+	}
+	if (last && c.meta[last].right_left != 0) verify_error(&c, last, "last leaf has a right sibling");
+	if (c.sum.leaf > 0 && c.sum.min_depth != c.sum.max_depth) verify_error(&c, root, "leaves are at different depths");
+
+	//어디서도 닿지 않은 페이지, 쓰레드가 잡아둔 extent에 남은 것이거나 잃어버린 것
+	uint64_t unused = 0;
+	for (pagenum_t pn = 1; pn < c.page_num; pn++)
+		if (!c.meta[pn].mark) unused++;
+
+	if (out) {
+		memset(out, 0, sizeof(verify_stat));
+		out->page_num = c.page_num;
+		out->depth = c.sum.leaf > 0 ? c.sum.max_depth + 1 : 0;
+		out->leaf = c.sum.leaf;
+		out->internal = c.sum.internal;
+		out->record = c.sum.record;
+		out->dead = c.sum.dead;
+		out->free = free_num;
+		out->unused = unused;
+		out->leaf_jump = c.sum.leaf_jump;
+		out->leaf_fill = c.sum.leaf ? c.sum.leaf_fill / c.sum.leaf : 0;
+		out->internal_fill = c.sum.internal ? c.sum.internal_fill / c.sum.internal : 0;
+		out->error = c.error;
+		out->sec = (stat_ns() - start) / 1e9;
+	}
+	free(c.task);
+	free(c.meta);
+	pthread_mutex_destroy(&c.latch);
+	return (int)(c.error > INT_MAX ? INT_MAX : c.error);
+}
 
+void verifyInfo(int table_id, int nthreads) {
+	verify_stat s;
+	printf("\n<verify> table %d, %d thread\n", table_id, nthreads);
+	if (db_verify(table_id, nthreads, &s) == FAIL) {
+		printf("table is not open\n");
+		return;
+	}
+	printf("page : %" PRIu64 " (%.1f MB) in %.2fs\n", s.page_num, (double)s.page_num * PAGESIZE / (1 << 20), s.sec);
+	printf("depth : %d / internal : %" PRIu64 " (fill %.1f%%) / leaf : %" PRIu64 " (fill %.1f%%)\n",
+		s.depth, s.internal, 100 * s.internal_fill, s.leaf, 100 * s.leaf_fill);
+	printf("record : %" PRIu64 " / dead : %" PRIu64 "\n", s.record, s.dead);
+	printf("free : %" PRIu64 " / unused : %" PRIu64 " / leaf chain jump : %" PRIu64 " (%.1f%%)\n",
+		s.free, s.unused, s.leaf_jump, s.leaf > 1 ? 100.0 * s.leaf_jump / (s.leaf - 1) : 0.0);
+	printf("error : %" PRIu64 "\n", s.error);
 }
 
 int showTable()
 {
 	printf("\n=========<Table List>========\n");
 
-	for (int i = 0; i < 10; i++)
+	for (int i = 0; i < b_M.table_total; i++)
 	{
-		printf("%d : pathname = %s , table_id = %d , fd = %d, isopen= = %d\n", i + 1, b_M.table[i].path,
-			b_M.table[i].id, b_M.table[i].fd, b_M.table[i].isopen);
+		printf("%d : pathname = %s , table_id = %d , fd = %d, isopen= = %d\n", i + 1, table_get(i + 1)->path,
+			table_get(i + 1)->id, table_get(i + 1)->fd, table_get(i + 1)->isopen);
 	}
 	printf("=============================\n");
 
@@ -1145,27 +4803,28 @@ void menu() {
 ///////////////
 //INSERT
 
-//⼭  x ---alloc ϸ鼭  Ϸ/Ѱ x
+//여기서는 헤더정보 변경x ---alloc을 하면서 프리페이지 수정완료/총개수는 변함x
 int make_internal_page(int table_id) {
 
 //printf("\nmake internal page1\n");
-	//  
-	///ͳ - numkey, {key, },parent, right_left, isleaf
-	// - Ʈ,,Ѱ
+	//페이지의 변경할 정보
+	//리프/인터널 - numkey, {key, },parent, right_left, isleaf
+	//헤더 - 루트,프리,총개수
 	int newpage = file_alloc_page(table_id);
 //printf("new alloc internal pagenum : %ld\n",b_M.frameArray[newpage].page_num);
 	
-	//ʱȭ 
-	b_M.frameArray[newpage].frame_p.is_leaf = 0;
-	b_M.frameArray[newpage].frame_p.num_key = 0;
+	//값초기화 
+	b_M.frameArray[newpage].frame_p->is_leaf = 0;
+	b_M.frameArray[newpage].frame_p->num_key = 0;
+	b_M.frameArray[newpage].frame_p->layout = table_get(table_id)->node_layout;
 
-	// θ  ȳ
-	b_M.frameArray[newpage].frame_p.parent = 0;
+	//아직 부모가 결정 안남
+	b_M.frameArray[newpage].frame_p->parent = 0;
 
-	//ڱ    x
-	b_M.frameArray[newpage].frame_p.right_left = 0;
+	//자기밑의 제일 왼쪽 페이지도 결정x
+	b_M.frameArray[newpage].frame_p->right_left = 0;
 
-	//Ű+offset  ʿx
+	//키+offset또한 아직 설정할필요x
 	setDirty(newpage);
 	clearPin(newpage);
 	return newpage;
@@ -1174,33 +4833,44 @@ int make_internal_page(int table_id) {
 
 int make_leaf_page(int tableid) {
 //printf("\nmake leaf page1\n");
-	//   
+	//새 페이지 갖고 옴
 	int leaf = make_internal_page(tableid);
 //printf("new alloc leaf pagenum : %ld\n",b_M.frameArray[leaf].page_num);
 
-	// set
-	b_M.frameArray[leaf].frame_p.is_leaf = 1;
+	//리프로 set
+	b_M.frameArray[leaf].frame_p->is_leaf = 1;
+	leaf_init(b_M.frameArray[leaf].frame_p, table_get(tableid)->leaf_layout);
 	setDirty(leaf);
-	clearPin(leaf);
 	return leaf;
 }
 /* Helper function used in insert_into_parent
  * to find the index of the parent's pointer to
  * the node to the left of the key to be inserted.
-  Ű ʿ ִ 忡  θ  ε ã  insert_into_parent Ǵ  .
+ 삽입할 키 왼쪽에 있는 노드에 대한 부모 포인터의 인덱스를 찾기 위해 insert_into_parent에 사용되는 도우미 기능.
  */
 
 int get_left_index(int tableid,pagenum_t p, pagenum_t l) {
 
 	int i;
-	int parent = pageScan(tableid, p);
-	int left = pageScan(tableid, l);
-pthread_mutex_unlock(&b_M.frameArray[parent].page_latch);
-pthread_mutex_unlock(&b_M.frameArray[left].page_latch);
+	int parent = pageScanShared(tableid, p);
+	int left = pageScanShared(tableid, l);
+pageUnlatch(parent);
+pageUnlatch(left);
+
+	//left의 첫 키로 부모에서 자리를 찾고, 자식이 맞지 않으면 처음부터 훑는다
+	if (b_left.num_key > 0) {
+		int64_t first = b_left.is_leaf ? leaf_key(&b_left, 0) : node_key(&b_left, 0);
+		i = node_search(&b_parent, b_parent.num_key, first);
+		if (i >= 0 && node_child(&b_parent, i) == l) {
+			clearPin(parent);
+			clearPin(left);
+			return i;
+		}
+	}
 
 	for (i = 0; i < b_parent.num_key; i++)
 	{
-		if(b_parent.branch[i].child==l){
+		if(node_child(&b_parent, i)==l){
 			clearPin(parent);
 			clearPin(left);
 
@@ -1219,33 +4889,21 @@ pthread_mutex_unlock(&b_M.frameArray[left].page_latch);
 //////////////////////////////////////////
 int insert_into_leaf(int tableid,pagenum_t l, int64_t key, char * val) {
 //printf("\ninsert into leaf -- leaf pagenum : %ld\n",l);
+	//db_update와 reader가 같은 리프를 latch로 보므로 고치는 동안은 X로 잡고 있는다
 	int leaf = pageScan(tableid, l);
-pthread_mutex_unlock(&b_M.frameArray[leaf].page_latch);
 //printf("insert into leaf : leaf = %d\n",leaf);
-	int insertion_point=0;
-	
-	//ġ ã´.
-	while (insertion_point < b_leaf.num_key &&  b_leaf.record[insertion_point].key < key)
-		insertion_point++;
+	//삽입위치를 찾는다.
+	int insertion_point = leaf_search(&b_leaf, b_leaf.num_key, key);
 
 //printf("insert into leaf : lnsert point = %d\n",insertion_point);
-	//ġ ڸ о ش
-	for (int i = b_leaf.num_key; i > insertion_point; i--) {
-		b_leaf.record[i].key = b_leaf.record[i - 1].key;
-		strcpy(b_leaf.record[i].val, b_leaf.record[i - 1].val);
-		
-	}
-
-	//  ġ 
-	b_leaf.record[insertion_point].key = key;
-	strcpy(b_leaf.record[insertion_point].val, val);
-//printf("insert into leaf---before numkey++ : %d\n",b_leaf.num_key);
-	b_leaf.num_key++;
+	//삽입위치 자리를 밀어서 비워주고 삽입
+	leaf_insert(&b_leaf, insertion_point, key, val);
 //printf("insert into leaf---after numkey++ : %d\n",b_leaf.num_key);
 
-	// leaf ٽ writeϰ free
+	//수정된 leaf 다시 write하고 free
 	setDirty(leaf);
 	clearPin(leaf);
+	pageUnlatch(leaf);
 //printf("?...\n");
 	return SUCCESS;
 }
@@ -1254,27 +4912,32 @@ pthread_mutex_unlock(&b_M.frameArray[leaf].page_latch);
 int insert_into_new_root(int tableid ,pagenum_t l, int64_t key, pagenum_t r) {
 	
 //printf("\ninsert into new root\n");
-	//  ޾ƿ´
+	//새 리프페이지를 받아온다
 	int root = make_internal_page(tableid);
+	setPin(root);
 	int head = pageScan(tableid, 0);
 	int right = pageScan(tableid, r);
 	int left = pageScan(tableid, l);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
-pthread_mutex_unlock(&b_M.frameArray[right].page_latch);
-pthread_mutex_unlock(&b_M.frameArray[left].page_latch);
+pageUnlatch(head);
+pageUnlatch(right);
+pageUnlatch(left);
 
 
+	//루트를 다 채운 다음 헤더를 바꾼다
+	pageWriteBegin(root);
+	b_root.parent = 0;//루트 flag
+	b_root.num_key++;
+	b_root.right_left = l ;
+	node_set(&b_root, 0, key, r);
+	pageWriteEnd(root);
+
+	pageWriteBegin(head);
 	b_head.root_page = b_M.frameArray[root].page_num;
+	pageWriteEnd(head);
 //printf("\ninsert into new root 2 -- change rootpage=%ld\n",b_head.root_page);
-	b_root.parent = 0;//Ʈ flag
 	b_right.parent =b_head.root_page;
 	b_left.parent = b_head.root_page;
 	
-	b_root.num_key++;
-	b_root.right_left = l ;
-	b_root.branch[0].key = key;
-	b_root.branch[0].child = r;
-	
 	setDirty(root);
 	setDirty(head);
 	setDirty(right);
@@ -1291,36 +4954,32 @@ pthread_mutex_unlock(&b_M.frameArray[left].page_latch);
 }
 
 
-//ó 
+//처음 삽입
 int start_new_tree(int tableid,int64_t key,char * val) {
 
 //printf("\nstart new tree 1 \n");
 
-	//  ޾ƿ´
+	//새 리프페이지를 받아온다
 	int leaf = make_leaf_page(tableid);
 //printf("leaf : %d\n",leaf);
 	int head = pageScan(tableid, 0);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+pageUnlatch(head);
 //printf("start new tree 2 \n");
-	// 
+	//헤더 설정
+	pageWriteBegin(head);
 	b_head.root_page =b_M.frameArray[leaf].page_num;
+	pageWriteEnd(head);
 
 //printf("start new tree - root : %ld \n",b_head.root_page);
 	//b_head.page_num++;
 
-	// 
+	//리프페이지 설정
 	b_leaf.parent = 0;
-	b_leaf.num_key = 1;
-	b_leaf.record[0].key = key;
-
-	//char *strcpy(char *dest, const char *src);
-	//scr dest 
-	strcpy(b_leaf.record[0].val, val);
+	leaf_insert(&b_leaf, 0, key, val);
 
 	//set and clear
 	setDirty(head);
 	setDirty(leaf);
-	clearPin(leaf);
 	clearPin(head);
 
 
@@ -1329,20 +4988,195 @@ pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
 
 
 
-int db_insert(int tableid,int64_t key, char * value) {
-	//printf("db insert 1.....\n");
-	// ޾ƿ´.
-	if(b_M.table[tableid-1].isopen==0) {
-		printf("File Is Closed\n");
-		return FAIL;
+//bulk load 진행 상태
+#define BULK_LEVEL 16
+#define BULK_BATCH 64
+typedef struct bulk_ctx {
+	int fd;
+	int layout;//인터널 형식
+	int levels;//루트 레벨, 0이면 루트가 리프
+	int64_t cnt[BULK_LEVEL];//레벨별 페이지 수
+	int64_t items[BULK_LEVEL];//레벨별로 나눠 담을 레코드/자식 수
+	pagenum_t base[BULK_LEVEL];//레벨별 첫 page_num
+	int64_t done[BULK_LEVEL];//다 채운 페이지 수
+	int filled[BULK_LEVEL];//지금 페이지에 담은 수
+	int64_t first_key[BULK_LEVEL];//지금 페이지의 첫 키
+	page_t * cur[BULK_LEVEL];//인터널 레벨의 지금 페이지
+
+	page_t * batch;//연속으로 쓸 리프들
+	int batch_num;
+	pagenum_t batch_start;
+}bulk_ctx;
+
+//items개를 cnt개 페이지에 고르게 나눴을때 p번 페이지에 들어가는 개수
+static int64_t bulk_size(int64_t items, int64_t cnt, int64_t p)
+{
+	return (p + 1) * items / cnt - p * items / cnt;
+}
+
+//자식 j가 들어가는 부모 인덱스, bulk_size와 같은 분배
+static int64_t bulk_parent(int64_t j, int64_t child_cnt, int64_t parent_cnt)
+{
+	return ((j + 1) * parent_cnt - 1) / child_cnt;
+}
+
+static int bulk_flush_leaves(bulk_ctx * c)
+{
+	if (c->batch_num == 0) return SUCCESS;
+	page_t * run[BULK_BATCH];
+	for (int i = 0; i < c->batch_num; i++) run[i] = &c->batch[i];
+	int ret = file_write_pages(c->fd, c->batch_start, run, c->batch_num);
+	c->batch_start += c->batch_num;
+	c->batch_num = 0;
+	return ret;
+}
+
+//l 레벨의 지금 페이지에 자식을 붙이고, 다 차면 쓰고 위로 올린다
+static int bulk_add_child(bulk_ctx * c, int l, int64_t key, pagenum_t child)
+{
+	page_t * pg = c->cur[l];
+
+	if (c->filled[l] == 0) {
+		memset(pg, 0, sizeof(page_t));
+		pg->layout = c->layout;
+		pg->right_left = child;//맨왼쪽 자식
+		c->first_key[l] = key;
+	}
+	else {
+		node_set(pg, c->filled[l] - 1, key, child);
+	}
+	pg->num_key = c->filled[l];
+	c->filled[l]++;
+
+	int64_t p = c->done[l];
+	if (c->filled[l] < bulk_size(c->items[l], c->cnt[l], p)) return SUCCESS;
+
+	//다 찼으므로 쓰고 부모에 올린다
+	pg->is_leaf = 0;
+	pg->parent = (l < c->levels) ? c->base[l + 1] + bulk_parent(p, c->cnt[l], c->cnt[l + 1]) : 0;
+	if (file_write_pages(c->fd, c->base[l] + p, &pg, 1) != SUCCESS) return FAIL;
+	c->done[l]++;
+	c->filled[l] = 0;
+
+	if (l < c->levels) return bulk_add_child(c, l + 1, c->first_key[l], c->base[l] + p);
+	return SUCCESS;
+}
+
+//정렬된 레코드 n개로 빈 테이블을 아래에서부터 한번에 만든다
+//리프는 fill(%)만큼, 인터널도 같은 비율로 고르게 나눠 채우고
+//헤더의 page_num 뒤에 리프 -> 인터널 순으로 이어서 쓴다 (리프끼리 연속이라 db_scan readahead도 그대로 먹힌다)
+//다른 스레드가 이 테이블을 쓰지 않을때만 호출, 키가 정렬되지 않았거나 개수가 모자라면 FAIL
+int db_bulk_load(int table_id, int64_t n, bulk_next next, int fill)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	if (table_get(table_id)->map || n <= 0) return FAIL;
+
+	int head = pageScanShared(table_id, 0);
+	pagenum_t root_now = b_head.root_page;
+	pagenum_t page_now = b_head.page_num;
+	clearPin(head);
+	pageUnlatch(head);
+	//빈 테이블만
+	if (root_now != 0) return FAIL;
+
+	if (fill <= 0 || fill > 100) fill = 100;
+	//LEAF_SLOT은 값 길이를 미리 모르므로 가장 긴 값 기준으로 나눈다
+	int leaf_layout = table_get(table_id)->leaf_layout;
+	int leaf_cap = (leaf_layout == LEAF_SLOT) ? leaf_body / ((int)sizeof(leaf_slot) + val_max) : leaf_order;
+	int leaf_fill = leaf_cap * fill / 100;
+	int layout = table_get(table_id)->node_layout;
+	int fanout = node_cap(layout) * fill / 100 + 1;
+	if (leaf_fill < 1) leaf_fill = 1;
+	if (fanout < 2) fanout = 2;
+
+	bulk_ctx c;
+	memset(&c, 0, sizeof(c));
+	c.fd = table_get(table_id)->fd;
+	c.layout = layout;
+
+	//레벨별 페이지 수와 위치를 먼저 정한다
+	c.items[0] = n;
+	c.cnt[0] = (n + leaf_fill - 1) / leaf_fill;
+	c.base[0] = page_now;
+	while (c.cnt[c.levels] > 1) {
+		if (c.levels + 1 >= BULK_LEVEL) return FAIL;
+		c.items[c.levels + 1] = c.cnt[c.levels];
+		c.cnt[c.levels + 1] = (c.cnt[c.levels] + fanout - 1) / fanout;
+		c.base[c.levels + 1] = c.base[c.levels] + c.cnt[c.levels];
+		c.levels++;
+	}
+	pagenum_t total = c.base[c.levels] + c.cnt[c.levels] - page_now;
+
+	for (int l = 1; l <= c.levels; l++) c.cur[l] = (page_t*)malloc(sizeof(page_t));
+	c.batch = (page_t*)malloc(sizeof(page_t) * BULK_BATCH);
+	c.batch_start = c.base[0];
+
+	int ret = SUCCESS;
+	int64_t leaf_p = 0;
+	page_t * leaf = NULL;
+	key_val rec;
+	int64_t last_key = 0;
+
+	for (int64_t i = 0; i < n && ret == SUCCESS; i++)
+	{
+		if (!next(&rec) || (i > 0 && rec.key <= last_key)) {
+			ret = FAIL;
+			break;
+		}
+		last_key = rec.key;
+
+		if (c.filled[0] == 0) {
+			if (c.batch_num == BULK_BATCH) ret = bulk_flush_leaves(&c);
+			leaf = &c.batch[c.batch_num];
+			memset(leaf, 0, sizeof(page_t));
+			leaf->is_leaf = 1;
+			leaf_init(leaf, leaf_layout);
+			c.first_key[0] = rec.key;
+		}
+		leaf_insert(leaf, c.filled[0]++, rec.key, rec.val);
+
+		if (c.filled[0] < bulk_size(c.items[0], c.cnt[0], leaf_p)) continue;
+
+		//리프 하나 완성 - 오른쪽 형제와 부모는 미리 정해둔 위치
+		leaf->right_left = (leaf_p + 1 < c.cnt[0]) ? c.base[0] + leaf_p + 1 : 0;
+		leaf->parent = (c.levels > 0) ? c.base[1] + bulk_parent(leaf_p, c.cnt[0], c.cnt[1]) : 0;
+		c.batch_num++;
+		c.filled[0] = 0;
+		if (c.levels > 0 && ret == SUCCESS)
+			ret = bulk_add_child(&c, 1, c.first_key[0], c.base[0] + leaf_p);
+		leaf_p++;
 	}
+	if (ret == SUCCESS) ret = bulk_flush_leaves(&c);
+	if (ret == SUCCESS && fdatasync(c.fd) != 0) ret = FAIL;
+
+	for (int l = 1; l <= c.levels; l++) free(c.cur[l]);
+	free(c.batch);
+	//실패하면 헤더를 건드리지 않으므로 뒤에 쓴 페이지는 나중에 alloc될때 덮어써진다
+	if (ret != SUCCESS) return FAIL;
+
+	head = pageScan(table_id, 0);
+	pageWriteBegin(head);
+	b_head.root_page = c.base[c.levels];
+	b_head.page_num = page_now + total;
+	pageWriteEnd(head);
+	setDirty(head);
+	clearPin(head);
+	pageUnlatch(head);
+
+	return SUCCESS;
+}
+
+//db_insert의 본체, smo_latch를 잡은 상태로 부른다
+static int insert_record(int tableid,int64_t key, char * value) {
+	//printf("db insert 1.....\n");
+	//헤더를 받아온다.
 //printf("\ndb_insert - 1\n");
 	int head = pageScan(tableid, 0);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+pageUnlatch(head);
 //printf("db_insert - head find success\n");
-	//ã  -- ̹ ִ 
+	//찾은 경우 -- 이미 있는 경우
 //find case--- duplicate
-char * str =(char *)malloc(120);
+char str[val_max];
 	if (!db_find_2(tableid,key, str)) {
 //printf("db_insert - duplicate\n");
 		clearPin(head);
@@ -1351,8 +5185,8 @@ char * str =(char *)malloc(120);
 		return FAIL;
 	}
 
-	//ã --   
-	//Ʈ ȸ ִ°(ù  )
+	//못찾은경우 -- 넣을 수 있음
+	//트리가 안만들어져 있는경우(첫 삽입인 경우)
 	if (b_head.root_page == 0) {
 //printf("db_insert - start new tree\n");
 		clearPin(head);
@@ -1360,134 +5194,591 @@ char * str =(char *)malloc(120);
 		return start_new_tree(tableid,key, value);
 	}
 
-	//Ʈ ִ 
-	//Ű   оδ
+	//트리가 만들어져있는 경우
+	//키가 들어갈 리프페이지 읽어들인다
 	int leaf = find_page_2(tableid,key);
 	
 	pagenum_t l = b_M.frameArray[leaf].page_num;
 //printf("db_insert - leaf find success\n");
 	//printf("db insert here -- leaf num = %ld\n",leaf);
 
-	//   ڸ ִ 
-	if (b_leaf.num_key < leaf_order) {
+	//db_delete가 지운 표시만 해둔 같은 키가 있으면 그 자리를 다시 살린다
+	int i = leaf_search(&b_leaf, b_leaf.num_key, key);
+	if (i < b_leaf.num_key && leaf_key(&b_leaf, i) == key) {
+		leaf = pageScan(tableid, l);
+		i = leaf_search(&b_leaf, b_leaf.num_key, key);
+		int revive = leaf_update(&b_leaf, i, value) == SUCCESS;
+		if (revive) {
+			leaf_dead_set(&b_leaf, i, 0);
+			b_leaf.dead_num--;
+		}
+		//LEAF_SLOT에서 값이 커져 자리가 없으면 빼고 새로 넣는다
+		else leaf_remove(&b_leaf, i);
+		setDirty(leaf);
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		if (revive) {
+			clearPin(head);
+			return SUCCESS;
+		}
+	}
+
+	//꽉 찬 리프에 지운 표시가 있으면 쪼개기 전에 먼저 비운다
+	if (!leaf_fits(&b_leaf, value) && b_leaf.dead_num > 0) {
+		leaf = pageScan(tableid, l);
+		leaf_purge(&b_leaf);
+		setDirty(leaf);
+		clearPin(leaf);
+		pageUnlatch(leaf);
+	}
+
+	//리프 페이지에 남은 자리가 있는 경우
+	if (leaf_fits(&b_leaf, value)) {
 //printf("db_insert - insert into leaf\n");
 //printf("num key = %d and leaf order = %d\n",b_leaf.num_key,leaf_order);
 clearPin(head);
-		clearPin(leaf);
 //printf("into leaf before\n");
 		insert_into_leaf(tableid,l, key, value);
 //printf("leaf after\n");
 		return SUCCESS;
 	}
 
-	// ڸ ٸ ɰ
+	//남은 자리가 없다면 쪼개야함
 //printf("db_insert - insert into after splitting\n");
 clearPin(head);
 
-	clearPin(leaf);
 //printf("before enter\n");
+	//레코드가 새 리프로 옮겨가므로 merge처럼 reader가 다시 내려오게 한다
+	smo_write_begin(tableid);
 	insert_into_leaf_after_splitting(tableid,l, key, value);
+	smo_write_end(tableid);
 //printf("after enter\n");
 	
 	return SUCCESS;
 
-	// Ű ̹ ִ ȮѴ.
-	//ٸ  ڵ带 Ѵ
-	// Ʈ嵵 ٸ  Ű Ʈ  ش
-	// Ű   ´
-	//insert into leaf
-	// leaf after splitȣ
+	//그 키가 이미 있는지 확인한다.
+	//없다면 새 레코드를 생성한다
+	//만약 루트노드도 없다면 그 키로 루트를 새로 만들어준다
+	//그 키가 들어갈 페이지를 가져온다
+	//insert into leaf시전
+	//리턴으로 leaf after split호출
+
+}
+
+//트리 모양을 바꾸는 insert/delete/merge는 테이블마다 하나씩 돈다
+//인덱스는 건드리지 않는다 (recovery와 인덱스 엔트리가 쓴다)
+int db_insert_base(int tableid, int64_t key, char * value) {
+	if(!table_isopen(tableid)) {
+		printf("File Is Closed\n");
+		return FAIL;
+	}
+	//mmap 테이블은 read only
+	Table * tb = table_get(tableid);
+	if (tb->map) return FAIL;
+
+	pthread_mutex_lock(&tb->smo_latch);
+	int ret = insert_record(tableid, key, value);
+	pthread_mutex_unlock(&tb->smo_latch);
+	return ret;
+}
+
+//레코드를 넣고 인덱스 엔트리도 넣는다
+int db_insert(int tableid,int64_t key, char * value) {
+	if (!table_isopen(tableid)) return db_insert_base(tableid, key, value);
+	Table * tb = table_get(tableid);
+	if (!index_key_ok(tb, key)) return FAIL;
+	int ret = db_insert_base(tableid, key, value);
+	if (ret == SUCCESS)
+		for (int j = 0; j < tb->index_num; j++)
+			db_insert_base(tb->index_table[j], index_entry(value, tb->index_len[j], key), index_val);
+	return ret;
+}
+
+//key 레코드가 있는 리프를 X로 잡아 프레임을 돌려주고 *i에 자리를 넣는다 (지운 표시가 있어도 찾는다), 없으면 FAIL
+//page_num부터 보고, split이나 merge로 옮겨갔으면 루트부터 다시 내려간다
+int leaf_locate(int table_id, pagenum_t page_num, int64_t key, int * i)
+{
+	uint64_t smo;
+	pagenum_t pn = page_num;
+	int f;
+	if (pn != 0) {
+		f = pageScan(table_id, pn);
+		page_t * pg = b_M.frameArray[f].frame_p;
+		*i = leaf_search(pg, pg->num_key, key);
+		if (pg->is_leaf && *i < pg->num_key && leaf_key(pg, *i) == key) return f;
+		clearPin(f);
+		pageUnlatch(f);
+	}
+
+	while (1) {
+		smo = smo_read_begin(table_id);
+		if (find_leaf_olc(table_id, key, 0, 0, &pn) != SUCCESS) return FAIL;
+		f = pageScan(table_id, pn);
+		if (smo_read_validate(table_id, smo)) break;
+		clearPin(f);
+		pageUnlatch(f);
+	}
+	page_t * pg = b_M.frameArray[f].frame_p;
+	*i = leaf_search(pg, pg->num_key, key);
+	if (*i < pg->num_key && leaf_key(pg, *i) == key) return f;
+	clearPin(f);
+	pageUnlatch(f);
+	return FAIL;
+}
+
+//key 바로 다음의 살아있는 키, 없으면 LOCK_SUPREMUM
+static int64_t next_key(int table_id, int64_t key)
+{
+	uint64_t smo;
+	pagenum_t pn;
+restart:
+	smo = smo_read_begin(table_id);
+	if (find_leaf_olc(table_id, key, 0, 0, &pn) != SUCCESS) return LOCK_SUPREMUM;
+	while (pn != 0) {
+		int leaf = pageScanShared(table_id, pn);
+		if (!smo_read_validate(table_id, smo)) {
+			clearPin(leaf);
+			pageUnlatch(leaf);
+			goto restart;
+		}
+		for (int i = leaf_search(&b_leaf, b_leaf.num_key, key); i < b_leaf.num_key; i++) {
+			int64_t k = leaf_key(&b_leaf, i);
+			if (k > key && !leaf_dead(&b_leaf, i)) {
+				clearPin(leaf);
+				pageUnlatch(leaf);
+				return k;
+			}
+		}
+		pn = b_leaf.right_left;
+		clearPin(leaf);
+		pageUnlatch(leaf);
+	}
+	return LOCK_SUPREMUM;
+}
+
+//trx로 레코드를 넣는다, 이미 있으면 FAIL / lock 실패시 ABORT
+//넣는 키와 바로 다음 키(없으면 LOCK_SUPREMUM)에 X lock을 commit까지 잡는다 (next-key locking)
+//그 사이를 훑은 scan은 다음 키에 S lock을 남기므로, 그 trx가 끝날때까지 phantom이 못 들어온다
+//로그는 키와 값만 남기는 logical insert라 abort하면 지운 표시로 되돌리고,
+//split은 smo_latch 안에서 trx와 상관없이 끝나는 system action이라 되돌리지 않는다
+int db_insert_trx(int table_id, int64_t key, char * value, int trx_id)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	Table * tb = table_get(table_id);
+	Trx * t = trx_get(trx_id);
+	if (!t || t->snap >= 0 || tb->map || !index_key_ok(tb, key)) return FAIL;
+
+	//lock은 smo_latch 밖에서 (기다리다 abort되면 undo가 smo_latch를 잡는다)
+	lock_t * tmp_l;
+	while (1) {
+		int64_t next = next_key(table_id, key);
+		if (lock_acquire(table_id, next, trx_id, 1) == NULL) return ABORT;
+		tmp_l = lock_acquire(table_id, key, trx_id, 1);
+		if (tmp_l == NULL) return ABORT;
+		//기다리는 사이 그 틈에 다른 키가 들어왔으면 새 다음 키로 다시
+		if (next_key(table_id, key) == next) break;
+	}
+
+	pthread_mutex_lock(&tb->smo_latch);
+	char str[val_max];
+	int dup = db_find_2(table_id, key, str) == SUCCESS;
+	if (dup) {
+		pthread_mutex_unlock(&tb->smo_latch);
+		return FAIL;
+	}
+
+	//smo_latch 안이라 키가 들어갈 리프는 그대로다
+	//checkpoint가 빠뜨리지 않게 그 리프를 잡은 채로 로그 자리를 잡고 rec_LSN을 남긴다
+	pagenum_t pn = 0;
+	int64_t LSN;
+	if (find_leaf_olc(table_id, key, 0, 0, &pn) == SUCCESS) {
+		int leaf = pageScan(table_id, pn);
+		LSN = log_insert(trx_id, table_id, pn, key, value);
+		b_leaf.page_LSN = LSN;
+		setDirtyLSN(leaf, LSN);
+		clearPin(leaf);
+		pageUnlatch(leaf);
+	}
+	else LSN = log_insert(trx_id, table_id, 0, key, value);
+
+	//레코드가 보이기 전에 없던 레코드라는 version을 남겨 snapshot trx가 읽지 않게 한다
+	mvcc_push(table_id, key, NULL, trx_id);
+	tmp_l->change = 1;
+	insert_record(table_id, key, value);
+
+	//그 사이 flush로 rec_LSN이 지워졌을 수 있으니 레코드가 들어간 리프에 다시 남긴다
+	int i;
+	int leaf = leaf_locate(table_id, pn, key, &i);
+	if (leaf >= 0) {
+		if (b_leaf.page_LSN < LSN) b_leaf.page_LSN = LSN;
+		setDirtyLSN(leaf, LSN);
+		clearPin(leaf);
+		pageUnlatch(leaf);
+	}
+	pthread_mutex_unlock(&tb->smo_latch);
+
+	//인덱스 엔트리도 같은 trx로 넣어 lock, 로그, abort를 레코드와 같이 따른다
+	for (int j = 0; j < tb->index_num; j++)
+		if (db_insert_trx(tb->index_table[j], index_entry(value, tb->index_len[j], key), index_val, trx_id) == ABORT) return ABORT;
+	return SUCCESS;
+}
+
+//merger에게 리프를 넘긴다, queue가 꽉 찼으면 버린다 (다음 delete가 다시 넘긴다)
+static void merge_push(int table_id, int gen, pagenum_t page_num)
+{
+	pthread_mutex_lock(&b_M.merge_latch);
+	if (b_M.merger_run && b_M.merge_num < MERGE_QUEUE) {
+		merge_ent * e = &b_M.merge_q[(b_M.merge_head + b_M.merge_num) % MERGE_QUEUE];
+		e->table_id = table_id;
+		e->gen = gen;
+		e->page_num = page_num;
+		b_M.merge_num++;
+		pthread_cond_signal(&b_M.merge_cond);
+	}
+	pthread_mutex_unlock(&b_M.merge_latch);
+}
+
+//key의 레코드를 지운다, 없으면 FAIL
+//리프에는 지운 표시만 하고 (record는 그 자리에 둔다), 덜 찬 리프는 merger가 나중에 옆 리프와 합친다
+//인덱스는 건드리지 않는다
+int db_delete_base(int table_id, int64_t key)
+{
+	if (!table_isopen(table_id)) return FAIL;
+	Table * tb = table_get(table_id);
+	if (tb->map) return FAIL;
+	int fill = b_opt.merge_fill > 0 ? b_opt.merge_fill : MERGE_FILL;
+
+	pthread_mutex_lock(&tb->smo_latch);
+	pagenum_t pn;
+	if (find_leaf_olc(table_id, key, 0, 0, &pn) != SUCCESS) {
+		pthread_mutex_unlock(&tb->smo_latch);
+		return FAIL;
+	}
+
+	int leaf = pageScan(table_id, pn);
+	int i = leaf_find(&b_leaf, key);
+	int ret = FAIL, under = 0;
+	if (i < b_leaf.num_key) {
+		leaf_dead_set(&b_leaf, i, 1);
+		b_leaf.dead_num++;
+		setDirty(leaf);
+		under = b_leaf.parent != 0 && leaf_used(&b_leaf, 1) * 100 < leaf_cap(&b_leaf) * fill;
+		ret = SUCCESS;
+	}
+	clearPin(leaf);
+	pageUnlatch(leaf);
+	pthread_mutex_unlock(&tb->smo_latch);
+
+	if (under) merge_push(table_id, tb->gen, pn);
+	return ret;
+}
+
+//레코드와 그 인덱스 엔트리를 지운다
+int db_delete(int table_id, int64_t key)
+{
+	if (!table_isopen(table_id) || table_get(table_id)->index_num == 0) return db_delete_base(table_id, key);
+	Table * tb = table_get(table_id);
+	char val[val_max];
+	if (db_find_2(table_id, key, val) != SUCCESS) return FAIL;
+	int ret = db_delete_base(table_id, key);
+	if (ret == SUCCESS)
+		for (int j = 0; j < tb->index_num; j++)
+			db_delete_base(tb->index_table[j], index_entry(val, tb->index_len[j], key));
+	return ret;
+}
+
+//인터널에서 j번째 키와 그 오른쪽 자식을 뺀다
+static void node_remove(page_t * pg, int j)
+{
+	for (int i = j; i < pg->num_key - 1; i++)
+		node_set(pg, i, node_key(pg, i + 1), node_child(pg, i + 1));
+	pg->num_key--;
+}
+
+//merger가 없앤 페이지, 예전 부모가 가리키던걸 따라와도 리프로 보이지 않게 비워두고 free list에 넣는다
+static void merge_free(int table_id, pagenum_t page_num)
+{
+	int f = pageScan(table_id, page_num);
+	pageWriteBegin(f);
+	b_M.frameArray[f].frame_p->is_leaf = 0;
+	b_M.frameArray[f].frame_p->num_key = 0;
+	pageWriteEnd(f);
+	setDirty(f);
+	clearPin(f);
+	pageUnlatch(f);
+	file_free_page(table_id, page_num);
+}
+
+//page_num 리프를 같은 부모 아래 옆 리프와 합치고, 둘이 한 리프에 안 들어가면 레코드를 나눠 가진다
+//lock이 잡힌 레코드는 undo가 page_num과 자리로 되돌리므로 그런 레코드가 있는 리프는 건드리지 않는다
+//인터널은 부모에서 키 하나를 빼는 것까지만 하고, 루트가 자식 하나만 남으면 그 자식을 루트로 올린다
+static void merge_leaf(int table_id, int gen, pagenum_t page_num)
+{
+	if (!table_isopen(table_id)) return;
+	Table * tb = table_get(table_id);
+	int fill = b_opt.merge_fill > 0 ? b_opt.merge_fill : MERGE_FILL;
+
+	pthread_mutex_lock(&tb->smo_latch);
+	if (!tb->isopen || tb->gen != gen || tb->map || lock_table_busy(table_id)) {
+		pthread_mutex_unlock(&tb->smo_latch);
+		return;
+	}
+
+	//queue에서 기다리는 사이 다시 찼거나 없어진 리프는 건너뛴다
+	int leaf = pageScan(table_id, page_num);
+	if (!b_leaf.is_leaf || b_leaf.parent == 0 || leaf_used(&b_leaf, 1) * 100 >= leaf_cap(&b_leaf) * fill) {
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		pthread_mutex_unlock(&tb->smo_latch);
+		return;
+	}
+
+	//부모에서 자리를 찾고 오른쪽 옆 리프를, 맨 오른쪽이면 왼쪽 옆 리프를 고른다
+	pagenum_t parent_num = b_leaf.parent;
+	int par = pageScan(table_id, parent_num);
+	page_t * pp = b_M.frameArray[par].frame_p;
+	int idx = -2;
+	if (!pp->is_leaf) {
+		for (int c = -1; c < pp->num_key; c++)
+			if (node_child(pp, c) == page_num) {
+				idx = c;
+				break;
+			}
+	}
+	pagenum_t sib_num = 0;
+	int j = 0, left_is_leaf = 1;
+	if (idx > -2 && idx < pp->num_key - 1) {
+		sib_num = node_child(pp, idx + 1);
+		j = idx + 1;
+	}
+	else if (idx > -2 && pp->num_key > 0) {
+		sib_num = node_child(pp, idx - 1);
+		j = idx;
+		left_is_leaf = 0;
+	}
+
+	int sib = -1;
+	if (sib_num != 0) sib = pageScan(table_id, sib_num);
+	int l = left_is_leaf ? leaf : sib;
+	int r = left_is_leaf ? sib : leaf;
+	page_t * lp = (l >= 0) ? b_M.frameArray[l].frame_p : NULL;
+	page_t * rp = (r >= 0) ? b_M.frameArray[r].frame_p : NULL;
+	pagenum_t right_num = left_is_leaf ? sib_num : page_num;
+
+	int ok = sib >= 0 && b_M.frameArray[sib].frame_p->is_leaf && b_M.frameArray[sib].frame_p->parent == parent_num
+		&& lp->right_left == right_num && lp->leaf_layout == rp->leaf_layout;
+	for (int i = 0; ok && i < lp->num_key; i++)
+		if (lock_busy(table_id, leaf_key(lp, i))) ok = 0;
+	for (int i = 0; ok && i < rp->num_key; i++)
+		if (lock_busy(table_id, leaf_key(rp, i))) ok = 0;
+
+	if (!ok) {
+		if (sib >= 0) {
+			clearPin(sib);
+			pageUnlatch(sib);
+		}
+		clearPin(par);
+		pageUnlatch(par);
+		clearPin(leaf);
+		pageUnlatch(leaf);
+		pthread_mutex_unlock(&tb->smo_latch);
+		return;
+	}
+
+	//여기서부터 smo_seq가 홀수, latch 없이 내려오던 reader는 끝날때까지 기다렸다가 다시 내려온다
+	smo_write_begin(table_id);
+
+	leaf_purge(lp);
+	leaf_purge(rp);
+	//레코드가 오가므로 두 리프 모두 더 큰 page_LSN을 가진다
+	if (lp->page_LSN < rp->page_LSN) lp->page_LSN = rp->page_LSN;
+	rp->page_LSN = lp->page_LSN;
+	int lu = leaf_used(lp, 0), ru = leaf_used(rp, 0);
+	pagenum_t free_leaf = 0, free_root = 0;
+
+	if (lu + ru <= leaf_cap(lp)) {
+		//오른쪽 리프를 왼쪽 뒤에 붙이고 부모에서 뺀다
+		for (int i = 0; i < rp->num_key; i++) {
+			leaf_insert(lp, lp->num_key, leaf_key(rp, i), leaf_val(rp, i));
+			if (b_M.ahi) ahi_drop(table_id, leaf_key(rp, i));
+		}
+		lp->right_left = rp->right_left;
+		pageWriteBegin(par);
+		node_remove(pp, j);
+		pageWriteEnd(par);
+		free_leaf = right_num;
+		b_M.merge_done++;
+
+		//루트에 자식 하나만 남으면 그 리프가 루트
+		if (pp->parent == 0 && pp->num_key == 0) {
+			int head = pageScan(table_id, 0);
+			pageWriteBegin(head);
+			b_head.root_page = pp->right_left;
+			pageWriteEnd(head);
+			setDirty(head);
+			clearPin(head);
+			pageUnlatch(head);
+			lp->parent = 0;
+			free_root = parent_num;
+		}
+	}
+	else {
+		//덜 찬 쪽으로 레코드를 옮겨 비슷하게 나눠 가진다
+		int moved = 0;
+		if (lu < ru) {
+			while (rp->num_key > 1 && lu + leaf_rec_size(rp, 0) <= ru - leaf_rec_size(rp, 0)) {
+				int sz = leaf_rec_size(rp, 0);
+				leaf_insert(lp, lp->num_key, leaf_key(rp, 0), leaf_val(rp, 0));
+				if (b_M.ahi) ahi_drop(table_id, leaf_key(rp, 0));
+				leaf_remove(rp, 0);
+				lu += sz;
+				ru -= sz;
+				moved = 1;
+			}
+		}
+		else {
+			while (lp->num_key > 1 && ru + leaf_rec_size(lp, lp->num_key - 1) <= lu - leaf_rec_size(lp, lp->num_key - 1)) {
+				int sz = leaf_rec_size(lp, lp->num_key - 1);
+				leaf_insert(rp, 0, leaf_key(lp, lp->num_key - 1), leaf_val(lp, lp->num_key - 1));
+				if (b_M.ahi) ahi_drop(table_id, leaf_key(lp, lp->num_key - 1));
+				leaf_remove(lp, lp->num_key - 1);
+				lu -= sz;
+				ru += sz;
+				moved = 1;
+			}
+		}
+		if (moved) {
+			pageWriteBegin(par);
+			node_set(pp, j, leaf_key(rp, 0), right_num);
+			pageWriteEnd(par);
+			b_M.merge_moved++;
+		}
+	}
+
+	setDirty(leaf);
+	setDirty(sib);
+	setDirty(par);
+	clearPin(sib);
+	pageUnlatch(sib);
+	clearPin(par);
+	pageUnlatch(par);
+	clearPin(leaf);
+	pageUnlatch(leaf);
+
+	if (free_leaf) merge_free(table_id, free_leaf);
+	if (free_root) merge_free(table_id, free_root);
 
+	smo_write_end(table_id);
+	pthread_mutex_unlock(&tb->smo_latch);
+}
+
+//background merger, db_delete가 넘긴 리프를 차례로 합친다
+void * merger_func(void * arg)
+{
+	pthread_mutex_lock(&b_M.merge_latch);
+	while (b_M.merger_run) {
+		if (b_M.merge_num == 0) {
+			pthread_cond_wait(&b_M.merge_cond, &b_M.merge_latch);
+			continue;
+		}
+		merge_ent e = b_M.merge_q[b_M.merge_head];
+		b_M.merge_head = (b_M.merge_head + 1) % MERGE_QUEUE;
+		b_M.merge_num--;
+		pthread_mutex_unlock(&b_M.merge_latch);
+
+		merge_leaf(e.table_id, e.gen, e.page_num);
+
+		pthread_mutex_lock(&b_M.merge_latch);
+	}
+	pthread_mutex_unlock(&b_M.merge_latch);
+	return NULL;
 }
 
 
 
 int insert_into_leaf_after_splitting(int tableid,pagenum_t l, int64_t key, char * val) {
 //printf("\ninsert into leaf after splitting 1\n");
-	// ִ  ֱ
-	int leaf = pageScan(tableid, l);
-	int insertion_index, split, new_key, i, j;
+	int insertion_index, split, i, j;
+	int64_t new_key;
 
-	//ӽð 
-	key_val* tmp_record = (key_val *)malloc(33*sizeof(struct record));
+	//임시공간 마련
+	key_val* tmp_record = (key_val *)malloc((slot_max + 1)*sizeof(struct record));
 
-	//ɰ ־   ֱ
+	//쪼개서 넣어줄 새 리프 만들어주기
+	//할당은 헤더를 잡으므로, 원래 리프를 X로 잡기 전에 해서 그 리프를 기다리는 reader와 엇갈리지 않게 한다
 	int new_p = make_leaf_page(tableid);
+	setPin(new_p);
 	pagenum_t n_p = b_M.frameArray[new_p].page_num;
-//printf("insert into leaf after splitting 2 --- leaf pagenum = %ld\n",n_p);
-	//tmpŰͿ ͸ Ű ͸ д ?  ---
-	//״ϱ 3  ִµ ϳ ° 4¥ Ҽִ temp 
-	//װ splitؼ ΰ ɰ ־شٴ 
 
-pthread_mutex_unlock(&b_M.frameArray[leaf].page_latch);
-pthread_mutex_unlock(&b_M.frameArray[new_p].page_latch);
+	//원래 있던 리프 만들어주기
+	int leaf = pageScan(tableid, l);
+//printf("insert into leaf after splitting 2 --- leaf pagenum = %ld\n",n_p);
+	//tmp키포인터와 포인터를 가리키는 포인터를 만들어둔다 ? 왜 ---
+	//그니까 원래3개만 들어갈수 있는데 하나가 더들어온경우 4개짜리를 보관할수있는 temp를 만들고
+	//그걸 split해서 두개로 쪼개서 넣어준다는 말씀
+	//원래 리프는 레코드를 옮기는 동안 X로 잡고 있는다 (db_update가 그 사이에 고친 값을 잃지 않게)
 
-	//ġ ã
-	insertion_index = 0;
-	while (insertion_index < leaf_order && b_leaf.record[insertion_index].key < key)
-		insertion_index++;
+	//삽입위치 찾기
+	insertion_index = leaf_search(&b_leaf, b_leaf.num_key, key);
 
 //printf("insert into leaf after splitting 3 -- insert index = %d\n",insertion_index);
-	//ġΰ ϳ leat  ؼ ͼ  
+	//삽입위치인경우 하나띄워서 leat의 값을 복사해서 가져와서 저장 
+	int n = b_leaf.num_key + 1;
 	for (i = 0, j = 0; i < b_leaf.num_key; i++, j++) {
 		if (j == insertion_index) j++;
-		tmp_record[j].key = b_leaf.record[i].key;
-		strcpy(tmp_record[j].val, b_leaf.record[i].val);
+		tmp_record[j].key = leaf_key(&b_leaf, i);
+		strcpy(tmp_record[j].val, leaf_val(&b_leaf, i));
 	}
-	// ġ ־ֱ
+	//빈 삽입위치에 넣어주기
 	tmp_record[insertion_index].key = key;
 	strcpy(tmp_record[insertion_index].val, val);
 
-
-	//   ٽ äش
-	b_leaf. num_key= 0;
-
-	// ϱ
-	split = cut(leaf_order);
-//printf("insert into leaf after splitting 4 -- split=%d\n",split);
-	//  ɰκ  ־ֱ
-	for (i = 0; i < split; i++) {
-		strcpy(b_leaf.record[i].val , tmp_record[i].val);
-		b_leaf.record[i].key = tmp_record[i].key;
-		b_leaf.num_key++;
-	}
-	//  ɰκ  κ ־ֱ
-	for (i = split, j = 0; i <= leaf_order; i++, j++) {
-		strcpy(b_M.frameArray[new_p].frame_p.record[j].val , tmp_record[i].val);
-		b_new.record[j].key = tmp_record[i].key;
-		b_new.num_key++;
+	//분할지점 정하기, LEAF_SLOT은 slot+값 바이트가 반씩 되도록
+	if (b_leaf.leaf_layout == LEAF_SLOT) {
+		int total = 0, half = 0;
+		for (i = 0; i < n; i++) total += sizeof(leaf_slot) + leaf_len(tmp_record[i].val);
+		for (split = 0; split < n - 1 && half * 2 < total; split++)
+			half += sizeof(leaf_slot) + leaf_len(tmp_record[split].val);
+		if (split == 0) split = 1;
 	}
+	else split = cut(leaf_order);
+//printf("insert into leaf after splitting 4 -- split=%d\n",split);
 
-	//tmp free
-	
-
-	//   ش     Ű ִ
-	// κ θ ų ֵ   ص־
+	//원래 리프를 비우고 쪼갠부분의 앞쪽을, 새 리프에 나머지 부분을 넣어주기
+	leaf_init(&b_leaf, b_leaf.leaf_layout);
+	for (i = 0; i < split; i++)
+		leaf_insert(&b_leaf, i, tmp_record[i].key, tmp_record[i].val);
+	for (i = split, j = 0; i < n; i++, j++)
+		leaf_insert(&b_new, j, tmp_record[i].key, tmp_record[i].val);
+	//새 리프로 옮겨간 키는 adaptive hash index에서 뺀다
+	if (b_M.ahi)
+		for (i = split; i < n; i++) ahi_drop(tableid, tmp_record[i].key);
+
+	//새 리프랑 원래리프를 연결시켜준다  물론 그전에 원래리프가 가리키고 있던
+	//다음 부분을 새로만든게 가리킬수 있도록 업뎃을 먼저 해둬야함
 	b_new.right_left = b_leaf.right_left;
 	b_leaf.right_left = n_p;
 
-	//  籸Ƿ  ִ κе ⶧
-	//ű⿡   ش
-	for (i = b_leaf.num_key; i < leaf_order ; i++) {
-		b_leaf.record[i].key = -1;
-		
-	}
-
-
-	//  ʺκ 
-	for (i = b_new.num_key; i < leaf_order ; i++) {
-		b_new.record[i].key = -1;
-		
+	//원래 리프를 재구성했으므로 원래값이 들어있던 부분들이 사라졌기때문에
+	//거기에 대한 조정을 해준다 (LEAF_SLOT은 그 자리가 heap이라 건드리지 않는다)
+	if (b_leaf.leaf_layout == LEAF_RECORD) {
+		for (i = b_leaf.num_key; i < leaf_order ; i++)
+			b_leaf.record[i].key = -1;
+		for (i = b_new.num_key; i < leaf_order ; i++)
+			b_new.record[i].key = -1;
 	}
 
-	//   θ ְ newŰ  
+	//새로 만들어준 리프를 부모와 연결시켜주고 new키 설정 
 	b_new.parent = b_leaf.parent;
-	new_key = b_new.record[0].key;
+	new_key = leaf_key(&b_new, 0);
+	//옮겨간 레코드의 redo 여부를 새 리프에서도 page_LSN으로 가릴 수 있게 넘겨준다
+	b_new.page_LSN = b_leaf.page_LSN;
 
 	setDirty(leaf);
 	setDirty(new_p);
 	clearPin(leaf);
 	clearPin(new_p);
+	pageUnlatch(leaf);
 
 	free(tmp_record);
 //printf("befor in to parent\n");
@@ -1498,19 +5789,18 @@ pthread_mutex_unlock(&b_M.frameArray[new_p].page_latch);
 int insert_into_node(int tableid,pagenum_t n_p,int left_index, int64_t key, pagenum_t right) {
 //printf("\ninsert into node 1 --- left index = %d\n",left_index);	
 	int i;
-	//n_p parent ޾ƿ
+	//n_p에 parent를 받아옴
 	int page_parent = pageScan(tableid, n_p);
-pthread_mutex_unlock(&b_M.frameArray[page_parent].page_latch);
-	//left ε ĭ  ̷Ｍ ڸ ȮѴ
-	for (i = b_page_parent.num_key; i > left_index; i--) {
-		b_page_parent.branch[i + 1].child = b_page_parent.branch[i].child;
-		b_page_parent.branch[i + 1].key = b_page_parent.branch[i].key;
-	}
-
-	//Ű ͸ 
-	b_page_parent.branch[left_index + 1].child = right;
-	b_page_parent.branch[left_index+1].key = key;
+pageUnlatch(page_parent);
+	pageWriteBegin(page_parent);
+	//left 인덱스까지 한칸씩 오른쪽으로 미뤄서 자리를 확보한다
+	for (i = b_page_parent.num_key - 1; i > left_index; i--)
+		node_set(&b_page_parent, i + 1, node_key(&b_page_parent, i), node_child(&b_page_parent, i));
+
+	//키와 포인터를 삽입
+	node_set(&b_page_parent, left_index + 1, key, right);
 	b_page_parent.num_key++;
+	pageWriteEnd(page_parent);
 	
 	setDirty(page_parent);
 	clearPin(page_parent);
@@ -1523,94 +5813,93 @@ pthread_mutex_unlock(&b_M.frameArray[page_parent].page_latch);
 int insert_into_node_after_splitting(int tableid,pagenum_t old, int left_index, int64_t key, pagenum_t right) {
 
 //printf("\ninsert into node after splitting 1\n");
-	//into parentԼ old parent Ѱ
+	//into parent함수에서 old에 parent를 넘겨줌
 	int i, j, split;
 	int64_t k_prime;
 	
-	// ִ  ֱ
-	int old_p = pageScan(tableid, old);
-
-	//ɰ ־   ֱ
+	//쪼개서 넣어줄 새 노드 만들어주기, 리프처럼 원래 노드를 잡기 전에 할당
 	int new_p = make_internal_page(tableid);
+	//make_*_page는 pin을 풀고 돌려주므로, 자식들을 scan하는 동안 쫓겨나지 않게 다시 잡는다
+	setPin(new_p);
 	pagenum_t n_p = b_M.frameArray[new_p].page_num;
 
-pthread_mutex_unlock(&b_M.frameArray[old_p].page_latch);
-pthread_mutex_unlock(&b_M.frameArray[new_p].page_latch);
+	//원래 있던 노드 만들어주기
+	int old_p = pageScan(tableid, old);
+
+pageUnlatch(old_p);
  //printf("\ninsert into node after splitting 2 -- alloc complete : %d \n",new_p);
 	/*
-	   Ű ͸    ùٸ ġ
-	   ִ ӽ Ű ͸ ʽÿ.
-	 ׷   带 ϰ Ű    忡,
-	    忡 Ͻʽÿ.
+	 먼저 새 키와 포인터를 포함한 모든 것을 올바른 위치에
+	 삽입할 수 있는 임시 키와 포인터를 만드십시오.
+	 그런 다음 새 노드를 생성하고 키와 포인터의 절반은 이전 노드에,
+	 나머지 절반은 새 노드에 복사하십시오.
 	 */
-	 //ӽð 
-	key_child * tmp_key_child = (key_child *)malloc(250 * sizeof(struct key_child));
+	 //임시공간 마련
+	key_child * tmp_key_child = (key_child *)malloc((sep_order + 2) * sizeof(struct key_child));
+	int cap = node_cap(b_old.layout);
 
-	// ġ ش
-	for (i = 0, j = 0; i < b_old.num_key + 1; i++, j++) {
-		if (j == left_index + 1) j++;
-		tmp_key_child[j].child = b_old.branch[i].child;
-	}
+	//삽입할 위치를 비워준다
 	for (i = 0, j = 0; i < b_old.num_key; i++, j++) {
 		if (j == left_index+1) j++;
-		tmp_key_child[j].key = b_old.branch[i].key;
+		tmp_key_child[j].key = node_key(&b_old, i);
+		tmp_key_child[j].child = node_child(&b_old, i);
 	}
 
-	// ġ 
+	//삽입할 위치에 삽입
 	tmp_key_child[left_index + 1].child = right;
 	tmp_key_child[left_index+1].key = key;
 
 	/* Create the new node and copy
 	 * half the keys and pointers to the
 	 * old and half to the new.
-	  带 ϰ Ű    忡,    忡 Ͻʽÿ.
+	 새 노드를 생성하고 키와 포인터의 절반을 기존 노드에, 포인터 절반은 새 노드에 복사하십시오.
 	 */
-	 //ɰ ġ ã
-	split = cut(node_order);
-	//  ֱ
+	 //쪼개는 위치 찾기
+	split = cut(cap);
+	//원래 노드 비워주기, 부모에 새 노드가 붙기 전까지 내려오던 reader는 다시 시작
+	pageWriteBegin(old_p);
 	b_old.num_key = 0;
 
-	//ִ  ä
+	//원래있던 노드 채우기
 	for (i = 0; i < split-1; i++) {
 		b_old.num_key++;
-		b_old.branch[i].key = tmp_key_child[i].key;
-		b_old.branch[i].child= tmp_key_child[i].child;
+		node_set(&b_old, i, tmp_key_child[i].key, tmp_key_child[i].child);
 		
 	}
 
-	//  ڽ ڽ   ׳ ø ۾  x
-	//׷ ͳ  ڽ  ö󰡰 ǹǷ
-	//ڽ ڽ  ʿ
+	//리프의 경우는 자신이 자식이 없기 때문에 그냥 올리는 작업을 했을때 문제x
+	//그러나 인터널의 경우 자식을 갖고 올라가게 되므로
+	//자신의 자식정보 수정이 필요
 
 
-	k_prime = tmp_key_child[split-1].key;//ö ģ k_primed 
+	k_prime = tmp_key_child[split-1].key;//올라갈 친구의 k_primed에 저장
 
 	
-	//θ ä
+	//새로만든 노드채우기
 	b_new.num_key = 0;
-	//split   
-	for (++i, j = 0; i <= node_order; i++, j++) {
+	//split 지점 부터 넣음
+	for (++i, j = 0; i <= cap; i++, j++) {
 		b_new.num_key++;
-		b_new.branch[j].key = tmp_key_child[i].key;
-		b_new.branch[j].child = tmp_key_child[i].child;
+		node_set(&b_new, j, tmp_key_child[i].key, tmp_key_child[i].child);
 		
 	}
 	
-	//ø Ű  Ű ִ ڽ θ  right_left(rightmost) Ű 
+	//올린 키가 원래 가리키고 있던 자식을 새로만든 노드의 right_left(rightmost)가 가리키게 설정
 	b_new.right_left= tmp_key_child[split-1].child;
 
-	//θ  θֱ
+	//새로만든 노드 부모설정해주기
 	b_new.parent = b_old.parent;
+	pageWriteEnd(old_p);
 
-	//θ  ڽ θ 
+	//새로만든 노드의 자식의 부모설정도 마무리
 	int child;
 	for (i = 0; i < b_new.num_key; i++) {
 //printf("\nchild changing...\n");
-		child = pageScan(tableid, b_new.branch[i].child);
+		child = pageScan(tableid, node_child(&b_new, i));
 		b_child.parent = n_p;
 		setDirty(child);
 		clearPin(child);
-pthread_mutex_unlock(&b_M.frameArray[child].page_latch);
+pageUnlatch(child);
 		
 	}
 //printf("\nchild changing...\n");
@@ -1625,9 +5914,9 @@ pthread_mutex_unlock(&b_M.frameArray[child].page_latch);
 	clearPin(child);
 
 
-pthread_mutex_unlock(&b_M.frameArray[child].page_latch);
+pageUnlatch(child);
 
-	return insert_into_parent(tableid,old, k_prime, n_p);//ö ģ ؼ θ 
+	return insert_into_parent(tableid,old, k_prime, n_p);//올라갈 친구를 선정해서 부모에 삽입
 }
 
 
@@ -1638,33 +5927,33 @@ int insert_into_parent(int tableid,pagenum_t l, int64_t key, pagenum_t right) {
 
 	int left = pageScan(tableid, l);
 	p_page = b_left.parent;
-pthread_mutex_unlock(&b_M.frameArray[left].page_latch);
+pageUnlatch(left);
 
 //printf("insert into parent 2 : left=%d,parent page=%ld\n",left,p_page);
 
-	//Ʈ ־ϴ ( left Ʈ(internal) )
+	//새루트에 넣어야하는 경우(즉 left가 루트(internal)였던 경우)
 	if (p_page == 0) {
 //printf("insert into new root call\n");
 		clearPin(left);
 		return insert_into_new_root(tableid,l, key, right);
 	}
 
-	//ƴѰ θ ޾ƿ´
+	//아닌경우 부모를 받아온다
 	int parent = pageScan(tableid, p_page);
-	pthread_mutex_unlock(&b_M.frameArray[parent].page_latch);
-	//left θʿ ° ε ִ Ȯ
+	pageUnlatch(parent);
+	//left가 부모쪽에서 몇번째 인덱스에 있는지 확인
 //printf("insert into parent : parent = %ld\n",p_page);
 	left_index = get_left_index(tableid,p_page, l);
 
-	//θ ÷ش
-	if (b_parent.num_key < node_order) {
+	//부모페이지에 올려준다
+	if (b_parent.num_key < node_cap(b_parent.layout)) {
 //printf("insert into node call\n");
 		clearPin(left);
 		clearPin(parent);
 
 		return insert_into_node(tableid,p_page, left_index, key, right);
 	}
-	 //θ ϳ ÷ȴµ ű⼭  ٽ ɰ
+	 //부모로 하나 올렸는데 거기서도 꽉찬경우 다시 쪼개줘야함
 	clearPin(left);
 	clearPin(parent);
 
@@ -1685,16 +5974,21 @@ int cut(int length) {
 
 int db_find_2(int tableid,int64_t key, char * ret_val) {
 	int i;
-	if(b_M.table[tableid-1].isopen==0) {
+	if(!table_isopen(tableid)) {
 		printf("File Is Closed\n");
 		return FAIL;
 	}
+	if (table_get(tableid)->map) return map_find(tableid, key, ret_val);
+	//latch 없이 읽으므로 다 읽은 뒤에 split이나 merge가 끼어들지 않았는지 본다
+	uint64_t smo;
+restart:
+	smo = smo_read_begin(tableid);
 //printf("\ndb_find-1\n");
-	// Ű  ִ  ´
+	//그 키가 들어있을수도 있는 리프페이지를 가져온다
 	int find_p = find_page_2(tableid,key);
 
 //printf("db_find --- find page success, find_p = %d\n",find_p);
-	//Ʈ 
+	//빈트리인 경우
 	if (find_p == FAIL) {
 //printf("db_find- empty\n");
 		//clearPin(find_p);
@@ -1702,32 +5996,28 @@ int db_find_2(int tableid,int64_t key, char * ret_val) {
 	}
 //printf("?..\n");
 
-	//Ű ߰ϸ 
-	for (i = 0; i < b_M.frameArray[find_p].frame_p.num_key; i++)
-	{
-//printf("[%d]check... ",i);
-		if (b_M.frameArray[find_p].frame_p.record[i].key == key) break;
-	}
-//printf("now i = %d and num_key =%d\n",i,b_M.frameArray[find_p].frame_p.num_key);
-	//ε  ƴ϶ ãѰ - break  ƴ϶ 
-	if (i == b_M.frameArray[find_p].frame_p.num_key) {
+	//키를 찾는다
+	i = leaf_find(b_M.frameArray[find_p].frame_p, key);
+//printf("now i = %d and num_key =%d\n",i,b_M.frameArray[find_p].frame_p->num_key);
+	//인덱스가 끝번이 아니라면 찾지못한것 - break로 멈춰진게 아니라는 뜻
+	if (i == b_M.frameArray[find_p].frame_p->num_key) {
 //printf("db_find----- not find\n");
-		clearPin(find_p);
+		if (!smo_read_validate(tableid, smo)) goto restart;
 		return FAIL;
 	}
 	else {
 //printf("db_find------ find\n");
-		strcpy(ret_val, b_M.frameArray[find_p].frame_p.record[i].val);
+		strcpy(ret_val, leaf_val(b_M.frameArray[find_p].frame_p, i));
 //printf("???\n");
-		clearPin(find_p);
+		if (!smo_read_validate(tableid, smo)) goto restart;
 //printf("?..\n");
 		return SUCCESS;
 	}
-	// ޾ƿ  null̶ 
-	//ִٸ    key ġϴ  ã´
-	//for  Ű ε ã´ i 5 
-	// ε numkey ٸ ã --- -1
-	//ƴ϶ val ϰ  0̷
+	//만약 받아온 페이지가 null이라면 리턴종료
+	//있다면 그 페이지 내에서 key와 일치하는 것을 찾는다
+	//for 돌린후 키의 인덱스를 찾는다 i 5 
+	//그 인덱스가 numkey와 같다면 못찾은것 --- -1리턴
+	//아니라면 val를 저장하고  0이런
 }
 
 
@@ -1735,75 +6025,22 @@ int db_find_2(int tableid,int64_t key, char * ret_val) {
 int find_page_2(int tableid,int64_t key) {
 
 //printf("\nfind page 1\n");
-	int i = 0;
-	// ޾ƿ´
-	int head = pageScan(tableid, 0);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
-//printf("0");
-	//Ʈ ϰ
-	if (b_head.root_page == 0) {
+	//인터널은 latch 없이 내려가고 리프만 잡는다, trx가 없으므로 lock x
+	pagenum_t tmp;
+	if (find_leaf_olc(tableid, key, 0, 0, &tmp) != SUCCESS) {
 //printf("find page - empty\n");
-		clearPin(head);
-
-
 		return FAIL;
 	}
 
-	//Ʈ
-	int trace = pageScan(tableid, b_head.root_page);
-	pagenum_t tmp=b_head.root_page;
-
-//printf("1\n");
-	while (!b_M.frameArray[trace].frame_p.is_leaf) {
-		i=0;
-//printf("2\n");
-		while (i < b_M.frameArray[trace].frame_p.num_key) {
-			if (key >= b_M.frameArray[trace].frame_p.branch[i].key) {
-				if(i==(b_M.frameArray[trace].frame_p.num_key -1)){
-				break;
-				}
-				i++;
-			}
-			else {
-				i--;
-				break;
-			}
-
-		}
-
-		if (i != -1) {
-//printf("find page - 2\n");
-			tmp = b_M.frameArray[trace].frame_p.branch[i].child;
-clearPin(trace);
-pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-//printf("\nunlock page [%d]\n",trace);
-			trace = pageScan(tableid, tmp);
-//printf("lock new  page [%d]\n",trace);
-		}
-		else if (i == -1) {
-//printf("find page - 3\n");
-			tmp = b_M.frameArray[trace].frame_p.right_left;
-clearPin(trace);
-pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-			//printf("unlock page [%d]\n",trace);
-			trace = pageScan(tableid, tmp);
-//printf("lock new  page [%d]\n",trace);
-		}
-		
-	
-	}
-	//while  ٴ°   
-	//̶ ȯǴ    Ű   ְ   ִ
-	//  9 ã , 7̻ 10̸ Ű ־ϴ  ȯǾ
-	//ű⿡ 9 ִٴ  x
-pthread_mutex_unlock(&b_M.frameArray[trace].page_latch);
-	int find = pageScan(tableid, tmp);
+	//while 이 끝났다는건 리프 까지 도착
+	//이때 반환되는 리프 페이지에는 실제 키가 들어있을 수도 있고 없을 수도 있다
+	//예를 들어 9를 찾는 경우, 7이상 10미만의 키들이 들어있어야하는 페이지가 반환되어도
+	//거기에 9가 있다는 보장은 x
+	int find = pageScanShared(tableid, tmp);
 //printf("find page - 4\n");
 
-	clearPin(trace);
-
 	clearPin(find);
-pthread_mutex_unlock(&b_M.frameArray[find].page_latch);
+pageUnlatch(find);
 	return find;
 }
 
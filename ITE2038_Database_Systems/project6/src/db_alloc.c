@@ -0,0 +1,124 @@
+#include "db_alloc.h"
+#include <stdlib.h>
+
+#ifdef DB_MM
+#include <pthread.h>
+#include "memlib.h"
+#include "mm.h"
+
+//mm_pool_*은 mm.c 안에만 선언되어 있고 handout의 mm.h에는 없으므로 mm.c의 선언과 맞춰둔다
+typedef struct mm_pool mm_pool;
+mm_pool *mm_pool_create(size_t size);
+void *mm_pool_alloc(mm_pool *pool);
+void mm_pool_free(mm_pool *pool, void *p);
+
+static mm_pool * db_pool[DB_OBJ_NUM];
+static pthread_mutex_t db_pool_latch = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t db_mm_once = PTHREAD_ONCE_INIT;
+static pthread_key_t db_cache_key;
+static int db_mm_ok;
+
+//객체의 첫 word로 잇는 쓰레드별 free list
+typedef struct db_cache {
+	void * head;
+	int num;
+}db_cache;
+
+static __thread db_cache db_cache_local[DB_OBJ_NUM];
+
+static void db_cache_exit(void * arg);
+
+//mm은 처음 한번만, 아무 쓰레드도 mm을 쓰기 전에 초기화된다
+static void db_mm_init(void)
+{
+	mem_init();
+	db_mm_ok = mm_init() == 0;
+	pthread_key_create(&db_cache_key, db_cache_exit);
+}
+
+//쓰레드가 끝나면 쥐고 있던 객체를 pool로 돌려준다
+static void db_cache_exit(void * arg)
+{
+	for (int k = 0; k < DB_OBJ_NUM; k++) {
+		db_cache * c = &db_cache_local[k];
+		while (c->head) {
+			void * p = c->head;
+			c->head = *(void**)p;
+			mm_pool_free(db_pool[k], p);
+		}
+		c->num = 0;
+	}
+}
+
+static mm_pool * db_pool_get(enum db_obj kind, size_t size)
+{
+	mm_pool * pool = __atomic_load_n(&db_pool[kind], __ATOMIC_ACQUIRE);
+	if (pool) return pool;
+
+	pthread_once(&db_mm_once, db_mm_init);
+	if (!db_mm_ok) return NULL;
+	pthread_mutex_lock(&db_pool_latch);
+	pool = db_pool[kind];
+	if (!pool) {
+		pool = mm_pool_create(size);
+		__atomic_store_n(&db_pool[kind], pool, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&db_pool_latch);
+	return pool;
+}
+
+void * db_obj_alloc(enum db_obj kind, size_t size)
+{
+	db_cache * c = &db_cache_local[kind];
+	if (c->head) {
+		void * p = c->head;
+		c->head = *(void**)p;
+		c->num--;
+		return p;
+	}
+	mm_pool * pool = db_pool_get(kind, size);
+	if (!pool) return NULL;
+	//이 쓰레드가 pool에서 처음 가져갈때 끝날때 돌려줄 수 있게 등록
+	pthread_setspecific(db_cache_key, db_cache_local);
+	return mm_pool_alloc(pool);
+}
+
+//다른 쓰레드가 만든 객체도 여기 쌓인다, 넘치면 pool로
+void db_obj_free(enum db_obj kind, void * p)
+{
+	if (!p) return;
+	db_cache * c = &db_cache_local[kind];
+	if (c->num >= DB_OBJ_CACHE) {
+		mm_pool_free(db_pool[kind], p);
+		return;
+	}
+	*(void**)p = c->head;
+	c->head = p;
+	c->num++;
+}
+
+void * db_slab_alloc(size_t size)
+{
+	pthread_once(&db_mm_once, db_mm_init);
+	if (!db_mm_ok) return NULL;
+	return mm_malloc(size);
+}
+
+#else
+
+void * db_obj_alloc(enum db_obj kind, size_t size)
+{
+	return malloc(size);
+}
+
+void db_obj_free(enum db_obj kind, void * p)
+{
+	free(p);
+}
+
+void * db_slab_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+#endif
@@ -1,5 +1,6 @@
 ﻿
 
+#define _GNU_SOURCE
 #include<stdio.h>
 #include<fcntl.h>
 #include<string.h>
@@ -10,84 +11,126 @@
 #include <sys/stat.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
 #include "file.h"
 
 int ch;
 
+//쓰레드마다 잡아둔 extent, [next, end)는 헤더의 page_num 안에 들어있지만 free list에는 없는 페이지
+//gen이 테이블의 gen과 다르면 그 사이에 테이블이 닫혔다 열린 것이므로 쓰지 않는다
+typedef struct file_extent {
+	int gen;
+	pagenum_t next;
+	pagenum_t end;
+}file_extent;
+typedef struct cz_file cz_file;
+static cz_file * cz_get(int fd);
+
+static __thread file_extent * file_ext;//table_id - 1로 찾는다, 이 쓰레드가 건드린 가장 큰 table_id까지만 늘린다
+static __thread int file_ext_num;
+
+static file_extent * file_ext_get(int table_id)
+{
+	if (table_id > file_ext_num) {
+		int n = file_ext_num ? file_ext_num : 16;
+		while (n < table_id) n *= 2;
+		file_extent * e = (file_extent*)realloc(file_ext, n * sizeof(file_extent));
+		if (!e) return NULL;
+		memset(e + file_ext_num, 0, (n - file_ext_num) * sizeof(file_extent));
+		file_ext = e;
+		file_ext_num = n;
+	}
+	return &file_ext[table_id - 1];
+}
+
 //프리페이지에서 떼와서 disk페이지를 할당한다.
+//free list가 비었으면 파일 끝에서 extent_pages개를 헤더 한번 고쳐서 잡아두고, 남은 것은 이 쓰레드가 헤더 없이 쓴다
+//같은 쓰레드가 만드는 페이지들은 디스크에서도 이어지므로 리프 readahead가 잘 맞는다
 pagenum_t file_alloc_page(int table_id) {
+	Table * tb = table_get(table_id);
+	file_extent * e = file_ext_get(table_id);
+	int now_free;
 
-	//printf("\nfile alloc page start\n");
-		//헤더를 버퍼에서 읽어온다.
+	if (e && e->gen == tb->gen && e->next < e->end) {
+		now_free = pageScan(table_id, e->next++);
+		pageUnlatch(now_free);
+		return now_free;//새 페이지를 올려둔 프레임 인덱스 반환
+	}
+
+	//헤더를 버퍼에서 읽어온다.
 	int head = pageScan(table_id, 0);
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
 	setDirty(head);
 
-	//현재 그 파일에서 사용하고 있는 페이지 수
-	pagenum_t page_use = b_head.page_num;
-	//printf("first page_use=%ld\n",page_use);
-		//헤더에서 프리페이지 첫 위치를 찾는다
-	pagenum_t free_p = b_head.free_page;
-	//printf("first free_page=%ld\n",b_head.free_page);
-		//만약 현재 프리페이지가 없다면 새로 더 할당해준다 //10개 만들어 주기
-	int tmp;
-	if (free_p == 0) {
-		//새페이지 하나 불러와서 free페이지리스트앞에 넣어준다.
-		tmp = pageScan(table_id, page_use);
-		//printf("new free!! tmp= %d\n",tmp);
-		b_head.free_page = page_use;
-		//printf("now firstfree = %ld",page_use);
-				//오른쪽프리페이지 아직없음
-		b_M.frameArray[tmp].frame_p.parent = 0;
-
-		//1증가
-		b_head.page_num++;
-		page_use++;
-
-		//set/clear
-		setDirty(tmp);
-		clearPin(tmp);
-pthread_mutex_unlock(&b_M.frameArray[tmp].page_latch);
-		for (int i = 1; i < 5; i++)
-		{
-			//printf("free make = i: %d\n",i);
-						//새페이지 하나 불러와서 free페이지리스트앞에 넣어준다. 오른쪽 꺼랑도 다시 연결
-			tmp = pageScan(table_id, page_use);
-			//printf("new free!! tmp= %d\n",tmp);
-			//printf("um.. past free_page = %ld\n",b_head.free_page);
-			//printf("um..past parent=%ld",b_M.frameArray[tmp].frame_p.parent);
-			b_M.frameArray[tmp].frame_p.parent = b_head.free_page;
-			b_head.free_page = page_use;
-
-			//printf("now firstfree = %ld\n",page_use);
-			//printf("now firstfree_right = %ld\n",b_M.frameArray[tmp].frame_p.parent);
-
-						//1증가
-			b_head.page_num++;
-			page_use++;
-
-			//set/clear
-			setDirty(tmp);
-			clearPin(tmp);
-pthread_mutex_unlock(&b_M.frameArray[tmp].page_latch);
+	//돌려받은 페이지가 있으면 그것부터, 오른쪽친구를 프리페이지헤더로 만들고 줌
+	if (b_head.free_page != 0) {
+		now_free = pageScan(table_id, b_head.free_page);
+		b_head.free_page = b_M.frameArray[now_free].frame_p->parent;
+		pageUnlatch(now_free);
+		clearPin(head);
+		pageUnlatch(head);
+		return now_free;
+	}
 
-		}
+	int n = b_opt.extent_pages > 0 ? b_opt.extent_pages : FILE_EXTENT;
+	pagenum_t first = b_head.page_num;
+	b_head.page_num += n;
+	clearPin(head);
+	pageUnlatch(head);
+
+	//extent를 디스크에서도 미리 잡아둔다, 아직 쓰지 않은 페이지는 0으로 읽힌다
+	//지원하지 않는 파일시스템이면 그냥 파일 끝 뒤를 쓰면서 늘어난다, 압축 테이블은 page_num 자리에 쓰지 않는다
+	if (!cz_get(tb->fd)) fallocate(tb->fd, 0, (off_t)first * PAGESIZE, (off_t)n * PAGESIZE);
+	//캐시를 못 늘렸으면 남은 페이지는 버려진다
+	if (e) {
+		e->gen = tb->gen;
+		e->next = first + 1;
+		e->end = first + n;
 	}
-	//pagenum_t tmp_free=b_head.free_page;
 
+	now_free = pageScan(table_id, first);
+	pageUnlatch(now_free);
+	return now_free;
+}
 
-	//넘겨줄 빈 페이지를 가져와서 오른쪽친구를 프리페이지헤더로 만들고 줌
-	int now_free = pageScan(table_id, b_head.free_page);
-	b_head.free_page = b_M.frameArray[now_free].frame_p.parent;
-pthread_mutex_unlock(&b_M.frameArray[now_free].page_latch);
-	//printf("alloc after :");
-	//headInfo(table_id);
-	//bufInfo();
-	//freeInfo(table_id);
+//이 쓰레드가 잡아두고 쓰지 않은 extent 페이지를 돌려준다
+//파일 끝의 extent면 page_num만 줄이고, 아니면 free list에 넣는다
+//다른 쓰레드가 들고 있던 extent는 닫힌 뒤에 gen이 달라져 버려지고, 파일 안의 쓰지 않은 페이지로 남는다
+void file_extent_release(int table_id) {
+	if (table_id > file_ext_num) return;
+	file_extent * e = &file_ext[table_id - 1];
+	if (e->gen != table_get(table_id)->gen || e->next >= e->end) {
+		e->gen = 0;
+		return;
+	}
 
+	int head = pageScan(table_id, 0);
+	setDirty(head);
+	if (e->end == (pagenum_t)b_head.page_num) b_head.page_num = e->next;
+	else {
+		//뒤에서부터 넣어서 앞쪽 페이지가 먼저 나가게
+		for (pagenum_t pn = e->end; pn-- > e->next;)
+		{
+			int tmp = pageScan(table_id, pn);
+			b_M.frameArray[tmp].frame_p->parent = b_head.free_page;
+			b_head.free_page = pn;
+			setDirty(tmp);
+			clearPin(tmp);
+			pageUnlatch(tmp);
+		}
+	}
+	e->gen = 0;
 	clearPin(head);
-	return now_free;//새 페이지를 올려둔 프레임 인덱스 반환
+	pageUnlatch(head);
 }
 
 
@@ -104,14 +147,14 @@ void file_free_page(int table_id, pagenum_t pagenum) {
 		//받아온 페이지를 프리 페이지 리스트에 넣어준다. 
 		//나중에 make page할때 다 초기화 하므로 지금 초기화해서 넣어 줄필요는 x
 	int do_free = pageScan(table_id, pagenum);
-pthread_mutex_unlock(&b_M.frameArray[do_free].page_latch);
+pageUnlatch(do_free);
 
 	//리스트 연결
-	b_M.frameArray[do_free].frame_p.parent = b_head.free_page;
+	b_M.frameArray[do_free].frame_p->parent = b_head.free_page;
 	b_head.free_page = pagenum;
-pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
+pageUnlatch(head);
 	//Drop 하고 clear
-	pageDrop(do_free);
+	pageEvict(do_free);
 	clearPin(do_free);
 	clearPin(head);
 	//printf("free after :");
@@ -120,25 +163,844 @@ pthread_mutex_unlock(&b_M.frameArray[head].page_latch);
 
 }
 
-void file_read_page(int table_fd, pagenum_t pagenum, page_t* dest) {
+//O_DIRECT는 메모리 주소도 PAGESIZE 정렬이어야 한다
+//프레임은 buffer_S 안에 메타데이터와 같이 있어서 첫 프레임만 정렬되므로, 정렬되지 않은 페이지는 쓰레드마다 둔 bounce buffer를 거친다
+static __thread page_t * file_bounce;
+static __thread int file_bounce_num;
+
+static page_t * file_bounce_get(int n)
+{
+	if (file_bounce_num < n) {
+		free(file_bounce);
+		if (posix_memalign((void**)&file_bounce, PAGESIZE, (size_t)n * PAGESIZE) != 0) {
+			file_bounce = NULL;
+			file_bounce_num = 0;
+			return NULL;
+		}
+		file_bounce_num = n;
+	}
+	return file_bounce;
+}
+
+static int file_unaligned(const void * p)
+{
+	return b_opt.direct_io && ((uintptr_t)p & (PAGESIZE - 1));
+}
+
+//CRC32C (Castagnoli), x86은 SSE4.2의 crc32, ARMv8은 CRC 확장 명령으로 8바이트씩, 둘 다 없으면 table로 한 바이트씩
+//헤더도 같은 자리에 checksum을 둔다
+_Static_assert(offsetof(page_t, checksum) == offsetof(header_page, checksum), "checksum offset");
+_Static_assert(offsetof(page_t, checksum) == PAGE_CSUM_OFF, "checksum offset");
+_Static_assert(offsetof(header_page, page_size) == 32, "geometry offset");
+_Static_assert(offsetof(page_t, body) == PAGE_HEADER, "page header size");
+_Static_assert(sizeof(page_t) == PAGESIZE, "page size");
+_Static_assert(sizeof(header_page) == PAGESIZE, "header size");
+#define CSUM_OFF offsetof(page_t, checksum)
+//checksum 뒤쪽을 CSUM_LANE바이트씩 세 갈래로 나눠 crc 명령의 latency를 겹친다, 8의 배수 (4096이면 1336)
+#define CSUM_LANE ((PAGESIZE - PAGE_CSUM_OFF - 4) / 3 / 8 * 8)
+_Static_assert(CSUM_OFF + sizeof(uint32_t) + 3 * CSUM_LANE <= PAGESIZE, "checksum lane");
+
+static uint32_t crc_table[256];
+static uint32_t crc_shift_table[4][256];//crc 값 뒤에 0을 CSUM_LANE바이트 더 넣은 결과, 바이트마다 나눠서
+static int crc_hw;
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+//c 뒤에 0을 n바이트 더 넣는다
+static uint32_t crc_zero(uint32_t c, size_t n)
+{
+	for (; n > 0; n--) c = crc_table[c & 0xFF] ^ (c >> 8);
+	return c;
+}
+
+//crc(A + B) = shift(crc(A)) ^ crc(B), B가 CSUM_LANE바이트이고 crc(B)는 0에서 시작했을때
+static uint32_t crc_shift(uint32_t c)
+{
+	return crc_shift_table[0][c & 0xFF] ^ crc_shift_table[1][(c >> 8) & 0xFF]
+		^ crc_shift_table[2][(c >> 16) & 0xFF] ^ crc_shift_table[3][c >> 24];
+}
+
+static void crc_init(void)
+{
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t c = i;
+		for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78 & -(c & 1));
+		crc_table[i] = c;
+	}
+#if defined(__x86_64__)
+	crc_hw = __builtin_cpu_supports("sse4.2");
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	crc_hw = 1;
+#endif
+	//0을 넣는 것은 선형이라 bit 하나씩만 구해서 xor로 합친다
+	if (crc_hw) {
+		uint32_t bit[32];
+		for (int b = 0; b < 32; b++) bit[b] = crc_zero(1u << b, CSUM_LANE);
+		for (int k = 0; k < 4; k++)
+			for (uint32_t v = 0; v < 256; v++) {
+				uint32_t c = 0;
+				for (int b = 0; b < 8; b++) if (v & (1u << b)) c ^= bit[k * 8 + b];
+				crc_shift_table[k][v] = c;
+			}
+	}
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc_run_hw(uint32_t c, const unsigned char * p, size_t n)
+{
+	uint64_t c64 = c;
+	for (; n >= 8; p += 8, n -= 8) {
+		uint64_t v;
+		memcpy(&v, p, 8);
+		c64 = __builtin_ia32_crc32di(c64, v);
+	}
+	c = (uint32_t)c64;
+	for (; n > 0; p++, n--) c = __builtin_ia32_crc32qi(c, *p);
+	return c;
+}
+
+//p부터 3 * CSUM_LANE바이트
+__attribute__((target("sse4.2")))
+static uint32_t crc_run_hw3(uint32_t c, const unsigned char * p)
+{
+	uint64_t a = c, b = 0, d = 0;
+	for (size_t i = 0; i < CSUM_LANE; i += 8) {
+		uint64_t va, vb, vd;
+		memcpy(&va, p + i, 8);
+		memcpy(&vb, p + CSUM_LANE + i, 8);
+		memcpy(&vd, p + 2 * CSUM_LANE + i, 8);
+		a = __builtin_ia32_crc32di(a, va);
+		b = __builtin_ia32_crc32di(b, vb);
+		d = __builtin_ia32_crc32di(d, vd);
+	}
+	return crc_shift(crc_shift((uint32_t)a) ^ (uint32_t)b) ^ (uint32_t)d;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+static uint32_t crc_run_hw(uint32_t c, const unsigned char * p, size_t n)
+{
+	for (; n >= 8; p += 8, n -= 8) {
+		uint64_t v;
+		memcpy(&v, p, 8);
+		c = __crc32cd(c, v);
+	}
+	for (; n > 0; p++, n--) c = __crc32cb(c, *p);
+	return c;
+}
+
+static uint32_t crc_run_hw3(uint32_t c, const unsigned char * p)
+{
+	uint32_t a = c, b = 0, d = 0;
+	for (size_t i = 0; i < CSUM_LANE; i += 8) {
+		uint64_t va, vb, vd;
+		memcpy(&va, p + i, 8);
+		memcpy(&vb, p + CSUM_LANE + i, 8);
+		memcpy(&vd, p + 2 * CSUM_LANE + i, 8);
+		a = __crc32cd(a, va);
+		b = __crc32cd(b, vb);
+		d = __crc32cd(d, vd);
+	}
+	return crc_shift(crc_shift(a) ^ b) ^ d;
+}
+#endif
+
+static uint32_t crc_run(uint32_t c, const unsigned char * p, size_t n)
+{
+#if defined(__x86_64__) || (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+	if (crc_hw) return crc_run_hw(c, p, n);
+#endif
+	for (; n > 0; p++, n--) c = crc_table[(c ^ *p) & 0xFF] ^ (c >> 8);
+	return c;
+}
+
+uint32_t page_checksum(const page_t * page)
+{
+	pthread_once(&crc_once, crc_init);
+	const unsigned char * p = (const unsigned char*)page;
+	uint32_t c = crc_run(0xFFFFFFFF, p, CSUM_OFF);
+	p += CSUM_OFF + sizeof(uint32_t);
+	size_t n = PAGESIZE - CSUM_OFF - sizeof(uint32_t);
+#if defined(__x86_64__) || (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+	if (crc_hw) {
+		c = crc_run_hw3(c, p);
+		p += 3 * CSUM_LANE;
+		n -= 3 * CSUM_LANE;
+	}
+#endif
+	return ~crc_run(c, p, n);
+}
+
+//쓰기 전에 채운다
+static void page_checksum_set(page_t * page)
+{
+	page->checksum = page_checksum(page);
+}
+
+//다 읽은 페이지의 checksum 확인, 0이면 예전 파일이거나 한번도 쓰지 않은 페이지라 넘어간다
+static int page_checksum_check(int table_fd, pagenum_t pagenum, const page_t * page)
+{
+	if (b_opt.no_checksum || page->checksum == 0) return SUCCESS;
+	uint32_t c = page_checksum(page);
+	if (c == page->checksum) return SUCCESS;
+	printf("page checksum mismatch : fd %d page %" PRIu64 " (stored %08x, computed %08x)\n", table_fd, pagenum, page->checksum, c);
+	return FAIL;
+}
+
+//압축 테이블 (b_opt.compress로 만든 파일)
+//파일 맨 앞 PAGESIZE는 압축 헤더 (magic, map page들의 위치), 헤더 페이지를 포함한 논리 페이지는 전부 map을 거친다
+//페이지는 CZ_SECTOR 단위의 가변 slot에 [압축 길이 4바이트 | 압축한 페이지]로 쓰고, map은 page_num -> (slot 시작 섹터, 섹터 수)
+//새로 쓴 값이 slot에 들어가면 그 자리에 덮어쓰고, 넘치면 파일 끝에 한 섹터 여유를 둔 slot을 새로 잡는다 (예전 slot은 다시 쓰지 않는다)
+//slot을 옮길때는 데이터를 내린(fdatasync) 뒤에 map에서 그 entry가 있는 섹터 하나만 고쳐 쓴다
+//중간에 죽어도 map은 예전 slot이나 새 slot 중 다 쓴 쪽을 가리킨다
+#define CZ_MAGIC 0x3130454741505a43ULL//"CZPAGE01", 일반 테이블이면 이 자리는 헤더의 free_page
+#define CZ_SECTOR 512
+#define CZ_MAP_ENT (PAGESIZE / 8)//map page 하나가 가리키는 페이지 수
+#define CZ_DIR ((PAGESIZE - 8) / 4)//압축 헤더에 둘 수 있는 map page 수
+#define CZ_FD_MAX 4096//fd로 바로 찾는다
+#define CZ_RAW 0//길이 자리가 0이면 압축하지 않고 그대로 쓴 페이지
+#define CZ_HASH 12//압축할때 4바이트 hash의 비트 수
+
+typedef struct cz_super {
+	uint64_t magic;
+	uint32_t dir[CZ_DIR];//map page의 시작 섹터, 0이면 아직 없음
+}cz_super;
+_Static_assert(sizeof(cz_super) == PAGESIZE, "compressed header size");
+
+typedef struct cz_file {
+	pthread_mutex_t latch;//slot 할당과 map 고치기
+	uint64_t end;//다음에 잡을 섹터
+	cz_super * sup;
+	uint64_t * map[CZ_DIR];//entry = 시작 섹터 << 8 | 섹터 수, 0이면 한번도 쓰지 않은 페이지
+	uint64_t relocate;//slot을 옮긴 횟수
+}cz_file;
+
+static cz_file * file_cz[CZ_FD_MAX];
+static __thread unsigned char cz_buf[PAGESIZE + 2 * CZ_SECTOR];
+static __thread uint16_t cz_hash[1 << CZ_HASH];
+
+static cz_file * cz_get(int fd)
+{
+	return (fd >= 0 && fd < CZ_FD_MAX) ? __atomic_load_n(&file_cz[fd], __ATOMIC_ACQUIRE) : NULL;
+}
+
+//LZ4 block과 같은 꼴의 LZ77 : token(상위 4비트 literal 길이, 하위 4비트 match 길이 - 4, 15면 뒤에 255씩 이어서) literal, offset 2바이트, match
+//마지막 sequence는 literal만 있다, val[120]의 0 padding은 offset 1짜리 긴 match 하나가 된다
+static int lz_len(unsigned char * dst, int op, int cap, int n)
+{
+	for (; n >= 255; n -= 255) {
+		if (op >= cap) return -1;
+		dst[op++] = 255;
+	}
+	if (op >= cap) return -1;
+	dst[op++] = (unsigned char)n;
+	return op;
+}
+
+static int lz_seq(unsigned char * dst, int op, int cap, const unsigned char * lit, int ll, int off, int ml)
+{
+	if (op >= cap) return -1;
+	int t = op++;
+	dst[t] = (unsigned char)((ll < 15 ? ll : 15) << 4);
+	if (ll >= 15 && (op = lz_len(dst, op, cap, ll - 15)) < 0) return -1;
+	if (op + ll > cap) return -1;
+	memcpy(dst + op, lit, ll);
+	op += ll;
+	if (off == 0) return op;
+	if (op + 2 > cap) return -1;
+	dst[op++] = (unsigned char)off;
+	dst[op++] = (unsigned char)(off >> 8);
+	ml -= 4;
+	dst[t] |= ml < 15 ? ml : 15;
+	if (ml >= 15 && (op = lz_len(dst, op, cap, ml - 15)) < 0) return -1;
+	return op;
+}
+
+//압축한 길이, cap 안에 들어가지 않으면 -1
+static int lz_compress(const unsigned char * src, int n, unsigned char * dst, int cap)
+{
+	memset(cz_hash, 0, sizeof(cz_hash));
+	int ip = 0, anchor = 0, op = 0;
+	while (ip + 4 <= n) {
+		uint32_t v;
+		memcpy(&v, src + ip, 4);
+		uint32_t h = (v * 2654435761u) >> (32 - CZ_HASH);
+		int ref = cz_hash[h] - 1;
+		cz_hash[h] = (uint16_t)(ip + 1);
+		if (ref < 0 || memcmp(src + ref, src + ip, 4) != 0) {
+			ip++;
+			continue;
+		}
+		int ml = 4;
+		while (ip + ml < n && src[ref + ml] == src[ip + ml]) ml++;
+		if ((op = lz_seq(dst, op, cap, src + anchor, ip - anchor, ip - ref, ml)) < 0) return -1;
+		ip += ml;
+		anchor = ip;
+	}
+	return lz_seq(dst, op, cap, src + anchor, n - anchor, 0, 0);
+}
+
+//풀린 길이, 깨졌으면 -1
+static int lz_decompress(const unsigned char * src, int n, unsigned char * dst, int cap)
+{
+	int ip = 0, op = 0;
+	while (ip < n) {
+		int t = src[ip++];
+		int ll = t >> 4, b;
+		if (ll == 15) do {
+			if (ip >= n) return -1;
+			ll += b = src[ip++];
+		} while (b == 255);
+		if (ip + ll > n || op + ll > cap) return -1;
+		memcpy(dst + op, src + ip, ll);
+		ip += ll;
+		op += ll;
+		if (ip == n) break;
+
+		if (ip + 2 > n) return -1;
+		int off = src[ip] | src[ip + 1] << 8;
+		ip += 2;
+		int ml = (t & 15) + 4;
+		if ((t & 15) == 15) do {
+			if (ip >= n) return -1;
+			ml += b = src[ip++];
+		} while (b == 255);
+		if (off == 0 || off > op || op + ml > cap) return -1;
+		//겹칠 수 있으므로 한 바이트씩
+		for (int i = 0; i < ml; i++) dst[op + i] = dst[op - off + i];
+		op += ml;
+	}
+	return op;
+}
+
+//map page j, 없으면 만들어서 압축 헤더에 남긴다 (latch를 잡고 부른다)
+static uint64_t * cz_map_page(int fd, cz_file * z, int j)
+{
+	if (z->map[j]) return z->map[j];
+	uint64_t * m = (uint64_t*)calloc(1, PAGESIZE);
+	if (!m) return NULL;
+	uint64_t s = z->end;
+	if (pwrite(fd, m, PAGESIZE, s * CZ_SECTOR) != PAGESIZE) {
+		free(m);
+		return NULL;
+	}
+	z->end += PAGESIZE / CZ_SECTOR;
+	//빈 map page가 내려간 뒤에 가리킨다
+	fdatasync(fd);
+	z->sup->dir[j] = (uint32_t)s;
+	size_t at = offsetof(cz_super, dir) + j * sizeof(uint32_t);
+	at -= at % CZ_SECTOR;
+	if (pwrite(fd, (char*)z->sup + at, CZ_SECTOR, at) != CZ_SECTOR) printf("compressed header write fail\n");
+	__atomic_store_n(&z->map[j], m, __ATOMIC_RELEASE);
+	return m;
+}
+
+static int cz_write(int fd, cz_file * z, pagenum_t pagenum, const page_t * src)
+{
+	if (pagenum >= (pagenum_t)CZ_DIR * CZ_MAP_ENT) return FAIL;
+	int j = pagenum / CZ_MAP_ENT, k = pagenum % CZ_MAP_ENT;
+
+	//한 섹터도 줄지 않으면 그대로 쓴다
+	uint32_t len = lz_compress((const unsigned char*)src, PAGESIZE, cz_buf + 4, PAGESIZE - CZ_SECTOR);
+	if ((int)len < 0) {
+		len = CZ_RAW;
+		memcpy(cz_buf + 4, src, PAGESIZE);
+	}
+	memcpy(cz_buf, &len, 4);
+	int size = 4 + (len == CZ_RAW ? PAGESIZE : len);
+	int need = (size + CZ_SECTOR - 1) / CZ_SECTOR;
+	memset(cz_buf + size, 0, need * CZ_SECTOR - size);
+
+	pthread_mutex_lock(&z->latch);
+	uint64_t * m = cz_map_page(fd, z, j);
+	if (!m) {
+		pthread_mutex_unlock(&z->latch);
+		return FAIL;
+	}
+	uint64_t e = m[k];
+	if (e != 0 && (int)(e & 0xFF) >= need) {
+		pthread_mutex_unlock(&z->latch);
+		//같은 페이지를 두 쓰레드가 같이 쓰지는 않으므로 그 자리에 바로 덮어쓴다
+		return pwrite(fd, cz_buf, need * CZ_SECTOR, (e >> 8) * CZ_SECTOR) == need * CZ_SECTOR ? SUCCESS : FAIL;
+	}
+
+	int cap = need <= PAGESIZE / CZ_SECTOR ? need + 1 : need;
+	uint64_t s = z->end;
+	z->end += cap;
+	int ret = SUCCESS;
+	if (pwrite(fd, cz_buf, need * CZ_SECTOR, s * CZ_SECTOR) != need * CZ_SECTOR) ret = FAIL;
+	else {
+		//처음 쓰는 페이지는 지킬 예전 값이 없다 (덜 내려간 자리는 0으로 읽혀 쓰지 않은 페이지가 된다)
+		if (e != 0) {
+			fdatasync(fd);
+			z->relocate++;
+		}
+		__atomic_store_n(&m[k], s << 8 | cap, __ATOMIC_RELEASE);
+		size_t at = k * sizeof(uint64_t);
+		at -= at % CZ_SECTOR;
+		if (pwrite(fd, (char*)m + at, CZ_SECTOR, (off_t)z->sup->dir[j] * CZ_SECTOR + at) != CZ_SECTOR) ret = FAIL;
+	}
+	pthread_mutex_unlock(&z->latch);
+	return ret;
+}
+
+//읽은 바이트 수, 한번도 쓰지 않았으면 0 (dest는 그대로), 깨졌으면 -1
+static int cz_read(int fd, cz_file * z, pagenum_t pagenum, page_t * dest)
+{
+	if (pagenum >= (pagenum_t)CZ_DIR * CZ_MAP_ENT) return 0;
+	uint64_t * m = __atomic_load_n(&z->map[pagenum / CZ_MAP_ENT], __ATOMIC_ACQUIRE);
+	if (!m) return 0;
+	uint64_t e = __atomic_load_n(&m[pagenum % CZ_MAP_ENT], __ATOMIC_ACQUIRE);
+	if (e == 0) return 0;
+
+	ssize_t got = pread(fd, cz_buf, (e & 0xFF) * CZ_SECTOR, (e >> 8) * CZ_SECTOR);
+	if (got < 4) return 0;
+	uint32_t len;
+	memcpy(&len, cz_buf, 4);
+	if (len == CZ_RAW) {
+		if (got < 4 + PAGESIZE) return 0;
+		memcpy(dest, cz_buf + 4, PAGESIZE);
+		return PAGESIZE;
+	}
+	if (len > got - 4 || lz_decompress(cz_buf + 4, len, (unsigned char*)dest, PAGESIZE) != PAGESIZE) return -1;
+	return PAGESIZE;
+}
+
+//헤더에 남은 페이지/레코드 크기가 이 빌드와 같은지, 0이면 크기를 남기기 전에 만든 4096/128 파일
+int file_geometry_check(int table_fd, const header_page * h)
+{
+	int page_size = h->page_size ? h->page_size : 4096;
+	int record_size = h->record_size ? h->record_size : 128;
+	if (page_size == PAGESIZE && record_size == RECORD_SIZE) return SUCCESS;
+	printf("page geometry mismatch : fd %d is page %d / record %d, built for page %d / record %d\n", table_fd, page_size, record_size, PAGESIZE, RECORD_SIZE);
+	return FAIL;
+}
+
+int file_open_table(int table_fd, int create)
+{
+	if (table_fd < 0) return FAIL;
+	if (create && !b_opt.compress) return SUCCESS;
+	cz_super * sup = (cz_super*)NULL;
+	if (posix_memalign((void**)&sup, PAGESIZE, PAGESIZE) != 0) return FAIL;
+	ssize_t got = 0;
+	if (create) {
+		memset(sup, 0, PAGESIZE);
+		sup->magic = CZ_MAGIC;
+		if (table_fd >= CZ_FD_MAX || pwrite(table_fd, sup, PAGESIZE, 0) != PAGESIZE) {
+			free(sup);
+			return FAIL;
+		}
+	}
+	else if ((got = pread(table_fd, sup, PAGESIZE, 0)) < (ssize_t)sizeof(uint64_t) || sup->magic != CZ_MAGIC) {
+		//압축하지 않은 파일은 여기가 헤더 페이지, 다른 크기로 만든 파일이면 PAGESIZE보다 덜 읽힐 수 있다
+		int ret = (got >= (ssize_t)offsetof(header_page, reserved0)) ? file_geometry_check(table_fd, (header_page*)sup) : SUCCESS;
+		free(sup);
+		return ret;
+	}
+	else if (table_fd >= CZ_FD_MAX) {
+		free(sup);
+		return FAIL;
+	}
+
+	//slot은 섹터 단위라 O_DIRECT는 끈다
+	int fl = fcntl(table_fd, F_GETFL);
+	if (fl >= 0 && (fl & O_DIRECT)) fcntl(table_fd, F_SETFL, fl & ~O_DIRECT);
+
+	cz_file * z = (cz_file*)calloc(1, sizeof(cz_file));
+	pthread_mutex_init(&z->latch, NULL);
+	z->sup = sup;
+	z->end = PAGESIZE / CZ_SECTOR;
+	//map이 가리키는 곳과 파일 끝 중 먼 쪽부터 잡는다 (map에 남기 전에 죽은 slot도 다시 쓰지 않는다)
+	for (int j = 0; j < CZ_DIR; j++) {
+		if (sup->dir[j] == 0) continue;
+		uint64_t * m = (uint64_t*)calloc(1, PAGESIZE);
+		if (pread(table_fd, m, PAGESIZE, (off_t)sup->dir[j] * CZ_SECTOR) != PAGESIZE) {
+			printf("compressed map read fail : fd %d map %d\n", table_fd, j);
+			memset(m, 0, PAGESIZE);
+		}
+		if (z->end < sup->dir[j] + PAGESIZE / CZ_SECTOR) z->end = sup->dir[j] + PAGESIZE / CZ_SECTOR;
+		for (int k = 0; k < CZ_MAP_ENT; k++)
+			if (m[k] && z->end < (m[k] >> 8) + (m[k] & 0xFF)) z->end = (m[k] >> 8) + (m[k] & 0xFF);
+		z->map[j] = m;
+	}
+	struct stat st;
+	if (fstat(table_fd, &st) == 0 && z->end < (uint64_t)(st.st_size + CZ_SECTOR - 1) / CZ_SECTOR)
+		z->end = (st.st_size + CZ_SECTOR - 1) / CZ_SECTOR;
+	//압축 파일은 헤더 페이지도 map을 거친다, 다른 크기로 만든 파일이면 map부터 맞지 않아 못 읽는다
+	if (!create) {
+		page_t * head = (page_t*)malloc(PAGESIZE);
+		int n = head ? cz_read(table_fd, z, 0, head) : -1;
+		int ret = (n < 0 || (n == PAGESIZE && file_geometry_check(table_fd, (header_page*)head) != SUCCESS)) ? FAIL : SUCCESS;
+		free(head);
+		if (ret != SUCCESS) {
+			for (int j = 0; j < CZ_DIR; j++) free(z->map[j]);
+			free(sup);
+			pthread_mutex_destroy(&z->latch);
+			free(z);
+			return FAIL;
+		}
+	}
+	__atomic_store_n(&file_cz[table_fd], z, __ATOMIC_RELEASE);
+	return SUCCESS;
+}
+
+void file_close_table(int table_fd)
+{
+	cz_file * z = cz_get(table_fd);
+	if (!z) return;
+	file_cz[table_fd] = NULL;
+	for (int j = 0; j < CZ_DIR; j++) free(z->map[j]);
+	free(z->sup);
+	pthread_mutex_destroy(&z->latch);
+	free(z);
+}
+
+int file_compressed_image(const void * first_page)
+{
+	uint64_t magic;
+	memcpy(&magic, first_page, sizeof(magic));
+	return magic == CZ_MAGIC;
+}
+
+int file_compress_info(int table_fd, uint64_t * pages, uint64_t * bytes, uint64_t * relocate)
+{
+	cz_file * z = cz_get(table_fd);
+	if (!z) return FAIL;
+	pthread_mutex_lock(&z->latch);
+	uint64_t n = 0, used = 0;
+	for (int j = 0; j < CZ_DIR; j++) {
+		if (!z->map[j]) continue;
+		used += PAGESIZE;
+		for (int k = 0; k < CZ_MAP_ENT; k++)
+			if (z->map[j][k]) {
+				n++;
+				used += (z->map[j][k] & 0xFF) * CZ_SECTOR;
+			}
+	}
+	*pages = n;
+	*bytes = used + PAGESIZE;
+	*relocate = z->relocate;
+	pthread_mutex_unlock(&z->latch);
+	return SUCCESS;
+}
+
+//압축 테이블의 file_submit, io마다 페이지를 하나씩 읽고 쓴다
+static void cz_submit_one(cz_file * z, file_io * io, file_done done)
+{
+	io->res = SUCCESS;
+	for (int i = 0; i < io->cnt; i++) {
+		if (io->write) {
+			page_checksum_set(io->pages[i]);
+			if (cz_write(io->fd, z, io->page_num + i, io->pages[i]) != SUCCESS) io->res = FAIL;
+			continue;
+		}
+		int got = cz_read(io->fd, z, io->page_num + i, io->pages[i]);
+		if (got < 0 || (got == PAGESIZE && page_checksum_check(io->fd, io->page_num + i, io->pages[i]) != SUCCESS)) io->res = FAIL;
+	}
+	if (done) done(io);
+}
+
+int file_read_page(int table_fd, pagenum_t pagenum, page_t* dest) {
 	//printf("\nfile read\n");
-	off_t off = lseek(table_fd, pagenum*PAGESIZE, SEEK_SET);
+	//여러 partition/flusher가 같은 fd를 쓰므로 lseek 대신 pread
 	//printf("fd : %d\n",table_fd);
-	ch = read(table_fd, dest, PAGESIZE);
+	cz_file * z = cz_get(table_fd);
+	page_t * bounce = !z && file_unaligned(dest) ? file_bounce_get(1) : NULL;
+	if (z) {
+		ch = cz_read(table_fd, z, pagenum, dest);
+		if (ch < 0) {
+			printf("compressed page broken : fd %d page %" PRIu64 "\n", table_fd, pagenum);
+			return FAIL;
+		}
+	}
+	else if (bounce) {
+		//파일 끝을 넘으면 읽은 만큼만 옮긴다 (buffered pread와 같게)
+		ch = pread(table_fd, bounce, PAGESIZE, pagenum*PAGESIZE);
+		if (ch > 0) memcpy(dest, bounce, ch);
+	}
+	else ch = pread(table_fd, dest, PAGESIZE, pagenum*PAGESIZE);
 
 	if (fsync(table_fd) == -1) printf("read fsync() failed\n");
 
 	//printf("file read end\n");
+	//파일 끝을 넘어 덜 읽었으면 아직 쓰지 않은 페이지
+	if (ch != PAGESIZE) return SUCCESS;
+	return page_checksum_check(table_fd, pagenum, dest);
 }
 
-void file_write_page(int table_fd, pagenum_t pagenum, const page_t* src) {
+void file_write_page(int table_fd, pagenum_t pagenum, page_t* src) {
 	//printf("\nfile write\n");
 
-	off_t off = lseek(table_fd, pagenum*PAGESIZE, SEEK_SET);
-	ch = write(table_fd, src, PAGESIZE);
+	page_checksum_set(src);
+	cz_file * z = cz_get(table_fd);
+	page_t * bounce = !z && file_unaligned(src) ? file_bounce_get(1) : NULL;
+	if (z) {
+		if (cz_write(table_fd, z, pagenum, src) != SUCCESS) printf("compressed page write fail : fd %d page %" PRIu64 "\n", table_fd, pagenum);
+	}
+	else {
+		if (bounce) {
+			memcpy(bounce, src, PAGESIZE);
+			src = bounce;
+		}
+		ch = pwrite(table_fd, src, PAGESIZE, pagenum*PAGESIZE);
+	}
 
 
 	if (fsync(table_fd) == -1)printf("write fsync fail\n");
 	//printf("file write end\n");
 
 }
+
+//연속된 페이지들을 pwritev 한번으로 쓴다, fsync는 호출한 쪽에서
+//direct_io에서 정렬되지 않은 페이지가 섞여 있으면 bounce buffer에 이어 붙여 pwrite 한번으로 쓴다
+int file_write_pages(int table_fd, pagenum_t pagenum, page_t** src, int cnt) {
+	struct iovec iov[64];
+	int done = 0;
+
+	for (int i = 0; i < cnt; i++) page_checksum_set(src[i]);
+	cz_file * z = cz_get(table_fd);
+	if (z) {
+		for (int i = 0; i < cnt; i++)
+			if (cz_write(table_fd, z, pagenum + i, src[i]) != SUCCESS) return FAIL;
+		return SUCCESS;
+	}
+	while (done < cnt) {
+		int n = cnt - done;
+		if (n > (int)(sizeof(iov) / sizeof(iov[0]))) n = sizeof(iov) / sizeof(iov[0]);
+
+		int unaligned = 0;
+		for (int i = 0; i < n && !unaligned; i++) unaligned = file_unaligned(src[done + i]);
+		page_t * bounce = unaligned ? file_bounce_get(n) : NULL;
+		if (bounce) {
+			for (int i = 0; i < n; i++) memcpy(&bounce[i], src[done + i], PAGESIZE);
+			if (pwrite(table_fd, bounce, (size_t)n * PAGESIZE, (pagenum + done)*PAGESIZE) != (ssize_t)n * PAGESIZE)
+				return FAIL;
+			done += n;
+			continue;
+		}
+
+		for (int i = 0; i < n; i++) {
+			iov[i].iov_base = src[done + i];
+			iov[i].iov_len = PAGESIZE;
+		}
+		if (pwritev(table_fd, iov, n, (pagenum + done)*PAGESIZE) != (ssize_t)n * PAGESIZE)
+			return FAIL;
+		done += n;
+	}
+	return SUCCESS;
+}
+
+//io_uring, 쓰레드마다 ring 하나 (liburing 없이 syscall로 직접 쓴다)
+//만들지 못하면(커널이 막았거나 오래된 커널) 그 쓰레드는 preadv/pwritev로 한다
+typedef struct file_ring {
+	int fd;//-1이면 아직 안 만듦, -2면 만들지 못함
+	unsigned entries;
+	unsigned * sq_head;
+	unsigned * sq_tail;
+	unsigned * sq_mask;
+	unsigned * sq_array;
+	unsigned * cq_head;
+	unsigned * cq_tail;
+	unsigned * cq_mask;
+	struct io_uring_sqe * sqes;
+	struct io_uring_cqe * cqes;
+	void * sq_map;
+	void * cq_map;
+	size_t sq_len;
+	size_t cq_len;
+	size_t sqe_len;
+}file_ring;
+
+static __thread file_ring file_R = { .fd = -1 };
+static pthread_key_t file_ring_key;
+static pthread_once_t file_ring_once = PTHREAD_ONCE_INIT;
+
+static void file_ring_close(void * arg)
+{
+	file_ring * r = (file_ring*)arg;
+	if (r->fd < 0) return;
+	munmap(r->sqes, r->sqe_len);
+	if (r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_len);
+	munmap(r->sq_map, r->sq_len);
+	close(r->fd);
+	r->fd = -2;
+}
+
+static void file_ring_key_init(void)
+{
+	pthread_key_create(&file_ring_key, file_ring_close);
+}
+
+static file_ring * file_ring_get(void)
+{
+	file_ring * r = &file_R;
+	if (r->fd != -1) return r->fd >= 0 ? r : NULL;
+	r->fd = -2;
+
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	int fd = syscall(__NR_io_uring_setup, FILE_RING, &p);
+	if (fd < 0) return NULL;
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	int single = p.features & IORING_FEAT_SINGLE_MMAP;
+	if (single) {
+		if (r->cq_len > r->sq_len) r->sq_len = r->cq_len;
+		r->cq_len = r->sq_len;
+	}
+	r->sqe_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	r->sq_map = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (r->sq_map == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	r->cq_map = single ? r->sq_map : mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqe_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (r->cq_map == MAP_FAILED || r->sqes == MAP_FAILED) {
+		if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqe_len);
+		if (r->cq_map != MAP_FAILED && !single) munmap(r->cq_map, r->cq_len);
+		munmap(r->sq_map, r->sq_len);
+		close(fd);
+		return NULL;
+	}
+
+	char * sq = (char*)r->sq_map;
+	char * cq = (char*)r->cq_map;
+	r->sq_head = (unsigned*)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned*)(sq + p.sq_off.array);
+	r->cq_head = (unsigned*)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+	r->entries = p.sq_entries;
+	r->fd = fd;
+
+	//쓰레드가 끝날때 ring을 닫는다
+	pthread_once(&file_ring_once, file_ring_key_init);
+	pthread_setspecific(file_ring_key, r);
+	return r;
+}
+
+//io 하나가 끝났다, res는 읽거나 쓴 바이트 수 (음수면 errno)
+//읽기는 파일 끝을 넘으면 읽은 만큼만 채워지는 것이 pread와 같으므로 성공으로 본다
+static void file_io_end(file_io * io, long res, page_t * bounce, file_done done)
+{
+	if (io->write) io->res = (res == (long)io->cnt * PAGESIZE) ? SUCCESS : FAIL;
+	else {
+		io->res = res >= 0 ? SUCCESS : FAIL;
+		if (bounce && res > 0)
+			for (int i = 0; i < io->cnt && (long)i * PAGESIZE < res; i++)
+				memcpy(io->pages[i], &bounce[i], res - (long)i * PAGESIZE < PAGESIZE ? res - (long)i * PAGESIZE : PAGESIZE);
+		//다 읽은 페이지만 checksum을 본다
+		for (int i = 0; i < io->cnt && (long)(i + 1) * PAGESIZE <= res; i++)
+			if (page_checksum_check(io->fd, io->page_num + i, io->pages[i]) != SUCCESS) io->res = FAIL;
+	}
+	if (done) done(io);
+}
+
+int file_submit(file_io * io, int n, file_done done)
+{
+	if (n <= 0) return SUCCESS;
+
+	//압축 테이블이 섞여 있으면 io마다 따로
+	for (int k = 0; k < n; k++) {
+		if (!cz_get(io[k].fd)) continue;
+		int ret = SUCCESS;
+		for (k = 0; k < n; k++) {
+			cz_file * z = cz_get(io[k].fd);
+			if (z) cz_submit_one(z, &io[k], done);
+			else file_submit(&io[k], 1, done);
+			if (io[k].res != SUCCESS) ret = FAIL;
+		}
+		return ret;
+	}
+
+	//io마다 iovec을 이어서 잡는다, direct_io에서 정렬되지 않은 페이지가 있으면 전부 bounce buffer를 거친다
+	int total = 0, unaligned = 0;
+	for (int k = 0; k < n; k++) {
+		total += io[k].cnt;
+		for (int i = 0; i < io[k].cnt && !unaligned; i++) unaligned = file_unaligned(io[k].pages[i]);
+	}
+	struct iovec * iov = (struct iovec*)malloc(sizeof(struct iovec) * total);
+	int * first = (int*)malloc(sizeof(int) * n);
+	if (!iov || !first) {
+		free(iov);
+		free(first);
+		return FAIL;
+	}
+	page_t * bounce = unaligned ? file_bounce_get(total) : NULL;
+	for (int k = 0, at = 0; k < n; k++) {
+		first[k] = at;
+		for (int i = 0; i < io[k].cnt; i++, at++) {
+			if (io[k].write) page_checksum_set(io[k].pages[i]);
+			iov[at].iov_base = bounce ? (void*)&bounce[at] : (void*)io[k].pages[i];
+			iov[at].iov_len = PAGESIZE;
+			if (bounce && io[k].write) memcpy(&bounce[at], io[k].pages[i], PAGESIZE);
+		}
+	}
+
+	file_ring * r = b_opt.io_uring ? file_ring_get() : NULL;
+	int next = 0;
+	if (r) {
+		//ring에 들어가는 만큼 넣고 하나라도 끝나면 거둔다, 끝난 io는 바로 done을 부른다
+		//next까지 넣었고 reaped개 거뒀다, 커널이 받지 않으면(broken) 더 넣지 않고 받은 것만 거둔 뒤 나머지는 sync로
+		int reaped = 0, broken = 0;
+		while (reaped < next || (next < n && !broken)) {
+			unsigned tail = *r->sq_tail;
+			while (!broken && next < n && next - reaped < (int)r->entries) {
+				unsigned slot = tail & *r->sq_mask;
+				struct io_uring_sqe * sqe = &r->sqes[slot];
+				memset(sqe, 0, sizeof(*sqe));
+				sqe->opcode = io[next].write ? IORING_OP_WRITEV : IORING_OP_READV;
+				sqe->fd = io[next].fd;
+				sqe->off = (uint64_t)io[next].page_num * PAGESIZE;
+				sqe->addr = (uint64_t)(uintptr_t)&iov[first[next]];
+				sqe->len = io[next].cnt;
+				sqe->user_data = next;
+				r->sq_array[slot] = slot;
+				tail++;
+				next++;
+			}
+			__atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+
+			unsigned pend = tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+			if (syscall(__NR_io_uring_enter, r->fd, pend, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+				&& errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				if (broken) break;
+				printf("io_uring enter fail\n");
+				broken = 1;
+				//넣은 순서대로 받으므로 받지 않은 것은 끝쪽 io들이다
+				unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+				next -= tail - head;
+				__atomic_store_n(r->sq_tail, head, __ATOMIC_RELEASE);
+			}
+
+			unsigned head = *r->cq_head;
+			unsigned ctail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+			while (head != ctail) {
+				struct io_uring_cqe * cqe = &r->cqes[head & *r->cq_mask];
+				int k = (int)cqe->user_data;
+				file_io_end(&io[k], cqe->res, bounce ? &bounce[first[k]] : NULL, done);
+				reaped++;
+				head++;
+			}
+			__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+		}
+	}
+
+	//sync : io마다 preadv/pwritev 한번
+	for (; next < n; next++) {
+		off_t off = (off_t)io[next].page_num * PAGESIZE;
+		long res = io[next].write ? pwritev(io[next].fd, &iov[first[next]], io[next].cnt, off)
+			: preadv(io[next].fd, &iov[first[next]], io[next].cnt, off);
+		file_io_end(&io[next], res, bounce ? &bounce[first[next]] : NULL, done);
+	}
+
+	int ret = SUCCESS;
+	for (int k = 0; k < n; k++) if (io[k].res != SUCCESS) ret = FAIL;
+	free(iov);
+	free(first);
+	return ret;
+}
@@ -3,6 +3,12 @@
 #include "buf_manager.h"
 
 #include "file.h"
+#include "db_alloc.h"
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 
 
@@ -14,14 +20,13 @@ int init_lock_table()
 {
 //printf("\ninit lock table start\n");
 	//hash table create
-	hash_t = createHashTable(20);
+	hash_t = createHashTable(LOCK_STRIPE);
 	if (!hash_t) {
 		//printf("init null error\n");
 		return FAIL;
 	}
 
-	//mutex,cond init
-	pthread_mutex_init(&lock_table_latch, NULL);
+	//stripe latch는 createHashTable에서 초기화
 	
 //hashPrint(hash_t);
 //printf("init lock table complete\n");
@@ -29,387 +34,782 @@ int init_lock_table()
 }
 
 
-// 
-lock_t* lock_acquire(int table_id, int64_t key, int trx_id, int lock_mode)
+//lock_t pool, 쓰레드마다 free list를 둔다
+//다른 쓰레드가 푼 lock(abort 등)은 푼 쓰레드의 pool로 가므로, 한쪽에 쌓이면 공용 pool을 거쳐 돌려쓴다
+//pool 안에서는 next로 잇는다
+static __thread lock_t * lock_pool;
+static __thread int lock_pool_num;
+static lock_t * lock_pool_shared;
+static int lock_pool_shared_num;
+static pthread_mutex_t lock_pool_latch = PTHREAD_MUTEX_INITIALIZER;
+
+static lock_t * lock_alloc(void)
 {
-//printf("\nlock acquire start - lock/ table id = %d,key = %ld, trx id=%d,mode=%d\n",table_id,key,trx_id,lock_mode);
+	if (!lock_pool) {
+		//공용 pool에서 LOCK_SLAB개까지 가져온다
+		pthread_mutex_lock(&lock_pool_latch);
+		while (lock_pool_shared && lock_pool_num < LOCK_SLAB) {
+			lock_t * t = lock_pool_shared;
+			lock_pool_shared = t->next;
+			lock_pool_shared_num--;
+			t->next = lock_pool;
+			lock_pool = t;
+			lock_pool_num++;
+		}
+		pthread_mutex_unlock(&lock_pool_latch);
+	}
+	if (!lock_pool) {
+		//새 slab, 돌려주지 않는다
+		lock_t * slab = (lock_t*)db_slab_alloc(sizeof(struct lock_t) * LOCK_SLAB);
+		if (!slab) return NULL;
+		for (int i = 0; i < LOCK_SLAB; i++) {
+			slab[i].park = 0;
+			slab[i].next = lock_pool;
+			lock_pool = &slab[i];
+		}
+		lock_pool_num = LOCK_SLAB;
+	}
+	lock_t * t = lock_pool;
+	lock_pool = t->next;
+	lock_pool_num--;
+	return t;
+}
 
-	//ؽ 
-	pthread_mutex_lock(&lock_table_latch);
-//printf("lock-table mutex lock suc/ table id = %d,key = %ld, trx id=%d,mode=%d\n",table_id,key,trx_id,lock_mode);
-	int ch = 0,ch2=0;
-	int t_c;
-//printf("before init\n");
-	if (!hash_t)init_lock_table();
-	
-	//̺ ش緹ڵ带  尡  ʴ´ٸ
-	//ؽ̺ 带 ߰  Ʈ ޾ش
-//printf("before node find\n");
-	Node* find = hashSearch(hash_t, table_id,key);
-	if(!find) {
-//printf("not find-hash insert\n");
-		hashInsert(hash_t, table_id, key);
-		find = hashSearch(hash_t, table_id, key);
+static void lock_free(lock_t * lock)
+{
+	lock->next = lock_pool;
+	lock_pool = lock;
+	if (++lock_pool_num <= LOCK_POOL_MAX) return;
+
+	//반을 떼어 공용 pool로 넘긴다
+	lock_t * first = lock_pool, * last = lock_pool;
+	for (int i = 1; i < LOCK_POOL_MAX / 2; i++) last = last->next;
+	lock_pool = last->next;
+	lock_pool_num -= LOCK_POOL_MAX / 2;
+
+	pthread_mutex_lock(&lock_pool_latch);
+	last->next = lock_pool_shared;
+	lock_pool_shared = first;
+	lock_pool_shared_num += LOCK_POOL_MAX / 2;
+	pthread_mutex_unlock(&lock_pool_latch);
+}
+
+//Node는 lock table에서 빠지지 않으므로 slab에서 잘라 쓰기만 한다
+//Node와 head, tail sentinel을 한 slab에서 같이 잡는다
+typedef struct node_slab_t {
+	Node node;
+	lock_t head;
+	lock_t tail;
+}node_slab_t;
+
+static __thread node_slab_t * node_slab;
+static __thread int node_slab_left;
+
+static Node * node_alloc(void)
+{
+	if (node_slab_left == 0) {
+		node_slab = (node_slab_t*)db_slab_alloc(sizeof(struct node_slab_t) * LOCK_SLAB);
+		if (!node_slab) return NULL;
+		node_slab_left = LOCK_SLAB;
 	}
+	node_slab_t * t = &node_slab[--node_slab_left];
+	t->node.head = &t->head;
+	t->node.tail = &t->tail;
+	t->node.closed = 0;
+	memset(t->node.fast, 0, sizeof(t->node.fast));
+	return &t->node;
+}
 
-	//߰ õ  ٽ нÿ fail
-	
+//최근에 본 (table_id, key)의 Node와 이 쓰레드의 trx가 받은 lock
+//Node는 lock table에서 빠지지 않고 table_id/record_id도 바뀌지 않으므로 latch 없이 다시 써도 된다
+//lock은 trx가 자기 쓰레드에서만 풀므로 owner가 같은 동안은 그 trx의 것이다 (lock_t는 free되지 않는다)
+typedef struct lock_cache_t {
+	Node * node;
+	lock_t * lock;
+	int trx_id;
+}lock_cache_t;
 
-	// ڵ   trx  ִ ˻ -> s1 - w1 ̷ / s1->w2-w1̰  Ȳ
-	ch = trx_duplicate(find->head->next, trx_id);
-	//ch2= trx_error(find->head->next);
-	//printf("lock?...\n");
-	lock_t * tmp = find->head->next;
-	lock_t * tmp2;
-	lock_t * dead_tmp;
-	// ְ ̹  read϶
-	
-	if (ch == 1) {
-		//printf("i have this record lock already\n");
-		if (lock_mode ==0) {
-			//printf("my mode is %d\n", lock_mode);
-			//S ʿϸ     lock ش.
-			while (tmp->next != NULL) {
-				if (tmp->owner_txn_id == trx_id) {
-					//printf("find my trx's another lock\n");
-					// trx Ҽ ٸ lock ߰ߴµ  ٷ   ޷ ϴ Ŷ(ǳ̶)
-					if (tmp->next->next == NULL) {
-						//printf("can exchange me right now\n");
-						if(tmp==NULL)printf("exchange but null error\n");
-						pthread_mutex_unlock(&lock_table_latch);
-						//printf("lock acquire : mutex unlock - finish\n");
-						return tmp;
-					}
-
-					//S ڿ  ְ ׵ڿ ̹ S  Ű  װ ̹ tail  
-					tmp2 = tmp;
-					while (tmp2->lock_mode==0) {
-						//printf("can exchange, lot of S\n");
-						if (tmp2->next->next == NULL) {
-							pthread_mutex_unlock(&lock_table_latch);
-							//printf("lock acquire : mutex unlock - finish\n");
-							return tmp;
-						}
-						tmp2 = tmp2->next;
-					}
-					break;
-				}
-				tmp = tmp->next;
-			}
+static __thread lock_cache_t lock_cache[LOCK_CACHE];
+
+static lock_cache_t * lock_cache_get(int table_id, int64_t key)
+{
+	return &lock_cache[getKey(table_id, key) & (LOCK_CACHE - 1)];
+}
+
+//fast 자리에 trx_id가 아닌 trx가 있으면 1, X를 막는다
+static int lock_fast_other(Node * node, int trx_id)
+{
+	for (int k = 0; k < LOCK_FAST; k++) {
+		int id = __atomic_load_n(&node->fast[k], __ATOMIC_SEQ_CST);
+		if (id != 0 && id != trx_id) return 1;
+	}
+	return 0;
+}
+
+static void lock_grant(Node * node);
+
+//fast 자리 k를 비운다, 줄에서 이 자리 때문에 자던 X가 있을 수 있으면 stripe latch를 잡고 다시 깨운다
+static void lock_fast_put(Node * node, int k)
+{
+	__atomic_store_n(&node->fast[k], 0, __ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(&node->closed, __ATOMIC_SEQ_CST)) return;
+	stat_latch(node->latch, STAT_LOCK_LATCH);
+	lock_grant(node);
+	pthread_mutex_unlock(node->latch);
+}
+
+//줄이 비어있으면 fast 자리를 잡아 S를 준다, 못 받으면 NULL
+//자리를 잡은 뒤 closed를 다시 보고, 줄을 연 쪽은 closed를 올린 뒤 자리를 보므로 둘 중 하나는 꼭 상대를 본다
+static lock_t * lock_fast_get(Node * node, int trx_id)
+{
+	if (__atomic_load_n(&node->closed, __ATOMIC_ACQUIRE)) return NULL;
+	for (int k = 0; k < LOCK_FAST; k++) {
+		int zero = 0;
+		if (__atomic_load_n(&node->fast[k], __ATOMIC_RELAXED) != 0) continue;
+		if (!__atomic_compare_exchange_n(&node->fast[k], &zero, trx_id, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) continue;
+		if (__atomic_load_n(&node->closed, __ATOMIC_SEQ_CST)) {
+			//줄에서 기다리는 lock이 이 자리를 봤을 수 있으므로 lock_fast_put으로 놓는다
+			lock_fast_put(node, k);
+			return NULL;
 		}
-		else {
-			//printf("my mode is %d\n", lock_mode);
-			//տ ִ ڽ trx 
-			while (tmp->next != NULL) {
-				if (tmp->owner_txn_id == trx_id) break;
-				tmp = tmp->next;
-			}
+		lock_t * lock = lock_alloc();
+		if (!lock) {
+			lock_fast_put(node, k);
+			return NULL;
+		}
+		lock->lock_mode = 0;
+		lock->owner_txn_id = trx_id;
+		lock->sleep = 0;
+		lock->victim = 0;
+		lock->upgrade = 0;
+		lock->change = 0;
+		lock->fast = k + 1;
+		lock->node_ptr = node;
+		lock->pre = NULL;
+		lock->next = NULL;
+		trx_lock(trx_id, lock);
+		return lock;
+	}
+	return NULL;
+}
 
-			//W ʿѵ տ W  װ 
-			if (tmp->lock_mode == 1 && tmp->next->next == NULL) {
-				//printf("pre lock is W, return this\n");
-				pthread_mutex_unlock(&lock_table_latch);
-				//printf("lock acquire : mutex unlock - finish\n");
-				return tmp;
-			}
 
-			//տ sϳ  s 带 w ϰ  -> w2 s1 w1 ΰ w2 w1 
-			if (tmp->lock_mode == 0&&tmp->next->next==NULL) {
-				if(tmp->pre->pre==NULL){
-				//printf("pre lock is only s and first lock, return this\n");
-				tmp->lock_mode = 1;
-				pthread_mutex_unlock(&lock_table_latch);
-				//printf("lock acquire : mutex unlock - finish\n");
-				return tmp;
-				}
-				
-			}
+//처음 lock_acquire를 부른 쓰레드가 한번만 만든다
+static pthread_once_t lock_table_once = PTHREAD_ONCE_INIT;
+static void lock_table_init_once(void)
+{
+	init_lock_table();
+}
 
-			//s    ִ s ڷ Űְ  w 
-			if (tmp->lock_mode == 0) {
-			
-				tmp2 = find->tail->pre;
-				while (tmp2->lock_mode==0) {
-					if (tmp2 == tmp) {
-					//printf("there are many S in front of me!! move this to tail and return s->w and sleep\n");
-						tmp->pre->next = tmp->next;
-						tmp->next->pre = tmp->pre;
-
-						tmp->pre = find->tail->pre;
-						tmp->next = find->tail;
-						find->tail->pre->next=tmp;
-						find->tail->pre=tmp;
-						
-						
-						tmp->sleep = 1;
-					
-						
-						
-				dead_tmp=tmp->pre;
-				
-				ch=checkDead(dead_tmp, tmp->owner_txn_id);
-			
+//o가 lock을 막으면 1 (다른 trx이고 mode가 맞지 않을때)
+//앞의 lock은 기다리는 중이라도 먼저 왔으므로 막고, 뒤의 lock은 이미 받은 것(upgrade 중이면 받아둔 S)만 막는다
+static int lock_blocks(lock_t * lock, lock_t * o, int behind)
+{
+	if (o->owner_txn_id == lock->owner_txn_id) return 0;
+	int m = o->lock_mode;
+	if (behind && o->sleep) {
+		if (!o->upgrade) return 0;
+		m = 0;
+	}
+	return m == 1 || lock->lock_mode == 1;
+}
 
-					//  abort Ǵ failȲ ߻
-				
-				if (ch == ABORT) {
-					pthread_mutex_unlock(&lock_table_latch);
-					//printf("lock acquire : mutex unlock - ABORT finish\n");
-					return NULL;
-				}
-				
+//lock을 지금 받을 수 있으면 1, stripe latch를 잡고 부른다
+//acquire와 release가 같은 규칙을 쓰므로 S->X upgrade도 줄에서 자리를 옮기지 않는다
+static int lock_grantable(lock_t * lock)
+{
+	if (lock->lock_mode == 1 && lock_fast_other(lock->node_ptr, lock->owner_txn_id)) return 0;
+	for (lock_t * t = lock->pre; t->pre != NULL; t = t->pre)
+		if (lock_blocks(lock, t, 0)) return 0;
+	for (lock_t * t = lock->next; t->next != NULL; t = t->next)
+		if (lock_blocks(lock, t, 1)) return 0;
+	return 1;
+}
 
-						tmp->lock_mode = 1;
-				
+//wait-for 간선을 모으는 id 배열, 대부분 몇개 없으므로 stack에 모으고 넘칠때만 malloc
+typedef struct id_list {
+	int buf[16];
+	int * ids;
+	int num;
+	int cap;
+}id_list;
 
-				
+static void id_init(id_list * l)
+{
+	l->ids = l->buf;
+	l->num = 0;
+	l->cap = 16;
+}
 
-						
-						//printf("cond wait...please sleep\n");
-						//printTrx();
-
-	//for(int i=0;i<15;i++){
-	//show_lock_list(i,1);
-	//}
-						
-						while(tmp->sleep){
-						ch=pthread_cond_wait(&tmp->cond, &lock_table_latch);
-						}
-						
-						//printf("cond wake!... continue the function,ch=%d\n",ch);
-
-						//ؽ 
-						
-						pthread_mutex_unlock(&lock_table_latch);
-						//printf("lock acquire : mutex unlock - Execption Finish\n");
-						return tmp;
-
-					}
-					tmp2 = tmp2->pre;
-				}
-			}
+static void id_push(id_list * l, int id)
+{
+	if (l->num == l->cap) {
+		int * more = (int*)malloc(sizeof(int) * l->cap * 2);
+		memcpy(more, l->ids, sizeof(int) * l->num);
+		if (l->ids != l->buf) free(l->ids);
+		l->ids = more;
+		l->cap *= 2;
+	}
+	l->ids[l->num++] = id;
+}
+
+static void id_free(id_list * l)
+{
+	if (l->ids != l->buf) free(l->ids);
+}
+
+//lock을 막고 있는 lock들의 주인을 모아 stripe latch를 놓은 뒤 deadlock 검사를 한다
+//upgrade는 뒤에서 자던 lock도 새로 막으므로 그 주인들의 간선에 자신을 더한다
+//SUCCESS면 latch를 다시 잡고 돌아오고, ABORT면 놓은 채로 돌아온다
+static int lock_wait_check(pthread_mutex_t * latch, lock_t * lock)
+{
+	id_list w, up;
+	id_init(&w);
+	id_init(&up);
+	for (lock_t * t = lock->pre; t->pre != NULL; t = t->pre)
+		if (lock_blocks(lock, t, 0)) id_push(&w, t->owner_txn_id);
+	for (lock_t * t = lock->next; t->next != NULL; t = t->next) {
+		if (lock_blocks(lock, t, 1)) id_push(&w, t->owner_txn_id);
+		else if (lock->upgrade && t->sleep && t->owner_txn_id != lock->owner_txn_id) id_push(&up, t->owner_txn_id);
+	}
+	if (lock->lock_mode == 1) {
+		for (int k = 0; k < LOCK_FAST; k++) {
+			int id = __atomic_load_n(&lock->node_ptr->fast[k], __ATOMIC_SEQ_CST);
+			if (id != 0 && id != lock->owner_txn_id) id_push(&w, id);
 		}
 	}
+	pthread_mutex_unlock(latch);
 
+	if (up.num > 0) trx_wait_add(up.ids, up.num, lock->owner_txn_id);
+	//detector 모드에서는 간선만 남기고 검사는 detector 쓰레드가 한다
+	int ch = b_opt.dead_ms > 0 ? trx_wait_set(lock->owner_txn_id, w.ids, w.num, lock)
+		: checkDead(lock->owner_txn_id, w.ids, w.num);
+	id_free(&w);
+	id_free(&up);
+	if (ch == ABORT) return ABORT;
 
-	//  Ʈ   ʱȭ
-	lock_t * new_lock = (lock_t*)malloc(sizeof(struct lock_t));
-		
-	new_lock->pre = NULL;
-	new_lock->next = NULL;
-	new_lock->lock_mode = lock_mode;
-	new_lock->owner_txn_id = trx_id;
-	new_lock->sleep = 0;
-	new_lock->change=0;
-	
-	new_lock->trx_next_lock = NULL;
-	new_lock->node_ptr = find;
-	pthread_cond_init(&new_lock->cond, NULL);
-
-
-	//Ѵٸ شڿ  ߰
-	tmp = find->head->next;
-	while (1) {
-//printf("lock list check....\n");
-		//null̶
-		if(!tmp) {
-			// tmp head head null̶     Ʈ 
-			if (tmp == find->head->next) {
-//printf("lock insert : first time\n");
-				//ũ Ʈ 
-				new_lock->pre = find->head;
-				new_lock->next = find->tail;
-
-				find->head->next = new_lock;
-				find->tail->pre = new_lock;
-			}
-			//Ʈ   
-			else {
-//printf("lock insert : insert back\n");
-				// ũ Ʈ 
-				new_lock->pre = find->tail->pre;
-				new_lock->next = find->tail;
-
-				new_lock->pre->next = new_lock;
-				find->tail->pre = new_lock;
-			}
-			break;
+	stat_latch(latch, STAT_LOCK_LATCH);
+	return SUCCESS;
+}
+
+//park가 0이 될때까지 futex에서 잔다, end_ns(CLOCK_MONOTONIC, 0이면 무한)가 지나면 1
+//lock_t는 pool로 돌아갈뿐 free되지 않으므로 다른 trx에 다시 쓰인 lock을 깨워도 park를 다시 보고 잔다
+static int lock_park(lock_t * lock, uint64_t end_ns)
+{
+	while (__atomic_load_n(&lock->park, __ATOMIC_ACQUIRE)) {
+		struct timespec ts, * tp = NULL;
+		if (end_ns) {
+			uint64_t now = stat_ns();
+			if (now >= end_ns) return 1;
+			ts.tv_sec = (end_ns - now) / 1000000000;
+			ts.tv_nsec = (end_ns - now) % 1000000000;
+			tp = &ts;
 		}
+		syscall(SYS_futex, &lock->park, FUTEX_WAIT_PRIVATE, 1, tp, NULL, 0);
+	}
+	return 0;
+}
 
-		//null ϶ Ʈ  ̵
-		tmp = tmp->next;
+void lock_wake(lock_t * lock)
+{
+	__atomic_store_n(&lock->park, 0, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &lock->park, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+//lock이 깨워질때까지 잔다 (latch는 잡은 채로 돌아온다)
+//latch를 놓고 futex에서 자므로 깨운 쪽이 latch를 놓기 전에 깨어나도 latch에서 다시 재워지지 않는다
+//detector가 victim으로 골랐거나 lock_timeout_ms 동안 깨워지지 않으면 ABORT
+static int lock_sleep(pthread_mutex_t * latch, lock_t * lock)
+{
+	uint64_t end_ns = b_opt.lock_timeout_ms > 0 ? stat_ns() + (uint64_t)b_opt.lock_timeout_ms * 1000000 : 0;
+	while (lock->sleep) {
+		if (lock->victim) return ABORT;
+		__atomic_store_n(&lock->park, 1, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(latch);
+		int timeout = lock_park(lock, end_ns);
+		stat_latch(latch, STAT_LOCK_LATCH);
+		if (timeout && lock->sleep) return ABORT;
 	}
-//hashPrint(hash_t);
+	return SUCCESS;
+}
 
-//ش trx lockƮ Ŵ޾ش.
-	
-	
+//table 전체를 S/X로 잡은 trx(no_lock이면 모든 trx)가 record lock 대신 돌려받는 lock, lock list에는 없다
+static __thread lock_t lock_covered;
 
-	//̹  ش ڵ忡  lock  ִµ ׵ڷ ٷ    deadlock x
-	// ׳  θ 
+//trx가 table_id에 받아둔 table lock mode, 같은 mode면 table latch 없이 넘어간다
+//자기 쓰레드의 리스트만 보므로 latch가 필요없다
+static int tlock_held(Trx * t, int table_id)
+{
+	for (tlock_t * e = t->tlock_head; e; e = e->trx_next_lock)
+		if (e->table_id == table_id) return e->held;
+	return TLOCK_NONE;
+}
 
-	if (new_lock->lock_mode == 0) {//S
-		//տ ƹ    ʿ 
-//printf("my mode is S and my pre lock's lock mode is %d and trx_id=%d\n",new_lock->pre->sleep,new_lock->pre->owner_txn_id);
-	
-		//տ ִµ
-		 if (new_lock->pre->pre!=NULL&&(new_lock->pre->sleep||new_lock->pre->lock_mode ==1))// ڰְų ִµ E϶ ش 
-		{
+//record lock 전에 부른다, 이 trx의 table lock이 record를 덮으면 1
+//필요한 intention lock(S는 IS, X는 IX)을 받았거나 이미 있으면 0, 기다리다 abort되면 ABORT
+static int lock_table_intent(int table_id, int trx_id, int lock_mode)
+{
+	if (table_id < 1) return 0;
+	Trx * t = trx_get(trx_id);
+	if (!t) return 0;
+
+	int held = tlock_held(t, table_id);
+	if (held == TLOCK_X || (lock_mode == 0 && (held == TLOCK_S || held == TLOCK_SIX))) return 1;
+	int need = lock_mode ? TLOCK_IX : TLOCK_IS;
+	if (tlock_sup[held][need] == held) return 0;
+	return lock_table(table_id, trx_id, need) == ABORT ? ABORT : 0;
+}
 
-			dead_tmp=new_lock->pre;
-			new_lock->sleep = 1;
-			ch=checkDead(dead_tmp, new_lock->owner_txn_id);
-			
+int lock_busy(int table_id, int64_t key)
+{
+	pthread_once(&lock_table_once, lock_table_init_once);
+	pthread_mutex_t * latch = hashLatch(hash_t, table_id, key);
+	stat_latch(latch, STAT_LOCK_LATCH);
+	Node * find = hashSearch(hash_t, table_id, key);
+	//head, tail 사이에 lock이 있거나 fast S가 있는지
+	int busy = find && ((find->head->next && find->head->next->next != NULL) || lock_fast_other(find, 0));
+	pthread_mutex_unlock(latch);
+	return busy;
+}
 
-			//  abort Ǵ failȲ ߻
-			
-			if (ch == ABORT) {
-				lock_release(new_lock);
-				pthread_mutex_unlock(&lock_table_latch);
-				//printf("lock acquire : mutex unlock - ABORT finish\n");
-				return NULL;
-			}
+//lock_mode 0=S 1=X, trx는 record마다 lock을 하나만 갖고 S를 가진채 X를 부르면 그 lock을 X로 바꾼다
+lock_t* lock_acquire(int table_id, int64_t key, int trx_id, int lock_mode)
+{
+//printf("\nlock acquire start - lock/ table id = %d,key = %ld, trx id=%d,mode=%d\n",table_id,key,trx_id,lock_mode);
 
+	pthread_once(&lock_table_once, lock_table_init_once);
+	if (b_opt.no_lock) return &lock_covered;
+
+	//이 trx가 이미 받아둔 lock이면 latch 없이 돌려준다 (mode는 이 쓰레드만 올린다)
+	lock_cache_t * c = lock_cache_get(table_id, key);
+	int hit = c->node && c->node->table_id == table_id && c->node->record_id == key;
+	if (hit && c->trx_id == trx_id && c->lock->owner_txn_id == trx_id && c->lock->node_ptr == c->node
+		&& c->lock->lock_mode >= lock_mode) return c->lock;
+
+	int cover = lock_table_intent(table_id, trx_id, lock_mode);
+	if (cover == ABORT) return NULL;
+	if (cover) return &lock_covered;
+
+	//줄이 비어있으면 S는 latch 없이 fast 자리로 받는다
+	if (hit && lock_mode == 0) {
+		lock_t * lock = lock_fast_get(c->node, trx_id);
+		if (lock) {
+			c->lock = lock;
+			c->trx_id = trx_id;
+			return lock;
+		}
+	}
 
-			t_c=trx_lock(trx_id, new_lock);
-			
-			
-			//printf("cond wait...please sleep\n");
-			
+	//노드가 많아졌으면 bucket 하나를 나눈다 (linear hashing, 조금씩 늘린다)
+	if (__atomic_load_n(&hash_t->node_num, __ATOMIC_RELAXED) > (int64_t)LOAD_FACTOR * __atomic_load_n(&hash_t->size, __ATOMIC_RELAXED))
+		hashSplit(hash_t);
 
-			//printTrx();
-	//for(int i=0;i<15;i++){
-	//show_lock_list(i,1);
-	//}
-			//ch=pthread_cond_wait(&new_lock->cond, &lock_table_latch);
-			
-		
-			//printf("cond wake!... continue the function\n");
-			
+	//key가 속한 stripe의 latch만 잡는다
+	pthread_mutex_t * latch = hashLatch(hash_t, table_id, key);
+	stat_latch(latch, STAT_LOCK_LATCH);
+
+	//현재테이블에 해당레코드를 가진 노드가 존재하지 않는다면
+	//해시테이블에 노드를 추가해준후 락 리스트에 달아준다
+	Node* find = hashSearch(hash_t, table_id,key);
+	if(!find) {
+		hashInsert(hash_t, table_id, key);
+		find = hashSearch(hash_t, table_id, key);
+	}
+	c->node = find;
+	//줄에 lock이 생기므로 fast 자리를 닫는다, 이미 자리를 가진 trx는 받은 S로 본다
+	if (!find->closed) __atomic_store_n(&find->closed, 1, __ATOMIC_SEQ_CST);
+
+	//이 trx가 이미 잡은 lock
+	lock_t * lock = NULL;
+	for (lock_t * t = find->head->next; t && t->next != NULL; t = t->next) {
+		if (t->owner_txn_id == trx_id) {
+			lock = t;
+			break;
 		}
-		else{
-			//printf("S mode : only S lock - not sleep\n");
-			t_c=trx_lock(trx_id, new_lock);
-			
-			
+	}
+
+	if (lock) {
+		//S가 필요하거나 이미 X면 원래 잡힌걸 쓰면됨
+		if (lock->lock_mode >= lock_mode) {
+			pthread_mutex_unlock(latch);
+			c->lock = lock;
+			c->trx_id = trx_id;
+			return lock;
 		}
-		  
-	}
-	else if (new_lock->lock_mode == 1) {//E
-			//տ ƹ    ʿ 
-//printf("my mode is E\n");
-		if (new_lock->pre->pre == NULL) {
-			//printf("E mode : one lock - not sleep\n");
-			t_c=trx_lock(trx_id, new_lock);
-			
-			
+		//S -> X, 받아둔 S는 그대로 잡은 채 자리에서 mode만 바꾼다
+		lock->lock_mode = 1;
+		lock->upgrade = 1;
+	}
+	else {
+		//새 락 오브젝트 생성 및 초기화
+		//pool에서 꺼내므로 park는 이미 0이다
+		lock = lock_alloc();
+		lock->lock_mode = lock_mode;
+		lock->owner_txn_id = trx_id;
+		lock->sleep = 0;
+		lock->victim = 0;
+		lock->upgrade = 0;
+		lock->change = 0;
+		lock->fast = 0;
+		lock->node_ptr = find;
+
+		//락 리스트 끝에 붙인다
+		if (find->head->next == NULL) {
+			lock->pre = find->head;
+			find->head->next = lock;
 		}
-		//տ  
 		else {
-			dead_tmp=new_lock->pre;
+			lock->pre = find->tail->pre;
+			lock->pre->next = lock;
+		}
+		lock->next = find->tail;
+		find->tail->pre = lock;
 
-				new_lock->sleep = 1;
-				ch=checkDead(dead_tmp, new_lock->owner_txn_id);
-			
-			//  abort Ǵ failȲ ߻
-				
-				if (ch == ABORT) {
-					lock_release(new_lock);
-					pthread_mutex_unlock(&lock_table_latch);
-					//printf("lock acquire : mutex unlock -ABORT finish\n");
-					return NULL;
-				}
-
-				t_c=trx_lock(trx_id, new_lock);
-				
-				
-				
-			//printf("cond wait...please sleep\n");
+		//해당 trx의 lock리스트에 매달아준다, 기다리다 abort되면 abort가 같이 풀어준다
+		trx_lock(trx_id, lock);
+	}
 
-			//printTrx();
-	//for(int i=0;i<15;i++){
-	//show_lock_list(i,1);
-	//}
-			
-			while(new_lock->sleep){
-				ch=pthread_cond_wait(&new_lock->cond, &lock_table_latch);
-			}
-			//printf("E:cond wait result , ch=%d\n",ch);
-			//printf("cond wake!... continue the function\n");
-		}
+	c->lock = lock;
+	c->trx_id = trx_id;
+	if (lock_grantable(lock)) {
+		lock->upgrade = 0;
+		pthread_mutex_unlock(latch);
+		return lock;
 	}
-	
 
+	//앞에 누가 있으면 재운다, 데드락 감지시 abort
+	lock->sleep = 1;
+	lock->victim = 0;
+	uint64_t wait_ns = stat_ns();
+	if (lock_wait_check(latch, lock) == ABORT) {
+		stat_lock_wait(wait_ns);
+		TRACE(TRACE_LOCK_WAIT, wait_ns, table_id, key);
+		stat_lock_abort(1);
+		trx_abort(trx_id);
+		return NULL;
+	}
+	if (lock_sleep(latch, lock) == ABORT) {
+		stat_lock_wait(wait_ns);
+		TRACE(TRACE_LOCK_WAIT, wait_ns, table_id, key);
+		stat_lock_abort(lock->victim);
+		pthread_mutex_unlock(latch);
+		trx_abort(trx_id);
+		return NULL;
+	}
+	stat_lock_wait(wait_ns);
+	TRACE(TRACE_LOCK_WAIT, wait_ns, table_id, key);
 
-	
+	//뮤텍스 언락
+	pthread_mutex_unlock(latch);
+	trx_wait_clear(trx_id);
+	return lock;
+}
 
 
-	//ؽ 
+//lock_release가 lock을 뺀 뒤, 줄 앞에서부터 받을 수 있는 자던 lock들(grant group)을 한번에 깨운다
+//lock_grantable과 같은 규칙을 수로 센다, 앞의 lock은 기다리는 중이라도 막고 뒤의 lock은 받은 것(upgrade 중이면 S)만 막는다
+//받을 수 없는 자던 lock이 나오면 그 뒤는 모두 그 lock에 막히므로 거기서 멈춘다
+static void lock_grant(Node * node)
+{
+	//줄 전체에서 받은 S, X 수 (fast 자리는 X를 받을때 따로 본다)
+	int gs = 0, gx = 0;
+	for (lock_t * t = node->head->next; t && t->next != NULL; t = t->next) {
+		if (!t->sleep) {
+			if (t->lock_mode == 1) gx++;
+			else gs++;
+		}
+		else if (t->upgrade) gs++;
+	}
 
-	pthread_mutex_unlock(&lock_table_latch);
-//printf("lock acquire : mutex unlock - finish\n");
-	return new_lock;
+	//as/ax : 앞의 모든 lock, ags/agx : 앞의 받은 lock
+	int as = 0, ax = 0, ags = 0, agx = 0;
+	for (lock_t * t = node->head->next; t && t->next != NULL; t = t->next) {
+		int cs = t->sleep ? t->upgrade : t->lock_mode == 0;
+		int cx = !t->sleep && t->lock_mode == 1;
+		if (t->sleep) {
+			int bs = gs - ags - cs, bx = gx - agx;
+			if (t->lock_mode == 1 ? as + ax + bs + bx > 0 || lock_fast_other(node, t->owner_txn_id) : ax + bx > 0) break;
+			t->sleep = 0;
+			t->upgrade = 0;
+			lock_wake(t);
+		}
+		if (t->lock_mode == 1) ax++;
+		else as++;
+		ags += cs;
+		agx += cx;
+	}
 }
 
-
-//ִ°͵  -> ѹ S ٱ° ߰
-// S  Sε  ޾  E  ϳ  ɵ
+//stripe latch를 잡은채로 부른다
+//lock을 뺀 뒤 자던 lock들 중에 이제 받을 수 있는 것을 앞에서부터 깨운다 (같이 받을 수 있는 S는 한번에 깨어난다)
 int lock_release(lock_t* lock_obj)
 {
+	if (lock_obj->lock_mode != 0 && lock_obj->lock_mode != 1) return FAIL;
 
-	// Ʈ ش
-	//ũ Ʈ 
-	if (!hash_t)init_lock_table();
+	//락 리스트에서 제거해준다
+	//링크드 리스트 수정
 	if(lock_obj->pre->pre==NULL&&lock_obj->next->next==NULL){
 	lock_obj->pre->next = NULL;
 	lock_obj->next->pre = NULL;
+	//줄이 비었으므로 다시 fast S를 준다
+	__atomic_store_n(&lock_obj->node_ptr->closed, 0, __ATOMIC_RELEASE);
 	}
 	else{
 	lock_obj->pre->next = lock_obj->next;
 	lock_obj->next->pre = lock_obj->pre;
 	}
 
-	
-	//ڽ  Sε ڿ ڰ ְ װ W϶ Wϳ 
-	if (lock_obj->lock_mode == 0&& lock_obj->pre->pre == NULL && lock_obj->next->next != NULL && lock_obj->next->lock_mode == 1) {
-		//printf("only S mode : wake one E lock\nE-signal!!\n");
-		pthread_cond_signal(&lock_obj->next->cond);
-		lock_obj->next->sleep=0;
-	}
-	//ڽ E
-	else if (lock_obj->lock_mode == 1) {
-		//ڰ ִµ װ S϶ S ε 
-		if (lock_obj->next->next != NULL && lock_obj->next->lock_mode == 0) {
-			//printf("E mode : wake all S locks\n");
-			lock_t * tmp = lock_obj->next;
-
-			//S ε  (ΰ  x)
-			while (tmp->lock_mode == 0 && tmp->next != NULL) {
-				//printf("S-signal!!-tmp's owner=%d ",tmp->owner_txn_id);
-				pthread_cond_signal(&tmp->cond);
-				tmp->sleep=0;
-				tmp = tmp->next;
+	lock_grant(lock_obj->node_ptr);
+
+	lock_free(lock_obj);
+
+	return SUCCESS;
+}
+
+//trx의 lock list를 차례로 푼다, lock마다 그 노드의 stripe latch를 잡는다
+void lock_release_all(lock_t * head)
+{
+	while (head) {
+		lock_t * next = head->trx_next_lock;
+		if (head->fast) {
+			lock_fast_put(head->node_ptr, head->fast - 1);
+			lock_free(head);
+			head = next;
+			continue;
+		}
+		pthread_mutex_t * latch = head->node_ptr->latch;
+		stat_latch(latch, STAT_LOCK_LATCH);
+		lock_release(head);
+		pthread_mutex_unlock(latch);
+		head = next;
+	}
+}
+
+
+//////////////
+//TABLE LOCK//
+//////////////
+
+//table마다 queue 하나, record lock과 같이 먼저 온 것이 앞에 있다
+typedef struct TableLock {
+	pthread_mutex_t latch;//queue와 그 안의 tlock_t를 보호
+	tlock_t * head;
+	tlock_t * tail;
+}TableLock;
+
+static TableLock tlock_table[TLOCK_TABLE] = { [0 ... TLOCK_TABLE - 1] = { .latch = PTHREAD_MUTEX_INITIALIZER } };
+
+//tlock_compat[받은 mode][부른 mode], 다른 trx끼리 같이 잡을 수 있으면 1
+static const int tlock_compat[6][6] = {
+	{ 1, 1, 1, 1, 1, 1 },//NONE
+	{ 1, 1, 1, 1, 1, 0 },//IS
+	{ 1, 1, 1, 0, 0, 0 },//IX
+	{ 1, 1, 0, 1, 0, 0 },//S
+	{ 1, 1, 0, 0, 0, 0 },//SIX
+	{ 1, 0, 0, 0, 0, 0 },//X
+};
+
+//tlock_sup[a][b], a와 b를 둘다 덮는 가장 약한 mode (IX + S = SIX)
+const int tlock_sup[6][6] = {
+	{ TLOCK_NONE, TLOCK_IS, TLOCK_IX, TLOCK_S, TLOCK_SIX, TLOCK_X },
+	{ TLOCK_IS, TLOCK_IS, TLOCK_IX, TLOCK_S, TLOCK_SIX, TLOCK_X },
+	{ TLOCK_IX, TLOCK_IX, TLOCK_IX, TLOCK_SIX, TLOCK_SIX, TLOCK_X },
+	{ TLOCK_S, TLOCK_S, TLOCK_SIX, TLOCK_S, TLOCK_SIX, TLOCK_X },
+	{ TLOCK_SIX, TLOCK_SIX, TLOCK_SIX, TLOCK_SIX, TLOCK_SIX, TLOCK_X },
+	{ TLOCK_X, TLOCK_X, TLOCK_X, TLOCK_X, TLOCK_X, TLOCK_X },
+};
+
+//trx는 자기 쓰레드에서 commit/abort하므로 table lock은 잡은 쓰레드로 돌아온다, cond는 한번만 초기화
+static __thread tlock_t * tlock_pool;
+
+static tlock_t * tlock_alloc(void)
+{
+	tlock_t * e = tlock_pool;
+	if (e) {
+		tlock_pool = e->trx_next_lock;
+		return e;
+	}
+	e = (tlock_t*)db_obj_alloc(DB_OBJ_TLOCK, sizeof(struct tlock_t));
+	if (e) pthread_cond_init(&e->cond, NULL);
+	return e;
+}
+
+//record lock의 lock_blocks와 같다, 뒤에서 upgrade 중인 lock은 받아둔 held만 막는다
+//queue에는 다른 table의 lock도 섞여있다
+static int tlock_blocks(tlock_t * e, tlock_t * o, int behind)
+{
+	if (o->owner_txn_id == e->owner_txn_id || o->table_id != e->table_id) return 0;
+	int m = behind && o->sleep ? o->held : o->mode;
+	return !tlock_compat[m][e->mode];
+}
+
+static int tlock_grantable(tlock_t * e)
+{
+	for (tlock_t * t = e->pre; t; t = t->pre)
+		if (tlock_blocks(e, t, 0)) return 0;
+	for (tlock_t * t = e->next; t; t = t->next)
+		if (tlock_blocks(e, t, 1)) return 0;
+	return 1;
+}
+
+//e를 막는 trx들로 deadlock 검사, table latch를 놓고 검사한 뒤 다시 잡는다
+//upgrade(held가 있을때)는 lock_wait_check처럼 뒤에서 자던 trx의 간선에 자신을 더한다
+static int tlock_check(TableLock * tl, tlock_t * e)
+{
+	id_list w, up;
+	id_init(&w);
+	id_init(&up);
+	for (tlock_t * t = e->pre; t; t = t->pre)
+		if (tlock_blocks(e, t, 0)) id_push(&w, t->owner_txn_id);
+	for (tlock_t * t = e->next; t; t = t->next) {
+		if (tlock_blocks(e, t, 1)) id_push(&w, t->owner_txn_id);
+		else if (e->held != TLOCK_NONE && t->sleep && t->table_id == e->table_id && t->owner_txn_id != e->owner_txn_id) id_push(&up, t->owner_txn_id);
+	}
+	pthread_mutex_unlock(&tl->latch);
+
+	if (up.num > 0) trx_wait_add(up.ids, up.num, e->owner_txn_id);
+	int ch = checkDead(e->owner_txn_id, w.ids, w.num);
+	id_free(&w);
+	id_free(&up);
+	stat_latch(&tl->latch, STAT_LOCK_LATCH);
+	return ch;
+}
+
+static void tlock_deadline(struct timespec * ts, int ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+	ts->tv_nsec += (long)ms * 1000000;
+	ts->tv_sec += ts->tv_nsec / 1000000000;
+	ts->tv_nsec %= 1000000000;
+}
+
+//e가 깨워질때까지 잔다, table latch를 잡고 부른다
+//detector는 record lock만 깨우므로 detector 모드에서는 dead_ms마다 스스로 다시 검사한다
+static int tlock_wait(TableLock * tl, tlock_t * e)
+{
+	struct timespec end = { 0, 0 }, ts;
+	if (b_opt.lock_timeout_ms > 0) tlock_deadline(&end, b_opt.lock_timeout_ms);
+	while (e->sleep) {
+		if (tlock_check(tl, e) == ABORT) {
+			stat_lock_abort(1);
+			return ABORT;
+		}
+		if (!e->sleep) break;
+
+		int timed = b_opt.lock_timeout_ms > 0 || b_opt.dead_ms > 0;
+		ts = end;
+		if (b_opt.dead_ms > 0) {
+			tlock_deadline(&ts, b_opt.dead_ms);
+			if (b_opt.lock_timeout_ms > 0 && (ts.tv_sec > end.tv_sec || (ts.tv_sec == end.tv_sec && ts.tv_nsec > end.tv_nsec))) ts = end;
+		}
+		if (!timed) pthread_cond_wait(&e->cond, &tl->latch);
+		else if (pthread_cond_timedwait(&e->cond, &tl->latch, &ts) == ETIMEDOUT && e->sleep && b_opt.lock_timeout_ms > 0) {
+			struct timespec now;
+			clock_gettime(CLOCK_REALTIME, &now);
+			if (now.tv_sec > end.tv_sec || (now.tv_sec == end.tv_sec && now.tv_nsec >= end.tv_nsec)) {
+				stat_lock_abort(0);
+				return ABORT;
 			}
-			printf("\n");
 		}
+	}
+	return SUCCESS;
+}
 
-		//ڰ ִµ E ΰ ϳ .
-		else if(lock_obj->next->next != NULL && lock_obj->next->lock_mode == 1) {
-			//printf("E mode : wake one W lock, W-signal!!\n");
-			pthread_cond_signal(&lock_obj->next->cond);
-			lock_obj->next->sleep=0;
+int lock_table(int table_id, int trx_id, int mode)
+{
+	if (table_id < 1 || mode <= TLOCK_NONE || mode > TLOCK_X) return FAIL;
+	Trx * t = trx_get(trx_id);
+	if (!t || t->snap >= 0) return FAIL;
+	if (b_opt.no_lock) return SUCCESS;
+
+	int held = tlock_held(t, table_id);
+	int want = tlock_sup[held][mode];
+	if (want == held) return SUCCESS;
+
+	TableLock * tl = &tlock_table[table_id % TLOCK_TABLE];
+	stat_latch(&tl->latch, STAT_LOCK_LATCH);
+
+	//이미 잡은 table lock이 있으면 그 자리에서 mode만 올린다
+	tlock_t * e;
+	for (e = tl->head; e; e = e->next)
+		if (e->owner_txn_id == trx_id && e->table_id == table_id) break;
+	if (!e) {
+		e = tlock_alloc();
+		if (!e) {
+			pthread_mutex_unlock(&tl->latch);
+			return FAIL;
 		}
+		e->table_id = table_id;
+		e->owner_txn_id = trx_id;
+		e->held = TLOCK_NONE;
+		e->sleep = 0;
+		e->next = NULL;
+		e->pre = tl->tail;
+		if (tl->tail) tl->tail->next = e;
+		else tl->head = e;
+		tl->tail = e;
+		e->trx_next_lock = t->tlock_head;
+		t->tlock_head = e;
 	}
-	else if(lock_obj->lock_mode!=0&&lock_obj->lock_mode!=1){
-	
-		return FAIL;
+	e->mode = want;
+
+	int ch = SUCCESS, waited = 0;
+	if (!tlock_grantable(e)) {
+		e->sleep = 1;
+		waited = 1;
+		uint64_t wait_ns = stat_ns();
+		ch = tlock_wait(tl, e);
+		stat_lock_wait(wait_ns);
+		TRACE(TRACE_LOCK_WAIT, wait_ns, table_id, -1);
 	}
+	if (ch == SUCCESS) {
+		e->held = want;
+	}
+	pthread_mutex_unlock(&tl->latch);
 
+	if (waited) trx_wait_clear(trx_id);
+	if (ch == ABORT) {
+		//e는 trx의 table lock 리스트에 있으므로 abort가 같이 풀어준다
+		trx_abort(trx_id);
+		return ABORT;
+	}
+	return SUCCESS;
+}
 
-	free(lock_obj);
-//hashPrint(hash_t);
+void lock_table_release_all(tlock_t * head)
+{
+	while (head) {
+		tlock_t * next = head->trx_next_lock;
+		TableLock * tl = &tlock_table[head->table_id % TLOCK_TABLE];
+		stat_latch(&tl->latch, STAT_LOCK_LATCH);
+		if (head->pre) head->pre->next = head->next;
+		else tl->head = head->next;
+		if (head->next) head->next->pre = head->pre;
+		else tl->tail = head->pre;
+
+		for (tlock_t * t = tl->head; t; t = t->next) {
+			if (t->sleep && tlock_grantable(t)) {
+				t->sleep = 0;
+				pthread_cond_signal(&t->cond);
+			}
+		}
+		pthread_mutex_unlock(&tl->latch);
 
-	return SUCCESS;
+		head->trx_next_lock = tlock_pool;
+		tlock_pool = head;
+		head = next;
+	}
+}
+
+int lock_table_busy(int table_id)
+{
+	TableLock * tl = &tlock_table[table_id % TLOCK_TABLE];
+	int busy = 0;
+	stat_latch(&tl->latch, STAT_LOCK_LATCH);
+	for (tlock_t * t = tl->head; t && !busy; t = t->next)
+		busy = (t->table_id == table_id);
+	pthread_mutex_unlock(&tl->latch);
+	return busy;
 }
 
 
@@ -449,7 +849,7 @@ printf("cant find\n");
 
 HashTable * createHashTable(int size){
 //printf("\ncreate table start\n");
-	//ؽ̺ ü  Ҵ
+	//해쉬테이블 구조체 공간 할당
 	HashTable* hash_t;
 	hash_t=(HashTable*)malloc(sizeof(struct HashTable));
 
@@ -458,47 +858,80 @@ printf("create error : memory allocation fail - 1\n");
 		return NULL;
 	}
 
-	//̺ ü    Ҵ
+	//처음 bucket 수는 stripe 수로 맞춘다 (split된 bucket이 원래 bucket과 같은 latch를 쓰도록)
+	if (size != LOCK_STRIPE) size = LOCK_STRIPE;
+
+	//segment 배열은 처음에 다 잡아두고, segment는 split이 닿을때 만든다
 	hash_t->size = size;
-	hash_t->table = (HashNode**)malloc(sizeof(struct HashNode*)*size);
+	hash_t->state = 0;
+	hash_t->node_num = 0;
+	hash_t->table = (HashNode**)calloc(LOCK_MAX_SEGMENT, sizeof(struct HashNode*));
 
 	if (!hash_t->table) {
 //printf("create error : memeory allocation fail -2\n");
 		return NULL;
 	}
 
-	// ̺Ϳ hashnode Ҵ   ʱȭ
-	for (int i = 0; i < size; i++)
+	//각 bucket 값 초기화
+	for (int s = 0; s * LOCK_SEGMENT < size; s++)
 	{
-		hash_t->table[i] = (HashNode *)malloc(sizeof(struct HashNode));
-		if (!hash_t->table[i]) {
+		hash_t->table[s] = (HashNode *)calloc(LOCK_SEGMENT, sizeof(struct HashNode));
+		if (!hash_t->table[s]) {
 //printf("create error : memeory allocation fail -3\n");
 			return NULL;
 		}
 
-		//3 ʱȭ clear
-		hash_t->table[i]->key = i;
-		hash_t->table[i]->node_num = 0;
-		hash_t->table[i]->nodeList = NULL;
-
+		//3개 초기화 clear
+		for (int i = 0; i < LOCK_SEGMENT; i++) {
+			hash_t->table[s][i].key = s * LOCK_SEGMENT + i;
+			hash_t->table[s][i].node_num = 0;
+			hash_t->table[s][i].nodeList = NULL;
+		}
 	}
 
+	pthread_mutex_init(&hash_t->split_latch, NULL);
+	for (int i = 0; i < LOCK_STRIPE; i++)
+		pthread_mutex_init(&hash_t->latch[i], NULL);
+
 //printf("hash table create complete\n");
 	return hash_t;
 }
 
+//bucket i, segment는 한번 만들면 옮기지 않으므로 latch 없이 찾아간다
+static HashNode * hashBucket(HashTable * hash_t, uint64_t i)
+{
+	HashNode * seg = __atomic_load_n(&hash_t->table[i / LOCK_SEGMENT], __ATOMIC_ACQUIRE);
+	return &seg[i % LOCK_SEGMENT];
+}
+
+//hash h가 지금 들어가는 bucket 번호, h의 stripe latch를 잡고 부른다
+//그 stripe의 split과는 겹치지 않으므로 state를 한번 읽은 값으로 충분하다
+static uint64_t hashAddr(HashTable * hash_t, uint64_t h)
+{
+	uint64_t st = __atomic_load_n(&hash_t->state, __ATOMIC_ACQUIRE);
+	uint64_t n = (uint64_t)LOCK_STRIPE << (st >> 32);
+	uint64_t b = h & (n - 1);
+	if (b < (st & 0xFFFFFFFFu)) b = h & (2 * n - 1);
+	return b;
+}
+
+pthread_mutex_t * hashLatch(HashTable * hash_t, int table_id, int64_t r_id)
+{
+	return &hash_t->latch[getKey(table_id, r_id) & (LOCK_STRIPE - 1)];
+}
+
 Node* hashSearch(HashTable * hash_t,int table_id,int64_t r_id){
 //printf("\nsearch start\n");
 	Node * tmp = NULL;
-	tmp = hash_t->table[getKey(r_id, hash_t->size)]->nodeList;
+	tmp = hashBucket(hash_t, hashAddr(hash_t, getKey(table_id, r_id)))->nodeList;
 //printf("search2\n");
-	//  帮Ʈ
+	//만약 빈 노드리스트라면
 	if (!tmp) {
 //printf("search null : empty node list\n");
 		return NULL;
 	}
 
-	//Ž 
+	//탐색 시작
 	while (tmp) {
 //printf("search3\n");
 		if (tmp->record_id == r_id && tmp->table_id==table_id) {
@@ -508,7 +941,7 @@ Node* hashSearch(HashTable * hash_t,int table_id,int64_t r_id){
 		tmp = tmp->next;
 	}
 
-	//Ž 
+	//탐색 실패
 //printf("search fail - not found\n");
 	return NULL;
 
@@ -518,27 +951,27 @@ Node* hashSearch(HashTable * hash_t,int table_id,int64_t r_id){
 int hashInsert(HashTable * hash_t, int table_id,int64_t r_id){
 //printf("\ninsert data start\n");
 	
-	//帮Ʈ Ű  
+	//노드리스트를 가리키는 포인터 갖고옴
 	HashNode* first;
-	first = hash_t->table[getKey(r_id, hash_t->size)];
+	first = hashBucket(hash_t, hashAddr(hash_t, getKey(table_id, r_id)));
 
-	//  帮Ʈ 
+	//그 포인터의 노드리스트를 가져옴
 	Node* tmp;
 	tmp = first->nodeList;
 
-	//  
-	Node *node = (Node*)malloc(sizeof(struct Node));
+	//삽입할 노드 생성
+	Node *node = node_alloc();
 	if (!node) {
 printf("Hashinsert error : memory alloc fail -1\n");
 		return FAIL;
 	}
 
-	//5ʱȭ clear
+	//5개초기화 clear
 	node->table_id = table_id;
 	node->record_id = r_id;
-	node->next = NULL;//
-	node->head = (lock_t*)malloc(sizeof(struct lock_t));// Ʈ 
-	node->tail = (lock_t*)malloc(sizeof(struct lock_t));// Ʈ 
+	node->next = NULL;//다음노드
+	node->latch = hashLatch(hash_t, table_id, r_id);
+	//head, tail(락 리스트 sentinel)은 node_alloc이 같이 잡아준다
 	
 	node->head->next = NULL;
 	node->head->pre = NULL;
@@ -547,25 +980,85 @@ printf("Hashinsert error : memory alloc fail -1\n");
 	node->tail->pre = NULL;
 
 
-	// 帮Ʈ ٸ ׳ nodeٷ 
+	//만약 노드리스트가 비었다면 그냥 node바로 삽입
 	if (!tmp) first->nodeList = node;
 
-	//尡 ߴٸ
+	//노드가 존재했다면
 	else {
 		Node* tmp2;
-		tmp2 = first->nodeList;//  ӽ 
-		first->nodeList = node;// տ 
-		node->next = tmp2;//ش ڿ ִ  
+		tmp2 = first->nodeList;//원래 노드 임시 저장
+		first->nodeList = node;//맨 앞에 삽입
+		node->next = tmp2;//해당 노드뒤에 원래있던 노드 연결
 	}
 
-	//  
+	//노드 개수 증가
 	first->node_num++;
+	__atomic_add_fetch(&hash_t->node_num, 1, __ATOMIC_RELAXED);
 
 //printf("insert data complete\n");
 	return SUCCESS;
 	
 }
 
+//split 차례의 bucket 하나를 그 bucket과 (bucket + LOCK_STRIPE << level)로 나눈다
+//노드가 bucket당 LOAD_FACTOR개를 넘었을때 stripe latch를 잡지 않은 쓰레드가 부르고, 누가 split중이면 그냥 돌아온다
+int hashSplit(HashTable * hash_t)
+{
+	if (pthread_mutex_trylock(&hash_t->split_latch) != 0) return FAIL;
+
+	uint64_t st = hash_t->state;
+	uint64_t level = st >> 32, split = st & 0xFFFFFFFFu;
+	uint64_t n = (uint64_t)LOCK_STRIPE << level;
+	uint64_t to = n + split;
+	if (to / LOCK_SEGMENT >= LOCK_MAX_SEGMENT ||
+		__atomic_load_n(&hash_t->node_num, __ATOMIC_RELAXED) <= (int64_t)LOAD_FACTOR * hash_t->size) {
+		pthread_mutex_unlock(&hash_t->split_latch);
+		return FAIL;
+	}
+
+	//새 bucket이 들어갈 segment, 다 만든 뒤에 보이게 한다
+	if (hash_t->table[to / LOCK_SEGMENT] == NULL) {
+		HashNode * seg = (HashNode *)calloc(LOCK_SEGMENT, sizeof(struct HashNode));
+		if (!seg) {
+			pthread_mutex_unlock(&hash_t->split_latch);
+			return FAIL;
+		}
+		for (int i = 0; i < LOCK_SEGMENT; i++) seg[i].key = (int)(to / LOCK_SEGMENT * LOCK_SEGMENT + i);
+		__atomic_store_n(&hash_t->table[to / LOCK_SEGMENT], seg, __ATOMIC_RELEASE);
+	}
+
+	//두 bucket은 아래 bit가 같으므로 stripe latch 하나로 충분하다
+	pthread_mutex_t * latch = &hash_t->latch[split & (LOCK_STRIPE - 1)];
+	stat_latch(latch, STAT_LOCK_LATCH);
+
+	HashNode * from = hashBucket(hash_t, split);
+	HashNode * dst = hashBucket(hash_t, to);
+	Node ** pp = &from->nodeList;
+	while (*pp) {
+		Node * tmp = *pp;
+		if ((getKey(tmp->table_id, tmp->record_id) & (2 * n - 1)) == to) {
+			*pp = tmp->next;
+			tmp->next = dst->nodeList;
+			dst->nodeList = tmp;
+			from->node_num--;
+			dst->node_num++;
+		}
+		else pp = &tmp->next;
+	}
+
+	split++;
+	if (split == n) {
+		level++;
+		split = 0;
+	}
+	__atomic_store_n(&hash_t->state, level << 32 | split, __ATOMIC_RELEASE);
+	__atomic_store_n(&hash_t->size, hash_t->size + 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(latch);
+	pthread_mutex_unlock(&hash_t->split_latch);
+	return SUCCESS;
+}
+
 
 
 
@@ -575,7 +1068,7 @@ int hashPrint(HashTable * hash_t){
 printf("\nprint hash table data\n");
 	for (int i = 0; i < hash_t->size; i++)
 	{
-		HashNode * first = hash_t->table[i];
+		HashNode * first = hashBucket(hash_t, i);
 		Node * tmp = first->nodeList;
 
 		printf("Key %d : \n",i);
@@ -600,9 +1093,17 @@ printf("\nprint hash table data\n");
 	return SUCCESS;
 }
 
-int getKey(int64_t r_id, int table_size) {
-
-	return r_id % table_size;
+//(table_id, record_id)를 같이 섞는 64bit hash (splitmix64의 finalizer)
+//아래 bit로 stripe와 bucket을 고르므로 연속된 key도 고르게 퍼져야 한다
+uint64_t getKey(int table_id, int64_t r_id) {
+
+	uint64_t x = (uint64_t)r_id + (uint64_t)table_id * 0x9E3779B97F4A7C15ull;
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
 }
 
 
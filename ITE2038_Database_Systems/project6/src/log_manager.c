@@ -1,296 +1,1612 @@
+#define _GNU_SOURCE//fallocate
 #include "log_manager.h"
 #include "buf_manager.h"
+#include <sched.h>
+#include <sys/uio.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+//recovery 진행 메세지, 메세지 파일이 없으면 버린다
+#define LOG_MSG(...) do { if (log_msg_fd > 0) dprintf(log_msg_fd, __VA_ARGS__); } while (0)
+
+static void log_ship_stop();
 
 int open_log(char * log_path)
 {
-	//  
+	//파일을 새로 생성
 	log_fd = open(log_path, O_RDWR | O_CREAT | O_EXCL, 0777);
-	if (log_fd > 0)return SUCCESS;
-	
-	//̹ Ǿִٸ ٽ о´.
-	log_fd = open(log_path, O_RDWR);
-	if (log_fd > 0) return SUCCESS;
+	int created = log_fd > 0;
 	
-	return FAIL;
+	//이미 생성되어있다면 다시 읽어온다.
+	if (log_fd <= 0) log_fd = open(log_path, O_RDWR);
+	if (log_fd <= 0) return FAIL;
+
+	//마지막 checkpoint 위치는 옆의 master 파일에 따로 둔다, 새 로그면 예전 master는 버린다
+	char master[300];
+	snprintf(master, sizeof(master), "%s.ckpt", log_path);
+	log_master_fd = open(master, O_RDWR | O_CREAT | (created ? O_TRUNC : 0), 0777);
+
+	return SUCCESS;
 }
 
 int open_msg_log(char *log_msg_path)
 {
-	//  
-	int fd = open(log_msg_path, O_RDWR | O_CREAT | O_EXCL, 0777);
-	if (fd > 0) return SUCCESS;
+	//파일을 새로 생성
+	log_msg_fd = open(log_msg_path, O_RDWR | O_CREAT | O_EXCL | O_APPEND, 0777);
+	if (log_msg_fd > 0) return SUCCESS;
 	
-	//̹ Ǿִٸ ٽ о´.
-	fd = open(log_msg_path, O_RDWR);
-	if (fd > 0) return SUCCESS;
+	//이미 생성되어있다면 다시 읽어온다, 메세지는 뒤에 이어서 남긴다
+	log_msg_fd = open(log_msg_path, O_RDWR | O_APPEND);
+	if (log_msg_fd > 0) return SUCCESS;
 
 	return FAIL;
 }
 
 int init_log_buf(int capacity)
 {
+	//capacity는 레코드 개수 기준, 가장 큰 레코드로 잡고 2의 거듭제곱으로 올린다
+	int64_t size = 1;
+	while (size < (int64_t)capacity * LOG_MAX_SIZE) size <<= 1;
+	log_M.ring_size = size;
+	log_M.ring = (char*)malloc(size);
+
+	//이미 있던 로그 파일이면 그 뒤에 이어서 쓴다 (LSN은 레코드 마지막 바이트의 offset)
+	off_t end = lseek(log_fd, 0, SEEK_END);
+	log_M.log_now = (end > 0) ? end - 1 : -1;
+	log_M.filled_LSN = log_M.log_now;
+
+	//group commit flusher
+	pthread_mutex_init(&log_M.latch, NULL);
+	pthread_cond_init(&log_M.flush_cond, NULL);
+	pthread_cond_init(&log_M.done_cond, NULL);
+	log_M.flush_req = log_M.log_now;
+	log_M.flushed_LSN = log_M.log_now;
+	log_M.elr_LSN = -1;
+	log_M.flush_round = 0;
+	log_M.flush_byte = 0;
+	pthread_cond_init(&log_M.ckpt_cond, NULL);
+	log_M.ckpt_run = 0;
+	log_M.ckpt_LSN = -1;
+	log_M.trunc_off = 0;
+	log_M.ckpt_num = 0;
+	log_M.ship_fd = -1;
+	log_M.ship_run = 0;
+	log_M.ship_num = 0;
+	for (int i = 0; i < SHIP_MAX; i++) {
+		log_M.ship_conn[i] = -1;
+		log_M.ship_off[i] = -1;
+	}
+	log_M.flusher_run = 1;
+	pthread_create(&log_M.flusher, NULL, log_flusher_func, NULL);
 
-	log_M.frame_capacity = capacity;
-	log_M.use_num = 0;
-	log_M.logRecords = (log_buffer_S*)calloc(capacity, sizeof(log_buffer_S));
-	
-	log_M.log_now=-1;
-	log_M.head = -1;
-	log_M.tail = -1;
+	return SUCCESS;
+}
 
-	for (int i = 0; i <capacity; i++)
-	{
-		log_M.logRecords[i].pre = -1;
-		log_M.logRecords[i].next = -1;
+//남은 로그를 다 내리고 flusher를 멈춘다
+int close_log()
+{
+	if (!log_M.flusher_run) return SUCCESS;
+
+	//replica에는 이미 내려간 로그만 보내므로 flusher보다 먼저 멈춘다
+	log_ship_stop();
+	pthread_mutex_lock(&log_M.latch);
+	if (log_M.ckpt_run) {
+		log_M.ckpt_run = 0;
+		pthread_cond_signal(&log_M.ckpt_cond);
+		pthread_mutex_unlock(&log_M.latch);
+		pthread_join(log_M.checkpointer, NULL);
+		pthread_mutex_lock(&log_M.latch);
+	}
+	log_M.flusher_run = 0;
+	pthread_cond_signal(&log_M.flush_cond);
+	pthread_mutex_unlock(&log_M.latch);
+	pthread_join(log_M.flusher, NULL);
+
+	free(log_M.ring);
+	close(log_fd);
+	if (log_master_fd > 0) close(log_master_fd);
+	return SUCCESS;
+}
 
+//size 바이트 자리를 잡고 그 레코드의 LSN(마지막 바이트 offset)을 돌려준다
+static int64_t log_reserve(int size)
+{
+	return __atomic_add_fetch(&log_M.log_now, size, __ATOMIC_ACQ_REL);
+}
 
+//잡아둔 자리에 레코드를 복사하고 filled_LSN을 넘겨준다
+//ring이 아직 안 내려간 로그로 차있으면 flusher가 비워줄때까지 기다린다
+static void log_put(const void * rec, int size, int64_t LSN)
+{
+	int64_t start = LSN + 1 - size;
+
+	if (LSN - __atomic_load_n(&log_M.flushed_LSN, __ATOMIC_ACQUIRE) > log_M.ring_size) {
+		pthread_mutex_lock(&log_M.latch);
+		while (LSN - log_M.flushed_LSN > log_M.ring_size) {
+			if (log_M.flush_req < start - 1) log_M.flush_req = start - 1;
+			pthread_cond_signal(&log_M.flush_cond);
+			pthread_cond_wait(&log_M.done_cond, &log_M.latch);
+		}
+		pthread_mutex_unlock(&log_M.latch);
+	}
+
+	//ring 끝에 걸치면 두번에 나눠서 복사
+	int64_t pos = start & (log_M.ring_size - 1);
+	int first = size;
+	if (pos + size > log_M.ring_size) first = (int)(log_M.ring_size - pos);
+	memcpy(log_M.ring + pos, rec, first);
+	if (first < size) memcpy(log_M.ring, (const char*)rec + first, size - first);
+
+	//앞 레코드가 다 복사된 뒤에 넘겨야 flusher가 빈 구간을 쓰지 않는다
+	while (__atomic_load_n(&log_M.filled_LSN, __ATOMIC_ACQUIRE) != start - 1)
+		sched_yield();
+	__atomic_store_n(&log_M.filled_LSN, LSN, __ATOMIC_RELEASE);
+}
+
+//LSN까지 디스크에 내려갈때까지 기다린다
+//동시에 commit하는 trx들은 flusher가 한번의 pwrite + fdatasync로 같이 내린다
+int log_flush(int64_t LSN)
+{
+	//page_LSN은 이전 파일에서 남은 값일 수 있으므로 자리가 잡힌 LSN까지만
+	int64_t now = __atomic_load_n(&log_M.log_now, __ATOMIC_ACQUIRE);
+	if (LSN > now) LSN = now;
+	if (LSN <= __atomic_load_n(&log_M.flushed_LSN, __ATOMIC_ACQUIRE)) return SUCCESS;
+
+	TRACE_START(t);
+	pthread_mutex_lock(&log_M.latch);
+	if (LSN > log_M.flush_req) {
+		log_M.flush_req = LSN;
+		pthread_cond_signal(&log_M.flush_cond);
 	}
+	while (log_M.flushed_LSN < LSN && log_M.flusher_run)
+		pthread_cond_wait(&log_M.done_cond, &log_M.latch);
+	pthread_mutex_unlock(&log_M.latch);
+	TRACE(TRACE_LOG_WAIT, t, LSN, 0);
 
 	return SUCCESS;
 }
 
-int log_to_file_BCR(int trx_id,int log_fd ,type_BCR * log) {
-	//α  α׷ڵ Ϸ ش.
-	off_t off = lseek(log_fd, log->LSN, SEEK_SET);
-	ch = write(log_fd, log, BCR_SIZE);
+//commit 로그 LSN을 elr_LSN에 올린다, 그 trx가 lock을 풀기 전에 부른다
+void log_elr(int64_t LSN)
+{
+	int64_t cur = __atomic_load_n(&log_M.elr_LSN, __ATOMIC_RELAXED);
+	while (cur < LSN && !__atomic_compare_exchange_n(&log_M.elr_LSN, &cur, LSN, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
 
+//요청이 오면 그때까지 ring에 복사된 구간 (flushed_LSN, filled_LSN]을 한번에 쓴다
+//쓰는 동안 들어온 요청은 다음 회차에 같이 내려간다
+void * log_flusher_func(void * arg)
+{
+	pthread_mutex_lock(&log_M.latch);
+	while (1) {
+		while (log_M.flusher_run && log_M.flush_req <= log_M.flushed_LSN)
+			pthread_cond_wait(&log_M.flush_cond, &log_M.latch);
+
+		int64_t end = __atomic_load_n(&log_M.filled_LSN, __ATOMIC_ACQUIRE);
+		if (end <= log_M.flushed_LSN) {
+			//자리만 잡고 복사중인 레코드가 있으면 잠깐 양보하고 다시 본다
+			if (!log_M.flusher_run && end == __atomic_load_n(&log_M.log_now, __ATOMIC_ACQUIRE)) break;
+			pthread_mutex_unlock(&log_M.latch);
+			sched_yield();
+			pthread_mutex_lock(&log_M.latch);
+			continue;
+		}
+		int64_t start = log_M.flushed_LSN + 1;
+		pthread_mutex_unlock(&log_M.latch);
+
+		//ring 끝에 걸친 구간은 두 조각을 한번에 쓴다
+		int64_t len = end + 1 - start;
+		int64_t pos = start & (log_M.ring_size - 1);
+		struct iovec iov[2];
+		int cnt = 1;
+		iov[0].iov_base = log_M.ring + pos;
+		iov[0].iov_len = len;
+		if (pos + len > log_M.ring_size) {
+			iov[0].iov_len = log_M.ring_size - pos;
+			iov[1].iov_base = log_M.ring;
+			iov[1].iov_len = len - iov[0].iov_len;
+			cnt = 2;
+		}
+		TRACE_START(t);
+		pwritev(log_fd, iov, cnt, start);
+		fdatasync(log_fd);
+		TRACE(TRACE_LOG_FLUSH, t, len, end);
+
+		pthread_mutex_lock(&log_M.latch);
+		__atomic_store_n(&log_M.flushed_LSN, end, __ATOMIC_RELEASE);
+		log_M.flush_round++;
+		log_M.flush_byte += len;
+		pthread_cond_broadcast(&log_M.done_cond);
+	}
+	pthread_mutex_unlock(&log_M.latch);
 
+	return NULL;
+}
 
-	return SUCCESS;
+void logFlushInfo()
+{
+	printf("\n<log flush info>\n");
+	printf("flushed LSN : %" PRId64 "\n", log_M.flushed_LSN);
+	printf("round : %" PRIu64 " / byte : %" PRIu64 "\n", log_M.flush_round, log_M.flush_byte);
+	printf("checkpoint : %" PRIu64 " / last LSN : %" PRId64 " / truncated : %" PRId64 "\n", log_M.ckpt_num, log_M.ckpt_LSN, log_M.trunc_off);
 }
 
-int log_to_file_UP(int trx_id, int log_fd, type_update * log) {
-	//α  α׷ڵ Ϸ ش.
-	off_t off = lseek(log_fd, log->LSN, SEEK_SET);
-	ch = write(log_fd, log,UP_SIZE);
+int log_BCR(int trx_id, int type)
+{
+	type_BCR log;
 
-	return SUCCESS;
+	log.log_size = BCR_SIZE;
+	log.trx_id = trx_id;
+	log.type = type;
+	
+	Trx* find = trx_get(trx_id);
+	//no_wal이면 lastLSN이 -1로 남아 abort의 undo도 아무것도 하지 않는다
+	if (b_opt.no_wal) return -1;
+
+	//lastLSN은 그 trx를 돌리는 쓰레드만 건드린다
+	log.pre_LSN = find->lastLSN;
+	log.LSN = log_reserve(BCR_SIZE);
+	find->lastLSN = log.LSN;
+	if (type == BEGIN) find->firstLSN = log.LSN;
+
+	log_put(&log, BCR_SIZE, log.LSN);
+	return log.LSN;
 }
 
-int log_to_file_COM(int trx_id, int log_fd, type_compen * log) {
-	//α  α׷ڵ Ϸ ش.
-	off_t off = lseek(log_fd, log->LSN, SEEK_SET);
-	ch = write(log_fd, log, COM_SIZE);
+//image의 k번째 바이트, 길이를 넘어가면 0
+static inline unsigned char log_image_at(const char * img, int len, int k)
+{
+	return k < len ? (unsigned char)img[k] : 0;
+}
 
-	return SUCCESS;
+//update/compensate/insert를 파일에 쓰는 모양(log_packed)으로 out에 만들고 크기를 돌려준다
+//image는 값 길이만큼만 담고, new image는 old와 다른 구간만 xor해서 담는 쪽이 짧으면 그렇게 한다
+//LSN은 크기를 알아야 자리를 잡을 수 있으므로 부른 쪽이 나중에 채운다
+static int log_pack(char * out, const type_compen * r)
+{
+	log_packed h;
+	memset(&h, 0, sizeof(h));
+	h.pre_LSN = r->pre_LSN;
+	h.trx_id = r->trx_id;
+	h.type = r->type;
+	h.table_id = r->table_id;
+	h.off = r->off;
+	h.page_num = r->page_num;
+	h.key = r->key;
+	h.old_len = (uint16_t)strnlen(r->old_image, LOG_IMAGE);
+	h.new_len = (uint16_t)strnlen(r->new_image, LOG_IMAGE);
+
+	int size = sizeof(h);
+	if (r->type == COMPENSATE || r->type == INSERT_CLR) {
+		memcpy(out + size, &r->next_undo_LSN, sizeof(int64_t));
+		size += sizeof(int64_t);
+	}
+	memcpy(out + size, r->old_image, h.old_len);
+	size += h.old_len;
+
+	//두 image가 다른 구간 [a, b)
+	int n = h.old_len > h.new_len ? h.old_len : h.new_len;
+	int a = 0, b = n;
+	while (a < b && log_image_at(r->old_image, h.old_len, a) == log_image_at(r->new_image, h.new_len, a)) a++;
+	while (b > a && log_image_at(r->old_image, h.old_len, b - 1) == log_image_at(r->new_image, h.new_len, b - 1)) b--;
+
+	if (!b_opt.log_full && b - a < h.new_len) {
+		h.d_off = (uint16_t)a;
+		h.d_len = (uint16_t)(b - a);
+		for (int k = a; k < b; k++)
+			out[size++] = (char)(log_image_at(r->old_image, h.old_len, k) ^ log_image_at(r->new_image, h.new_len, k));
+	}
+	else {
+		h.d_off = LOG_FULL;
+		memcpy(out + size, r->new_image, h.new_len);
+		size += h.new_len;
+	}
+
+	//뒤에서부터 읽을 수 있게 크기를 끝에 남긴다 (BCR의 log_size도 마지막 필드)
+	size += sizeof(int);
+	memcpy(out + size - sizeof(int), &size, sizeof(int));
+	memcpy(out, &h, sizeof(h));
+	return size;
 }
 
+//in에서 시작하는 레코드 하나를 rec에 풀고 크기를 돌려준다, avail 안에 온전히 없거나 모양이 틀리면 0
+//checkpoint end는 여기서 다루지 않는다
+static int log_decode(const char * in, int avail, log_rec * rec)
+{
+	type_BCR b;
+	if (avail < BCR_SIZE) return 0;
+	memcpy(&b, in, BCR_SIZE);
+
+	if (b.type == BEGIN || b.type == COMMIT || b.type == ROLLBACK || b.type == CKPT_BEGIN) {
+		if (b.log_size != BCR_SIZE) return 0;
+		memset(rec, 0, sizeof(log_rec));
+		rec->bcr = b;
+		return BCR_SIZE;
+	}
+	if (b.type != UPDATE && b.type != COMPENSATE && b.type != INSERT && b.type != INSERT_CLR) return 0;
+
+	log_packed h;
+	if (avail < (int)sizeof(h)) return 0;
+	memcpy(&h, in, sizeof(h));
+	if (h.old_len > LOG_IMAGE || h.new_len > LOG_IMAGE) return 0;
+	if (h.d_off != LOG_FULL && h.d_off + h.d_len > LOG_IMAGE) return 0;
+
+	int clr = h.type == COMPENSATE || h.type == INSERT_CLR;
+	int size = sizeof(h) + (clr ? sizeof(int64_t) : 0) + h.old_len
+		+ (h.d_off == LOG_FULL ? h.new_len : h.d_len) + sizeof(int);
+	int tail;
+	if (size > avail) return 0;
+	memcpy(&tail, in + size - sizeof(int), sizeof(int));
+	if (tail != size) return 0;
+
+	memset(rec, 0, sizeof(log_rec));
+	type_compen * r = &rec->compen;
+	r->LSN = h.LSN;
+	r->pre_LSN = h.pre_LSN;
+	r->trx_id = h.trx_id;
+	r->type = h.type;
+	r->table_id = h.table_id;
+	r->page_num = h.page_num;
+	r->key = h.key;
+	r->off = h.off;
+	r->data_len = h.new_len;
+
+	int at = sizeof(h);
+	if (clr) {
+		memcpy(&r->next_undo_LSN, in + at, sizeof(int64_t));
+		at += sizeof(int64_t);
+	}
+	memcpy(r->old_image, in + at, h.old_len);
+	at += h.old_len;
+	if (h.d_off == LOG_FULL) memcpy(r->new_image, in + at, h.new_len);
+	else {
+		memcpy(r->new_image, r->old_image, LOG_IMAGE);
+		for (int k = 0; k < h.d_len; k++) r->new_image[h.d_off + k] ^= in[at + k];
+		memset(r->new_image + h.new_len, 0, LOG_IMAGE - h.new_len);
+	}
 
+	if (clr) r->log_size = size;
+	else rec->update.log_size = size;
+	return size;
+}
 
+//pack한 레코드의 자리를 잡고 LSN을 채워 ring에 넣는다
+static int64_t log_put_packed(char * rec, int size, Trx * find)
+{
+	if (b_opt.no_wal) return -1;
+	int64_t LSN = log_reserve(size);
+	memcpy(rec, &LSN, sizeof(int64_t));
+	find->lastLSN = LSN;
+	log_put(rec, size, LSN);
+	return LSN;
+}
 
-int log_BCR(int trx_id, int type)
+//target(update 로그)를 되돌리는 compensate log
+int log_compensate(int trx_id, const type_update * target)
 {
-	type_BCR *log=(type_BCR*)malloc(sizeof(struct type_BCR));
-	if (!log) return FAIL;
+	type_compen log;
+	log.trx_id = trx_id;
+	log.type = COMPENSATE;
 
-	log->log_size = BCR_SIZE;
-	log->trx_id = trx_id;
-	log->type = type;
-	
-	Trx* find = trx_find(trx_id);
 
-	log->pre_LSN = find->lastLSN;
-	log_M.log_now += BCR_SIZE;
-	log->LSN = log_M.log_now;
-	find->lastLSN = log->LSN;
+	log.table_id = target->table_id;
+	log.page_num = target->page_num;
+	log.key = target->key;
+	log.off = target->off;
+	log.data_len = target->data_len;
 
-	//α ۿ ø ڸ ã´
-	int i;
-	for (i = 0; i < log_M.frame_capacity; i++)
-	{
-		if (log_M.logRecords[i].pre == -1 && log_M.logRecords[i].next == -1) {
-			break;
+	//이 log의 old가 new가 되고 new가 old가 된다
+	memcpy(log.old_image, target->new_image, sizeof(log.old_image));
+	memcpy(log.new_image, target->old_image, sizeof(log.new_image));
+
+	//되돌린 그 로그의 preLSN이 이 로그의 nextundoLSN으로 들어감
+	log.next_undo_LSN = target->pre_LSN;
+
+	Trx* find = trx_get(trx_id);
+	log.pre_LSN = find->lastLSN;
+
+	char rec[LOG_MAX_SIZE];
+	int size = log_pack(rec, &log);
+	return log_put_packed(rec, size, find);
+}
+
+int log_update(int trx_id, int table_id, int64_t page_num, int64_t key, char * old_image, char * new_image,int record_off)
+{
+	//update도 compensate와 같은 모양으로 pack한다 (next_undo_LSN만 쓰지 않음)
+	type_compen log;
+	log.trx_id = trx_id;
+	log.type = UPDATE;
+
+
+	log.table_id = table_id;
+	log.page_num = page_num;
+	log.key = key;
+	log.off = PAGE_HEADER + RECORD_SIZE * (record_off);
+	log.data_len = strnlen(new_image, LOG_IMAGE);
+	strncpy(log.old_image, old_image, LOG_IMAGE);
+	strncpy(log.new_image, new_image, LOG_IMAGE);
+
+	Trx* find = trx_get(trx_id);
+	log.pre_LSN = find->lastLSN;
+
+	char rec[LOG_MAX_SIZE];
+	int size = log_pack(rec, &log);
+	return log_put_packed(rec, size, find);
+}
+
+//write batch의 update n개를 log_update와 같은 모양으로 pack해서 자리는 한번에 잡는다
+//레코드마다의 LSN을 LSN[]에 채운다 (no_wal이면 -1), pre_LSN은 앞 레코드로 이어진다
+void log_update_batch(int trx_id, const wbatch_ent * e, int n, int64_t * LSN)
+{
+	if (b_opt.no_wal) {
+		for (int k = 0; k < n; k++) LSN[k] = -1;
+		return;
+	}
+	char * buf = (char*)malloc((size_t)n * LOG_MAX_SIZE);
+	int * size = (int*)malloc(sizeof(int) * n);
+	int total = 0;
+	type_compen log;
+	memset(&log, 0, sizeof(log));
+	log.trx_id = trx_id;
+	log.type = UPDATE;
+	for (int k = 0; k < n; k++) {
+		log.table_id = e[k].table_id;
+		log.page_num = e[k].page_num;
+		log.key = e[k].key;
+		log.off = PAGE_HEADER + RECORD_SIZE * e[k].off;
+		log.data_len = strnlen(e[k].new_image, LOG_IMAGE);
+		strncpy(log.old_image, e[k].old_image, LOG_IMAGE);
+		strncpy(log.new_image, e[k].new_image, LOG_IMAGE);
+		size[k] = log_pack(buf + total, &log);
+		total += size[k];
+	}
+
+	//크기를 다 안 뒤에 한번만 자리를 잡고 LSN/pre_LSN을 채운다
+	Trx* find = trx_get(trx_id);
+	int64_t end = log_reserve(total);
+	int64_t pre = find->lastLSN;
+	int64_t at = end - total;
+	char * p = buf;
+	for (int k = 0; k < n; k++) {
+		at += size[k];
+		memcpy(p + offsetof(log_packed, LSN), &at, sizeof(int64_t));
+		memcpy(p + offsetof(log_packed, pre_LSN), &pre, sizeof(int64_t));
+		LSN[k] = pre = at;
+		p += size[k];
+	}
+	find->lastLSN = end;
+	log_put(buf, total, end);
+	free(size);
+	free(buf);
+}
+
+//db_insert_trx의 logical insert, page_num은 넣을때 키가 들어갈 리프 (redo가 dpt로 거르는 페이지)
+int log_insert(int trx_id, int table_id, int64_t page_num, int64_t key, const char * value)
+{
+	type_compen log;
+	memset(&log, 0, sizeof(log));
+	log.trx_id = trx_id;
+	log.type = INSERT;
+	log.table_id = table_id;
+	log.page_num = page_num;
+	log.key = key;
+	log.data_len = strnlen(value, LOG_IMAGE);
+	strncpy(log.new_image, value, LOG_IMAGE);
+
+	Trx* find = trx_get(trx_id);
+	log.pre_LSN = find->lastLSN;
+
+	char rec[LOG_MAX_SIZE];
+	int size = log_pack(rec, &log);
+	return log_put_packed(rec, size, find);
+}
+
+//target(insert 로그)를 되돌리는 compensate, image 없이 키만 남긴다
+static int64_t log_insert_clr(int trx_id, const type_update * target)
+{
+	type_compen log;
+	memset(&log, 0, sizeof(log));
+	log.trx_id = trx_id;
+	log.type = INSERT_CLR;
+	log.table_id = target->table_id;
+	log.page_num = target->page_num;
+	log.key = target->key;
+	log.next_undo_LSN = target->pre_LSN;
+
+	Trx* find = trx_get(trx_id);
+	log.pre_LSN = find->lastLSN;
+
+	char rec[LOG_MAX_SIZE];
+	int size = log_pack(rec, &log);
+	return log_put_packed(rec, size, find);
+}
+
+//checkpoint끼리는 겹치지 않게 (checkpointer와 recovery 끝의 checkpoint)
+static pthread_mutex_t ckpt_latch = PTHREAD_MUTEX_INITIALIZER;
+
+//keep 레코드가 시작하는 곳 앞의 로그 파일 공간을 비운다
+//LSN이 파일 offset이므로 파일 크기는 그대로 두고 구멍만 낸다
+//아직 replica에 보내지 않은 로그는 남긴다, 새 replica가 그 사이 붙지 않게 latch 안에서 비운다
+static void log_truncate(int64_t keep)
+{
+	pthread_mutex_lock(&log_M.latch);
+	for (int i = 0; i < SHIP_MAX; i++)
+		if (log_M.ship_off[i] >= 0 && log_M.ship_off[i] + LOG_MAX_SIZE - 1 < keep) keep = log_M.ship_off[i] + LOG_MAX_SIZE - 1;
+	int64_t off = (keep + 1 - LOG_MAX_SIZE) & ~(int64_t)(PAGESIZE - 1);
+	if (off > log_M.trunc_off && fallocate(log_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, log_M.trunc_off, off - log_M.trunc_off) == 0)
+		log_M.trunc_off = off;
+	pthread_mutex_unlock(&log_M.latch);
+}
+
+//fuzzy checkpoint, trx를 멈추지 않고 begin을 남긴 뒤 active trx 표와 dirty page 표를 모아 end에 남긴다
+//end까지 디스크에 내려가면 master에 begin 위치를 쓰고, 더 이상 필요없는 앞쪽 로그 공간을 비운다
+int log_checkpoint()
+{
+	pthread_mutex_lock(&ckpt_latch);
+
+	type_BCR b;
+	b.pre_LSN = -1;
+	b.trx_id = 0;
+	b.type = CKPT_BEGIN;
+	b.log_size = BCR_SIZE;
+	b.LSN = log_reserve(BCR_SIZE);
+	//log_put은 앞의 레코드가 다 복사된 뒤에 끝나므로, 이제 begin 전 레코드의 lastLSN은 다 반영되어 있다
+	log_put(&b, BCR_SIZE, b.LSN);
+
+	//keep : 이 LSN의 레코드부터는 recovery가 다시 읽을 수 있다
+	int64_t keep = b.LSN;
+
+	//active transaction table, 로그를 남긴 trx만
+	int att_num = 0, att_cap = 16;
+	ckpt_att * att = (ckpt_att*)malloc(att_cap * sizeof(ckpt_att));
+	pthread_mutex_lock(&trx_latch);
+	Trx * t = T_M.trx_table_head ? T_M.trx_table_head->next : NULL;
+	for (; t && t != T_M.trx_table_tail; t = t->next) {
+		if (t->lastLSN < 0) continue;
+		if (att_num == att_cap) {
+			att_cap *= 2;
+			att = (ckpt_att*)realloc(att, att_cap * sizeof(ckpt_att));
 		}
+		att[att_num].trx_id = t->trx_id;
+		att[att_num].reserved = 0;
+		att[att_num].lastLSN = t->lastLSN;
+		att_num++;
+		//undo가 begin까지 되돌아가야 하므로 그 앞은 남긴다
+		if (t->firstLSN >= 0 && t->firstLSN < keep) keep = t->firstLSN;
+	}
+	int trx_max = (int)T_M.global_trx_id;
+	pthread_mutex_unlock(&trx_latch);
+
+	//dirty page table, 고치는 중인 프레임은 S latch로 기다렸다가 본다
+	//begin 전에 자리를 잡은 update는 X latch 안에서 rec_LSN까지 남기므로 빠지지 않는다
+	int dpt_num = 0, dpt_cap = 64;
+	ckpt_dpt * dpt = (ckpt_dpt*)malloc(dpt_cap * sizeof(ckpt_dpt));
+	for (int i = 0; i < b_M.frame_capacity; i++) {
+		buffer_S * f = &b_M.frameArray[i];
+		pageLatchShared(i);
+		if (f->table_id != 0 && f->page_num != 0 && f->isdirty && f->rec_LSN >= 0) {
+			if (dpt_num == dpt_cap) {
+				dpt_cap *= 2;
+				dpt = (ckpt_dpt*)realloc(dpt, dpt_cap * sizeof(ckpt_dpt));
+			}
+			dpt[dpt_num].table_id = f->table_id;
+			dpt[dpt_num].reserved = 0;
+			dpt[dpt_num].page_num = f->page_num;
+			dpt[dpt_num].rec_LSN = f->rec_LSN;
+			if (f->rec_LSN < keep) keep = f->rec_LSN;
+			dpt_num++;
+		}
+		pageUnlatch(i);
 	}
-	log_M.logRecords[i].frame_BCR = *log;
 
-	if (log_M.use_num == 0) {
-		log_M.logRecords[i].pre = HEAD;
-		log_M.logRecords[i].next = TAIL;
-		log_M.head = i;
-		log_M.tail = i;
-		
-		
+	int size = sizeof(type_ckpt) + att_num * sizeof(ckpt_att) + dpt_num * sizeof(ckpt_dpt);
+
+	//ring 절반보다 큰 레코드는 쓰지 않는다, end가 없는 begin은 analysis가 쓰지 않는다
+	if (size > log_M.ring_size / 2) {
+		free(att);
+		free(dpt);
+		pthread_mutex_unlock(&ckpt_latch);
+		return FAIL;
 	}
-	else {
-		log_M.logRecords[i].pre = log_M.tail;
-		log_M.logRecords[i].next = TAIL;
-		log_M.logRecords[log_M.tail].next = i;
-		log_M.tail = i;
+
+	type_ckpt e;
+	memset(&e, 0, sizeof(e));
+	e.pre_LSN = b.LSN;
+	e.trx_id = 0;
+	e.type = CKPT_END;
+	e.log_size = size;
+	e.att_num = att_num;
+	e.dpt_num = dpt_num;
+	e.table_max = b_M.table_total;
+	e.trx_max = trx_max;
+	e.LSN = log_reserve(size);
+
+	char * rec = (char*)malloc(size);
+	memcpy(rec, &e, sizeof(e));
+	memcpy(rec + sizeof(e), att, att_num * sizeof(ckpt_att));
+	memcpy(rec + sizeof(e) + att_num * sizeof(ckpt_att), dpt, dpt_num * sizeof(ckpt_dpt));
+	log_put(rec, size, e.LSN);
+	log_flush(e.LSN);
+	free(rec);
+	free(att);
+	free(dpt);
+
+	//end가 내려간 뒤에 master를 바꾼다
+	int64_t m[2] = { b.LSN, e.LSN };
+	if (log_master_fd > 0 && pwrite(log_master_fd, m, sizeof(m), 0) == sizeof(m)) {
+		fdatasync(log_master_fd);
+		log_M.ckpt_LSN = b.LSN;
+		log_M.ckpt_num++;
+		log_truncate(keep);
 	}
 
-	log_M.use_num++;
+	pthread_mutex_unlock(&ckpt_latch);
+	return SUCCESS;
+}
+
+//ckpt_ms마다 checkpoint, close_log에서 멈춘다
+static void * log_checkpointer_func(void * arg)
+{
+	pthread_mutex_lock(&log_M.latch);
+	while (log_M.ckpt_run) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += (long)log_M.ckpt_ms * 1000000;
+		ts.tv_sec += ts.tv_nsec / 1000000000;
+		ts.tv_nsec %= 1000000000;
+		pthread_cond_timedwait(&log_M.ckpt_cond, &log_M.latch, &ts);
+		if (!log_M.ckpt_run) break;
+
+		pthread_mutex_unlock(&log_M.latch);
+		log_checkpoint();
+		pthread_mutex_lock(&log_M.latch);
+	}
+	pthread_mutex_unlock(&log_M.latch);
 
-	return log->LSN;
+	return NULL;
 }
 
-int log_compensate(int trx_id, int table_id, int64_t page_num, int target_log,int record_off)
+int log_checkpoint_start(int ms)
 {
-	type_compen *log = (type_compen*)malloc(sizeof(struct type_compen));
-	if (!log) return FAIL;
-	log->log_size = COM_SIZE;
-	log->trx_id = trx_id;
-	log->type = COMPENSATE;
-	
+	if (log_M.ckpt_run || ms <= 0) return FAIL;
 
-	log->table_id = table_id;
-	log->page_num = page_num;
-	log->off = 128+128*(record_off);
-	log->data_len = 120;
+	log_M.ckpt_ms = ms;
+	log_M.ckpt_run = 1;
+	pthread_create(&log_M.checkpointer, NULL, log_checkpointer_func, NULL);
+	return SUCCESS;
+}
 
-	// α׸ о
-	// log old new ǰ new old Ǽ strcpy 
-	//strcpy(log->old_image, old_image);
-	//strcpy(log->new_image, new_image);
+//n바이트를 다 보낸다, 끊겼으면 FAIL
+static int ship_send(int fd, const char * p, int64_t n)
+{
+	while (n > 0) {
+		ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+		if (w <= 0) return FAIL;
+		p += w;
+		n -= w;
+	}
+	return SUCCESS;
+}
 
-	//  α preLSN  α nextundoLSN 
-	//log->next_undo_LSN = ;
+//replica 하나를 맡은 shipper, 붙을때 받은 offset부터 flushed_LSN까지를 계속 보낸다
+//flusher가 done_cond를 깨울때마다 새로 내려간 구간을 파일에서 읽어 보낸다
+static void * log_shipper_func(void * arg)
+{
+	int slot = (int)(intptr_t)arg;
+	char * buf = (char*)malloc(SHIP_CHUNK);
+
+	pthread_mutex_lock(&log_M.latch);
+	int fd = log_M.ship_conn[slot];
+	int64_t off = log_M.ship_off[slot];
+	while (buf) {
+		while (log_M.ship_run && log_M.flushed_LSN < off)
+			pthread_cond_wait(&log_M.done_cond, &log_M.latch);
+		if (!log_M.ship_run) break;
+		int64_t len = log_M.flushed_LSN + 1 - off;
+		pthread_mutex_unlock(&log_M.latch);
+
+		if (len > SHIP_CHUNK) len = SHIP_CHUNK;
+		int ok = pread(log_fd, buf, len, off) == len && ship_send(fd, buf, len) == SUCCESS;
+
+		pthread_mutex_lock(&log_M.latch);
+		if (!ok) break;
+		off += len;
+		log_M.ship_off[slot] = off;
+	}
+	close(fd);
+	log_M.ship_conn[slot] = -1;
+	log_M.ship_off[slot] = -1;
+	log_M.ship_num--;
+	pthread_cond_broadcast(&log_M.done_cond);
+	pthread_mutex_unlock(&log_M.latch);
+
+	free(buf);
+	return NULL;
+}
 
-	Trx* find = trx_find(trx_id);
-	
-	log->pre_LSN = find->lastLSN;
-	log_M.log_now += COM_SIZE;
-	log->LSN = log_M.log_now;
-	find->lastLSN = log->LSN;
+//replica는 붙자마자 받을 offset(int64_t)을 보낸다
+//이미 비운 로그나 아직 내려가지 않은 로그부터는 보낼 수 없으므로 끊는다
+static void * log_ship_accept_func(void * arg)
+{
+	while (1) {
+		int fd = accept(log_M.ship_fd, NULL, NULL);
+		if (fd < 0) {
+			if (!__atomic_load_n(&log_M.ship_run, __ATOMIC_ACQUIRE)) break;
+			continue;
+		}
+		//offset을 안 보내는 replica가 acceptor를 붙잡지 않게
+		struct timeval tv = { 1, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		int64_t from;
+		if (recv(fd, &from, sizeof(from), MSG_WAITALL) != sizeof(from)) {
+			close(fd);
+			continue;
+		}
 
-	//α ۿ ø ڸ ã´
-	int i;
-	for (i = 0; i < log_M.frame_capacity; i++)
-	{
-		if (log_M.logRecords[i].pre == -1 && log_M.logRecords[i].next == -1) {
-			break;
+		pthread_mutex_lock(&log_M.latch);
+		int slot = -1;
+		for (int i = 0; i < SHIP_MAX && slot < 0; i++)
+			if (log_M.ship_conn[i] < 0) slot = i;
+		if (!log_M.ship_run || slot < 0 || from < log_M.trunc_off || from > log_M.flushed_LSN + 1) {
+			pthread_mutex_unlock(&log_M.latch);
+			LOG_MSG("[SHIP] refuse replica at offset %" PRId64 "\n", from);
+			close(fd);
+			continue;
 		}
+		log_M.ship_conn[slot] = fd;
+		log_M.ship_off[slot] = from;
+		log_M.ship_num++;
+		pthread_mutex_unlock(&log_M.latch);
+		LOG_MSG("[SHIP] replica %d from offset %" PRId64 "\n", slot, from);
+
+		pthread_t th;
+		pthread_create(&th, NULL, log_shipper_func, (void*)(intptr_t)slot);
+		pthread_detach(th);
+	}
+	return NULL;
+}
+
+int log_ship_start(int port)
+{
+	if (log_M.ship_run || b_opt.no_wal || port <= 0 || port > 65535) return FAIL;
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return FAIL;
+	int one = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SHIP_MAX) < 0) {
+		close(fd);
+		return FAIL;
+	}
+
+	log_M.ship_fd = fd;
+	log_M.ship_run = 1;
+	pthread_create(&log_M.ship_acceptor, NULL, log_ship_accept_func, NULL);
+	return SUCCESS;
+}
+
+//socket을 닫아 acceptor와 shipper를 깨우고 다 끝날때까지 기다린다
+static void log_ship_stop()
+{
+	pthread_mutex_lock(&log_M.latch);
+	if (!log_M.ship_run) {
+		pthread_mutex_unlock(&log_M.latch);
+		return;
 	}
+	__atomic_store_n(&log_M.ship_run, 0, __ATOMIC_RELEASE);
+	shutdown(log_M.ship_fd, SHUT_RDWR);
+	for (int i = 0; i < SHIP_MAX; i++)
+		if (log_M.ship_conn[i] >= 0) shutdown(log_M.ship_conn[i], SHUT_RDWR);
+	pthread_cond_broadcast(&log_M.done_cond);
+	pthread_mutex_unlock(&log_M.latch);
+
+	pthread_join(log_M.ship_acceptor, NULL);
+	close(log_M.ship_fd);
+	log_M.ship_fd = -1;
+
+	pthread_mutex_lock(&log_M.latch);
+	while (log_M.ship_num > 0)
+		pthread_cond_wait(&log_M.done_cond, &log_M.latch);
+	pthread_mutex_unlock(&log_M.latch);
+}
+
+//LSN에서 끝나는 레코드를 rec에 읽고 크기를 돌려준다, 없으면 0
+//모든 레코드(checkpoint end 제외)의 마지막 4바이트가 크기이므로 뒤에서부터 찾는다
+static int log_read_rec(int64_t LSN, log_rec * rec)
+{
+	char buf[LOG_MAX_SIZE];
 
-	log_M.logRecords[i].frame_compensate=*log;
+	log_flush(LSN);
+	int size;
+	if (LSN + 1 < BCR_SIZE || pread(log_fd, &size, sizeof(int), LSN + 1 - sizeof(int)) != sizeof(int)) return 0;
+	if (size < BCR_SIZE || size > LOG_MAX_SIZE || LSN + 1 < size) return 0;
+	if (pread(log_fd, buf, size, LSN + 1 - size) != size) return 0;
 
+	if (log_decode(buf, size, rec) != size || rec->bcr.LSN != LSN) return 0;
+	return size;
+}
 
-	if (log_M.use_num == 0) {
-		log_M.logRecords[i].pre = HEAD;
-		log_M.logRecords[i].next = TAIL;
-		log_M.head = i;
-		log_M.tail = i;
+int log_read(int64_t LSN, log_rec * rec)
+{
+	return log_read_rec(LSN, rec) ? SUCCESS : FAIL;
+}
 
+//파일 앞에서부터 레코드를 차례로 읽는 커서, LOG_READ_SIZE씩 읽어둔다
+typedef struct log_cursor {
+	int64_t off;//다음 레코드 시작
+	int64_t base;//buf[0]의 파일 offset
+	int len;
+	char * buf;
+}log_cursor;
 
+static void cursor_open(log_cursor * c, int64_t off)
+{
+	c->off = off;
+	c->base = off;
+	c->len = 0;
+	c->buf = (char*)malloc(LOG_READ_SIZE);
+}
+
+static void cursor_close(log_cursor * c)
+{
+	free(c->buf);
+}
+
+//다음 레코드를 rec에 읽고 크기를 돌려준다, 끝이거나 덜 쓰인 레코드면 0
+//checkpoint end는 헤더만 읽고 뒤의 표는 건너뛴다 (표는 ckpt_load로 따로 읽는다)
+static int cursor_next(log_cursor * c, log_rec * rec)
+{
+	//가장 큰 레코드가 통째로 버퍼에 없으면 off부터 다시 채운다
+	if (c->off + LOG_MAX_SIZE > c->base + c->len) {
+		c->base = c->off;
+		c->len = (int)pread(log_fd, c->buf, LOG_READ_SIZE, c->base);
+		if (c->len < 0) c->len = 0;
 	}
-	else {
-		log_M.logRecords[i].pre = log_M.tail;
-		log_M.logRecords[i].next = TAIL;
-		log_M.logRecords[log_M.tail].next = i;
-		log_M.tail = i;
+
+	int at = (int)(c->off - c->base);
+	if (at + LOG_HEAD > c->len) return 0;
+	type_BCR h;
+	memcpy(&h, c->buf + at, LOG_HEAD);
+	if (h.type == CKPT_END) {
+		type_ckpt e;
+		if (at + (int)sizeof(type_ckpt) > c->len) return 0;
+		memcpy(&e, c->buf + at, sizeof(type_ckpt));
+		if (e.log_size < (int)sizeof(type_ckpt) || e.LSN != c->off + e.log_size - 1) return 0;
+		if (lseek(log_fd, 0, SEEK_END) <= e.LSN) return 0;
+		memset(rec, 0, sizeof(log_rec));
+		rec->ckpt = e;
+		c->off += e.log_size;
+		return e.log_size;
 	}
+	int size = log_decode(c->buf + at, c->len - at, rec);
+	if (size == 0 || h.LSN != c->off + size - 1) return 0;
 
-	log_M.use_num++;
-	return log->LSN;
+	c->off += size;
+	return size;
 }
 
-int log_update(int trx_id, int table_id, int64_t page_num, char * old_image, char * new_image,int record_off)
+//analysis가 찾은 trx 상태
+typedef struct recovery_trx {
+	int trx_id;//0이면 빈칸
+	int done;//commit/rollback까지 남았으면 1 (winner)
+	int64_t lastLSN;
+}recovery_trx;
+
+//analysis에서 쓰는 dirty page table 한칸, table_id가 0이면 빈칸
+typedef struct recovery_page {
+	int table_id;
+	int64_t page_num;
+	int64_t rec_LSN;
+}recovery_page;
+
+static struct {
+	recovery_trx * trx;//trx_id로 찾는 open addressing, 크기는 2의 거듭제곱
+	int trx_cap;
+	int trx_num;
+	recovery_page * dpt;//(table_id, page_num)으로 찾는 open addressing
+	int dpt_cap;
+	int dpt_num;
+	int table_max;//로그에 나온 가장 큰 table_id
+	int64_t redo_LSN;//redo를 시작할 레코드 (dpt의 가장 작은 rec_LSN), 없으면 -1
+	int64_t end;//마지막 레코드의 LSN
+}rv;
+
+static recovery_trx * rv_slot(int trx_id)
 {
-	type_update *log = (type_update*)malloc(sizeof(struct type_update));
-	if (!log) return FAIL;
-	log->log_size = UP_SIZE;
-	log->trx_id = trx_id;
-	log->type = UPDATE;
-	
+	uint32_t h = ((uint32_t)trx_id * 2654435761u) & (rv.trx_cap - 1);
+	while (rv.trx[h].trx_id != 0 && rv.trx[h].trx_id != trx_id)
+		h = (h + 1) & (rv.trx_cap - 1);
+	return &rv.trx[h];
+}
+
+//trx_id의 상태를 찾고 없으면 새로 만든다
+static recovery_trx * rv_trx(int trx_id)
+{
+	if ((rv.trx_num + 1) * 2 > rv.trx_cap) {
+		recovery_trx * old = rv.trx;
+		int old_cap = rv.trx_cap;
+		rv.trx_cap = old_cap ? old_cap * 2 : 64;
+		rv.trx = (recovery_trx*)calloc(rv.trx_cap, sizeof(recovery_trx));
+		for (int i = 0; i < old_cap; i++)
+			if (old[i].trx_id != 0) *rv_slot(old[i].trx_id) = old[i];
+		free(old);
+	}
+
+	recovery_trx * t = rv_slot(trx_id);
+	if (t->trx_id == 0) {
+		t->trx_id = trx_id;
+		t->done = 0;
+		t->lastLSN = -1;
+		rv.trx_num++;
+	}
+	return t;
+}
 
-	log->table_id = table_id;
-	log->page_num = page_num;
-	log->off = 128 + 128 * (record_off);
-	log->data_len = 120;
-	strcpy(log->old_image, old_image);
-	strcpy(log->new_image, new_image);
+static recovery_page * rv_page_slot(int table_id, int64_t page_num)
+{
+	uint64_t h = (((uint64_t)table_id << 48) ^ (uint64_t)page_num) * 0x9E3779B97F4A7C15ull >> 32;
+	h &= rv.dpt_cap - 1;
+	while (rv.dpt[h].table_id != 0 && (rv.dpt[h].table_id != table_id || rv.dpt[h].page_num != page_num))
+		h = (h + 1) & (rv.dpt_cap - 1);
+	return &rv.dpt[h];
+}
 
-	Trx* find = trx_find(trx_id);
+//dpt에 없는 페이지면 rec_LSN으로 넣고, 있으면 더 작은 rec_LSN을 남긴다
+static void rv_page(int table_id, int64_t page_num, int64_t rec_LSN)
+{
+	if ((rv.dpt_num + 1) * 2 > rv.dpt_cap) {
+		recovery_page * old = rv.dpt;
+		int old_cap = rv.dpt_cap;
+		rv.dpt_cap = old_cap ? old_cap * 2 : 256;
+		rv.dpt = (recovery_page*)calloc(rv.dpt_cap, sizeof(recovery_page));
+		for (int i = 0; i < old_cap; i++)
+			if (old[i].table_id != 0) *rv_page_slot(old[i].table_id, old[i].page_num) = old[i];
+		free(old);
+	}
 
-	log->pre_LSN = find->lastLSN;
-	log_M.log_now += UP_SIZE;
-	log->LSN = log_M.log_now;
-	find->lastLSN = log->LSN;
+	recovery_page * p = rv_page_slot(table_id, page_num);
+	if (p->table_id == 0) {
+		p->table_id = table_id;
+		p->page_num = page_num;
+		p->rec_LSN = rec_LSN;
+		rv.dpt_num++;
+	}
+	else if (rec_LSN < p->rec_LSN) p->rec_LSN = rec_LSN;
+}
 
-	//α ۿ ø ڸ ã´
-	int i;
-	for (i = 0; i < log_M.frame_capacity; i++)
-	{
-		if (log_M.logRecords[i].pre == -1 && log_M.logRecords[i].next == -1) {
-			break;
+static recovery_page * rv_page_find(int table_id, int64_t page_num)
+{
+	if (rv.dpt_cap == 0) return NULL;
+	recovery_page * p = rv_page_slot(table_id, page_num);
+	return p->table_id != 0 ? p : NULL;
+}
+
+static const char * log_type_name(int type)
+{
+	static const char * name[] = { "BEGIN", "UPDATE", "COMMIT", "ROLLBACK", "CLR", "CHECKPOINT-BEGIN", "CHECKPOINT-END", "INSERT", "INSERT-CLR" };
+	if (type < BEGIN || type > INSERT_CLR) return "UNKNOWN";
+	return name[type];
+}
+
+//master 파일에 남은 마지막 checkpoint begin의 LSN, 없거나 맞지 않으면 -1
+static int64_t ckpt_master()
+{
+	int64_t m[2];
+	log_rec rec;
+	if (log_master_fd <= 0 || pread(log_master_fd, m, sizeof(m), 0) != sizeof(m)) return -1;
+	if (m[0] < BCR_SIZE - 1 || m[1] <= m[0]) return -1;
+	if (log_read(m[0], &rec) != SUCCESS || rec.bcr.type != CKPT_BEGIN) return -1;
+	return m[0];
+}
+
+//checkpoint end의 표를 읽어서 analysis 상태에 더한다
+//begin 이후의 레코드로 이미 본 trx/페이지는 더 새 정보(lastLSN은 큰 쪽, rec_LSN은 작은 쪽)를 남긴다
+static void ckpt_load(const type_ckpt * e, int * max_trx)
+{
+	int len = e->log_size - (int)sizeof(type_ckpt);
+	char * buf = (char*)malloc(len > 0 ? len : 1);
+	if (pread(log_fd, buf, len, e->LSN + 1 - e->log_size + sizeof(type_ckpt)) == len) {
+		ckpt_att * att = (ckpt_att*)buf;
+		ckpt_dpt * dpt = (ckpt_dpt*)(att + e->att_num);
+		for (int i = 0; i < e->att_num; i++) {
+			recovery_trx * t = rv_trx(att[i].trx_id);
+			if (att[i].lastLSN > t->lastLSN) t->lastLSN = att[i].lastLSN;
+		}
+		for (int i = 0; i < e->dpt_num; i++)
+			rv_page(dpt[i].table_id, dpt[i].page_num, dpt[i].rec_LSN);
+		if (e->table_max > rv.table_max) rv.table_max = e->table_max;
+		if (e->trx_max > *max_trx) *max_trx = e->trx_max;
+	}
+	free(buf);
+}
+
+//마지막 checkpoint(없으면 파일 처음)부터 읽으면서 winner/loser와 dirty page table을 만든다
+//loser는 undo가 끝날때까지 trx 테이블에 다시 올리고, 마지막 레코드의 LSN을 돌려준다
+int analysis()
+{
+	log_rec rec;
+	log_cursor c;
+	int max_trx = 0;
+
+	LOG_MSG("[ANALYSIS] Analysis pass start\n");
+	free(rv.trx);
+	free(rv.dpt);
+	memset(&rv, 0, sizeof(rv));
+
+	int64_t ckpt = ckpt_master();
+	if (ckpt >= 0) LOG_MSG("[ANALYSIS] Checkpoint LSN %" PRId64 "\n", ckpt);
+
+	cursor_open(&c, ckpt >= 0 ? ckpt + 1 - BCR_SIZE : 0);
+	while (cursor_next(&c, &rec)) {
+		int type = rec.bcr.type;
+		if (type == CKPT_BEGIN) continue;
+		if (type == CKPT_END) {
+			if (ckpt >= 0 && rec.ckpt.pre_LSN == ckpt) ckpt_load(&rec.ckpt, &max_trx);
+			continue;
 		}
+
+		recovery_trx * t = rv_trx(rec.bcr.trx_id);
+		//같은 id가 이전 실행에서 쓰였을 수 있으므로 begin에서 새로 시작
+		if (type == BEGIN) t->done = 0;
+		if (type == COMMIT || type == ROLLBACK) t->done = 1;
+		t->lastLSN = rec.bcr.LSN;
+
+		if (type == UPDATE || type == COMPENSATE || type == INSERT || type == INSERT_CLR) {
+			if (rec.update.table_id > rv.table_max) rv.table_max = rec.update.table_id;
+			rv_page(rec.update.table_id, rec.update.page_num, rec.update.LSN);
+		}
+		if (rec.bcr.trx_id > max_trx) max_trx = rec.bcr.trx_id;
+	}
+	rv.end = c.off - 1;
+	cursor_close(&c);
+
+	rv.redo_LSN = -1;
+	for (int i = 0; i < rv.dpt_cap; i++)
+		if (rv.dpt[i].table_id != 0 && (rv.redo_LSN < 0 || rv.dpt[i].rec_LSN < rv.redo_LSN)) rv.redo_LSN = rv.dpt[i].rec_LSN;
+
+	//끝에 덜 쓰인 레코드가 있으면 잘라내고 그 자리부터 이어서 쓴다
+	if (lseek(log_fd, 0, SEEK_END) > rv.end + 1) ftruncate(log_fd, rv.end + 1);
+	pthread_mutex_lock(&log_M.latch);
+	log_M.filled_LSN = rv.end;
+	log_M.flushed_LSN = rv.end;
+	log_M.flush_req = rv.end;
+	pthread_mutex_unlock(&log_M.latch);
+
+	LOG_MSG("[ANALYSIS] Analysis success. Winner:");
+	for (int i = 0; i < rv.trx_cap; i++)
+		if (rv.trx[i].trx_id != 0 && rv.trx[i].done) LOG_MSG(" %d", rv.trx[i].trx_id);
+	LOG_MSG(", Loser:");
+	for (int i = 0; i < rv.trx_cap; i++)
+		if (rv.trx[i].trx_id != 0 && !rv.trx[i].done) LOG_MSG(" %d", rv.trx[i].trx_id);
+	LOG_MSG("\n");
+
+	//새 trx는 로그에 나온 id 뒤부터
+	trx_set_id(max_trx);
+	for (int i = 0; i < rv.trx_cap; i++)
+		if (rv.trx[i].trx_id != 0 && !rv.trx[i].done) trx_restore(rv.trx[i].trx_id, rv.trx[i].lastLSN);
+
+	return rv.end;
+}
+
+//redo/undo가 건드릴 테이블을 연다, 로그에는 table_id만 있으므로 DATA<table_id> 파일
+//open_table은 처음 여는 순서대로 id를 주므로 1번부터 차례로 연다
+static void recovery_open_tables()
+{
+	char path[20];
+	for (int id = 1; id <= rv.table_max && id <= TABLE_MAX; id++) {
+		if (table_isopen(id) || b_M.table_total != id - 1) continue;
+		sprintf(path, "DATA%d", id);
+		open_table(path);
 	}
+}
 
-	log_M.logRecords[i].frame_update = *log;
-	if (log_M.use_num == 0) {
-		log_M.logRecords[i].pre = HEAD;
-		log_M.logRecords[i].next = TAIL;
-		log_M.head = i;
-		log_M.tail = i;
+static int recovery_table_open(int table_id)
+{
+	return table_isopen(table_id);
+}
 
+//(table_id, page_num)별로 나눠받은 update/compensate를 LSN 순서대로 적용하는 redo 쓰레드
+//한 페이지는 한 쓰레드만 맡으므로 페이지 안의 순서가 지켜진다
+typedef struct redo_worker {
+	pthread_t thread;
+	pthread_mutex_t latch;
+	pthread_cond_t cond;//dispatcher와 worker가 서로를 깨운다
+	type_compen * q;//REDO_QUEUE칸 ring
+	int head;
+	int num;
+	int done;
+}redo_worker;
+
+//page_LSN이 레코드 LSN보다 작을때만 다시 적용한다
+//레코드는 key로 찾는다, 그 사이 redo한 insert의 split으로 다른 리프에 옮겨갔을 수 있다
+static void redo_apply(type_compen * r)
+{
+	int i;
+	int index = leaf_locate(r->table_id, r->page_num, r->key, &i);
+	if (index < 0) {
+		LOG_MSG("LSN %" PRId64 " [CONSIDER-REDO] Transaction id %d\n", r->LSN, r->trx_id);
+		return;
+	}
+	page_t * pg = b_M.frameArray[index].frame_p;
 
+	if (pg->page_LSN < r->LSN) {
+		leaf_update(pg, i, r->new_image);
+		pg->page_LSN = r->LSN;
+		setDirtyLSN(index, r->LSN);
+		LOG_MSG("LSN %" PRId64 " [%s] Transaction id %d redo apply\n", r->LSN, log_type_name(r->type), r->trx_id);
+	}
+	else {
+		LOG_MSG("LSN %" PRId64 " [CONSIDER-REDO] Transaction id %d\n", r->LSN, r->trx_id);
 	}
+
+	clearPin(index);
+	pageUnlatch(index);
+}
+
+//insert/insert clr은 트리 모양을 바꿀 수 있어 dispatcher가 그 자리에서 바로 적용한다
+//키가 없을때만 넣고 (지운 표시면 되살린다), clr은 살아있을때만 지운 표시를 한다
+static void redo_logical(type_compen * r)
+{
+	char val[LOG_IMAGE];
+	int here = db_find_2(r->table_id, r->key, val) == SUCCESS;
+	if (r->type == INSERT && !here) db_insert_base(r->table_id, r->key, r->new_image);
+	else if (r->type == INSERT_CLR && here) db_delete_base(r->table_id, r->key);
 	else {
-		log_M.logRecords[i].pre = log_M.tail;
-		log_M.logRecords[i].next = TAIL;
-		log_M.logRecords[log_M.tail].next = i;
-		log_M.tail = i;
+		LOG_MSG("LSN %" PRId64 " [CONSIDER-REDO] Transaction id %d\n", r->LSN, r->trx_id);
+		return;
+	}
+	LOG_MSG("LSN %" PRId64 " [%s] Transaction id %d redo apply\n", r->LSN, log_type_name(r->type), r->trx_id);
+}
+
+static void * redo_worker_func(void * arg)
+{
+	redo_worker * w = (redo_worker*)arg;
+	type_compen r;
+
+	pthread_mutex_lock(&w->latch);
+	while (1) {
+		while (w->num == 0 && !w->done)
+			pthread_cond_wait(&w->cond, &w->latch);
+		if (w->num == 0) break;
+
+		r = w->q[w->head];
+		w->head = (w->head + 1) % REDO_QUEUE;
+		w->num--;
+		pthread_cond_signal(&w->cond);
+		pthread_mutex_unlock(&w->latch);
+
+		redo_apply(&r);
+		pthread_mutex_lock(&w->latch);
 	}
+	pthread_mutex_unlock(&w->latch);
+
+	return NULL;
+}
+
+static void redo_push(redo_worker * w, const type_compen * r)
+{
+	pthread_mutex_lock(&w->latch);
+	while (w->num == REDO_QUEUE)
+		pthread_cond_wait(&w->cond, &w->latch);
+	w->q[(w->head + w->num) % REDO_QUEUE] = *r;
+	w->num++;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->latch);
+}
 
-	log_M.use_num++;
-	return log->LSN;
+//처음 보는 페이지면 커널에 미리 읽어달라고 한다, 최근에 본 페이지는 작은 표로 거른다
+static void redo_prefetch(uint64_t * seen, int table_id, int64_t page_num)
+{
+	uint64_t tag = (((uint64_t)table_id << 48) ^ (uint64_t)page_num) + 1;
+	uint64_t h = (tag * 0x9E3779B97F4A7C15ull) >> (64 - REDO_SEEN_BITS);
+	if (seen[h] == tag) return;
+	seen[h] = tag;
+	posix_fadvise(table_get(table_id)->fd, page_num * PAGESIZE, PAGESIZE, POSIX_FADV_WILLNEED);
 }
 
+//dpt의 가장 작은 rec_LSN부터 끝까지(log_num이 0보다 크면 log_num개까지) 다시 실행
+//update/compensate는 페이지별로 redo 쓰레드에 나눠주고, 읽는 쪽은 그 페이지를 미리 읽어둔다
+//insert/insert clr은 읽는 쪽이 바로 적용한다
+//dpt에 없거나 rec_LSN보다 앞의 레코드는 페이지를 읽지 않고 넘어간다
 void recovery_redo(int log_num)
 {
-	//α  
+	LOG_MSG("[REDO] Redo pass start\n");
+	recovery_open_tables();
+
+	log_rec rec;
+	int64_t start = rv.end + 1;
+	int size;
+	if (rv.redo_LSN >= 0 && (size = log_read_rec(rv.redo_LSN, &rec)) > 0)
+		start = rv.redo_LSN + 1 - size;
+
+	int n = b_opt.redo_thread > 0 ? b_opt.redo_thread : 4;
+	redo_worker * w = (redo_worker*)calloc(n, sizeof(redo_worker));
+	for (int k = 0; k < n; k++) {
+		pthread_mutex_init(&w[k].latch, NULL);
+		pthread_cond_init(&w[k].cond, NULL);
+		w[k].q = (type_compen*)malloc(REDO_QUEUE * sizeof(type_compen));
+		pthread_create(&w[k].thread, NULL, redo_worker_func, &w[k]);
+	}
+	uint64_t * seen = (uint64_t*)calloc((size_t)1 << REDO_SEEN_BITS, sizeof(uint64_t));
+
+	log_cursor c;
+	int cnt = 0;
+	cursor_open(&c, start);
+	while (cursor_next(&c, &rec)) {
+		//redo crash : log_num개까지만 진행
+		if (log_num > 0 && cnt == log_num) break;
+		cnt++;
+
+		int type = rec.bcr.type;
+		if (type == UPDATE || type == COMPENSATE || type == INSERT || type == INSERT_CLR) {
+			if (!recovery_table_open(rec.update.table_id)) continue;
+			recovery_page * p = rv_page_find(rec.update.table_id, rec.update.page_num);
+			if (!p || rec.update.LSN < p->rec_LSN) {
+				LOG_MSG("LSN %" PRId64 " [CONSIDER-REDO] Transaction id %d\n", rec.bcr.LSN, rec.bcr.trx_id);
+				continue;
+			}
+			if (type == INSERT || type == INSERT_CLR) {
+				redo_logical(&rec.compen);
+				continue;
+			}
+			redo_prefetch(seen, rec.update.table_id, rec.update.page_num);
+			uint64_t h = ((uint64_t)rec.update.table_id * 0x9E3779B97F4A7C15ull) ^ (uint64_t)rec.update.page_num;
+			redo_push(&w[(h * 0x9E3779B97F4A7C15ull >> 32) % n], &rec.compen);
+			continue;
+		}
+		LOG_MSG("LSN %" PRId64 " [%s] Transaction id %d\n", rec.bcr.LSN, log_type_name(type), rec.bcr.trx_id);
+	}
+	cursor_close(&c);
+
+	for (int k = 0; k < n; k++) {
+		pthread_mutex_lock(&w[k].latch);
+		w[k].done = 1;
+		pthread_cond_signal(&w[k].cond);
+		pthread_mutex_unlock(&w[k].latch);
+		pthread_join(w[k].thread, NULL);
+		free(w[k].q);
+	}
+	free(w);
+	free(seen);
 
-	//ó α׺ log num  
+	LOG_MSG("[REDO] Redo pass end\n");
+}
 
-	// log num -1̶  α(update,compenstate) 
+//LSN의 레코드가 update면 old image로 되돌리고 compensate log를 남긴다
+//insert면 insert clr을 남기고 그 키에 지운 표시를 한다
+//compensate면 이미 되돌린 것이므로 next_undo_LSN으로 건너뛴다
+int64_t log_undo(int trx_id, int64_t LSN, int * type)
+{
+	log_rec rec;
+	if (log_read(LSN, &rec) != SUCCESS || rec.bcr.trx_id != trx_id) return -1;
+	if (type) *type = rec.bcr.type;
+
+	if (rec.bcr.type == COMPENSATE || rec.bcr.type == INSERT_CLR) return rec.compen.next_undo_LSN;
+	if (rec.bcr.type == BEGIN) return -1;
+	if (rec.bcr.type != UPDATE && rec.bcr.type != INSERT) return rec.bcr.pre_LSN;
+
+	type_update * u = &rec.update;
+	if (rec.bcr.type == INSERT) {
+		log_insert_clr(trx_id, u);
+		if (recovery_table_open(u->table_id)) db_delete_base(u->table_id, u->key);
+		return u->pre_LSN;
+	}
+	if (!recovery_table_open(u->table_id)) {
+		log_compensate(trx_id, u);
+		return u->pre_LSN;
+	}
 
-	// consider redo ؾϴ  redo skip
-	// ؾϴ α LSN ش  lastLSN ū츸 redo 
+	//split이나 merge로 옮겨갔을 수 있으므로 key로 찾는다
+	int i;
+	int index = leaf_locate(u->table_id, u->page_num, u->key, &i);
+	if (index < 0) {
+		log_compensate(trx_id, u);
+		return u->pre_LSN;
+	}
+	page_t * pg = b_M.frameArray[index].frame_p;
+	leaf_update(pg, i, u->old_image);
+	pg->page_LSN = log_compensate(trx_id, u);
+	setDirtyLSN(index, pg->page_LSN);
+	clearPin(index);
+	pageUnlatch(index);
+
+	return u->pre_LSN;
 }
 
+//loser들을 LSN이 큰 레코드부터 차례로 되돌린다 (log_num이 0보다 크면 log_num개까지)
+//begin까지 되돌린 trx는 rollback을 남기고 trx 테이블에서 뺀다
 void recovery_undo(int log_num)
 {
-	// ȮѴ.
+	LOG_MSG("[UNDO] Undo pass start\n");
+
+	int n = 0;
+	int * ids = (int*)malloc(sizeof(int) * (rv.trx_num + 1));
+	int64_t * next = (int64_t*)malloc(sizeof(int64_t) * (rv.trx_num + 1));
+	for (int i = 0; i < rv.trx_cap; i++) {
+		if (rv.trx[i].trx_id == 0 || rv.trx[i].done) continue;
+		ids[n] = rv.trx[i].trx_id;
+		next[n] = rv.trx[i].lastLSN;
+		n++;
+	}
+
+	int cnt = 0;
+	while (1) {
+		int k = -1;
+		for (int j = 0; j < n; j++)
+			if (next[j] >= 0 && (k < 0 || next[j] > next[k])) k = j;
+		if (k < 0) break;
+
+		//undo crash : log_num개까지만 진행
+		if (log_num > 0 && cnt == log_num) break;
+		cnt++;
+
+		int type = -1;
+		int64_t LSN = next[k];
+		next[k] = log_undo(ids[k], LSN, &type);
+		if (type == UPDATE || type == INSERT)
+			LOG_MSG("LSN %" PRId64 " [%s] Transaction id %d undo apply\n", LSN, log_type_name(type), ids[k]);
+
+		if (next[k] < 0) {
+			log_flush(log_BCR(ids[k], ROLLBACK));
+			trx_remove(ids[k]);
+			rv_trx(ids[k])->done = 1;
+		}
+	}
+	free(ids);
+	free(next);
 
-	//α    α׺ ؼ  α׸ undo(log num/-1ΰ ׳ normal)
+	LOG_MSG("[UNDO] Undo pass end\n");
+}
 
-	//write α׿ ؼ ׳ ׷α׸ Ÿ ⿡ compensate log ߱
+//replica가 받고 있는 primary의 trx 하나, commit을 받으면 모아둔 update/insert를 자기 trx로 다시 실행한다
+//rollback을 받거나 끝내 commit이 오지 않은 trx는 적용하지 않으므로 compensate는 볼 필요가 없다
+typedef struct replica_trx {
+	int trx_id;
+	int64_t begin;//처음 받은 레코드의 시작 offset
+	type_compen * rec;
+	int num;
+	int cap;
+}replica_trx;
+
+static struct {
+	int fd;//primary와의 연결, -1이면 꺼짐
+	int run;
+	pthread_t th;
+	int state_fd;//[다시 받을 offset, 마지막으로 적용한 commit LSN]
+	int64_t off;//다음에 받을 레코드의 primary 로그 offset
+	int64_t applied;//다시 받은 로그에서 이 앞의 commit은 이미 적용한 것
+	replica_trx * trx;
+	int trx_num;
+	int trx_cap;
+}rp = { -1 };
+
+static replica_trx * rp_trx(int trx_id, int create)
+{
+	for (int i = 0; i < rp.trx_num; i++)
+		if (rp.trx[i].trx_id == trx_id) return &rp.trx[i];
+	if (!create) return NULL;
 
-	//compensateα׸   α nextundoLSN  а شϴ α׸ Ÿ  compensate α 
-	// ĺ  write log pre 󰡸鼭 compensate߱
+	if (rp.trx_num == rp.trx_cap) {
+		rp.trx_cap = rp.trx_cap ? rp.trx_cap * 2 : 16;
+		rp.trx = (replica_trx*)realloc(rp.trx, rp.trx_cap * sizeof(replica_trx));
+	}
+	replica_trx * p = &rp.trx[rp.trx_num++];
+	memset(p, 0, sizeof(replica_trx));
+	p->trx_id = trx_id;
+	p->begin = rp.off;
+	return p;
+}
 
-	//(write log)pre -1̰ų (compensate)nextundoLSN -1 Ǹ  trx  rollback log߱
+static void rp_drop(replica_trx * p)
+{
+	free(p->rec);
+	*p = rp.trx[--rp.trx_num];
 }
 
-int analysis()
+//인덱스 테이블이면 1, 인덱스 엔트리는 원래 테이블의 레코드를 다시 실행할때 같이 들어간다
+static int rp_index_table(int table_id)
 {
-	//α 
-	//α ޼ 
-	int log_num=-1;
+	for (int id = 1; id <= b_M.table_total; id++) {
+		if (!table_isopen(id)) continue;
+		Table * tb = table_get(id);
+		for (int j = 0; j < tb->index_num; j++)
+			if (tb->index_table[j] == table_id) return 1;
+	}
+	return 0;
+}
 
-	while (1) {
-		//αϿ ϳ α ڵ带 о´
-		//ΰ üũص 
+//commit된 trx를 trx 하나로 다시 실행한다, 그 사이 snapshot trx는 이 trx 전이나 후만 본다
+//replica에서 lock을 잡는 쪽이 있으면 abort될 수 있으므로 될때까지 다시 한다, 멈추라고 하면 FAIL
+static int rp_apply(replica_trx * p)
+{
+	while (__atomic_load_n(&rp.run, __ATOMIC_ACQUIRE)) {
+		int trx_id = trx_begin();
+		if (!trx_id) continue;
+
+		int ok = 1;
+		for (int k = 0; k < p->num && ok; k++) {
+			type_compen * r = &p->rec[k];
+			if (!table_isopen(r->table_id) || rp_index_table(r->table_id)) continue;
+			//이미 있는 키의 insert나 없는 키의 update는 FAIL, 다시 받은 로그면 그럴 수 있다
+			if (r->type == INSERT) ok = db_insert_trx(r->table_id, r->key, r->new_image, trx_id) != ABORT;
+			else ok = db_update(r->table_id, r->key, r->new_image, trx_id) != ABORT;
+		}
+		if (ok && trx_commit(trx_id) == trx_id) return SUCCESS;
+		if (trx_get(trx_id)) trx_abort(trx_id);
+	}
+	return FAIL;
+}
 
-		//abort ִµ    Ѱ loser
-		//rollback ߰ߵ  winner
+//다시 붙을때는 진행중인 trx 중 가장 앞의 레코드부터 받는다
+static void rp_state_save()
+{
+	int64_t m[2] = { rp.off, rp.applied };
+	for (int i = 0; i < rp.trx_num; i++)
+		if (rp.trx[i].begin < m[0]) m[0] = rp.trx[i].begin;
+	if (rp.state_fd > 0) pwrite(rp.state_fd, m, sizeof(m), 0);
+}
 
-		//abort µ commit    loser
-		//commit߽߰ winner
+//rp.off에서 시작하는 레코드 하나를 받았다
+static void rp_record(log_rec * rec, int size)
+{
+	int type = rec->bcr.type;
+	replica_trx * p = rp_trx(rec->bcr.trx_id, type == BEGIN || type == UPDATE || type == INSERT);
 
+	if (type == BEGIN) {
+		//이전 실행에서 쓰인 id일 수 있으므로 새로 시작
+		p->num = 0;
+		p->begin = rp.off;
 	}
-	//loserƮ .
-	//ʿ   ޼ 
-	
-	return log_num;
-	
+	else if (type == UPDATE || type == INSERT) {
+		if (p->num == p->cap) {
+			p->cap = p->cap ? p->cap * 2 : 16;
+			p->rec = (type_compen*)realloc(p->rec, p->cap * sizeof(type_compen));
+		}
+		p->rec[p->num++] = rec->compen;
+	}
+	else if (type == ROLLBACK && p) rp_drop(p);
+	rp.off += size;
+
+	if (type == COMMIT) {
+		if (rec->bcr.LSN > rp.applied) {
+			if (p && rp_apply(p) != SUCCESS) return;
+			rp.applied = rec->bcr.LSN;
+		}
+		if (p) rp_drop(p);
+		rp_state_save();
+	}
+}
+
+//primary가 보내는 로그를 레코드 단위로 잘라 rp_record에 넘긴다
+//checkpoint end는 replica에 쓸모가 없으므로 받는대로 버린다
+static void * log_replica_func(void * arg)
+{
+	char * buf = (char*)malloc(LOG_READ_SIZE);
+	int len = 0;//buf[0]은 rp.off의 바이트
+	int64_t skip = 0;
+	log_rec rec;
+
+	while (buf && __atomic_load_n(&rp.run, __ATOMIC_ACQUIRE)) {
+		ssize_t n = recv(rp.fd, buf + len, LOG_READ_SIZE - len, 0);
+		if (n <= 0) {
+			LOG_MSG("[REPLICA] primary closed at offset %" PRId64 "\n", rp.off);
+			break;
+		}
+		len += n;
+
+		int at = 0;
+		while (1) {
+			if (skip) {
+				int d = skip < len - at ? (int)skip : len - at;
+				at += d;
+				rp.off += d;
+				skip -= d;
+				if (skip) break;
+			}
+			if (len - at < LOG_HEAD) break;
+			type_BCR h;
+			memcpy(&h, buf + at, LOG_HEAD);
+			if (h.type == CKPT_END) {
+				type_ckpt e;
+				if (len - at < (int)sizeof(type_ckpt)) break;
+				memcpy(&e, buf + at, sizeof(type_ckpt));
+				if (e.log_size < (int)sizeof(type_ckpt) || e.LSN != rp.off + e.log_size - 1) goto bad;
+				skip = e.log_size;
+				continue;
+			}
+			int size = log_decode(buf + at, len - at, &rec);
+			if (size == 0) {
+				if (len - at >= LOG_MAX_SIZE) goto bad;
+				break;
+			}
+			if (rec.bcr.LSN != rp.off + size - 1) goto bad;
+			at += size;
+			rp_record(&rec, size);
+		}
+		memmove(buf, buf + at, len - at);
+		len -= at;
+	}
+	free(buf);
+	return NULL;
+
+bad:
+	LOG_MSG("[REPLICA] bad log record at offset %" PRId64 "\n", rp.off);
+	free(buf);
+	return NULL;
 }
 
-int read_log_file(int off)
+int log_replica_start(const char * host, int port, const char * state_path, int64_t from)
 {
-	// off ּҿ α ڵ  8Ʈ оͼ LSN а
-	//endoff о´
+	if (rp.fd >= 0 || !host || !state_path || port <= 0 || port > 65535) return FAIL;
+
+	rp.state_fd = open(state_path, O_RDWR | O_CREAT, 0777);
+	if (rp.state_fd < 0) return FAIL;
+	int64_t m[2];
+	if (pread(rp.state_fd, m, sizeof(m), 0) == sizeof(m)) {
+		rp.off = m[0];
+		rp.applied = m[1];
+	}
+	else {
+		rp.off = from > 0 ? from : 0;
+		rp.applied = -1;
+	}
+
+	char service[16];
+	snprintf(service, sizeof(service), "%d", port);
+	struct addrinfo hint, * res, * ai;
+	memset(&hint, 0, sizeof(hint));
+	hint.ai_family = AF_UNSPEC;
+	hint.ai_socktype = SOCK_STREAM;
+	int fd = -1;
+	if (getaddrinfo(host, service, &hint, &res) == 0) {
+		for (ai = res; ai && fd < 0; ai = ai->ai_next) {
+			fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+			if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+				close(fd);
+				fd = -1;
+			}
+		}
+		freeaddrinfo(res);
+	}
+	if (fd < 0 || send(fd, &rp.off, sizeof(int64_t), MSG_NOSIGNAL) != sizeof(int64_t)) {
+		if (fd >= 0) close(fd);
+		close(rp.state_fd);
+		rp.state_fd = -1;
+		return FAIL;
+	}
 
-	//  ġ ش
+	rp.fd = fd;
+	rp.trx_num = 0;
+	rp.run = 1;
+	pthread_create(&rp.th, NULL, log_replica_func, NULL);
 	return SUCCESS;
 }
+
+//연결을 끊고 applier가 지금 적용중인 trx까지 마치고 멈출때까지 기다린다
+void log_replica_stop()
+{
+	if (rp.fd < 0) return;
+
+	__atomic_store_n(&rp.run, 0, __ATOMIC_RELEASE);
+	shutdown(rp.fd, SHUT_RDWR);
+	pthread_join(rp.th, NULL);
+	close(rp.fd);
+	rp.fd = -1;
+	close(rp.state_fd);
+	rp.state_fd = -1;
+
+	while (rp.trx_num > 0) rp_drop(&rp.trx[0]);
+	free(rp.trx);
+	rp.trx = NULL;
+	rp.trx_cap = 0;
+}
@@ -2,6 +2,7 @@
 #include "file.h"
 #include "trx_manager.h"
 #include "buf_manager.h"
+#include "db_alloc.h"
 
 #include <stdio.h>
 #include <pthread.h>
@@ -24,6 +25,7 @@
 
 int cnt;
 int action;
+volatile int transfer_done;
 /*
  * This thread repeatedly transfers some money between accounts randomly.
  */
@@ -35,7 +37,7 @@ transfer_thread_func(void* arg)
 	
 	//printf("\nmy trx id is %d-----------------------------------------\n",trx_id);
 	int ran;
-	char * tmp=(char*)malloc(120);
+	char * tmp=(char*)db_obj_alloc(DB_OBJ_VALUE, val_max);
 	int64_t key_ran;
 
 	for (int i = 0; i < 15; i++)
@@ -80,6 +82,7 @@ transfer_thread_func(void* arg)
 	}
 	
 	trx_commit(trx_id);
+	db_obj_free(DB_OBJ_VALUE, tmp);
 	cnt--;
 	
 //printf("[%d] trx is done !!!------------------------------------------\n",trx_id);
@@ -88,15 +91,44 @@ transfer_thread_func(void* arg)
 }
 
 /*
- * This thread repeatedly check the summation of all accounts.
- * Because the locking strategy is 2PL (2 Phase Locking), the summation must
- * always be consistent.
+ * This thread repeatedly counts the records of table 1.
+ * The transfer threads only update values, they never insert or delete, so
+ * every snapshot must see the same number of records as the first one.
+ * It reads from a snapshot, so it takes no record lock and never conflicts
+ * with the transfer threads.
  */
+static int scan_cnt;
+static int scan_callback_func(int64_t key, const char * val)
+{
+	scan_cnt++;
+	return 0;
+}
+
+void*
+scan_thread_func(void* arg)
+{
+	int round = 0, expected = -1, bad = 0;
+	while (!transfer_done) {
+		int trx_id = trx_begin_snapshot();
+		scan_cnt = 0;
+		db_scan(1, 0, 99, scan_callback_func, trx_id);
+		trx_commit(trx_id);
+		if (expected < 0) expected = scan_cnt;
+		else if (scan_cnt != expected) {
+			printf("scan round %d : %d records, expected %d\n", round, scan_cnt, expected);
+			bad++;
+		}
+		round++;
+	}
+	printf("scan rounds : %d (%d records, %d inconsistent)\n", round, expected, bad);
+	return NULL;
+}
 
 
 int main()
 {
 	pthread_t	transfer_threads[100];
+	pthread_t	scan_threads[SCAN_THREAD_NUMBER];
 	char * pathname=(char *)malloc(100);
 	printf("please input pathname : ");
 	int a;
@@ -117,6 +149,9 @@ int main()
 	for (int i = 0; i < 100; i++) {
 		pthread_create(&transfer_threads[i], 0, transfer_thread_func, NULL);
 	}
+	for (int i = 0; i < SCAN_THREAD_NUMBER; i++) {
+		pthread_create(&scan_threads[i], 0, scan_thread_func, NULL);
+	}
 
 
 	/* thread join */
@@ -124,6 +159,10 @@ int main()
 	//printf("exit suc one ");
 		pthread_join(transfer_threads[i], NULL);
 	}
+	transfer_done = 1;
+	for (int i = 0; i < SCAN_THREAD_NUMBER; i++) {
+		pthread_join(scan_threads[i], NULL);
+	}
 	printf("\nall clear\n");
 
 	//print_tree(1);
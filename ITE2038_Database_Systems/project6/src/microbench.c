@@ -0,0 +1,211 @@
+#include "lock_manager.h"
+#include "file.h"
+#include "trx_manager.h"
+#include "buf_manager.h"
+#include "log_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//쓰레드 하나로 hot path 하나씩의 연산당 시간을 재는 벤치마크
+//bench가 trx 전체의 처리량을 본다면 여기서는 층마다 따로 본다
+//
+//./microbench -k 100000 -b 64 -n 10000 -r 9
+//  buf_hit      올라와 있는 페이지 하나를 pageScan/clearPin/pageUnlatch
+//  buf_miss     프레임보다 훨씬 많은 페이지를 섞어 가며 pageScan (OS page cache에서 읽는다)
+//  lock_acquire trx 하나가 서로 다른 key에 S lock을 n개 잡는 동안의 lock 하나당 시간
+//  lock_release 그 trx의 commit 시간을 n으로 나눈 값 (lock 해제 + commit 로그)
+//  log_append   trx 하나에서 log_update n개의 레코드 하나당 시간
+//결과는 한 줄에 하나씩 "BENCH db_<이름> <값> ns", r번 잰 것의 중앙값
+//bench/run.sh가 이 줄들을 모아 기록한다
+
+typedef struct micro_opt {
+	int64_t keys;//미리 넣어두는 레코드 수, 페이지가 프레임보다 훨씬 많아야 miss가 나온다
+	int frames;//버퍼 프레임 수
+	int ops;//한번 잴때의 연산 수
+	int rounds;//잰 횟수, 중앙값을 쓴다
+	char * path;//테이블 파일, 로그는 뒤에 .log/.msg를 붙인다
+}micro_opt;
+
+static micro_opt opt = { 100000, 64, 10000, 9, "microbench.db" };
+static int table_id;
+
+static int ns_cmp(const void * a, const void * b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+//rounds번 잰 연산당 시간의 중앙값을 출력
+static void report(const char * name, double * ns)
+{
+	qsort(ns, opt.rounds, sizeof(double), ns_cmp);
+	printf("BENCH db_%s %.1f ns\n", name, ns[opt.rounds / 2]);
+	fflush(stdout);
+}
+
+static pagenum_t root_page()
+{
+	int h = pageScan(table_id, 0);
+	pagenum_t root = b_M.frameArray[h].frame_h->root_page;
+	clearPin(h);
+	pageUnlatch(h);
+	return root;
+}
+
+static int64_t page_count()
+{
+	int h = pageScan(table_id, 0);
+	int64_t n = b_M.frameArray[h].frame_h->page_num;
+	clearPin(h);
+	pageUnlatch(h);
+	return n;
+}
+
+static void bench_buf_hit(double * ns)
+{
+	pagenum_t root = root_page();
+	for (int r = 0; r < opt.rounds; r++) {
+		uint64_t start = stat_ns();
+		for (int i = 0; i < opt.ops; i++) {
+			int index = pageScan(table_id, root);
+			clearPin(index);
+			pageUnlatch(index);
+		}
+		ns[r] = (double)(stat_ns() - start) / opt.ops;
+	}
+}
+
+//1 ~ n-1 페이지를 소수 간격으로 건너뛰며 읽어서 순서대로 읽을때의 이득을 빼고
+//한바퀴가 프레임보다 훨씬 길어 거의 모든 접근이 교체로 이어진다
+static void bench_buf_miss(double * ns)
+{
+	int64_t n = page_count() - 1;
+	int64_t pos = 0;
+	for (int r = 0; r < opt.rounds; r++) {
+		uint64_t start = stat_ns();
+		for (int i = 0; i < opt.ops; i++) {
+			pos = (pos + 7919) % n;
+			int index = pageScan(table_id, pos + 1);
+			clearPin(index);
+			pageUnlatch(index);
+		}
+		ns[r] = (double)(stat_ns() - start) / opt.ops;
+	}
+}
+
+static int bench_lock(double * acq, double * rel)
+{
+	for (int r = 0; r < opt.rounds; r++) {
+		int trx_id = trx_begin();
+		if (trx_id <= 0) return FAIL;
+		uint64_t start = stat_ns();
+		for (int i = 0; i < opt.ops; i++)
+			if (lock_acquire(table_id, i % opt.keys, trx_id, 0) == NULL) return FAIL;
+		uint64_t mid = stat_ns();
+		if (trx_commit(trx_id) != trx_id) return FAIL;
+		acq[r] = (double)(mid - start) / opt.ops;
+		rel[r] = (double)(stat_ns() - mid) / opt.ops;
+	}
+	return SUCCESS;
+}
+
+//page/key는 실제 레코드를 가리키지 않는다, commit만 하므로 로그가 페이지에 적용되지 않는다
+static int bench_log(double * ns)
+{
+	char old_image[val_max], new_image[val_max];
+	memset(old_image, 'o', sizeof(old_image) - 1);
+	memset(new_image, 'n', sizeof(new_image) - 1);
+	old_image[sizeof(old_image) - 1] = new_image[sizeof(new_image) - 1] = 0;
+
+	for (int r = 0; r < opt.rounds; r++) {
+		int trx_id = trx_begin();
+		if (trx_id <= 0) return FAIL;
+		uint64_t start = stat_ns();
+		for (int i = 0; i < opt.ops; i++)
+			log_update(trx_id, table_id, 1, i, old_image, new_image, 0);
+		ns[r] = (double)(stat_ns() - start) / opt.ops;
+		if (trx_commit(trx_id) != trx_id) return FAIL;
+	}
+	return SUCCESS;
+}
+
+static void usage(const char * name)
+{
+	fprintf(stderr, "usage : %s [-k keys] [-b frames] [-n ops per round] [-r rounds] [-f table path]\n", name);
+}
+
+static int parse_opt(int argc, char ** argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "k:b:n:r:f:h")) != -1) {
+		switch (c) {
+		case 'k': opt.keys = atoll(optarg); break;
+		case 'b': opt.frames = atoi(optarg); break;
+		case 'n': opt.ops = atoi(optarg); break;
+		case 'r': opt.rounds = atoi(optarg); break;
+		case 'f': opt.path = optarg; break;
+		default: return FAIL;
+		}
+	}
+	if (opt.keys < 2 || opt.frames < 8 || opt.ops < 1 || opt.rounds < 1) return FAIL;
+	return SUCCESS;
+}
+
+int main(int argc, char ** argv)
+{
+	if (parse_opt(argc, argv) != SUCCESS) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	char log_path[300], msg_path[300], ckpt_path[310];
+	snprintf(log_path, sizeof(log_path), "%s.log", opt.path);
+	snprintf(msg_path, sizeof(msg_path), "%s.msg", opt.path);
+	snprintf(ckpt_path, sizeof(ckpt_path), "%s.ckpt", log_path);
+	unlink(opt.path);
+	unlink(log_path);
+	unlink(msg_path);
+	unlink(ckpt_path);
+
+	if (init_db(opt.frames, 0, 0, log_path, msg_path) != SUCCESS) return 1;
+	table_id = open_table(opt.path);
+	if (table_id == FAIL) return 1;
+	char val[val_max];
+	for (int64_t k = 0; k < opt.keys; k++) {
+		snprintf(val, sizeof(val), "%" PRId64, k);
+		db_insert(table_id, k, val);
+	}
+	if (page_count() < 4 * opt.frames)
+		fprintf(stderr, "%s : only %" PRId64 " pages for %d frames, buf_miss will hit\n", argv[0], page_count(), opt.frames);
+
+	double * ns = (double*)malloc(opt.rounds * sizeof(double));
+	double * ns2 = (double*)malloc(opt.rounds * sizeof(double));
+
+	bench_buf_hit(ns);
+	report("buf_hit", ns);
+	bench_buf_miss(ns);
+	report("buf_miss", ns);
+	if (bench_lock(ns, ns2) != SUCCESS) {
+		fprintf(stderr, "%s : lock benchmark aborted\n", argv[0]);
+		return 1;
+	}
+	report("lock_acquire", ns);
+	report("lock_release", ns2);
+	if (bench_log(ns) != SUCCESS) {
+		fprintf(stderr, "%s : log benchmark aborted\n", argv[0]);
+		return 1;
+	}
+	report("log_append", ns);
+
+	free(ns2);
+	free(ns);
+	shutdown_db();
+	unlink(opt.path);
+	unlink(log_path);
+	unlink(msg_path);
+	unlink(ckpt_path);
+	return 0;
+}
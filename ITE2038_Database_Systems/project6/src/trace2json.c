@@ -0,0 +1,96 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+//trace_dump가 남긴 binary trace를 Chrome trace(JSON)로 바꿔 stdout에 쓴다
+//
+//./trace2json bench.trace > bench.json 후 chrome://tracing 이나 ui.perfetto.dev에서 연다
+//기다린 시간이 있는 event는 그 구간(X), 나머지는 순간(i) event가 된다
+
+static const char * trace_name[TRACE_KIND] = {
+	"latch wait",
+	"page latch",
+	"page unlatch",
+	"lock wait",
+	"page miss",
+	"log flush",
+	"log wait",
+};
+
+//args에 남길 a/b의 이름
+static const char * trace_arg[TRACE_KIND][2] = {
+	{ "kind", NULL },
+	{ "frame", "x" },
+	{ "frame", NULL },
+	{ "table_id", "key" },
+	{ "table_id", "page_num" },
+	{ "byte", "LSN" },
+	{ "LSN", NULL },
+};
+
+int main(int argc, char ** argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage : %s <trace file>\n", argv[0]);
+		return 1;
+	}
+	FILE * fp = fopen(argv[1], "rb");
+	if (!fp) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	trace_file fh;
+	if (fread(&fh, sizeof(fh), 1, fp) != 1 || fh.magic != TRACE_MAGIC || fh.ev_size != sizeof(trace_ev)) {
+		fprintf(stderr, "%s : not a trace file\n", argv[1]);
+		fclose(fp);
+		return 1;
+	}
+
+	//ts는 가장 이른 event를 0으로 맞추므로 먼저 전부 읽는다
+	trace_head * th = (trace_head*)calloc(fh.ring_num ? fh.ring_num : 1, sizeof(trace_head));
+	trace_ev ** ev = (trace_ev**)calloc(fh.ring_num ? fh.ring_num : 1, sizeof(trace_ev*));
+	if (!th || !ev) return 1;
+	uint64_t base = UINT64_MAX;
+	for (uint32_t r = 0; r < fh.ring_num; r++) {
+		if (fread(&th[r], sizeof(trace_head), 1, fp) != 1) {
+			fprintf(stderr, "%s : truncated\n", argv[1]);
+			return 1;
+		}
+		ev[r] = (trace_ev*)malloc((th[r].n ? th[r].n : 1) * sizeof(trace_ev));
+		if (!ev[r] || fread(ev[r], sizeof(trace_ev), th[r].n, fp) != th[r].n) {
+			fprintf(stderr, "%s : truncated\n", argv[1]);
+			return 1;
+		}
+		if (th[r].n && ev[r][0].ts < base) base = ev[r][0].ts;
+	}
+	fclose(fp);
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	int first = 1;
+	for (uint32_t r = 0; r < fh.ring_num; r++) {
+		printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"trace %u\"}}",
+			first ? "" : ",\n", th[r].tid, th[r].tid);
+		first = 0;
+		for (uint32_t k = 0; k < th[r].n; k++) {
+			trace_ev * e = &ev[r][k];
+			if (e->kind >= TRACE_KIND) continue;
+			//Chrome trace의 ts/dur 단위는 us
+			printf(",\n{\"name\":\"%s\",\"cat\":\"db\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,",
+				trace_name[e->kind], e->tid, (e->ts - base) / 1000.0);
+			if (e->dur) printf("\"ph\":\"X\",\"dur\":%.3f,", e->dur / 1000.0);
+			else printf("\"ph\":\"i\",\"s\":\"t\",");
+			printf("\"args\":{\"%s\":%" PRId64, trace_arg[e->kind][0], e->a);
+			if (trace_arg[e->kind][1]) printf(",\"%s\":%" PRId64, trace_arg[e->kind][1], e->b);
+			printf("}}");
+		}
+		free(ev[r]);
+	}
+	printf("\n]}\n");
+
+	free(ev);
+	free(th);
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include "trx_manager.h"
 #include "lock_manager.h"
 #include "buf_manager.h"
+#include "db_alloc.h"
 #include <stdlib.h>
 #include <time.h>
 
@@ -10,19 +11,20 @@ int trx_init()
 {
 //printf("\ntrx init start\n");
 	pthread_mutex_init(&trx_latch, NULL);
-	// Ŵ ʱȭ ϸ鼭 ÿ ߵɰ  
+	//버퍼 매니저 초기화 하면서 동시에 해줘야될거 같은데 
 	T_M.trx_table_head = (Trx*)malloc(sizeof(struct Trx));
 	T_M.trx_table_tail = (Trx*)malloc(sizeof(struct Trx));
 	if (!T_M.trx_table_head)return FAIL;
 	if (!T_M.trx_table_tail)return FAIL;
+	memset(T_M.trx_hash, 0, sizeof(T_M.trx_hash));
 
-	// ʱȭ
+	//헤드 초기화
 	T_M.trx_table_head->trx_id = HEAD;
 	T_M.trx_table_head->next = NULL;
 	T_M.trx_table_head->pre = NULL;
 	T_M.trx_table_head->trx_lock_head=NULL;
 
-	// ʱȭ
+	//테일 초기화
 	T_M.trx_table_tail->trx_id = TAIL;
 	T_M.trx_table_tail->next = NULL;
 	T_M.trx_table_tail->pre = NULL;
@@ -32,14 +34,53 @@ int trx_init()
 }
 
 
-int trx_begin()
+//trx 테이블 리스트 끝과 hash에 넣는다, trx_latch를 잡고 부른다
+static void trx_link(Trx * new_trx)
+{
+	if(T_M.trx_table_head->next==NULL){
+		new_trx->next = T_M.trx_table_tail;
+		new_trx->pre = T_M.trx_table_head;
+		T_M.trx_table_head->next=new_trx;
+		T_M.trx_table_tail->pre=new_trx;
+	}
+	else{
+		new_trx->next = T_M.trx_table_tail;
+		new_trx->pre = T_M.trx_table_tail->pre;
+		T_M.trx_table_tail->pre->next=new_trx;
+		T_M.trx_table_tail->pre=new_trx;
+	}
+
+	Trx ** b = &T_M.trx_hash[new_trx->trx_id & (TRX_HASH - 1)];
+	new_trx->hash_next = *b;
+	*b = new_trx;
+}
+
+//이 쓰레드가 지금 돌리는 trx, trx_get이 latch 없이 먼저 본다
+//trx는 begin한 쓰레드가 commit/abort하므로 지울때 그 쓰레드의 것만 비우면 된다
+static __thread Trx * trx_cur;
+
+//trx 테이블 리스트와 hash에서 뺀다, trx_latch를 잡고 부른다
+static void trx_unlink(Trx * tmp)
+{
+	tmp->next->pre = tmp->pre;
+	tmp->pre->next = tmp->next;
+
+	Trx ** b = &T_M.trx_hash[tmp->trx_id & (TRX_HASH - 1)];
+	while (*b != tmp) b = &(*b)->hash_next;
+	*b = tmp->hash_next;
+
+	if (trx_cur == tmp) trx_cur = NULL;
+}
+
+//trx를 만들어 테이블에 넣는다, begin 로그는 trx_begin이 남긴다
+static int trx_create()
 {
 //printf("\ntrx begin start\n");
 	pthread_mutex_lock(&trx_latch);
 //printf("\ntrx begin mutex lock\n");
 
-	// trx
-	Trx *new_trx=(Trx *)malloc(sizeof(struct Trx));
+	//새 trx생성
+	Trx *new_trx=(Trx *)db_obj_alloc(DB_OBJ_TRX, sizeof(struct Trx));
 	if (!new_trx) {
 		//printf("trx begin malloc error\n"); 
 		pthread_mutex_unlock(&trx_latch);
@@ -47,8 +88,8 @@ int trx_begin()
 		return 0;//fail
 	}
 
-	//trx Ŵ ʱȭ ʿϸ ϰ ۷ι trx id
-	//̰ ʱȭ 0 Ǿִ Ȯ
+	//trx 매니저 초기화가 필요하면 하고 글로벌 trx id증가
+	//이거 초기화전에 0으로 되어있는지 확인
 	if (T_M.global_trx_id == 0) {
 		//printf("T_M init\n");
 		trx_init();
@@ -56,42 +97,289 @@ int trx_begin()
 	}
 	
 
-	//۷ι ̵  
+	//글로벌 아이디 변수 증가
 	T_M.global_trx_id++;
-
-	//begin α 
-	log_BCR(T_M.global_trx_id,BEGIN);
 	
 
-	// trx ʱȭ
+	//새 trx 초기화
 	new_trx->trx_id = T_M.global_trx_id;
 	new_trx->state = 1;
 	new_trx->lastLSN = -1;
+	new_trx->firstLSN = -1;
 	new_trx->trx_lock_head = NULL;
+	new_trx->trx_lock_tail = NULL;
+	new_trx->wait_for = NULL;
+	new_trx->wait_num = 0;
+	new_trx->wait_cap = 0;
+	new_trx->wait_lock = NULL;
+	new_trx->wait_latch = NULL;
+	new_trx->snap = -1;
+	new_trx->mv = NULL;
+	new_trx->tlock_head = NULL;
+	new_trx->index_head = NULL;
+	new_trx->wbatch = NULL;
+	new_trx->wbatch_num = 0;
 	
-	if(T_M.trx_table_head->next==NULL){
-	//printf("trx_begin init trx first\n");
-		new_trx->next = T_M.trx_table_tail;
-		new_trx->pre = T_M.trx_table_head;
-		T_M.trx_table_head->next=new_trx;
-		T_M.trx_table_tail->pre=new_trx;
-		
-	}
-	else{
-		//printf("trx_begin init trx not first\n");
-		new_trx->next = T_M.trx_table_tail;
-		new_trx->pre = T_M.trx_table_tail->pre;
-		T_M.trx_table_tail->pre->next=new_trx;
-		T_M.trx_table_tail->pre=new_trx;	
-	}
+	trx_link(new_trx);
+	trx_cur = new_trx;
 
 
 
 
 //printf("trx begin end\n");
+	int trx_id = new_trx->trx_id;
 	pthread_mutex_unlock(&trx_latch);
 //printf("trx begin mutex unlock\n");
-	return new_trx->trx_id ;//success
+
+	return trx_id;//success
+}
+
+int trx_begin()
+{
+	//b_opt.numa면 이 쓰레드를 node 하나에 묶는다, 한번 묶으면 다음부터는 바로 돌아온다
+	bufBindThread();
+	int trx_id = trx_create();
+	if (!trx_id) return 0;
+
+	//begin 로그 생성, trx 테이블에 들어간 뒤라야 lastLSN을 이어줄 수 있다
+	log_BCR(trx_id, BEGIN);
+	return trx_id;
+}
+
+
+//MVCC, db_update가 덮어쓴 값(old image)을 (table_id, key)마다 새것부터 version chain으로 남긴다
+//writer는 commit할때 seq를 하나 받고(csn), snapshot trx는 begin때의 seq 이하의 csn까지만 본다
+//page의 값에서 시작해 안보이는 writer의 version을 만날때마다 그 old image로 되돌린다
+typedef struct mvcc_writer {
+	int64_t csn;//0 진행중, 양수 commit 순서, MVCC_ABORTED
+	int refs;//trx 하나 + 가리키는 version 수
+}mvcc_writer;
+
+typedef struct mvcc_ver mvcc_ver;
+typedef struct mvcc_ver {
+	mvcc_writer * w;//이 값을 덮어쓴 trx
+	mvcc_ver * next;//더 오래된 version
+	int absent;//db_insert_trx가 넣은 레코드, 그 전에는 없었다
+	char old_image[val_max];
+}mvcc_ver;
+
+typedef struct mvcc_key mvcc_key;
+typedef struct mvcc_key {
+	int table_id;
+	int64_t key;
+	mvcc_ver * ver;
+	mvcc_key * next;
+}mvcc_key;
+
+typedef struct mvcc_m {
+	pthread_mutex_t latch;//seq, snapshot 리스트
+	int64_t seq;//마지막으로 준 csn
+	int64_t horizon;//가장 오래된 snapshot, 없으면 seq. 이 이하로 commit된 version 뒤는 아무도 읽지 않는다
+	Trx * snap_head;
+	Trx * snap_tail;
+	uint64_t ver_num;//남아있는 version 수
+	mvcc_key * hash[MVCC_HASH];
+	pthread_mutex_t hash_latch[MVCC_STRIPE];//hash bucket & (MVCC_STRIPE - 1)
+}mvcc_m;
+
+static mvcc_m mvcc_M = {
+	.latch = PTHREAD_MUTEX_INITIALIZER,
+	.hash_latch = { [0 ... MVCC_STRIPE - 1] = PTHREAD_MUTEX_INITIALIZER },
+};
+
+static void mvcc_writer_put(mvcc_writer * w)
+{
+	if (__atomic_sub_fetch(&w->refs, 1, __ATOMIC_ACQ_REL) == 0) db_obj_free(DB_OBJ_MVCC_WRITER, w);
+}
+
+static mvcc_key ** mvcc_bucket(int table_id, int64_t key, pthread_mutex_t ** latch)
+{
+	uint64_t b = getKey(table_id, key) & (MVCC_HASH - 1);
+	*latch = &mvcc_M.hash_latch[b & (MVCC_STRIPE - 1)];
+	return &mvcc_M.hash[b];
+}
+
+//abort한 writer의 version은 undo가 page를 되돌린 뒤라 그대로 빼도 된다
+//horizon 이하로 commit된 첫 version 뒤는 아무도 읽지 않으므로 지운다
+//그 version이 맨 앞이면 page의 값이 누구에게나 보이므로 chain을 다 지우고 1, bucket latch를 잡고 부른다
+static int mvcc_prune(mvcc_key * k)
+{
+	int64_t h = __atomic_load_n(&mvcc_M.horizon, __ATOMIC_ACQUIRE);
+	mvcc_ver ** pp = &k->ver;
+	mvcc_ver * cut = NULL;
+	while (*pp) {
+		mvcc_ver * v = *pp;
+		int64_t csn = __atomic_load_n(&v->w->csn, __ATOMIC_ACQUIRE);
+		if (csn == MVCC_ABORTED) {
+			*pp = v->next;
+			mvcc_writer_put(v->w);
+			db_obj_free(DB_OBJ_MVCC_VER, v);
+			__atomic_sub_fetch(&mvcc_M.ver_num, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (csn > 0 && csn <= h) {
+			cut = v;
+			break;
+		}
+		pp = &v->next;
+	}
+	if (!cut) return 0;
+
+	mvcc_ver * t;
+	if (cut == k->ver) {
+		t = k->ver;
+		k->ver = NULL;
+	}
+	else {
+		t = cut->next;
+		cut->next = NULL;
+	}
+	while (t) {
+		mvcc_ver * n = t->next;
+		mvcc_writer_put(t->w);
+		db_obj_free(DB_OBJ_MVCC_VER, t);
+		__atomic_sub_fetch(&mvcc_M.ver_num, 1, __ATOMIC_RELAXED);
+		t = n;
+	}
+	return k->ver == NULL;
+}
+
+//(table_id, key) chain을 정리하고 비었으면 노드도 뺀다
+static void mvcc_prune_key(int table_id, int64_t key)
+{
+	pthread_mutex_t * latch;
+	mvcc_key ** pp = mvcc_bucket(table_id, key, &latch);
+	pthread_mutex_lock(latch);
+	while (*pp && ((*pp)->table_id != table_id || (*pp)->key != key)) pp = &(*pp)->next;
+	if (*pp && mvcc_prune(*pp)) {
+		mvcc_key * k = *pp;
+		*pp = k->next;
+		db_obj_free(DB_OBJ_MVCC_KEY, k);
+	}
+	pthread_mutex_unlock(latch);
+}
+
+//db_update가 page latch를 잡은 채로, 값을 바꾼 직후에 부른다
+//old_image가 NULL이면 없던 레코드 (db_insert_trx가 레코드를 넣기 전에 부른다)
+int mvcc_push(int table_id, int64_t key, const char * old_image, int trx_id)
+{
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	if (!t->mv) {
+		t->mv = (mvcc_writer*)db_obj_alloc(DB_OBJ_MVCC_WRITER, sizeof(struct mvcc_writer));
+		if (!t->mv) return FAIL;
+		t->mv->csn = 0;
+		t->mv->refs = 1;
+	}
+
+	mvcc_ver * v = (mvcc_ver*)db_obj_alloc(DB_OBJ_MVCC_VER, sizeof(struct mvcc_ver));
+	if (!v) return FAIL;
+	v->w = t->mv;
+	__atomic_add_fetch(&t->mv->refs, 1, __ATOMIC_RELAXED);
+	v->absent = old_image == NULL;
+	if (old_image) strncpy(v->old_image, old_image, sizeof(v->old_image));
+	else v->old_image[0] = '\0';
+
+	pthread_mutex_t * latch;
+	mvcc_key ** b = mvcc_bucket(table_id, key, &latch);
+	pthread_mutex_lock(latch);
+	mvcc_key * k = *b;
+	while (k && (k->table_id != table_id || k->key != key)) k = k->next;
+	if (!k) {
+		k = (mvcc_key*)db_obj_alloc(DB_OBJ_MVCC_KEY, sizeof(struct mvcc_key));
+		k->table_id = table_id;
+		k->key = key;
+		k->ver = NULL;
+		k->next = *b;
+		*b = k;
+	}
+	v->next = k->ver;
+	k->ver = v;
+	__atomic_add_fetch(&mvcc_M.ver_num, 1, __ATOMIC_RELAXED);
+
+	//맨 앞은 방금 넣은 진행중 version이므로 뒤쪽만 정리된다
+	mvcc_prune(k);
+	pthread_mutex_unlock(latch);
+	return SUCCESS;
+}
+
+//val에 page에서 읽은 값을 넣고 page latch를 잡은 채로 부른다, snap 시점의 값으로 바꿔준다
+//snap 시점에 없던 레코드면 FAIL (val은 그대로)
+int mvcc_read(int table_id, int64_t key, char * val, int64_t snap)
+{
+	int absent = 0;
+	pthread_mutex_t * latch;
+	mvcc_key ** b = mvcc_bucket(table_id, key, &latch);
+	pthread_mutex_lock(latch);
+	mvcc_key * k = *b;
+	while (k && (k->table_id != table_id || k->key != key)) k = k->next;
+	for (mvcc_ver * v = k ? k->ver : NULL; v; v = v->next) {
+		int64_t csn = __atomic_load_n(&v->w->csn, __ATOMIC_ACQUIRE);
+		if (csn > 0 && csn <= snap) break;
+		absent = v->absent;
+		if (!absent) strcpy(val, v->old_image);
+	}
+	pthread_mutex_unlock(latch);
+	return absent ? FAIL : SUCCESS;
+}
+
+//horizon을 다시 정한다, mvcc_M.latch를 잡고 부른다
+static void mvcc_horizon()
+{
+	int64_t h = mvcc_M.snap_head ? mvcc_M.snap_head->snap : mvcc_M.seq;
+	__atomic_store_n(&mvcc_M.horizon, h, __ATOMIC_RELEASE);
+}
+
+int trx_begin_snapshot()
+{
+	//read only이므로 로그는 남기지 않는다
+	int trx_id = trx_create();
+	if (!trx_id) return 0;
+	Trx * t = trx_get(trx_id);
+
+	pthread_mutex_lock(&mvcc_M.latch);
+	t->snap = mvcc_M.seq;
+	t->snap_next = NULL;
+	t->snap_pre = mvcc_M.snap_tail;
+	if (mvcc_M.snap_tail) mvcc_M.snap_tail->snap_next = t;
+	else mvcc_M.snap_head = t;
+	mvcc_M.snap_tail = t;
+	mvcc_horizon();
+	pthread_mutex_unlock(&mvcc_M.latch);
+
+	return trx_id;
+}
+
+//commit/abort때 lock을 풀기 전에 부른다
+//writer면 csn을 받아 (abort면 MVCC_ABORTED) version들이 보이게 하고, snapshot trx면 리스트에서 뺀다
+//자기가 남긴 chain은 아직 lock을 잡고 있을때 정리한다 (읽는 snapshot이 없으면 통째로 빠진다)
+static void mvcc_finish(Trx * t, int commit)
+{
+	if (t->snap < 0 && !t->mv) return;
+
+	pthread_mutex_lock(&mvcc_M.latch);
+	if (t->snap >= 0) {
+		if (t->snap_pre) t->snap_pre->snap_next = t->snap_next;
+		else mvcc_M.snap_head = t->snap_next;
+		if (t->snap_next) t->snap_next->snap_pre = t->snap_pre;
+		else mvcc_M.snap_tail = t->snap_pre;
+	}
+	if (t->mv) __atomic_store_n(&t->mv->csn, commit ? ++mvcc_M.seq : MVCC_ABORTED, __ATOMIC_RELEASE);
+	mvcc_horizon();
+	pthread_mutex_unlock(&mvcc_M.latch);
+
+	if (!t->mv) return;
+	for (lock_t * l = t->trx_lock_head; l; l = l->trx_next_lock)
+		if (l->change) mvcc_prune_key(l->node_ptr->table_id, l->node_ptr->record_id);
+	mvcc_writer_put(t->mv);
+	t->mv = NULL;
+}
+
+void mvccInfo()
+{
+	printf("\n<mvcc info>\n");
+	printf("commit seq : %" PRId64 " / horizon : %" PRId64 "\n", mvcc_M.seq, mvcc_M.horizon);
+	printf("version : %" PRIu64 " / snapshot : %s\n", mvcc_M.ver_num, mvcc_M.snap_head ? "running" : "none");
 }
 
 
@@ -101,7 +389,7 @@ int trx_commit(int trx_id)
 	pthread_mutex_lock(&trx_latch);
 //printf("trx commit mutex first lock\n");
 
-	//ش trx ̺ ãƿ´
+	//해당 trx을 테이블에서 찾아온다
 	Trx* tmp = trx_find(trx_id);
 	if (!tmp) {
 		pthread_mutex_unlock(&trx_latch);
@@ -110,238 +398,506 @@ int trx_commit(int trx_id)
 	}
 //printf("commit 1\n");
 	pthread_mutex_unlock(&trx_latch);
-//printf("trx commit SUCCESS mutex first unlock\n");
-	//trx ޷ִ lock ʷ ش.
-	lock_t * tmp_l;
-	lock_t * lock_free = tmp->trx_lock_head;
-
 
-	pthread_mutex_lock(&lock_table_latch);
-//printf("trx commit lock table mutex lock\n");
-	while (lock_free) {
-		tmp_l = lock_free->trx_next_lock;
-		lock_release(lock_free);
-		lock_free = tmp_l;
+	//커밋 로그를 남기고 그 LSN까지 디스크에 내려간 뒤에 lock을 푼다
+	//같이 commit하는 trx들은 log flusher가 한번의 fdatasync로 묶어서 내린다
+	//snapshot trx는 로그가 없다
+	//b_opt.elr이면 로그가 버퍼에 들어가자마자 lock을 풀고 돌아가기 전에 내려가길 기다린다
+	//풀린 값을 보고 commit하는 trx는 그 뒤에 commit 로그를 남기므로 자기 LSN까지 기다리면 앞의 것도 내려간다
+	int64_t LSN = -1;
+	if (tmp->snap < 0) {
+		//write batch에 남은 update를 commit 로그 앞에 한번에 남기고 페이지에 쓴다
+		db_wbatch_flush(tmp);
+		LSN = log_BCR(trx_id, COMMIT);
+		if (b_opt.elr) log_elr(LSN);
+		else log_flush(LSN);
+	}
+	//바뀌기 전 값의 인덱스 엔트리는 lock을 풀기 전에 지운다 (로그 없이, 남아도 찾을때 걸러진다)
+	index_del * d = tmp->index_head;
+	while (d) {
+		index_del * next = d->next;
+		db_delete_base(d->table_id, d->key);
+		db_obj_free(DB_OBJ_INDEX_DEL, d);
+		d = next;
+	}
+	//lock을 풀기 전에 csn을 받아야 이 값을 덮어쓸 다음 writer가 더 큰 csn을 받는다
+	mvcc_finish(tmp, 1);
+//printf("trx commit SUCCESS mutex first unlock\n");
+	//trx에 달려있는 lock들을 차례로 해제시켜준다. (lock마다 그 stripe latch 안에서)
+	lock_release_all(tmp->trx_lock_head);
+	lock_table_release_all(tmp->tlock_head);
+
+	if (b_opt.elr) {
+		//snapshot trx는 로그가 없으므로 lock을 먼저 푼 trx들의 commit 로그까지 기다린다
+		//csn은 lock을 풀기 전에 받으므로 이 trx가 본 값의 commit LSN은 이미 elr_LSN에 올라가 있다
+		if (tmp->snap >= 0) LSN = __atomic_load_n(&log_M.elr_LSN, __ATOMIC_ACQUIRE);
+		log_flush(LSN);
 	}
-
-	pthread_mutex_unlock(&lock_table_latch);
-//printf("trx commit lock table mutex unlock\n");
-
 	
 //printf("commit 2\n");
 	pthread_mutex_lock(&trx_latch);
 //printf("trx commit mutex second lock\n");
 
-	tmp->next->pre = tmp->pre;
-	tmp->pre->next = tmp->next;
-	free(tmp);
+	trx_unlink(tmp);
+	free(tmp->wait_for);
+	free(tmp->wbatch);
+	db_obj_free(DB_OBJ_TRX, tmp);
 
 //printf("trx commit SUCCESS end\n");
 	pthread_mutex_unlock(&trx_latch);
 
-	//Ŀ α 
-	log_BCR(trx_id, COMMIT);
-	
+	//실패시에 0을 반환
 
-	//   α׸ ۿ α Ϸ  
-	//α ۿ ִ α׷ڵ带  Ϸ ش
-	for (int i = log_M.head; i != -1; i = log_M.logRecords[i].next)
-	{
-		if (log_M.logRecords[i].type == COMMIT || log_M.logRecords[i].type == ROLLBACK || log_M.logRecords[i].type == BEGIN) {
-			log_to_file_BCR(trx_id, log_fd, &log_M.logRecords[i].frame_BCR);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
-		}
-		else if (log_M.logRecords[i].type == UPDATE) {
-			log_to_file_UP(trx_id, log_fd, &log_M.logRecords[i].frame_update);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
+//printf("trx commit SUCCESS mutex second unlock\n");
+	return trx_id;
+}
+
+
+//me의 wait-for 간선을 바꾼다, trx_latch를 잡고 부른다
+static void trx_wait_publish(Trx * me, const int * wait_for, int wait_num)
+{
+	if (me->wait_cap < wait_num) {
+		me->wait_cap = wait_num;
+		me->wait_for = (int*)realloc(me->wait_for, sizeof(int) * wait_num);
+	}
+	memcpy(me->wait_for, wait_for, sizeof(int) * wait_num);
+	me->wait_num = wait_num;
+}
+
+//wait_for(기다리는 lock 앞에 있는 lock들의 주인)를 back_id의 간선으로 남기고
+//wait-for 그래프에서 back_id로 다시 돌아오는 길이 있으면 deadlock -> ABORT
+//간선은 trx 테이블에만 있으므로 lock table의 latch 없이 trx_latch 안에서만 따라간다
+//간선을 남기는 것과 검사를 한 latch 안에서 하므로, 동시에 cycle을 만드는 두 trx 중 나중 것은 꼭 cycle을 본다
+int checkDead(int back_id, const int * wait_for, int wait_num)
+{
+	int Dead = 0;
+	pthread_mutex_lock(&trx_latch);
+
+	Trx * me = trx_find(back_id);
+	if (!me) {
+		pthread_mutex_unlock(&trx_latch);
+		return SUCCESS;
+	}
+	trx_wait_publish(me, wait_for, wait_num);
+
+	//dfs, 한번 본 trx는 다시 보지 않는다
+	int top = 0, cap = 16, seen_num = 0, seen_cap = 16;
+	int * stack = (int*)malloc(sizeof(int) * cap);
+	int * seen = (int*)malloc(sizeof(int) * seen_cap);
+	for (int i = 0; i < wait_num; i++) {
+		if (top == cap) stack = (int*)realloc(stack, sizeof(int) * (cap *= 2));
+		stack[top++] = wait_for[i];
+	}
+	while (top > 0 && !Dead) {
+		int id = stack[--top];
+		if (id == back_id) {
+			Dead = 1;
+			break;
 		}
-		else {
-			log_to_file_COM(trx_id, log_fd, &log_M.logRecords[i].frame_compensate);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
+		int k;
+		for (k = 0; k < seen_num; k++) if (seen[k] == id) break;
+		if (k < seen_num) continue;
+		if (seen_num == seen_cap) seen = (int*)realloc(seen, sizeof(int) * (seen_cap *= 2));
+		seen[seen_num++] = id;
+
+		//이미 끝난 trx는 lock도 다 놓았으므로 간선이 없다
+		Trx * t = trx_find(id);
+		if (!t) continue;
+		for (int i = 0; i < t->wait_num; i++) {
+			if (top == cap) stack = (int*)realloc(stack, sizeof(int) * (cap *= 2));
+			stack[top++] = t->wait_for[i];
 		}
 	}
-	//нÿ 0 ȯ
+	free(stack);
+	free(seen);
 
-//printf("trx commit SUCCESS mutex second unlock\n");
-	return trx_id;
+	pthread_mutex_unlock(&trx_latch);
+//printf("check dead mutext unlock-finish\n");
+
+	if(Dead) return ABORT ;
+	return SUCCESS;
 }
 
+//ids의 trx들이 blocker도 기다리게 되었다 (blocker가 그 앞에서 upgrade), 간선에 더한다
+void trx_wait_add(const int * ids, int num, int blocker)
+{
+	pthread_mutex_lock(&trx_latch);
+	for (int i = 0; i < num; i++) {
+		Trx * t = trx_find(ids[i]);
+		if (!t || t->wait_num == 0) continue;
+		int k;
+		for (k = 0; k < t->wait_num; k++) if (t->wait_for[k] == blocker) break;
+		if (k < t->wait_num) continue;
+		if (t->wait_cap == t->wait_num) {
+			t->wait_cap *= 2;
+			t->wait_for = (int*)realloc(t->wait_for, sizeof(int) * t->wait_cap);
+		}
+		t->wait_for[t->wait_num++] = blocker;
+	}
+	pthread_mutex_unlock(&trx_latch);
+}
 
-//ڽ ٸ ִ lock  trx ٸ lock ϳ ڽ Ǵٸ lock ٸ ִ deadlockȲ Ǹ ڽ abortѴ
-//ؽ    
-int checkDead(lock_t* front,int back_id)
+//lock을 받았거나 기다리지 않게 되면 간선을 지운다
+void trx_wait_clear(int trx_id)
 {
-	
-//printf("\ncheck dead start , front&back=%d,%d\n",front->owner_txn_id,back_id);
-	int Dead = 0,ch,ch2,cnt=0,front_id,cycle=0;
 	pthread_mutex_lock(&trx_latch);
-//printf("check dead mutex lock\n");
-	//ش trxãƿ
-	while(front->pre!=NULL){
-	front_id=front->owner_txn_id;
-	
-//printf("\ncheck dead continue..... , front&back=%d,%d\n",front->owner_txn_id,back_id);
-	Trx* find = trx_find(front_id);
-	if (!find) {
-		//printf("check Dead : cannot find trx in the trx table\n");
-		
-		continue;
+	Trx * me = trx_find(trx_id);
+	if (me) {
+		me->wait_num = 0;
+		me->wait_lock = NULL;
 	}
+	pthread_mutex_unlock(&trx_latch);
+}
 
-	// ٸ ִ trx id trx Ŵ شtrx lockƮ ȸѴ.
-	// lock waitε ڽ lock ٸ ִ ϳϳ 󰡸鼭 ˻
-	lock_t * tmp = find->trx_lock_head;
-	while (tmp) {
-		cnt=0;
-		cnt++;
-//printf("check dead [%d]'s lock on front id trx\n",cnt);
-		//ٸ ִ ε װ ڽ ٸ 
-		ch = trx_dead_check(tmp, back_id);
-		ch2=trx_cycle(tmp,back_id);
+//detector 모드에서 checkDead 대신 부른다, 간선과 기다리는 lock만 남기고 바로 돌아온다
+int trx_wait_set(int back_id, const int * wait_for, int wait_num, lock_t * lock)
+{
+	pthread_mutex_lock(&trx_latch);
+	Trx * me = trx_find(back_id);
+	if (me) {
+		trx_wait_publish(me, wait_for, wait_num);
+		me->wait_lock = lock;
+		me->wait_latch = lock->node_ptr->latch;
+	}
+	pthread_mutex_unlock(&trx_latch);
+	return SUCCESS;
+}
 
 
-		if (ch ==-1) {
-			//printf("check dead : FAIL-try_dead_check \n");
-			continue;
-		}
+//deadlock detector, dead_ms마다 wait-for 그래프에서 cycle을 찾는다
+//cycle마다 가장 젊은(id가 큰) trx를 victim으로 골라 깨우고, 깨어난 trx가 스스로 abort한다
+typedef struct trx_detector {
+	pthread_t thread;
+	pthread_mutex_t latch;
+	pthread_cond_t cond;
+	int run;
+	int ms;
+	uint64_t round;
+	uint64_t victim_num;
+}trx_detector;
+
+static trx_detector trx_D = { .latch = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+//detector가 한 round에 보는 그래프, 노드는 기다리는 중인 trx만
+typedef struct dead_graph {
+	int n;
+	Trx ** w;
+	int * color;//0 아직, 1 dfs path 위, 2 끝
+	int * victim;//victim으로 고른 trx는 그래프에서 빠진 것으로 본다
+	int * path;
+	int len;
+}dead_graph;
+
+static int dead_index(dead_graph * g, int trx_id)
+{
+	for (int i = 0; i < g->n; i++)
+		if (g->w[i]->trx_id == trx_id) return i;
+	return -1;
+}
 
-		else if (tmp->sleep&&ch>0) {
-		//printf("dead check : same line!!!\n");
-			Dead = 1;
-			break;
+//i에서 path 위의 trx로 돌아오는 간선이 있으면 그 cycle에서 가장 젊은 trx를 victim으로 하고 1
+//기다리지 않는 trx는 간선이 없으므로 cycle에 들지 않는다
+static int dead_dfs(dead_graph * g, int i)
+{
+	g->color[i] = 1;
+	g->path[g->len++] = i;
+	Trx * t = g->w[i];
+	for (int k = 0; k < t->wait_num; k++) {
+		int j = dead_index(g, t->wait_for[k]);
+		if (j < 0 || g->victim[j]) continue;
+		if (g->color[j] == 1) {
+			int v = j;
+			for (int p = g->len - 1; g->path[p] != j; p--)
+				if (g->w[g->path[p]]->trx_id > g->w[v]->trx_id) v = g->path[p];
+			g->victim[v] = 1;
+			return 1;
 		}
-		
+		if (g->color[j] == 0 && dead_dfs(g, j)) return 1;
+	}
+	g->color[i] = 2;
+	g->len--;
+	return 0;
+}
 
-		if(ch2==ABORT) {
-			Dead=1;
-			
+//한 round, 그래프는 trx_latch 안에서 보고 victim은 latch를 놓은 뒤 그 lock의 stripe latch 안에서 깨운다
+static void trx_dead_round(void)
+{
+	pthread_mutex_lock(&trx_latch);
+	if (T_M.trx_table_head == NULL || T_M.trx_table_head->next == NULL) {
+		pthread_mutex_unlock(&trx_latch);
+		return;
+	}
 
-			//printf("not cycle but dead\n");
+	dead_graph g;
+	g.n = 0;
+	for (Trx * t = T_M.trx_table_head->next; t != T_M.trx_table_tail; t = t->next)
+		if (t->wait_num > 0 && t->wait_lock) g.n++;
+	if (g.n < 2) {
+		pthread_mutex_unlock(&trx_latch);
+		return;
+	}
 
-			break;
+	g.w = (Trx**)malloc(sizeof(Trx*) * g.n);
+	g.color = (int*)calloc(g.n, sizeof(int));
+	g.victim = (int*)calloc(g.n, sizeof(int));
+	g.path = (int*)malloc(sizeof(int) * g.n);
+	int k = 0;
+	for (Trx * t = T_M.trx_table_head->next; t != T_M.trx_table_tail; t = t->next)
+		if (t->wait_num > 0 && t->wait_lock) g.w[k++] = t;
+
+	//cycle 하나에 victim 하나, victim을 빼고 cycle이 없어질때까지 다시 본다
+	while (1) {
+		int found = 0;
+		memset(g.color, 0, sizeof(int) * g.n);
+		for (int i = 0; i < g.n && !found; i++) {
+			if (g.victim[i] || g.color[i]) continue;
+			g.len = 0;
+			found = dead_dfs(&g, i);
 		}
-		else if(ch2==CYCLE){		
-			Dead=1;
+		if (!found) break;
+	}
 
-			//printf("cycle\n");
-			break;
+	int num = 0;
+	lock_t ** locks = (lock_t**)malloc(sizeof(lock_t*) * g.n);
+	pthread_mutex_t ** latches = (pthread_mutex_t**)malloc(sizeof(pthread_mutex_t*) * g.n);
+	int * ids = (int*)malloc(sizeof(int) * g.n);
+	for (int i = 0; i < g.n; i++) {
+		if (!g.victim[i]) continue;
+		locks[num] = g.w[i]->wait_lock;
+		latches[num] = g.w[i]->wait_latch;
+		ids[num++] = g.w[i]->trx_id;
+	}
+	pthread_mutex_unlock(&trx_latch);
 
+	//그 사이 lock을 받았거나 lock이 다른 trx에 다시 쓰였으면 건너뛴다 (lock_t는 pool로 돌아갈뿐 free되지 않는다)
+	for (int i = 0; i < num; i++) {
+		pthread_mutex_lock(latches[i]);
+		lock_t * l = locks[i];
+		if (l->owner_txn_id == ids[i] && l->sleep && l->node_ptr->latch == latches[i]) {
+			l->victim = 1;
+			lock_wake(l);
+			trx_D.victim_num++;
 		}
-		tmp=tmp->trx_next_lock;
+		pthread_mutex_unlock(latches[i]);
 	}
-		front=front->pre;
+
+	free(locks);
+	free(latches);
+	free(ids);
+	free(g.w);
+	free(g.color);
+	free(g.victim);
+	free(g.path);
+}
+
+static void * trx_detector_func(void * arg)
+{
+	pthread_mutex_lock(&trx_D.latch);
+	while (trx_D.run) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += (long)trx_D.ms * 1000000;
+		ts.tv_sec += ts.tv_nsec / 1000000000;
+		ts.tv_nsec %= 1000000000;
+		pthread_cond_timedwait(&trx_D.cond, &trx_D.latch, &ts);
+		if (!trx_D.run) break;
+
+		pthread_mutex_unlock(&trx_D.latch);
+		trx_dead_round();
+		pthread_mutex_lock(&trx_D.latch);
+		trx_D.round++;
 	}
-	// Ȳ Ȱ abort 
-	if (Dead) {
-		trx_abort(back_id);
+	pthread_mutex_unlock(&trx_D.latch);
+
+	return NULL;
+}
+
+int trx_detector_start(int ms)
+{
+	if (trx_D.run || ms <= 0) return FAIL;
+
+	trx_D.ms = ms;
+	trx_D.run = 1;
+	pthread_create(&trx_D.thread, NULL, trx_detector_func, NULL);
+	return SUCCESS;
+}
 
-		//printf("check dead : abort complete\n");
+//shutdown_db에서 부른다
+void trx_detector_stop()
+{
+	pthread_mutex_lock(&trx_D.latch);
+	if (!trx_D.run) {
+		pthread_mutex_unlock(&trx_D.latch);
+		return;
 	}
-	
-	
-	pthread_mutex_unlock(&trx_latch);
-//printf("check dead mutext unlock-finish\n");
+	trx_D.run = 0;
+	pthread_cond_signal(&trx_D.cond);
+	pthread_mutex_unlock(&trx_D.latch);
+	pthread_join(trx_D.thread, NULL);
+}
+
+void deadInfo()
+{
+	printf("\n<deadlock detector info>\n");
+	printf("detector : %s / period : %dms\n", trx_D.run ? "on" : "off", trx_D.ms);
+	printf("round : %" PRIu64 " / victim : %" PRIu64 "\n", trx_D.round, trx_D.victim_num);
+}
 
-	if(Dead||cycle) return ABORT ;
+//trx가 commit때 지울 인덱스 엔트리에 del_key를 넣고 keep_key는 뺀다
+//trx를 돌리는 쓰레드만 부르므로 latch는 없다
+int trx_index_del(int trx_id, int table_id, int64_t del_key, int64_t keep_key)
+{
+	Trx * t = trx_get(trx_id);
+	if (!t) return FAIL;
+	for (index_del ** p = &t->index_head; *p; p = &(*p)->next) {
+		if ((*p)->table_id == table_id && (*p)->key == keep_key) {
+			index_del * d = *p;
+			*p = d->next;
+			db_obj_free(DB_OBJ_INDEX_DEL, d);
+			break;
+		}
+	}
+	index_del * d = (index_del*)db_obj_alloc(DB_OBJ_INDEX_DEL, sizeof(index_del));
+	d->table_id = table_id;
+	d->key = del_key;
+	d->next = t->index_head;
+	t->index_head = d;
 	return SUCCESS;
 }
 
-//trx ̺  ش trx lockƮ 󰡸鼭 lockAbort
-// ؽ Ƶ  ->  ˻Լ ̹ lock
+//trx 테이블에서 지우고 해당 trx의 lock리스트를 따라가면서 lockAbort실행
+//lock table의 latch는 잡지 않은채로 부른다 (lock은 하나씩 stripe latch를 잡아 푼다)
 int trx_abort(int trx_id)
 {
 //printf("\nabort start\n");
-	//شtrx ̺ ãƿ´
+	//해당trx을 테이블에서 찾아온다
+	pthread_mutex_lock(&trx_latch);
 	Trx* tmp = trx_find(trx_id);
+	pthread_mutex_unlock(&trx_latch);
 	if (!tmp) {
 		//printf("abort : trx not find - FAIL\n");
 		return FAIL;
 	}
 
-	//ش trx  Ʈ 󰡸鼭 lock_abort
-	lock_t * tmp_l;
-	lock_t * abort = tmp->trx_lock_head;
-	while (abort) {
-		tmp_l = abort->trx_next_lock;
-		lock_release(abort);
-		abort = tmp_l;
+	//write batch에 남은 update는 로그도 페이지도 없으므로 버리기만 한다
+	tmp->wbatch_num = 0;
+	//lastLSN부터 preLSN을 따라가면서 update를 되돌리고 compensate log발급
+	//lock을 풀기 전에 되돌려야 다른 trx가 되돌리기 전 값을 읽지 않는다
+	int64_t trace = tmp->lastLSN;
+	while (trace >= 0) {
+		trace = log_undo(trx_id, trace, NULL);
+	}
 
+	//무사히 다끝나면 rollback 발급, commit과 같이 log flusher가 내린다
+	if (tmp->snap < 0) log_flush(log_BCR(trx_id,ROLLBACK));
+	//page가 다 되돌려졌으므로 이 trx의 version은 빼도 된다
+	mvcc_finish(tmp, 0);
+	//값이 되돌아갔으므로 예전 엔트리는 그대로 둔다
+	while (tmp->index_head) {
+		index_del * d = tmp->index_head;
+		tmp->index_head = d->next;
+		db_obj_free(DB_OBJ_INDEX_DEL, d);
 	}
 
-	//ش trx ̺ 
-	tmp->next->pre = tmp->pre;
-	tmp->pre->next = tmp->next;
-	free(tmp);
+	//해당 trx의 락 리스트를 따라가면서 lock_abort
+	lock_release_all(tmp->trx_lock_head);
+	lock_table_release_all(tmp->tlock_head);
 
+	//해당 trx를 테이블에서 지운다
+	pthread_mutex_lock(&trx_latch);
+	trx_unlink(tmp);
+	pthread_mutex_unlock(&trx_latch);
+	free(tmp->wait_for);
+	free(tmp->wbatch);
+	db_obj_free(DB_OBJ_TRX, tmp);
 
-	//compensate log߱
-	int trace = tmp->lastLSN;
-	while (1) {
+//printf("abort end\n");
+	return SUCCESS;
+}
 
-		//ش ڵ preLSN 󰡸鼭 compensate  - update log 쿡
+//analysis에서 로그에 나온 가장 큰 trx id 뒤부터 새 id를 주도록 한다
+void trx_set_id(int64_t trx_id)
+{
+	pthread_mutex_lock(&trx_latch);
+	if (T_M.trx_table_head == NULL) trx_init();
+	if (T_M.global_trx_id < trx_id) T_M.global_trx_id = trx_id;
+	pthread_mutex_unlock(&trx_latch);
+}
 
-		//-1ΰ ش trx ڵ尡 ̻ ٴ 
-		//trace=
-	}
+//analysis에서 찾은 loser를 undo가 끝날때까지 trx 테이블에 다시 올린다
+//compensate/rollback 로그가 lastLSN에 이어진다
+Trx * trx_restore(int trx_id, int lastLSN)
+{
+	Trx *new_trx=(Trx *)db_obj_alloc(DB_OBJ_TRX, sizeof(struct Trx));
+	if (!new_trx) return NULL;
 
+	pthread_mutex_lock(&trx_latch);
+	if (T_M.trx_table_head == NULL) trx_init();
+	if (T_M.global_trx_id < trx_id) T_M.global_trx_id = trx_id;
+
+	new_trx->trx_id = trx_id;
+	new_trx->state = 3;
+	new_trx->lastLSN = lastLSN;
+	//begin 위치를 모르므로 checkpoint가 로그를 지우지 않게 한다
+	new_trx->firstLSN = 0;
+	new_trx->trx_lock_head = NULL;
+	new_trx->trx_lock_tail = NULL;
+	new_trx->wait_for = NULL;
+	new_trx->wait_num = 0;
+	new_trx->wait_cap = 0;
+	new_trx->wait_lock = NULL;
+	new_trx->wait_latch = NULL;
+	new_trx->snap = -1;
+	new_trx->mv = NULL;
+	new_trx->tlock_head = NULL;
+	new_trx->index_head = NULL;
+	new_trx->wbatch = NULL;
+	new_trx->wbatch_num = 0;
+
+	trx_link(new_trx);
+	pthread_mutex_unlock(&trx_latch);
 
-	// ٳ rollback ߱
-	log_BCR(trx_id,ROLLBACK);
+	return new_trx;
+}
 
-	//α ۿ ִ α׷ڵ带  Ϸ ش
-	for (int i = log_M.head; i !=-1; i=log_M.logRecords[i].next)
-	{
-		if (log_M.logRecords[i].type == COMMIT || log_M.logRecords[i].type == ROLLBACK || log_M.logRecords[i].type == BEGIN) {
-			log_to_file_BCR(trx_id, log_fd, &log_M.logRecords[i].frame_BCR);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
-		}
-		else if (log_M.logRecords[i].type == UPDATE) {
-			log_to_file_UP(trx_id, log_fd, &log_M.logRecords[i].frame_update);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
-		}
-		else {
-			log_to_file_COM(trx_id, log_fd, &log_M.logRecords[i].frame_compensate);
-			log_M.logRecords[i].next = -1;
-			log_M.logRecords[i].pre = -1;
-		}
+//lock이 없는 trx(recovery의 loser)를 테이블에서 지운다
+int trx_remove(int trx_id)
+{
+	pthread_mutex_lock(&trx_latch);
+	Trx* tmp = trx_find(trx_id);
+	if (!tmp) {
+		pthread_mutex_unlock(&trx_latch);
+		return FAIL;
 	}
+	trx_unlink(tmp);
+	free(tmp->wait_for);
+	free(tmp->wbatch);
+	db_obj_free(DB_OBJ_TRX, tmp);
+	pthread_mutex_unlock(&trx_latch);
 
-//printf("abort end\n");
 	return SUCCESS;
 }
 
-//ش trx ޾ƿ  ޾ش.
-//ؽ ϰ  
+//해당 trx에 받아온 락을 달아준다.
+//뮤텍스락 하고 끝날때 해제
 int trx_lock(int trx_id, lock_t * lock)
 {
 //printf("\ntrx lock start\n");
-	//ش trx ãƿ´
-	Trx* find = trx_find(trx_id);
+	//해당 trx를 찾아온다
+	Trx* find = trx_get(trx_id);
 	if(!find) return FAIL;
 //printf("trx lock 1\n");
-	//ƮŽ
-	lock_t * find_l = find->trx_lock_head;
-
-	if(find_l==NULL){
+	//tail 뒤에 바로 붙인다
+	lock->trx_next_lock = NULL;
+	if(find->trx_lock_head==NULL){
 //printf("trx lock , find_l is NULL-> first this trx's lock\n");
 		find->trx_lock_head=lock;
-		lock->trx_next_lock=NULL;
 	}
 	else{
 //printf("trx lock , not first this trx's lock\n");
-		while ( find_l->trx_next_lock!= NULL) {
-			find_l = find_l->trx_next_lock;
-		}
-
-	//while Դٴ° ڽ  lock̶  -> ⿡   ޾ش
-		find_l->trx_next_lock = lock;
-		lock->trx_next_lock = NULL;
+		find->trx_lock_tail->trx_next_lock = lock;
 	}
+	find->trx_lock_tail = lock;
 
 //printf("trx lock end\n");
 	
@@ -349,7 +905,20 @@ int trx_lock(int trx_id, lock_t * lock)
 }
 
 
-//ؽ ʿ - 긦 ȣϴ Լʿ ̹ 
+//trx_latch를 잡고 찾는다, 자기 trx처럼 찾은 뒤에 다른 쓰레드가 지우지 않는 trx를 찾을때 쓴다
+//이 쓰레드가 begin한 trx면 latch 없이 바로 돌려준다
+Trx * trx_get(int trx_id)
+{
+	Trx * cur = trx_cur;
+	if (cur && cur->trx_id == trx_id) return cur;
+
+	pthread_mutex_lock(&trx_latch);
+	Trx * find = trx_find(trx_id);
+	pthread_mutex_unlock(&trx_latch);
+	return find;
+}
+
+//뮤텍스 불필요 - 얘를 호출하는 함수쪽에서 이미 잡고있음
 Trx * trx_find(int trx_id) {
 //printf("\ntrx find start\n");
 if(T_M.global_trx_id==0) {
@@ -357,110 +926,17 @@ if(T_M.global_trx_id==0) {
 	return NULL;
 
 }
-	//ش trx ã´
-	int ch = 0;
-	Trx *tmp = T_M.trx_table_head->next;
-	if(tmp==NULL) return NULL;
-	while (tmp != T_M.trx_table_tail) {
-		if (tmp->trx_id == trx_id) {
-			ch = 1;
-			break;
-		}
-		tmp = tmp->next;
-	}
-	//ٸ 
-	if (!ch) {
+	//해당 trx를 찾는다 (hash bucket의 chain만 본다)
+	Trx *tmp = T_M.trx_hash[trx_id & (TRX_HASH - 1)];
+	while (tmp && tmp->trx_id != trx_id) tmp = tmp->hash_next;
+	//없다면 실패
+	if (!tmp) {
 		//printf("cannot find this trx in the trx table\n");
 		return NULL;
 	}
 //printf("trx find end -found!!\n");
 	return tmp;
 }
-int trx_cycle(lock_t* obj,int back_id){
-	//find acquireds
-if(obj==NULL)return FAIL;
-//sleep(1);
-int id;
-lock_t * first;
-lock_t * tmp;
-int wait=obj->owner_txn_id;
-
-if(!obj->sleep)return SUCCESS;
-	while(obj->pre!=NULL){
-		if(!obj->sleep){
-	
-			id=obj->owner_txn_id;
-			if(id==back_id){
-					
-			
-					return ABORT;
-			}
-
-			first=trx_find(id)->trx_lock_head;
-			while(first){
-
-				if(first->sleep){
-
-					tmp=first->pre;
-					while(tmp->pre!=NULL){
-					if(!tmp->sleep&&tmp->owner_txn_id==back_id) {
-
-	
-						return CYCLE;
-					}
-					tmp=tmp->pre;
-					}
-					
-				}
-				first=first->trx_next_lock;
-			}
-		}
-		obj=obj->pre;
-	}
-
-}
-
-
-
-//ڽ  ٸ  Ȯ
-int trx_dead_check(lock_t * obj,int back_id)
-{
-//printf("\ntrx dead check start\n");
-	if(obj==NULL) {
-//printf("trx dead check : obj == NULL\n");
-		return -1;
-	}
-	if(!obj->sleep)return 0;
-	Node * myNode = obj->node_ptr;
-	if(myNode ==NULL){
-//printf("trx dead check : myNode== NULL\n");
-		return -1;
-	}		
-	lock_t * tmp = myNode->head->next;//׷ڵ  Ʈ ù lock Ʈ
-	int cnt = 0;
-//printf("trx dead check 1\n");
-	if (!tmp) {
-//printf("trx dead check FAIL end: empty node\n");
-		return 0;
-	}
-
-
-	while (tmp->next != NULL&&tmp!=obj) {
-		if (tmp->owner_txn_id == back_id) {
-			cnt++;
-		}
-		tmp = tmp->next;
-	}
-
-	if (cnt != 0) {
-		//printf("trx dead check ABORT end\n");
-		return cnt;
-	}
-	
-//printf("trx dead chech SUCCESS end : cnt=%d\n",cnt);
-	return cnt;
-}
-
 int trx_duplicate(lock_t * tmp,int back_id)
 {
 //printf("\ntrx dup check start\n");
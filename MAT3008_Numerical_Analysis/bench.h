@@ -0,0 +1,151 @@
+﻿#pragma once
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+// 짧은 계산의 실행 시간을 재는 도구
+// clock()은 해상도가 낮아 수 us짜리 계산은 0으로 나온다. 여기서는
+// steady_clock으로 한 묶음(reps번 반복)의 시간을 재서 한 번의 시간으로 나누고,
+// 묶음을 여러 번 재서 중앙값과 사분위 범위를 구한다
+
+struct BenchResult {
+	double median;		// 한 번 실행 시간의 중앙값 (ns)
+	double low, high;	// 25%, 75% 분위 (ns)
+	int samples;		// 잰 묶음의 수
+	long long reps;		// 묶음 하나의 반복 횟수
+
+	// 중앙값에 대한 사분위 범위의 비율
+	double spread() const { return median > 0 ? (high - low) / median : 0; }
+};
+
+// 정렬된 v에서 q 분위 값
+inline double benchQuantile(const std::vector<double> &v, double q)
+{
+	double pos = q * (v.size() - 1);
+	size_t i = (size_t)pos;
+	if (i + 1 >= v.size()) return v.back();
+	return v[i] + (v[i + 1] - v[i]) * (pos - i);
+}
+
+// fn()을 반복 실행해 한 번의 시간을 잰다 (fn은 double로 바꿀 수 있는 값을 돌려준다)
+// 묶음 하나가 0.2ms 이상 걸리도록 reps를 두 배씩 늘리고,
+// 사분위 범위가 중앙값의 5% 안에 들거나 budget(초)를 다 쓸 때까지 묶음을 더 잰다
+template <typename Fn>
+BenchResult benchmark(Fn fn, double budget = 0.2)
+{
+	typedef std::chrono::steady_clock clk;
+	const double SAMPLE_NS = 2e5;
+	const int MIN_SAMPLES = 7, MAX_SAMPLES = 101;
+	const double STABLE = 0.05;
+	volatile double sink = 0;	// 결과를 쓰지 않으면 계산이 최적화로 사라진다
+
+	auto run = [&](long long reps) {
+		clk::time_point start = clk::now();
+		for (long long r = 0; r < reps; r++) sink = sink + fn();
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clk::now() - start).count();
+	};
+
+	BenchResult res;
+	res.reps = 1;
+	double total = 0, ns;
+	while ((ns = run(res.reps)) < SAMPLE_NS && res.reps < (1LL << 30)) {
+		total += ns;
+		res.reps *= 2;
+	}
+
+	std::vector<double> t, sorted;
+	t.push_back(ns / res.reps);
+	total += ns;
+	for (;;) {
+		sorted = t;
+		std::sort(sorted.begin(), sorted.end());
+		res.samples = (int)t.size();
+		res.median = benchQuantile(sorted, 0.5);
+		res.low = benchQuantile(sorted, 0.25);
+		res.high = benchQuantile(sorted, 0.75);
+		if (res.samples >= MIN_SAMPLES && (res.spread() < STABLE || total > budget * 1e9)) break;
+		if (res.samples >= MAX_SAMPLES) break;
+		ns = run(res.reps);
+		total += ns;
+		t.push_back(ns / res.reps);
+	}
+	return res;
+}
+
+// 함수 평가 횟수
+inline long long &benchEvals()
+{
+	static long long n = 0;
+	return n;
+}
+
+// 함수 포인터를 받는 루틴에 넘겨서 평가 횟수를 세는 함수
+// counted(f)는 부를 때마다 benchEvals()를 하나 올리고 f를 부르는 함수를 돌려준다
+// (한 번에 하나의 f만 셀 수 있다)
+template <typename T>
+struct EvalCounter {
+	static T (*func)(T);
+	static void (*funcd)(T, T &, T &);
+
+	static T call(T x) {
+		benchEvals()++;
+		return func(x);
+	}
+	static void calld(T x, T &y, T &dy) {
+		benchEvals()++;
+		funcd(x, y, dy);
+	}
+};
+template <typename T> T (*EvalCounter<T>::func)(T) = 0;
+template <typename T> void (*EvalCounter<T>::funcd)(T, T &, T &) = 0;
+
+template <typename T>
+T (*counted(T (*f)(T)))(T)
+{
+	EvalCounter<T>::func = f;
+	return EvalCounter<T>::call;
+}
+
+template <typename T>
+void (*counted(void (*f)(T, T &, T &)))(T, T &, T &)
+{
+	EvalCounter<T>::funcd = f;
+	return EvalCounter<T>::calld;
+}
+
+// 벤치마크 결과를 한 줄씩 쓰는 CSV 파일
+class BenchCsv {
+public:
+	BenchCsv() : fp(NULL) {}
+	~BenchCsv() { close(); }
+
+	bool open(const char *name) {
+		close();
+		fp = fopen(name, "w");
+		if (fp == NULL) return false;
+		fprintf(fp, "problem,method,xacc,root,iterations,evaluations,median_ns,p25_ns,p75_ns,samples,reps\n");
+		return true;
+	}
+
+	void close() {
+		if (fp) fclose(fp);
+		fp = NULL;
+	}
+
+	bool isOpen() const { return fp != NULL; }
+
+	// iterations를 모르면 -1
+	void row(const char *problem, const char *method, double xacc, double root,
+		int iterations, long long evals, const BenchResult &r) {
+		if (fp == NULL) return;
+		fprintf(fp, "%s,%s,%g,%.10f,%d,%lld,%.1f,%.1f,%.1f,%d,%lld\n", problem, method, xacc, root,
+			iterations, evals, r.median, r.low, r.high, r.samples, r.reps);
+	}
+
+private:
+	BenchCsv(const BenchCsv &);
+	BenchCsv &operator=(const BenchCsv &);
+
+	FILE *fp;
+};
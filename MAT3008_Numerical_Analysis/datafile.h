@@ -0,0 +1,246 @@
+﻿#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 공백으로 구분된 숫자 데이터 파일을 빠르게 읽는다
+// 파일 전체를 메모리에 매핑(윈도우에서는 한 번에 fread)하고
+// fscanf 대신 직접 만든 파서로 숫자를 읽는다
+
+// 매핑한 파일 한 개
+class DataFile {
+public:
+	DataFile() : text(NULL), len(0), mapped(false) {}
+	~DataFile() { close(); }
+
+	// 파일을 연다. 실패하면 false
+	bool open(const char *name) {
+		close();
+#ifndef _WIN32
+		int fd = ::open(name, O_RDONLY);
+		struct stat st;
+		if (fd < 0) return false;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			return false;
+		}
+		len = (size_t)st.st_size;
+		if (len > 0) {
+			void *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				madvise(p, len, MADV_SEQUENTIAL);
+				text = (const char *)p;
+				mapped = true;
+			}
+		}
+		::close(fd);
+		if (mapped || len == 0) return true;
+#endif
+		FILE *fp = fopen(name, "rb");
+		if (fp == NULL) return false;
+		fseek(fp, 0, SEEK_END);
+		len = (size_t)ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		char *buf = (char *)malloc(len + 1);
+		if (buf == NULL || fread(buf, 1, len, fp) != len) {
+			free(buf);
+			fclose(fp);
+			len = 0;
+			return false;
+		}
+		fclose(fp);
+		text = buf;
+		return true;
+	}
+
+	void close() {
+#ifndef _WIN32
+		if (mapped) munmap((void *)text, len);
+		else
+#endif
+			free((void *)text);
+		text = NULL;
+		len = 0;
+		mapped = false;
+	}
+
+	const char *begin() const { return text; }
+	const char *end() const { return text + len; }
+
+private:
+	DataFile(const DataFile &);
+	DataFile &operator=(const DataFile &);
+
+	const char *text;
+	size_t len;
+	bool mapped;	// mmap이면 true, fread 버퍼면 false
+};
+
+// 10의 거듭제곱 (double로 정확히 나타나는 범위)
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// [p, end)에서 숫자 하나를 읽어 *v에 넣고 다음 위치를 돌려준다
+// 앞의 공백은 건너뛰고, 숫자가 없으면 NULL을 돌려준다
+// 유효숫자 15자리, 지수 22 이내는 double로 정확히 계산하고
+// 그 밖의 드문 경우는 strtod에 맡긴다
+inline const char *parseFloat(const char *p, const char *end, float *v)
+{
+	while (p < end && isBlank(*p)) p++;
+	if (p == end) return NULL;
+
+	const char *start = p;
+	bool neg = false;
+	unsigned long long mant = 0;
+	int digits = 0, scale = 0;
+	bool any = false;
+
+	if (*p == '-' || *p == '+') neg = (*p++ == '-');
+	for (; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+		if (digits < 19) {
+			mant = mant * 10 + (*p - '0');
+			if (mant) digits++;
+		}
+		else scale++;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+			if (digits < 19) {
+				mant = mant * 10 + (*p - '0');
+				if (mant) digits++;
+				scale--;
+			}
+		}
+	}
+	if (!any) return NULL;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char *q = p + 1;
+		bool eneg = false;
+		int e = 0;
+		if (q < end && (*q == '-' || *q == '+')) eneg = (*q++ == '-');
+		if (q < end && *q >= '0' && *q <= '9') {
+			for (; q < end && *q >= '0' && *q <= '9'; q++)
+				if (e < 10000) e = e * 10 + (*q - '0');
+			scale += eneg ? -e : e;
+			p = q;
+		}
+	}
+
+	if (digits <= 15 && scale >= -22 && scale <= 22) {
+		double d = (double)mant;
+		d = scale < 0 ? d / POW10[-scale] : d * POW10[scale];
+		*v = (float)(neg ? -d : d);
+	}
+	else {
+		// strtod는 NUL로 끝나는 문자열이 필요하다
+		char tmp[128];
+		size_t n = (size_t)(p - start);
+		if (n >= sizeof(tmp)) n = sizeof(tmp) - 1;
+		memcpy(tmp, start, n);
+		tmp[n] = '\0';
+		*v = (float)strtod(tmp, NULL);
+	}
+	return p;
+}
+
+// 파일을 앞에서부터 한 행씩 읽는다 (메모리는 파일 크기와 상관없다)
+class DataReader {
+public:
+	DataReader() : p(NULL) {}
+
+	bool open(const char *name) {
+		if (!file.open(name)) return false;
+		p = file.begin();
+		return true;
+	}
+
+	// 숫자 n개를 row에 읽는다. 다 읽지 못하면 false
+	bool next(float *row, int n) {
+		for (int i = 0; i < n; i++) {
+			const char *q = p ? parseFloat(p, file.end(), &row[i]) : NULL;
+			if (q == NULL) {
+				p = NULL;
+				return false;
+			}
+			p = q;
+		}
+		return true;
+	}
+
+private:
+	DataFile file;
+	const char *p;
+};
+
+// [p, end)의 행들을 ncol개의 열 배열 cols[]에 덧붙인다
+inline void parseColumns(const char *p, const char *end, int ncol, std::vector<float> *cols)
+{
+	std::vector<float> row(ncol);
+
+	for (;;) {
+		for (int i = 0; i < ncol; i++) {
+			p = parseFloat(p, end, &row[i]);
+			if (p == NULL) return;
+		}
+		for (int i = 0; i < ncol; i++) cols[i].push_back(row[i]);
+	}
+}
+
+// 한 행에 숫자 ncol개씩 있는 파일을 열마다 연속된 배열 cols[0..ncol-1]로 읽는다
+// threads > 1이면 파일을 줄바꿈에 맞춘 조각으로 나누어 동시에 읽는다
+// 읽은 행의 수를 돌려주고, 파일을 열지 못하면 -1
+inline int loadColumns(const char *name, int ncol, std::vector<float> *cols, int threads = 1)
+{
+	DataFile file;
+	if (!file.open(name)) return -1;
+
+	const char *b = file.begin(), *e = file.end();
+	size_t len = (size_t)(e - b);
+	if (threads < 1) threads = 1;
+	if (len < (size_t)threads * 65536) threads = 1;
+
+	// 조각의 경계를 다음 줄의 시작으로 옮긴다
+	std::vector<const char *> cut(threads + 1);
+	cut[0] = b;
+	cut[threads] = e;
+	for (int t = 1; t < threads; t++) {
+		const char *q = b + len / threads * t;
+		if (q < cut[t - 1]) q = cut[t - 1];
+		while (q < e && *q != '\n') q++;
+		cut[t] = q < e ? q + 1 : e;
+	}
+
+	std::vector<std::vector<float> > part((size_t)threads * ncol);
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++)
+		pool.push_back(std::thread(parseColumns, cut[t], cut[t + 1], ncol, &part[(size_t)t * ncol]));
+	parseColumns(cut[0], cut[1], ncol, &part[0]);
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+
+	size_t rows = 0;
+	for (int t = 0; t < threads; t++) rows += part[(size_t)t * ncol].size();
+	for (int i = 0; i < ncol; i++) {
+		cols[i].clear();
+		cols[i].reserve(rows);
+		for (int t = 0; t < threads; t++) {
+			const std::vector<float> &v = part[(size_t)t * ncol + i];
+			cols[i].insert(cols[i].end(), v.begin(), v.end());
+		}
+	}
+	return (int)rows;
+}
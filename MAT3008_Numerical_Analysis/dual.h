@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <cmath>
+
+// 전진 모드 자동 미분에 쓰는 이원수 v + d*e (e*e = 0)
+// 함수를 T에 대한 템플릿으로 한 번만 쓰면, T = Dual<double>로 불렀을 때
+// 함숫값과 미분값이 한 번의 계산으로 같이 나온다. 연산마다 연쇄 법칙을 그대로
+// 적용하므로 손으로 미분한 식과 달리 f와 f'이 서로 어긋날 일이 없다
+//   template <typename T> T f(T x) { return exp(-x) * cos(x) - 0.5; }
+//   Dual<double> r = f(Dual<double>(x, 1));	// r.v = f(x), r.d = f'(x)
+// 연산자와 수학 함수는 클래스 안의 friend로 두어 ADL로만 찾아지게 했다.
+// 템플릿 인자를 추론하지 않으므로 0.5나 2 같은 상수가 T로 그대로 바뀐다
+
+template <typename T>
+struct Dual {
+	T v;	// 함숫값
+	T d;	// 미분값
+
+	Dual(const T &v_ = 0, const T &d_ = 0) : v(v_), d(d_) {}
+
+	friend Dual operator+(const Dual &a) { return a; }
+	friend Dual operator-(const Dual &a) { return Dual(-a.v, -a.d); }
+
+	friend Dual operator+(const Dual &a, const Dual &b) { return Dual(a.v + b.v, a.d + b.d); }
+	friend Dual operator+(const Dual &a, const T &b) { return Dual(a.v + b, a.d); }
+	friend Dual operator+(const T &a, const Dual &b) { return Dual(a + b.v, b.d); }
+
+	friend Dual operator-(const Dual &a, const Dual &b) { return Dual(a.v - b.v, a.d - b.d); }
+	friend Dual operator-(const Dual &a, const T &b) { return Dual(a.v - b, a.d); }
+	friend Dual operator-(const T &a, const Dual &b) { return Dual(a - b.v, -b.d); }
+
+	friend Dual operator*(const Dual &a, const Dual &b) { return Dual(a.v * b.v, a.d * b.v + a.v * b.d); }
+	friend Dual operator*(const Dual &a, const T &b) { return Dual(a.v * b, a.d * b); }
+	friend Dual operator*(const T &a, const Dual &b) { return Dual(a * b.v, a * b.d); }
+
+	friend Dual operator/(const Dual &a, const Dual &b) {
+		T q = a.v / b.v;
+		return Dual(q, (a.d - q * b.d) / b.v);
+	}
+	friend Dual operator/(const Dual &a, const T &b) { return Dual(a.v / b, a.d / b); }
+	friend Dual operator/(const T &a, const Dual &b) {
+		T q = a / b.v;
+		return Dual(q, -q * b.d / b.v);
+	}
+
+	Dual &operator+=(const Dual &b) { return *this = *this + b; }
+	Dual &operator-=(const Dual &b) { return *this = *this - b; }
+	Dual &operator*=(const Dual &b) { return *this = *this * b; }
+	Dual &operator/=(const Dual &b) { return *this = *this / b; }
+
+	// 비교는 함숫값으로만 한다 (분기가 있는 함수도 그대로 쓸 수 있다)
+	friend bool operator<(const Dual &a, const Dual &b) { return a.v < b.v; }
+	friend bool operator>(const Dual &a, const Dual &b) { return a.v > b.v; }
+	friend bool operator<=(const Dual &a, const Dual &b) { return a.v <= b.v; }
+	friend bool operator>=(const Dual &a, const Dual &b) { return a.v >= b.v; }
+
+	friend Dual exp(const Dual &a) {
+		T e = std::exp(a.v);
+		return Dual(e, e * a.d);
+	}
+	friend Dual log(const Dual &a) { return Dual(std::log(a.v), a.d / a.v); }
+	friend Dual sqrt(const Dual &a) {
+		T s = std::sqrt(a.v);
+		return Dual(s, a.d / (2 * s));
+	}
+	friend Dual sin(const Dual &a) { return Dual(std::sin(a.v), std::cos(a.v) * a.d); }
+	friend Dual cos(const Dual &a) { return Dual(std::cos(a.v), -std::sin(a.v) * a.d); }
+	friend Dual tan(const Dual &a) {
+		T t = std::tan(a.v);
+		return Dual(t, (1 + t * t) * a.d);
+	}
+	friend Dual fabs(const Dual &a) { return a.v < 0 ? -a : a; }
+	// 지수가 상수일 때: (x^p)' = p x^(p-1) x'
+	friend Dual pow(const Dual &a, const T &p) {
+		T r = std::pow(a.v, p - 1);
+		return Dual(r * a.v, p * r * a.d);
+	}
+};
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "machar.cpp"
 #include "machar_double.cpp"
+#include "../machar.h"
 
 
 float get_eps_float() {
@@ -17,6 +18,20 @@ double get_eps_double() {
 	return eps * 2;
 }
 
+// machar()가 실행 중에 구한 값과 컴파일 시간 상수 Machar<T>가 모두 같은지 확인한다
+template <typename T>
+bool check_machar(int ibeta, int it, int irnd, int ngrd, int machep, int negep,
+	int iexp, int minexp, int maxexp, T eps, T epsneg, T xmin, T xmax) {
+	typedef Machar<T> M;
+	return ibeta == M::ibeta && it == M::it && irnd == M::irnd && ngrd == M::ngrd
+		&& machep == M::machep && negep == M::negep && iexp == M::iexp
+		&& minexp == M::minexp && maxexp == M::maxexp
+		&& eps == M::eps && epsneg == M::epsneg && xmin == M::xmin && xmax == M::xmax;
+}
+
+// 상수식에 쓸 수 있다
+static_assert(Machar<float>::eps > 0 && Machar<double>::eps < Machar<float>::eps, "");
+
 int main() {
 	// Method 1
 	printf("Machine epsilon by machar():\n");
@@ -27,9 +42,13 @@ int main() {
 		&f_eps_1, &f_epsneg, &f_xmin, &f_xmax);
 
 	printf("Epsilon of float:  %g (%.23f)\n", f_eps_1, f_eps_1);
+	bool f_match = check_machar(ibeta, it, irnd, ngrd, machep, negep, iexp, minexp, maxexp,
+		f_eps_1, f_epsneg, f_xmin, f_xmax);
 	double d_eps_1, d_epsneg, d_xmin, d_xmax;
 	machar_double(&ibeta, &it, &irnd, &ngrd, &machep, &negep, &iexp, &minexp, &maxexp,
 		&d_eps_1, &d_epsneg, &d_xmin, &d_xmax);
+	bool d_match = check_machar(ibeta, it, irnd, ngrd, machep, negep, iexp, minexp, maxexp,
+		d_eps_1, d_epsneg, d_xmin, d_xmax);
 
 	printf("Epsilon of double: %g (%.52f)\n", d_eps_1, d_eps_1);
 	printf("\n");
@@ -45,5 +64,12 @@ int main() {
 	printf("Difference: \n");
 	printf("Epsilon of float:  %.23f\n", f_eps_1 - f_eps_2);
 	printf("Epsilon of double: %.52f\n", d_eps_1 - d_eps_2);
-	return 0;
+	printf("\n");
+
+	// Method 3
+	printf("Compile-time Machar<T> (machar.h):\n");
+	printf("Epsilon of float:  %g (%s machar())\n", Machar<float>::eps, f_match ? "matches" : "DIFFERS from");
+	printf("Epsilon of double: %g (%s machar())\n", Machar<double>::eps, d_match ? "matches" : "DIFFERS from");
+	printf("Epsilon of long double: %Lg\n", Machar<long double>::eps);
+	return f_match && d_match ? 0 : 1;
 }
\ No newline at end of file
@@ -10,6 +10,9 @@
 #include <opencv2/videoio.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/core.hpp>
+#include "../matrix.h"
+#include "../datafile.h"
+#include "../philox.h"
 using namespace cv;
 using namespace std;
 
@@ -20,7 +23,7 @@ void SWAP(float*a, float*b) {
 }
 
 
-void gaussj(float**a, float**b, int n, int m)
+void gaussj(Matrix<float> &a, Matrix<float> &b, int n, int m)
 {
 	int i, icol, irow, j, k, l, ll;
 	float big, dum, pivinv;
@@ -77,7 +80,7 @@ void gaussj(float**a, float**b, int n, int m)
 
 
 void mrqcof(float *x, float* y, float* sig, float* a,
-	int *ia, float**alpha, float* beta, float *chisq,
+	int *ia, Matrix<float> &alpha, float* beta, float *chisq,
 	void funcs(const float, float* , float *, float*),int ma, int ndata)
 {
 	int i, j, k, l, m, mfit = 0;
@@ -113,7 +116,7 @@ void mrqcof(float *x, float* y, float* sig, float* a,
 }
 
 
-void covsrt(float ** covar, int ia[], const int mfit,int ma)
+void covsrt(Matrix<float> &covar, int ia[], const int mfit,int ma)
 {
 	int i, j, k;
 
@@ -131,19 +134,13 @@ void covsrt(float ** covar, int ia[], const int mfit,int ma)
 
 
 void mrqmin(float x[], float y[], float sig[], int ndata, float a[], int ia[],
-	int ma, float **covar, float **alpha, float *chisq,
+	int ma, Matrix<float> &covar, Matrix<float> &alpha, float *chisq,
 	void(*funcs)(float, float[], float *, float[]), float *alamda){
 	static int mfit;
 	static float ochisq;
 	int j, k, l;
 	//printf("mrq1\n");
-	static float** oneda = (float**)calloc(ma, sizeof(float*));
-	for (int i = 0; i < ma; i++)
-	{
-		//printf("mrq1..??^^.\n");
-
-		oneda[i] = (float*)calloc(1, sizeof(float));
-	}
+	Matrix<float> oneda(ma, 1);
 	
 	static float* atry = (float*)calloc(ma, sizeof(float));
 	static float *beta = (float*)calloc(ma, sizeof(float));
@@ -160,11 +157,7 @@ void mrqmin(float x[], float y[], float sig[], int ndata, float a[], int ia[],
 		for (j = 0; j < ma; j++) atry[j] = a[j];
 	}
 
-	static float** temp = (float**)calloc(mfit, sizeof(float*));
-	for (int i = 0; i < ma; i++)
-	{
-		temp[i] = (float*)calloc(mfit, sizeof(float));
-	}
+	Matrix<float> temp(ma, ma);
 	//printf("mrq3\n");
 
 	for (j = 0; j < mfit; j++) {
@@ -187,7 +180,7 @@ void mrqmin(float x[], float y[], float sig[], int ndata, float a[], int ia[],
 
 	}
 
-	gaussj(temp, oneda,mfit,ma);
+	gaussj(temp, oneda,mfit,1);
 	//printf("mrq4-2\n");
 
 	for (j = 0; j < mfit; j++) {
@@ -263,13 +256,8 @@ void run_mrqmin(vector<pair<Point2f, Point2f>> &correspondences, float a[], cons
 	float *sig = (float*)calloc(ndata, sizeof(float));
 	int *ia = (int*)calloc(ma, sizeof(int));
 	//printf("run1\n");
-	float **covar = (float**)calloc(ma, sizeof(float*));
-	float **alpha = (float**)calloc(ma, sizeof(float*));
-	for (int i = 0; i < ma; i++)
-	{
-		covar[i] = (float*)calloc(ma, sizeof(float));
-		alpha[i] = (float*)calloc(ma, sizeof(float));
-	}
+	Matrix<float> covar(ma, ma);
+	Matrix<float> alpha(ma, ma);
 	float chisq;
 	float alamda;
 	//printf("run2\n");
@@ -297,30 +285,308 @@ void run_mrqmin(vector<pair<Point2f, Point2f>> &correspondences, float a[], cons
 }
 
 
+//============================================================================================
+//호모그래피 8개 매개변수를 x', y' 두 식에 함께 맞추는 Levenberg-Marquardt
+//a[0..7] : x' = (a0 x + a1 y + a2) / D, y' = (a3 x + a4 y + a5) / D, D = a6 x + a7 y + 1
+//(mrqmin의 a[1..8]과 같은 순서)
+//
+//점마다 funcs를 부르는 mrqcof 대신 모든 점의 잔차와 야코비안을 한 번에 구한다.
+//두 식이 같은 분모 D를 쓰므로 1/D를 한 번만 계산하고, 야코비안의 0인 칸
+//(x' 식의 a3..a5, y' 식의 a0..a2)은 건너뛴다.
+//점에 대한 루프는 배열만 읽고 쓰므로 컴파일러가 SIMD로 바꿀 수 있다
+
+//점 데이터를 열마다 연속된 배열로 둔다
+struct HomographyData {
+	vector<float> x, y, xp, yp;
+};
+
+//합을 LANES개로 나누어 더하는 내적 (나누어 더하면 -ffast-math 없이도 벡터화된다)
+static double dot_lanes(const float *p, const float *q, int n) {
+	const int LANES = 8;
+	float part[LANES] = { 0 };
+	int i = 0;
+	for (; i + LANES <= n; i += LANES)
+		for (int l = 0; l < LANES; l++) part[l] += p[i + l] * q[i + l];
+	double sum = 0;
+	for (int l = 0; l < LANES; l++) sum += part[l];
+	for (; i < n; i++) sum += p[i] * q[i];
+	return sum;
+}
+
+//a에서의 J^T J(alpha, 8 x 8)와 J^T r(beta)을 만들고 chi^2을 돌려준다
+//work는 점마다의 중간값을 두는 곳으로, 한 번 잡아 두면 반복마다 다시 할당하지 않는다
+static float homography_normal(const float a[8], const HomographyData &d,
+	Matrix<float> &alpha, float beta[8], vector<float> work[10]) {
+	int n = (int)d.x.size();
+	for (int c = 0; c < 10; c++) work[c].resize(n);
+	float *u = work[0].data(), *v = work[1].data(), *w = work[2].data();
+	float *up = work[3].data(), *vp = work[4].data(), *uq = work[5].data(), *vq = work[6].data();
+	float *rx = work[7].data(), *ry = work[8].data(), *pq = work[9].data();
+	const float *x = d.x.data(), *y = d.y.data(), *xp = d.xp.data(), *yp = d.yp.data();
+
+	//점마다: 1/D, 예측값 p, q, 잔차, 야코비안의 0이 아닌 칸
+	for (int i = 0; i < n; i++) {
+		float inv = 1.0f / (a[6] * x[i] + a[7] * y[i] + 1);
+		float p = (a[0] * x[i] + a[1] * y[i] + a[2]) * inv;
+		float q = (a[3] * x[i] + a[4] * y[i] + a[5]) * inv;
+		u[i] = x[i] * inv;
+		v[i] = y[i] * inv;
+		w[i] = inv;
+		up[i] = -u[i] * p;
+		vp[i] = -v[i] * p;
+		uq[i] = -u[i] * q;
+		vq[i] = -v[i] * q;
+		rx[i] = xp[i] - p;
+		ry[i] = yp[i] - q;
+		pq[i] = 0;
+	}
+
+	//x' 식의 야코비안 행: [u v w 0 0 0 up vp], y' 식: [0 0 0 u v w uq vq]
+	const float *g[3] = { u, v, w };
+	double uvw[3][3];
+	for (int j = 0; j < 3; j++)
+		for (int k = 0; k <= j; k++) uvw[j][k] = uvw[k][j] = dot_lanes(g[j], g[k], n);
+
+	alpha.fill(0);
+	for (int j = 0; j < 3; j++)
+		for (int k = 0; k < 3; k++) alpha[j][k] = alpha[j + 3][k + 3] = (float)uvw[j][k];
+	for (int j = 0; j < 3; j++) {
+		alpha[j][6] = alpha[6][j] = (float)dot_lanes(g[j], up, n);
+		alpha[j][7] = alpha[7][j] = (float)dot_lanes(g[j], vp, n);
+		alpha[j + 3][6] = alpha[6][j + 3] = (float)dot_lanes(g[j], uq, n);
+		alpha[j + 3][7] = alpha[7][j + 3] = (float)dot_lanes(g[j], vq, n);
+		beta[j] = (float)dot_lanes(g[j], rx, n);
+		beta[j + 3] = (float)dot_lanes(g[j], ry, n);
+	}
+	alpha[6][6] = (float)(dot_lanes(up, up, n) + dot_lanes(uq, uq, n));
+	alpha[7][7] = (float)(dot_lanes(vp, vp, n) + dot_lanes(vq, vq, n));
+	alpha[6][7] = alpha[7][6] = (float)(dot_lanes(up, vp, n) + dot_lanes(uq, vq, n));
+	beta[6] = (float)(dot_lanes(up, rx, n) + dot_lanes(uq, ry, n));
+	beta[7] = (float)(dot_lanes(vp, rx, n) + dot_lanes(vq, ry, n));
+
+	return (float)(dot_lanes(rx, rx, n) + dot_lanes(ry, ry, n));
+}
+
+//a를 초기값으로 받아 8개 매개변수를 함께 맞추고 최종 chi^2을 돌려준다
+//lambda 조절은 mrqmin과 같다 (좋아지면 0.1배, 나빠지면 10배)
+float fit_homography(const HomographyData &d, float a[8], int max_iter = 100) {
+	const int MA = 8;
+	Matrix<float> alpha(MA, MA), talpha(MA, MA), temp(MA, MA), da(MA, 1);
+	float beta[MA], tbeta[MA], atry[MA];
+	vector<float> work[10];
+	float lambda = 0.001f;
+
+	float chisq = homography_normal(a, d, alpha, beta, work);
+	for (int it = 0; it < max_iter; it++) {
+		temp = alpha;
+		for (int j = 0; j < MA; j++) {
+			temp[j][j] = alpha[j][j] * (1.0f + lambda);
+			da[j][0] = beta[j];
+		}
+		gaussj(temp, da, MA, 1);
+		for (int j = 0; j < MA; j++) atry[j] = a[j] + da[j][0];
+
+		float tchisq = homography_normal(atry, d, talpha, tbeta, work);
+		if (tchisq < chisq) {
+			bool done = chisq - tchisq <= 1e-7f * chisq;
+			lambda *= 0.1f;
+			chisq = tchisq;
+			alpha = talpha;
+			for (int j = 0; j < MA; j++) {
+				beta[j] = tbeta[j];
+				a[j] = atry[j];
+			}
+			if (done) break;
+		}
+		else {
+			lambda *= 10.0f;
+			if (lambda > 1e10f) break;
+		}
+	}
+	return chisq;
+}
+
+//============================================================================================
+//RANSAC: 잘못 짝지어진 점(outlier)이 섞여 있어도 호모그래피를 안정적으로 구한다
+//임의의 4점으로 DLT 해를 만들고 오차가 thresh 안인 점(inlier) 수로 평가해서
+//가장 많은 inlier를 얻은 해를 고른다. LM은 그 inlier들에만 맞춘다
+
+//4점 (x, y) -> (xp, yp)를 정확히 지나는 호모그래피 h[0..7] (DLT, h33 = 1)
+//8 x 8 연립방정식을 부분 피벗팅 가우스 소거로 푼다. 세 점이 한 직선 위에 있는 등
+//해가 없으면 false
+static bool dlt4(const HomographyData &d, const int idx[4], float h[8]) {
+	double m[8][9];
+
+	for (int k = 0; k < 4; k++) {
+		double x = d.x[idx[k]], y = d.y[idx[k]], xp = d.xp[idx[k]], yp = d.yp[idx[k]];
+		double r0[9] = { x, y, 1, 0, 0, 0, -x * xp, -y * xp, xp };
+		double r1[9] = { 0, 0, 0, x, y, 1, -x * yp, -y * yp, yp };
+		for (int c = 0; c < 9; c++) {
+			m[2 * k][c] = r0[c];
+			m[2 * k + 1][c] = r1[c];
+		}
+	}
+	for (int c = 0; c < 8; c++) {
+		int piv = c;
+		for (int r = c + 1; r < 8; r++)
+			if (fabs(m[r][c]) > fabs(m[piv][c])) piv = r;
+		if (fabs(m[piv][c]) < 1e-12) return false;
+		if (piv != c)
+			for (int k = 0; k < 9; k++) {
+				double t = m[c][k];
+				m[c][k] = m[piv][k];
+				m[piv][k] = t;
+			}
+		for (int r = c + 1; r < 8; r++) {
+			double f = m[r][c] / m[c][c];
+			for (int k = c; k < 9; k++) m[r][k] -= f * m[c][k];
+		}
+	}
+	for (int c = 7; c >= 0; c--) {
+		double sum = m[c][8];
+		for (int k = c + 1; k < 8; k++) sum -= m[c][k] * h[k];
+		h[c] = (float)(sum / m[c][c]);
+	}
+	return true;
+}
+
+//h로 옮긴 점과 (xp, yp)의 거리가 thresh 이내인 점의 수 (mask가 있으면 표시도 한다)
+static int count_inliers(const HomographyData &d, const float h[8], float thresh, char *mask) {
+	int n = (int)d.x.size(), cnt = 0;
+	const float *x = d.x.data(), *y = d.y.data(), *xp = d.xp.data(), *yp = d.yp.data();
+	const float t2 = thresh * thresh;
+
+	for (int i = 0; i < n; i++) {
+		float inv = 1.0f / (h[6] * x[i] + h[7] * y[i] + 1);
+		float ex = (h[0] * x[i] + h[1] * y[i] + h[2]) * inv - xp[i];
+		float ey = (h[3] * x[i] + h[4] * y[i] + h[5]) * inv - yp[i];
+		int in = ex * ex + ey * ey < t2;
+		if (mask) mask[i] = (char)in;
+		cnt += in;
+	}
+	return cnt;
+}
+
+//it번째 가설의 서로 다른 4점 (Philox의 it번째 블록으로 뽑으므로 스레드 수와 상관없다)
+static void sample4(const Philox &gen, uint64_t it, int n, int idx[4]) {
+	uint32_t u[4];
+	int sorted[4];
+
+	gen.block(it, u);
+	for (int k = 0; k < 4; k++) {
+		int v = (int)(u[k] % (uint32_t)(n - k));
+		//이미 뽑은 번호를 작은 것부터 건너뛰면 겹치지 않는다
+		int j = 0;
+		for (; j < k && sorted[j] <= v; j++) v++;
+		for (int l = k; l > j; l--) sorted[l] = sorted[l - 1];
+		sorted[j] = v;
+		idx[k] = v;
+	}
+}
+
+struct RansacResult {
+	float h[8];
+	vector<char> inlier;	// 점마다 inlier이면 1
+	int inliers;
+	int iterations;		// 평가한 가설 수
+};
+
+//가설을 ROUND개씩 묶어 threads개의 스레드가 나누어 평가하고, 묶음이 끝날 때마다
+//지금까지의 최대 inlier 비율 w로 필요한 반복 수 log(1 - confidence) / log(1 - w^4)를
+//다시 구해 그만큼 했으면 멈춘다 (결과는 스레드 수와 상관없이 같다)
+RansacResult ransac_homography(const HomographyData &d, float thresh, float confidence = 0.99f,
+	int max_iter = 2000, int threads = (int)thread::hardware_concurrency(), uint64_t seed = 1) {
+	const int ROUND = 64;
+	int n = (int)d.x.size();
+	Philox gen(seed);
+	RansacResult res;
+	vector<int> count(ROUND);
+	vector<float> hyp((size_t)ROUND * 8);
+	long need = max_iter;
+
+	res.inliers = 0;
+	res.iterations = 0;
+	for (int j = 0; j < 8; j++) res.h[j] = j == 0 || j == 4 ? 1.0f : 0.0f;
+	if (threads < 1) threads = 1;
+	if (n < 4) return res;
+
+	while (res.iterations < need) {
+		int batch = (int)min<long>(ROUND, need - res.iterations);
+		uint64_t first = (uint64_t)res.iterations;
+		auto work = [&](int b0, int b1) {
+			int idx[4];
+			for (int b = b0; b < b1; b++) {
+				float *h = &hyp[(size_t)b * 8];
+				sample4(gen, first + b, n, idx);
+				count[b] = dlt4(d, idx, h) ? count_inliers(d, h, thresh, NULL) : 0;
+			}
+		};
+
+		int nt = min(threads, batch), chunk = (batch + nt - 1) / nt;
+		vector<thread> pool;
+		for (int t = 1; t < nt; t++)
+			pool.push_back(thread(work, min(batch, t * chunk), min(batch, (t + 1) * chunk)));
+		work(0, min(batch, chunk));
+		for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+
+		for (int b = 0; b < batch; b++)
+			if (count[b] > res.inliers) {
+				res.inliers = count[b];
+				for (int j = 0; j < 8; j++) res.h[j] = hyp[(size_t)b * 8 + j];
+			}
+		res.iterations += batch;
+
+		double w = (double)res.inliers / n, w4 = w * w * w * w;
+		if (w4 >= 1.0) break;
+		if (w4 > 0) need = min<long>(max_iter, (long)ceil(log(1 - confidence) / log(1 - w4)));
+	}
+
+	res.inlier.resize(n);
+	res.inliers = count_inliers(d, res.h, thresh, res.inlier.data());
+	return res;
+}
+
+//RANSAC으로 inlier를 고르고 그 점들로만 LM을 돌린다. inlier 수를 돌려준다
+int fit_homography_robust(const HomographyData &d, float a[8], float thresh, float *chisq) {
+	RansacResult r = ransac_homography(d, thresh);
+	HomographyData in;
+
+	for (size_t i = 0; i < d.x.size(); i++)
+		if (r.inlier[i]) {
+			in.x.push_back(d.x[i]);
+			in.y.push_back(d.y[i]);
+			in.xp.push_back(d.xp[i]);
+			in.yp.push_back(d.yp[i]);
+		}
+	for (int j = 0; j < 8; j++) a[j] = r.h[j];
+	*chisq = fit_homography(in, a);
+	return r.inliers;
+}
+
+
 int main() {
 	const char * fileName="sample_data.txt";
-	FILE* fp = fopen(fileName, "r");
+	vector<float> cols[4];
+	int rows = loadColumns(fileName, 4, cols, thread::hardware_concurrency());
 	//구현을 완료하지 못했습니다. 죄송합니다
 
-	const int ma = 8;
-	float *a = (float*)calloc(ma, sizeof(float));
-	fill(a + 1, a + ma + 1, 2); 
-	vector<pair<Point2f, Point2f>> correspondences;
-	float p1_x, p1_y, p2_x, p2_y;
-	while (fscanf(fp,"%f %f %f %f",&p1_x,&p1_y,&p2_x,&p2_y)>0) {
-		Point2f a(p1_x, p1_y);
-		Point2f b(p2_x, p2_y);
-		correspondences.push_back({a ,b});
-		//printf("scanf ");
-	}
+	//x', y'를 8개 매개변수로 함께 맞춘다 (초기값은 항등 변환)
+	HomographyData d;
+	d.x = cols[0];
+	d.y = cols[1];
+	d.xp = cols[2];
+	d.yp = cols[3];
+	//RANSAC으로 outlier를 걸러낸 뒤 inlier에만 맞춘다 (오차 허용 10)
+	const float THRESH = 10;
+	float a[8], chisq;
+	int inliers = fit_homography_robust(d, a, THRESH, &chisq);
 
-	//cout << "?..";
-	run_mrqmin(correspondences, a, ma);
 	cout << "a = [";
-	for (int i = 1; i < ma; i++) {
+	for (int i = 0; i < 7; i++) {
 		cout << a[i] << ", ";
 	}
-	cout << a[ma] << "]" << endl;
+	cout << a[7] << "]" << endl;
+	cout << "chisq = " << chisq << " (" << inliers << " / " << rows << " inliers)" << endl;
 
 	return 0;
 }
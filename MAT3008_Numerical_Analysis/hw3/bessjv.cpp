@@ -0,0 +1,221 @@
+﻿#include <math.h>
+
+// bessj0, bessj1을 배열 전체에 대해 한꺼번에 계산한다
+// 원소 W개를 한 벡터에 담아 |x| < 8의 유리함수 근사와 |x| >= 8의 점근 근사를
+// 분기 없이 계산하고 마스크로 골라 담는다. 한 벡터가 모두 같은 쪽이면 그쪽만 계산한다
+// 계산은 double로 해서 double 상수를 쓰는 스칼라 버전과 정확도가 같다
+// 점근 근사에 필요한 sin, cos도 벡터로 직접 계산한다 (pi/2로 범위를 줄인 뒤 다항식)
+//
+// 컴파일 옵션에 따라 AVX-512, AVX2(+FMA), NEON(aarch64) 중 하나를 쓰고
+// 아무것도 없거나 BESSJV_SCALAR를 정의하면 스칼라 bessj0, bessj1을 차례로 부른다
+#if !defined(BESSJV_SCALAR)
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define BESSJV_AVX512
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define BESSJV_AVX2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BESSJV_NEON
+#endif
+#endif
+
+#if defined(BESSJV_AVX512)
+typedef __m512d VD;
+typedef __mmask8 VM;
+const int BESSJV_W = 8;
+static inline VD vset(double a) { return _mm512_set1_pd(a); }
+static inline VD vload(const float *p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+static inline VD vload(const double *p) { return _mm512_loadu_pd(p); }
+static inline void vstore(float *p, VD a) { _mm256_storeu_ps(p, _mm512_cvtpd_ps(a)); }
+static inline void vstore(double *p, VD a) { _mm512_storeu_pd(p, a); }
+static inline VD vadd(VD a, VD b) { return _mm512_add_pd(a, b); }
+static inline VD vsub(VD a, VD b) { return _mm512_sub_pd(a, b); }
+static inline VD vmul(VD a, VD b) { return _mm512_mul_pd(a, b); }
+static inline VD vdiv(VD a, VD b) { return _mm512_div_pd(a, b); }
+static inline VD vfma(VD a, VD b, VD c) { return _mm512_fmadd_pd(a, b, c); }
+static inline VD vsqrt(VD a) { return _mm512_sqrt_pd(a); }
+static inline VD vabs(VD a) { return _mm512_abs_pd(a); }
+static inline VD vround(VD a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+static inline VD vfloor(VD a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+static inline VM vlt(VD a, VD b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+static inline VD vsel(VM m, VD a, VD b) { return _mm512_mask_blend_pd(m, b, a); }
+static inline bool vany(VM m) { return m != 0; }
+static inline bool vall(VM m) { return m == 0xFF; }
+static const char *bessjv_kernel() { return "avx512"; }
+#elif defined(BESSJV_AVX2)
+typedef __m256d VD;
+typedef __m256d VM;
+const int BESSJV_W = 4;
+static inline VD vset(double a) { return _mm256_set1_pd(a); }
+static inline VD vload(const float *p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+static inline VD vload(const double *p) { return _mm256_loadu_pd(p); }
+static inline void vstore(float *p, VD a) { _mm_storeu_ps(p, _mm256_cvtpd_ps(a)); }
+static inline void vstore(double *p, VD a) { _mm256_storeu_pd(p, a); }
+static inline VD vadd(VD a, VD b) { return _mm256_add_pd(a, b); }
+static inline VD vsub(VD a, VD b) { return _mm256_sub_pd(a, b); }
+static inline VD vmul(VD a, VD b) { return _mm256_mul_pd(a, b); }
+static inline VD vdiv(VD a, VD b) { return _mm256_div_pd(a, b); }
+static inline VD vfma(VD a, VD b, VD c) { return _mm256_fmadd_pd(a, b, c); }
+static inline VD vsqrt(VD a) { return _mm256_sqrt_pd(a); }
+static inline VD vabs(VD a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+static inline VD vround(VD a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+static inline VD vfloor(VD a) { return _mm256_floor_pd(a); }
+static inline VM vlt(VD a, VD b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+static inline VD vsel(VM m, VD a, VD b) { return _mm256_blendv_pd(b, a, m); }
+static inline bool vany(VM m) { return _mm256_movemask_pd(m) != 0; }
+static inline bool vall(VM m) { return _mm256_movemask_pd(m) == 0xF; }
+static const char *bessjv_kernel() { return "avx2"; }
+#elif defined(BESSJV_NEON)
+typedef float64x2_t VD;
+typedef uint64x2_t VM;
+const int BESSJV_W = 2;
+static inline VD vset(double a) { return vdupq_n_f64(a); }
+static inline VD vload(const float *p) { return vcvt_f64_f32(vld1_f32(p)); }
+static inline VD vload(const double *p) { return vld1q_f64(p); }
+static inline void vstore(float *p, VD a) { vst1_f32(p, vcvt_f32_f64(a)); }
+static inline void vstore(double *p, VD a) { vst1q_f64(p, a); }
+static inline VD vadd(VD a, VD b) { return vaddq_f64(a, b); }
+static inline VD vsub(VD a, VD b) { return vsubq_f64(a, b); }
+static inline VD vmul(VD a, VD b) { return vmulq_f64(a, b); }
+static inline VD vdiv(VD a, VD b) { return vdivq_f64(a, b); }
+static inline VD vfma(VD a, VD b, VD c) { return vfmaq_f64(c, a, b); }
+static inline VD vsqrt(VD a) { return vsqrtq_f64(a); }
+static inline VD vabs(VD a) { return vabsq_f64(a); }
+static inline VD vround(VD a) { return vrndnq_f64(a); }
+static inline VD vfloor(VD a) { return vrndmq_f64(a); }
+static inline VM vlt(VD a, VD b) { return vcltq_f64(a, b); }
+static inline VD vsel(VM m, VD a, VD b) { return vbslq_f64(m, a, b); }
+static inline bool vany(VM m) { return vmaxvq_u32(vreinterpretq_u32_u64(m)) != 0; }
+static inline bool vall(VM m) { return vminvq_u32(vreinterpretq_u32_u64(m)) != 0; }
+static const char *bessjv_kernel() { return "neon"; }
+#endif
+
+#if defined(BESSJV_AVX512) || defined(BESSJV_AVX2) || defined(BESSJV_NEON)
+
+// c[0] + y*(c[1] + y*(c[2] + ...)) (c는 n개)
+static inline VD vpoly(VD y, const double *c, int n)
+{
+	VD r = vset(c[n - 1]);
+	for (int i = n - 2; i >= 0; i--) r = vfma(r, y, vset(c[i]));
+	return r;
+}
+
+// x의 sin, cos (x >= 0, |x| < 2^20 * pi/2)
+// q = round(x / (pi/2))로 r = x - q*pi/2를 [-pi/4, pi/4]로 줄이고
+// pi/2를 세 조각으로 나누어 빼서 q*pi/2의 반올림 오차를 없앤다 (fdlibm)
+// q mod 4에 따라 sin(r), cos(r)의 자리와 부호를 바꾼다
+static inline void vsincos(VD x, VD &s, VD &c)
+{
+	static const double S[] = {
+		-1.66666666666666324348e-01, 8.33333333332248946124e-03,
+		-1.98412698298579493134e-04, 2.75573137070700676789e-06,
+		-2.50507602534068634195e-08, 1.58969099521155010221e-10
+	};
+	static const double C[] = {
+		4.16666666666666019037e-02, -1.38888888888741095749e-03,
+		2.48015872894767294178e-05, -2.75573143513906633035e-07,
+		2.08757232129817482790e-09, -1.13596475577881948265e-11
+	};
+	VD q = vround(vmul(x, vset(6.36619772367581382433e-01)));
+	VD r = vfma(q, vset(-1.57079632673412561417e+00), x);
+	r = vfma(q, vset(-6.07710050630396597660e-11), r);
+	r = vfma(q, vset(-2.02226624879595063154e-21), r);
+
+	VD z = vmul(r, r);
+	VD sr = vfma(vmul(r, z), vpoly(z, S, 6), r);
+	VD cr = vfma(vmul(z, z), vpoly(z, C, 6), vfma(z, vset(-0.5), vset(1.0)));
+
+	// k = q mod 4, 홀수면 sin과 cos이 바뀐다
+	VD k = vsub(q, vmul(vset(4.0), vfloor(vmul(q, vset(0.25)))));
+	VM odd = vlt(vset(0.5), vsub(k, vmul(vset(2.0), vfloor(vmul(k, vset(0.5))))));
+	VM sneg = vlt(vset(1.5), k);
+	VD k1 = vadd(k, vset(1.0));
+	VM cneg = vlt(vset(1.5), vsub(k1, vmul(vset(4.0), vfloor(vmul(k1, vset(0.25))))));
+	VD zero = vset(0.0);
+	s = vsel(odd, cr, sr);
+	c = vsel(odd, sr, cr);
+	s = vsel(sneg, vsub(zero, s), s);
+	c = vsel(cneg, vsub(zero, c), c);
+}
+
+// NR bessj0, bessj1의 계수
+static const double J0_P1[] = { 57568490574.0, -13362590354.0, 651619640.7, -11214424.18, 77392.33017, -184.9052456 };
+static const double J0_Q1[] = { 57568490411.0, 1029532985.0, 9494680.718, 59272.64853, 267.8532712, 1.0 };
+static const double J0_P2[] = { 1.0, -0.1098628627e-2, 0.2734510407e-4, -0.2073370639e-5, 0.2093887211e-6 };
+static const double J0_Q2[] = { -0.1562499995e-1, 0.1430488765e-3, -0.6911147651e-5, 0.7621095161e-6, -0.934945152e-7 };
+static const double J1_P1[] = { 72362614232.0, -7895059235.0, 242396853.1, -2972611.439, 15704.48260, -30.16036606 };
+static const double J1_Q1[] = { 144725228442.0, 2300535178.0, 18583304.74, 99447.43394, 376.9991397, 1.0 };
+static const double J1_P2[] = { 1.0, 0.183105e-2, -0.3516396496e-4, 0.2457520174e-5, -0.240337019e-6 };
+static const double J1_Q2[] = { 0.04687499995, -0.2002690873e-3, 0.8449199096e-5, -0.88228987e-6, 0.105787412e-6 };
+
+// |x| >= 8의 점근 근사 sqrt(2/(pi x)) (cos(xx) P(y) - z sin(xx) Q(y)), xx = |x| - phase
+static inline VD vbessj_far(VD ax, const double *p, const double *q, double phase)
+{
+	VD z = vdiv(vset(8.0), ax);
+	VD y = vmul(z, z);
+	VD s, c;
+	vsincos(vsub(ax, vset(phase)), s, c);
+	VD t = vsub(vmul(c, vpoly(y, p, 5)), vmul(vmul(z, s), vpoly(y, q, 5)));
+	return vmul(vsqrt(vdiv(vset(0.636619772), ax)), t);
+}
+
+// order 0 또는 1의 bessj를 한 벡터에 대해 계산한다
+static inline VD vbessj(VD x, int order)
+{
+	VD ax = vabs(x);
+	VM inner = vlt(ax, vset(8.0));
+	VD a = vset(0.0), b = vset(0.0);
+
+	if (vany(inner)) {
+		VD y = vmul(x, x);
+		if (order == 0) a = vdiv(vpoly(y, J0_P1, 6), vpoly(y, J0_Q1, 6));
+		else a = vdiv(vmul(x, vpoly(y, J1_P1, 6)), vpoly(y, J1_Q1, 6));
+		if (vall(inner)) return a;
+	}
+	if (order == 0) b = vbessj_far(ax, J0_P2, J0_Q2, 0.785398164);
+	else {
+		b = vbessj_far(ax, J1_P2, J1_Q2, 2.356194491);
+		b = vsel(vlt(x, vset(0.0)), vsub(vset(0.0), b), b);
+	}
+	return vsel(inner, a, b);
+}
+
+template <typename T>
+static void bessjv(const T *x, T *y, int n, int order)
+{
+	int i = 0;
+
+	for (; i + BESSJV_W <= n; i += BESSJV_W)
+		vstore(y + i, vbessj(vload(x + i), order));
+	if (i < n) {
+		// 남은 원소는 0으로 채운 벡터 하나로 계산한다
+		T xt[BESSJV_W], yt[BESSJV_W];
+		for (int l = 0; l < BESSJV_W; l++) xt[l] = i + l < n ? x[i + l] : 0;
+		vstore(yt, vbessj(vload(xt), order));
+		for (int l = 0; i + l < n; l++) y[i + l] = yt[l];
+	}
+}
+
+#else
+static const char *bessjv_kernel() { return "scalar"; }
+
+template <typename T>
+static void bessjv(const T *x, T *y, int n, int order)
+{
+	for (int i = 0; i < n; i++) y[i] = order == 0 ? NR::bessj0(x[i]) : NR::bessj1(x[i]);
+}
+#endif
+
+// y[i] = bessj0(x[i]), i = 0..n-1
+void bessj0v(const DP *x, DP *y, int n)
+{
+	bessjv(x, y, n, 0);
+}
+
+// y[i] = bessj1(x[i]), i = 0..n-1
+void bessj1v(const DP *x, DP *y, int n)
+{
+	bessjv(x, y, n, 1);
+}
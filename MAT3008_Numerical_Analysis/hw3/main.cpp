@@ -3,6 +3,10 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <time.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "rtbis.cpp"
 #include "rtflsp.cpp"
 #include "rtnewt.cpp"
@@ -11,41 +15,188 @@
 
 #include "bessj0.cpp"
 #include "bessj1.cpp"
+#include "bessjv.cpp"
+#include "../bench.h"
 using namespace NR;
 typedef float DP;
 
 
+//main에 파일 이름을 주면 측정 결과를 csv로도 남긴다
+static BenchCsv bench_csv;
+
 //아래의 두 함수는 타입에 맞는 함수를 받아와서 root를 찾게 한 후
 //걸린 시간과 root값을 구하는 것이다.
-void run_and_clock_1(DP(*method)(DP(*func)(DP), DP, DP, DP),
+//clock()으로는 수 us짜리 계산이 0으로 나오므로 root마다 benchmark로
+//여러 번 반복해서 잰 중앙값을 쓰고, 함수 평가 횟수도 함께 센다
+void run_and_clock_1(const char *problem, const char *name,
+	DP(*method)(DP(*func)(DP), DP, DP, DP),
 	DP(*func)(DP),
 	DP *xb1,DP *xb2,int num_roots,DP xacc) {
-	time_t start, end, total;
-	total = 0;
+	double total = 0;
 	for (int i = 1; i <= num_roots; i++) {
-		start = (double)clock() ;
-		DP root = (*method)(func, xb1[i], xb2[i], xacc);
-		end = (double)clock() ;
-		total += end - start;
-		printf("[%d]: %.10f\n", i, root);
+		benchEvals() = 0;
+		DP root = (*method)(counted(func), xb1[i], xb2[i], xacc);
+		long long evals = benchEvals();
+		BenchResult r = benchmark([&]() { return (*method)(func, xb1[i], xb2[i], xacc); });
+		total += r.median;
+		printf("[%d]: %.10f  (%lld evals, %.1fns)\n", i, root, evals, r.median);
+		bench_csv.row(problem, name, xacc, root, -1, evals, r);
 	}
 
-	printf("Time: %ldus\n\n", total* (int)1e6 / CLOCKS_PER_SEC);
+	printf("Time: %.3fus\n\n", total / 1e3);
 }
 
-void run_and_clock_2(DP(*method)(void(*func)(DP, DP &, DP &), DP, DP, DP),
+void run_and_clock_2(const char *problem, const char *name,
+	DP(*method)(void(*func)(DP, DP &, DP &), DP, DP, DP),
 	void(*func)(DP, DP &, DP &),
 	DP *xb1,DP *xb2,int num_roots,DP xacc) {
-	time_t start, end, total;
-	total = 0;
+	double total = 0;
 	for (int i = 1; i <= num_roots; i++) {
-		start = (double)clock();
-		DP root = (*method)(func, xb1[i], xb2[i], xacc);
-		end = (double)clock();
-		total += end - start;
-		printf("[%d]: %.10f\n", i, root);
+		benchEvals() = 0;
+		DP root = (*method)(counted(func), xb1[i], xb2[i], xacc);
+		long long evals = benchEvals();
+		BenchResult r = benchmark([&]() { return (*method)(func, xb1[i], xb2[i], xacc); });
+		total += r.median;
+		printf("[%d]: %.10f  (%lld evals, %.1fns)\n", i, root, evals, r.median);
+		bench_csv.row(problem, name, xacc, root, -1, evals, r);
+	}
+	printf("Time: %.3fus\n\n", total / 1e3);
+}
+/////////////////////////////////////
+
+//여러 구간의 root를 한꺼번에 구하는 함수들
+//xb1[1..num_roots], xb2[1..num_roots]는 zbrak이 찾은 구간이고
+//roots[1..num_roots]에 결과를 넣는다
+
+//계산이 비싼 함수(bessj0 등)는 구간 하나를 한 스레드가 맡는다
+//스레드마다 다음 구간 번호를 가져가므로 수렴이 느린 구간이 있어도 고르게 나뉜다
+template <typename Method, typename Func>
+void solve_batch(Method method, Func func, const DP *xb1, const DP *xb2,
+	int num_roots, DP xacc, DP *roots, int threads) {
+	std::atomic<int> next(1);
+	auto worker = [&]() {
+		for (int i; (i = next++) <= num_roots; )
+			roots[i] = (*method)(func, xb1[i], xb2[i], xacc);
+	};
+
+	if (threads > num_roots) threads = num_roots;
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++) pool.push_back(std::thread(worker));
+	worker();
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+}
+
+//계산이 싼 함수는 LANES개의 구간을 한 묶음으로 같은 반복을 함께 돌린다
+//vfunc(x, y, n)은 x[0..n-1]에서의 함수 값을 y에 한꺼번에 구한다
+//수렴한 lane은 done으로 표시해 값을 고정하고, 모든 lane이 수렴하면 끝낸다
+//lane마다의 계산은 rtbis/rtsec과 같으므로 결과도 같다
+const int LANES = 8;
+
+void rtbis_lanes(void(*vfunc)(const DP *, DP *, int), const DP *xb1, const DP *xb2,
+	int num_roots, DP xacc, DP *roots) {
+	const int JMAX = 40;
+	DP x1[LANES], x2[LANES], f[LANES], fmid[LANES], xmid[LANES], rtb[LANES], dx[LANES];
+	bool done[LANES];
+
+	for (int base = 1; base <= num_roots; base += LANES) {
+		int n = num_roots - base + 1 < LANES ? num_roots - base + 1 : LANES;
+		//남는 lane은 마지막 구간을 복사해 채운다
+		for (int l = 0; l < LANES; l++) {
+			int i = base + (l < n ? l : n - 1);
+			x1[l] = xb1[i];
+			x2[l] = xb2[i];
+		}
+		vfunc(x1, f, LANES);
+		vfunc(x2, fmid, LANES);
+		for (int l = 0; l < LANES; l++) {
+			if (f[l] * fmid[l] >= 0.0) nrerror("Root must be bracketed for bisection in rtbis_lanes");
+			rtb[l] = f[l] < 0.0 ? x1[l] : x2[l];
+			dx[l] = f[l] < 0.0 ? x2[l] - x1[l] : x1[l] - x2[l];
+			done[l] = false;
+		}
+		int left = LANES;
+		for (int j = 0; j < JMAX && left > 0; j++) {
+			for (int l = 0; l < LANES; l++) {
+				dx[l] = done[l] ? dx[l] : dx[l] * 0.5f;
+				xmid[l] = rtb[l] + dx[l];
+			}
+			vfunc(xmid, fmid, LANES);
+			for (int l = 0; l < LANES; l++) {
+				if (done[l]) continue;
+				if (fmid[l] <= 0.0) rtb[l] = xmid[l];
+				if (fabs(dx[l]) < xacc || fmid[l] == 0.0) {
+					done[l] = true;
+					left--;
+				}
+			}
+		}
+		if (left > 0) nrerror("Too many bisections in rtbis_lanes");
+		for (int l = 0; l < n; l++) roots[base + l] = rtb[l];
+	}
+}
+
+void rtsec_lanes(void(*vfunc)(const DP *, DP *, int), const DP *xb1, const DP *xb2,
+	int num_roots, DP xacc, DP *roots) {
+	const int MAXIT = 30;
+	DP x1[LANES], x2[LANES], fl[LANES], f[LANES], xl[LANES], rts[LANES], dx[LANES];
+	bool done[LANES];
+
+	for (int base = 1; base <= num_roots; base += LANES) {
+		int n = num_roots - base + 1 < LANES ? num_roots - base + 1 : LANES;
+		for (int l = 0; l < LANES; l++) {
+			int i = base + (l < n ? l : n - 1);
+			x1[l] = xb1[i];
+			x2[l] = xb2[i];
+		}
+		vfunc(x1, fl, LANES);
+		vfunc(x2, f, LANES);
+		for (int l = 0; l < LANES; l++) {
+			if (fabs(fl[l]) < fabs(f[l])) {
+				rts[l] = x1[l];
+				xl[l] = x2[l];
+				SWAP(fl[l], f[l]);
+			}
+			else {
+				xl[l] = x1[l];
+				rts[l] = x2[l];
+			}
+			done[l] = false;
+		}
+		int left = LANES;
+		for (int j = 0; j < MAXIT && left > 0; j++) {
+			for (int l = 0; l < LANES; l++) {
+				if (done[l]) continue;
+				dx[l] = (xl[l] - rts[l]) * f[l] / (f[l] - fl[l]);
+				xl[l] = rts[l];
+				fl[l] = f[l];
+				rts[l] += dx[l];
+			}
+			vfunc(rts, f, LANES);
+			for (int l = 0; l < LANES; l++) {
+				if (done[l]) continue;
+				if (fabs(dx[l]) < xacc || f[l] == 0.0) {
+					done[l] = true;
+					left--;
+				}
+			}
+		}
+		if (left > 0) nrerror("Maximum number of iterations exceeded in rtsec_lanes");
+		for (int l = 0; l < n; l++) roots[base + l] = rts[l];
 	}
-	printf("Time: %ldus\n\n", total * (int)1e6 / CLOCKS_PER_SEC);
+}
+
+//한꺼번에 구한 root를 출력하고 걸린 시간(벽시계)을 출력한다
+//스레드를 쓰면 clock()은 모든 스레드의 CPU 시간을 더하므로 쓰지 않는다
+template <typename Solve>
+void run_and_clock_batch(Solve solve, int num_roots) {
+	std::vector<DP> roots(num_roots + 1);
+	auto start = std::chrono::steady_clock::now();
+	solve(roots.data());
+	auto end = std::chrono::steady_clock::now();
+
+	for (int i = 1; i <= num_roots; i++) printf("[%d]: %.10f\n", i, roots[i]);
+	printf("Time: %ldus\n\n",
+		(long)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
 }
 /////////////////////////////////////
 
@@ -54,6 +205,26 @@ void bessj0d(DP x, DP &y, DP &dy) {
 	dy = -bessj1(x);
 }
 
+//bessj0v, bessj1v를 스칼라 bessj0, bessj1과 비교한다
+//[-100, 100]을 촘촘히 훑어 가장 큰 차이를 출력하고, 허용 오차를 넘으면 false
+//스칼라 버전은 점근 근사의 위상과 cos, sin을 float로 계산하므로 x가 클수록 차이가 조금 커진다
+bool check_bessjv() {
+	const int N = 200001;
+	const DP TOL = 1e-6;
+	std::vector<DP> x(N), y0(N), y1(N);
+	DP err0 = 0, err1 = 0;
+
+	for (int i = 0; i < N; i++) x[i] = -100 + 200 * (DP)i / (N - 1);
+	bessj0v(x.data(), y0.data(), N);
+	bessj1v(x.data(), y1.data(), N);
+	for (int i = 0; i < N; i++) {
+		err0 = fmax(err0, fabs(y0[i] - bessj0(x[i])));
+		err1 = fmax(err1, fabs(y1[i] - bessj1(x[i])));
+	}
+	printf("bessj0v/bessj1v (%s): max |diff| = %.3g, %.3g\n\n", bessjv_kernel(), err0, err1);
+	return err0 <= TOL && err1 <= TOL;
+}
+
 //zbrak 함수 재정의
 void zbrak(DP(*fx)(DP), DP x1, DP x2, int n, DP xb1[],
 	DP xb2[], int *nb)
@@ -96,24 +267,47 @@ void problem_0() {
 
 	//아래는 순서대로 다른 방식을 적용해서 root를 찾는 과정
 	printf("---------Bisection method---------\n");
-	run_and_clock_1(rtbis, bessj0, xb1, xb2, num_roots, XACC);
+	run_and_clock_1("problem0", "rtbis", rtbis, bessj0, xb1, xb2, num_roots, XACC);
 
 	printf("---------Linear interpolation---------\n");
-	run_and_clock_1(rtflsp, bessj0, xb1, xb2, num_roots, XACC);
+	run_and_clock_1("problem0", "rtflsp", rtflsp, bessj0, xb1, xb2, num_roots, XACC);
 
 	printf("---------Secant method---------\n");
-	run_and_clock_1(rtsec, bessj0, xb1, xb2, num_roots, XACC);
+	run_and_clock_1("problem0", "rtsec", rtsec, bessj0, xb1, xb2, num_roots, XACC);
 
 	//뮬러 방식은 구현하지 못하였습니다..
 	//printf("---------Muller method---------\n");
 	//run_and_clock_1(muller, bessj0, xb1, xb2, num_roots, XACC);
 
 	printf("---------Newton-Raphson method---------\n");
-	run_and_clock_2(rtnewt, bessj0d, xb1, xb2, num_roots, XACC);
+	run_and_clock_2("problem0", "rtnewt", rtnewt, bessj0d, xb1, xb2, num_roots, XACC);
 
 	printf("---------Newton with bracketing---------\n");
-	run_and_clock_2(rtsafe, bessj0d, xb1, xb2, num_roots, XACC);
-
+	run_and_clock_2("problem0", "rtsafe", rtsafe, bessj0d, xb1, xb2, num_roots, XACC);
+
+	//같은 구간들을 한꺼번에 풀기
+	int threads = (int)std::thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+
+	printf("---------Batched bisection (%d threads)---------\n", threads);
+	run_and_clock_batch([&](DP *roots) {
+		solve_batch(rtbis, bessj0, xb1, xb2, num_roots, XACC, roots, threads);
+	}, num_roots);
+
+	printf("---------Batched Newton with bracketing (%d threads)---------\n", threads);
+	run_and_clock_batch([&](DP *roots) {
+		solve_batch(rtsafe, bessj0d, xb1, xb2, num_roots, XACC, roots, threads);
+	}, num_roots);
+
+	printf("---------Batched bisection (%d lanes)---------\n", LANES);
+	run_and_clock_batch([&](DP *roots) {
+		rtbis_lanes(bessj0v, xb1, xb2, num_roots, XACC, roots);
+	}, num_roots);
+
+	printf("---------Batched secant method (%d lanes)---------\n", LANES);
+	run_and_clock_batch([&](DP *roots) {
+		rtsec_lanes(bessj0v, xb1, xb2, num_roots, XACC, roots);
+	}, num_roots);
 }
 ///////////////////////////////////////////
 
@@ -140,7 +334,7 @@ void problem_1() {
 	DP xb1[2] = { 0, X1 };
 	DP xb2[2] = { 0, X2 };
 
-	run_and_clock_2(rtsafe, func_1d, xb1, xb2, num_roots, XACC);
+	run_and_clock_2("problem1", "rtsafe", rtsafe, func_1d, xb1, xb2, num_roots, XACC);
 }
 
 //////////////////////////////////////////
@@ -168,7 +362,7 @@ void problem_2() {
 	DP xb1[2] = { 0, X1 };
 	DP xb2[2] = { 0, X2 };
 
-	run_and_clock_2(rtsafe, func_2d, xb1, xb2, num_roots, XACC);
+	run_and_clock_2("problem2", "rtsafe", rtsafe, func_2d, xb1, xb2, num_roots, XACC);
 }
 
 /////////////////////////////////////////////
@@ -196,10 +390,15 @@ void problem_3() {
 	DP xb1[2] = { 0, X1 };
 	DP xb2[2] = { 0, X2 };
 
-	run_and_clock_2(rtsafe, func_3d, xb1, xb2, num_roots, XACC);
+	run_and_clock_2("problem3", "rtsafe", rtsafe, func_3d, xb1, xb2, num_roots, XACC);
 }
 
-int main() {
+//hw3 [파일이름] : 파일 이름을 주면 측정 결과를 csv로도 남긴다
+int main(int argc, char *argv[]) {
+	if (argc > 1 && !bench_csv.open(argv[1])) printf("Cannot open %s\n", argv[1]);
+
+	if (!check_bessjv()) return 1;
+
 	//여러 방법으로 root 구해보기
 	problem_0();
 	
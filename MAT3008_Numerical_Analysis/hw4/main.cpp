@@ -3,21 +3,26 @@
 #define _USE_MATH_DEFINES
 #include <time.h>
 #include <cmath>
+#include <string.h>
 #include "rt.cpp"
+#include "../bench.h"
 
 using namespace NR;
 
+//식은 템플릿으로 한 번만 쓴다
+//DP로 부르면 함수값, Dual<DP>로 부르면 미분값까지 한 번에 나온다
+struct F1 {
+	template <typename T>
+	T operator()(T R) const {
+		return exp(-0.005 * R) * cos(sqrt(2000 - R * R * 0.01) * 0.05) - 0.01;
+	}
+};
+
 //Bisection / Linear Method 용
-DP f1(DP R) {
-	return exp(-0.005 * R) * cos(sqrt(2000 - R * R * 0.01) * 0.05) - 0.01;
-}
+DP f1(DP R) { return F1()(R); }
 
-//Newton / Secant Method 용 - 미분
-void df1(DP R, DP &y, DP &dy) {
-	y = f1(R);
-	float tmp = sqrt(2000 - R * R * 0.01) * 0.05;
-	dy = exp(-0.005 * R) * (sin(tmp) / tmp - cos(tmp)) * 0.005;
-}
+//Newton / Secant Method 용 - 미분은 자동 미분으로 구한다
+void df1(DP R, DP &y, DP &dy) { ad_funcd<DP, F1>(R, y, dy); }
 
 void problem1() {
 	printf("[Problem 1]=====================================================\n");
@@ -34,16 +39,18 @@ void problem1() {
 	rtsafe_method(df1, 0, 400, 1e-6);
 }
 
+struct F2 {
+	template <typename T>
+	T operator()(T R) const {
+		return pow(R*R + .9*.9, 1.5)*(8.85 * M_PI) / (100) - R;
+	}
+};
+
 //Bisection / Linear Method 용
-DP f2(DP R) {
-	return pow(R*R + .9*.9, 1.5)*(8.85 * M_PI) / (100) - R;
-}
+DP f2(DP R) { return F2()(R); }
 
 //Newton / Secant Method 용 - 미분
-void df2(DP R, DP &y, DP &dy) {
-	y = f2(R);
-	dy = (531 * M_PI* R*sqrt(100 * pow(R,2)+ 81) - 20000) / 20000;
-}
+void df2(DP R, DP &y, DP &dy) { ad_funcd<DP, F2>(R, y, dy); }
 
 void problem2() {
 	printf("[Problem 2]=====================================================\n");
@@ -54,16 +61,18 @@ void problem2() {
 	rtsafe_method(df2, 0, 2, 1e-4);
 }
 
+struct F3 {
+	template <typename T>
+	T operator()(T R) const {
+		return -0.20597 + 1.671e-4 * R + 9.7215e-8 * pow(R, 2) - 9.5838e-11 * pow(R, 3) + 1.9520e-14 * pow(R, 4);
+	}
+};
+
 //Bisection / Linear Method 용
-DP f3(DP R) {
-	return -0.20597 + 1.671e-4 * R + 9.7215e-8 * pow(R, 2) - 9.5838e-11 * pow(R, 3) + 1.9520e-14 * pow(R, 4);
-}
+DP f3(DP R) { return F3()(R); }
 
 //Newton / Secant Method 용 - 미분
-void df3(DP R, DP &y, DP &dy) {
-	y = f3(R);
-	dy = 1.671e-4 + 9.7215e-8 * 2 * R - 9.5838e-11 * 3 * pow(R, 2) + 1.9520e-14 * 4 * pow(R, 3);
-}
+void df3(DP R, DP &y, DP &dy) { ad_funcd<DP, F3>(R, y, dy); }
 
 void problem3() {
 	printf("[Problem 3]=====================================================\n");
@@ -74,8 +83,82 @@ void problem3() {
 	rtsafe_method(df3, 1000, 1500, 1e-4);
 }
 
+//////////////////////////////////////////
+
+//한 방법의 root, 반복 횟수, 함수 평가 횟수와 실행 시간을 출력하고 csv에 남긴다
+void bench_1(BenchCsv &csv, const char *problem, const char *name,
+	DP(*method)(DP(*)(DP), DP, DP, DP, int *), DP(*f)(DP), DP x1, DP x2, DP xacc) {
+	int num_iter = 0;
+	benchEvals() = 0;
+	DP root = method(counted(f), x1, x2, xacc, &num_iter);
+	long long evals = benchEvals();
+
+	rt_quiet = true;
+	BenchResult r = benchmark([&]() {
+		int n;
+		return method(f, x1, x2, xacc, &n);
+	});
+	rt_quiet = false;
+
+	printf("%-7s xacc %.0e: %14.10f  %2d iter %3lld evals  %9.1fns (IQR %4.1f%%)\n",
+		name, xacc, root, num_iter, evals, r.median, 100 * r.spread());
+	csv.row(problem, name, xacc, root, num_iter, evals, r);
+}
+
+void bench_2(BenchCsv &csv, const char *problem, const char *name,
+	DP(*method)(void(*)(DP, DP &, DP &), DP, DP, DP, int *), void(*df)(DP, DP &, DP &),
+	DP x1, DP x2, DP xacc) {
+	int num_iter = 0;
+	benchEvals() = 0;
+	DP root = method(counted(df), x1, x2, xacc, &num_iter);
+	long long evals = benchEvals();
+
+	rt_quiet = true;
+	BenchResult r = benchmark([&]() {
+		int n;
+		return method(df, x1, x2, xacc, &n);
+	});
+	rt_quiet = false;
+
+	printf("%-7s xacc %.0e: %14.10f  %2d iter %3lld evals  %9.1fns (IQR %4.1f%%)\n",
+		name, xacc, root, num_iter, evals, r.median, 100 * r.spread());
+	csv.row(problem, name, xacc, root, num_iter, evals, r);
+}
+
+//다섯 방법을 같은 구간에서 비교
+void bench_problem(BenchCsv &csv, const char *problem, DP(*f)(DP), void(*df)(DP, DP &, DP &),
+	DP x1, DP x2, DP xacc) {
+	bench_1(csv, problem, "rtbis", rtbis, f, x1, x2, xacc);
+	bench_1(csv, problem, "rtflsp", rtflsp, f, x1, x2, xacc);
+	bench_1(csv, problem, "rtsec", rtsec, f, x1, x2, xacc);
+	bench_2(csv, problem, "rtnewt", rtnewt, df, x1, x2, xacc);
+	bench_2(csv, problem, "rtsafe", rtsafe, df, x1, x2, xacc);
+}
+
+//hw4 bench [파일이름] : 각 문제를 방법별로 재서 csv로 남긴다
+void bench(const char *fileName) {
+	BenchCsv csv;
+	if (!csv.open(fileName)) {
+		printf("Cannot open %s\n", fileName);
+		return;
+	}
+
+	printf("[Problem 1]=====================================================\n");
+	bench_problem(csv, "problem1", f1, df1, 0, 400, 1e-4);
+	bench_problem(csv, "problem1", f1, df1, 0, 400, 1e-6);
+	printf("[Problem 2]=====================================================\n");
+	bench_problem(csv, "problem2", f2, df2, 0, 2, 1e-4);
+	printf("[Problem 3]=====================================================\n");
+	bench_problem(csv, "problem3", f3, df3, 1000, 1500, 1e-4);
+	printf("\nSaved to %s\n", fileName);
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench(argc > 2 ? argv[2] : "hw4_bench.csv");
+		return 0;
+	}
 
-int main() {
 	problem1();
 	problem2();
 	problem3();
@@ -1,18 +1,27 @@
 #include <cmath>
 #include "nr.h"
+#include "../dual.h"
 using namespace std;
 
+//ġũó    ݺ  rt_quiet  ޽ 
+static bool rt_quiet = false;
+
+static void rt_error(const char *msg) {
+	if (!rt_quiet) printf("%s", msg);
+}
+
 
 //Bisection Method
-DP rtbis(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_iter)
+template <typename T>
+T rtbis(T func(const T), const T x1, const T x2, const T xacc, int *num_iter)
 {// f(x)/// /ݺ Ƚ
 	const int JMAX = 40;
 	int j;
-	DP dx, f, fmid, xmid, rtb;
+	T dx, f, fmid, xmid, rtb;
 
 	f = func(x1);//  ־
 	fmid = func(x2); //   ־ 
-	if (f*fmid >= 0.0) printf("Root must be bracketed for bisection in rtbis\n");
+	if (f*fmid >= 0.0) rt_error("Root must be bracketed for bisection in rtbis\n");
 
 	//rtb   , dx  ũ
 	rtb = f < 0.0 ? (dx = x2 - x1, x1) : (dx = x1 - x2, x2);
@@ -40,21 +49,22 @@ DP rtbis(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_it
 	}
 
 	//Max Ž  ʰ
-	printf("Too many bisections in rtbis\n");
+	rt_error("Too many bisections in rtbis\n");
 	return 0.0;
 }
 
 //Linear interpolation Method
-DP rtflsp(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_iter)
+template <typename T>
+T rtflsp(T func(const T), const T x1, const T x2, const T xacc, int *num_iter)
 {
 	const int MAXIT = 30;
 	int j;
-	DP fl, fh, xl, xh, dx, del, f, rtf;
+	T fl, fh, xl, xh, dx, del, f, rtf;
 
 	// ۰  ־
 	fl = func(x1);
 	fh = func(x2);
-	if (fl*fh > 0.0) printf("Root must be bracketed in rtflsp\n");
+	if (fl*fh > 0.0) rt_error("Root must be bracketed in rtflsp\n");
 
 	//Լ  xl д
 	//  
@@ -100,17 +110,18 @@ DP rtflsp(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_i
 	}
 
 	//Max Ž  ʰ
-	printf("Maximum number of iterations exceeded in rtflsp\n");
+	rt_error("Maximum number of iterations exceeded in rtflsp\n");
 	return 0.0;
 }
 
 
 //Secant Method
-DP rtsec(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_iter)
+template <typename T>
+T rtsec(T func(const T), const T x1, const T x2, const T xacc, int *num_iter)
 {
 	const int MAXIT = 30;
 	int j;
-	DP fl, f, dx, xl, rts;
+	T fl, f, dx, xl, rts;
 
 	//糡 Լ Ȯ
 	fl = func(x1);
@@ -146,18 +157,32 @@ DP rtsec(DP func(const DP), const DP x1, const DP x2, const DP xacc, int *num_it
 	}
 
 	//Max Ž  ʰ
-	printf("Maximum number of iterations exceeded in rtsec\n");
+	rt_error("Maximum number of iterations exceeded in rtsec\n");
 	return 0.0;
 }
 
+//rtnewt, rtsafe ѱ funcd Լ ü F ϳ 
+//F operator() ø  Tδ Լ, Dual<T>δ ̺а ȴ
+//x ̺а 1  Dual<T>   Ѱ f df  Ƿ
+//f   ϰų ̺н  Ű  ʿ䰡 
+// Լ funcd ڸ ad_funcd<DP, F1>ó ״ ѱ  ִ
+template <typename T, typename F>
+void ad_funcd(const T x, T &f, T &df)
+{
+	Dual<T> r = F()(Dual<T>(x, 1));
+	f = r.v;
+	df = r.d;
+}
+
 //Newton-Raphson Method
-DP rtnewt(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
-	const DP xacc, int* num_iter)
+template <typename T>
+T rtnewt(void funcd(const T, T &, T &), const T x1, const T x2,
+	const T xacc, int* num_iter)
 {
 	// ߰   y=0     Ǵ 
 	const int JMAX = 20;
 	int j;
-	DP df, dx, f, rtn;
+	T df, dx, f, rtn;
 	//f Լ df  ̺а
 
 	//ʱ  P0 -> ߾Ӱ 
@@ -171,7 +196,7 @@ DP rtnewt(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
 
 		//  -> ߻?
 		if ((x1 - rtn)*(rtn - x2) < 0.0)
-			printf("Jumped out of brackets in rtnewt\n");
+			rt_error("Jumped out of brackets in rtnewt\n");
 
 		//밡  Ǿٸ  
 		if (fabs(dx) < xacc) {
@@ -181,18 +206,19 @@ DP rtnewt(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
 	}
 
 	//Max Ž  ʰ
-	printf("Maximum number of iterations exceeded in rtnewt\n");
+	rt_error("Maximum number of iterations exceeded in rtnewt\n");
 	return 0.0;
 }
 
 
 //Newton with Bracking Method
-DP rtsafe(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
-	const DP xacc, int *num_iter)
+template <typename T>
+T rtsafe(void funcd(const T, T &, T &), const T x1, const T x2,
+	const T xacc, int *num_iter)
 {
 	const int MAXIT = 100;
 	int j;
-	DP df, dx, dxold, f, fh, fl, temp, xh, xl, rts;
+	T df, dx, dxold, f, fh, fl, temp, xh, xl, rts;
 
 	//糡 Լ ̺а ˾ƿ´
 	funcd(x1, fl, df);
@@ -200,7 +226,7 @@ DP rtsafe(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
 
 
 	if ((fl > 0.0 && fh > 0.0) || (fl < 0.0 && fh < 0.0))
-		printf("Root must be bracketed in rtsafe\n");
+		rt_error("Root must be bracketed in rtsafe\n");
 
 	//ٷ Ʈ ãҴٸ ״ 
 	if (fl == 0.0) return x1;
@@ -268,10 +294,23 @@ DP rtsafe(void funcd(const DP, DP &, DP &), const DP x1, const DP x2,
 	}
 
 	//Max Ž  ʰ
-	printf("Maximum number of iterations exceeded in rtsafe\n");
+	rt_error("Maximum number of iterations exceeded in rtsafe\n");
 	return 0.0;
 }
 
+//  е ̸  д
+//(DP ٲ ʰ rtbis<double>ó    ִ)
+#define RT_INSTANTIATE(T) \
+	template T rtbis<T>(T func(const T), const T, const T, const T, int *); \
+	template T rtflsp<T>(T func(const T), const T, const T, const T, int *); \
+	template T rtsec<T>(T func(const T), const T, const T, const T, int *); \
+	template T rtnewt<T>(void funcd(const T, T &, T &), const T, const T, const T, int *); \
+	template T rtsafe<T>(void funcd(const T, T &, T &), const T, const T, const T, int *);
+RT_INSTANTIATE(float)
+RT_INSTANTIATE(double)
+RT_INSTANTIATE(long double)
+#undef RT_INSTANTIATE
+
 
 //  ؼ Ʈ  ϰ Iteration  ϱ
 void rtbis_method(DP(*f)(DP), DP x1, DP x2, DP xacc) {
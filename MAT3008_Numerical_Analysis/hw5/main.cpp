@@ -5,120 +5,107 @@
 #include <cmath>
 #include <fstream>
 #include <complex>
+#include <chrono>
 #include <iostream>
+#include <thread>
+#include <vector>
+#include "../matrix.h"
+#include "../datafile.h"
+#include "../machar.h"
+#include "../sparse.h"
 using namespace std;
-void lubksb(float **a, int* indx, float * b, int n);
-void mprove(float **a, float **alud, int* indx, float * b, float * x, int a_n, int x_n);
-void SWAP(float *a, float *b);
-float MAX(float a, float b);
-float MIN(float a, float b);
-float SIGN(const float &a, const double &b);
-void svdcmp(float**a, float*w, float**v, int n, int m);
-void gaussj(float ** a, float **b, int n, int m);
-void ludcmp(float **a, int *indx, float &d, int n);
-void load(FILE *fp);
-float SQR(float a);
-float pythag(const float a, const float b);
-float** transMatrix(float **mat1, int n);
-float** multiMatrix(float **mat1, float **mat2, int row_1, int col_1,int col_2);
-float DetMat(float **mat, int size);
-float CofacMat(float **mat, int p, int q, int size);
-void mprove(float** a, float** alud, int* indx, float* b, float* x, int n);
-
-
-float **A = NULL;
+void lubksb(Matrix<float> &a, int* indx, float * b, int n);
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, float * b, float * x, int a_n, int x_n);
+template <typename T> void SWAP(T *a, T *b);
+template <typename T> T MAX(T a, T b);
+template <typename T> T MIN(T a, T b);
+template <typename T> T SIGN(const T &a, const double &b);
+template <typename T> void svdcmp(Matrix<T> &a, T*w, Matrix<T> &v, int n, int m);
+template <typename T> void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m);
+void ludcmp(Matrix<float> &a, int *indx, float &d, int n);
+bool load(const char *fileName);
+template <typename T> T SQR(T a);
+template <typename T> T pythag(const T a, const T b);
+Matrix<float> transMatrix(const Matrix<float> &mat1, int n);
+Matrix<float> multiMatrix(const Matrix<float> &mat1, const Matrix<float> &mat2, int row_1, int col_1,int col_2);
+float DetMat(const Matrix<float> &mat, int size);
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, float* b, float* x, int n);
+void ludcmp_blocked(Matrix<float> &a, int *indx, float &d, int n);
+void lubksb(Matrix<float> &a, int* indx, Matrix<float> &b, int n, int m);
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, Matrix<float> &b, Matrix<float> &x, int n, int m);
+
+//LU 분해 결과
+//lu에 L(대각의 1은 생략)과 U를 함께, indx에 행 교환, d에 교환에 따른 부호를 둔다
+//한 번 분해해 두고 해 구하기, 역행렬, 개선, 행렬식에 같이 쓴다
+struct LUDecomp {
+	Matrix<float> lu;
+	vector<int> indx;
+	float d;
+};
+LUDecomp lu_factor(const Matrix<float> &A, int n);
+
+//gaussj의 작업 공간
+//같은 크기의 연립방정식을 여러 번 풀 때 하나를 계속 넘기면
+//처음 한 번만 할당하고 그 뒤로는 할당하지 않는다
+template <typename T = float>
+struct GaussjWork {
+	vector<int> indxc, indxr, ipiv;
+	Matrix<T> a;	// solve_gaussj가 A를 복사해 두는 곳
+};
+template <typename T> void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m, GaussjWork<T> &w);
+template <typename T> void solve_gaussj(const Matrix<T> &A, Matrix<T> &B, int n, int m, GaussjWork<T> &w);
+
+//float로 분해한 LU로 double 정확도의 해를 구하는 혼합 정밀도 반복 개선
+int mprove_mixed(const Matrix<double> &a, LUDecomp &lu, const double *b, double *x, int n, int max_iter = 10);
+vector<double> solve_mixed(const Matrix<double> &a, const double *b, int n);
+
+
+Matrix<float> A;
 float *b = NULL;
 int N;
 
-float *problem_gaussj(int N, float **A, float *b) {
-	//동적할당을 통해 A와 B를 복사해둔다
-	float **A_copy = (float**)calloc(N , sizeof(float *));
-	float **B_copy = (float **)calloc(N , sizeof(float *));
+float *problem_gaussj(int N, Matrix<float> &A, float *b) {
+	//B를 복사해둔다 (A는 solve_gaussj가 작업 공간에 복사한다)
+	GaussjWork<> work;
+	Matrix<float> B_copy(N, 1);
 
 	for (int i = 0; i < N; i++) {
-		A_copy[i] = (float*)malloc((N) * sizeof(float));
-		memcpy(A_copy[i], A[i], (N) * sizeof(float));
-	}
-	
-	for (int i = 0; i < N; i++) {
-		B_copy[i] = (float*)calloc(1, sizeof(float));
 		B_copy[i][0] = b[i];
 	}
 
 	//가우스 조던 소거법 사용
-	gaussj(A_copy, B_copy, N, 1);
+	solve_gaussj(A, B_copy, N, 1, work);
 	//찾은 해를 옮긴다.
 	float *ret = (float *)calloc(N , sizeof(float));
 	for (int i = 0; i < N; i++) {
 		ret[i] = B_copy[i][0];
 	}
 	
-	//동적할당한 공간 해제하기
-	for (int i = 0; i < N; i++) free(A_copy[i]);
-	for (int i = 0; i < N; i++) free(B_copy[i]);
-	free(A_copy);
-	free(B_copy);
-
 	return ret;
 }
 
-float *problem_ludcmp(int N, float **A, float *b) {
-	float d = 0;
-	int * indx = (int *)malloc(sizeof(int)*N);
-
-	//동적할당을 통해 A와 B를 복사해둔다
-	float **A_copy = (float**)malloc((N) *sizeof(float *));
-	float *B_copy = (float *)malloc((N) *sizeof(float ));
-
-	for (int i = 0; i < N; i++) {
-		A_copy[i] = (float*)malloc((N) *sizeof(float));
-		memcpy(A_copy[i], A[i], (N) * sizeof(float));
-	}
-
-	B_copy = (float*)malloc((N) *sizeof(float));
-	for (int i = 0; i < N; i++) {
-		B_copy[i] = b[i];
-	}
-
-	//LU Decomposition 사용
-	ludcmp(A_copy, indx, d, N);
-
-	lubksb(A_copy, indx, B_copy, N);
-
-	//찾은 해를 옮긴다.
+float *problem_ludcmp(LUDecomp &lu, float *b) {
+	//B를 복사해둔다
 	float *ret = (float *)calloc(N , sizeof(float));
-	for (int i = 0; i < N; i++) ret[i] = B_copy[i];
+	for (int i = 0; i < N; i++) ret[i] = b[i];
 
-
-	//동적할당한 공간 해제하기
-	for (int i = 0; i < N; i++) free(A_copy[i]);
-	free(A_copy);
-	free(B_copy);
+	//미리 구한 LU 분해로 해를 구한다
+	lubksb(lu.lu, lu.indx.data(), ret, N);
 
 	return ret;
 }
 
-float *problem_svdcmp(int N, float **A, float *b) {
+float *problem_svdcmp(int N, Matrix<float> &A, float *b) {
 	float * w = (float*)calloc(N,sizeof(float));
-	float **v= (float**)calloc(N,sizeof(float*));
-	for (int i = 0; i < N; i++)
-		v[i]= (float*)calloc(N,sizeof(float));
-	
-	float **x;
-
-	//동적할당을 통해 A와 B를 복사해둔다
-	float **A_copy = (float**)calloc(N, sizeof(float *));
-	float **w_ = (float**)calloc(N, sizeof(float *));
-	float **B_copy = (float **)calloc(N, sizeof(float *));
+	Matrix<float> v(N, N);
+	Matrix<float> x(N, 1);
 
-	for (int i = 0; i < N; i++) {
-		w_[i] = (float*)calloc(N, sizeof(float));
-		A_copy[i] = (float*)calloc(N, sizeof(float));
-		memcpy(A_copy[i], A[i], (N) * sizeof(float));
-	}
+	//A와 B를 복사해둔다
+	Matrix<float> A_copy = A;
+	Matrix<float> w_(N, N);
+	Matrix<float> B_copy(N, 1);
 
 	for (int i = 0; i < N; i++) {
-		B_copy[i] = (float*)calloc(1, sizeof(float));
 		B_copy[i][0] = b[i];
 	}
 
@@ -146,7 +133,7 @@ float *problem_svdcmp(int N, float **A, float *b) {
 	}
 	//b!=0이라면
 	else {
-		float ** tmp1, **tmp2;
+		Matrix<float> tmp1, tmp2;
 		for (int i = 0; i < N; i++)
 		{
 			w_[i][i] = ((w[i]==0) ? 0 : float(1/w[i]));
@@ -162,87 +149,141 @@ float *problem_svdcmp(int N, float **A, float *b) {
 	for (int i = 0; i < N; i++) ret[i] = x[i][0];
 
 	//동적할당한 공간 해제하기
-	for (int i = 0; i < N; i++) free(A_copy[i]);
-	free(A_copy);
-	free(B_copy);
+	free(w);
 
 	return ret;
 }
 
-float ** problem_inverse_matrix(int N, float **A) {
-	float* b = (float *)malloc(sizeof(float)*N);
-	float **A_inverse = (float**)calloc(N , sizeof(float *));
-	float d;
-	int * indx = (int *)malloc(sizeof(int)*N);
+Matrix<float> problem_inverse_matrix(int N, LUDecomp &lu) {
+	//단위 행렬의 N개 열을 우변으로 두고 한꺼번에 푼다
+	Matrix<float> A_inverse(N, N);
+	for (int i = 0; i < N; i++) A_inverse[i][i] = 1;
 
-	//동적할당을 통해 A와 B를 복사해둔다
-	float **A_copy = (float**)malloc(N * sizeof(float *));
-	for (int i = 0; i < N; i++) {
-		A_copy[i] = (float*)malloc(N * sizeof(float));
-		A_inverse[i] = (float*)malloc(N * sizeof(float));
-		memcpy(A_copy[i], A[i], N  * sizeof(float));
-	}
-	//LU Decomposition 사용
-	ludcmp(A_copy, indx, d, N);
-	for (int i = 0; i < N; i++)
-	{
-		for (int j = 0; j < N; j++)
-		{
-			if (i == j) b[j] = 1;
-			else b[j] = 0;
-		}
-
-		lubksb(A_copy, indx, b, N);
-		for (int j = 0; j < N; j++)
-		{
-			A_inverse[j][i] = b[j];
-		}
-	}
-	//동적할당한 공간 해제하기
-	for (int i = 0; i < N; i++) free(A_copy[i]);
-	free(A_copy);
+	lubksb(lu.lu, lu.indx.data(), A_inverse, N, N);
 
 	return A_inverse;
 }
 
 
-float* problem_improve(float*b,float*x) {
-	float d;
-	int * indx = (int *)malloc(sizeof(int)*N);
-
-	//동적할당을 통해 A와 x를 복사해둔다
-	float **A_copy = (float**)malloc(N * sizeof(float *));
+float* problem_improve(LUDecomp &lu, float*b,float*x) {
+	//x를 복사해둔다
 	float *x_copy = (float*)malloc(N * sizeof(float));
 
 	for (int i = 0; i < N; i++) {
-		A_copy[i] = (float*)malloc(N * sizeof(float));
-		memcpy(A_copy[i], A[i], N * sizeof(float));
 		x_copy[i] = x[i];
 	}
 
-	//LU Decomposition 사용
-	ludcmp(A_copy, indx, d, N);
-	mprove(A, A_copy, indx, b, x_copy, N);
+	//이미 구한 LU 분해를 다시 쓴다
+	mprove(A, lu.lu, lu.indx.data(), b, x_copy, N);
 
 	return x_copy;
 }
 
-int main() {
-	FILE *fp;
+//3차원 n x n x n 격자에서 7점 차분으로 만든 -Δu + c ∂u/∂x 의 행렬
+//격자점마다 한 행에 원소가 7개 이하이고, c = 0이면 대칭 양의 정부호다
+CsrMatrix<double> grid_matrix(int n, double c) {
+	int N3 = n * n * n;
+	CsrMatrix<double> S(N3, N3, (size_t)N3 * 7);
+
+	for (int k = 0; k < n; k++)
+		for (int j = 0; j < n; j++)
+			for (int i = 0; i < n; i++) {
+				int row = (k * n + j) * n + i;
+				if (k > 0) S.add(row - n * n, -1);
+				if (j > 0) S.add(row - n, -1);
+				if (i > 0) S.add(row - 1, -1 - c);
+				S.add(row, 6);
+				if (i < n - 1) S.add(row + 1, -1 + c);
+				if (j < n - 1) S.add(row + n, -1);
+				if (k < n - 1) S.add(row + n * n, -1);
+				S.endRow();
+			}
+	return S;
+}
+
+//풀이 하나를 돌려 반복 횟수, 실제 상대 잔차, 참값 1과의 최대 오차, 걸린 시간을 출력한다
+template <typename Solve>
+void run_sparse(const char *name, const CsrMatrix<double> &S, const vector<double> &rhs, Solve solve) {
+	int n = S.rows();
+	vector<double> x(n, 0.0), r(n);
+
+	auto start = chrono::steady_clock::now();
+	int iter = solve(x.data());
+	auto end = chrono::steady_clock::now();
+
+	spResidual(S, x.data(), rhs.data(), r.data());
+	double err = 0;
+	for (int i = 0; i < n; i++) err = MAX(err, fabs(x[i] - 1));
+	printf("%-20s %5d iter  residual %.2e  error %.2e  %8.1fms\n", name, iter,
+		sqrt(spDot(r.data(), r.data(), n) / spDot(rhs.data(), rhs.data(), n)), err,
+		chrono::duration<double, milli>(end - start).count());
+}
+
+//hw5 sparse [n] : 밀집 행렬로는 만들 수 없는 n^3 x n^3 연립방정식을 CSR로 만들어
+//CG와 BiCGSTAB으로 푼다 (n = 100이면 10^6개의 미지수, 밀집 행렬이면 4TB)
+//해가 모두 1이 되도록 b = A * 1로 둔다
+void problem_sparse(int n) {
+	const double TOL = 1e-8;
+	const int MAX_ITER = 10000;
+
+	for (int pass = 0; pass < 2; pass++) {
+		double c = pass == 0 ? 0 : 0.4;
+		CsrMatrix<double> S = grid_matrix(n, c);
+		vector<double> one(S.rows(), 1.0), rhs(S.rows());
+		spmv(S, one.data(), rhs.data());
+
+		printf("[%s] %d x %d, %zu nonzeros\n", c == 0 ? "Poisson" : "Convection-diffusion",
+			S.rows(), S.cols(), S.nnz());
+		JacobiPrecond<double> jac(S);
+		Ilu0Precond<double> ilu(S);
+		if (c == 0) {
+			run_sparse("CG + Jacobi", S, rhs, [&](double *x) {
+				return cg(S, rhs.data(), x, jac, TOL, MAX_ITER);
+			});
+			run_sparse("CG + ILU(0)", S, rhs, [&](double *x) {
+				return cg(S, rhs.data(), x, ilu, TOL, MAX_ITER);
+			});
+		}
+		run_sparse("BiCGSTAB + Jacobi", S, rhs, [&](double *x) {
+			return bicgstab(S, rhs.data(), x, jac, TOL, MAX_ITER);
+		});
+		run_sparse("BiCGSTAB + ILU(0)", S, rhs, [&](double *x) {
+			return bicgstab(S, rhs.data(), x, ilu, TOL, MAX_ITER);
+		});
+		printf("\n");
+	}
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1 && strcmp(argv[1], "sparse") == 0) {
+		problem_sparse(argc > 2 ? atoi(argv[2]) : 100);
+		return 0;
+	}
+
 	float *x_1, *x_2, *x_3, *x_1_pr , *x_2_pr , *x_3_pr;
 	char fileName[30];
 	scanf("%s", fileName);
 
-	fp = fopen(fileName, "r");
-	if (fp == NULL) {
+	if (!load(fileName)) {
 		printf("Failed to open file: %s\n",fileName);
+		return 1;
 	}
-	load(fp);
 
 	x_1=problem_gaussj(N, A, b);
 
-	x_2 = problem_ludcmp(N, A, b);
-	x_2_pr = problem_improve(b,x_2);
+	//LU 분해는 한 번만 한다
+	LUDecomp lu = lu_factor(A, N);
+	x_2 = problem_ludcmp(lu, b);
+	x_2_pr = problem_improve(lu, b, x_2);
+
+	//float 분해 + double 개선
+	Matrix<double> A_d(N, N);
+	vector<double> b_d(N);
+	for (int i = 0; i < N; i++) {
+		for (int j = 0; j < N; j++) A_d[i][j] = A[i][j];
+		b_d[i] = b[i];
+	}
+	vector<double> x_2_mp = solve_mixed(A_d, b_d.data(), N);
 
 	x_3=problem_svdcmp(N, A, b);
 
@@ -259,6 +300,10 @@ int main() {
 	printf("2-2) Iterative Improve : x = { ");
 	for (int i = 0; i < N; i++)
 		printf("%f ", x_2_pr[i]);
+	printf("}\n");
+	printf("2-3) Mixed Precision Improve : x = { ");
+	for (int i = 0; i < N; i++)
+		printf("%f ", x_2_mp[i]);
 	printf("}\n\n");
 
 	printf("3-1) Singular Value Decomposition : x = { ");
@@ -269,7 +314,7 @@ int main() {
 
 	//A의 inverse Matrix 구하기
 	printf("Inverse A Matrix : \n");
-	float ** A_inverse=problem_inverse_matrix(N,A);
+	Matrix<float> A_inverse=problem_inverse_matrix(N,lu);
 	for (int j = 0; j < N; j++)
 	{
 		for (int i = 0; i < N; i++)
@@ -279,18 +324,14 @@ int main() {
 		printf("\n");
 	}
 
-	printf("\nDet(A) = %f", DetMat(A,N));
+	printf("\nDet(A) = %f", DetMat(lu.lu, N) * lu.d);
 
-	for (int i = 0; i < N; i++)
-		free(A[i]);
-	free(A);
 	free(b);
-	fclose(fp);
 
 	return 0;
 }
 
-void lubksb(float **a, int* indx, float * b,int n)
+void lubksb(Matrix<float> &a, int* indx, float * b,int n)
 {
 	int i, ii = 0, ip, j;
 	float sum;
@@ -312,7 +353,7 @@ void lubksb(float **a, int* indx, float * b,int n)
 	}
 }
 
-void mprove(float **a, float **alud, int* indx, float * b, float * x, int a_n, int x_n)
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, float * b, float * x, int a_n, int x_n)
 {
 	int i, j;
 
@@ -330,38 +371,43 @@ void mprove(float **a, float **alud, int* indx, float * b, float * x, int a_n, i
 }
 
 
-void SWAP(float *a, float *b)
+template <typename T>
+void SWAP(T *a, T *b)
 {
-	float dum = *a; 
+	T dum = *a; 
 	*a = *b; 
 	*b = dum;
 }
 
-float MAX(float a, float b)
+template <typename T>
+T MAX(T a, T b)
 {
 	return a > b ? a : b;
 }
 
-float MIN(float a, float b)
+template <typename T>
+T MIN(T a, T b)
 {
 	return a < b ? a : b;
 
 }
 
-float SIGN(const float &a, const double &b)
+template <typename T>
+T SIGN(const T &a, const double &b)
 {
 	return b >= 0 ? (a >= 0 ? a : -a) : (a >= 0 ? -a : a);
 }
 
 
-void svdcmp(float**a, float*w, float**v, int n, int m)
+template <typename T>
+void svdcmp(Matrix<T> &a, T*w, Matrix<T> &v, int n, int m)
 {
 	bool flag;
 	int i, its, j, jj, k, l, nm;
-	float anorm, c, f, g, h, s, scale, x, y, z;
+	T anorm, c, f, g, h, s, scale, x, y, z;
 
-	float* rv1;
-	rv1 = (float*)malloc(sizeof(float)*n);
+	T* rv1;
+	rv1 = (T*)malloc(sizeof(T)*n);
 
 	g = scale = anorm = 0.0;
 	for (i = 0; i < n; i++) {
@@ -489,7 +535,7 @@ void svdcmp(float**a, float*w, float**v, int n, int m)
 			g = rv1[nm];
 			h = rv1[k];
 			f = ((y - z)*(y + z) + (g - h)*(g + h)) / (2.0*h*y);
-			g = pythag(f, 1.0);
+			g = pythag(f, (T)1.0);
 			f = ((x - z)*(x + z) + h * ((y / (f + SIGN(g, f))) - h)) / x;
 			c = s = 1.0;
 			for (j = l; j <= nm; j++) {
@@ -536,15 +582,33 @@ void svdcmp(float**a, float*w, float**v, int n, int m)
 }
 
 
-void gaussj(float ** a, float **b, int n, int m)
+template <typename T>
+void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m)
+{
+	GaussjWork<T> w;
+	gaussj(a, b, n, m, w);
+}
+
+//A는 그대로 두고 B의 m개 열(우변)을 해로 바꾼다
+//A는 w.a에 복사하는데, 크기가 같으면 이전 버퍼를 그대로 쓴다
+template <typename T>
+void solve_gaussj(const Matrix<T> &A, Matrix<T> &B, int n, int m, GaussjWork<T> &w)
+{
+	w.a = A;
+	gaussj(w.a, B, n, m, w);
+}
+
+//a는 역행렬로, b의 m개 열은 해로 바뀐다
+template <typename T>
+void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m, GaussjWork<T> &w)
 {
 	int i, icol, irow, j, k, l, ll;
-	float big, dum, pivinv;
+	T big, dum, pivinv;
 
-	int* indxc, *indxr, *ipiv;
-	indxc = (int *)malloc(sizeof(int)*n);
-	indxr = (int *)malloc(sizeof(int)*n);
-	ipiv = (int *)malloc(sizeof(int)*n);
+	w.indxc.resize(n);
+	w.indxr.resize(n);
+	w.ipiv.resize(n);
+	int *indxc = w.indxc.data(), *indxr = w.indxr.data(), *ipiv = w.ipiv.data();
 
 	for (j = 0; j < n; j++) ipiv[j] = 0;
 	for (i = 0; i < n; i++) {
@@ -589,7 +653,7 @@ void gaussj(float ** a, float **b, int n, int m)
 
 
 
-void ludcmp(float **a, int *indx, float &d, int n)
+void ludcmp(Matrix<float> &a, int *indx, float &d, int n)
 {
 	const float TINY = 1.0e-20;
 	int i, imax, j, k;
@@ -641,35 +705,37 @@ void ludcmp(float **a, int *indx, float &d, int n)
 }
 
 
-void load(FILE *fp) {
-	int M;
+bool load(const char *fileName) {
+	DataReader in;
+	float size[2];
+	if (!in.open(fileName)) return false;
+
 	//A의 크기를 읽어온다
-	fscanf(fp, "%d %d", &M, &N);
+	in.next(size, 2);
+	N = (int)size[1];
 
 	//A와 b의 값을 읽어온다
-	A = (float**)malloc(N*sizeof(float *));
-	for (int i = 0; i < N; i++)
-		A[i] = (float*)malloc(N*sizeof(float));
+	A = Matrix<float>(N, N);
 
 	for (int i = 0; i < N; i++)
-		for (int j = 0; j < N; j++)
-			fscanf(fp, "%f", &A[i][j]);
-
-	b = (float*)malloc(N*sizeof(float));
-	for (int i = 0; i < N; i++)
-		fscanf(fp, "%f", &b[i]);
+		in.next(A[i], N);
 
+	b = (float*)calloc(N, sizeof(float));
+	in.next(b, N);
 
+	return true;
 }
 
 
-float SQR(float a) { 
+template <typename T>
+T SQR(T a) { 
 	return a * a; 
 }
 
-float pythag(const float a, const float b)
+template <typename T>
+T pythag(const T a, const T b)
 {
-	float absa, absb;
+	T absa, absb;
 
 	absa = fabs(a);
 	absb = fabs(b);
@@ -678,14 +744,10 @@ float pythag(const float a, const float b)
 }
 
 // transformation 매트릭스를 산출해 내는 함수
-float** transMatrix(float **mat1, int n) {
+Matrix<float> transMatrix(const Matrix<float> &mat1, int n) {
 	int i, j;
 
-	float** ret = (float**)malloc(sizeof(float*)*n);
-	for (int i = 0; i < n; i++)
-	{
-		ret[i] = (float*)malloc(sizeof(float)*n);
-	}
+	Matrix<float> ret(n, n);
 
 	for (i = 0; i < n; i++)
 		for (j = 0; j < n; j++)
@@ -696,101 +758,259 @@ float** transMatrix(float **mat1, int n) {
 }
 
 // 두 매트릭스의 곱을 구하는 함수
-float** multiMatrix(float **mat1, float **mat2, int row_1 ,int col_1, int col_2 ) {
-	int i, j, k;
-	float resTemp = 0.0;
+Matrix<float> multiMatrix(const Matrix<float> &mat1, const Matrix<float> &mat2, int row_1 ,int col_1, int col_2 ) {
+	Matrix<float> ret(row_1, col_2);
 
+	gemm(mat1, mat2, ret, row_1, col_1, col_2);
+	return ret;
+}
 
-	float** ret = (float**)malloc(sizeof(float*)*row_1);
-	for (int i = 0; i < row_1; i++)
-	{
-		ret[i] = (float*)malloc(sizeof(float)*col_2);
-	}
+//LU 분해된 행렬의 행렬식 (행 교환의 부호는 곱하지 않는다)
+//U의 대각 원소의 곱이라 O(n)이고, 분해까지 O(n^3)이다
+//(여인수 전개는 O(n!)이라 큰 행렬에 쓸 수 없다)
+float DetMat(const Matrix<float> &lu, int size) {
+	float det = 1;
 
-	for (i = 0; i < row_1; i++) {
-		for (j = 0; j < col_2; j++) {
-			for (k = 0; k < col_1; k++) {
-				resTemp += mat1[i][k] * mat2[k][j];
-			}
-			ret[i][j] = resTemp;
-			resTemp = 0.0;
-		}
+	for (int i = 0; i < size; i++) det *= lu[i][i];
+	return det;
+}
+
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, float* b,float* x,int n)
+{
+	int i, j;
+
+	//int n = x.size();
+	float* r;
+	r = (float*)calloc(n, sizeof(float));
+	for (i = 0; i < n; i++) {
+		long double sdp = -b[i];
+		for (j = 0; j < n; j++)
+			sdp += (long double)a[i][j] * (long double)x[j];
+		r[i] = sdp;
 	}
+	lubksb(alud, indx, r ,n);
+	for (i = 0; i < n; i++) x[i] -= r[i];
+}
 
 
-	return ret;
+//이 크기보다 큰 행렬은 블록 LU로 분해한다
+const int LU_BLOCKED_MIN = 2 * MATRIX_BLOCK;
+
+LUDecomp lu_factor(const Matrix<float> &A, int n) {
+	LUDecomp lu;
+	lu.lu = A;
+	lu.indx.resize(n);
+	if (n < LU_BLOCKED_MIN) ludcmp(lu.lu, lu.indx.data(), lu.d, n);
+	else ludcmp_blocked(lu.lu, lu.indx.data(), lu.d, n);
+	return lu;
+}
+
+//[r0, r1)행의 나머지 갱신을 threads개의 스레드로 나누어 한다
+static void trailing_update(Matrix<float> &a, int k0, int kb, int r0, int r1, int n)
+{
+	int threads = (int)thread::hardware_concurrency();
+	int rows = r1 - r0, cols = n - (k0 + kb);
+	int ld = a.stride();
+	const float *l21 = a[r0] + k0, *u12 = a[k0] + k0 + kb;
+
+	if (threads < 1) threads = 1;
+	if ((double)rows * cols * kb < 1e7) threads = 1;
+	if (threads > rows) threads = rows;
+
+	vector<thread> pool;
+	int chunk = (rows + threads - 1) / threads;
+	for (int t = 1; t < threads; t++) {
+		int s = t * chunk, e = s + chunk < rows ? s + chunk : rows;
+		if (s >= e) break;
+		pool.push_back(thread(gemmSub<float>, l21 + (size_t)s * ld, ld, u12, ld,
+			a[r0 + s] + k0 + kb, ld, e - s, kb, cols));
+	}
+	gemmSub(l21, ld, u12, ld, a[r0] + k0 + kb, ld, chunk < rows ? chunk : rows, kb, cols);
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
 }
 
-float DetMat(float **mat, int size) {
-	int p = 0, q = 0;
-	float det = 0;
+//오른쪽으로 나아가는(right-looking) 블록 LU 분해
+//ludcmp와 같이 행마다 크기를 맞춘 부분 피벗팅을 하고 결과 형식도 같아서
+//lubksb, mprove에 그대로 쓸 수 있다
+//MATRIX_BLOCK개의 열(패널)을 분해한 뒤 U의 블록 행을 구하고
+//나머지 부분 행렬을 gemmSub로 한꺼번에 갱신하므로 대부분의 계산이
+//캐시에 맞춘 행렬 곱이 된다
+void ludcmp_blocked(Matrix<float> &a, int *indx, float &d, int n)
+{
+	const float TINY = 1.0e-20;
+	const int NB = MATRIX_BLOCK;
+	int i, imax, j, k, k0, kend;
+	float big, dum, temp;
+	vector<float> vv(n);
 
-	if (size == 1) {   //determinant of 1 by 1 matrix
-		return mat[0][0];
-	}
-	else if (size == 2) { //determinant 2 by 2 matrix
-		return mat[0][0] * mat[1][1] - mat[0][1] * mat[1][0];
+	d = 1.0;
+	for (i = 0; i < n; i++) {
+		big = 0.0;
+		for (j = 0; j < n; j++)
+			if ((temp = fabs(a[i][j])) > big) big = temp;
+		if (big == 0.0) printf("Singular matrix in routine ludcmp_blocked\n");
+		vv[i] = 1.0 / big;
 	}
-	else {     //3 by 3 이상
-		for (q = 0, det = 0; q < size; q++) {
-			det = det + mat[0][q] * CofacMat(mat, 0, q, size);
+	for (k0 = 0; k0 < n; k0 += NB) {
+		kend = k0 + NB < n ? k0 + NB : n;
+
+		//패널 [k0, kend) 열을 분해한다
+		for (j = k0; j < kend; j++) {
+			big = 0.0;
+			imax = j;
+			for (i = j; i < n; i++) {
+				if ((dum = vv[i] * fabs(a[i][j])) >= big) {
+					big = dum;
+					imax = i;
+				}
+			}
+			if (j != imax) {
+				float *rj = a[j], *ri = a[imax];
+				for (k = 0; k < n; k++) {
+					dum = ri[k];
+					ri[k] = rj[k];
+					rj[k] = dum;
+				}
+				d = -d;
+				vv[imax] = vv[j];
+			}
+			indx[j] = imax;
+			if (a[j][j] == 0.0) a[j][j] = TINY;
+			dum = 1.0 / (a[j][j]);
+			const float *rj = a[j];
+			for (i = j + 1; i < n; i++) {
+				float *ri = a[i];
+				float lij = (ri[j] *= dum);
+				for (k = j + 1; k < kend; k++) ri[k] -= lij * rj[k];
+			}
+		}
+		if (kend == n) break;
+
+		//U의 블록 행: U12 = L11^-1 * A12
+		for (j = k0; j < kend; j++) {
+			const float *rj = a[j];
+			for (i = j + 1; i < kend; i++) {
+				float *ri = a[i];
+				float lij = ri[j];
+				for (k = kend; k < n; k++) ri[k] -= lij * rj[k];
+			}
 		}
-		return det;
+
+		//나머지 부분 행렬: A22 -= L21 * U12
+		trailing_update(a, k0, kend - k0, kend, n, n);
 	}
-	return 0;
 }
 
-float CofacMat(float **mat, int p, int q, int size) {
-	int i = 0, j = 0;  //인자로 받은 matrix의 index
-	int x = 0, y = 0;  //cmat의 index
-	float **cmat;
-	float cofactor = 0;
-
-	//cofactor matrix의 dynamic memory 할당
-	cmat = (float**)malloc(sizeof(float*) * (size - 1));
-	for (i = 0; i < (size - 1); i++) {
-		cmat[i] = (float*)malloc(sizeof(float) * (size - 1));
-	}
+//우변 m개(b의 각 열)를 한꺼번에 푼다
+//lubksb와 같은 대입이지만 행 단위로 b의 한 행 전체를 갱신해서 연속된 메모리를 훑는다
+void lubksb(Matrix<float> &a, int* indx, Matrix<float> &b, int n, int m)
+{
+	int i, j, k;
 
-	//mat으로 부터 cmat추출(cmat은 mat의 p행과 q열의 원소를 제외한 나머지 원소들로 구성된 matrix)
-	for (i = 0, x = 0; i < size; i++) {
-		if (i != p) {
-			for (j = 0, y = 0; j < size; j++) {
-				if (j != q) {
-					cmat[x][y] = mat[i][j];
-					y++;
-				}
+	for (i = 0; i < n; i++) {
+		int ip = indx[i];
+		if (ip != i)
+			for (k = 0; k < m; k++) {
+				float dum = b[ip][k];
+				b[ip][k] = b[i][k];
+				b[i][k] = dum;
 			}
-			x++;
+	}
+	for (i = 0; i < n; i++) {
+		float *bi = b[i];
+		for (j = 0; j < i; j++) {
+			const float aij = a[i][j];
+			const float *bj = b[j];
+			for (k = 0; k < m; k++) bi[k] -= aij * bj[k];
 		}
 	}
+	for (i = n - 1; i >= 0; i--) {
+		float *bi = b[i];
+		for (j = i + 1; j < n; j++) {
+			const float aij = a[i][j];
+			const float *bj = b[j];
+			for (k = 0; k < m; k++) bi[k] -= aij * bj[k];
+		}
+		const float inv = 1.0f / a[i][i];
+		for (k = 0; k < m; k++) bi[k] *= inv;
+	}
+}
 
-	//cofactor를 계산
-	cofactor = pow(-1, p)*pow(-1, q)*DetMat(cmat, size - 1);
+//우변 m개(b, x의 각 열)의 해를 한 번의 LU 분해로 함께 개선한다
+void mprove(Matrix<float> &a, Matrix<float> &alud, int* indx, Matrix<float> &b, Matrix<float> &x, int n, int m)
+{
+	int i, j, k;
+	Matrix<float> r(n, m);
+	vector<double> sdp(m);
 
-	//cofactor matrix의 dynamic memory 해제
-	for (i = 0; i < (size - 1); i++) {
-		free(cmat[i]);
+	for (i = 0; i < n; i++) {
+		for (k = 0; k < m; k++) sdp[k] = -b[i][k];
+		for (j = 0; j < n; j++) {
+			const double aij = a[i][j];
+			const float *xj = x[j];
+			for (k = 0; k < m; k++) sdp[k] += aij * xj[k];
+		}
+		for (k = 0; k < m; k++) r[i][k] = sdp[k];
 	}
-	free(cmat);
-
-	return cofactor;
+	lubksb(alud, indx, r, n, m);
+	for (i = 0; i < n; i++)
+		for (k = 0; k < m; k++) x[i][k] -= r[i][k];
 }
 
-
-void mprove(float** a, float** alud, int* indx, float* b,float* x,int n)
+//float로 분해한 LU로 double 정확도의 해를 구한다 (혼합 정밀도 반복 개선)
+//잔차 b - A x는 double로 구하고 보정량만 float LU로 풀어 x에 더한다
+//분해는 float로 한 번만 하고 반복마다 O(n^2)만 더 든다
+//보정량이 x의 double 반올림 수준이 되거나 max_iter번 하면 멈추고 반복 횟수를 돌려준다
+int mprove_mixed(const Matrix<double> &a, LUDecomp &lu, const double *b, double *x, int n, int max_iter)
 {
-	int i, j;
+	vector<float> r(n);
+	int it;
+
+	for (it = 0; it < max_iter; it++) {
+		for (int i = 0; i < n; i++) {
+			const double *ai = a[i];
+			double sdp = b[i];
+			for (int j = 0; j < n; j++) sdp -= ai[j] * x[j];
+			r[i] = (float)sdp;
+		}
+		lubksb(lu.lu, lu.indx.data(), r.data(), n);
 
-	//int n = x.size();
-	float* r;
-	r = (float*)calloc(n, sizeof(float));
-	for (i = 0; i < n; i++) {
-		long double sdp = -b[i];
-		for (j = 0; j < n; j++)
-			sdp += (long double)a[i][j] * (long double)x[j];
-		r[i] = sdp;
+		double dmax = 0, xmax = 0;
+		for (int i = 0; i < n; i++) {
+			x[i] += r[i];
+			dmax = MAX(dmax, fabs((double)r[i]));
+			xmax = MAX(xmax, fabs(x[i]));
+		}
+		if (dmax <= 4 * Machar<double>::eps * xmax) return it + 1;
 	}
-	lubksb(alud, indx, r ,n);
-	for (i = 0; i < n; i++) x[i] -= r[i];
+	return it;
 }
+
+//A x = b를 float LU와 double 반복 개선으로 푼다
+vector<double> solve_mixed(const Matrix<double> &a, const double *b, int n)
+{
+	Matrix<float> af(n, n);
+	vector<double> x(n);
+	vector<float> xf(n);
+
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) af[i][j] = (float)a[i][j];
+		xf[i] = (float)b[i];
+	}
+	LUDecomp lu = lu_factor(af, n);
+	lubksb(lu.lu, lu.indx.data(), xf.data(), n);
+	for (int i = 0; i < n; i++) x[i] = xf[i];
+	mprove_mixed(a, lu, b, x.data(), n);
+	return x;
+}
+
+//float, double, long double로 미리 만들어 둔다
+#define NR_INSTANTIATE(T) \
+	template void svdcmp<T>(Matrix<T> &, T *, Matrix<T> &, int, int); \
+	template void gaussj<T>(Matrix<T> &, Matrix<T> &, int, int); \
+	template void gaussj<T>(Matrix<T> &, Matrix<T> &, int, int, GaussjWork<T> &); \
+	template void solve_gaussj<T>(const Matrix<T> &, Matrix<T> &, int, int, GaussjWork<T> &);
+NR_INSTANTIATE(float)
+NR_INSTANTIATE(double)
+NR_INSTANTIATE(long double)
+#undef NR_INSTANTIATE
@@ -1,23 +1,29 @@
 import subprocess as sp
 import sys
 import matplotlib.pyplot as plt
-import numpy as np
 
 
-a = -3
-b = 2
-m = -0.5
-s = 1.5
-intervals = 100
 samples = [100, 1000, 10000, 100000]
 
-# Uniform distribution
-def histo_uniform():
-    for i in range(4):
-        #hw6.exe(sys.argv[1]) 파일로 인자str(samples[i]), 'uniform' 넣어서 실행
-        result = sp.run([sys.argv[1], str(samples[i]), 'uniform'], stdout=sp.PIPE)
-        result = result.stdout.decode(encoding='UTF-8')
-        x = [float(j) * (b-a) + a for j in result.split()]
+# hw6.exe(sys.argv[1])를 stats 모드로 실행해서 히스토그램 구간만 받아온다
+# 표본을 텍스트로 받지 않으므로 표본 수가 커도 출력은 요약 몇 줄이다
+def run_stats(n, method):
+    result = sp.run([sys.argv[1], str(n), method, 'stats'], stdout=sp.PIPE)
+    lines = result.stdout.decode(encoding='UTF-8').splitlines()
+
+    #요약 통계는 그대로 보여주고 'bins:' 아래의 구간만 읽는다
+    start = lines.index('bins:')
+    print('\n'.join(lines[:start]) + '\n')
+    edges, counts = [], []
+    for line in lines[start + 1:]:
+        lo, hi, c = line.split()
+        edges.append((float(lo), float(hi)))
+        counts.append(int(c))
+    return edges, counts
+
+def histo(method, color):
+    for i in range(len(samples)):
+        edges, counts = run_stats(samples[i], method)
 
         #axis
         plt.subplot(2, len(samples), len(samples)+i+1)
@@ -28,28 +34,18 @@ def histo_uniform():
         plt.xlabel('x')
         plt.ylabel('y')
 
-        #histogram set
-        plt.hist(x, intervals, density=True, facecolor='blue')
+        #histogram set (density=True와 같게 넓이의 합을 1로)
+        width = [hi - lo for lo, hi in edges]
+        density = [c / (samples[i] * w) for c, w in zip(counts, width)]
+        plt.bar([lo for lo, hi in edges], density, width=width, align='edge', facecolor=color)
+
+# Uniform distribution
+def histo_uniform():
+    histo('uniform', 'blue')
 
 # Gaussian distribution
 def histo_gaussian():
-    for i in range(4):
-        #hw6.exe(sys.argv[1]) 파일로 인자(str(samples[i]), 'gaussian') 넣어서 실행
-        result = sp.run([sys.argv[1], str(samples[i]), 'gaussian'], stdout=sp.PIPE)
-        result = result.stdout.decode(encoding='UTF-8')
-        x = [float(j) * s + m for j in result.split()]
-
-        #axis
-        plt.subplot(2, len(samples), len(samples)+i+1)
-        #title
-        plt.title('[samples=' + str(samples[i]) + ']')
-
-        #label
-        plt.xlabel('x')
-        plt.ylabel('y')
-
-        #histogram set
-        plt.hist(x, intervals, density=True, facecolor='green')
+    histo('gaussian', 'green')
 
 
 plt.figure(1, figsize=(15, 5))
@@ -57,5 +53,5 @@ histo_uniform()
 plt.figure(2, figsize=(15, 5))
 histo_gaussian()
 
-#show figures 
-plt.show()
\ No newline at end of file
+#show figures
+plt.show()
@@ -3,81 +3,121 @@
 #include <time.h>
 #include <stdlib.h>
 #include <cmath>
+#include <thread>
+#include "../philox.h"
+#include "../stats.h"
 
-float ran1(long long  &idum)
-{
-	const int IA = 16807, IM = 2147483647, IQ = 127773, IR = 2836, NTAB = 32;
-	const int NDIV = (1 + (IM - 1) / NTAB);
-	const float EPS = 3.0e-16, AM = 1.0 / IM, RNMX = (1.0 - EPS);
-	static int iy = 0;
-	static int iv[NTAB];
-	int j, k;
-	float temp;
+const double UNIFORM_LO = -3, UNIFORM_HI = 2;
+const double GAUSS_MEAN = 0.5, GAUSS_SD = 1.5;
+const int BINS = 100;
 
-	if (idum <= 0 || !iy) {
-		if (-idum < 1) idum = 1;
-		else idum = -idum;
-		for (j = NTAB + 7; j >= 0; j--) {
-			k = idum / IQ;
-			idum = IA * (idum - k * IQ) - IR * k;
-			if (idum < 0) idum += IM;
-			if (j < NTAB) iv[j] = idum;
-		}
-		iy = iv[0];
-	}
-	k = idum / IQ;
-	idum = IA * (idum - k * IQ) - IR * k;
-	if (idum < 0) idum += IM;
-	j = iy / NDIV;
-	iy = iv[j];
-	iv[j] = idum;
-	if ((temp = AM * iy) > RNMX) return RNMX;
-	else return temp;
+//표준정규분포의 누적분포함수
+double normal_cdf(double z) {
+	return 0.5 * erfc(-z / sqrt(2.0));
 }
 
-float gasdev(long long  &idum)
-{
-	static int iset = 0;
-	static float gset;
-	float fac, rsq, v1, v2;
+//표본은 출력하지 않고 만들면서 바로 요약해 결과만 출력한다
+//기대값과 비교할 수 있도록 평균, 분산, 분위수의 이론값과
+//히스토그램의 카이제곱 통계량, 구간 경계에서의 누적분포 최대 차이도 출력한다
+int summarize(uint64_t n, const char *method, Philox &gen, int threads) {
+	const double Q[] = { 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99 };
+	//표준정규분포의 Q 분위수
+	const double ZQ[] = { -2.326347874, -1.644853627, -0.674489750, 0, 0.674489750, 1.644853627, 2.326347874 };
+	bool uniform = strcmp(method, "uniform") == 0;
+	double lo, hi, mean, var;
 
-	if (idum < 0) iset = 0;
-	if (iset == 0) {
-		do {
-			v1 = 2.0*ran1(idum) - 1.0;
-			v2 = 2.0*ran1(idum) - 1.0;
-			rsq = v1 * v1 + v2 * v2;
-		} while (rsq >= 1.0 || rsq == 0.0);
-		fac = sqrt(-2.0*log(rsq) / rsq);
-		gset = v1 * fac;
-		iset = 1;
-		return v2 * fac;
+	if (uniform) {
+		lo = UNIFORM_LO;
+		hi = UNIFORM_HI;
+		mean = (lo + hi) / 2;
+		var = (hi - lo) * (hi - lo) / 12;
 	}
-	else {
-		iset = 0;
-		return gset;
+	else if (strcmp(method, "gaussian") == 0) {
+		lo = GAUSS_MEAN - 5 * GAUSS_SD;
+		hi = GAUSS_MEAN + 5 * GAUSS_SD;
+		mean = GAUSS_MEAN;
+		var = GAUSS_SD * GAUSS_SD;
 	}
-}
+	else return 1;
+
+	StreamStats st = parallelStats(n, threads, lo, hi, BINS, [&](float *out, size_t count, uint64_t first) {
+		if (uniform) gen.fillUniform(out, count, UNIFORM_LO, UNIFORM_HI, first);
+		else gen.fillGaussian(out, count, GAUSS_MEAN, GAUSS_SD, first);
+	});
 
+	//이론 누적분포
+	auto cdf = [&](double x) {
+		if (uniform) return x <= lo ? 0.0 : x >= hi ? 1.0 : (x - lo) / (hi - lo);
+		return normal_cdf((x - GAUSS_MEAN) / GAUSS_SD);
+	};
 
+	printf("n = %llu\n", (unsigned long long)st.moments.count());
+	printf("mean = %.6f (expected %.6f)\n", st.moments.mean(), mean);
+	printf("variance = %.6f (expected %.6f)\n", st.moments.variance(), var);
+	printf("min = %.6f, max = %.6f\n", st.moments.min(), st.moments.max());
+	for (int i = 0; i < 7; i++) {
+		double e = uniform ? lo + Q[i] * (hi - lo) : GAUSS_MEAN + GAUSS_SD * ZQ[i];
+		printf("q%.2f = %.6f (expected %.6f)\n", Q[i], st.sketch.quantile(Q[i]), e);
+	}
+
+	double chi2 = 0, dmax = 0;
+	uint64_t acc = st.hist.below();
+	for (int b = 0; b < BINS; b++) {
+		double expect = n * (cdf(st.hist.edge(b + 1)) - cdf(st.hist.edge(b)));
+		double d = st.hist[b] - expect;
+		if (expect > 0) chi2 += d * d / expect;
+		acc += st.hist[b];
+		dmax = fmax(dmax, fabs((double)acc / n - cdf(st.hist.edge(b + 1))));
+	}
+	printf("chi2 = %.2f (dof %d), max |F - F0| = %.3g\n", chi2, BINS - 1, dmax);
+	printf("below = %llu, above = %llu\n", (unsigned long long)st.hist.below(), (unsigned long long)st.hist.above());
+
+	//구간마다 시작, 끝, 개수
+	printf("bins:\n");
+	for (int b = 0; b < BINS; b++)
+		printf("%f %f %llu\n", st.hist.edge(b), st.hist.edge(b + 1), (unsigned long long)st.hist[b]);
+	return 0;
+}
+
+//hw6 n method [stats] : method는 uniform 또는 gaussian
+//stats를 주면 표본 대신 요약 통계와 히스토그램만 출력한다
 int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		printf("usage: %s n uniform|gaussian [stats]\n", argv[0]);
+		return 1;
+	}
+	Philox gen((uint64_t)time(NULL));
+	int threads = (int)std::thread::hardware_concurrency();
+	if (argc > 3 && strcmp(argv[3], "stats") == 0)
+		return summarize(strtoull(argv[1], NULL, 10), argv[2], gen, threads);
+
 	int n = atoi(argv[1]);
 	char* method = argv[2];
-	long long seed;
-
-
+	float *x = (float*)malloc((n > 0 ? n : 1) * sizeof(float));
 
-	seed = time(NULL);
+	//난수를 배열에 한꺼번에 채운다
 	if (strcmp(method, "uniform") == 0) {
-		for (int i = 0; i < n; i++) {
-			printf("%f ", 5 * ran1(seed) - 3);
-		}
+		parallelFill(x, n, threads, [&](float *out, size_t count, uint64_t first) {
+			gen.fillUniform(out, count, UNIFORM_LO, UNIFORM_HI, first);
+		});
 	}
 	else if (strcmp(method, "gaussian") == 0) {
-		for (int i = 0; i < n; i++) {
-			printf("%f ", 1.5*gasdev(seed) + 0.5);
+		parallelFill(x, n, threads, [&](float *out, size_t count, uint64_t first) {
+			gen.fillGaussian(out, count, GAUSS_MEAN, GAUSS_SD, first);
+		});
+	}
+	else n = 0;
 
+	//버퍼에 모아서 한 번에 출력한다
+	static char buf[65536];
+	int len = 0;
+	for (int i = 0; i < n; i++) {
+		if (len > (int)sizeof(buf) - 64) {
+			fwrite(buf, 1, len, stdout);
+			len = 0;
 		}
-
+		len += sprintf(buf + len, "%f ", x[i]);
 	}
-}
\ No newline at end of file
+	fwrite(buf, 1, len, stdout);
+	free(x);
+}
@@ -1,12 +1,17 @@
 ﻿#include <stdio.h>
 #include <time.h>
 #include <cmath>
+#include <stdlib.h>
+#include <vector>
+#include "../matrix.h"
+#include "../philox.h"
 using namespace std;
 
-void rot(float** a, const float s, const float tau, const int i,
+template <typename T>
+void rot(Matrix<T> &a, const T s, const T tau, const int i,
 	const int j, const int k, const int l)
 {
-	float g, h;
+	T g, h;
 
 	g = a[i][j];
 	h = a[k][l];
@@ -14,14 +19,15 @@ void rot(float** a, const float s, const float tau, const int i,
 	a[k][l] = h + s * (g - h * tau);
 }
 
-void jacobi(float**a, float*d, float**v, int &nrot,int d_size)
+template <typename T>
+void jacobi(Matrix<T> &a, T*d, Matrix<T> &v, int &nrot,int d_size)
 {
 	int i, j, ip, iq;
-	float tresh, theta, tau, t, sm, s, h, g, c;
+	T tresh, theta, tau, t, sm, s, h, g, c;
 
 	int n = d_size;
-	float* b = (float *)malloc(n * sizeof(float));
-	float* z=(float *)malloc(n*sizeof(float));
+	T* b = (T *)malloc(n * sizeof(T));
+	T* z=(T *)malloc(n*sizeof(T));
 
 	for (ip = 0; ip < n; ip++) {
 		for (iq = 0; iq < n; iq++) v[ip][iq] = 0.0;
@@ -89,10 +95,180 @@ void jacobi(float**a, float*d, float**v, int &nrot,int d_size)
 	printf("Too many iterations in routine jacobi");
 }
 
-void eigsrt(float* d, float **v,int d_size)
+//Householder 변환으로 대칭 행렬 a를 삼중대각 행렬로 만든다 (NR tred2)
+//d에 대각 원소, e[1..n-1]에 부대각 원소가 들어가고 a는 변환 행렬 Q가 된다
+//Q를 모으는 마지막 단계는 열을 따라 내려가던 원래 루프 대신
+//행 i의 내적 g[j]를 한꺼번에 구해 행 단위로 갱신한다 (더하는 순서는 같다)
+template <typename T>
+void tred2(Matrix<T> &a, T *d, T *e, int n)
+{
+	int l, k, j, i;
+	T scale, hh, h, g, f;
+	vector<T> gs(n);
+
+	for (i = n - 1; i > 0; i--) {
+		l = i - 1;
+		h = scale = 0.0;
+		if (l > 0) {
+			for (k = 0; k < l + 1; k++)
+				scale += fabs(a[i][k]);
+			if (scale == 0.0)
+				e[i] = a[i][l];
+			else {
+				for (k = 0; k < l + 1; k++) {
+					a[i][k] /= scale;
+					h += a[i][k] * a[i][k];
+				}
+				f = a[i][l];
+				g = (f >= 0.0 ? -sqrt(h) : sqrt(h));
+				e[i] = scale * g;
+				h -= f * g;
+				a[i][l] = f - g;
+				f = 0.0;
+				for (j = 0; j < l + 1; j++) {
+					a[j][i] = a[i][j] / h;
+					g = 0.0;
+					for (k = 0; k < j + 1; k++)
+						g += a[j][k] * a[i][k];
+					for (k = j + 1; k < l + 1; k++)
+						g += a[k][j] * a[i][k];
+					e[j] = g / h;
+					f += e[j] * a[i][j];
+				}
+				hh = f / (h + h);
+				for (j = 0; j < l + 1; j++) {
+					f = a[i][j];
+					e[j] = g = e[j] - hh * f;
+					for (k = 0; k < j + 1; k++)
+						a[j][k] -= (f*e[k] + g * a[i][k]);
+				}
+			}
+		}
+		else
+			e[i] = a[i][l];
+		d[i] = h;
+	}
+	d[0] = 0.0;
+	e[0] = 0.0;
+	for (i = 0; i < n; i++) {
+		l = i;
+		if (d[i] != 0.0) {
+			for (j = 0; j < l; j++) gs[j] = 0.0;
+			for (k = 0; k < l; k++) {
+				T aik = a[i][k];
+				for (j = 0; j < l; j++) gs[j] += aik * a[k][j];
+			}
+			for (k = 0; k < l; k++) {
+				T aki = a[k][i];
+				for (j = 0; j < l; j++) a[k][j] -= gs[j] * aki;
+			}
+		}
+		d[i] = a[i][i];
+		a[i][i] = 1.0;
+		for (j = 0; j < l; j++) a[j][i] = a[i][j] = 0.0;
+	}
+}
+
+template <typename T>
+T pythag(const T a, const T b)
+{
+	T absa = fabs(a), absb = fabs(b);
+
+	if (absa > absb) return absa * sqrt(1.0 + (absb / absa)*(absb / absa));
+	return (absb == 0.0 ? 0.0 : absb * sqrt(1.0 + (absa / absb)*(absa / absb)));
+}
+
+//삼중대각 행렬(d, e)의 고유값을 암시적 이동 QL로 구한다 (NR tqli)
+//zt는 tred2가 만든 Q의 전치(행 k가 k번째 열)로 받아서 고유벡터를 행으로 돌려준다
+//회전마다 인접한 두 열을 갱신하는데, 전치해 두면 두 연속된 행을 훑게 된다
+template <typename T>
+void tqli(T *d, T *e, Matrix<T> &zt, int n)
+{
+	int m, l, iter, i, k;
+	T s, r, p, g, f, dd, c, b;
+
+	for (i = 1; i < n; i++) e[i - 1] = e[i];
+	e[n - 1] = 0.0;
+	for (l = 0; l < n; l++) {
+		iter = 0;
+		do {
+			for (m = l; m < n - 1; m++) {
+				dd = fabs(d[m]) + fabs(d[m + 1]);
+				if (fabs(e[m]) + dd == dd) break;
+			}
+			if (m != l) {
+				if (iter++ == 30) {
+					printf("Too many iterations in tqli");
+					return;
+				}
+				g = (d[l + 1] - d[l]) / (2.0*e[l]);
+				r = pythag(g, (T)1.0);
+				g = d[m] - d[l] + e[l] / (g + (g >= 0.0 ? fabs(r) : -fabs(r)));
+				s = c = 1.0;
+				p = 0.0;
+				for (i = m - 1; i >= l; i--) {
+					f = s * e[i];
+					b = c * e[i];
+					e[i + 1] = (r = pythag(f, g));
+					if (r == 0.0) {
+						d[i + 1] -= p;
+						e[m] = 0.0;
+						break;
+					}
+					s = f / r;
+					c = g / r;
+					g = d[i + 1] - p;
+					r = (d[i] - g)*s + 2.0*c*b;
+					d[i + 1] = g + (p = s * r);
+					g = c * r - b;
+					T *zi = zt[i], *zi1 = zt[i + 1];
+					for (k = 0; k < n; k++) {
+						f = zi1[k];
+						zi1[k] = s * zi[k] + c * f;
+						zi[k] = c * zi[k] - s * f;
+					}
+				}
+				if (r == 0.0 && i >= l) continue;
+				d[l] -= p;
+				e[l] = g;
+				e[m] = 0.0;
+			}
+		} while (m != l);
+	}
+}
+
+//이 크기보다 큰 행렬은 Jacobi 대신 tred2 + tqli로 푼다
+//Jacobi는 한 번 훑을 때마다 O(n^3)이고 여러 번 훑어야 하지만
+//tred2 + tqli는 전체가 O(n^3) 몇 번이다
+const int JACOBI_MAX = 32;
+
+//대칭 행렬 a의 고유값 d와 고유벡터 v(열)를 구한다
+//작은 행렬은 jacobi로 풀어 a가 대각화되고 nrot에 회전 횟수가 들어간다
+//큰 행렬은 a가 변환 행렬로 덮어써지고 nrot은 0이다
+template <typename T>
+void eigen(Matrix<T> &a, T *d, Matrix<T> &v, int &nrot, int n)
+{
+	if (n <= JACOBI_MAX) {
+		jacobi(a, d, v, nrot, n);
+		return;
+	}
+
+	vector<T> e(n);
+	Matrix<T> zt(n, n);
+	nrot = 0;
+	tred2(a, d, e.data(), n);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) zt[j][i] = a[i][j];
+	tqli(d, e.data(), zt, n);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) v[i][j] = zt[j][i];
+}
+
+template <typename T>
+void eigsrt(T* d, Matrix<T> &v,int d_size)
 {
 	int i, j, k;
-	float p;
+	T p;
 
 	int n = d_size;
 	for (i = 0; i < n - 1; i++) {
@@ -111,112 +287,67 @@ void eigsrt(float* d, float **v,int d_size)
 	}
 }
 
-float ran1(long long &idum)
-{
-	const int IA = 16807, IM = 2147483647, IQ = 127773, IR = 2836, NTAB = 32;
-	const int NDIV = (1 + (IM - 1) / NTAB);
-	const float EPS = 3.0e-16, AM = 1.0 / IM, RNMX = (1.0 - EPS);
-	static int iy = 0;
-	static float* iv = (float*)malloc(NTAB*sizeof(float));
-	int j, k;
-	float temp;
-
-	if (idum <= 0 || !iy) {
-		if (-idum < 1) idum = 1;
-		else idum = -idum;
-		for (j = NTAB + 7; j >= 0; j--) {
-			k = idum / IQ;
-			idum = IA * (idum - k * IQ) - IR * k;
-			if (idum < 0) idum += IM;
-			if (j < NTAB) iv[j] = idum;
-		}
-		iy = iv[0];
-	}
-	k = idum / IQ;
-	idum = IA * (idum - k * IQ) - IR * k;
-	if (idum < 0) idum += IM;
-	j = iy / NDIV;
-	iy = iv[j];
-	iv[j] = idum;
-	if ((temp = AM * iy) > RNMX) return RNMX;
-	else return temp;
-}
-
+//float, double, long double로 미리 만들어 둔다
+#define EIGEN_INSTANTIATE(T) \
+	template void jacobi<T>(Matrix<T> &, T *, Matrix<T> &, int &, int); \
+	template void eigen<T>(Matrix<T> &, T *, Matrix<T> &, int &, int); \
+	template void eigsrt<T>(T *, Matrix<T> &, int);
+EIGEN_INSTANTIATE(float)
+EIGEN_INSTANTIATE(double)
+EIGEN_INSTANTIATE(long double)
+#undef EIGEN_INSTANTIATE
 
-float gasdev(long long  &idum)
-{
-	static int iset = 0;
-	static float gset;
-	float fac, rsq, v1, v2;
-
-	if (idum < 0) iset = 0;
-	if (iset == 0) {
-		do {
-			v1 = 2.0*ran1(idum) - 1.0;
-			v2 = 2.0*ran1(idum) - 1.0;
-			rsq = v1 * v1 + v2 * v2;
-		} while (rsq >= 1.0 || rsq == 0.0);
-		fac = sqrt(-2.0*log(rsq) / rsq);
-		gset = v1 * fac;
-		iset = 1;
-		return v2 * fac;
-	}
-	else {
-		iset = 0;
-		return gset;
-	}
-}
-
-
-int main() {
-	const int N = 11;
-	float **a = (float**)malloc((N+1) * sizeof(float*));
-	float **v = (float**)malloc((N+1) * sizeof(float*));
+//hw7 [N] : N x N 임의 대칭 행렬의 고유값을 구한다 (기본 11)
+//N이 크면 행렬과 고유벡터는 출력하지 않는다
+int main(int argc, char *argv[]) {
+	const int N = argc > 1 ? atoi(argv[1]) : 11;
+	const int PRINT_MAX = 20;
+	Matrix<float> a(N, N, 1);
+	Matrix<float> v(N, N, 1);
 	float *d = (float*)malloc((N+1) * sizeof(float));
 
-	for (int i = 0; i <= N; i++)
-	{
-		a[i] = (float*)malloc((N+1) * sizeof(float));
-		v[i] = (float*)malloc((N+1) * sizeof(float));
-	}
-
-	long long idum = time(NULL);
-	int nrot;
+	Philox gen((uint64_t)time(NULL));
+	vector<float> ran((size_t)N * (N + 1) / 2);
+	int nrot, cnt = 0;
 
 	printf("Generate random matrix....\n");
+	gen.fillGaussian(ran.data(), ran.size(), 0, 1);
 	for (int i = 1; i <= N; i++)
 		for (int j = i; j <= N; j++) {
-			float ran = gasdev(idum);
-			a[i][j] = ran;
-			a[j][i] = ran;
+			a[i][j] = ran[cnt];
+			a[j][i] = ran[cnt++];
 		}
 
-	printf("Random matrix before Succesive diagonalization:\n");
-	for (int i = 1; i <= N; i++) {
-		for (int j = 1; j <= N; j++) {
-			printf("%f ", a[i][j]);
+	if (N <= PRINT_MAX) {
+		printf("Random matrix before Succesive diagonalization:\n");
+		for (int i = 1; i <= N; i++) {
+			for (int j = 1; j <= N; j++) {
+				printf("%f ", a[i][j]);
+			}
+			printf("\n");
 		}
-		printf("\n");
 	}
 	
-	jacobi(a, d, v, nrot, N+1);
+	eigen(a, d, v, nrot, N+1);
 	eigsrt(d, v, N+1);
 
-	printf("\nRandom matrix after Succesive diagonalization:\n");
-	for (int i = 1; i <= N; i++) {
-		for (int j = 1; j <= N; j++) {
-			printf("%f ", a[i][j]);
+	if (N <= PRINT_MAX) {
+		printf("\nRandom matrix after Succesive diagonalization:\n");
+		for (int i = 1; i <= N; i++) {
+			for (int j = 1; j <= N; j++) {
+				printf("%f ", a[i][j]);
+			}
+			printf("\n");
 		}
-		printf("\n");
-	}
 
 
-	printf("\nEigen vectors:\n");
-	for (int i = 1; i <= N; i++ ) {
-		for (int j = 1; j <= N; j++) {
-			printf("%f ", v[i][j]);
+		printf("\nEigen vectors:\n");
+		for (int i = 1; i <= N; i++ ) {
+			for (int j = 1; j <= N; j++) {
+				printf("%f ", v[i][j]);
+			}
+			printf("\n");
 		}
-		printf("\n");
 	}
 
 	printf("\nEigen values:\n");
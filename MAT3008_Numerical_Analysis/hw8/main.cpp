@@ -1,16 +1,36 @@
 ﻿#include <iostream>
 #include <string>
+#include <string.h>
 #include <sstream>
+#include <vector>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/videoio.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/core.hpp>
+#include "../pngstream.h"
+#include "../bench.h"
 using namespace cv;
 using namespace std;
 void bilinear_interpolation(Mat *orgImg, Mat *resImg);
+void bilinear_interpolation_fast(const Mat &orgImg, Mat &resImg);
+bool bilinear_interpolation_tiled(const char *src, const char *dst, int target_m, int target_n);
+void bench(int target_m, int target_n);
 
 
-int main() {
+int main(int argc, char *argv[]) {
+	//hw8 tiled [원본.png] [결과.png] [가로] [세로] : 창을 띄우지 않고 파일에서 파일로 바꾼다
+	if (argc > 5 && strcmp(argv[1], "tiled") == 0) {
+		if (!bilinear_interpolation_tiled(argv[2], argv[3], atoi(argv[4]), atoi(argv[5]))) {
+			cout << "Failed to resize " << argv[2] << endl;
+			return 1;
+		}
+		return 0;
+	}
+	//hw8 bench [가로] [세로] : 창을 띄우지 않고 두 구현의 시간을 잰다
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench(argc > 3 ? atoi(argv[2]) : 1600, argc > 3 ? atoi(argv[3]) : 1200);
+		return 0;
+	}
 
 	int target_m,target_n;
 	//변환시킬 사이즈를 입력받기
@@ -29,7 +49,7 @@ int main() {
 	
 	//bilinear interpolation을 통한 resize
 	Mat result = Mat::zeros(target_n, target_m, CV_8UC3);
-	bilinear_interpolation(&original, &result);
+	bilinear_interpolation_fast(original, result);
 
 	cout << result.rows << endl;
 	cout << result.cols << endl;
@@ -80,4 +100,178 @@ void bilinear_interpolation(Mat *orgImg, Mat *resImg) {
 		}
 	}
 
-}
\ No newline at end of file
+}
+
+
+//고정소수점 가중치의 소수부 비트 수
+const int INTER_BITS = 11;
+const int INTER_ONE = 1 << INTER_BITS;
+
+//크기를 바꿀 때 새 열/행마다의 원래 위치와 가중치
+//bilinear_interpolation과 같은 가중치를 한 번만 구해 둔다
+struct InterpTable {
+	vector<int> x_off, w_x1;	//새 x의 원래 x * 3, 가중치
+	vector<int> y_org, w_y1;	//새 y의 원래 y, 가중치
+	int x_end;	//이 x부터는 범위를 벗어나 계산하지 않는다
+
+	InterpTable(int org_rows, int org_cols, int res_rows, int res_cols)
+		: x_off(res_cols), w_x1(res_cols), y_org(res_rows), w_y1(res_rows), x_end(0) {
+		//각 축에대한 확대 또는 축소 비율 구하기
+		double x_rate = (double)res_cols / org_cols;
+		double y_rate = (double)res_rows / org_rows;
+
+		for (int x = 0; x < res_cols; x++) {
+			int x_org = (int)(x / x_rate);
+			if (x_org + 1 >= org_cols) break;
+			x_off[x] = x_org * 3;
+			w_x1[x] = (int)(((double)x / x_rate - x_org) * INTER_ONE + 0.5);
+			x_end = x + 1;
+		}
+		for (int y = 0; y < res_rows; y++) {
+			y_org[y] = (int)(y / y_rate);
+			w_y1[y] = (int)(((double)y / y_rate - y_org[y]) * INTER_ONE + 0.5);
+		}
+	}
+};
+
+//새 행 하나의 [x0, x1) 픽셀을 원래의 두 행 row_1, row_2에서 구한다
+//정수 연산만 쓴다 (CV_8UC3 전용)
+static void interpolate_row(const InterpTable &t, int y, const uchar *row_1, const uchar *row_2,
+	uchar *dst, int x0, int x1) {
+	const int e_y1 = t.w_y1[y];
+	const int e_y2 = INTER_ONE - e_y1;
+
+	for (int x = x0; x < x1; x++) {
+		const uchar *p_1 = row_1 + t.x_off[x];
+		const uchar *p_3 = row_2 + t.x_off[x];
+		const int e_x1 = t.w_x1[x];
+		const int e_x2 = INTER_ONE - e_x1;
+
+		//각 사각형의 넓이 (소수부 2*INTER_BITS 비트)
+		const int width_1 = e_x1 * e_y2;
+		const int width_2 = e_x2 * e_y2;
+		const int width_3 = e_x1 * e_y1;
+		const int width_4 = e_x2 * e_y1;
+
+		for (int c = 0; c < 3; c++)
+			dst[x * 3 + c] = (uchar)((width_1 * p_1[c] + width_2 * p_1[c + 3] +
+				width_3 * p_3[c] + width_4 * p_3[c + 3] +
+				(1 << (2 * INTER_BITS - 1))) >> (2 * INTER_BITS));
+	}
+}
+
+//bilinear_interpolation과 같은 가중치로 크기를 바꾸는 빠른 버전
+//열/행마다의 원래 위치와 가중치를 한 번만 구해 두고, 행 우선으로 돌며
+//정수 연산만 쓰고, 행들을 여러 스레드에 나눈다 (CV_8UC3 전용)
+void bilinear_interpolation_fast(const Mat &orgImg, Mat &resImg) {
+	InterpTable t(orgImg.rows, orgImg.cols, resImg.rows, resImg.cols);
+
+	parallel_for_(Range(0, resImg.rows), [&](const Range &range) {
+		for (int y = range.start; y < range.end; y++) {
+			//범위에서 벗어나면 out
+			if (t.y_org[y] + 1 >= orgImg.rows) continue;
+
+			interpolate_row(t, y, orgImg.ptr<uchar>(t.y_org[y]), orgImg.ptr<uchar>(t.y_org[y] + 1),
+				resImg.ptr<uchar>(y), 0, t.x_end);
+		}
+	});
+}
+
+//타일 하나의 크기 (결과 픽셀)
+const int TILE_ROWS = 64;
+const int TILE_COLS = 256;
+
+//bilinear_interpolation_fast와 같은 결과를 원본과 결과를 통째로 메모리에 두지 않고 만든다
+//결과를 TILE_ROWS행씩의 띠로 나누어 위에서부터
+//  1. 띠가 쓰는 원본 행(새 y마다 y_org와 그 아래 한 행)만 PNG에서 풀고
+//  2. 띠를 TILE_ROWS x TILE_COLS 타일로 나누어 parallel_for_로 계산한 뒤
+//  3. 띠의 행들을 바로 PNG로 내보낸다
+//y_org는 y에 따라 늘기만 하므로 원본은 위에서 아래로 한 번만 풀고,
+//이전 띠와 겹치는 원본 행(아래쪽 halo 한두 행)은 다시 풀지 않고 옮겨 온다
+//메모리는 원본 행 2 * TILE_ROWS개와 결과 행 TILE_ROWS개 정도로 크기와 상관없다
+bool bilinear_interpolation_tiled(const char *src, const char *dst, int target_m, int target_n) {
+	PngRowReader in;
+	PngRowWriter out;
+	if (target_m <= 0 || target_n <= 0) return false;
+	if (!in.open(src) || !out.open(dst, target_n, target_m)) return false;
+
+	InterpTable t(in.rows(), in.cols(), target_n, target_m);
+	size_t src_bytes = (size_t)in.cols() * 3, dst_bytes = (size_t)target_m * 3;
+	vector<int> need, prev_need;	//띠가 쓰는 원본 행 번호 (오름차순)
+	vector<uchar> rows, prev_rows;	//need[i]행은 rows의 i번째 행
+	vector<uchar> skip(src_bytes), band;
+	vector<const uchar *> row_1(TILE_ROWS);	//띠의 각 행이 쓰는 원본 행 (없으면 NULL)
+	int next = 0;	//다음에 풀 원본 행
+
+	for (int y0 = 0; y0 < target_n; y0 += TILE_ROWS) {
+		int y1 = min(y0 + TILE_ROWS, target_n);
+
+		need.clear();
+		for (int y = y0; y < y1; y++) {
+			int r = t.y_org[y];
+			if (r + 1 >= in.rows()) continue;
+			if (need.empty() || need.back() < r) need.push_back(r);
+			if (need.back() < r + 1) need.push_back(r + 1);
+		}
+
+		//필요한 행만 남기고 나머지는 풀어서 버린다
+		rows.resize(need.size() * src_bytes);
+		for (size_t i = 0; i < need.size(); i++) {
+			uchar *p = &rows[i * src_bytes];
+			if (need[i] < next) {
+				size_t j = lower_bound(prev_need.begin(), prev_need.end(), need[i]) - prev_need.begin();
+				memcpy(p, &prev_rows[j * src_bytes], src_bytes);
+				continue;
+			}
+			for (; next < need[i]; next++)
+				if (!in.readRow(skip.data())) return false;
+			if (!in.readRow(p)) return false;
+			next++;
+		}
+		for (int y = y0; y < y1; y++) {
+			int r = t.y_org[y];
+			row_1[y - y0] = NULL;
+			if (r + 1 >= in.rows()) continue;
+			row_1[y - y0] = &rows[(lower_bound(need.begin(), need.end(), r) - need.begin()) * src_bytes];
+		}
+
+		band.assign((size_t)(y1 - y0) * dst_bytes, 0);
+		int tiles_x = (t.x_end + TILE_COLS - 1) / TILE_COLS;
+		parallel_for_(Range(0, (y1 - y0) * tiles_x), [&](const Range &range) {
+			for (int i = range.start; i < range.end; i++) {
+				int y = y0 + i / tiles_x, x0 = i % tiles_x * TILE_COLS;
+				const uchar *p = row_1[y - y0];
+				if (!p) continue;
+				interpolate_row(t, y, p, p + src_bytes, &band[(size_t)(y - y0) * dst_bytes],
+					x0, min(x0 + TILE_COLS, t.x_end));
+			}
+		});
+
+		for (int y = y0; y < y1; y++)
+			if (!out.writeRow(&band[(size_t)(y - y0) * dst_bytes])) return false;
+		rows.swap(prev_rows);
+		need.swap(prev_need);
+	}
+	return out.finish();
+}
+
+
+//1024 x 768 난수 이미지를 target_m x target_n으로 바꾸는 한 번의 시간
+//bench/run.sh가 모으는 "BENCH 이름 값 단위" 꼴로 출력
+void bench(int target_m, int target_n) {
+	Mat original(768, 1024, CV_8UC3);
+	randu(original, Scalar::all(0), Scalar::all(256));
+	Mat result = Mat::zeros(target_n, target_m, CV_8UC3);
+
+	BenchResult r = benchmark([&]() {
+		bilinear_interpolation(&original, &result);
+		return (double)result.data[0];
+	}, 1.0);
+	printf("BENCH bilinear_%dx%d %.1f ns\n", target_m, target_n, r.median);
+
+	r = benchmark([&]() {
+		bilinear_interpolation_fast(original, result);
+		return (double)result.data[0];
+	}, 1.0);
+	printf("BENCH bilinear_fast_%dx%d %.1f ns\n", target_m, target_n, r.median);
+}
@@ -4,85 +4,50 @@
 #include <malloc.h>
 #include <iostream>
 #include <cmath>
+#include "../matrix.h"
+#include "../datafile.h"
+#include "../lsq.h"
+#include "../bench.h"
+#include "../philox.h"
 using namespace std;
-void svdcmp(float**a, float*w, float**v, int n, int m);
-float** multiMatrix(float **mat1, float **mat2, int row_1, int col_1, int col_2);
-void SWAP(float *a, float *b);
-float MAX(float a, float b);
-float MIN(float a, float b);
-float SIGN(const float &a, const double &b);
-float pythag(const float a, const float b);
-float SQR(float a);
-float** transMatrix(float **mat1, int n);
-float** make_matrix(int n, int m);
-float **problem_svdcmp(float **A, float **b, int M, int K);
-void gaussj(float ** a, float **b, int n, int m);
-float **fit_data(float **f, float **y, int n, int m, int k);
-
-typedef struct {
-	float x;
-	float y;
-	float xp;
-	float yp;
-} Data;
-
-typedef struct {
-	Data *data;
-	int size;
-	int _capacity;
-} DataList;
-
-
-int main() {
+template <typename T> void svdcmp(Matrix<T> &a, T*w, Matrix<T> &v, int n, int m);
+Matrix<float> multiMatrix(const Matrix<float> &mat1, const Matrix<float> &mat2, int row_1, int col_1, int col_2);
+template <typename T> void SWAP(T *a, T *b);
+template <typename T> T MAX(T a, T b);
+template <typename T> T MIN(T a, T b);
+template <typename T> T SIGN(const T &a, const double &b);
+template <typename T> T pythag(const T a, const T b);
+template <typename T> T SQR(T a);
+Matrix<float> transMatrix(const Matrix<float> &mat1, int n);
+Matrix<float> problem_svdcmp(Matrix<float> &A, Matrix<float> &b, int M, int K);
+template <typename T> void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m);
+Matrix<float> fit_stream(DataReader &in, int m, int k);
+void bench(int n);
+
+
+int main(int argc, char *argv[]) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench(argc > 2 ? atoi(argv[2]) : 64);
+		return 0;
+	}
+
 	//파일 받아오기
 	char filename[30];
 	scanf("%s", filename);
-	FILE *fp = fopen(filename, "r");
-
-	//데이터 리스트 초기화
-	DataList *list = (DataList*)malloc(sizeof(DataList));
-	list->data = (Data*)malloc(sizeof(Data));
-	list->size = 0;
-	list->_capacity = 1;
-
-	//데이터 입력받기
-	Data *data = &list->data[0];
-
-	while (fscanf(fp, "%f %f %f %f", &data->x, &data->y, &data->xp, &data->yp) == 4) {
-		list->size++;
-		//용량 초과시 용량 늘려주기
-		if (list->size == list->_capacity) {
-			list->_capacity *= 2;
-			list->data = (Data*)realloc(list->data, sizeof(Data) * (list->_capacity));
-		}
-		data = &list->data[list->size];
+	DataReader in;
+	if (!in.open(filename)) {
+		printf("Failed to open file: %s\n", filename);
+		return 1;
 	}
-	fclose(fp);
 
 	// f=> n * m matrix
 	// y=> n * k matrix
 	// a=> m * k matrix
-	int n = list->size;
 	int m = 3;
 	int k = 2;
 
-	//매트릭스 생성
-	float **f = make_matrix(n, m);
-	float **y = make_matrix(n, k);
-
-	for (int i = 1; i <= n; i++) {
-		f[i][1] = list->data[i - 1].x;
-		f[i][2] = list->data[i - 1].y;
-		f[i][3] = 1;
-		//ax+ay+a => 관찰 데이터
-
-		y[i][1] = list->data[i - 1].xp;//x'
-		y[i][2] = list->data[i - 1].yp;//y'
-	}
-	//printf("1\n");
 	//매개변수
-	float **a = fit_data(f, y, n, m, k);
-	int cnt = 1;
+	Matrix<float> a = fit_stream(in, m, k);
 	for (int i = 1; i <= m; i++)
 	{
 		for (int j= 1; j <= k; j++)
@@ -96,47 +61,37 @@ int main() {
 }
 
 //fit 함수
-float **fit_data(float **f, float **y, int n, int m, int k) {
+//x y xp yp를 한 행씩 읽으며 Givens 회전으로 F = QR의 R과 Q^T*y에 바로 흡수하므로
+//데이터를 메모리에 모아 두지 않고 파일을 한 번만 읽는다
+//F^T*F를 만들지 않아 조건수가 제곱되지 않고, 작은 R만 SVD로 푼다 (lsq.h)
+Matrix<float> fit_stream(DataReader &in, int m, int k) {
 	//새 매트릭스 생성
-	float **fit_f = make_matrix(m, m);
-	float **fit_y = make_matrix(m, k);
-	//printf("2-fit\n");
-
-	for (int i = 1; i <= m; i++) {
-		for (int j = 1; j <= m; j++) {
-			for (int k = 1; k <= n; k++)
-				fit_f[i][j] += f[k][i] * f[k][j];//F_t*F
-		}
+	Matrix<float> fit_r(m, m, 1);
+	Matrix<float> fit_z(m, k, 1);
+	float row[4], f[3], y[2];
+
+	while (in.next(row, 4)) {
+		f[0] = row[0];
+		f[1] = row[1];
+		f[2] = 1;
+		y[0] = row[2];
+		y[1] = row[3];
+		//ax+ay+a => 관찰 데이터, y => x', y'
+		qrAddRow(f, y, m, k, fit_r, fit_z);
 	}
-	//printf("3-fit\n");
-
-	for (int i = 1; i <= m; i++) {
-		for (int j = 1; j <= k; j++) {
-			for (int k = 1; k <= n; k++)
-				fit_y[i][j] += f[k][i] * y[k][j]; //F_t*y
-		}
-	}
-	//F_t*F*a=F_t*y 
+	//R*a=Q_t*y
 	//해(a) 구하기
-	return problem_svdcmp(fit_f, fit_y, m, k);
+	return lsqSolve(fit_r, fit_z, m, k);
 
 
 }
 
-//매트릭스 생성함수
-float** make_matrix(int n, int m) {
-	float **new_mat = (float**)calloc((n + 1), sizeof(float*));
-	for (int i = 0; i <= n; i++)
-		new_mat[i] = (float*)calloc((m + 1), sizeof(float));
-
-	return new_mat;
-}
-
 //============================================================================================
 
-float pythag(const float a, const float b)
+template <typename T>
+T pythag(const T a, const T b)
 {
-	float absa, absb;
+	T absa, absb;
 
 	absa = fabs(a);
 	absb = fabs(b);
@@ -144,30 +99,35 @@ float pythag(const float a, const float b)
 	else return (absb == 0.0 ? 0.0 : absb * sqrt(1.0 + SQR(absa / absb)));
 }
 
-float SQR(float a) {
+template <typename T>
+T SQR(T a) {
 	return a * a;
 }
 
 
-void SWAP(float * a,float* b) {
-	float tmp = *a;
+template <typename T>
+void SWAP(T * a,T* b) {
+	T tmp = *a;
 	*a = *b;
 	*b = tmp;
 }
 
 
-float MAX(float a, float b)
+template <typename T>
+T MAX(T a, T b)
 {
 	return a > b ? a : b;
 }
 
-float MIN(float a, float b)
+template <typename T>
+T MIN(T a, T b)
 {
 	return a < b ? a : b;
 
 }
 
-float SIGN(const float &a, const double &b)
+template <typename T>
+T SIGN(const T &a, const double &b)
 {
 	return b >= 0 ? (a >= 0 ? a : -a) : (a >= 0 ? -a : a);
 }
@@ -176,40 +136,23 @@ float SIGN(const float &a, const double &b)
 
 
 // 두 매트릭스의 곱을 구하는 함수
-float** multiMatrix(float **mat1, float **mat2, int row_1, int col_1, int col_2) {
-	int i, j, k;
-	float resTemp = 0.0;
-
-
-	float** ret = (float**)malloc(sizeof(float*)*row_1);
-	for (int i = 1; i < row_1; i++)
-	{
-		ret[i] = (float*)malloc(sizeof(float)*col_2);
-	}
-
-	for (i = 1; i < row_1; i++) {
-		for (j = 1; j < col_2; j++) {
-			for (k = 1; k < col_1; k++) {
-				resTemp += mat1[i][k] * mat2[k][j];
-			}
-			ret[i][j] = resTemp;
-			resTemp = 0.0;
-		}
-	}
-
+Matrix<float> multiMatrix(const Matrix<float> &mat1, const Matrix<float> &mat2, int row_1, int col_1, int col_2) {
+	Matrix<float> ret(row_1 - 1, col_2 - 1, 1);
 
+	gemm(mat1, mat2, ret, row_1 - 1, col_1 - 1, col_2 - 1);
 	return ret;
 }
 
 
-void svdcmp(float**a, float*w, float**v, int n, int m)
+template <typename T>
+void svdcmp(Matrix<T> &a, T*w, Matrix<T> &v, int n, int m)
 {
 	bool flag;
 	int i, its, j, jj, k, l, nm;
-	float anorm, c, f, g, h, s, scale, x, y, z;
+	T anorm, c, f, g, h, s, scale, x, y, z;
 
-	float* rv1;
-	rv1 = (float*)malloc(sizeof(float)*n);
+	T* rv1;
+	rv1 = (T*)malloc(sizeof(T)*n);
 
 	g = scale = anorm = 0.0;
 	for (i = 0; i < n; i++) {
@@ -337,7 +280,7 @@ void svdcmp(float**a, float*w, float**v, int n, int m)
 			g = rv1[nm];
 			h = rv1[k];
 			f = ((y - z)*(y + z) + (g - h)*(g + h)) / (2.0*h*y);
-			g = pythag(f, 1.0);
+			g = pythag(f, (T)1.0);
 			f = ((x - z)*(x + z) + h * ((y / (f + SIGN(g, f))) - h)) / x;
 			c = s = 1.0;
 			for (j = l; j <= nm; j++) {
@@ -385,14 +328,10 @@ void svdcmp(float**a, float*w, float**v, int n, int m)
 
 
 // transformation 매트릭스를 산출해 내는 함수
-float** transMatrix(float **mat1, int n) {
+Matrix<float> transMatrix(const Matrix<float> &mat1, int n) {
 	int i, j;
 
-	float** ret = (float**)malloc(sizeof(float*)*n);
-	for (int i = 1; i < n; i++)
-	{
-		ret[i] = (float*)malloc(sizeof(float)*n);
-	}
+	Matrix<float> ret(n - 1, n - 1, 1);
 
 	for (i = 1; i < n; i++)
 		for (j = 1; j < n; j++)
@@ -404,20 +343,13 @@ float** transMatrix(float **mat1, int n) {
 
 
 
-float **problem_svdcmp(float **A, float **b,int M,int K) {
+Matrix<float> problem_svdcmp(Matrix<float> &A, Matrix<float> &b,int M,int K) {
 	float * w = (float*)calloc(M+1, sizeof(float));
 
 
-	float **w_ = (float**)calloc(M+1, sizeof(float *));
-	float **x  = (float**)calloc(M+1, sizeof(float *));
-	float **v = (float**)calloc(M+1, sizeof(float*));
-
-	for (int i = 0; i < M+1; i++) {
-		w_[i] = (float*)calloc(M+1, sizeof(float));
-		x[i] = (float*)calloc(K+1, sizeof(float));
-		v[i] = (float*)calloc(M+1, sizeof(float));
-
-	}
+	Matrix<float> w_(M, M, 1);
+	Matrix<float> x(M, K, 1);
+	Matrix<float> v(M, M, 1);
 
 	//printf("4-svd\n");
 
@@ -457,7 +389,7 @@ float **problem_svdcmp(float **A, float **b,int M,int K) {
 			else {
 				//printf("8-not homo\n");
 
-				float ** tmp1, **tmp2;
+				Matrix<float> tmp1, tmp2;
 				for (int i = 1; i <= M; i++)
 				{
 					w_[i][i] = ((w[i] == 0) ? 0 : float(1 / w[i]));
@@ -478,10 +410,11 @@ float **problem_svdcmp(float **A, float **b,int M,int K) {
 	return x;
 }
 
-void gaussj(float ** a, float **b, int n, int m)
+template <typename T>
+void gaussj(Matrix<T> &a, Matrix<T> &b, int n, int m)
 {
 	int i, icol, irow, j, k, l, ll;
-	float big, dum, pivinv;
+	T big, dum, pivinv;
 
 	int* indxc, *indxr, *ipiv;
 	indxc = (int *)malloc(sizeof(int)*n);
@@ -530,4 +463,43 @@ void gaussj(float ** a, float **b, int n, int m)
 	}
 }
 
+//float, double, long double로 미리 만들어 둔다
+#define NR_INSTANTIATE(T) \
+	template void svdcmp<T>(Matrix<T> &, T *, Matrix<T> &, int, int); \
+	template void gaussj<T>(Matrix<T> &, Matrix<T> &, int, int);
+NR_INSTANTIATE(float)
+NR_INSTANTIATE(double)
+NR_INSTANTIATE(long double)
+#undef NR_INSTANTIATE
+
+//hw9 bench [n] : n x n 난수 행렬에서 gaussj와 svdcmp 한 번의 시간을 잰다
+//둘 다 행렬을 제자리에서 바꾸므로 매번 복사본으로 풀고, 복사 시간(O(n^2))도 들어간다
+//bench/run.sh가 모으는 "BENCH 이름 값 단위" 꼴로 출력
+void bench(int n) {
+	Philox gen(9);
+	vector<float> ran((size_t)n * (n + 1));
+	gen.fillUniform(ran.data(), ran.size(), -1, 1);
+
+	//대각 우세로 만들어 gaussj가 특이 행렬을 만나지 않게 한다
+	Matrix<float> A(n, n), B(n, 1);
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) A[i][j] = ran[(size_t)i * n + j];
+		A[i][i] += n;
+		B[i][0] = ran[(size_t)n * n + i];
+	}
 
+	BenchResult r = benchmark([&]() {
+		Matrix<float> a = A, b = B;
+		gaussj(a, b, n, 1);
+		return b[0][0];
+	}, 1.0);
+	printf("BENCH gaussj_%d %.1f ns\n", n, r.median);
+
+	vector<float> w(n);
+	r = benchmark([&]() {
+		Matrix<float> a = A, v(n, n);
+		svdcmp(a, w.data(), v, n, n);
+		return w[0];
+	}, 1.0);
+	printf("BENCH svdcmp_%d %.1f ns\n", n, r.median);
+}
@@ -0,0 +1,338 @@
+﻿#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <limits>
+#include <vector>
+#include "matrix.h"
+#include "philox.h"
+
+// 최소제곱과 특이값 분해를 정규방정식 없이 푸는 도구
+// F^T F를 만들면 조건수가 제곱이 되므로, F의 행을 Givens 회전으로
+// 상삼각 R에 하나씩 흡수해 F = QR을 만들고 작은 R만 SVD한다.
+// SVD는 행끼리 직교화하는 one-sided Jacobi라서 행렬의 행을 연속으로 훑는다
+
+// 행렬 G(r x c)의 행들을 서로 직교하게 만든다 (one-sided Jacobi)
+// 끝나면 G의 i행은 s[i] * u_i, Vt의 i행은 v_i가 되어 G^T = U diag(s) V^T 이다
+// (G^T의 특이값 분해, u_i는 길이 c, v_i는 길이 r)
+// 내적은 double로 누적하고, 한 번 훑는 동안 회전이 없으면 끝낸다
+template <typename T>
+void jacobiSvdRows(Matrix<T> &G, int r, int c, T *s, Matrix<T> &Vt)
+{
+	const int MAX_SWEEPS = 60;
+	const double EPS = sizeof(T) == sizeof(float) ? 1e-7 : 1e-15;
+	int go = G.base(), vo = Vt.base();
+
+	for (int i = 0; i < r; i++)
+		for (int j = 0; j < r; j++) Vt[i + vo][j + vo] = i == j ? 1 : 0;
+
+	for (int sweep = 0; sweep < MAX_SWEEPS; sweep++) {
+		bool rotated = false;
+		for (int p = 0; p < r - 1; p++) {
+			for (int q = p + 1; q < r; q++) {
+				T *gp = G[p + go] + go, *gq = G[q + go] + go;
+				double alpha = 0, beta = 0, gamma = 0;
+				for (int j = 0; j < c; j++) {
+					alpha += (double)gp[j] * gp[j];
+					beta += (double)gq[j] * gq[j];
+					gamma += (double)gp[j] * gq[j];
+				}
+				if (gamma == 0 || fabs(gamma) <= EPS * sqrt(alpha * beta)) continue;
+				rotated = true;
+
+				double zeta = (beta - alpha) / (2 * gamma);
+				double t = (zeta >= 0 ? 1 : -1) / (fabs(zeta) + sqrt(1 + zeta * zeta));
+				T cs = (T)(1 / sqrt(1 + t * t)), sn = (T)(cs * t);
+				for (int j = 0; j < c; j++) {
+					T a = gp[j], b = gq[j];
+					gp[j] = cs * a - sn * b;
+					gq[j] = sn * a + cs * b;
+				}
+				T *vp = Vt[p + vo] + vo, *vq = Vt[q + vo] + vo;
+				for (int j = 0; j < r; j++) {
+					T a = vp[j], b = vq[j];
+					vp[j] = cs * a - sn * b;
+					vq[j] = sn * a + cs * b;
+				}
+			}
+		}
+		if (!rotated) break;
+	}
+
+	for (int i = 0; i < r; i++) {
+		T *g = G[i + go] + go;
+		double norm = 0;
+		for (int j = 0; j < c; j++) norm += (double)g[j] * g[j];
+		s[i] = (T)sqrt(norm);
+		if (s[i] != 0)
+			for (int j = 0; j < c; j++) g[j] /= s[i];
+	}
+}
+
+// 데이터 한 행 f(m개), y(k개)를 상삼각 R(m x m)과 Z = Q^T Y(m x k)에 흡수한다
+// (Givens 회전, 행 하나에 O(m(m + k)))
+// R, Z를 0으로 시작해 모든 행을 더하면 F = QR, Z는 Q^T Y의 위 m행이 된다
+// f, y는 회전의 작업 공간으로 쓰여 값이 바뀐다
+template <typename T>
+void qrAddRow(T *f, T *y, int m, int k, Matrix<T> &R, Matrix<T> &Z)
+{
+	int o = R.base();
+
+	for (int j = 0; j < m; j++) {
+		if (f[j] == 0) continue;
+		T *rj = R[j + o] + o, *zj = Z[j + o] + o;
+		T h = (T)sqrt((double)rj[j] * rj[j] + (double)f[j] * f[j]);
+		T c = rj[j] / h, s = f[j] / h;
+		rj[j] = h;
+		for (int l = j + 1; l < m; l++) {
+			T a = rj[l], b = f[l];
+			rj[l] = c * a + s * b;
+			f[l] = c * b - s * a;
+		}
+		for (int l = 0; l < k; l++) {
+			T a = zj[l], b = y[l];
+			zj[l] = c * a + s * b;
+			y[l] = c * b - s * a;
+		}
+	}
+}
+
+// A X = Z (A는 m x m)를 A의 SVD로 푼다
+// A = U diag(s) V^T 에서 X = V diag(1/s) U^T Z 이고,
+// 가장 큰 특이값의 rcond배보다 작은 특이값은 0으로 보아 버린다 (계수 부족 대비)
+// X는 A와 같은 base의 m x k 행렬
+template <typename T>
+Matrix<T> svdSolve(const Matrix<T> &R, const Matrix<T> &Z, int m, int k, double rcond = 1e-6)
+{
+	int o = R.base();
+	Matrix<T> G(m, m, o), Vt(m, m, o), X(m, k, o);
+	std::vector<T> s(m);
+	std::vector<double> uz(k);
+
+	// G = R^T 로 두면 G^T = R
+	for (int i = 0; i < m; i++)
+		for (int j = 0; j < m; j++) G[j + o][i + o] = R[i + o][j + o];
+	jacobiSvdRows(G, m, m, s.data(), Vt);
+
+	T smax = 0;
+	for (int i = 0; i < m; i++) if (s[i] > smax) smax = s[i];
+	for (int i = 0; i < m; i++) {
+		if (s[i] <= rcond * smax || s[i] == 0) continue;
+		// uz = u_i^T Z / s_i
+		const T *u = G[i + o] + o;
+		for (int l = 0; l < k; l++) uz[l] = 0;
+		for (int j = 0; j < m; j++) {
+			const T *zj = Z[j + o] + o;
+			for (int l = 0; l < k; l++) uz[l] += (double)u[j] * zj[l];
+		}
+		const T *v = Vt[i + o] + o;
+		for (int j = 0; j < m; j++) {
+			T *xj = X[j + o] + o;
+			for (int l = 0; l < k; l++) xj[l] += (T)(v[j] * uz[l] / s[i]);
+		}
+	}
+	return X;
+}
+
+// R X = Z (R은 m x m 상삼각)를 푼다
+// R의 대각 원소가 모두 가장 큰 것의 rcond배보다 크면 뒤에서부터 대입해 O(m^2 k)에 풀고,
+// 아니면 계수가 부족한 것으로 보아 svdSolve로 푼다
+// (R^T R = F^T F라서 R은 정규방정식의 Cholesky 인수와 같다)
+template <typename T>
+Matrix<T> lsqSolve(const Matrix<T> &R, const Matrix<T> &Z, int m, int k, double rcond = 1e-6)
+{
+	int o = R.base();
+	double rmax = 0;
+
+	for (int i = 0; i < m; i++) if (fabs(R[i + o][i + o]) > rmax) rmax = fabs(R[i + o][i + o]);
+	for (int i = 0; i < m; i++)
+		if (!(fabs(R[i + o][i + o]) > rcond * rmax)) return svdSolve(R, Z, m, k, rcond);
+
+	Matrix<T> X(m, k, o);
+	std::vector<double> sum(k);
+	for (int i = m - 1; i >= 0; i--) {
+		const T *ri = R[i + o] + o, *zi = Z[i + o] + o;
+		for (int l = 0; l < k; l++) sum[l] = zi[l];
+		for (int j = i + 1; j < m; j++) {
+			const T *xj = X[j + o] + o;
+			for (int l = 0; l < k; l++) sum[l] -= (double)ri[j] * xj[l];
+		}
+		T *xi = X[i + o] + o;
+		for (int l = 0; l < k; l++) xi[l] = (T)(sum[l] / ri[i]);
+	}
+	return X;
+}
+
+// 대칭 양의 정부호 A(m x m)를 A = L D L^T로 분해한다
+// L(대각의 1은 생략)은 A의 아래 삼각에, D는 d에 둔다. 대각과 위 삼각은 그대로 둔다
+// 피벗 d_i가 A의 가장 큰 대각 원소의 tol배 이하로 떨어지면 계수가 부족한 것으로 보고
+// false를 돌려준다. Cholesky와 달리 제곱근을 구하지 않는다
+template <typename T>
+bool ldlt(Matrix<T> &A, int m, T *d, double tol)
+{
+	int o = A.base();
+	std::vector<double> w(m);	// i행의 l_ij * d_j
+	double amax = 0;
+
+	for (int i = 0; i < m; i++) if (A[i + o][i + o] > amax) amax = A[i + o][i + o];
+	for (int i = 0; i < m; i++) {
+		T *ai = A[i + o] + o;
+		for (int j = 0; j < i; j++) {
+			const T *aj = A[j + o] + o;
+			double s = ai[j];
+			for (int p = 0; p < j; p++) s -= w[p] * aj[p];
+			w[j] = s;
+			ai[j] = (T)(s / d[j]);
+		}
+		double s = ai[i];
+		for (int p = 0; p < i; p++) s -= w[p] * ai[p];
+		if (!(s > tol * amax)) return false;
+		d[i] = (T)s;
+	}
+	return true;
+}
+
+// A X = B (A는 m x m 대칭 양의 정부호, B는 m x k)를 푼다
+// 정규방정식 F^T F a = F^T y처럼 A가 대칭 양의 정부호이면 LDL^T로 O(m^3 / 3)에 풀고,
+// 분해가 계수 부족을 알아내면 A의 SVD로 푼다. A의 위 삼각만 읽는다
+// rcond는 F에 대한 값이다 (A = F^T F의 특이값은 F의 특이값의 제곱)
+template <typename T>
+Matrix<T> spdSolve(const Matrix<T> &A, const Matrix<T> &B, int m, int k, double rcond = 1e-6)
+{
+	int o = A.base();
+	double tol = rcond * rcond;
+	Matrix<T> L(m, m, o), X(m, k, o);
+	std::vector<T> d(m);
+
+	//아래 삼각을 위 삼각에서 채워서 분해한다
+	for (int i = 0; i < m; i++)
+		for (int j = 0; j < m; j++) L[i + o][j + o] = j < i ? A[j + o][i + o] : A[i + o][j + o];
+	if (tol < m * std::numeric_limits<T>::epsilon()) tol = m * std::numeric_limits<T>::epsilon();
+	if (!ldlt(L, m, d.data(), tol)) {
+		mirrorUpper(L, m);
+		return svdSolve(L, B, m, k, rcond * rcond);
+	}
+
+	//L y = b, D z = y, L^T x = z
+	for (int i = 0; i < m; i++) {
+		const T *li = L[i + o] + o, *bi = B[i + o] + o;
+		T *xi = X[i + o] + o;
+		for (int l = 0; l < k; l++) xi[l] = bi[l];
+		for (int j = 0; j < i; j++) {
+			const T *xj = X[j + o] + o;
+			for (int l = 0; l < k; l++) xi[l] -= li[j] * xj[l];
+		}
+	}
+	for (int i = 0; i < m; i++)
+		for (int l = 0; l < k; l++) X[i + o][l + o] /= d[i];
+	for (int i = m - 1; i >= 0; i--) {
+		T *xi = X[i + o] + o;
+		for (int j = i + 1; j < m; j++) {
+			const T lji = L[j + o][i + o];
+			const T *xj = X[j + o] + o;
+			for (int l = 0; l < k; l++) xi[l] -= lji * xj[l];
+		}
+	}
+	return X;
+}
+
+// min ||F X - Y|| (F는 n x m, Y는 n x k)를 QR과 SVD로 푼다
+template <typename T>
+Matrix<T> lstsqQR(const Matrix<T> &F, const Matrix<T> &Y, int n, int m, int k)
+{
+	int o = F.base();
+	Matrix<T> R(m, m, o), Z(m, k, o);
+	std::vector<T> f(m), y(k);
+
+	for (int r = 0; r < n; r++) {
+		for (int j = 0; j < m; j++) f[j] = F[r + o][j + o];
+		for (int j = 0; j < k; j++) y[j] = Y[r + o][j + o];
+		qrAddRow(f.data(), y.data(), m, k, R, Z);
+	}
+	return lsqSolve(R, Z, m, k);
+}
+
+// Q(l x n)의 행들을 정규직교로 만든다 (수정 Gram-Schmidt를 두 번)
+template <typename T>
+void orthonormalRows(Matrix<T> &Q, int l, int n)
+{
+	int o = Q.base();
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < l; i++) {
+			T *qi = Q[i + o] + o;
+			for (int j = 0; j < i; j++) {
+				const T *qj = Q[j + o] + o;
+				double d = 0;
+				for (int c = 0; c < n; c++) d += (double)qi[c] * qj[c];
+				for (int c = 0; c < n; c++) qi[c] -= (T)d * qj[c];
+			}
+			double norm = 0;
+			for (int c = 0; c < n; c++) norm += (double)qi[c] * qi[c];
+			norm = sqrt(norm);
+			if (norm > 0)
+				for (int c = 0; c < n; c++) qi[c] = (T)(qi[c] / norm);
+		}
+	}
+}
+
+// A(n x m, base 0)의 큰 특이값 k개를 무작위 사영으로 구한다
+// (Halko, Martinsson, Tropp의 randomized range finder)
+// 가우스 난수 행렬로 A의 열 공간을 k + oversample 차원으로 잡고
+// power번 A A^T를 곱해 작은 특이값의 영향을 줄인 뒤, 그 공간에서 작은 SVD를 푼다.
+// 모든 행렬은 행 단위로 저장하므로 특이벡터도 행으로 돌려준다:
+// Ut(k x n)의 i행이 u_i, Vt(k x m)의 i행이 v_i, s는 큰 순서
+template <typename T>
+void randomizedSvd(const Matrix<T> &A, int n, int m, int k, Matrix<T> &Ut, T *s, Matrix<T> &Vt,
+	int oversample = 8, int power = 2, uint64_t seed = 1)
+{
+	int l = k + oversample;
+	if (l > m) l = m;
+	if (l > n) l = n;
+	if (k > l) k = l;
+
+	Matrix<T> At(m, n), Omega(l, m), Q(l, n), W(l, m);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++) At[j][i] = A[i][j];
+
+	std::vector<float> g((size_t)l * m);
+	Philox(seed).fillGaussian(g.data(), g.size(), 0, 1);
+	for (int i = 0; i < l; i++)
+		for (int j = 0; j < m; j++) Omega[i][j] = (T)g[(size_t)i * m + j];
+
+	// Q^T = (A Omega)^T = Omega^T A^T
+	gemm(Omega, At, Q, l, m, n);
+	orthonormalRows(Q, l, n);
+	for (int it = 0; it < power; it++) {
+		gemm(Q, A, W, l, n, m);
+		orthonormalRows(W, l, m);
+		gemm(W, At, Q, l, m, n);
+		orthonormalRows(Q, l, n);
+	}
+
+	// B = Q^T A (l x m)의 SVD: B^T = Ub S Vb^T 이므로 B = Vb S Ub^T
+	Matrix<T> B(l, m), Vb(l, l), UAt(l, n);
+	std::vector<T> sb(l);
+	gemm(Q, A, B, l, n, m);
+	jacobiSvdRows(B, l, m, sb.data(), Vb);
+	// A의 왼쪽 특이벡터 u_i = Q Vb의 i열 -> 행으로는 Vb의 i행 * Q^T
+	gemm(Vb, Q, UAt, l, l, n);
+
+	std::vector<int> order(l);
+	for (int i = 0; i < l; i++) order[i] = i;
+	for (int i = 0; i < l; i++)
+		for (int j = i + 1; j < l; j++)
+			if (sb[order[j]] > sb[order[i]]) {
+				int t = order[i];
+				order[i] = order[j];
+				order[j] = t;
+			}
+
+	Ut = Matrix<T>(k, n);
+	Vt = Matrix<T>(k, m);
+	for (int i = 0; i < k; i++) {
+		int p = order[i];
+		s[i] = sb[p];
+		for (int j = 0; j < n; j++) Ut[i][j] = UAt[p][j];
+		for (int j = 0; j < m; j++) Vt[i][j] = B[p][j];
+	}
+}
@@ -0,0 +1,51 @@
+﻿#pragma once
+#include <limits>
+
+// NR machar()가 실행 중에 반복문으로 알아내는 기계 상수를 컴파일 시간 상수로 둔다
+// std::numeric_limits에서 바로 얻으므로 시작할 때 드는 비용이 없고,
+// constexpr라서 허용 오차 같은 상수식에 그대로 쓸 수 있다
+//   const float TOL = 100 * Machar<float>::eps;
+// 각 값의 뜻은 machar()의 같은 이름의 출력과 같다 (hw1에서 둘을 비교한다)
+
+// 0..n-1을 나타내는 데 필요한 비트 수
+constexpr int macharBits(int n)
+{
+	return n <= 1 ? 0 : 1 + macharBits((n + 1) / 2);
+}
+
+template <typename T>
+struct Machar {
+	typedef std::numeric_limits<T> lim;
+	static_assert(lim::is_specialized && !lim::is_integer, "Machar needs a floating-point type");
+
+	static constexpr int ibeta = lim::radix;		// 기수
+	static constexpr int it = lim::digits;			// 가수의 자릿수 (기수 ibeta)
+	// 0: 버림, 2: IEEE 반올림, 3/5: 각각에 점진적 언더플로가 있을 때
+	static constexpr int irnd = (lim::round_style == std::round_to_nearest ? 2 : 0)
+		+ (lim::has_denorm == std::denorm_present ? 3 : 0);
+	static constexpr int ngrd = 0;					// 곱셈의 보호 자릿수
+	static constexpr int machep = 1 - it;			// eps = ibeta^machep
+	static constexpr int negep = -it;				// epsneg = ibeta^negep
+	static constexpr int minexp = lim::min_exponent - 1;	// xmin = ibeta^minexp
+	static constexpr int maxexp = lim::max_exponent;		// xmax < ibeta^maxexp
+	static constexpr int iexp = macharBits(maxexp - minexp + 1);	// 지수의 비트 수
+
+	static constexpr T eps = lim::epsilon();		// 1 + eps != 1인 가장 작은 ibeta의 거듭제곱
+	static constexpr T epsneg = lim::epsilon() / lim::radix;	// 1 - epsneg != 1
+	static constexpr T xmin = lim::min();			// 가장 작은 정규화 수
+	static constexpr T xmax = lim::max();			// 가장 큰 수
+};
+
+template <typename T> constexpr int Machar<T>::ibeta;
+template <typename T> constexpr int Machar<T>::it;
+template <typename T> constexpr int Machar<T>::irnd;
+template <typename T> constexpr int Machar<T>::ngrd;
+template <typename T> constexpr int Machar<T>::machep;
+template <typename T> constexpr int Machar<T>::negep;
+template <typename T> constexpr int Machar<T>::minexp;
+template <typename T> constexpr int Machar<T>::maxexp;
+template <typename T> constexpr int Machar<T>::iexp;
+template <typename T> constexpr T Machar<T>::eps;
+template <typename T> constexpr T Machar<T>::epsneg;
+template <typename T> constexpr T Machar<T>::xmin;
+template <typename T> constexpr T Machar<T>::xmax;
@@ -0,0 +1,169 @@
+﻿#pragma once
+#include <stddef.h>
+#include <vector>
+
+// 한 덩어리 버퍼에 행 우선(row-major)으로 저장하는 행렬
+// a[i][j]는 data()[i * stride() + j]라서 행마다 malloc하던 float**와
+// 같은 모양으로 쓰면서도 행 사이를 포인터로 건너뛰지 않는다
+// base = 1로 만들면 0행과 0열을 비워 두어 NR식 1-based 인덱스
+// (a[1][1] ~ a[n][m])를 그대로 쓸 수 있다
+template <typename T>
+class Matrix {
+public:
+	Matrix() : nrow(0), ncol(0), first(0), step(0) {}
+
+	// n x m 행렬, 0으로 초기화
+	Matrix(int n, int m, int base = 0)
+		: buf((size_t)(n + base) * (m + base), T()),
+		  nrow(n), ncol(m), first(base), step(m + base) {}
+
+	T *operator[](int i) { return &buf[(size_t)i * step]; }
+	const T *operator[](int i) const { return &buf[(size_t)i * step]; }
+
+	int rows() const { return nrow; }
+	int cols() const { return ncol; }
+	int base() const { return first; }
+	int stride() const { return step; }
+	T *data() { return buf.data(); }
+	const T *data() const { return buf.data(); }
+
+	void fill(T v) {
+		for (size_t i = 0; i < buf.size(); i++) buf[i] = v;
+	}
+
+private:
+	std::vector<T> buf;
+	int nrow, ncol;
+	int first;	// 첫 행/열의 인덱스 (0 또는 1)
+	int step;	// 한 행의 원소 수
+};
+
+// 캐시에 올려 두고 재사용할 블록의 크기 (원소 수)
+const int MATRIX_BLOCK = 64;
+
+// C = A * B (A는 n x k, B는 k x m, 셋 다 같은 base)
+// k와 j를 블록으로 나누어 B의 블록이 캐시에 남아 있는 동안 A의 모든 행에
+// 쓰고, 가장 안쪽 루프는 B와 C의 한 행을 연속으로 훑어서 컴파일러가
+// SIMD로 바꿀 수 있다. 각 원소는 p 순서대로 더해지므로 i-j-p 세 겹
+// 루프와 결과가 같다
+template <typename T>
+void gemm(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C, int n, int k, int m)
+{
+	int o = A.base();
+
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++) C[i + o][j + o] = 0;
+	for (int pp = 0; pp < k; pp += MATRIX_BLOCK) {
+		int pend = pp + MATRIX_BLOCK < k ? pp + MATRIX_BLOCK : k;
+		for (int jj = 0; jj < m; jj += MATRIX_BLOCK) {
+			int jend = jj + MATRIX_BLOCK < m ? jj + MATRIX_BLOCK : m;
+			for (int i = 0; i < n; i++) {
+				const T *a = A[i + o] + o;
+				T *c = C[i + o] + o;
+				for (int p = pp; p < pend; p++) {
+					const T aip = a[p];
+					const T *b = B[p + o] + o;
+					for (int j = jj; j < jend; j++) c[j] += aip * b[j];
+				}
+			}
+		}
+	}
+}
+
+// C -= A * B (A는 n x k, B는 k x m)
+// 각 행렬을 첫 원소의 포인터와 행 간격(ld)으로 받아서 부분 행렬에 바로 쓴다.
+// 블록을 나누는 방식은 gemm과 같다 (블록 LU의 나머지 갱신 등)
+template <typename T>
+void gemmSub(const T *a, int lda, const T *b, int ldb, T *c, int ldc, int n, int k, int m)
+{
+	for (int pp = 0; pp < k; pp += MATRIX_BLOCK) {
+		int pend = pp + MATRIX_BLOCK < k ? pp + MATRIX_BLOCK : k;
+		for (int jj = 0; jj < m; jj += MATRIX_BLOCK) {
+			int jend = jj + MATRIX_BLOCK < m ? jj + MATRIX_BLOCK : m;
+			for (int i = 0; i < n; i++) {
+				const T *ai = a + (size_t)i * lda;
+				T *ci = c + (size_t)i * ldc;
+				for (int p = pp; p < pend; p++) {
+					const T aip = ai[p];
+					const T *bp = b + (size_t)p * ldb;
+					for (int j = jj; j < jend; j++) ci[j] -= aip * bp[j];
+				}
+			}
+		}
+	}
+}
+
+// C = A^T * A (A는 n x m, C는 m x m)
+// A의 행을 한 번씩만 읽으면서 아래 삼각을 더하고 마지막에 위로 복사한다.
+// 열을 따라 내려가며 읽던 것과 달리 n이 커도 A를 한 번만 훑는다
+template <typename T>
+void syrk(const Matrix<T> &A, Matrix<T> &C, int n, int m)
+{
+	int o = A.base();
+
+	for (int i = 0; i < m; i++)
+		for (int j = 0; j < m; j++) C[i + o][j + o] = 0;
+	for (int r = 0; r < n; r++) {
+		const T *a = A[r + o] + o;
+		for (int i = 0; i < m; i++) {
+			const T ai = a[i];
+			T *c = C[i + o] + o;
+			for (int j = 0; j <= i; j++) c[j] += ai * a[j];
+		}
+	}
+	for (int i = 0; i < m; i++)
+		for (int j = i + 1; j < m; j++) C[i + o][j + o] = C[j + o][i + o];
+}
+
+// 데이터 한 행 f(m개), y(k개)를 정규방정식 F^T F a = F^T y의 양변에 더한다
+// FtF는 아래 삼각만 채우므로 다 더한 뒤 mirrorLower로 위를 채운다
+template <typename T>
+void addNormalRow(const T *f, const T *y, int m, int k, Matrix<T> &FtF, Matrix<T> &FtY)
+{
+	int o = FtF.base();
+
+	for (int i = 0; i < m; i++) {
+		const T fi = f[i];
+		T *c = FtF[i + o] + o;
+		T *d = FtY[i + o] + o;
+		for (int j = 0; j <= i; j++) c[j] += fi * f[j];
+		for (int j = 0; j < k; j++) d[j] += fi * y[j];
+	}
+}
+
+// m x m 행렬의 아래 삼각을 위 삼각으로 복사한다
+template <typename T>
+void mirrorLower(Matrix<T> &C, int m)
+{
+	int o = C.base();
+
+	for (int i = 0; i < m; i++)
+		for (int j = i + 1; j < m; j++) C[i + o][j + o] = C[j + o][i + o];
+}
+
+// m x m 행렬의 위 삼각을 아래 삼각으로 복사한다
+template <typename T>
+void mirrorUpper(Matrix<T> &C, int m)
+{
+	int o = C.base();
+
+	for (int i = 0; i < m; i++)
+		for (int j = i + 1; j < m; j++) C[j + o][i + o] = C[i + o][j + o];
+}
+
+// 최소제곱 정규방정식의 양변을 데이터를 한 번 훑으며 만든다
+// (F는 n x m, Y는 n x k, FtF는 m x m, FtY는 m x k)
+template <typename T>
+void normalEquations(const Matrix<T> &F, const Matrix<T> &Y, int n, int m, int k,
+	Matrix<T> &FtF, Matrix<T> &FtY)
+{
+	int o = F.base();
+
+	for (int i = 0; i < m; i++) {
+		for (int j = 0; j < m; j++) FtF[i + o][j + o] = 0;
+		for (int j = 0; j < k; j++) FtY[i + o][j + o] = 0;
+	}
+	for (int r = 0; r < n; r++)
+		addNormalRow(F[r + o] + o, Y[r + o] + o, m, k, FtF, FtY);
+	mirrorLower(FtF, m);
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// 카운터 기반 난수 생성기 Philox4x32-10
+// i번째 난수는 (seed, stream, i)만으로 정해지고 내부 상태가 없어서
+// 배열을 한꺼번에 채우거나 여러 스레드가 나누어 채워도 같은 수열이 나온다
+// stream을 다르게 주면 서로 겹치지 않는 수열을 얻는다
+class Philox {
+public:
+	Philox(uint64_t seed, uint32_t stream = 0)
+		: k0((uint32_t)seed), k1((uint32_t)(seed >> 32)), str(stream) {}
+
+	// ctr번째 블록의 32비트 난수 4개
+	void block(uint64_t ctr, uint32_t out[4]) const {
+		uint32_t c0 = (uint32_t)ctr, c1 = (uint32_t)(ctr >> 32), c2 = str, c3 = 0;
+		uint32_t key0 = k0, key1 = k1;
+
+		for (int r = 0; r < 10; r++) {
+			uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+			uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+			uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ key0;
+			uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ key1;
+			c1 = (uint32_t)p1;
+			c3 = (uint32_t)p0;
+			c0 = n0;
+			c2 = n2;
+			key0 += 0x9E3779B9u;
+			key1 += 0xBB67AE85u;
+		}
+		out[0] = c0;
+		out[1] = c1;
+		out[2] = c2;
+		out[3] = c3;
+	}
+
+	// out[0..n-1]에 first번째부터의 [lo, hi) 균등분포 난수를 채운다
+	void fillUniform(float *out, size_t n, float lo, float hi, uint64_t first = 0) const {
+		uint32_t u[4];
+		const float scale = (hi - lo) * (1.0f / 16777216.0f);
+
+		for (size_t i = 0; i < n; ) {
+			uint64_t idx = first + i;
+			block(idx / 4, u);
+			for (unsigned w = (unsigned)(idx % 4); w < 4 && i < n; w++, i++)
+				out[i] = lo + (float)(u[w] >> 8) * scale;
+		}
+	}
+
+	// out[0..n-1]에 first번째부터의 정규분포 난수를 채운다 (Box-Muller)
+	// 2j, 2j+1번째 수는 j번째 블록의 두 균등 난수로 만든다
+	void fillGaussian(float *out, size_t n, float mean, float sd, uint64_t first = 0) const {
+		uint32_t u[4];
+		const float TWO_PI = 6.28318530717958647692f;
+
+		for (size_t i = 0; i < n; ) {
+			uint64_t idx = first + i;
+			block(idx / 2, u);
+			// (0, 1]이라 log가 발산하지 않는다
+			float u1 = (float)((u[0] >> 8) + 1) * (1.0f / 16777216.0f);
+			float u2 = (float)(u[1] >> 8) * (1.0f / 16777216.0f);
+			float r = sd * sqrtf(-2.0f * logf(u1));
+			if (idx % 2 == 0) out[i++] = mean + r * cosf(TWO_PI * u2);
+			if (i < n) out[i++] = mean + r * sinf(TWO_PI * u2);
+		}
+	}
+
+private:
+	uint32_t k0, k1;
+	uint32_t str;
+};
+
+// fill을 threads개의 스레드에 나누어 out[0..n-1]을 채운다
+// 각 조각은 자기 시작 번호부터 채우므로 스레드 수와 상관없이 결과가 같다
+// fill(out + start, count, start)
+template <typename Fill>
+void parallelFill(float *out, size_t n, int threads, Fill fill)
+{
+	if (threads < 1) threads = 1;
+	if (n < (size_t)threads * 4096) threads = 1;
+
+	std::vector<std::thread> pool;
+	size_t chunk = ((n + threads - 1) / threads + 3) & ~(size_t)3;
+	for (int t = 1; t < threads; t++) {
+		size_t start = chunk * t;
+		if (start >= n) break;
+		size_t count = n - start < chunk ? n - start : chunk;
+		pool.push_back(std::thread(fill, out + start, count, (uint64_t)start));
+	}
+	fill(out, n < chunk ? n : chunk, (uint64_t)0);
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+}
@@ -0,0 +1,135 @@
+﻿#pragma once
+#include <setjmp.h>
+#include <stdio.h>
+#include <png.h>
+
+// PNG를 한 번에 다 풀지 않고 위에서부터 행 단위로 풀고 쓴다 (libpng)
+// 어떤 형식이든 8비트 3채널 BGR(OpenCV의 CV_8UC3와 같은 순서)로 바꿔서 읽고,
+// 같은 형식으로 쓴다. 메모리에는 부르는 쪽이 넘긴 행만 있다
+// libpng의 오류는 longjmp로 오므로 함수마다 setjmp로 받아 false를 돌려준다
+// 인터레이스 PNG는 마지막 패스까지 풀어야 한 행이 완성되므로 열지 않는다
+
+class PngRowReader {
+public:
+	PngRowReader() : fp(NULL), png(NULL), info(NULL), w(0), h(0) {}
+	~PngRowReader() { close(); }
+
+	bool open(const char *name) {
+		close();
+		if (!(fp = fopen(name, "rb"))) return false;
+		png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		if (png) info = png_create_info_struct(png);
+		if (!info) {
+			close();
+			return false;
+		}
+		if (setjmp(png_jmpbuf(png))) {
+			close();
+			return false;
+		}
+		png_init_io(png, fp);
+		png_read_info(png, info);
+		if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+			close();
+			return false;
+		}
+
+		int color = png_get_color_type(png, info);
+		png_set_strip_16(png);
+		png_set_strip_alpha(png);
+		png_set_packing(png);
+		if (color == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+		if (color == PNG_COLOR_TYPE_GRAY || color == PNG_COLOR_TYPE_GRAY_ALPHA) {
+			png_set_expand_gray_1_2_4_to_8(png);
+			png_set_gray_to_rgb(png);
+		}
+		png_set_bgr(png);
+		png_read_update_info(png, info);
+
+		w = (int)png_get_image_width(png, info);
+		h = (int)png_get_image_height(png, info);
+		return true;
+	}
+
+	// 다음 행을 row(cols() * 3바이트)에 푼다
+	bool readRow(unsigned char *row) {
+		if (!png) return false;
+		if (setjmp(png_jmpbuf(png))) return false;
+		png_read_row(png, row, NULL);
+		return true;
+	}
+
+	void close() {
+		if (png) png_destroy_read_struct(&png, info ? &info : NULL, NULL);
+		if (fp) fclose(fp);
+		fp = NULL;
+		png = NULL;
+		info = NULL;
+	}
+
+	int rows() const { return h; }
+	int cols() const { return w; }
+
+private:
+	FILE *fp;
+	png_structp png;
+	png_infop info;
+	int w, h;
+};
+
+class PngRowWriter {
+public:
+	PngRowWriter() : fp(NULL), png(NULL), info(NULL) {}
+	~PngRowWriter() { close(); }
+
+	// rows x cols 크기로 쓰기 시작한다. 행은 writeRow로 위에서부터 rows개를 넘긴다
+	bool open(const char *name, int rows, int cols) {
+		close();
+		if (!(fp = fopen(name, "wb"))) return false;
+		png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		if (png) info = png_create_info_struct(png);
+		if (!info) {
+			close();
+			return false;
+		}
+		if (setjmp(png_jmpbuf(png))) {
+			close();
+			return false;
+		}
+		png_init_io(png, fp);
+		png_set_IHDR(png, info, cols, rows, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+		png_write_info(png, info);
+		png_set_bgr(png);
+		return true;
+	}
+
+	bool writeRow(const unsigned char *row) {
+		if (!png) return false;
+		if (setjmp(png_jmpbuf(png))) return false;
+		png_write_row(png, row);
+		return true;
+	}
+
+	// 모든 행을 넘긴 뒤 부르면 파일을 마무리한다
+	bool finish() {
+		if (!png) return false;
+		if (setjmp(png_jmpbuf(png))) return false;
+		png_write_end(png, NULL);
+		close();
+		return true;
+	}
+
+	void close() {
+		if (png) png_destroy_write_struct(&png, info ? &info : NULL);
+		if (fp) fclose(fp);
+		fp = NULL;
+		png = NULL;
+		info = NULL;
+	}
+
+private:
+	FILE *fp;
+	png_structp png;
+	png_infop info;
+};
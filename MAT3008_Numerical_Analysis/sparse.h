@@ -0,0 +1,363 @@
+﻿#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "matrix.h"
+
+// 0이 아닌 원소만 행 단위로 저장하는 CSR 행렬과 반복법 풀이
+// 격자를 이산화한 연립방정식은 한 행에 원소가 몇 개뿐이지만 Matrix<T>로는
+// n^2개를 할당해야 해서 n = 10^6이면 만들 수조차 없다.
+// CSR은 nnz개의 값과 열 번호, n + 1개의 행 시작 위치만 둔다
+// 인덱스는 0부터 시작한다
+
+template <typename T>
+class CsrMatrix {
+public:
+	CsrMatrix() : nrow(0), ncol(0) { start.push_back(0); }
+
+	// n x m 행렬, 0이 아닌 원소 nnz개를 미리 잡아 둔다
+	// add로 한 행의 원소를 넣고 endRow로 행을 닫기를 n번 한다
+	CsrMatrix(int n, int m, size_t nnz = 0) : nrow(n), ncol(m) {
+		start.reserve((size_t)n + 1);
+		start.push_back(0);
+		col.reserve(nnz);
+		val.reserve(nnz);
+	}
+
+	// 지금 행에 (j, v)를 넣는다
+	void add(int j, T v) {
+		col.push_back(j);
+		val.push_back(v);
+	}
+
+	// 지금 행을 닫는다. 행 안의 원소는 열 순서로 정렬한다
+	void endRow() {
+		size_t s = start.back(), e = col.size();
+		for (size_t k = s + 1; k < e; k++) {
+			int c = col[k];
+			T v = val[k];
+			size_t p = k;
+			for (; p > s && col[p - 1] > c; p--) {
+				col[p] = col[p - 1];
+				val[p] = val[p - 1];
+			}
+			col[p] = c;
+			val[p] = v;
+		}
+		start.push_back(e);
+	}
+
+	int rows() const { return nrow; }
+	int cols() const { return ncol; }
+	size_t nnz() const { return col.size(); }
+	const size_t *rowPtr() const { return start.data(); }
+	const int *colIdx() const { return col.data(); }
+	T *values() { return val.data(); }
+	const T *values() const { return val.data(); }
+
+private:
+	std::vector<size_t> start;	// i행은 [start[i], start[i + 1])
+	std::vector<int> col;
+	std::vector<T> val;
+	int nrow, ncol;
+};
+
+// 밀집 행렬 A(n x m)의 0이 아닌 원소를 CSR로 옮긴다
+template <typename T>
+CsrMatrix<T> toCsr(const Matrix<T> &A, int n, int m)
+{
+	int o = A.base();
+	CsrMatrix<T> S(n, m);
+
+	for (int i = 0; i < n; i++) {
+		const T *a = A[i + o] + o;
+		for (int j = 0; j < m; j++)
+			if (a[j] != 0) S.add(j, a[j]);
+		S.endRow();
+	}
+	return S;
+}
+
+// 이보다 원소가 적으면 스레드를 만드는 비용이 더 커서 혼자 한다
+const size_t SPARSE_PARALLEL_MIN = 1 << 16;
+
+// A의 행을 [r0, r1) 구간으로 나누어 fn(r0, r1)을 여러 스레드로 부른다
+// 행마다 원소 수가 달라도 스레드마다 nnz가 비슷하도록 rowPtr에서 경계를 찾는다
+template <typename T, typename Fn>
+void sparseRows(const CsrMatrix<T> &A, Fn fn)
+{
+	int n = A.rows();
+	int threads = (int)std::thread::hardware_concurrency();
+	const size_t *p = A.rowPtr();
+
+	if (threads < 1 || A.nnz() < SPARSE_PARALLEL_MIN) threads = 1;
+	if (threads > n) threads = n > 0 ? n : 1;
+
+	std::vector<std::thread> pool;
+	int r0 = 0;
+	for (int t = 1; t < threads; t++) {
+		size_t target = A.nnz() / threads * t;
+		int r1 = (int)(std::lower_bound(p + r0, p + n, target) - p);
+		if (r1 <= r0) continue;
+		pool.push_back(std::thread(fn, r0, r1));
+		r0 = r1;
+	}
+	fn(r0, n);
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+}
+
+// y = A x
+template <typename T>
+void spmv(const CsrMatrix<T> &A, const T *x, T *y)
+{
+	const size_t *p = A.rowPtr();
+	const int *c = A.colIdx();
+	const T *v = A.values();
+
+	sparseRows(A, [=](int r0, int r1) {
+		for (int i = r0; i < r1; i++) {
+			T s = 0;
+			for (size_t k = p[i]; k < p[i + 1]; k++) s += v[k] * x[c[k]];
+			y[i] = s;
+		}
+	});
+}
+
+// r = b - A x
+// mprove처럼 한 행의 합을 long double로 더해서 A x와 b가 거의 같아도
+// 잔차가 반올림 오차에 묻히지 않는다
+template <typename T>
+void spResidual(const CsrMatrix<T> &A, const T *x, const T *b, T *r)
+{
+	const size_t *p = A.rowPtr();
+	const int *c = A.colIdx();
+	const T *v = A.values();
+
+	sparseRows(A, [=](int r0, int r1) {
+		for (int i = r0; i < r1; i++) {
+			long double sdp = b[i];
+			for (size_t k = p[i]; k < p[i + 1]; k++)
+				sdp -= (long double)v[k] * (long double)x[c[k]];
+			r[i] = (T)sdp;
+		}
+	});
+}
+
+template <typename T>
+double spDot(const T *a, const T *b, int n)
+{
+	double s = 0;
+	for (int i = 0; i < n; i++) s += (double)a[i] * b[i];
+	return s;
+}
+
+// 전처리: apply(r, z)로 z = M^-1 r을 구한다
+
+// 대각 원소로 나눈다 (Jacobi)
+template <typename T>
+struct JacobiPrecond {
+	std::vector<T> inv;	// 대각 원소의 역수
+
+	explicit JacobiPrecond(const CsrMatrix<T> &A) : inv(A.rows(), (T)1) {
+		const size_t *p = A.rowPtr();
+		const int *c = A.colIdx();
+		const T *v = A.values();
+		for (int i = 0; i < A.rows(); i++)
+			for (size_t k = p[i]; k < p[i + 1]; k++)
+				if (c[k] == i && v[k] != 0) inv[i] = 1 / v[k];
+	}
+
+	void apply(const T *r, T *z) const {
+		for (size_t i = 0; i < inv.size(); i++) z[i] = inv[i] * r[i];
+	}
+};
+
+// 불완전 LU 분해 ILU(0)
+// A에 0이 아닌 원소가 있는 자리에만 L(대각의 1은 생략)과 U를 두므로
+// 채움(fill-in)이 없고 메모리는 A와 같다. 피벗팅은 하지 않는다
+template <typename T>
+struct Ilu0Precond {
+	CsrMatrix<T> lu;
+	std::vector<size_t> diag;	// i행의 대각 원소 위치
+
+	explicit Ilu0Precond(const CsrMatrix<T> &A) : diag(A.rows()) {
+		const T TINY = (T)1.0e-20;
+		const size_t NONE = (size_t)-1;
+		int n = A.rows();
+
+		//대각 원소가 없는 행은 0을 넣어 자리를 만든다
+		const size_t *ap = A.rowPtr();
+		const int *ac = A.colIdx();
+		const T *av = A.values();
+		lu = CsrMatrix<T>(n, A.cols(), A.nnz() + n);
+		for (int i = 0; i < n; i++) {
+			bool has = false;
+			for (size_t k = ap[i]; k < ap[i + 1]; k++) {
+				lu.add(ac[k], av[k]);
+				if (ac[k] == i) has = true;
+			}
+			if (!has) lu.add(i, 0);
+			lu.endRow();
+		}
+
+		const size_t *p = lu.rowPtr();
+		const int *c = lu.colIdx();
+		T *v = lu.values();
+		std::vector<size_t> where(A.cols(), NONE);
+		for (int i = 0; i < n; i++) {
+			for (size_t k = p[i]; k < p[i + 1]; k++) {
+				where[c[k]] = k;
+				if (c[k] == i) diag[i] = k;
+			}
+			//l_ik = a_ik / u_kk, 그리고 i행에 자리가 있는 곳만 a_ij -= l_ik * u_kj
+			for (size_t kk = p[i]; kk < diag[i]; kk++) {
+				int k = c[kk];
+				T lik = (v[kk] /= v[diag[k]]);
+				for (size_t jj = diag[k] + 1; jj < p[k + 1]; jj++)
+					if (where[c[jj]] != NONE) v[where[c[jj]]] -= lik * v[jj];
+			}
+			if (v[diag[i]] == 0) {
+				printf("Zero pivot in Ilu0Precond at row %d\n", i);
+				v[diag[i]] = TINY;
+			}
+			for (size_t k = p[i]; k < p[i + 1]; k++) where[c[k]] = NONE;
+		}
+	}
+
+	//L z = r, U z = z를 차례로 푼다
+	void apply(const T *r, T *z) const {
+		const size_t *p = lu.rowPtr();
+		const int *c = lu.colIdx();
+		const T *v = lu.values();
+		int n = lu.rows();
+
+		for (int i = 0; i < n; i++) {
+			T sum = r[i];
+			for (size_t k = p[i]; k < diag[i]; k++) sum -= v[k] * z[c[k]];
+			z[i] = sum;
+		}
+		for (int i = n - 1; i >= 0; i--) {
+			T sum = z[i];
+			for (size_t k = diag[i] + 1; k < p[i + 1]; k++) sum -= v[k] * z[c[k]];
+			z[i] = sum / v[diag[i]];
+		}
+	}
+};
+
+// 점화식으로 갱신한 잔차는 반올림 오차가 쌓여 실제 잔차 b - A x와 멀어질 수 있다
+// 갱신한 잔차가 허용 오차 안에 들면 spResidual로 실제 잔차를 다시 구해 확인하고,
+// 아직 멀면 그 잔차로 처음부터 다시 시작한다
+
+// 전처리한 켤레 기울기법 (A는 대칭 양의 정부호)
+// x에 초기 추정값을 넣어 주면 해로 바꾼다
+// ||b - A x|| <= tol * ||b||가 되면 멈추고 반복 횟수를, 못 하면 max_iter를 돌려준다
+template <typename T, typename P>
+int cg(const CsrMatrix<T> &A, const T *b, T *x, const P &M, double tol, int max_iter)
+{
+	int n = A.rows();
+	std::vector<T> r(n), z(n), p(n), q(n);
+	double bnorm = sqrt(spDot(b, b, n)), rz = 0;
+	bool restart = true;
+
+	if (bnorm == 0) bnorm = 1;
+	spResidual(A, x, b, r.data());
+	if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) return 0;
+
+	for (int it = 0; it < max_iter; it++) {
+		if (restart) {
+			M.apply(r.data(), z.data());
+			rz = spDot(r.data(), z.data(), n);
+			for (int i = 0; i < n; i++) p[i] = z[i];
+			restart = false;
+		}
+
+		spmv(A, p.data(), q.data());
+		double pq = spDot(p.data(), q.data(), n);
+		if (pq == 0) break;
+		T alpha = (T)(rz / pq);
+		for (int i = 0; i < n; i++) {
+			x[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+
+		if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) {
+			spResidual(A, x, b, r.data());
+			if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) return it + 1;
+			restart = true;
+			continue;
+		}
+
+		M.apply(r.data(), z.data());
+		double rz_new = spDot(r.data(), z.data(), n);
+		T beta = (T)(rz_new / rz);
+		rz = rz_new;
+		for (int i = 0; i < n; i++) p[i] = z[i] + beta * p[i];
+	}
+	return max_iter;
+}
+
+// 오른쪽 전처리한 BiCGSTAB (A가 대칭이 아니어도 된다)
+// 인자와 돌려주는 값은 cg와 같다
+template <typename T, typename P>
+int bicgstab(const CsrMatrix<T> &A, const T *b, T *x, const P &M, double tol, int max_iter)
+{
+	int n = A.rows();
+	std::vector<T> r(n), rhat(n), p(n), v(n), ph(n), s(n), sh(n), t(n);
+	double bnorm = sqrt(spDot(b, b, n)), rho = 1, alpha = 1, omega = 1;
+	bool restart = true;
+
+	if (bnorm == 0) bnorm = 1;
+	spResidual(A, x, b, r.data());
+	if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) return 0;
+
+	for (int it = 0; it < max_iter; it++) {
+		if (restart) {
+			for (int i = 0; i < n; i++) rhat[i] = p[i] = r[i];
+			rho = spDot(rhat.data(), r.data(), n);
+			restart = false;
+		} else {
+			double rho_new = spDot(rhat.data(), r.data(), n);
+			if (rho_new == 0) break;
+			T beta = (T)((rho_new / rho) * (alpha / omega));
+			rho = rho_new;
+			for (int i = 0; i < n; i++) p[i] = r[i] + beta * (p[i] - (T)omega * v[i]);
+		}
+
+		M.apply(p.data(), ph.data());
+		spmv(A, ph.data(), v.data());
+		double rv = spDot(rhat.data(), v.data(), n);
+		if (rv == 0) break;
+		alpha = rho / rv;
+		for (int i = 0; i < n; i++) s[i] = r[i] - (T)alpha * v[i];
+
+		if (sqrt(spDot(s.data(), s.data(), n)) <= tol * bnorm) {
+			for (int i = 0; i < n; i++) x[i] += (T)alpha * ph[i];
+			spResidual(A, x, b, r.data());
+			if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) return it + 1;
+			restart = true;
+			continue;
+		}
+
+		M.apply(s.data(), sh.data());
+		spmv(A, sh.data(), t.data());
+		double tt = spDot(t.data(), t.data(), n);
+		omega = tt == 0 ? 0 : spDot(t.data(), s.data(), n) / tt;
+		for (int i = 0; i < n; i++) {
+			x[i] += (T)alpha * ph[i] + (T)omega * sh[i];
+			r[i] = s[i] - (T)omega * t[i];
+		}
+
+		if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) {
+			spResidual(A, x, b, r.data());
+			if (sqrt(spDot(r.data(), r.data(), n)) <= tol * bnorm) return it + 1;
+			restart = true;
+			continue;
+		}
+		//omega가 0이면 다음 방향을 만들 수 없으므로 지금 잔차로 다시 시작한다
+		if (omega == 0) restart = true;
+	}
+	return max_iter;
+}
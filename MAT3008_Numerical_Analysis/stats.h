@@ -0,0 +1,234 @@
+﻿#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// 표본을 저장하지 않고 흘려 보내면서 요약 통계만 모은다
+// 평균/분산, 고정 구간 히스토그램, 분위수 스케치는 모두 merge가 있어서
+// 스레드마다 따로 모은 뒤 마지막에 합칠 수 있다
+
+// 개수, 평균, 분산, 최솟값, 최댓값
+// 블록 하나는 두 번 훑어 평균과 편차 제곱합을 구하고(안쪽 루프가 SIMD로 바뀐다)
+// 누적값과는 Chan의 병합 공식으로 합친다. 한 개씩 더하면 Welford와 같다
+class Moments {
+public:
+	Moments() : n(0), mu(0), m2(0), lo(INFINITY), hi(-INFINITY) {}
+
+	void add(double x) {
+		n++;
+		double d = x - mu;
+		mu += d / n;
+		m2 += d * (x - mu);
+		if (x < lo) lo = x;
+		if (x > hi) hi = x;
+	}
+
+	void add(const float *x, size_t count) {
+		if (count == 0) return;
+		double s = 0, ss = 0;
+		float bl = x[0], bh = x[0];
+		for (size_t i = 0; i < count; i++) s += x[i];
+		double bm = s / count;
+		for (size_t i = 0; i < count; i++) {
+			double d = x[i] - bm;
+			ss += d * d;
+		}
+		for (size_t i = 0; i < count; i++) {
+			bl = x[i] < bl ? x[i] : bl;
+			bh = x[i] > bh ? x[i] : bh;
+		}
+		combine(count, bm, ss, bl, bh);
+	}
+
+	void merge(const Moments &o) {
+		if (o.n) combine(o.n, o.mu, o.m2, o.lo, o.hi);
+	}
+
+	uint64_t count() const { return n; }
+	double mean() const { return mu; }
+	double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+	double min() const { return lo; }
+	double max() const { return hi; }
+
+private:
+	void combine(uint64_t nb, double mb, double m2b, double lb, double hb) {
+		uint64_t na = n;
+		n += nb;
+		double d = mb - mu;
+		mu += d * nb / n;
+		m2 += m2b + d * d * ((double)na * nb / n);
+		if (lb < lo) lo = lb;
+		if (hb > hi) hi = hb;
+	}
+
+	uint64_t n;
+	double mu, m2;
+	double lo, hi;
+};
+
+// [lo, hi)를 bins개의 같은 폭 구간으로 나눈 히스토그램
+// 범위를 벗어난 표본은 under, over에 센다
+class Histogram {
+public:
+	Histogram() : lo(0), hi(0), scale(0), under(0), over(0) {}
+	Histogram(double lo_, double hi_, int bins)
+		: lo(lo_), hi(hi_), scale(bins / (hi_ - lo_)), counts(bins, 0), under(0), over(0) {}
+
+	void add(double x) {
+		if (x < lo) under++;
+		else if (x >= hi) over++;
+		else {
+			size_t b = (size_t)((x - lo) * scale);
+			counts[b < counts.size() ? b : counts.size() - 1]++;
+		}
+	}
+
+	void add(const float *x, size_t count) {
+		for (size_t i = 0; i < count; i++) add(x[i]);
+	}
+
+	// 구간이 같은 히스토그램만 합칠 수 있다
+	void merge(const Histogram &o) {
+		for (size_t b = 0; b < counts.size(); b++) counts[b] += o.counts[b];
+		under += o.under;
+		over += o.over;
+	}
+
+	int bins() const { return (int)counts.size(); }
+	double edge(int b) const { return lo + (hi - lo) * b / counts.size(); }
+	uint64_t operator[](int b) const { return counts[b]; }
+	uint64_t below() const { return under; }
+	uint64_t above() const { return over; }
+
+private:
+	double lo, hi, scale;
+	std::vector<uint64_t> counts;
+	uint64_t under, over;
+};
+
+// 분위수 스케치 (로그-선형 히스토그램)
+// float의 부호와 지수, 가수의 앞 MBITS비트로 구간을 정해 센다. 구간의 폭이
+// 값에 비례하므로 돌려주는 분위수의 상대 오차는 2^-(MBITS+1) 이내이고
+// 범위를 미리 정하지 않아도 된다. 같은 지수의 구간들은 처음 쓰일 때 만든다
+// 구간 번호가 같으면 같은 곳에 세므로 merge는 정확하고 스레드 수와 상관없다
+class QuantileSketch {
+public:
+	static const int MBITS = 10;
+
+	QuantileSketch() : n(0), blocks(512) {}
+
+	void add(float x) {
+		if (x != x) return;	// NaN
+		uint32_t key = orderKey(x) >> (23 - MBITS);
+		std::vector<uint64_t> &blk = blocks[key >> MBITS];
+		if (blk.empty()) blk.resize((size_t)1 << MBITS);
+		blk[key & (((uint32_t)1 << MBITS) - 1)]++;
+		n++;
+	}
+
+	void add(const float *x, size_t count) {
+		for (size_t i = 0; i < count; i++) add(x[i]);
+	}
+
+	void merge(const QuantileSketch &o) {
+		for (size_t e = 0; e < blocks.size(); e++) {
+			if (o.blocks[e].empty()) continue;
+			if (blocks[e].empty()) blocks[e].resize(o.blocks[e].size());
+			for (size_t i = 0; i < o.blocks[e].size(); i++) blocks[e][i] += o.blocks[e][i];
+		}
+		n += o.n;
+	}
+
+	// 0 <= q <= 1인 q 분위수 (해당 구간의 가운데 값)
+	double quantile(double q) const {
+		if (n == 0) return NAN;
+		double target = q * n;
+		uint64_t acc = 0;
+		uint32_t last = 0;
+		for (size_t e = 0; e < blocks.size(); e++)
+			for (size_t i = 0; i < blocks[e].size(); i++) {
+				if (blocks[e][i] == 0) continue;
+				last = (uint32_t)(e << MBITS | i);
+				acc += blocks[e][i];
+				if (acc >= target) return center(last);
+			}
+		return center(last);
+	}
+
+	uint64_t count() const { return n; }
+
+private:
+	// 값의 크기 순서와 같은 순서가 되도록 float의 비트를 바꾼다
+	static uint32_t orderKey(float x) {
+		uint32_t u;
+		memcpy(&u, &x, sizeof(u));
+		return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+	}
+
+	static double center(uint32_t key) {
+		uint32_t u = key << (23 - MBITS) | (uint32_t)1 << (22 - MBITS);
+		u = (u & 0x80000000u) ? (u & 0x7fffffffu) : ~u;
+		float x;
+		memcpy(&x, &u, sizeof(x));
+		return x;
+	}
+
+	uint64_t n;
+	std::vector<std::vector<uint64_t> > blocks;	// [부호와 지수][가수 앞 MBITS비트]
+};
+
+// 평균/분산, 히스토그램, 분위수를 함께 모은다
+struct StreamStats {
+	Moments moments;
+	Histogram hist;
+	QuantileSketch sketch;
+
+	StreamStats() {}
+	StreamStats(double lo, double hi, int bins) : hist(lo, hi, bins) {}
+
+	void add(const float *x, size_t count) {
+		moments.add(x, count);
+		hist.add(x, count);
+		sketch.add(x, count);
+	}
+
+	void merge(const StreamStats &o) {
+		moments.merge(o.moments);
+		hist.merge(o.hist);
+		sketch.merge(o.sketch);
+	}
+};
+
+// n개의 표본을 threads개의 스레드가 나누어 만들면서 바로 요약한다
+// 스레드마다 BLOCK개씩 fill(buf, count, first)로 first번째부터의 표본을 받아
+// 자기 StreamStats에 더하고, 끝나면 스레드 순서대로 합친다
+// 표본 전체를 메모리에 두지 않으므로 n이 10^9이어도 된다
+template <typename Fill>
+StreamStats parallelStats(uint64_t n, int threads, double lo, double hi, int bins, Fill fill)
+{
+	const size_t BLOCK = 65536;
+	if (threads < 1) threads = 1;
+	if (n < (uint64_t)threads * BLOCK) threads = 1;
+
+	std::vector<StreamStats> part(threads, StreamStats(lo, hi, bins));
+	uint64_t chunk = (n + threads - 1) / threads;
+	auto work = [&](int t) {
+		std::vector<float> buf(BLOCK);
+		uint64_t end = chunk * (t + 1) < n ? chunk * (t + 1) : n;
+		for (uint64_t i = chunk * t; i < end; i += BLOCK) {
+			size_t count = end - i < BLOCK ? (size_t)(end - i) : BLOCK;
+			fill(buf.data(), count, i);
+			part[t].add(buf.data(), count);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++) pool.push_back(std::thread(work, t));
+	work(0);
+	for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+	for (int t = 1; t < threads; t++) part[0].merge(part[t]);
+	return part[0];
+}
@@ -0,0 +1,10 @@
+* TM dispatch benchmark: count r0 down from 10000000,
+* storing and reloading it every time around the loop
+* 4 instructions per iteration, 40000003 in all
+  0:    LDC  0,10000000(0)   r0 = iterations
+  1:    LDC  1,1(0)          r1 = 1
+  2:    SUB  0,0,1           r0--
+  3:     ST  0,1(6)          dMem[1] = r0
+  4:     LD  2,1(6)          r2 = dMem[1]
+  5:    JGT  0,-4(7)         loop while r0 > 0
+  6:   HALT  0,0,0
@@ -0,0 +1,235 @@
+#!/bin/sh
+#
+# run.sh - run the benchmarks built by the Makefile, keep a history and
+# catch regressions
+#
+# usage : run.sh [-b build dir] [-o history file] [-n runs] [-t threshold %]
+#   -b  where the Makefile put the binaries (default build)
+#   -o  JSON lines history, one line per run (default history.jsonl)
+#   -n  compare with the median of the last n runs on this host (default 5)
+#   -t  a result this many percent worse than that median is a regression
+#       (default 10)
+#
+# Every benchmark prints lines of the form
+#
+#     BENCH <name> <value> <unit>
+#
+# A unit ending in "/s" is a rate (higher is better), anything else is a
+# time or a size (lower is better). A benchmark whose binary is missing is
+# recorded as skipped with the reason.
+#
+# The run is appended to the history as
+#
+#     {"date":"...","commit":"...","host":"...","results":{"<name>":{"value":v,"unit":"u"},...},"skipped":[...]}
+#
+# and the exit status is 1 if any result regressed, so `make -C bench run`
+# can gate a merge. Only runs from the same host are compared: the numbers
+# of different machines mean nothing to each other.
+
+here=$(cd "$(dirname "$0")" && pwd)
+build=build
+history=history.jsonl
+runs=5
+threshold=10
+
+while getopts b:o:n:t: opt; do
+	case $opt in
+	b) build=$OPTARG ;;
+	o) history=$OPTARG ;;
+	n) runs=$OPTARG ;;
+	t) threshold=$OPTARG ;;
+	*) sed -n '5,11p' "$0" >&2; exit 2 ;;
+	esac
+done
+
+results=$build/results.txt
+skipped=$build/skipped.txt
+: > "$results"
+: > "$skipped"
+
+skip() {
+	echo "skip $1: $2" >&2
+	echo "$1" >> "$skipped"
+}
+
+# keep the BENCH lines of a benchmark's output
+collect() {
+	awk '$1 == "BENCH" && NF == 4 { print $2, $3, $4 }' | tee -a "$results"
+}
+
+now_ns() {
+	date +%s%N
+}
+
+# median of the numbers on stdin
+median() {
+	sort -g | awk '{ v[NR] = $1 } END { if (NR) print v[int((NR + 1) / 2)] }'
+}
+
+# database layer: buffer hit/miss, lock acquire/release, log append
+if [ -x "$build/db/microbench" ]; then
+	(cd "$build" && ./db/microbench -f microbench.db) | collect
+else
+	skip db "microbench was not built"
+fi
+
+# mm_malloc/mm_free: a trace of 1000 blocks freed and allocated again
+# 100 times, sizes mostly small with a tail up to 4KB, replayed on mm and libc
+if [ -x "$build/mm_bench" ]; then
+	awk 'BEGIN {
+		srand(1); ids = 1000; rounds = 100
+		print 20000000; print ids; print ids * (2 * rounds + 2); print 1
+		for (i = 0; i < ids; i++) {
+			size[i] = rand() < 0.9 ? 16 + int(rand() * 240) : 256 + int(rand() * 3840)
+			print "a", i, size[i]
+		}
+		for (r = 0; r < rounds; r++)
+			for (i = 0; i < ids; i++) { print "f", i; print "a", i, size[(i + r) % ids] }
+		for (i = 0; i < ids; i++) print "f", i
+	}' > "$build/mm_pairs.rep"
+	"$build/mm_bench" -r 5 -l "$build/mm_pairs.rep" |
+		awk -F, '$1 ~ /mm_pairs/ && ($2 == "mm" || $2 == "libc") && $5 > 0 {
+			printf "BENCH %s_malloc_free %.2f ns\n", $2, 1e9 / $5 }' | collect
+else
+	skip mm "mm_bench needs memlib.c, memlib.h and mm.h from the handout in MMDIR"
+fi
+
+# TM dispatch: 40M instructions of loop.tm through stepTM (s), the
+# direct-threaded runTM (g) and the native code (j g), less the time to
+# load the program and quit; the median of 3 runs each
+tm_ns() {
+	for i in 1 2 3; do
+		t0=$(now_ns)
+		printf "$1q\n" | "$build/tm" "$here/loop.tm" > "$build/tm.out"
+		t1=$(now_ns)
+		echo $((t1 - t0))
+	done | median
+}
+if [ -x "$build/tm" ]; then
+	instrs=40000003
+	base=$(tm_ns "")
+	for mode in "step:s $instrs\n" "run:g\n" "jit:j\ng\n"; do
+		name=${mode%%:*}
+		ns=$(tm_ns "${mode#*:}")
+		if grep -q "No native code" "$build/tm.out"; then
+			skip tm_jit "no native code on this machine"
+			continue
+		fi
+		awk -v n="$name" -v ns="$ns" -v base="$base" -v i="$instrs" \
+			'BEGIN { printf "BENCH tm_%s %.3f ns\n", n, (ns - base) / i }' | collect
+	done
+else
+	skip tm "tm was not built"
+fi
+
+# scanner: the C-Minus tests repeated to about 5MB, tokens per second of
+# the scan phase from -ftime-report
+if [ -x "$build/scanner/cminus_cimpl" ]; then
+	src=$build/scanner/test.1.txt
+	i=0
+	: > "$build/scan.cm"
+	while [ $i -lt 10000 ]; do
+		cat "$src"
+		i=$((i + 1))
+	done >> "$build/scan.cm"
+	for i in 1 2 3; do
+		"$build/scanner/cminus_cimpl" -ftime-report "$build/scan.cm" |
+			awk '$1 == "scan" { wall = $2 } $1 == "tokens:" { tok = $2 }
+				END { if (wall > 0) printf "%.0f\n", tok / wall }'
+	done | median | awk '{ print "BENCH scan_tokens", $1, "tokens/s" }' | collect
+else
+	skip scanner "cminus_cimpl was not built"
+fi
+
+# numerical kernels
+if [ -x "$build/hw9" ]; then
+	"$build/hw9" bench 64 | collect
+else
+	skip gaussj_svdcmp "hw9 was not built"
+fi
+if [ -x "$build/hw8" ]; then
+	"$build/hw8" bench 1600 1200 | collect
+else
+	skip bilinear "hw8 needs OpenCV 4 (pkg-config opencv4)"
+fi
+
+# List, UnrolledList and MyContainer
+if [ -x "$build/containers" ]; then
+	"$build/containers" | collect
+else
+	skip containers "containers was not built"
+fi
+
+if [ ! -s "$results" ]; then
+	echo "no results" >&2
+	exit 1
+fi
+
+date=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+commit=$(cd "$here" && git rev-parse --short HEAD 2>/dev/null || echo unknown)
+if [ "$commit" != unknown ] && ! (cd "$here" && git diff --quiet HEAD 2>/dev/null); then
+	commit=$commit-dirty
+fi
+host=$(uname -n)
+
+# compare with the history of this host, before this run goes into it
+touch "$history"
+echo "compared with the median of the last $runs runs on $host in $history:"
+awk -v host="$host" -v runs="$runs" -v thr="$threshold" '
+	# history lines come first, then the results of this run
+	FILENAME == ARGV[1] {
+		if (index($0, "\"host\":\"" host "\"") == 0) next
+		s = $0
+		while (match(s, /"[^"]+":\{"value":[^,]*,"unit":"[^"]*"\}/)) {
+			tok = substr(s, RSTART, RLENGTH)
+			s = substr(s, RSTART + RLENGTH)
+			split(tok, f, "\"")
+			v = substr(tok, index(tok, "\"value\":") + 8)
+			v = substr(v, 1, index(v, ",") - 1)
+			n = ++cnt[f[2]]
+			hist[f[2], n] = v + 0
+		}
+		next
+	}
+	{
+		name = $1; cur = $2 + 0; unit = $3
+		n = cnt[name]
+		if (n == 0) {
+			printf "%-32s %14.2f %-9s (new)\n", name, cur, unit
+			next
+		}
+		# median of the last runs values
+		k = 0
+		for (i = (n > runs ? n - runs + 1 : 1); i <= n; i++) {
+			x = hist[name, i]
+			for (j = k; j > 0 && w[j] > x; j--) w[j + 1] = w[j]
+			w[j + 1] = x
+			k++
+		}
+		med = k % 2 ? w[(k + 1) / 2] : (w[k / 2] + w[k / 2 + 1]) / 2
+		if (med <= 0) next
+		change = 100 * (cur - med) / med
+		worse = unit ~ /\/s$/ ? -change : change
+		flag = ""
+		if (worse > thr) {
+			flag = "REGRESSION"
+			bad++
+		}
+		printf "%-32s %14.2f %-9s median %14.2f %+7.1f%% %s\n", name, cur, unit, med, change, flag
+	}
+	END { exit bad ? 1 : 0 }
+' "$history" "$results"
+status=$?
+
+{
+	printf '{"date":"%s","commit":"%s","host":"%s","results":{' "$date" "$commit" "$host"
+	awk '{ printf "%s\"%s\":{\"value\":%s,\"unit\":\"%s\"}", (NR > 1 ? "," : ""), $1, $2, $3 }' "$results"
+	printf '},"skipped":['
+	awk '{ printf "%s\"%s\"", (NR > 1 ? "," : ""), $1 }' "$skipped"
+	printf ']}\n'
+} >> "$history"
+
+if [ $status -ne 0 ]; then
+	echo "regression: more than $threshold% worse than the median of the last $runs runs on $host" >&2
+fi
+exit $status